@@ -0,0 +1,306 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/bigtable/benchmarks/benchmark.h"
+#include "google/cloud/bigtable/benchmarks/random_mutation.h"
+#include "google/cloud/bigtable/mutation_batcher.h"
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <map>
+#include <thread>
+
+/**
+ * @file
+ *
+ * Measure the throughput of `bigtable::MutationBatcher::AsyncApply()`.
+ *
+ * This benchmark measures the throughput of `MutationBatcher` with different
+ * configurations. The benchmark:
+ * - Creates an empty table with a single column family.
+ * - The name of the table starts with `mbt`, followed by random characters.
+ * - If there is a collision on the table name the benchmark aborts immediately.
+ *
+ * Then, for each `MutationBatcher` configuration (the default, with a linger
+ * timer, with one shard per thread, and with both), the benchmark:
+ *
+ * - Starts T threads, all using the same `MutationBatcher`, executing the
+ *   following loop for S seconds:
+ *   - Pick one of the table keys at random, with uniform probability.
+ *   - Create a mutation setting all the fields to random values.
+ *   - Call `AsyncApply()`, wait for the mutation to be admitted, record the
+ *     latency of these two steps.
+ * - Waits until all the mutations complete.
+ *
+ * The benchmark reports the throughput, in mutations per second, and the
+ * admission latency for each configuration. The admission latency includes
+ * any contention on the `MutationBatcher` locks.
+ *
+ * At full speed the batches fill up quickly and the linger timer has little
+ * effect. To measure it, the benchmark also runs the default and the linger
+ * configurations at a low rate: the threads submit a total of 1,000 mutations
+ * per second, at regular intervals, without waiting for the previous mutations
+ * to complete. For these runs it reports the completion latency of each
+ * mutation and, when using the embedded server, the number of `MutateRows`
+ * RPCs and the average number of mutations in each batch.
+ *
+ * Using a command-line parameter the benchmark can be configured to create a
+ * local gRPC server that implements the Cloud Bigtable APIs used by the
+ * benchmark.  If this parameter is not used, the benchmark uses the default
+ * configuration, that is, a production instance of Cloud Bigtable unless the
+ * CLOUD_BIGTABLE_EMULATOR environment variable is set.
+ */
+
+/// Helper functions and types for the mutation_batcher_throughput_benchmark.
+namespace {
+namespace bigtable = google::cloud::bigtable;
+using bigtable::benchmarks::Benchmark;
+using bigtable::benchmarks::BenchmarkResult;
+using bigtable::benchmarks::FormatDuration;
+using bigtable::benchmarks::kNumFields;
+using bigtable::benchmarks::MakeBenchmarkSetup;
+using bigtable::benchmarks::MakeRandomMutation;
+using bigtable::benchmarks::OperationResult;
+
+/// How long a partial batch waits for more mutations, when enabled.
+constexpr std::chrono::milliseconds kLinger(5);
+
+/// The combined rate of all the threads in the low-rate runs.
+constexpr int kPacedMutationsPerSecond = 1000;
+
+/// Apply mutations until @p test_duration expires.
+BenchmarkResult RunWriter(Benchmark const& benchmark,
+                          bigtable::MutationBatcher& batcher,
+                          google::cloud::CompletionQueue& cq,
+                          std::chrono::seconds test_duration);
+
+/**
+ * Apply a mutation every @p interval until @p test_duration expires.
+ *
+ * The operations in the result contain the completion latency of each
+ * mutation.
+ */
+BenchmarkResult RunPacedWriter(Benchmark const& benchmark,
+                               bigtable::MutationBatcher& batcher,
+                               google::cloud::CompletionQueue& cq,
+                               std::chrono::seconds test_duration,
+                               std::chrono::microseconds interval);
+
+/**
+ * Run an iteration of the test, returns the combined results of all threads.
+ *
+ * Each thread submits mutations as fast as possible if @p interval is zero,
+ * otherwise it submits one mutation every @p interval.
+ */
+BenchmarkResult RunBenchmark(Benchmark const& benchmark, bigtable::Table table,
+                             google::cloud::CompletionQueue& cq,
+                             bigtable::MutationBatcher::Options options,
+                             int thread_count,
+                             std::chrono::seconds test_duration,
+                             std::chrono::microseconds interval);
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  auto setup = MakeBenchmarkSetup("mbt", argc, argv);
+  if (!setup) {
+    std::cerr << setup.status() << "\n";
+    return -1;
+  }
+
+  Benchmark benchmark(*setup);
+  benchmark.CreateTable();
+
+  google::cloud::CompletionQueue cq;
+  std::vector<std::thread> cq_threads;
+  for (int i = 0; i != setup->thread_count(); ++i) {
+    cq_threads.emplace_back([&cq] { cq.Run(); });
+  }
+
+  auto const shards = static_cast<std::size_t>(setup->thread_count());
+  std::map<std::string, bigtable::MutationBatcher::Options> configurations{
+      {"Default", bigtable::MutationBatcher::Options()},
+      {"Linger", bigtable::MutationBatcher::Options().SetMaxLinger(kLinger)},
+      {"Shards", bigtable::MutationBatcher::Options().SetShards(shards)},
+      {"LingerShards", bigtable::MutationBatcher::Options()
+                           .SetMaxLinger(kLinger)
+                           .SetShards(shards)},
+  };
+
+  bigtable::Table table(benchmark.MakeDataClient(), setup->app_profile_id(),
+                        setup->table_id());
+  std::map<std::string, BenchmarkResult> results;
+  for (auto const& kv : configurations) {
+    std::cout << "# Running benchmark [" << kv.first << "] " << std::flush;
+    auto result =
+        RunBenchmark(benchmark, table, cq, kv.second, setup->thread_count(),
+                     setup->test_duration(), std::chrono::microseconds(0));
+    std::cout << " DONE. Elapsed=" << FormatDuration(result.elapsed)
+              << ", Ops=" << result.operations.size()
+              << ", Rows=" << result.row_count << "\n";
+    auto op_name = "AsyncApply(" + kv.first + ")";
+    Benchmark::PrintThroughputResult(std::cout, "mbt", op_name, result);
+    Benchmark::PrintLatencyResult(std::cout, "mbt", op_name, result);
+    results[op_name] = std::move(result);
+  }
+
+  // At low rates the batches are partial, this is where the linger timer
+  // matters. Only the embedded server counts the batches.
+  std::map<std::string, bigtable::MutationBatcher::Options> paced{
+      {"PacedDefault", bigtable::MutationBatcher::Options()},
+      {"PacedLinger",
+       bigtable::MutationBatcher::Options().SetMaxLinger(kLinger)},
+  };
+  auto const interval = std::chrono::microseconds(std::chrono::seconds(1)) *
+                        setup->thread_count() / kPacedMutationsPerSecond;
+  std::map<std::string, BenchmarkResult> paced_results;
+  for (auto const& kv : paced) {
+    std::cout << "# Running benchmark [" << kv.first << "] " << std::flush;
+    auto const batches_before = benchmark.mutate_rows_count();
+    auto result =
+        RunBenchmark(benchmark, table, cq, kv.second, setup->thread_count(),
+                     setup->test_duration(), interval);
+    auto const batches = benchmark.mutate_rows_count() - batches_before;
+    std::cout << " DONE. Elapsed=" << FormatDuration(result.elapsed)
+              << ", Ops=" << result.operations.size()
+              << ", Rows=" << result.row_count << ", Batches=" << batches;
+    if (batches != 0) {
+      std::cout << ", AvgBatchSize="
+                << static_cast<double>(result.row_count) / batches;
+    }
+    std::cout << "\n";
+    auto op_name = "AsyncApply(" + kv.first + ")";
+    Benchmark::PrintThroughputResult(std::cout, "mbt", op_name, result);
+    Benchmark::PrintLatencyResult(std::cout, "mbt", op_name, result);
+    paced_results[op_name] = std::move(result);
+  }
+
+  std::cout << bigtable::benchmarks::Benchmark::ResultsCsvHeader() << "\n";
+  for (auto& kv : results) {
+    benchmark.PrintResultCsv(std::cout, "mbt", kv.first, "AdmissionLatency",
+                             kv.second);
+  }
+  for (auto& kv : paced_results) {
+    benchmark.PrintResultCsv(std::cout, "mbt", kv.first, "CompletionLatency",
+                             kv.second);
+  }
+
+  benchmark.DeleteTable();
+  cq.Shutdown();
+  for (auto& t : cq_threads) {
+    t.join();
+  }
+
+  return 0;
+}
+
+namespace {
+
+BenchmarkResult RunWriter(Benchmark const& benchmark,
+                          bigtable::MutationBatcher& batcher,
+                          google::cloud::CompletionQueue& cq,
+                          std::chrono::seconds test_duration) {
+  BenchmarkResult result = {};
+  auto generator = google::cloud::internal::MakeDefaultPRNG();
+
+  auto start = std::chrono::steady_clock::now();
+  auto end = start + test_duration;
+  for (auto now = start; now < end; now = std::chrono::steady_clock::now()) {
+    bigtable::SingleRowMutation mutation(benchmark.MakeRandomKey(generator));
+    for (int field = 0; field != kNumFields; ++field) {
+      mutation.emplace_back(MakeRandomMutation(generator, field));
+    }
+    auto op = [&batcher, &cq, &mutation]() -> google::cloud::Status {
+      auto admission_completion = batcher.AsyncApply(cq, std::move(mutation));
+      admission_completion.first.get();
+      return google::cloud::Status{};
+    };
+    result.operations.push_back(Benchmark::TimeOperation(std::move(op)));
+    ++result.row_count;
+  }
+  return result;
+}
+
+BenchmarkResult RunPacedWriter(Benchmark const& benchmark,
+                               bigtable::MutationBatcher& batcher,
+                               google::cloud::CompletionQueue& cq,
+                               std::chrono::seconds test_duration,
+                               std::chrono::microseconds interval) {
+  BenchmarkResult result = {};
+  auto generator = google::cloud::internal::MakeDefaultPRNG();
+
+  std::vector<google::cloud::future<OperationResult>> pending;
+  auto start = std::chrono::steady_clock::now();
+  auto end = start + test_duration;
+  for (auto next = start; next < end; next += interval) {
+    std::this_thread::sleep_until(next);
+    bigtable::SingleRowMutation mutation(benchmark.MakeRandomKey(generator));
+    for (int field = 0; field != kNumFields; ++field) {
+      mutation.emplace_back(MakeRandomMutation(generator, field));
+    }
+    auto const issued = std::chrono::steady_clock::now();
+    auto admission_completion = batcher.AsyncApply(cq, std::move(mutation));
+    pending.push_back(admission_completion.second.then(
+        [issued](google::cloud::future<google::cloud::Status> f) {
+          auto status = f.get();
+          return OperationResult{
+              std::move(status),
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - issued)};
+        }));
+    admission_completion.first.get();
+    ++result.row_count;
+  }
+  for (auto& f : pending) result.operations.push_back(f.get());
+  return result;
+}
+
+BenchmarkResult RunBenchmark(Benchmark const& benchmark, bigtable::Table table,
+                             google::cloud::CompletionQueue& cq,
+                             bigtable::MutationBatcher::Options options,
+                             int thread_count,
+                             std::chrono::seconds test_duration,
+                             std::chrono::microseconds interval) {
+  bigtable::MutationBatcher batcher(std::move(table), options);
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::future<BenchmarkResult>> tasks;
+  for (int i = 0; i != thread_count; ++i) {
+    std::cout << '=' << std::flush;
+    if (interval.count() == 0) {
+      tasks.emplace_back(std::async(std::launch::async, RunWriter,
+                                    std::cref(benchmark), std::ref(batcher),
+                                    std::ref(cq), test_duration));
+      continue;
+    }
+    tasks.emplace_back(std::async(std::launch::async, RunPacedWriter,
+                                  std::cref(benchmark), std::ref(batcher),
+                                  std::ref(cq), test_duration, interval));
+  }
+
+  BenchmarkResult combined = {};
+  for (auto& task : tasks) {
+    auto result = task.get();
+    combined.row_count += result.row_count;
+    combined.operations.insert(combined.operations.end(),
+                               result.operations.begin(),
+                               result.operations.end());
+  }
+  // The throughput includes the time to complete all the mutations.
+  batcher.AsyncWaitForNoPendingRequests().get();
+  combined.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  return combined;
+}
+
+}  // anonymous namespace
@@ -25,6 +25,7 @@ bigtable_client_hdrs = [
     "cluster_config.h",
     "cluster_list_responses.h",
     "column_family.h",
+    "compact_row.h",
     "completion_queue.h",
     "data_client.h",
     "expr.h",
@@ -55,8 +56,10 @@ bigtable_client_hdrs = [
     "internal/rpc_policy_parameters.inc",
     "internal/unary_client_utils.h",
     "metadata_update_policy.h",
+    "mutate_rows_limiter.h",
     "mutation_batcher.h",
     "mutations.h",
+    "parallel_scan.h",
     "polling_policy.h",
     "read_modify_write_rule.h",
     "row.h",
@@ -79,6 +82,7 @@ bigtable_client_srcs = [
     "app_profile_config.cc",
     "client_options.cc",
     "cluster_config.cc",
+    "compact_row.cc",
     "data_client.cc",
     "expr.cc",
     "iam_binding.cc",
@@ -96,8 +100,10 @@ bigtable_client_srcs = [
     "internal/readrowsparser.cc",
     "internal/rowreaderiterator.cc",
     "metadata_update_policy.cc",
+    "mutate_rows_limiter.cc",
     "mutation_batcher.cc",
     "mutations.cc",
+    "parallel_scan.cc",
     "polling_policy.cc",
     "row_range.cc",
     "row_reader.cc",
@@ -29,6 +29,7 @@ bigtable_client_unit_tests = [
     "client_options_test.cc",
     "cluster_config_test.cc",
     "column_family_test.cc",
+    "compact_row_test.cc",
     "data_client_test.cc",
     "expr_test.cc",
     "filters_test.cc",
@@ -40,6 +41,7 @@ bigtable_client_unit_tests = [
     "instance_admin_test.cc",
     "instance_config_test.cc",
     "instance_update_config_test.cc",
+    "internal/async_bulk_apply_test.cc",
     "internal/async_longrunning_op_test.cc",
     "internal/async_retry_multi_page_test.cc",
     "internal/async_retry_unary_rpc_and_poll_test.cc",
@@ -47,8 +49,10 @@ bigtable_client_unit_tests = [
     "internal/google_bytes_traits_test.cc",
     "internal/prefix_range_end_test.cc",
     "metadata_update_policy_test.cc",
+    "mutate_rows_limiter_test.cc",
     "mutation_batcher_test.cc",
     "mutations_test.cc",
+    "parallel_scan_test.cc",
     "polling_policy_test.cc",
     "read_modify_write_rule_test.cc",
     "row_range_test.cc",
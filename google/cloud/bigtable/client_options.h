@@ -15,7 +15,9 @@
 #ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_CLIENT_OPTIONS_H
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_CLIENT_OPTIONS_H
 
+#include "google/cloud/bigtable/mutate_rows_limiter.h"
 #include "google/cloud/bigtable/version.h"
+#include "google/cloud/optional.h"
 #include "google/cloud/status.h"
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/resource_quota.h>
@@ -123,6 +125,26 @@ class ClientOptions {
 
   std::size_t connection_pool_size() const { return connection_pool_size_; }
 
+  /**
+   * Adapt the `MutateRows` traffic to the server pushback.
+   *
+   * If set, the `DataClient` created with these options owns a
+   * `MutateRowsLimiter`, shared by all the `Table::BulkApply()` and
+   * `Table::AsyncBulkApply()` calls using that client. By default there is no
+   * limit, and throttled mutations are only retried after the backoff policy
+   * delay.
+   */
+  ClientOptions& set_mutate_rows_limiter_options(
+      MutateRowsLimiter::Options options) {
+    mutate_rows_limiter_options_ = std::move(options);
+    return *this;
+  }
+  /// Return the `MutateRowsLimiter` configuration, if any.
+  optional<MutateRowsLimiter::Options> const& mutate_rows_limiter_options()
+      const {
+    return mutate_rows_limiter_options_;
+  }
+
   /// Return the current credentials.
   std::shared_ptr<grpc::ChannelCredentials> credentials() const {
     return credentials_;
@@ -314,6 +336,7 @@ class ClientOptions {
   // testing, where the emulator for instance admin operations may be different
   // than the emulator for admin and data operations.
   std::string instance_admin_endpoint_;
+  optional<MutateRowsLimiter::Options> mutate_rows_limiter_options_;
 };
 }  // namespace BIGTABLE_CLIENT_NS
 }  // namespace bigtable
@@ -262,6 +262,17 @@ TEST(ClientOptionsTest, EditConnectionPoolSize) {
   EXPECT_EQ(42UL, returned.connection_pool_size());
 }
 
+TEST(ClientOptionsTest, EditMutateRowsLimiterOptions) {
+  bigtable::ClientOptions client_options_object;
+  EXPECT_FALSE(client_options_object.mutate_rows_limiter_options());
+  auto& returned = client_options_object.set_mutate_rows_limiter_options(
+      bigtable::MutateRowsLimiter::Options().SetMaxBytesInFlight(4096));
+  EXPECT_EQ(&returned, &client_options_object);
+  ASSERT_TRUE(returned.mutate_rows_limiter_options());
+  EXPECT_EQ(4096U,
+            returned.mutate_rows_limiter_options()->max_bytes_in_flight);
+}
+
 TEST(ClientOptionsTest, ResetToDefaultConnectionPoolSize) {
   bigtable::ClientOptions client_options_object;
   auto& returned = client_options_object.set_connection_pool_size(0);
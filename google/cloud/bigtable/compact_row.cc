@@ -0,0 +1,125 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/bigtable/compact_row.h"
+#include <algorithm>
+#include <limits>
+
+namespace google {
+namespace cloud {
+namespace bigtable {
+inline namespace BIGTABLE_CLIENT_NS {
+namespace {
+auto constexpr kNoLabels = (std::numeric_limits<std::uint32_t>::max)();
+}  // namespace
+
+std::vector<std::string> const& CompactRow::CellView::labels() const {
+  static auto const* const kEmpty = new std::vector<std::string>;
+  if (entry_->labels == kNoLabels) return *kEmpty;
+  return row_->labels_[entry_->labels];
+}
+
+Cell CompactRow::CellView::ToCell() const {
+  auto qualifier = column_qualifier();
+  auto value = this->value();
+  return Cell(row_key(), family_name(),
+              ColumnQualifierType(qualifier.data(), qualifier.size()),
+              entry_->timestamp, CellValueType(value.data(), value.size()),
+              labels());
+}
+
+Row CompactRow::ToRow() const {
+  std::vector<Cell> cells;
+  cells.reserve(cells_.size());
+  for (auto cell : *this) cells.push_back(cell.ToCell());
+  return Row(row_key_, std::move(cells));
+}
+
+namespace internal {
+
+void CompactRowBuilder::AddCell(std::string const& family,
+                                ColumnQualifierType const& qualifier,
+                                std::int64_t timestamp,
+                                CellValueType const& value,
+                                std::vector<std::string> labels) {
+  if (row_.arena_.empty() && arena_hint_ != 0) {
+    row_.arena_.reserve(arena_hint_);
+  }
+  CompactRow::CellEntry entry;
+  entry.family = FamilyIndex(family);
+  entry.labels = kNoLabels;
+  if (!labels.empty()) {
+    entry.labels = static_cast<std::uint32_t>(row_.labels_.size());
+    row_.labels_.push_back(std::move(labels));
+  }
+  entry.timestamp = timestamp;
+  entry.qualifier_offset = QualifierOffset(entry.family, qualifier);
+  entry.qualifier_size = qualifier.size();
+  entry.value_offset = row_.arena_.size();
+  entry.value_size = value.size();
+  row_.arena_.append(value.data(), value.size());
+  row_.cells_.push_back(entry);
+}
+
+void CompactRowBuilder::Clear() {
+  row_.families_.clear();
+  row_.labels_.clear();
+  row_.arena_.clear();
+  row_.cells_.clear();
+}
+
+CompactRow CompactRowBuilder::Build(RowKeyType row_key) {
+  CompactRow row = std::move(row_);
+  row.row_key_ = std::move(row_key);
+  arena_hint_ = row.arena_.size();
+  row_ = CompactRow();
+  return row;
+}
+
+std::uint32_t CompactRowBuilder::FamilyIndex(std::string const& family) {
+  auto& families = row_.families_;
+  // The cells are grouped by family, so the common case is a match with the
+  // last cell.
+  if (!row_.cells_.empty() && families[row_.cells_.back().family] == family) {
+    return row_.cells_.back().family;
+  }
+  auto loc = std::find(families.begin(), families.end(), family);
+  if (loc == families.end()) {
+    families.push_back(family);
+    loc = std::prev(families.end());
+  }
+  return static_cast<std::uint32_t>(std::distance(families.begin(), loc));
+}
+
+std::size_t CompactRowBuilder::QualifierOffset(
+    std::uint32_t family, ColumnQualifierType const& qualifier) {
+  // Multiple versions of a column are consecutive, share the qualifier bytes.
+  if (!row_.cells_.empty()) {
+    auto const& last = row_.cells_.back();
+    if (last.family == family && last.qualifier_size == qualifier.size() &&
+        row_.arena_.compare(last.qualifier_offset, last.qualifier_size,
+                            qualifier.data(), qualifier.size()) == 0) {
+      return last.qualifier_offset;
+    }
+  }
+  auto const offset = row_.arena_.size();
+  row_.arena_.append(qualifier.data(), qualifier.size());
+  return offset;
+}
+
+}  // namespace internal
+}  // namespace BIGTABLE_CLIENT_NS
+}  // namespace bigtable
+}  // namespace cloud
+}  // namespace google
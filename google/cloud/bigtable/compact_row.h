@@ -0,0 +1,217 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_COMPACT_ROW_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_COMPACT_ROW_H
+
+#include "google/cloud/bigtable/cell.h"
+#include "google/cloud/bigtable/row.h"
+#include "google/cloud/bigtable/version.h"
+#include "absl/strings/string_view.h"
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace bigtable {
+inline namespace BIGTABLE_CLIENT_NS {
+namespace internal {
+class CompactRowBuilder;
+}  // namespace internal
+
+/**
+ * A compact, read-only, in-memory representation of a Bigtable row.
+ *
+ * Each `Cell` in a `Row` owns a copy of the row key, the column family name,
+ * the column qualifier, the value, and the labels. On wide rows most of these
+ * copies are duplicates. `CompactRow` stores the row key and each column family
+ * name once, and packs the qualifiers and values of all the cells in a single
+ * buffer. Consecutive cells in the same column (i.e. multiple versions) share
+ * the qualifier bytes. Reading a row in this representation requires a handful
+ * of allocations, instead of several allocations per cell.
+ *
+ * The cells are accessed through `CellView` objects, which refer to the data
+ * in the `CompactRow` and are not valid after it is deleted. Use `ToRow()` to
+ * convert to the (owning) `Row` representation.
+ *
+ * Applications receive these objects from `RowReader::NextCompact()`.
+ */
+class CompactRow {
+ private:
+  struct CellEntry {
+    std::uint32_t family;
+    std::uint32_t labels;
+    std::int64_t timestamp;
+    std::size_t qualifier_offset;
+    std::size_t qualifier_size;
+    std::size_t value_offset;
+    std::size_t value_size;
+  };
+
+ public:
+  /// A non-owning view of a cell in a `CompactRow`.
+  class CellView {
+   public:
+    /// Return the row key this cell belongs to.
+    RowKeyType const& row_key() const { return row_->row_key_; }
+
+    /// Return the family this cell belongs to.
+    std::string const& family_name() const {
+      return row_->families_[entry_->family];
+    }
+
+    /// Return the column this cell belongs to.
+    absl::string_view column_qualifier() const {
+      return absl::string_view(row_->arena_).substr(entry_->qualifier_offset,
+                                                    entry_->qualifier_size);
+    }
+
+    /// Return the timestamp of this cell.
+    std::chrono::microseconds timestamp() const {
+      return std::chrono::microseconds(entry_->timestamp);
+    }
+
+    /// Return the contents of this cell.
+    absl::string_view value() const {
+      return absl::string_view(row_->arena_).substr(entry_->value_offset,
+                                                    entry_->value_size);
+    }
+
+    /// Return the labels applied to this cell by label transformer filters.
+    std::vector<std::string> const& labels() const;
+
+    /// Return a copy of this cell in the `Cell` representation.
+    Cell ToCell() const;
+
+   private:
+    friend class CompactRow;
+    CellView(CompactRow const* row, CellEntry const* entry)
+        : row_(row), entry_(entry) {}
+
+    CompactRow const* row_;
+    CellEntry const* entry_;
+  };
+
+  /// An input iterator over the cells in a `CompactRow`.
+  class const_iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = CellView;
+    using difference_type = std::ptrdiff_t;
+    using pointer = CellView const*;
+    using reference = CellView;
+
+    CellView operator*() const { return CellView(row_, &row_->cells_[index_]); }
+
+    const_iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      auto tmp = *this;
+      ++index_;
+      return tmp;
+    }
+
+    friend bool operator==(const_iterator const& lhs,
+                           const_iterator const& rhs) {
+      return lhs.row_ == rhs.row_ && lhs.index_ == rhs.index_;
+    }
+    friend bool operator!=(const_iterator const& lhs,
+                           const_iterator const& rhs) {
+      return !(lhs == rhs);
+    }
+
+   private:
+    friend class CompactRow;
+    const_iterator(CompactRow const* row, std::size_t index)
+        : row_(row), index_(index) {}
+
+    CompactRow const* row_;
+    std::size_t index_;
+  };
+
+  /// Return the row key. The returned value is not valid after this object is
+  /// deleted.
+  RowKeyType const& row_key() const { return row_key_; }
+
+  /// Return the number of cells in the row.
+  std::size_t size() const { return cells_.size(); }
+  bool empty() const { return cells_.empty(); }
+
+  /// Return the @p i -th cell in the row, in the order returned by the service.
+  CellView cell(std::size_t i) const { return CellView(this, &cells_[i]); }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, cells_.size()); }
+
+  /// Return a copy of this row in the `Row` representation.
+  Row ToRow() const;
+
+ private:
+  friend class internal::CompactRowBuilder;
+  CompactRow() = default;
+
+  RowKeyType row_key_;
+  std::vector<std::string> families_;
+  std::vector<std::vector<std::string>> labels_;
+  std::string arena_;
+  std::vector<CellEntry> cells_;
+};
+
+namespace internal {
+/**
+ * Accumulates the cells of a row into a `CompactRow`.
+ *
+ * Used by `ReadRowsParser`, the cells are added in the order they appear in
+ * the stream, so the previous cell is the best predictor for the family and
+ * column of the next cell.
+ */
+class CompactRowBuilder {
+ public:
+  /// Copy the data of a cell into the row being built.
+  void AddCell(std::string const& family, ColumnQualifierType const& qualifier,
+               std::int64_t timestamp, CellValueType const& value,
+               std::vector<std::string> labels);
+
+  /// Return true if no cells have been added since the last `Build()`.
+  bool empty() const { return row_.cells_.empty(); }
+
+  /// Discard all the cells added since the last `Build()`.
+  void Clear();
+
+  /// Return the row containing all the cells, and start a new row.
+  CompactRow Build(RowKeyType row_key);
+
+ private:
+  std::uint32_t FamilyIndex(std::string const& family);
+  std::size_t QualifierOffset(std::uint32_t family,
+                              ColumnQualifierType const& qualifier);
+
+  CompactRow row_;
+  // The buffer size of the last row, used to avoid growing the buffer
+  // piecemeal on tables with rows of similar sizes.
+  std::size_t arena_hint_ = 0;
+};
+}  // namespace internal
+
+}  // namespace BIGTABLE_CLIENT_NS
+}  // namespace bigtable
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_COMPACT_ROW_H
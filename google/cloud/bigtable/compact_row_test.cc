@@ -0,0 +1,152 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/bigtable/compact_row.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace bigtable {
+inline namespace BIGTABLE_CLIENT_NS {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(CompactRowTest, Empty) {
+  internal::CompactRowBuilder builder;
+  EXPECT_TRUE(builder.empty());
+  auto row = builder.Build("row");
+  EXPECT_EQ("row", row.row_key());
+  EXPECT_TRUE(row.empty());
+  EXPECT_EQ(0U, row.size());
+  EXPECT_EQ(row.begin(), row.end());
+}
+
+TEST(CompactRowTest, Simple) {
+  internal::CompactRowBuilder builder;
+  builder.AddCell("fam1", "c1", 30, "v1", {});
+  builder.AddCell("fam1", "c1", 20, "v2", {"l1", "l2"});
+  builder.AddCell("fam1", "c2", 10, "v3", {});
+  builder.AddCell("fam2", "c1", 10, "v4", {});
+  EXPECT_FALSE(builder.empty());
+  auto row = builder.Build("row");
+  EXPECT_TRUE(builder.empty());
+
+  EXPECT_EQ("row", row.row_key());
+  ASSERT_EQ(4U, row.size());
+  EXPECT_EQ("row", row.cell(0).row_key());
+  EXPECT_EQ("fam1", row.cell(0).family_name());
+  EXPECT_EQ("c1", row.cell(0).column_qualifier());
+  EXPECT_EQ(30, row.cell(0).timestamp().count());
+  EXPECT_EQ("v1", row.cell(0).value());
+  EXPECT_TRUE(row.cell(0).labels().empty());
+
+  EXPECT_EQ("c1", row.cell(1).column_qualifier());
+  EXPECT_EQ("v2", row.cell(1).value());
+  EXPECT_THAT(row.cell(1).labels(), ElementsAre("l1", "l2"));
+
+  EXPECT_EQ("fam1", row.cell(2).family_name());
+  EXPECT_EQ("c2", row.cell(2).column_qualifier());
+  EXPECT_EQ("fam2", row.cell(3).family_name());
+  EXPECT_EQ("c1", row.cell(3).column_qualifier());
+  EXPECT_EQ("v4", row.cell(3).value());
+
+  std::vector<std::string> values;
+  for (auto cell : row) values.emplace_back(cell.value());
+  EXPECT_THAT(values, ElementsAre("v1", "v2", "v3", "v4"));
+}
+
+TEST(CompactRowTest, FamiliesAreShared) {
+  internal::CompactRowBuilder builder;
+  builder.AddCell("fam1", "c1", 0, "v1", {});
+  builder.AddCell("fam2", "c1", 0, "v2", {});
+  builder.AddCell("fam1", "c2", 0, "v3", {});
+  auto row = builder.Build("row");
+  ASSERT_EQ(3U, row.size());
+  EXPECT_EQ(&row.cell(0).family_name(), &row.cell(2).family_name());
+  EXPECT_NE(&row.cell(0).family_name(), &row.cell(1).family_name());
+}
+
+TEST(CompactRowTest, VersionsShareQualifier) {
+  internal::CompactRowBuilder builder;
+  builder.AddCell("fam", "column", 30, "v1", {});
+  builder.AddCell("fam", "column", 20, "v2", {});
+  builder.AddCell("other", "column", 10, "v3", {});
+  auto row = builder.Build("row");
+  ASSERT_EQ(3U, row.size());
+  EXPECT_EQ(row.cell(0).column_qualifier().data(),
+            row.cell(1).column_qualifier().data());
+  // The same qualifier in a different family is not shared.
+  EXPECT_NE(row.cell(0).column_qualifier().data(),
+            row.cell(2).column_qualifier().data());
+  EXPECT_EQ("column", row.cell(2).column_qualifier());
+}
+
+TEST(CompactRowTest, ClearDiscardsCells) {
+  internal::CompactRowBuilder builder;
+  builder.AddCell("fam", "c1", 0, "discarded", {"label"});
+  builder.Clear();
+  EXPECT_TRUE(builder.empty());
+  builder.AddCell("fam", "c2", 0, "v", {});
+  auto row = builder.Build("row");
+  ASSERT_EQ(1U, row.size());
+  EXPECT_EQ("c2", row.cell(0).column_qualifier());
+  EXPECT_EQ("v", row.cell(0).value());
+  EXPECT_TRUE(row.cell(0).labels().empty());
+}
+
+TEST(CompactRowTest, BuilderIsReusable) {
+  internal::CompactRowBuilder builder;
+  builder.AddCell("fam1", "c1", 0, "v1", {});
+  auto r1 = builder.Build("r1");
+  builder.AddCell("fam2", "c2", 0, "v2", {});
+  auto r2 = builder.Build("r2");
+
+  ASSERT_EQ(1U, r1.size());
+  EXPECT_EQ("fam1", r1.cell(0).family_name());
+  EXPECT_EQ("v1", r1.cell(0).value());
+  ASSERT_EQ(1U, r2.size());
+  EXPECT_EQ("r2", r2.cell(0).row_key());
+  EXPECT_EQ("fam2", r2.cell(0).family_name());
+  EXPECT_EQ("c2", r2.cell(0).column_qualifier());
+  EXPECT_EQ("v2", r2.cell(0).value());
+}
+
+TEST(CompactRowTest, ToRow) {
+  internal::CompactRowBuilder builder;
+  builder.AddCell("fam", "c1", 30, "v1", {"l1"});
+  builder.AddCell("fam", "c2", 20, "v2", {});
+  auto row = builder.Build("row").ToRow();
+
+  EXPECT_EQ("row", row.row_key());
+  ASSERT_EQ(2U, row.cells().size());
+  auto const& c0 = row.cells()[0];
+  EXPECT_EQ("row", c0.row_key());
+  EXPECT_EQ("fam", c0.family_name());
+  EXPECT_EQ("c1", c0.column_qualifier());
+  EXPECT_EQ(30, c0.timestamp().count());
+  EXPECT_EQ("v1", c0.value());
+  EXPECT_THAT(c0.labels(), ElementsAre("l1"));
+  auto const& c1 = row.cells()[1];
+  EXPECT_EQ("c2", c1.column_qualifier());
+  EXPECT_EQ(20, c1.timestamp().count());
+  EXPECT_EQ("v2", c1.value());
+  EXPECT_TRUE(c1.labels().empty());
+}
+
+}  // namespace
+}  // namespace BIGTABLE_CLIENT_NS
+}  // namespace bigtable
+}  // namespace cloud
+}  // namespace google
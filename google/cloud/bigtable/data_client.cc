@@ -45,6 +45,7 @@ class DefaultDataClient : public DataClient {
                     ClientOptions options)
       : project_(std::move(project)),
         instance_(std::move(instance)),
+        mutate_rows_limiter_(MakeMutateRowsLimiter(options)),
         impl_(std::move(options)) {}
 
   DefaultDataClient(std::string project, std::string instance)
@@ -56,6 +57,9 @@ class DefaultDataClient : public DataClient {
 
   std::shared_ptr<grpc::Channel> Channel() override { return impl_.Channel(); }
   void reset() override { impl_.reset(); }
+  std::shared_ptr<MutateRowsLimiter> mutate_rows_limiter() override {
+    return mutate_rows_limiter_;
+  }
 
   grpc::Status MutateRow(grpc::ClientContext* context,
                          btproto::MutateRowRequest const& request,
@@ -160,8 +164,16 @@ class DefaultDataClient : public DataClient {
   }
 
  private:
+  static std::shared_ptr<MutateRowsLimiter> MakeMutateRowsLimiter(
+      ClientOptions const& options) {
+    if (!options.mutate_rows_limiter_options()) return nullptr;
+    return std::make_shared<MutateRowsLimiter>(
+        *options.mutate_rows_limiter_options());
+  }
+
   std::string project_;
   std::string instance_;
+  std::shared_ptr<MutateRowsLimiter> mutate_rows_limiter_;
   Impl impl_;
 };
 
@@ -17,6 +17,7 @@
 
 #include "google/cloud/bigtable/client_options.h"
 #include "google/cloud/bigtable/completion_queue.h"
+#include "google/cloud/bigtable/mutate_rows_limiter.h"
 #include "google/cloud/bigtable/row.h"
 #include "google/cloud/bigtable/version.h"
 #include <google/bigtable/v2/bigtable.grpc.pb.h>
@@ -82,6 +83,20 @@ class DataClient {
    */
   virtual void reset() = 0;
 
+  /**
+   * Return the limiter for the `MutateRows` RPCs sent through this client.
+   *
+   * The limiter is shared by all the `Table` objects using this client.
+   * Applications can use it to monitor the current limit, for example, via
+   * `MutateRowsLimiter::bytes_in_flight_limit()`. Returns `nullptr` if the
+   * client does not limit the `MutateRows` traffic.
+   *
+   * @see `ClientOptions::set_mutate_rows_limiter_options()`
+   */
+  virtual std::shared_ptr<MutateRowsLimiter> mutate_rows_limiter() {
+    return {};
+  }
+
   // The member functions of this class are not intended for general use by
   // application developers (they are simply a dependency injection point). Make
   // them protected, so the mock classes can override them, and then make the
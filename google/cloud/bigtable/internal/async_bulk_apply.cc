@@ -49,6 +49,7 @@ AsyncRetryBulkApply::AsyncRetryBulkApply(
       rpc_backoff_policy_(std::move(rpc_backoff_policy)),
       metadata_update_policy_(std::move(metadata_update_policy)),
       client_(std::move(client)),
+      limiter_(client_->mutate_rows_limiter()),
       state_(app_profile_id, table_name, idempotent_policy, std::move(mut)) {}
 
 void AsyncRetryBulkApply::StartIterationIfNeeded(CompletionQueue cq) {
@@ -60,7 +61,22 @@ void AsyncRetryBulkApply::StartIterationIfNeeded(CompletionQueue cq) {
     promise_.set_value(std::move(state_).OnRetryDone());
     return;
   }
+  if (!limiter_) {
+    MakeRequest(std::move(cq));
+    return;
+  }
+
+  // Wait until the server can take more mutations.
+  limiter_bytes_ = state_.PendingBytes();
+  auto self = shared_from_this();
+  limiter_->AsyncAcquire(limiter_bytes_)
+      .then([self, cq](future<std::uint64_t> f) {
+        self->limiter_token_ = f.get();
+        self->MakeRequest(cq);
+      });
+}
 
+void AsyncRetryBulkApply::MakeRequest(CompletionQueue cq) {
   auto context = absl::make_unique<grpc::ClientContext>();
   rpc_retry_policy_->Setup(*context);
   rpc_backoff_policy_->Setup(*context);
@@ -88,6 +104,9 @@ void AsyncRetryBulkApply::OnRead(
 
 void AsyncRetryBulkApply::OnFinish(CompletionQueue cq, Status status) {
   state_.OnFinish(std::move(status));
+  if (limiter_) {
+    limiter_->Release(limiter_bytes_, limiter_token_, state_.WasThrottled());
+  }
   StartIterationIfNeeded(std::move(cq));
 }
 
@@ -59,6 +59,8 @@ class AsyncRetryBulkApply
                       std::string const& table_name, BulkMutation mut);
 
   void StartIterationIfNeeded(CompletionQueue cq);
+  /// Start the MutateRows() RPC, after the limiter (if any) admitted it.
+  void MakeRequest(CompletionQueue cq);
 
   void OnRead(google::bigtable::v2::MutateRowsResponse response);
   void OnFinish(CompletionQueue cq, google::cloud::Status status);
@@ -67,7 +69,11 @@ class AsyncRetryBulkApply
   std::unique_ptr<RPCBackoffPolicy> rpc_backoff_policy_;
   MetadataUpdatePolicy metadata_update_policy_;
   std::shared_ptr<bigtable::DataClient> client_;
+  std::shared_ptr<MutateRowsLimiter> limiter_;
   BulkMutatorState state_;
+  // The bytes and token acquired from `limiter_` for the current request.
+  std::size_t limiter_bytes_ = 0;
+  std::uint64_t limiter_token_ = 0;
   promise<std::vector<FailedMutation>> promise_;
 };
 
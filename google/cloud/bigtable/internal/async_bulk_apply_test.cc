@@ -0,0 +1,218 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/bigtable/internal/async_bulk_apply.h"
+#include "google/cloud/bigtable/testing/mock_data_client.h"
+#include "google/cloud/bigtable/testing/mock_response_reader.h"
+#include "google/cloud/testing_util/chrono_literals.h"
+#include "google/cloud/testing_util/mock_completion_queue.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace bigtable {
+inline namespace BIGTABLE_CLIENT_NS {
+namespace internal {
+namespace {
+
+namespace btproto = google::bigtable::v2;
+
+using ::google::cloud::testing_util::chrono_literals::operator"" _ms;
+using ::google::cloud::testing_util::MockCompletionQueue;
+using bigtable::testing::MockClientAsyncReaderInterface;
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+
+using MockReader = MockClientAsyncReaderInterface<btproto::MutateRowsResponse>;
+
+char const kTableName[] = "projects/p/instances/i/tables/t";
+
+class AsyncBulkApplyTest : public ::testing::Test {
+ protected:
+  AsyncBulkApplyTest()
+      : cq_impl_(std::make_shared<MockCompletionQueue>()),
+        cq_(cq_impl_),
+        client_(std::make_shared<bigtable::testing::MockDataClient>()),
+        limiter_(std::make_shared<MutateRowsLimiter>(
+            MutateRowsLimiter::Options()
+                .SetInitialBytesInFlight(1000)
+                .SetMinBytesInFlight(100))),
+        policy_(DefaultIdempotentMutationPolicy()) {
+    EXPECT_CALL(*client_, mutate_rows_limiter())
+        .WillRepeatedly(Return(limiter_));
+  }
+
+  static BulkMutation MakeMutation() {
+    return BulkMutation(
+        SingleRowMutation("foo", {SetCell("fam", "col", 0_ms, "baz")}),
+        SingleRowMutation("bar", {SetCell("fam", "col", 0_ms, "qux")}));
+  }
+
+  future<std::vector<FailedMutation>> Start() {
+    return AsyncRetryBulkApply::Create(
+        cq_, DefaultRPCRetryPolicy(kBigtableLimits),
+        DefaultRPCBackoffPolicy(kBigtableLimits), *policy_,
+        MetadataUpdatePolicy(kTableName, MetadataParamTypes::TABLE_NAME),
+        client_, "", kTableName, MakeMutation());
+  }
+
+  /**
+   * Expect a MutateRows stream returning @p codes for its entries, and
+   * finishing with @p finish.
+   *
+   * The bytes for the request must be acquired from the limiter before the
+   * stream starts.
+   */
+  void ExpectStream(std::vector<grpc::StatusCode> const& codes,
+                    grpc::Status const& finish = grpc::Status::OK) {
+    auto* reader = new MockReader;
+    EXPECT_CALL(*reader, StartCall(_)).Times(1);
+    EXPECT_CALL(*reader, Read(_, _))
+        .WillOnce(Invoke([codes](btproto::MutateRowsResponse* r, void*) {
+          for (std::size_t i = 0; i != codes.size(); ++i) {
+            auto& e = *r->add_entries();
+            e.set_index(static_cast<std::int64_t>(i));
+            e.mutable_status()->set_code(codes[i]);
+          }
+        }))
+        .WillOnce(Invoke([](btproto::MutateRowsResponse*, void*) {}));
+    EXPECT_CALL(*reader, Finish(_, _))
+        .WillOnce(Invoke(
+            [finish](grpc::Status* status, void*) { *status = finish; }));
+
+    auto limiter = limiter_;
+    EXPECT_CALL(*client_, PrepareAsyncMutateRows(_, _, _))
+        .WillOnce(Invoke([reader, limiter](grpc::ClientContext*,
+                                           btproto::MutateRowsRequest const& r,
+                                           grpc::CompletionQueue*) {
+          EXPECT_EQ(r.ByteSizeLong(), limiter->bytes_in_flight());
+          return std::unique_ptr<MockReader>(reader);
+        }))
+        .RetiresOnSaturation();
+  }
+
+  /// Simulate the completions for a stream created by `ExpectStream()`.
+  void RunStream() {
+    // StartCall(), Read() with the entries, Read() at the end of the stream.
+    cq_impl_->SimulateCompletion(true);
+    cq_impl_->SimulateCompletion(true);
+    cq_impl_->SimulateCompletion(false);
+    // Finish()
+    cq_impl_->SimulateCompletion(true);
+  }
+
+  std::shared_ptr<MockCompletionQueue> cq_impl_;
+  CompletionQueue cq_;
+  std::shared_ptr<bigtable::testing::MockDataClient> client_;
+  std::shared_ptr<MutateRowsLimiter> limiter_;
+  std::unique_ptr<IdempotentMutationPolicy> policy_;
+};
+
+/// @test Verify the limiter is held while each stream, including retries, runs.
+TEST_F(AsyncBulkApplyTest, LimiterAroundEachStream) {
+  // gmock matches the most recent expectations first.
+  ExpectStream({grpc::StatusCode::OK});
+  ExpectStream({grpc::StatusCode::OK, grpc::StatusCode::ABORTED});
+
+  auto result = Start();
+  EXPECT_LT(0U, limiter_->bytes_in_flight());
+  RunStream();
+  // The retry acquires the (smaller) request again.
+  EXPECT_LT(0U, limiter_->bytes_in_flight());
+  EXPECT_FALSE(result.is_ready());
+  RunStream();
+
+  ASSERT_TRUE(result.is_ready());
+  EXPECT_TRUE(result.get().empty());
+  EXPECT_EQ(0U, limiter_->bytes_in_flight());
+  EXPECT_EQ(0U, limiter_->throttle_count());
+  EXPECT_TRUE(cq_impl_->empty());
+}
+
+/// @test Verify failed entries with pushback errors throttle the limiter.
+TEST_F(AsyncBulkApplyTest, LimiterThrottledByEntries) {
+  ExpectStream({grpc::StatusCode::OK});
+  ExpectStream({grpc::StatusCode::OK, grpc::StatusCode::UNAVAILABLE});
+
+  auto result = Start();
+  RunStream();
+  EXPECT_EQ(1U, limiter_->throttle_count());
+  EXPECT_EQ(500U, limiter_->bytes_in_flight_limit());
+  RunStream();
+
+  ASSERT_TRUE(result.is_ready());
+  EXPECT_TRUE(result.get().empty());
+  EXPECT_EQ(0U, limiter_->bytes_in_flight());
+  EXPECT_EQ(1U, limiter_->throttle_count());
+}
+
+/// @test Verify a RESOURCE_EXHAUSTED entry throttles the limiter.
+TEST_F(AsyncBulkApplyTest, LimiterThrottledByResourceExhausted) {
+  ExpectStream({grpc::StatusCode::OK, grpc::StatusCode::RESOURCE_EXHAUSTED});
+
+  auto result = Start();
+  RunStream();
+
+  // RESOURCE_EXHAUSTED is not retried, but it reduces the limit.
+  ASSERT_TRUE(result.is_ready());
+  auto failures = result.get();
+  ASSERT_EQ(1U, failures.size());
+  EXPECT_EQ(1, failures[0].original_index());
+  EXPECT_EQ(0U, limiter_->bytes_in_flight());
+  EXPECT_EQ(1U, limiter_->throttle_count());
+}
+
+/// @test Verify a stream failing with pushback throttles the limiter.
+TEST_F(AsyncBulkApplyTest, LimiterThrottledByStream) {
+  ExpectStream({grpc::StatusCode::OK, grpc::StatusCode::OK});
+  ExpectStream({}, grpc::Status(grpc::StatusCode::UNAVAILABLE, "try-again"));
+
+  auto result = Start();
+  RunStream();
+  EXPECT_EQ(1U, limiter_->throttle_count());
+  RunStream();
+
+  ASSERT_TRUE(result.is_ready());
+  EXPECT_TRUE(result.get().empty());
+  EXPECT_EQ(0U, limiter_->bytes_in_flight());
+  EXPECT_EQ(1U, limiter_->throttle_count());
+}
+
+/// @test Verify a request waits until the limiter has room for it.
+TEST_F(AsyncBulkApplyTest, WaitsForRelease) {
+  // Another request holds the full limit.
+  auto const token = limiter_->Acquire(1000);
+
+  auto result = Start();
+  // The stream does not start until the other request releases its bytes.
+  EXPECT_TRUE(cq_impl_->empty());
+  EXPECT_EQ(1000U, limiter_->bytes_in_flight());
+
+  ExpectStream({grpc::StatusCode::OK, grpc::StatusCode::OK});
+  limiter_->Release(1000, token, false);
+  EXPECT_FALSE(cq_impl_->empty());
+  RunStream();
+
+  ASSERT_TRUE(result.is_ready());
+  EXPECT_TRUE(result.get().empty());
+  EXPECT_EQ(0U, limiter_->bytes_in_flight());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace BIGTABLE_CLIENT_NS
+}  // namespace bigtable
+}  // namespace cloud
+}  // namespace google
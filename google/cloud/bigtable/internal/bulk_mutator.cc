@@ -26,6 +26,14 @@ namespace internal {
 
 namespace btproto = google::bigtable::v2;
 
+namespace {
+/// Return true if @p code indicates the server is overloaded.
+bool IsThrottlingError(grpc::StatusCode code) {
+  return code == grpc::StatusCode::RESOURCE_EXHAUSTED ||
+         code == grpc::StatusCode::UNAVAILABLE;
+}
+}  // namespace
+
 BulkMutatorState::BulkMutatorState(std::string const& app_profile_id,
                                    std::string const& table_name,
                                    IdempotentMutationPolicy& idempotent_policy,
@@ -69,6 +77,7 @@ google::bigtable::v2::MutateRowsRequest const& BulkMutatorState::BeforeStart() {
   pending_mutations_.set_app_profile_id(mutations_.app_profile_id());
   pending_mutations_.set_table_name(mutations_.table_name());
   pending_annotations_ = {};
+  throttled_ = false;
 
   return mutations_;
 }
@@ -97,6 +106,7 @@ std::vector<int> BulkMutatorState::OnRead(
       res.push_back(annotation.original_index);
       continue;
     }
+    if (IsThrottlingError(code)) throttled_ = true;
     auto& original = *mutations_.mutable_entries(static_cast<int>(index));
     // Failed responses are handled according to the current policies.
     if (SafeGrpcRetry::IsTransientFailure(code) && annotation.is_idempotent) {
@@ -118,6 +128,9 @@ std::vector<int> BulkMutatorState::OnRead(
 
 void BulkMutatorState::OnFinish(google::cloud::Status finish_status) {
   last_status_ = std::move(finish_status);
+  if (IsThrottlingError(static_cast<grpc::StatusCode>(last_status_.code()))) {
+    throttled_ = true;
+  }
 
   int index = 0;
   for (auto const& annotation : annotations_) {
@@ -187,6 +200,11 @@ BulkMutator::BulkMutator(std::string const& app_profile_id,
 
 grpc::Status BulkMutator::MakeOneRequest(bigtable::DataClient& client,
                                          grpc::ClientContext& client_context) {
+  // Wait until the server can take more mutations.
+  auto limiter = client.mutate_rows_limiter();
+  auto const bytes = state_.PendingBytes();
+  std::uint64_t token = 0;
+  if (limiter) token = limiter->Acquire(bytes);
   // Send the request to the server.
   auto const& mutations = state_.BeforeStart();
   auto stream = client.MutateRows(&client_context, mutations);
@@ -198,6 +216,7 @@ grpc::Status BulkMutator::MakeOneRequest(bigtable::DataClient& client,
   // Handle any errors in the stream.
   auto grpc_status = stream->Finish();
   state_.OnFinish(MakeStatusFromRpcError(grpc_status));
+  if (limiter) limiter->Release(bytes, token, state_.WasThrottled());
   return grpc_status;
 }
 
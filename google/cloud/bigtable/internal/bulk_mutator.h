@@ -38,6 +38,11 @@ class BulkMutatorState {
     return pending_mutations_.entries_size() != 0;
   }
 
+  /// The size of the request for the next MutateRows() RPC.
+  std::size_t PendingBytes() const {
+    return pending_mutations_.ByteSizeLong();
+  }
+
   /// Returns the Request parameter for the next MutateRows() RPC.
   google::bigtable::v2::MutateRowsRequest const& BeforeStart();
 
@@ -51,6 +56,14 @@ class BulkMutatorState {
   /// Handle the result of a `Finish()` operation on the MutateRows() RPC.
   void OnFinish(google::cloud::Status finish_status);
 
+  /**
+   * Return true if the server pushed back on the last MutateRows() RPC.
+   *
+   * That is, if the stream or any of the mutations failed with
+   * `RESOURCE_EXHAUSTED` or `UNAVAILABLE`.
+   */
+  bool WasThrottled() const { return throttled_; }
+
   /**
    * Return the permanently failed mutations.
    *
@@ -77,6 +90,9 @@ class BulkMutatorState {
    */
   google::cloud::Status last_status_;
 
+  /// Set if the server pushed back on the current request.
+  bool throttled_ = false;
+
   /// Accumulate any permanent failures and the list of mutations we gave up on.
   std::vector<FailedMutation> failures_;
 
@@ -39,6 +39,25 @@ std::unique_ptr<grpc::ClientContext> TestContext() {
       .Setup(*context);
   return context;
 }
+
+/// Return a reader for a stream with a single response.
+std::unique_ptr<MockMutateRowsReader> MakeReader(
+    std::vector<grpc::StatusCode> const& codes) {
+  auto reader = absl::make_unique<MockMutateRowsReader>(
+      "google.bigtable.v2.Bigtable.MutateRows");
+  EXPECT_CALL(*reader, Read(_))
+      .WillOnce(Invoke([codes](btproto::MutateRowsResponse* r) {
+        for (std::size_t i = 0; i != codes.size(); ++i) {
+          auto& e = *r->add_entries();
+          e.set_index(static_cast<std::int64_t>(i));
+          e.mutable_status()->set_code(codes[i]);
+        }
+        return true;
+      }))
+      .WillOnce(Return(false));
+  EXPECT_CALL(*reader, Finish()).WillOnce(Return(grpc::Status::OK));
+  return reader;
+}
 }  // anonymous namespace
 
 /// @test Verify that MultipleRowsMutator handles easy cases.
@@ -487,3 +506,113 @@ TEST(MultipleRowsMutatorTest, UnconfirmedAreFailed) {
   EXPECT_EQ(google::cloud::StatusCode::kPermissionDenied,
             failures.front().status().code());
 }
+
+/// @test Verify that MultipleRowsMutator holds the limiter around each stream.
+TEST(MultipleRowsMutatorTest, LimiterAroundEachStream) {
+  bt::BulkMutation mut(
+      bt::SingleRowMutation("foo", {bt::SetCell("fam", "col", 0_ms, "baz")}),
+      bt::SingleRowMutation("bar", {bt::SetCell("fam", "col", 0_ms, "qux")}));
+
+  // The first stream has a transient failure, which is retried.
+  auto r1 = MakeReader({grpc::StatusCode::OK, grpc::StatusCode::ABORTED});
+  auto r2 = MakeReader({grpc::StatusCode::OK});
+
+  auto limiter = std::make_shared<bigtable::MutateRowsLimiter>();
+  bigtable::testing::MockDataClient client;
+  EXPECT_CALL(client, mutate_rows_limiter()).WillRepeatedly(Return(limiter));
+  auto expect_acquired = [limiter](btproto::MutateRowsRequest const& req) {
+    EXPECT_EQ(req.ByteSizeLong(), limiter->bytes_in_flight());
+  };
+  EXPECT_CALL(client, MutateRows(_, _))
+      .WillOnce(Invoke([&r1, expect_acquired](
+                           grpc::ClientContext*,
+                           btproto::MutateRowsRequest const& req) {
+        EXPECT_EQ(2, req.entries_size());
+        expect_acquired(req);
+        return r1.release()->AsUniqueMocked();
+      }))
+      .WillOnce(Invoke([&r2, expect_acquired](
+                           grpc::ClientContext*,
+                           btproto::MutateRowsRequest const& req) {
+        EXPECT_EQ(1, req.entries_size());
+        expect_acquired(req);
+        return r2.release()->AsUniqueMocked();
+      }));
+
+  auto policy = bt::DefaultIdempotentMutationPolicy();
+  bt::internal::BulkMutator mutator("", "foo/bar/baz/table", *policy,
+                                    std::move(mut));
+
+  auto const initial_limit = limiter->bytes_in_flight_limit();
+  for (int i = 0; i != 2; ++i) {
+    EXPECT_TRUE(mutator.HasPendingMutations());
+    auto context = TestContext();
+    auto status = mutator.MakeOneRequest(client, *context);
+    EXPECT_TRUE(status.ok());
+    EXPECT_EQ(0U, limiter->bytes_in_flight());
+  }
+  EXPECT_FALSE(mutator.HasPendingMutations());
+  // ABORTED is not a sign of server overload.
+  EXPECT_EQ(0U, limiter->throttle_count());
+  EXPECT_LE(initial_limit, limiter->bytes_in_flight_limit());
+}
+
+/// @test Verify that failed entries with pushback errors throttle the limiter.
+TEST(MultipleRowsMutatorTest, LimiterThrottledByEntries) {
+  for (auto code : {grpc::StatusCode::RESOURCE_EXHAUSTED,
+                    grpc::StatusCode::UNAVAILABLE}) {
+    SCOPED_TRACE("Testing with " + std::to_string(code));
+    bt::BulkMutation mut(
+        bt::SingleRowMutation("foo", {bt::SetCell("fam", "col", 0_ms, "baz")}),
+        bt::SingleRowMutation("bar", {bt::SetCell("fam", "col", 0_ms, "qux")}));
+    auto reader = MakeReader({grpc::StatusCode::OK, code});
+
+    auto limiter = std::make_shared<bigtable::MutateRowsLimiter>();
+    bigtable::testing::MockDataClient client;
+    EXPECT_CALL(client, mutate_rows_limiter()).WillRepeatedly(Return(limiter));
+    EXPECT_CALL(client, MutateRows(_, _))
+        .WillOnce(Invoke(reader.release()->MakeMockReturner()));
+
+    auto policy = bt::DefaultIdempotentMutationPolicy();
+    bt::internal::BulkMutator mutator("", "foo/bar/baz/table", *policy,
+                                      std::move(mut));
+    auto const initial_limit = limiter->bytes_in_flight_limit();
+    auto context = TestContext();
+    auto status = mutator.MakeOneRequest(client, *context);
+    EXPECT_TRUE(status.ok());
+    EXPECT_EQ(0U, limiter->bytes_in_flight());
+    EXPECT_EQ(1U, limiter->throttle_count());
+    EXPECT_GT(initial_limit, limiter->bytes_in_flight_limit());
+  }
+}
+
+/// @test Verify that a stream failing with pushback throttles the limiter.
+TEST(MultipleRowsMutatorTest, LimiterThrottledByStream) {
+  for (auto code : {grpc::StatusCode::RESOURCE_EXHAUSTED,
+                    grpc::StatusCode::UNAVAILABLE}) {
+    SCOPED_TRACE("Testing with " + std::to_string(code));
+    bt::BulkMutation mut(
+        bt::SingleRowMutation("foo", {bt::SetCell("fam", "col", 0_ms, "baz")}),
+        bt::SingleRowMutation("bar", {bt::SetCell("fam", "col", 0_ms, "qux")}));
+    auto reader = absl::make_unique<MockMutateRowsReader>(
+        "google.bigtable.v2.Bigtable.MutateRows");
+    EXPECT_CALL(*reader, Read(_)).WillOnce(Return(false));
+    EXPECT_CALL(*reader, Finish())
+        .WillOnce(Return(grpc::Status(code, "try-again")));
+
+    auto limiter = std::make_shared<bigtable::MutateRowsLimiter>();
+    bigtable::testing::MockDataClient client;
+    EXPECT_CALL(client, mutate_rows_limiter()).WillRepeatedly(Return(limiter));
+    EXPECT_CALL(client, MutateRows(_, _))
+        .WillOnce(Invoke(reader.release()->MakeMockReturner()));
+
+    auto policy = bt::DefaultIdempotentMutationPolicy();
+    bt::internal::BulkMutator mutator("", "foo/bar/baz/table", *policy,
+                                      std::move(mut));
+    auto context = TestContext();
+    auto status = mutator.MakeOneRequest(client, *context);
+    EXPECT_EQ(code, status.error_code());
+    EXPECT_EQ(0U, limiter->bytes_in_flight());
+    EXPECT_EQ(1U, limiter->throttle_count());
+  }
+}
@@ -86,7 +86,7 @@ void ReadRowsParser::HandleChunk(ReadRowsResponse_CellChunk chunk,
 
   // Last chunk in the cell has zero for value size
   if (chunk.value_size() == 0) {
-    if (cells_.empty()) {
+    if (RowIsEmpty()) {
       if (cell_.row.empty()) {
         status = grpc::Status(grpc::StatusCode::INTERNAL,
                               "Missing row key at last chunk in cell");
@@ -100,12 +100,13 @@ void ReadRowsParser::HandleChunk(ReadRowsResponse_CellChunk chunk,
         return;
       }
     }
-    cells_.emplace_back(MovePartialToCell());
+    AddPartialCell();
     cell_first_chunk_ = true;
   }
 
   if (chunk.reset_row()) {
     cells_.clear();
+    compact_cells_.Clear();
     cell_ = {};
     if (!cell_first_chunk_) {
       status = grpc::Status(grpc::StatusCode::INTERNAL,
@@ -118,7 +119,7 @@ void ReadRowsParser::HandleChunk(ReadRowsResponse_CellChunk chunk,
                             "Commit row with an unfinished cell");
       return;
     }
-    if (cells_.empty()) {
+    if (RowIsEmpty()) {
       status = grpc::Status(grpc::StatusCode::INTERNAL,
                             "Commit row missing the row key");
       return;
@@ -143,7 +144,7 @@ void ReadRowsParser::HandleEndOfStream(grpc::Status& status) {
     return;
   }
 
-  if (cells_.begin() != cells_.end() && !row_ready_) {
+  if (!RowIsEmpty() && !row_ready_) {
     status = grpc::Status(grpc::StatusCode::INTERNAL,
                           "end of stream with unfinished row");
     return;
@@ -158,6 +159,7 @@ Row ReadRowsParser::Next(grpc::Status& status) {
         grpc::Status(grpc::StatusCode::INTERNAL, "Next with row not ready");
     return Row("", {});
   }
+  if (compact_rows_) return NextCompact(status).ToRow();
   row_ready_ = false;
 
   Row row(std::move(row_key_), std::move(cells_));
@@ -166,6 +168,38 @@ Row ReadRowsParser::Next(grpc::Status& status) {
   return row;
 }
 
+CompactRow ReadRowsParser::NextCompact(grpc::Status& status) {
+  if (!compact_rows_) {
+    status = grpc::Status(grpc::StatusCode::INTERNAL,
+                          "NextCompact with a parser for non-compact rows");
+    return CompactRowBuilder().Build("");
+  }
+  if (!row_ready_) {
+    status =
+        grpc::Status(grpc::StatusCode::INTERNAL, "Next with row not ready");
+    return CompactRowBuilder().Build("");
+  }
+  row_ready_ = false;
+
+  auto row = compact_cells_.Build(std::move(row_key_));
+  row_key_.clear();
+
+  return row;
+}
+
+void ReadRowsParser::AddPartialCell() {
+  if (!compact_rows_) {
+    cells_.emplace_back(MovePartialToCell());
+    return;
+  }
+  // The value is copied into the row buffer, `cell_` is reused by the next
+  // cell.
+  compact_cells_.AddCell(cell_.family, cell_.column, cell_.timestamp,
+                         cell_.value, std::move(cell_.labels));
+  cell_.value.clear();
+  cell_.labels.clear();
+}
+
 Cell ReadRowsParser::MovePartialToCell() {
   // The row, family, and column are explicitly copied because the
   // ReadRows v2 may reuse them in future chunks. See the CellChunk
@@ -16,6 +16,7 @@
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_INTERNAL_READROWSPARSER_H
 
 #include "google/cloud/bigtable/cell.h"
+#include "google/cloud/bigtable/compact_row.h"
 #include "google/cloud/bigtable/row.h"
 #include "google/cloud/bigtable/version.h"
 #include "absl/memory/memory.h"
@@ -51,7 +52,16 @@ namespace internal {
  */
 class ReadRowsParser {
  public:
-  ReadRowsParser() : row_key_(""), last_seen_row_key_("") {}
+  ReadRowsParser() : ReadRowsParser(false) {}
+
+  /**
+   * Create a parser, optionally accumulating the rows as `CompactRow`.
+   *
+   * When @p compact_rows is true the completed rows should be taken with
+   * `NextCompact()`, `Next()` converts them to `Row`.
+   */
+  explicit ReadRowsParser(bool compact_rows)
+      : row_key_(""), last_seen_row_key_(""), compact_rows_(compact_rows) {}
 
   virtual ~ReadRowsParser() = default;
 
@@ -91,6 +101,14 @@ class ReadRowsParser {
    */
   virtual Row Next(grpc::Status& status);
 
+  /**
+   * Extract and take ownership of the data in a row, in compact form.
+   *
+   * Requires a parser created with `compact_rows == true`, and HasNext() must
+   * be true.
+   */
+  virtual CompactRow NextCompact(grpc::Status& status);
+
  private:
   /// Holds partially formed data until a full Row is ready.
   struct ParseCell {
@@ -111,6 +129,14 @@ class ReadRowsParser {
    */
   Cell MovePartialToCell();
 
+  /// Adds the completed cell to `cells_` or `compact_cells_`.
+  void AddPartialCell();
+
+  /// True if there are no parsed cells in the current row.
+  bool RowIsEmpty() const {
+    return compact_rows_ ? compact_cells_.empty() : cells_.empty();
+  }
+
   /// Row key for the current row.
   RowKeyType row_key_;
 
@@ -131,6 +157,12 @@ class ReadRowsParser {
 
   /// Have we received the end of stream call?
   bool end_of_stream_{false};
+
+  /// If true, the cells are accumulated in `compact_cells_`.
+  bool compact_rows_;
+
+  /// Parsed cells of a yet unfinished row, when `compact_rows_` is true.
+  CompactRowBuilder compact_cells_;
 };
 
 /// Factory for creating parser instances, defined for testability.
@@ -142,6 +174,11 @@ class ReadRowsParserFactory {
   virtual std::unique_ptr<ReadRowsParser> Create() {
     return absl::make_unique<ReadRowsParser>();
   }
+
+  /// Returns a newly created parser instance producing `CompactRow`.
+  virtual std::unique_ptr<ReadRowsParser> CreateCompact() {
+    return absl::make_unique<ReadRowsParser>(true);
+  }
 };
 }  // namespace internal
 }  // namespace BIGTABLE_CLIENT_NS
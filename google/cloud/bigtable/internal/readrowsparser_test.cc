@@ -122,6 +122,78 @@ TEST(ReadRowsParserTest, NextAfterEndOfStreamSucceeds) {
   EXPECT_FALSE(parser.HasNext());
 }
 
+TEST(ReadRowsParserTest, CompactRowSucceeds) {
+  using google::protobuf::TextFormat;
+  ReadRowsParser parser(true);
+  std::vector<std::string> chunks = {
+      R"(row_key: "RK"
+         family_name: < value: "F1">
+         qualifier: < value: "C1">
+         timestamp_micros: 42
+         value: "V1")",
+      R"(timestamp_micros: 41
+         labels: "L1"
+         value: "V2")",
+      R"(family_name: < value: "F2">
+         qualifier: < value: "C2">
+         timestamp_micros: 40
+         value: "V"
+         value_size: 4)",
+      R"(value: "345"
+         commit_row: true)",
+  };
+  grpc::Status status;
+  for (auto const& c : chunks) {
+    ReadRowsResponse_CellChunk chunk;
+    ASSERT_TRUE(TextFormat::ParseFromString(c, &chunk));
+    parser.HandleChunk(std::move(chunk), status);
+    ASSERT_TRUE(status.ok());
+  }
+  EXPECT_TRUE(parser.HasNext());
+
+  auto row = parser.NextCompact(status);
+  EXPECT_TRUE(status.ok());
+  EXPECT_FALSE(parser.HasNext());
+  EXPECT_EQ("RK", row.row_key());
+  ASSERT_EQ(3U, row.size());
+  EXPECT_EQ("F1", row.cell(0).family_name());
+  EXPECT_EQ("C1", row.cell(0).column_qualifier());
+  EXPECT_EQ(42, row.cell(0).timestamp().count());
+  EXPECT_EQ("V1", row.cell(0).value());
+  EXPECT_TRUE(row.cell(0).labels().empty());
+  EXPECT_EQ("F1", row.cell(1).family_name());
+  EXPECT_EQ("C1", row.cell(1).column_qualifier());
+  EXPECT_EQ("V2", row.cell(1).value());
+  EXPECT_EQ(std::vector<std::string>{"L1"}, row.cell(1).labels());
+  EXPECT_EQ("F2", row.cell(2).family_name());
+  EXPECT_EQ("C2", row.cell(2).column_qualifier());
+  EXPECT_EQ(40, row.cell(2).timestamp().count());
+  EXPECT_EQ("V345", row.cell(2).value());
+
+  parser.HandleEndOfStream(status);
+  EXPECT_TRUE(status.ok());
+}
+
+TEST(ReadRowsParserTest, NextCompactRequiresCompactParser) {
+  using google::protobuf::TextFormat;
+  ReadRowsParser parser;
+  ReadRowsResponse_CellChunk chunk;
+  std::string chunk1 = R"(
+    row_key: "RK"
+    family_name: < value: "F">
+    qualifier: < value: "C">
+    value: "V"
+    commit_row: true
+    )";
+  ASSERT_TRUE(TextFormat::ParseFromString(chunk1, &chunk));
+  grpc::Status status;
+  parser.HandleChunk(chunk, status);
+  ASSERT_TRUE(status.ok());
+  EXPECT_TRUE(parser.HasNext());
+  parser.NextCompact(status);
+  EXPECT_FALSE(status.ok());
+}
+
 TEST(ReadRowsParserTest, NextWithNoDataThrows) {
   ReadRowsParser parser;
   grpc::Status status;
@@ -167,10 +239,13 @@ std::string CellToString(Cell const& cell) {
 
 class AcceptanceTest : public ::testing::Test {
  protected:
-  std::vector<std::string> ExtractCells() {
+  std::vector<std::string> ExtractCells() { return ExtractCells(rows_); }
+
+  static std::vector<std::string> ExtractCells(
+      std::vector<google::cloud::bigtable::Row> const& rows) {
     std::vector<std::string> cells;
 
-    for (auto const& r : rows_) {
+    for (auto const& r : rows) {
       std::transform(r.cells().begin(), r.cells().end(),
                      std::back_inserter(cells),
                      google::cloud::bigtable::CellToString);
@@ -196,20 +271,36 @@ class AcceptanceTest : public ::testing::Test {
 
   google::cloud::Status FeedChunks(
       std::vector<ReadRowsResponse_CellChunk> const& chunks) {
+    auto status = FeedChunks(parser_, chunks, rows_);
+
+    // The compact representation must produce the same results.
+    ReadRowsParser compact_parser(true);
+    std::vector<google::cloud::bigtable::Row> compact_rows;
+    auto compact_status = FeedChunks(compact_parser, chunks, compact_rows);
+    EXPECT_EQ(status.code(), compact_status.code());
+    EXPECT_EQ(ExtractCells(rows_), ExtractCells(compact_rows));
+
+    return status;
+  }
+
+  static google::cloud::Status FeedChunks(
+      ReadRowsParser& parser,
+      std::vector<ReadRowsResponse_CellChunk> const& chunks,
+      std::vector<google::cloud::bigtable::Row>& rows) {
     grpc::Status status;
     for (auto const& chunk : chunks) {
-      parser_.HandleChunk(chunk, status);
+      parser.HandleChunk(chunk, status);
       if (!status.ok()) {
         return ::google::cloud::MakeStatusFromRpcError(status);
       }
-      if (parser_.HasNext()) {
-        rows_.emplace_back(parser_.Next(status));
+      if (parser.HasNext()) {
+        rows.emplace_back(parser.Next(status));
         if (!status.ok()) {
           return ::google::cloud::MakeStatusFromRpcError(status);
         }
       }
     }
-    parser_.HandleEndOfStream(status);
+    parser.HandleEndOfStream(status);
     if (!status.ok()) {
       return ::google::cloud::MakeStatusFromRpcError(status);
     }
@@ -0,0 +1,137 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/bigtable/mutate_rows_limiter.h"
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace bigtable {
+inline namespace BIGTABLE_CLIENT_NS {
+
+// MutateRows requests are limited to 100,000 mutations, with small mutations
+// that is a few MiB, so start with room for a handful of full requests.
+auto constexpr kDefaultInitialBytesInFlight = 32 * 1024 * 1024;
+auto constexpr kDefaultMinBytesInFlight = 1024 * 1024;
+auto constexpr kDefaultMaxBytesInFlight = 512 * 1024 * 1024;
+auto constexpr kDefaultIncreaseStep = 1024 * 1024;
+auto constexpr kDefaultDecreaseFactor = 0.5;
+
+MutateRowsLimiter::Options::Options()
+    : initial_bytes_in_flight(kDefaultInitialBytesInFlight),
+      min_bytes_in_flight(kDefaultMinBytesInFlight),
+      max_bytes_in_flight(kDefaultMaxBytesInFlight),
+      increase_step(kDefaultIncreaseStep),
+      decrease_factor(kDefaultDecreaseFactor) {}
+
+namespace {
+MutateRowsLimiter::Options Sanitize(MutateRowsLimiter::Options options) {
+  options.min_bytes_in_flight =
+      (std::max<std::size_t>)(options.min_bytes_in_flight, 1);
+  options.max_bytes_in_flight =
+      (std::max)(options.max_bytes_in_flight, options.min_bytes_in_flight);
+  options.initial_bytes_in_flight = (std::min)(
+      (std::max)(options.initial_bytes_in_flight, options.min_bytes_in_flight),
+      options.max_bytes_in_flight);
+  if (options.decrease_factor <= 0.0 || options.decrease_factor > 1.0) {
+    options.decrease_factor = kDefaultDecreaseFactor;
+  }
+  return options;
+}
+}  // namespace
+
+MutateRowsLimiter::MutateRowsLimiter(Options options)
+    : options_(Sanitize(std::move(options))),
+      limit_(static_cast<double>(options_.initial_bytes_in_flight)) {}
+
+std::uint64_t MutateRowsLimiter::Acquire(std::size_t bytes) {
+  std::unique_lock<std::mutex> lk(mu_);
+  // Do not overtake the asynchronous callers already waiting.
+  cv_.wait(lk, [this, bytes] {
+    return waiters_.empty() && TryAcquireLocked(bytes);
+  });
+  return epoch_;
+}
+
+future<std::uint64_t> MutateRowsLimiter::AsyncAcquire(std::size_t bytes) {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (waiters_.empty() && TryAcquireLocked(bytes)) {
+    return make_ready_future(epoch_);
+  }
+  waiters_.push_back(Waiter{bytes, promise<std::uint64_t>()});
+  return waiters_.back().admitted.get_future();
+}
+
+void MutateRowsLimiter::Release(std::size_t bytes, std::uint64_t token,
+                                bool throttled) {
+  std::unique_lock<std::mutex> lk(mu_);
+  in_flight_ -= (std::min)(bytes, in_flight_);
+  auto const min = static_cast<double>(options_.min_bytes_in_flight);
+  auto const max = static_cast<double>(options_.max_bytes_in_flight);
+  if (throttled) {
+    // Requests sent before the last decrease report the old congestion.
+    if (token == epoch_) {
+      limit_ = (std::max)(min, limit_ * options_.decrease_factor);
+      ++epoch_;
+      ++throttle_count_;
+    }
+  } else {
+    // Grow by `increase_step` for each `limit_` bytes completed.
+    auto const step = static_cast<double>(options_.increase_step);
+    auto const growth = step * static_cast<double>(bytes) / limit_;
+    limit_ = (std::min)(max, limit_ + growth);
+  }
+  auto admitted = AdmitWaitersLocked();
+  auto const epoch = epoch_;
+  lk.unlock();
+  cv_.notify_all();
+  for (auto& p : admitted) p.set_value(epoch);
+}
+
+std::size_t MutateRowsLimiter::bytes_in_flight_limit() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return static_cast<std::size_t>(limit_);
+}
+
+std::size_t MutateRowsLimiter::bytes_in_flight() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return in_flight_;
+}
+
+std::uint64_t MutateRowsLimiter::throttle_count() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return throttle_count_;
+}
+
+bool MutateRowsLimiter::TryAcquireLocked(std::size_t bytes) {
+  if (in_flight_ != 0 && static_cast<double>(in_flight_ + bytes) > limit_) {
+    return false;
+  }
+  in_flight_ += bytes;
+  return true;
+}
+
+std::vector<promise<std::uint64_t>> MutateRowsLimiter::AdmitWaitersLocked() {
+  std::vector<promise<std::uint64_t>> admitted;
+  while (!waiters_.empty() && TryAcquireLocked(waiters_.front().bytes)) {
+    admitted.push_back(std::move(waiters_.front().admitted));
+    waiters_.pop_front();
+  }
+  return admitted;
+}
+
+}  // namespace BIGTABLE_CLIENT_NS
+}  // namespace bigtable
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,162 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_MUTATE_ROWS_LIMITER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_MUTATE_ROWS_LIMITER_H
+
+#include "google/cloud/bigtable/version.h"
+#include "google/cloud/future.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace bigtable {
+inline namespace BIGTABLE_CLIENT_NS {
+/**
+ * Adapts the number of `MutateRows` bytes in flight to the server pushback.
+ *
+ * `Table::BulkApply()` and `Table::AsyncBulkApply()` acquire the size of each
+ * `MutateRows` request from this object before sending it, and release it
+ * when the request completes. When the server rejects mutations with
+ * `RESOURCE_EXHAUSTED` or `UNAVAILABLE` the limit is multiplied by the
+ * decrease factor, when a request succeeds the limit grows by (about) the
+ * increase step for each limit's worth of bytes completed. That is, the limit
+ * follows an additive-increase / multiplicative-decrease (AIMD) scheme, much
+ * like the TCP congestion window.
+ *
+ * A single limiter is shared by all the `Table` objects using the same
+ * `DataClient`, see `ClientOptions::set_mutate_rows_limiter_options()`.
+ *
+ * @par Thread-safety
+ * All the member functions are thread-safe.
+ */
+class MutateRowsLimiter {
+ public:
+  /// Configuration for `MutateRowsLimiter`.
+  struct Options {
+    Options();
+
+    /// The limit, in bytes, before any feedback from the server.
+    Options& SetInitialBytesInFlight(std::size_t initial_bytes_in_flight_arg) {
+      initial_bytes_in_flight = initial_bytes_in_flight_arg;
+      return *this;
+    }
+
+    /// The limit is never decreased below this value.
+    Options& SetMinBytesInFlight(std::size_t min_bytes_in_flight_arg) {
+      min_bytes_in_flight = min_bytes_in_flight_arg;
+      return *this;
+    }
+
+    /// The limit is never increased above this value.
+    Options& SetMaxBytesInFlight(std::size_t max_bytes_in_flight_arg) {
+      max_bytes_in_flight = max_bytes_in_flight_arg;
+      return *this;
+    }
+
+    /// How much the limit grows after a limit's worth of successful bytes.
+    Options& SetIncreaseStep(std::size_t increase_step_arg) {
+      increase_step = increase_step_arg;
+      return *this;
+    }
+
+    /// The limit is multiplied by this value when the server pushes back.
+    Options& SetDecreaseFactor(double decrease_factor_arg) {
+      decrease_factor = decrease_factor_arg;
+      return *this;
+    }
+
+    std::size_t initial_bytes_in_flight;
+    std::size_t min_bytes_in_flight;
+    std::size_t max_bytes_in_flight;
+    std::size_t increase_step;
+    double decrease_factor;
+  };
+
+  explicit MutateRowsLimiter(Options options = Options());
+
+  /**
+   * Blocks until @p bytes can be sent without exceeding the limit.
+   *
+   * A request larger than the limit is admitted once nothing else is in
+   * flight, otherwise it could never be sent.
+   *
+   * @return a token to pass to `Release()`.
+   */
+  std::uint64_t Acquire(std::size_t bytes);
+
+  /**
+   * Like `Acquire()`, but returns a future instead of blocking.
+   *
+   * Requests are admitted in the order they arrive. The future may be
+   * satisfied inline, or from the thread calling `Release()`.
+   */
+  future<std::uint64_t> AsyncAcquire(std::size_t bytes);
+
+  /**
+   * Returns @p bytes acquired with @p token, and adjusts the limit.
+   *
+   * @param bytes the value passed to `Acquire()` or `AsyncAcquire()`.
+   * @param token the value returned by `Acquire()` or `AsyncAcquire()`.
+   * @param throttled true if the server rejected any mutation with
+   *     `RESOURCE_EXHAUSTED` or `UNAVAILABLE`.
+   *
+   * @note The limit is decreased at most once for all the requests sent
+   *     before the first decrease took effect. Without this, a burst of
+   *     rejections for requests sent at the old rate would collapse the limit.
+   */
+  void Release(std::size_t bytes, std::uint64_t token, bool throttled);
+
+  /// The current limit, in bytes.
+  std::size_t bytes_in_flight_limit() const;
+
+  /// The bytes acquired and not yet released.
+  std::size_t bytes_in_flight() const;
+
+  /// The number of times the limit was decreased.
+  std::uint64_t throttle_count() const;
+
+ private:
+  struct Waiter {
+    std::size_t bytes;
+    promise<std::uint64_t> admitted;
+  };
+
+  /// Returns true if @p bytes can be sent now, and if so, reserves them.
+  bool TryAcquireLocked(std::size_t bytes);
+  /// Reserves the bytes for the waiters that fit, returns their promises.
+  std::vector<promise<std::uint64_t>> AdmitWaitersLocked();
+
+  Options const options_;
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  double limit_;
+  std::size_t in_flight_ = 0;
+  // Incremented each time the limit decreases, see `Release()`.
+  std::uint64_t epoch_ = 0;
+  std::uint64_t throttle_count_ = 0;
+  // Asynchronous callers waiting for capacity, in arrival order.
+  std::deque<Waiter> waiters_;
+};
+
+}  // namespace BIGTABLE_CLIENT_NS
+}  // namespace bigtable
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_MUTATE_ROWS_LIMITER_H
@@ -0,0 +1,138 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/bigtable/mutate_rows_limiter.h"
+#include <gmock/gmock.h>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace bigtable {
+inline namespace BIGTABLE_CLIENT_NS {
+namespace {
+
+MutateRowsLimiter::Options TestOptions() {
+  return MutateRowsLimiter::Options()
+      .SetInitialBytesInFlight(1000)
+      .SetMinBytesInFlight(100)
+      .SetMaxBytesInFlight(2000)
+      .SetIncreaseStep(100)
+      .SetDecreaseFactor(0.5);
+}
+
+TEST(MutateRowsLimiterTest, OptionsAreSanitized) {
+  MutateRowsLimiter limiter(MutateRowsLimiter::Options()
+                                .SetInitialBytesInFlight(10)
+                                .SetMinBytesInFlight(100)
+                                .SetMaxBytesInFlight(50)
+                                .SetDecreaseFactor(2.0));
+  EXPECT_EQ(100U, limiter.bytes_in_flight_limit());
+}
+
+TEST(MutateRowsLimiterTest, AdmitsUpToLimit) {
+  MutateRowsLimiter limiter(TestOptions());
+  auto t1 = limiter.AsyncAcquire(600);
+  ASSERT_TRUE(t1.is_ready());
+  auto t2 = limiter.AsyncAcquire(400);
+  ASSERT_TRUE(t2.is_ready());
+  EXPECT_EQ(1000U, limiter.bytes_in_flight());
+
+  auto t3 = limiter.AsyncAcquire(100);
+  EXPECT_FALSE(t3.is_ready());
+  // Later requests wait behind `t3`, even if they would fit.
+  auto t4 = limiter.AsyncAcquire(1);
+  EXPECT_FALSE(t4.is_ready());
+
+  limiter.Release(600, t1.get(), false);
+  EXPECT_TRUE(t3.is_ready());
+  EXPECT_TRUE(t4.is_ready());
+  EXPECT_EQ(501U, limiter.bytes_in_flight());
+}
+
+TEST(MutateRowsLimiterTest, LargeRequestWhenIdle) {
+  MutateRowsLimiter limiter(TestOptions());
+  auto t1 = limiter.AsyncAcquire(5000);
+  ASSERT_TRUE(t1.is_ready());
+  auto t2 = limiter.AsyncAcquire(1);
+  EXPECT_FALSE(t2.is_ready());
+  limiter.Release(5000, t1.get(), false);
+  EXPECT_TRUE(t2.is_ready());
+}
+
+TEST(MutateRowsLimiterTest, AdditiveIncrease) {
+  MutateRowsLimiter limiter(TestOptions());
+  // A full limit's worth of bytes increases the limit by one step.
+  limiter.Release(1000, limiter.Acquire(1000), false);
+  EXPECT_EQ(1100U, limiter.bytes_in_flight_limit());
+  for (int i = 0; i != 100; ++i) {
+    limiter.Release(1000, limiter.Acquire(1000), false);
+  }
+  EXPECT_EQ(2000U, limiter.bytes_in_flight_limit());
+  EXPECT_EQ(0U, limiter.bytes_in_flight());
+}
+
+TEST(MutateRowsLimiterTest, MultiplicativeDecrease) {
+  MutateRowsLimiter limiter(TestOptions());
+  limiter.Release(100, limiter.Acquire(100), true);
+  EXPECT_EQ(500U, limiter.bytes_in_flight_limit());
+  limiter.Release(100, limiter.Acquire(100), true);
+  EXPECT_EQ(250U, limiter.bytes_in_flight_limit());
+  limiter.Release(100, limiter.Acquire(100), true);
+  limiter.Release(100, limiter.Acquire(100), true);
+  EXPECT_EQ(100U, limiter.bytes_in_flight_limit());
+  EXPECT_EQ(4U, limiter.throttle_count());
+}
+
+TEST(MutateRowsLimiterTest, DecreaseOncePerEpoch) {
+  MutateRowsLimiter limiter(TestOptions());
+  auto t1 = limiter.Acquire(300);
+  auto t2 = limiter.Acquire(300);
+  auto t3 = limiter.Acquire(300);
+  // All three requests were sent at the old rate, only the first rejection
+  // reduces the limit.
+  limiter.Release(300, t1, true);
+  limiter.Release(300, t2, true);
+  EXPECT_EQ(500U, limiter.bytes_in_flight_limit());
+  EXPECT_EQ(1U, limiter.throttle_count());
+
+  // Requests sent after the decrease can reduce it again.
+  auto t4 = limiter.Acquire(100);
+  limiter.Release(300, t3, true);
+  EXPECT_EQ(500U, limiter.bytes_in_flight_limit());
+  limiter.Release(100, t4, true);
+  EXPECT_EQ(250U, limiter.bytes_in_flight_limit());
+  EXPECT_EQ(2U, limiter.throttle_count());
+}
+
+TEST(MutateRowsLimiterTest, AcquireBlocks) {
+  MutateRowsLimiter limiter(TestOptions());
+  auto t1 = limiter.Acquire(1000);
+  promise<std::uint64_t> admitted;
+  auto f = admitted.get_future();
+  std::thread t([&limiter, &admitted] {
+    admitted.set_value(limiter.Acquire(500));
+  });
+  EXPECT_EQ(std::future_status::timeout,
+            f.wait_for(std::chrono::milliseconds(50)));
+  limiter.Release(1000, t1, false);
+  limiter.Release(500, f.get(), false);
+  t.join();
+  EXPECT_EQ(0U, limiter.bytes_in_flight());
+}
+
+}  // namespace
+}  // namespace BIGTABLE_CLIENT_NS
+}  // namespace bigtable
+}  // namespace cloud
+}  // namespace google
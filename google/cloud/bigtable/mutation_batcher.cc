@@ -14,8 +14,12 @@
 
 #include "google/cloud/bigtable/mutation_batcher.h"
 #include "google/cloud/bigtable/internal/client_options_defaults.h"
+#include "google/cloud/bigtable/internal/google_bytes_traits.h"
 #include "google/cloud/grpc_error_delegate.h"
+#include <algorithm>
+#include <atomic>
 #include <sstream>
+#include <thread>
 
 namespace google {
 namespace cloud {
@@ -31,12 +35,67 @@ auto constexpr kDefaultMaxSizePerBatch =
 auto constexpr kDefaultMaxBatches = 8;
 auto constexpr kDefaultMaxOutstandingSize =
     kDefaultMaxSizePerBatch * kDefaultMaxBatches;
+// Tablets split and merge slowly, refreshing them is relatively expensive.
+auto constexpr kDefaultRowKeySamplingPeriod = std::chrono::minutes(5);
+
+namespace {
+void JoinRefreshThread(std::thread refresh) {
+  if (!refresh.joinable()) return;
+  // The refresh thread satisfies the futures returned by
+  // `AsyncWaitForNoPendingRequests()`, their continuations may run in it and
+  // start a new refresh, or destroy the `MutationBatcher`. The thread has no
+  // more work to do in that case.
+  if (refresh.get_id() == std::this_thread::get_id()) {
+    refresh.detach();
+    return;
+  }
+  refresh.join();
+}
+}  // namespace
 
 MutationBatcher::Options::Options()
     : max_mutations_per_batch(kBigtableMutationLimit),
       max_size_per_batch(kDefaultMaxSizePerBatch),
       max_batches(kDefaultMaxBatches),
-      max_outstanding_size(kDefaultMaxOutstandingSize) {}
+      max_outstanding_size(kDefaultMaxOutstandingSize),
+      max_linger(0),
+      shards(1),
+      group_by_tablet(false),
+      row_key_sampling_period(kDefaultRowKeySamplingPeriod) {}
+
+MutationBatcher::MutationBatcher(Table table, Options options)
+    : table_(std::move(table)),
+      options_(options),
+      tablet_splits_(std::make_shared<TabletSplits>()) {
+  // Each shard must be able to send at least one batch of the largest size,
+  // otherwise it could never admit some mutations. Limit the number of shards
+  // so these minimums do not exceed the global limits.
+  auto max_shards = options_.max_batches;
+  if (options_.max_size_per_batch != 0) {
+    auto const by_size =
+        options_.max_outstanding_size / options_.max_size_per_batch;
+    max_shards = (std::min)(max_shards, by_size);
+  }
+  max_shards = (std::max<std::size_t>)(max_shards, 1);
+  auto const count =
+      (std::min)((std::max<std::size_t>)(options_.shards, 1), max_shards);
+  auto const max_batches =
+      (std::max<std::size_t>)(options_.max_batches / count, 1);
+  auto const max_outstanding_size = (std::max)(
+      options_.max_outstanding_size / count, options_.max_size_per_batch);
+  shards_.reserve(count);
+  for (std::size_t i = 0; i != count; ++i) {
+    shards_.push_back(
+        absl::make_unique<Shard>(max_batches, max_outstanding_size));
+  }
+}
+
+MutationBatcher::~MutationBatcher() {
+  std::unique_lock<std::mutex> lk(tablet_splits_->mu);
+  auto refresh = std::move(refresh_thread_);
+  lk.unlock();
+  JoinRefreshThread(std::move(refresh));
+}
 
 std::pair<future<void>, future<Status>> MutationBatcher::AsyncApply(
     CompletionQueue& cq, SingleRowMutation mut) {
@@ -47,7 +106,8 @@ std::pair<future<void>, future<Status>> MutationBatcher::AsyncApply(
   PendingSingleRowMutation pending(std::move(mut),
                                    std::move(completion_promise),
                                    std::move(admission_promise));
-  std::unique_lock<std::mutex> lk(mu_);
+  auto& shard = PickShard(pending.mut.row_key(), &pending.tablet);
+  std::unique_lock<std::mutex> lk(shard.mu);
 
   grpc::Status mutation_status = IsValid(pending);
   if (!mutation_status.ok()) {
@@ -62,28 +122,141 @@ std::pair<future<void>, future<Status>> MutationBatcher::AsyncApply(
     pending.admission_promise.set_value();
     return res;
   }
-  ++num_requests_pending_;
+  ++shard.num_requests_pending;
 
-  if (!CanAppendToBatch(pending)) {
-    pending_mutations_.push(std::move(pending));
+  if (!CanAppendToBatch(shard, pending)) {
+    shard.pending_mutations.push(std::move(pending));
+    // The current batch cannot grow, there is no point in waiting for more
+    // mutations.
+    FlushIfPossible(shard, cq);
     return res;
   }
   std::vector<AdmissionPromise> admission_promises_to_satisfy;
   admission_promises_to_satisfy.emplace_back(
       std::move(pending.admission_promise));
-  Admit(std::move(pending));
-  FlushIfPossible(cq);
-  SatisfyPromises(std::move(admission_promises_to_satisfy), lk);
+  Admit(shard, std::move(pending));
+  FlushIfPossible(shard, cq);
+  SatisfyPromises(shard, cq, std::move(admission_promises_to_satisfy), lk);
   return res;
 }
 
 future<void> MutationBatcher::AsyncWaitForNoPendingRequests() {
-  std::unique_lock<std::mutex> lk(mu_);
-  if (num_requests_pending_ == 0) {
+  if (shards_.size() == 1) return AsyncWaitForNoPendingRequests(*shards_[0]);
+
+  std::vector<future<void>> pending;
+  pending.reserve(shards_.size() + 1);
+  for (auto& shard : shards_) {
+    pending.push_back(AsyncWaitForNoPendingRequests(*shard));
+  }
+  pending.push_back(AsyncWaitForTabletSplitsRefresh());
+
+  struct WaitForAll {
+    std::atomic<std::size_t> remaining;
+    NoMorePendingPromise done;
+  };
+  auto state = std::make_shared<WaitForAll>();
+  state->remaining = pending.size();
+  // The continuations may run inline, get the future before attaching them.
+  auto result = state->done.get_future();
+  for (auto& f : pending) {
+    f.then([state](future<void>) {
+      if (--state->remaining == 0) state->done.set_value();
+    });
+  }
+  return result;
+}
+
+MutationBatcher::Shard& MutationBatcher::PickShard(RowKeyType const& row_key,
+                                                   std::size_t* tablet) {
+  *tablet = 0;
+  if (options_.group_by_tablet) {
+    MaybeRefreshTabletSplits();
+    auto split_points = std::atomic_load(&tablet_splits_->split_points);
+    if (split_points) {
+      // Consecutive tablets use different shards, the hot tablets are often
+      // next to each other.
+      *tablet = internal::TabletForRowKey(*split_points, row_key);
+      return *shards_[*tablet % shards_.size()];
+    }
+  }
+  if (shards_.size() == 1) return *shards_[0];
+  // Each thread always uses the same shard, threads submitting mutations
+  // concurrently are likely to use different shards.
+  auto const hash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+  return *shards_[hash % shards_.size()];
+}
+
+MutationBatcher::Batch& MutationBatcher::CurrentBatch(Shard& shard,
+                                                     std::size_t tablet) {
+  auto& batch = shard.cur_batches[tablet];
+  if (!batch) {
+    batch = std::make_shared<Batch>();
+    batch->tablet = tablet;
+    batch->sequence = shard.next_sequence++;
+  }
+  return *batch;
+}
+
+void MutationBatcher::MaybeRefreshTabletSplits() {
+  auto const now = std::chrono::steady_clock::now().time_since_epoch().count();
+  if (now < tablet_splits_->next_refresh.load()) return;
+  bool expected = false;
+  if (!tablet_splits_->refreshing.compare_exchange_strong(expected, true)) {
+    return;
+  }
+  // There is no asynchronous version of `SampleRows()`. It blocks, including
+  // the backoff between retries, so it must not run in a `CompletionQueue`
+  // thread: with a single thread it would stall all the asynchronous
+  // operations, including the batches of this object. Only one refresh runs at
+  // a time, its thread is joined by the next refresh or by the destructor.
+  auto splits = tablet_splits_;
+  auto table = std::make_shared<Table>(table_);
+  auto const period =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          options_.row_key_sampling_period);
+  std::unique_lock<std::mutex> lk(splits->mu);
+  auto previous = std::move(refresh_thread_);
+  refresh_thread_ = std::thread([splits, table, period]() mutable {
+    auto samples = table->SampleRows();
+    table.reset();
+    // On errors keep the current boundaries, they may be stale but they are
+    // still useful.
+    if (samples) {
+      std::atomic_store(&splits->split_points,
+                        std::shared_ptr<std::vector<RowKeyType> const>(
+                            std::make_shared<std::vector<RowKeyType>>(
+                                internal::SplitPointsFromSamples(*samples))));
+    }
+    splits->next_refresh =
+        (std::chrono::steady_clock::now() + period).time_since_epoch().count();
+    std::vector<NoMorePendingPromise> refresh_done_promises;
+    std::unique_lock<std::mutex> done_lk(splits->mu);
+    splits->refreshing = false;
+    splits->refresh_done_promises.swap(refresh_done_promises);
+    done_lk.unlock();
+    for (auto& promise : refresh_done_promises) {
+      promise.set_value();
+    }
+  });
+  lk.unlock();
+  // The previous refresh has completed, or is about to.
+  JoinRefreshThread(std::move(previous));
+}
+
+future<void> MutationBatcher::AsyncWaitForTabletSplitsRefresh() {
+  std::lock_guard<std::mutex> lk(tablet_splits_->mu);
+  if (!tablet_splits_->refreshing.load()) return make_ready_future();
+  tablet_splits_->refresh_done_promises.emplace_back();
+  return tablet_splits_->refresh_done_promises.back().get_future();
+}
+
+future<void> MutationBatcher::AsyncWaitForNoPendingRequests(Shard& shard) {
+  std::unique_lock<std::mutex> lk(shard.mu);
+  if (shard.num_requests_pending == 0 && shard.num_linger_timers == 0) {
     return make_ready_future();
   }
-  no_more_pending_promises_.emplace_back();
-  return no_more_pending_promises_.back().get_future();
+  shard.no_more_pending_promises.emplace_back();
+  return shard.no_more_pending_promises.back().get_future();
 }
 
 MutationBatcher::PendingSingleRowMutation::PendingSingleRowMutation(
@@ -126,34 +299,87 @@ grpc::Status MutationBatcher::IsValid(PendingSingleRowMutation& mut) const {
   return grpc::Status();
 }
 
-bool MutationBatcher::HasSpaceFor(PendingSingleRowMutation const& mut) const {
-  return outstanding_size_ + mut.request_size <=
-             options_.max_outstanding_size &&
-         cur_batch_->requests_size + mut.request_size <=
+bool MutationBatcher::HasSpaceFor(Shard const& shard,
+                                  PendingSingleRowMutation const& mut) const {
+  if (shard.outstanding_size + mut.request_size > shard.max_outstanding_size) {
+    return false;
+  }
+  auto const b = shard.cur_batches.find(mut.tablet);
+  // A new batch is created for the mutation.
+  if (b == shard.cur_batches.end()) return true;
+  auto const& batch = *b->second;
+  return batch.requests_size + mut.request_size <=
              options_.max_size_per_batch &&
-         cur_batch_->num_mutations + mut.num_mutations <=
+         batch.num_mutations + mut.num_mutations <=
              options_.max_mutations_per_batch;
 }
 
-bool MutationBatcher::FlushIfPossible(CompletionQueue cq) {
-  if (cur_batch_->num_mutations > 0 &&
-      num_outstanding_batches_ < options_.max_batches) {
-    ++num_outstanding_batches_;
+bool MutationBatcher::IsReadyToSend(Shard const& shard,
+                                    Batch const& batch) const {
+  if (options_.max_linger.count() <= 0 || batch.linger_expired) return true;
+  // Mutations waiting for admission do not fit in the current batch.
+  if (!shard.pending_mutations.empty()) return true;
+  return batch.num_mutations >= options_.max_mutations_per_batch ||
+         batch.requests_size >= options_.max_size_per_batch;
+}
 
-    auto batch = std::make_shared<Batch>();
-    cur_batch_.swap(batch);
+bool MutationBatcher::FlushIfPossible(Shard& shard, CompletionQueue cq) {
+  bool sent = false;
+  while (shard.num_outstanding_batches < shard.max_batches) {
+    // Send the oldest batch first, so no tablet is starved.
+    auto ready = shard.cur_batches.end();
+    for (auto b = shard.cur_batches.begin(); b != shard.cur_batches.end();
+         ++b) {
+      auto const& batch = *b->second;
+      if (batch.num_mutations == 0 || !IsReadyToSend(shard, batch)) continue;
+      if (ready == shard.cur_batches.end() ||
+          batch.sequence < ready->second->sequence) {
+        ready = b;
+      }
+    }
+    if (ready == shard.cur_batches.end()) break;
+    ++shard.num_outstanding_batches;
+
+    auto batch = std::move(ready->second);
+    shard.cur_batches.erase(ready);
+    auto* s = &shard;
     table_.AsyncBulkApply(std::move(batch->requests), cq)
-        .then([this, cq,
+        .then([this, s, cq,
                batch](future<std::vector<FailedMutation>> failed) mutable {
-          OnBulkApplyDone(std::move(cq), std::move(*batch), failed.get());
+          OnBulkApplyDone(*s, std::move(cq), std::move(*batch), failed.get());
         });
-    return true;
+    sent = true;
   }
-  return false;
+  return sent;
+}
+
+void MutationBatcher::StartLingerTimer(Shard& shard, CompletionQueue cq,
+                                       std::shared_ptr<Batch> batch) {
+  auto* s = &shard;
+  // The timer holds a reference to the batch only to compare it with the
+  // current batch, the batch may have been sent (and completed) when the timer
+  // expires.
+  cq.MakeRelativeTimer(options_.max_linger)
+      .then([this, s, cq, batch](
+                future<StatusOr<std::chrono::system_clock::time_point>>) {
+        // Even if the timer was cancelled the batch must be sent.
+        OnLingerTimer(*s, cq, batch);
+      });
+}
+
+void MutationBatcher::OnLingerTimer(Shard& shard, CompletionQueue cq,
+                                    std::shared_ptr<Batch> const& batch) {
+  std::unique_lock<std::mutex> lk(shard.mu);
+  --shard.num_linger_timers;
+  auto const b = shard.cur_batches.find(batch->tablet);
+  if (b != shard.cur_batches.end() && b->second == batch) {
+    batch->linger_expired = true;
+  }
+  SatisfyPromises(shard, cq, TryAdmit(shard, cq), lk);  // unlocks the lock
 }
 
 void MutationBatcher::OnBulkApplyDone(
-    CompletionQueue cq, MutationBatcher::Batch batch,
+    Shard& shard, CompletionQueue cq, MutationBatcher::Batch batch,
     std::vector<FailedMutation> const& failed) {
   // First process all the failures, marking the mutations as done after
   // processing them.
@@ -182,52 +408,73 @@ void MutationBatcher::OnBulkApplyDone(
   auto const num_mutations = batch.mutation_data.size();
   batch.mutation_data.clear();
 
-  std::unique_lock<std::mutex> lk(mu_);
-  outstanding_size_ -= batch.requests_size;
-  num_requests_pending_ -= num_mutations;
-  num_outstanding_batches_--;
-  SatisfyPromises(TryAdmit(cq), lk);  // unlocks the lock
+  std::unique_lock<std::mutex> lk(shard.mu);
+  shard.outstanding_size -= batch.requests_size;
+  shard.num_requests_pending -= num_mutations;
+  shard.num_outstanding_batches--;
+  SatisfyPromises(shard, cq, TryAdmit(shard, cq), lk);  // unlocks the lock
 }
 
 std::vector<MutationBatcher::AdmissionPromise> MutationBatcher::TryAdmit(
-    CompletionQueue& cq) {
+    Shard& shard, CompletionQueue& cq) {
   // Defer satisfying promises until we release the lock.
   std::vector<AdmissionPromise> admission_promises;
 
   do {
-    while (!pending_mutations_.empty() &&
-           HasSpaceFor(pending_mutations_.front())) {
-      auto& mut = pending_mutations_.front();
+    while (!shard.pending_mutations.empty() &&
+           HasSpaceFor(shard, shard.pending_mutations.front())) {
+      auto& mut = shard.pending_mutations.front();
       admission_promises.emplace_back(std::move(mut.admission_promise));
-      Admit(std::move(mut));
-      pending_mutations_.pop();
+      Admit(shard, std::move(mut));
+      shard.pending_mutations.pop();
     }
-  } while (FlushIfPossible(cq));
+  } while (FlushIfPossible(shard, cq));
   return admission_promises;
 }
 
-void MutationBatcher::Admit(PendingSingleRowMutation mut) {
-  outstanding_size_ += mut.request_size;
-  cur_batch_->requests_size += mut.request_size;
-  cur_batch_->num_mutations += mut.num_mutations;
-  cur_batch_->requests.emplace_back(std::move(mut.mut));
-  cur_batch_->mutation_data.emplace_back(MutationData(std::move(mut)));
+void MutationBatcher::Admit(Shard& shard, PendingSingleRowMutation mut) {
+  auto& batch = CurrentBatch(shard, mut.tablet);
+  shard.outstanding_size += mut.request_size;
+  batch.requests_size += mut.request_size;
+  batch.num_mutations += mut.num_mutations;
+  batch.requests.emplace_back(std::move(mut.mut));
+  batch.mutation_data.emplace_back(MutationData(std::move(mut)));
 }
 
 void MutationBatcher::SatisfyPromises(
+    Shard& shard, CompletionQueue& cq,
     std::vector<AdmissionPromise> admission_promises,
     std::unique_lock<std::mutex>& lk) {
+  // A new batch waiting for more mutations needs a linger timer. The timers
+  // are started without holding the lock because their callbacks may run
+  // inline, e.g., if the completion queue is shutdown.
+  std::vector<std::shared_ptr<Batch>> linger_batches;
+  if (options_.max_linger.count() > 0) {
+    for (auto& b : shard.cur_batches) {
+      auto& batch = b.second;
+      if (batch->num_mutations == 0 || batch->linger_started) continue;
+      batch->linger_started = true;
+      ++shard.num_linger_timers;
+      linger_batches.push_back(batch);
+    }
+  }
   std::vector<NoMorePendingPromise> no_more_pending_promises;
-  if (num_requests_pending_ == 0 && num_outstanding_batches_ == 0) {
-    // We should wait not only on num_requests_pending_ being zero but also on
-    // num_outstanding_batches_ because we want to allow the user to kill the
+  if (shard.num_requests_pending == 0 && shard.num_outstanding_batches == 0 &&
+      shard.num_linger_timers == 0) {
+    // We should wait not only on num_requests_pending being zero but also on
+    // num_outstanding_batches because we want to allow the user to kill the
     // completion queue after this promise is fulfilled. Otherwise, the user can
     // destroy the completion queue while the last batch is still being
-    // processed - we've had this bug (#2140).
-    no_more_pending_promises_.swap(no_more_pending_promises);
+    // processed - we've had this bug (#2140). The linger timers also use the
+    // completion queue, and `this`.
+    shard.no_more_pending_promises.swap(no_more_pending_promises);
   }
   lk.unlock();
 
+  for (auto& batch : linger_batches) {
+    StartLingerTimer(shard, cq, std::move(batch));
+  }
+
   // Inform the user that we've admitted these mutations and there might be some
   // space in the buffer finally.
   for (auto& promise : admission_promises) {
@@ -238,6 +485,36 @@ void MutationBatcher::SatisfyPromises(
   }
 }
 
+namespace internal {
+namespace {
+bool RowKeyLess(RowKeyType const& lhs, RowKeyType const& rhs) {
+  return CompareRowKey(lhs, rhs) < 0;
+}
+}  // namespace
+
+std::size_t TabletForRowKey(std::vector<RowKeyType> const& split_points,
+                            RowKeyType const& row_key) {
+  // Each sample is strictly larger than all the rows in its tablet.
+  return static_cast<std::size_t>(std::distance(
+      split_points.begin(),
+      std::upper_bound(split_points.begin(), split_points.end(), row_key,
+                       RowKeyLess)));
+}
+
+std::vector<RowKeyType> SplitPointsFromSamples(
+    std::vector<RowKeySample> const& samples) {
+  std::vector<RowKeyType> split_points;
+  split_points.reserve(samples.size());
+  for (auto const& sample : samples) {
+    // The empty row key represents the end of the table.
+    if (IsEmptyRowKey(sample.row_key)) continue;
+    split_points.push_back(sample.row_key);
+  }
+  std::sort(split_points.begin(), split_points.end(), RowKeyLess);
+  return split_points;
+}
+
+}  // namespace internal
 }  // namespace BIGTABLE_CLIENT_NS
 }  // namespace bigtable
 }  // namespace cloud
@@ -18,15 +18,24 @@
 #include "google/cloud/bigtable/client_options.h"
 #include "google/cloud/bigtable/completion_queue.h"
 #include "google/cloud/bigtable/mutations.h"
+#include "google/cloud/bigtable/row_key.h"
+#include "google/cloud/bigtable/row_key_sample.h"
 #include "google/cloud/bigtable/table.h"
 #include "google/cloud/bigtable/version.h"
 #include "google/cloud/status.h"
 #include "absl/memory/memory.h"
 #include <google/bigtable/v2/bigtable.grpc.pb.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <deque>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
+#include <thread>
+#include <vector>
 
 namespace google {
 namespace cloud {
@@ -45,6 +54,15 @@ inline namespace BIGTABLE_CLIENT_NS {
  * This class also offers an easy-to-use flow control mechanism to avoid
  * unbounded growth in its internal buffers.
  *
+ * By default a batch is sent as soon as there are fewer than `max_batches`
+ * outstanding RPCs, so at low write rates most batches contain a single
+ * mutation. Setting `max_linger` holds partial batches for a short time to
+ * collect more mutations. When many threads call `AsyncApply()`, setting
+ * `shards` splits the batcher into independent sub-batchers, each with its own
+ * lock, to reduce contention. With `group_by_tablet` the batcher keeps a
+ * separate batch for each tablet, so each batch touches a single tablet, and
+ * the batches are sent independently of each other.
+ *
  * Applications must provide a `CompletionQueue` to (asynchronously) execute
  * these operations. The application is responsible of executing the
  * `CompletionQueue` event loop in one or more threads.
@@ -79,19 +97,80 @@ class MutationBatcher {
       return *this;
     }
 
+    /**
+     * A batch that is not full waits at most this long for more mutations.
+     *
+     * The batch is sent when it is full, or when it has waited this long and
+     * there are fewer than `max_batches` outstanding RPCs. A zero value
+     * disables the wait, and the batch is sent as soon as possible.
+     */
+    Options& SetMaxLinger(std::chrono::milliseconds max_linger_arg) {
+      max_linger = max_linger_arg;
+      return *this;
+    }
+
+    /**
+     * Split the batcher into this many independent sub-batchers.
+     *
+     * Each thread calling `AsyncApply()` always uses the same sub-batcher,
+     * unless `group_by_tablet` is set, then each tablet always uses the same
+     * sub-batcher. The `max_batches` and `max_outstanding_size` limits are
+     * divided among the sub-batchers, each one can have at least one batch
+     * and `max_size_per_batch` bytes outstanding.
+     *
+     * The number of sub-batchers is capped at `max_batches`, and at
+     * `max_outstanding_size / max_size_per_batch`, so the sub-batchers never
+     * exceed the limits of the batcher. Larger values are silently reduced.
+     */
+    Options& SetShards(std::size_t shards_arg) {
+      shards = shards_arg;
+      return *this;
+    }
+
     std::size_t max_mutations_per_batch;
     std::size_t max_size_per_batch;
     std::size_t max_batches;
     std::size_t max_outstanding_size;
+    /**
+     * Group the mutations in batches by the tablet containing their row.
+     *
+     * Each tablet has its own batch, which is sent when it is ready,
+     * independently of the batches for other tablets. The batches of tablet
+     * `i` are handled by sub-batcher `i % shards`, and share its
+     * `max_batches` and `max_outstanding_size` limits. When the batches
+     * cannot all be sent, the oldest batch is sent first.
+     *
+     * The tablet boundaries are obtained with `Table::SampleRows()` and
+     * refreshed every `row_key_sampling_period`. `SampleRows()` is a blocking
+     * call, it runs in a separate thread, and never in the threads of the
+     * `CompletionQueue`. Until the first sample is received the mutations
+     * are batched as if this option was not set.
+     *
+     * Splitting the mutations by tablet makes the batches smaller, consider
+     * setting `max_linger` to fill them.
+     */
+    Options& SetGroupByTablet(bool group_by_tablet_arg) {
+      group_by_tablet = group_by_tablet_arg;
+      return *this;
+    }
+
+    /// How often the tablet boundaries are refreshed with `group_by_tablet`.
+    Options& SetRowKeySamplingPeriod(
+        std::chrono::milliseconds row_key_sampling_period_arg) {
+      row_key_sampling_period = row_key_sampling_period_arg;
+      return *this;
+    }
+
+    std::chrono::milliseconds max_linger;
+    std::size_t shards;
+    bool group_by_tablet;
+    std::chrono::milliseconds row_key_sampling_period;
   };
 
-  explicit MutationBatcher(Table table, Options options = Options())
-      : table_(std::move(table)),
-        options_(options),
-        num_outstanding_batches_(),
-        outstanding_size_(),
-        num_requests_pending_(),
-        cur_batch_(std::make_shared<Batch>()) {}
+  explicit MutationBatcher(Table table, Options options = Options());
+
+  /// Waits for any refresh of the tablet boundaries to complete.
+  ~MutationBatcher();
 
   /**
    * Asynchronously apply mutation.
@@ -153,6 +232,11 @@ class MutationBatcher {
    * @return a future which will be satisfied once all mutations submitted
    *     before calling this function finish; if there are no such operations,
    *     the returned future is already satisfied.
+   *
+   * @note With a non-zero `max_linger` the future is not satisfied until the
+   *     timers started for the outstanding batches expire. With
+   *     `group_by_tablet` it is not satisfied until any running refresh of
+   *     the tablet boundaries completes.
    */
   future<void> AsyncWaitForNoPendingRequests();
 
@@ -173,6 +257,8 @@ class MutationBatcher {
     SingleRowMutation mut;
     size_t num_mutations;
     size_t request_size;
+    /// The tablet containing the row, always 0 without `group_by_tablet`.
+    std::size_t tablet = 0;
     CompletionPromise completion_promise;
     AdmissionPromise admission_promise;
   };
@@ -215,88 +301,194 @@ class MutationBatcher {
     size_t requests_size{};
     BulkMutation requests;
     std::vector<MutationData> mutation_data;
+    /// The linger timer for this batch has been started.
+    bool linger_started{};
+    /// The batch has waited `max_linger` and should be sent.
+    bool linger_expired{};
+    /// The tablet of the mutations, always 0 without `group_by_tablet`.
+    std::size_t tablet{};
+    /// The order in which the batches of a shard were created.
+    std::uint64_t sequence{};
+  };
+
+  /**
+   * An independent sub-batcher.
+   *
+   * All the members are protected by `mu`. Shards share no mutable state, so
+   * threads using different shards do not contend.
+   */
+  struct Shard {
+    Shard(std::size_t max_batches_arg, std::size_t max_outstanding_size_arg)
+        : max_batches(max_batches_arg),
+          max_outstanding_size(max_outstanding_size_arg) {}
+
+    std::mutex mu;
+    /// The share of `Options::max_batches` for this shard.
+    std::size_t const max_batches;
+    /// The share of `Options::max_outstanding_size` for this shard.
+    std::size_t const max_outstanding_size;
+
+    /// Num batches sent but not completed.
+    size_t num_outstanding_batches{};
+    /// Size of admitted but uncompleted mutations.
+    size_t outstanding_size{};
+    // Number of uncompleted SingleRowMutations (including not admitted).
+    size_t num_requests_pending{};
+    /// Number of linger timers that have not expired.
+    size_t num_linger_timers{};
+
+    /**
+     * The batches being constructed, by tablet.
+     *
+     * Batches are created by the first mutation for their tablet, and removed
+     * when they are sent. Without `group_by_tablet` all the mutations use
+     * tablet 0.
+     */
+    std::map<std::size_t, std::shared_ptr<Batch>> cur_batches;
+    /// The `Batch::sequence` of the next batch.
+    std::uint64_t next_sequence{};
+
+    /**
+     * These are the mutations which have not been admitted yet. If the user is
+     * properly reacting to `admission_promise`s, there should be very few of
+     * these (likely no more than one).
+     */
+    std::queue<PendingSingleRowMutation> pending_mutations;
+
+    /**
+     * The list of promises made to this point.
+     *
+     * These promises are satisfied as part of calling
+     * `AsyncWaitForNoPendingRequests()`.
+     */
+    std::vector<NoMorePendingPromise> no_more_pending_promises;
+  };
+
+  /**
+   * The cached tablet boundaries used with `group_by_tablet`.
+   *
+   * Shared with the thread refreshing the boundaries.
+   */
+  struct TabletSplits {
+    /// Replaced as a whole, use `std::atomic_load()` and `std::atomic_store()`.
+    std::shared_ptr<std::vector<RowKeyType> const> split_points;
+    /// The next refresh, in `std::chrono::steady_clock` ticks.
+    std::atomic<std::chrono::steady_clock::rep> next_refresh{0};
+    /// Set when a refresh starts, cleared with `mu` held when it completes.
+    std::atomic<bool> refreshing{false};
+
+    std::mutex mu;
+    /// Satisfied when the running refresh completes.
+    std::vector<NoMorePendingPromise> refresh_done_promises;
   };
 
+  /// Pick the shard and the tablet for a mutation on @p row_key.
+  Shard& PickShard(RowKeyType const& row_key, std::size_t* tablet);
+
+  /// Returns the batch being constructed for @p tablet, creating it if needed.
+  Batch& CurrentBatch(Shard& shard, std::size_t tablet);
+
+  /// Start refreshing the tablet boundaries if they are stale.
+  void MaybeRefreshTabletSplits();
+
+  /// Wait until there are no pending requests in a single shard.
+  future<void> AsyncWaitForNoPendingRequests(Shard& shard);
+
+  /// Wait until the running refresh of the tablet boundaries, if any, ends.
+  future<void> AsyncWaitForTabletSplitsRefresh();
+
   /// Check if a mutation doesn't exceed allowed limits.
   grpc::Status IsValid(PendingSingleRowMutation& mut) const;
 
   /**
    * Check whether there is space for the passed mutation in the currently
-   * constructed batch.
+   * constructed batch for its tablet.
    */
-  bool HasSpaceFor(PendingSingleRowMutation const& mut) const;
+  bool HasSpaceFor(Shard const& shard,
+                   PendingSingleRowMutation const& mut) const;
 
   /**
    * Check if one can append a mutation to the currently constructed batch.
    * Even if there is space for the mutation, we shouldn't append mutations if
    * some other are not admitted yet.
    */
-  bool CanAppendToBatch(PendingSingleRowMutation const& mut) const {
+  bool CanAppendToBatch(Shard const& shard,
+                        PendingSingleRowMutation const& mut) const {
     // If some mutations are already subject to flow control, don't admit any
     // new, even if there's space for them. Otherwise we might starve big
     // mutations.
-    return pending_mutations_.empty() && HasSpaceFor(mut);
+    return shard.pending_mutations.empty() && HasSpaceFor(shard, mut);
   }
 
   /**
-   * Send the currently constructed batch if there are not too many outstanding
-   * already. If there are no mutations in the batch, it's a noop.
+   * Check if @p batch should be sent, or wait for more mutations.
+   */
+  bool IsReadyToSend(Shard const& shard, Batch const& batch) const;
+
+  /**
+   * Send the constructed batches that are ready, oldest first, while there are
+   * not too many outstanding already. Returns true if any batch was sent.
    */
-  bool FlushIfPossible(CompletionQueue cq);
+  bool FlushIfPossible(Shard& shard, CompletionQueue cq);
+
+  /// Start the linger timer for @p batch.
+  void StartLingerTimer(Shard& shard, CompletionQueue cq,
+                        std::shared_ptr<Batch> batch);
+
+  /// Handle an expired linger timer.
+  void OnLingerTimer(Shard& shard, CompletionQueue cq,
+                     std::shared_ptr<Batch> const& batch);
 
   /// Handle a completed batch.
-  void OnBulkApplyDone(CompletionQueue cq, MutationBatcher::Batch batch,
+  void OnBulkApplyDone(Shard& shard, CompletionQueue cq,
+                       MutationBatcher::Batch batch,
                        std::vector<FailedMutation> const& failed);
 
   /**
-   * Try to move mutations waiting in `pending_mutations_` to the currently
+   * Try to move mutations waiting in `pending_mutations` to the currently
    * constructed batch.
    *
    * @return the admission promises of the newly admitted mutations.
    */
-  std::vector<MutationBatcher::AdmissionPromise> TryAdmit(CompletionQueue& cq);
+  std::vector<MutationBatcher::AdmissionPromise> TryAdmit(Shard& shard,
+                                                          CompletionQueue& cq);
 
   /**
-   * Append mutation `mut` to the currently constructed batch.
+   * Append mutation `mut` to the currently constructed batch for its tablet.
    */
-  void Admit(PendingSingleRowMutation mut);
+  void Admit(Shard& shard, PendingSingleRowMutation mut);
 
   /**
    * Satisfies passed admission promises and potentially the promises of no more
-   * pending requests. Unlocks `lk`.
+   * pending requests. Starts the linger timers for the currently constructed
+   * batches if needed. Unlocks `lk`.
    */
-  void SatisfyPromises(std::vector<AdmissionPromise>,
+  void SatisfyPromises(Shard& shard, CompletionQueue& cq,
+                       std::vector<AdmissionPromise>,
                        std::unique_lock<std::mutex>& lk);
 
-  std::mutex mu_;
+  friend struct MutationBatcherTestTraits;
+
   Table table_;
   Options options_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::shared_ptr<TabletSplits> tablet_splits_;
+  /// The thread running the last refresh, protected by `tablet_splits_->mu`.
+  std::thread refresh_thread_;
+};
 
-  /// Num batches sent but not completed.
-  size_t num_outstanding_batches_;
-  /// Size of admitted but uncompleted mutations.
-  size_t outstanding_size_;
-  // Number of uncompleted SingleRowMutations (including not admitted).
-  size_t num_requests_pending_;
-
-  /// Currently contructed batch of mutations.
-  std::shared_ptr<Batch> cur_batch_;
-
-  /**
-   * These are the mutations which have not been admitted yet. If the user is
-   * properly reacting to `admission_promise`s, there should be very few of
-   * these (likely no more than one).
-   */
-  std::queue<PendingSingleRowMutation> pending_mutations_;
+namespace internal {
+/**
+ * Returns the index of the tablet containing @p row_key when the table is
+ * split at @p split_points.
+ */
+std::size_t TabletForRowKey(std::vector<RowKeyType> const& split_points,
+                            RowKeyType const& row_key);
 
-  /**
-   * The list of promises made to this point.
-   *
-   * These promises are satisfied as part of calling
-   * `AsyncWaitForNoPendingRequests()`.
-   */
-  std::vector<NoMorePendingPromise> no_more_pending_promises_;
-};
+/// Returns the split points in @p samples, without the end of table marker.
+std::vector<RowKeyType> SplitPointsFromSamples(
+    std::vector<RowKeySample> const& samples);
+}  // namespace internal
 
 }  // namespace BIGTABLE_CLIENT_NS
 }  // namespace bigtable
@@ -14,6 +14,7 @@
 
 #include "google/cloud/bigtable/mutation_batcher.h"
 #include "google/cloud/bigtable/testing/mock_mutate_rows_reader.h"
+#include "google/cloud/bigtable/testing/mock_sample_row_keys_reader.h"
 #include "google/cloud/bigtable/testing/table_test_fixture.h"
 #include "google/cloud/bigtable/testing/validate_metadata.h"
 #include "google/cloud/future.h"
@@ -22,11 +23,38 @@
 #include "google/cloud/testing_util/mock_completion_queue.h"
 #include <google/protobuf/util/message_differencer.h>
 #include <gmock/gmock.h>
+#include <future>
+#include <thread>
 
 namespace google {
 namespace cloud {
 namespace bigtable {
 inline namespace BIGTABLE_CLIENT_NS {
+
+struct MutationBatcherTestTraits {
+  /// Refresh the tablet boundaries, if they are stale, and wait for the result.
+  static void RefreshTabletSplits(MutationBatcher& batcher) {
+    batcher.MaybeRefreshTabletSplits();
+    batcher.AsyncWaitForNoPendingRequests().get();
+  }
+
+  /// Start refreshing the tablet boundaries, if they are stale.
+  static void StartTabletSplitsRefresh(MutationBatcher& batcher) {
+    batcher.MaybeRefreshTabletSplits();
+  }
+
+  static std::size_t NumShards(MutationBatcher const& batcher) {
+    return batcher.shards_.size();
+  }
+
+  static std::vector<RowKeyType> SplitPoints(MutationBatcher const& batcher) {
+    auto split_points =
+        std::atomic_load(&batcher.tablet_splits_->split_points);
+    if (!split_points) return {};
+    return *split_points;
+  }
+};
+
 namespace {
 
 namespace btproto = google::bigtable::v2;
@@ -34,9 +62,12 @@ namespace bt = ::google::cloud::bigtable;
 
 using ::google::cloud::testing_util::chrono_literals::operator"" _ms;
 using bigtable::testing::MockClientAsyncReaderInterface;
+using bigtable::testing::MockSampleRowKeysReader;
 using ::google::cloud::testing_util::MockCompletionQueue;
 using ::testing::_;
+using ::testing::ElementsAre;
 using ::testing::Invoke;
+using ::testing::Return;
 using ::testing::WithParamInterface;
 
 std::size_t MutationSize(SingleRowMutation mut) {
@@ -243,6 +274,47 @@ class MutationBatcherTest : public bigtable::testing::TableTestFixture {
 
   std::size_t NumOperationsOutstanding() { return cq_impl_->size(); }
 
+  /**
+   * Expect a `SampleRowKeys()` call returning @p row_keys.
+   *
+   * If @p gate is valid the responses are blocked until it is satisfied.
+   */
+  void ExpectSampleRowKeys(std::vector<std::string> const& row_keys,
+                           std::shared_future<void> gate = {}) {
+    auto* reader = new MockSampleRowKeysReader(
+        "google.bigtable.v2.Bigtable.SampleRowKeys");
+    auto& read = EXPECT_CALL(*reader, Read(_));
+    std::int64_t offset = 0;
+    for (auto const& key : row_keys) {
+      offset += 1000;
+      read.WillOnce(
+          Invoke([key, offset, gate](btproto::SampleRowKeysResponse* r) {
+            if (gate.valid()) gate.wait();
+            r->set_row_key(key);
+            r->set_offset_bytes(offset);
+            return true;
+          }));
+    }
+    read.WillOnce(Return(false));
+    EXPECT_CALL(*reader, Finish()).WillOnce(Return(grpc::Status::OK));
+    EXPECT_CALL(*client_, SampleRowKeys(_, _))
+        .WillOnce(Invoke(reader->MakeMockReturner()))
+        .RetiresOnSaturation();
+  }
+
+  /// Expect a `SampleRowKeys()` call failing with a permanent error.
+  void ExpectSampleRowKeysFailure() {
+    auto* reader = new MockSampleRowKeysReader(
+        "google.bigtable.v2.Bigtable.SampleRowKeys");
+    EXPECT_CALL(*reader, Read(_)).WillOnce(Return(false));
+    EXPECT_CALL(*reader, Finish())
+        .WillOnce(Return(
+            grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "uh-oh")));
+    EXPECT_CALL(*client_, SampleRowKeys(_, _))
+        .WillOnce(Invoke(reader->MakeMockReturner()))
+        .RetiresOnSaturation();
+  }
+
   std::shared_ptr<MockCompletionQueue> cq_impl_;
   CompletionQueue cq_;
   std::unique_ptr<MutationBatcher> batcher_;
@@ -260,6 +332,52 @@ TEST(OptionsTest, Trivial) {
   ASSERT_EQ(4, opt.max_outstanding_size);
 }
 
+TEST(OptionsTest, LingerAndShards) {
+  MutationBatcher::Options opt;
+  ASSERT_EQ(0, opt.max_linger.count());
+  ASSERT_EQ(1, opt.shards);
+  opt.SetMaxLinger(std::chrono::milliseconds(5)).SetShards(4);
+  ASSERT_EQ(5, opt.max_linger.count());
+  ASSERT_EQ(4, opt.shards);
+}
+
+TEST(OptionsTest, GroupByTablet) {
+  MutationBatcher::Options opt;
+  ASSERT_FALSE(opt.group_by_tablet);
+  ASSERT_LT(0, opt.row_key_sampling_period.count());
+  opt.SetGroupByTablet(true).SetRowKeySamplingPeriod(
+      std::chrono::milliseconds(7));
+  ASSERT_TRUE(opt.group_by_tablet);
+  ASSERT_EQ(7, opt.row_key_sampling_period.count());
+}
+
+TEST(TabletForRowKeyTest, Simple) {
+  std::vector<RowKeyType> split_points{"b", "d", "f"};
+  EXPECT_EQ(0, internal::TabletForRowKey(split_points, "a"));
+  // The split points belong to the next tablet.
+  EXPECT_EQ(1, internal::TabletForRowKey(split_points, "b"));
+  EXPECT_EQ(1, internal::TabletForRowKey(split_points, "c"));
+  EXPECT_EQ(2, internal::TabletForRowKey(split_points, "e"));
+  EXPECT_EQ(3, internal::TabletForRowKey(split_points, "z"));
+}
+
+TEST(TabletForRowKeyTest, NoSplitPoints) {
+  EXPECT_EQ(0, internal::TabletForRowKey({}, "a"));
+  EXPECT_EQ(0, internal::TabletForRowKey({}, "z"));
+}
+
+TEST(SplitPointsFromSamplesTest, Simple) {
+  auto make_sample = [](std::string key, std::int64_t offset) {
+    RowKeySample sample;
+    sample.row_key = std::move(key);
+    sample.offset_bytes = offset;
+    return sample;
+  };
+  auto actual = internal::SplitPointsFromSamples(
+      {make_sample("d", 20), make_sample("b", 10), make_sample("", 30)});
+  EXPECT_THAT(actual, ElementsAre("b", "d"));
+}
+
 TEST_F(MutationBatcherTest, TrivialTest) {
   std::vector<SingleRowMutation> mutations(
       {SingleRowMutation("foo", {bt::SetCell("fam", "col", 0_ms, "baz")})});
@@ -664,6 +782,281 @@ TEST_F(MutationBatcherTest, WaitForNoPendingEdgeCases) {
   EXPECT_EQ(no_more_pending2.wait_for(1_ms), std::future_status::ready);
 }
 
+TEST_F(MutationBatcherTest, LingerFlushesPartialBatch) {
+  std::vector<SingleRowMutation> mutations(
+      {SingleRowMutation("foo", {bt::SetCell("fam", "col", 0_ms, "baz")}),
+       SingleRowMutation("foo2", {bt::SetCell("fam", "col", 0_ms, "baz")})});
+  batcher_.reset(new MutationBatcher(
+      table_, MutationBatcher::Options().SetMaxLinger(10_ms)));
+
+  ExpectInteraction({Exchange({mutations[0], mutations[1]},
+                              {ResultPiece({0, 1}, {}, {})})});
+
+  // Both mutations wait for the linger timer, even though the batcher could
+  // send them right away.
+  auto state = ApplyMany(mutations.begin(), mutations.end());
+  EXPECT_TRUE(state.AllAdmitted());
+  EXPECT_TRUE(state.NoneCompleted());
+  EXPECT_EQ(1, NumOperationsOutstanding());
+
+  auto no_more_pending = batcher_->AsyncWaitForNoPendingRequests();
+  FinishTimer();
+  EXPECT_TRUE(state.NoneCompleted());
+  EXPECT_EQ(1, NumOperationsOutstanding());
+  EXPECT_EQ(no_more_pending.wait_for(1_ms), std::future_status::timeout);
+
+  FinishSingleItemStream();
+
+  EXPECT_TRUE(state.AllCompleted());
+  EXPECT_EQ(0, NumOperationsOutstanding());
+  EXPECT_EQ(no_more_pending.wait_for(1_ms), std::future_status::ready);
+}
+
+TEST_F(MutationBatcherTest, LingerDoesNotDelayFullBatch) {
+  std::vector<SingleRowMutation> mutations(
+      {SingleRowMutation("foo", {bt::SetCell("fam", "col", 0_ms, "baz")}),
+       SingleRowMutation("foo2", {bt::SetCell("fam", "col", 0_ms, "baz")})});
+  batcher_.reset(new MutationBatcher(
+      table_,
+      MutationBatcher::Options().SetMaxMutationsPerBatch(2).SetMaxLinger(
+          10_ms)));
+
+  ExpectInteraction({Exchange({mutations[0], mutations[1]},
+                              {ResultPiece({0, 1}, {}, {})})});
+
+  auto state0 = Apply(mutations[0]);
+  EXPECT_TRUE(state0->admitted);
+  // Only the linger timer is running.
+  EXPECT_EQ(1, NumOperationsOutstanding());
+
+  // The batch is full, it is sent without waiting for the timer.
+  auto state1 = Apply(mutations[1]);
+  EXPECT_TRUE(state1->admitted);
+  EXPECT_EQ(2, NumOperationsOutstanding());
+
+  auto no_more_pending = batcher_->AsyncWaitForNoPendingRequests();
+  // Completes the stream and the timer.
+  FinishSingleItemStream();
+
+  EXPECT_TRUE(state0->completed);
+  EXPECT_TRUE(state1->completed);
+  EXPECT_EQ(0, NumOperationsOutstanding());
+  EXPECT_EQ(no_more_pending.wait_for(1_ms), std::future_status::ready);
+}
+
+TEST_F(MutationBatcherTest, ShardsDivideLimits) {
+  std::vector<SingleRowMutation> mutations(
+      {SingleRowMutation("foo", {bt::SetCell("fam", "col", 0_ms, "baz")}),
+       SingleRowMutation("foo2", {bt::SetCell("fam", "col", 0_ms, "baz")}),
+       SingleRowMutation("foo3", {bt::SetCell("fam", "col", 0_ms, "baz")})});
+  // All the mutations are applied from this thread, so they use the same
+  // shard, which can only have one outstanding batch.
+  batcher_.reset(new MutationBatcher(
+      table_, MutationBatcher::Options().SetMaxBatches(2).SetShards(2)));
+
+  ExpectInteraction(
+      {Exchange({mutations[0]}, {ResultPiece({0}, {}, {})}),
+       Exchange({mutations[1], mutations[2]}, {ResultPiece({0, 1}, {}, {})})});
+
+  auto state0 = Apply(mutations[0]);
+  EXPECT_TRUE(state0->admitted);
+  EXPECT_EQ(1, NumOperationsOutstanding());
+
+  auto state1 = ApplyMany(mutations.begin() + 1, mutations.end());
+  EXPECT_TRUE(state1.AllAdmitted());
+  EXPECT_EQ(1, NumOperationsOutstanding());
+
+  auto no_more_pending = batcher_->AsyncWaitForNoPendingRequests();
+  FinishSingleItemStream();
+
+  EXPECT_TRUE(state0->completed);
+  EXPECT_TRUE(state1.NoneCompleted());
+  EXPECT_EQ(1, NumOperationsOutstanding());
+  EXPECT_EQ(no_more_pending.wait_for(1_ms), std::future_status::timeout);
+
+  FinishSingleItemStream();
+
+  EXPECT_TRUE(state1.AllCompleted());
+  EXPECT_EQ(0, NumOperationsOutstanding());
+  EXPECT_EQ(no_more_pending.wait_for(1_ms), std::future_status::ready);
+}
+
+TEST_F(MutationBatcherTest, ShardsLimitedByGlobalLimits) {
+  MutationBatcher by_batches(
+      table_, MutationBatcher::Options().SetMaxBatches(2).SetShards(4));
+  EXPECT_EQ(2, MutationBatcherTestTraits::NumShards(by_batches));
+
+  MutationBatcher by_size(table_, MutationBatcher::Options()
+                                      .SetMaxSizePerBatch(10)
+                                      .SetMaxBatches(8)
+                                      .SetMaxOutstandingSize(30)
+                                      .SetShards(4));
+  EXPECT_EQ(3, MutationBatcherTestTraits::NumShards(by_size));
+
+  MutationBatcher no_batches(
+      table_, MutationBatcher::Options().SetMaxBatches(0).SetShards(4));
+  EXPECT_EQ(1, MutationBatcherTestTraits::NumShards(no_batches));
+}
+
+TEST_F(MutationBatcherTest, GroupByTabletSeparatesBatches) {
+  std::vector<SingleRowMutation> mutations(
+      {SingleRowMutation("a", {bt::SetCell("fam", "col", 0_ms, "baz")}),
+       SingleRowMutation("z", {bt::SetCell("fam", "col", 0_ms, "baz")}),
+       SingleRowMutation("b", {bt::SetCell("fam", "col", 0_ms, "baz")})});
+  // Each shard can only have one outstanding batch.
+  batcher_.reset(new MutationBatcher(table_, MutationBatcher::Options()
+                                                 .SetMaxBatches(2)
+                                                 .SetShards(2)
+                                                 .SetGroupByTablet(true)));
+  ExpectSampleRowKeys({"m", ""});
+  MutationBatcherTestTraits::RefreshTabletSplits(*batcher_);
+  EXPECT_THAT(MutationBatcherTestTraits::SplitPoints(*batcher_),
+              ElementsAre("m"));
+
+  // Without `group_by_tablet` all the mutations would use the same shard, and
+  // "z" and "b" would share a batch.
+  ExpectInteraction({Exchange({mutations[0]}, {ResultPiece({0}, {}, {})}),
+                     Exchange({mutations[1]}, {ResultPiece({0}, {}, {})}),
+                     Exchange({mutations[2]}, {ResultPiece({0}, {}, {})})});
+
+  auto state0 = Apply(mutations[0]);
+  EXPECT_TRUE(state0->admitted);
+  EXPECT_EQ(1, NumOperationsOutstanding());
+
+  // The second tablet uses a different shard, its batch is sent right away.
+  auto state1 = Apply(mutations[1]);
+  EXPECT_TRUE(state1->admitted);
+  EXPECT_EQ(2, NumOperationsOutstanding());
+
+  // The first shard is busy, the mutation waits for the next batch.
+  auto state2 = Apply(mutations[2]);
+  EXPECT_TRUE(state2->admitted);
+  EXPECT_EQ(2, NumOperationsOutstanding());
+
+  auto no_more_pending = batcher_->AsyncWaitForNoPendingRequests();
+  FinishSingleItemStream();
+
+  EXPECT_TRUE(state0->completed);
+  EXPECT_TRUE(state1->completed);
+  EXPECT_FALSE(state2->completed);
+  EXPECT_EQ(1, NumOperationsOutstanding());
+
+  FinishSingleItemStream();
+
+  EXPECT_TRUE(state2->completed);
+  EXPECT_EQ(0, NumOperationsOutstanding());
+  EXPECT_EQ(no_more_pending.wait_for(1_ms), std::future_status::ready);
+}
+
+TEST_F(MutationBatcherTest, GroupByTabletRefreshesAfterPeriod) {
+  batcher_.reset(new MutationBatcher(
+      table_, MutationBatcher::Options()
+                  .SetShards(2)
+                  .SetGroupByTablet(true)
+                  .SetRowKeySamplingPeriod(std::chrono::milliseconds(10))));
+  // gmock matches the most recent expectations first.
+  ExpectSampleRowKeys({"c", "m", ""});
+  ExpectSampleRowKeys({"m", ""});
+
+  MutationBatcherTestTraits::RefreshTabletSplits(*batcher_);
+  EXPECT_THAT(MutationBatcherTestTraits::SplitPoints(*batcher_),
+              ElementsAre("m"));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  MutationBatcherTestTraits::RefreshTabletSplits(*batcher_);
+  EXPECT_THAT(MutationBatcherTestTraits::SplitPoints(*batcher_),
+              ElementsAre("c", "m"));
+}
+
+TEST_F(MutationBatcherTest, GroupByTabletNoRefreshBeforePeriod) {
+  batcher_.reset(new MutationBatcher(
+      table_, MutationBatcher::Options().SetShards(2).SetGroupByTablet(true)));
+  // The default period is several minutes, the second refresh is skipped.
+  ExpectSampleRowKeys({"m", ""});
+
+  MutationBatcherTestTraits::RefreshTabletSplits(*batcher_);
+  MutationBatcherTestTraits::RefreshTabletSplits(*batcher_);
+  EXPECT_THAT(MutationBatcherTestTraits::SplitPoints(*batcher_),
+              ElementsAre("m"));
+}
+
+TEST_F(MutationBatcherTest, GroupByTabletKeepsSplitsOnError) {
+  batcher_.reset(new MutationBatcher(
+      table_, MutationBatcher::Options()
+                  .SetShards(2)
+                  .SetGroupByTablet(true)
+                  .SetRowKeySamplingPeriod(std::chrono::milliseconds(10))));
+  ExpectSampleRowKeysFailure();
+  ExpectSampleRowKeys({"m", ""});
+
+  MutationBatcherTestTraits::RefreshTabletSplits(*batcher_);
+  EXPECT_THAT(MutationBatcherTestTraits::SplitPoints(*batcher_),
+              ElementsAre("m"));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  MutationBatcherTestTraits::RefreshTabletSplits(*batcher_);
+  EXPECT_THAT(MutationBatcherTestTraits::SplitPoints(*batcher_),
+              ElementsAre("m"));
+}
+
+TEST_F(MutationBatcherTest, WaitForNoPendingIncludesTabletRefresh) {
+  batcher_.reset(new MutationBatcher(
+      table_, MutationBatcher::Options().SetShards(2).SetGroupByTablet(true)));
+  std::promise<void> unblock;
+  ExpectSampleRowKeys({"m", ""}, unblock.get_future().share());
+
+  MutationBatcherTestTraits::StartTabletSplitsRefresh(*batcher_);
+  auto no_more_pending = batcher_->AsyncWaitForNoPendingRequests();
+  EXPECT_EQ(no_more_pending.wait_for(10_ms), std::future_status::timeout);
+
+  unblock.set_value();
+  EXPECT_EQ(no_more_pending.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  EXPECT_THAT(MutationBatcherTestTraits::SplitPoints(*batcher_),
+              ElementsAre("m"));
+}
+
+TEST_F(MutationBatcherTest, GroupByTabletSingleShard) {
+  std::vector<SingleRowMutation> mutations(
+      {SingleRowMutation("a", {bt::SetCell("fam", "col", 0_ms, "baz")}),
+       SingleRowMutation("z", {bt::SetCell("fam", "col", 0_ms, "baz")}),
+       SingleRowMutation("b", {bt::SetCell("fam", "col", 0_ms, "baz")})});
+  batcher_.reset(new MutationBatcher(
+      table_,
+      MutationBatcher::Options().SetMaxBatches(1).SetGroupByTablet(true)));
+  ExpectSampleRowKeys({"m", ""});
+  MutationBatcherTestTraits::RefreshTabletSplits(*batcher_);
+
+  // Each tablet has its own batch, even with a single shard. Without
+  // `group_by_tablet` "z" and "b" would share a batch.
+  ExpectInteraction({Exchange({mutations[0]}, {ResultPiece({0}, {}, {})}),
+                     Exchange({mutations[1]}, {ResultPiece({0}, {}, {})}),
+                     Exchange({mutations[2]}, {ResultPiece({0}, {}, {})})});
+
+  auto state0 = Apply(mutations[0]);
+  EXPECT_EQ(1, NumOperationsOutstanding());
+  auto state1 = Apply(mutations[1]);
+  auto state2 = Apply(mutations[2]);
+  EXPECT_TRUE(state1->admitted);
+  EXPECT_TRUE(state2->admitted);
+  EXPECT_EQ(1, NumOperationsOutstanding());
+
+  // The oldest batch is sent first.
+  FinishSingleItemStream();
+  EXPECT_TRUE(state0->completed);
+  EXPECT_FALSE(state1->completed);
+  EXPECT_EQ(1, NumOperationsOutstanding());
+
+  FinishSingleItemStream();
+  EXPECT_TRUE(state1->completed);
+  EXPECT_FALSE(state2->completed);
+  EXPECT_EQ(1, NumOperationsOutstanding());
+
+  FinishSingleItemStream();
+  EXPECT_TRUE(state2->completed);
+  EXPECT_EQ(0, NumOperationsOutstanding());
+}
+
 }  // namespace
 }  // namespace BIGTABLE_CLIENT_NS
 }  // namespace bigtable
@@ -0,0 +1,342 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/bigtable/parallel_scan.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace google {
+namespace cloud {
+namespace bigtable {
+inline namespace BIGTABLE_CLIENT_NS {
+
+auto constexpr kDefaultMaxShards = 64;
+auto constexpr kDefaultMaxConcurrentShards = 16;
+auto constexpr kDefaultMaxBufferedRowsPerShard = 64;
+
+namespace {
+void JoinSamplingThread(std::thread thread) {
+  // The sampling thread may satisfy the future returned by `AsyncReadRows()`,
+  // and its continuations may destroy the `ParallelScan`. The thread has no
+  // more work to do in that case.
+  if (thread.get_id() == std::this_thread::get_id()) {
+    thread.detach();
+    return;
+  }
+  thread.join();
+}
+}  // namespace
+
+ParallelScan::Options::Options()
+    : max_shards(kDefaultMaxShards),
+      max_concurrent_shards(kDefaultMaxConcurrentShards),
+      max_buffered_rows_per_shard(kDefaultMaxBufferedRowsPerShard),
+      ordered(false) {}
+
+ParallelScan::~ParallelScan() {
+  std::unique_lock<std::mutex> lk(mu_);
+  auto threads = std::move(sampling_threads_);
+  lk.unlock();
+  for (auto& t : threads) JoinSamplingThread(std::move(t.thread));
+}
+
+future<Status> ParallelScan::AsyncReadRows(
+    CompletionQueue& cq, std::function<future<bool>(Row)> on_row,
+    RowSet row_set, Filter filter) {
+  auto done = std::make_shared<promise<Status>>();
+  auto result = done->get_future();
+  auto finished = std::make_shared<std::atomic<bool>>(false);
+  // There is no asynchronous version of `SampleRows()`. It blocks, including
+  // the backoff between retries, so it must not run in the calling thread,
+  // which may be a `CompletionQueue` thread, nor in the `CompletionQueue`.
+  auto table = table_;
+  auto const options = options_;
+  auto sample = [table, options, cq, on_row, row_set, filter, done,
+                 finished]() mutable {
+    auto samples = table.SampleRows();
+    if (!samples) {
+      *finished = true;
+      done->set_value(std::move(samples).status());
+      return;
+    }
+    auto shards = internal::ShardRowSet(row_set, *samples, options.max_shards);
+    auto reader = [table, cq, filter](
+                      RowSet shard,
+                      internal::ParallelScanState::RowCallback on_shard_row,
+                      internal::ParallelScanState::FinishCallback
+                          on_finish) mutable {
+      table.AsyncReadRows(cq, std::move(on_shard_row), std::move(on_finish),
+                          std::move(shard), filter);
+    };
+    auto state = internal::ParallelScanState::Create(
+        std::move(shards), std::move(reader), std::move(on_row),
+        options.max_concurrent_shards, options.max_buffered_rows_per_shard,
+        options.ordered);
+    *finished = true;
+    state->Start().then(
+        [done](future<Status> f) { done->set_value(f.get()); });
+  };
+
+  std::unique_lock<std::mutex> lk(mu_);
+  // Reclaim the threads of previous calls.
+  std::vector<SamplingThread> finished_threads;
+  auto running = std::partition(
+      sampling_threads_.begin(), sampling_threads_.end(),
+      [](SamplingThread const& t) { return !t.done->load(); });
+  std::move(running, sampling_threads_.end(),
+            std::back_inserter(finished_threads));
+  sampling_threads_.erase(running, sampling_threads_.end());
+  sampling_threads_.push_back(
+      SamplingThread{std::thread(std::move(sample)), std::move(finished)});
+  lk.unlock();
+  for (auto& t : finished_threads) JoinSamplingThread(std::move(t.thread));
+  return result;
+}
+
+namespace internal {
+
+std::vector<RowSet> ShardRowSet(RowSet const& row_set,
+                                std::vector<RowKeySample> const& samples,
+                                std::size_t max_shards) {
+  if (row_set.IsEmpty()) return {};
+  max_shards = (std::max<std::size_t>)(max_shards, 1);
+
+  // Sample `i` covers the keys from `samples[i - 1].row_key` (inclusive) to
+  // `samples[i].row_key` (exclusive), the empty row key represents the end of
+  // the table. Only the samples from the first to the last one containing rows
+  // in `row_set` are used to compute the splits.
+  auto first = samples.size();
+  auto last = samples.size();
+  RowKeyType previous;
+  for (std::size_t i = 0; i != samples.size(); ++i) {
+    auto const& key = samples[i].row_key;
+    if (!row_set.Intersect(RowRange::RightOpen(previous, key)).IsEmpty()) {
+      if (first == samples.size()) first = i;
+      last = i;
+    }
+    if (internal::IsEmptyRowKey(key)) break;
+    previous = key;
+  }
+
+  // The offsets are cumulative, split whenever the next multiple of
+  // `total / max_shards` bytes within the span is reached.
+  std::vector<RowKeyType> splits;
+  if (first != samples.size()) {
+    auto const base =
+        first == 0 ? std::int64_t{0} : samples[first - 1].offset_bytes;
+    auto const total = samples[last].offset_bytes - base;
+    for (auto i = first; i != last; ++i) {
+      auto const& sample = samples[i];
+      if (splits.size() + 1 >= max_shards) break;
+      if (!splits.empty() &&
+          CompareRowKey(splits.back(), sample.row_key) >= 0) {
+        continue;
+      }
+      auto const threshold = static_cast<std::int64_t>(
+          static_cast<double>(total) * static_cast<double>(splits.size() + 1) /
+          static_cast<double>(max_shards));
+      if (sample.offset_bytes - base < threshold) continue;
+      splits.push_back(sample.row_key);
+    }
+  }
+
+  std::vector<RowSet> shards;
+  RowKeyType start;
+  for (auto& split : splits) {
+    auto shard = row_set.Intersect(RowRange::RightOpen(start, split));
+    if (!shard.IsEmpty()) shards.push_back(std::move(shard));
+    start = std::move(split);
+  }
+  auto tail = row_set.Intersect(RowRange::StartingAt(std::move(start)));
+  if (!tail.IsEmpty()) shards.push_back(std::move(tail));
+  return shards;
+}
+
+ParallelScanState::ParallelScanState(std::vector<RowSet> shards,
+                                     ShardReader reader, RowCallback on_row,
+                                     std::size_t max_concurrent_shards,
+                                     std::size_t max_buffered_rows,
+                                     bool ordered)
+    : shards_(shards.size()),
+      reader_(std::move(reader)),
+      on_row_(std::move(on_row)),
+      max_concurrent_shards_((std::max<std::size_t>)(max_concurrent_shards, 1)),
+      max_buffered_rows_((std::max<std::size_t>)(max_buffered_rows, 1)),
+      ordered_(ordered) {
+  for (std::size_t i = 0; i != shards.size(); ++i) {
+    shards_[i].row_set = std::move(shards[i]);
+  }
+}
+
+future<Status> ParallelScanState::Start() {
+  auto result = done_.get_future();
+  std::unique_lock<std::mutex> lk(mu_);
+  auto start = ShardsToStartLocked();
+  // With no shards this satisfies `result` immediately.
+  Dispatch(std::move(lk));
+  Launch(start);
+  return result;
+}
+
+future<bool> ParallelScanState::OnRow(std::size_t index, Row row) {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (stopped_) return make_ready_future(false);
+  auto& shard = shards_[index];
+  shard.rows.push_back(std::move(row));
+  if (shard.rows.size() < max_buffered_rows_) {
+    Dispatch(std::move(lk));
+    // The application may have stopped the scan while processing the row.
+    std::lock_guard<std::mutex> guard(mu_);
+    return make_ready_future(!stopped_);
+  }
+  shard.waiting = true;
+  shard.resume = promise<bool>();
+  auto result = shard.resume.get_future();
+  Dispatch(std::move(lk));
+  return result;
+}
+
+void ParallelScanState::OnFinish(std::size_t index, Status status) {
+  std::unique_lock<std::mutex> lk(mu_);
+  shards_[index].done = true;
+  --running_;
+  // Errors after the scan stopped are the result of stopping it.
+  std::vector<promise<bool>> waiting;
+  if (!status.ok() && !stopped_) {
+    status_ = std::move(status);
+    waiting = StopLocked();
+  }
+  auto start = ShardsToStartLocked();
+  lk.unlock();
+  for (auto& p : waiting) p.set_value(false);
+  lk.lock();
+  Dispatch(std::move(lk));
+  Launch(start);
+}
+
+void ParallelScanState::OnDelivered(bool keep_reading) {
+  std::unique_lock<std::mutex> lk(mu_);
+  delivering_ = false;
+  std::vector<promise<bool>> waiting;
+  if (!keep_reading && !stopped_) waiting = StopLocked();
+  lk.unlock();
+  for (auto& p : waiting) p.set_value(false);
+  lk.lock();
+  Dispatch(std::move(lk));
+}
+
+void ParallelScanState::Dispatch(std::unique_lock<std::mutex> lk) {
+  while (!delivering_ && !stopped_) {
+    auto const index = NextReadyLocked();
+    if (index == shards_.size()) break;
+    delivering_ = true;
+    auto& shard = shards_[index];
+    auto row = std::move(shard.rows.front());
+    shard.rows.pop_front();
+    // There is room in the buffer now, let the shard continue.
+    optional<promise<bool>> resume;
+    if (shard.waiting) {
+      shard.waiting = false;
+      resume.emplace(std::move(shard.resume));
+    }
+    lk.unlock();
+    if (resume) resume->set_value(true);
+
+    auto delivered = on_row_(std::move(row));
+    if (!delivered.is_ready()) {
+      auto self = shared_from_this();
+      delivered.then([self](future<bool> f) { self->OnDelivered(f.get()); });
+      return;
+    }
+    // Loop instead of recursing when the callback completes inline.
+    bool const keep_reading = delivered.get();
+    lk.lock();
+    delivering_ = false;
+    if (!keep_reading && !stopped_) {
+      auto waiting = StopLocked();
+      lk.unlock();
+      for (auto& p : waiting) p.set_value(false);
+      lk.lock();
+    }
+  }
+  MaybeFinish(std::move(lk));
+}
+
+void ParallelScanState::MaybeFinish(std::unique_lock<std::mutex> lk) {
+  if (finished_ || delivering_ || running_ != 0) return;
+  if (!stopped_ && next_shard_ != shards_.size()) return;
+  finished_ = true;
+  auto status = status_;
+  lk.unlock();
+  done_.set_value(std::move(status));
+}
+
+void ParallelScanState::Launch(std::vector<std::size_t> const& indexes) {
+  auto self = shared_from_this();
+  for (auto index : indexes) {
+    reader_(
+        shards_[index].row_set,
+        [self, index](Row row) { return self->OnRow(index, std::move(row)); },
+        [self, index](Status status) {
+          self->OnFinish(index, std::move(status));
+        });
+  }
+}
+
+std::vector<std::size_t> ParallelScanState::ShardsToStartLocked() {
+  std::vector<std::size_t> indexes;
+  while (!stopped_ && next_shard_ != shards_.size() &&
+         running_ < max_concurrent_shards_) {
+    indexes.push_back(next_shard_++);
+    ++running_;
+  }
+  return indexes;
+}
+
+std::size_t ParallelScanState::NextReadyLocked() {
+  auto const n = shards_.size();
+  if (ordered_) {
+    while (head_ != n && shards_[head_].done && shards_[head_].rows.empty()) {
+      ++head_;
+    }
+    if (head_ != n && !shards_[head_].rows.empty()) return head_;
+    return n;
+  }
+  for (std::size_t i = 0; i != n; ++i) {
+    auto const index = (head_ + i) % n;
+    if (shards_[index].rows.empty()) continue;
+    head_ = (index + 1) % n;
+    return index;
+  }
+  return n;
+}
+
+std::vector<promise<bool>> ParallelScanState::StopLocked() {
+  stopped_ = true;
+  std::vector<promise<bool>> waiting;
+  for (auto& shard : shards_) {
+    shard.rows.clear();
+    if (!shard.waiting) continue;
+    shard.waiting = false;
+    waiting.push_back(std::move(shard.resume));
+  }
+  return waiting;
+}
+
+}  // namespace internal
+}  // namespace BIGTABLE_CLIENT_NS
+}  // namespace bigtable
+}  // namespace cloud
+}  // namespace google
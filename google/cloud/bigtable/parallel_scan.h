@@ -0,0 +1,240 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_PARALLEL_SCAN_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_PARALLEL_SCAN_H
+
+#include "google/cloud/bigtable/completion_queue.h"
+#include "google/cloud/bigtable/filters.h"
+#include "google/cloud/bigtable/row.h"
+#include "google/cloud/bigtable/row_key_sample.h"
+#include "google/cloud/bigtable/row_set.h"
+#include "google/cloud/bigtable/table.h"
+#include "google/cloud/bigtable/version.h"
+#include "google/cloud/future.h"
+#include "google/cloud/optional.h"
+#include "google/cloud/status.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace bigtable {
+inline namespace BIGTABLE_CLIENT_NS {
+/**
+ * Reads a large set of rows using multiple concurrent streams.
+ *
+ * `Table::ReadRows()` and `Table::AsyncReadRows()` read all the rows over a
+ * single streaming RPC, and their throughput is limited by that stream.
+ * Objects of this class use `Table::SampleRows()` to split the rows into
+ * shards of similar size, and read the shards concurrently using
+ * `Table::AsyncReadRows()`. Each shard is retried, and resumes after the last
+ * row received, using the retry and backoff policies of the `Table`.
+ *
+ * The rows can be delivered in row key order, or in the order they are
+ * received. In both cases the application callback is invoked for one row at
+ * a time.
+ *
+ * Applications must provide a `CompletionQueue` to (asynchronously) execute
+ * these operations. The application is responsible of executing the
+ * `CompletionQueue` event loop in one or more threads.
+ */
+class ParallelScan {
+ public:
+  /// Configuration for `ParallelScan`.
+  struct Options {
+    Options();
+
+    /// The rows are split in at most this many shards.
+    Options& SetMaxShards(std::size_t max_shards_arg) {
+      max_shards = max_shards_arg;
+      return *this;
+    }
+
+    /// There will be no more streams open than this.
+    Options& SetMaxConcurrentShards(std::size_t max_concurrent_shards_arg) {
+      max_concurrent_shards = max_concurrent_shards_arg;
+      return *this;
+    }
+
+    /// Each shard buffers at most this many rows waiting for delivery.
+    Options& SetMaxBufferedRowsPerShard(std::size_t max_buffered_rows_arg) {
+      max_buffered_rows_per_shard = max_buffered_rows_arg;
+      return *this;
+    }
+
+    /// If true, the rows are delivered in row key order.
+    Options& SetOrdered(bool ordered_arg) {
+      ordered = ordered_arg;
+      return *this;
+    }
+
+    std::size_t max_shards;
+    std::size_t max_concurrent_shards;
+    std::size_t max_buffered_rows_per_shard;
+    bool ordered;
+  };
+
+  explicit ParallelScan(Table table, Options options = Options())
+      : table_(std::move(table)), options_(options) {}
+
+  /// Waits for any calls to `Table::SampleRows()` started by this object.
+  ~ParallelScan();
+
+  ParallelScan(ParallelScan const&) = delete;
+  ParallelScan& operator=(ParallelScan const&) = delete;
+
+  /**
+   * Asynchronously reads a set of rows from the table using multiple streams.
+   *
+   * @param cq the completion queue that will execute the asynchronous calls,
+   *     the application must ensure that one or more threads are blocked on
+   *     `cq.Run()`.
+   * @param on_row the callback to be invoked on each successfully read row;
+   *     the returned `future<bool>` should be satisfied with `true` when the
+   *     application is ready to receive the next row and with `false` to stop
+   *     the scan. The callback is never invoked concurrently with itself.
+   * @param row_set the rows to read from.
+   * @param filter is applied on the server-side to data in the rows.
+   *
+   * @return a future satisfied when all the shards are finished, or when the
+   *     scan stopped because a shard failed, in which case it contains the
+   *     error. If the application stopped the scan the status is OK.
+   *
+   * @note The shards are computed with `Table::SampleRows()`, which is a
+   *     blocking call. It runs in a separate thread, owned by this object,
+   *     and never in the calling thread or in the threads of the
+   *     `CompletionQueue`. The destructor waits for any such thread.
+   */
+  future<Status> AsyncReadRows(CompletionQueue& cq,
+                               std::function<future<bool>(Row)> on_row,
+                               RowSet row_set, Filter filter);
+
+ private:
+  /// A thread calling `Table::SampleRows()`, and whether it has finished.
+  struct SamplingThread {
+    std::thread thread;
+    std::shared_ptr<std::atomic<bool>> done;
+  };
+
+  Table table_;
+  Options options_;
+  std::mutex mu_;
+  std::vector<SamplingThread> sampling_threads_;
+};
+
+namespace internal {
+/**
+ * Splits @p row_set at the boundaries in @p samples.
+ *
+ * Only the samples that overlap the key span of @p row_set are used. They are
+ * combined so that the shards have a similar number of bytes of that span, and
+ * there are at most @p max_shards shards. Shards that do not contain any rows
+ * are omitted, the shards are returned in row key order.
+ */
+std::vector<RowSet> ShardRowSet(RowSet const& row_set,
+                                std::vector<RowKeySample> const& samples,
+                                std::size_t max_shards);
+
+/**
+ * Reads a number of shards concurrently and delivers their rows one at a time.
+ *
+ * The shards are read with a `ShardReader`, which must invoke its callbacks
+ * as `Table::AsyncReadRows()` does. Separated from `ParallelScan` for
+ * testability.
+ */
+class ParallelScanState
+    : public std::enable_shared_from_this<ParallelScanState> {
+ public:
+  using RowCallback = std::function<future<bool>(Row)>;
+  using FinishCallback = std::function<void(Status)>;
+  using ShardReader = std::function<void(RowSet, RowCallback, FinishCallback)>;
+
+  static std::shared_ptr<ParallelScanState> Create(
+      std::vector<RowSet> shards, ShardReader reader, RowCallback on_row,
+      std::size_t max_concurrent_shards, std::size_t max_buffered_rows,
+      bool ordered) {
+    return std::shared_ptr<ParallelScanState>(new ParallelScanState(
+        std::move(shards), std::move(reader), std::move(on_row),
+        max_concurrent_shards, max_buffered_rows, ordered));
+  }
+
+  /// Starts reading the shards, the future is satisfied when the scan ends.
+  future<Status> Start();
+
+ private:
+  ParallelScanState(std::vector<RowSet> shards, ShardReader reader,
+                    RowCallback on_row, std::size_t max_concurrent_shards,
+                    std::size_t max_buffered_rows, bool ordered);
+
+  struct Shard {
+    RowSet row_set;
+    /// Rows received and not yet delivered.
+    std::deque<Row> rows;
+    /// If true, the shard reader waits on `resume` for buffer space.
+    bool waiting = false;
+    promise<bool> resume;
+    bool done = false;
+  };
+
+  future<bool> OnRow(std::size_t index, Row row);
+  void OnFinish(std::size_t index, Status status);
+  void OnDelivered(bool keep_reading);
+
+  /// Delivers rows until the application callback does not complete inline.
+  void Dispatch(std::unique_lock<std::mutex> lk);
+  /// Satisfies the future returned by Start() if there is no more work.
+  void MaybeFinish(std::unique_lock<std::mutex> lk);
+  /// Starts the shards in @p indexes.
+  void Launch(std::vector<std::size_t> const& indexes);
+
+  /// Marks the shards to start, without exceeding the concurrency limit.
+  std::vector<std::size_t> ShardsToStartLocked();
+  /// Returns the shard with the next row to deliver, or `shards_.size()`.
+  std::size_t NextReadyLocked();
+  /// Stops the scan, returns the promises of the shards waiting for space.
+  std::vector<promise<bool>> StopLocked();
+
+  std::mutex mu_;
+  std::vector<Shard> shards_;
+  ShardReader reader_;
+  RowCallback on_row_;
+  std::size_t const max_concurrent_shards_;
+  std::size_t const max_buffered_rows_;
+  bool const ordered_;
+
+  std::size_t next_shard_ = 0;
+  std::size_t running_ = 0;
+  // In ordered mode, the shard delivering rows. In unordered mode, the shard
+  // checked first for rows, the shards take turns.
+  std::size_t head_ = 0;
+  bool delivering_ = false;
+  bool stopped_ = false;
+  bool finished_ = false;
+  Status status_;
+  promise<Status> done_;
+};
+}  // namespace internal
+
+}  // namespace BIGTABLE_CLIENT_NS
+}  // namespace bigtable
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_PARALLEL_SCAN_H
@@ -0,0 +1,283 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/bigtable/parallel_scan.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <deque>
+
+namespace google {
+namespace cloud {
+namespace bigtable {
+inline namespace BIGTABLE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+RowKeySample MakeSample(std::string key, std::int64_t offset) {
+  RowKeySample sample;
+  sample.row_key = std::move(key);
+  sample.offset_bytes = offset;
+  return sample;
+}
+
+TEST(ShardRowSetTest, SplitsAtSamples) {
+  auto shards = ShardRowSet(
+      RowSet(), {MakeSample("c", 10), MakeSample("m", 20), MakeSample("", 30)},
+      10);
+  ASSERT_EQ(3U, shards.size());
+  auto p0 = shards[0].as_proto();
+  ASSERT_EQ(1, p0.row_ranges_size());
+  EXPECT_EQ("", p0.row_ranges(0).start_key_closed());
+  EXPECT_EQ("c", p0.row_ranges(0).end_key_open());
+  auto p1 = shards[1].as_proto();
+  ASSERT_EQ(1, p1.row_ranges_size());
+  EXPECT_EQ("c", p1.row_ranges(0).start_key_closed());
+  EXPECT_EQ("m", p1.row_ranges(0).end_key_open());
+  auto p2 = shards[2].as_proto();
+  ASSERT_EQ(1, p2.row_ranges_size());
+  EXPECT_EQ("m", p2.row_ranges(0).start_key_closed());
+  EXPECT_EQ("", p2.row_ranges(0).end_key_open());
+}
+
+TEST(ShardRowSetTest, BalancesShards) {
+  // Most of the data is in the first sample range, the small ranges after it
+  // are combined.
+  auto shards = ShardRowSet(RowSet(),
+                            {MakeSample("b", 50), MakeSample("c", 60),
+                             MakeSample("d", 70), MakeSample("e", 80),
+                             MakeSample("f", 90), MakeSample("", 100)},
+                            2);
+  ASSERT_EQ(2U, shards.size());
+  auto p0 = shards[0].as_proto();
+  ASSERT_EQ(1, p0.row_ranges_size());
+  EXPECT_EQ("b", p0.row_ranges(0).end_key_open());
+  auto p1 = shards[1].as_proto();
+  ASSERT_EQ(1, p1.row_ranges_size());
+  EXPECT_EQ("b", p1.row_ranges(0).start_key_closed());
+  EXPECT_EQ("", p1.row_ranges(0).end_key_open());
+}
+
+TEST(ShardRowSetTest, IntersectsRowSet) {
+  RowSet row_set(RowRange::Range("a", "d"), "x");
+  auto shards = ShardRowSet(row_set,
+                            {MakeSample("c", 10), MakeSample("m", 20),
+                             MakeSample("p", 25), MakeSample("", 30)},
+                            10);
+  // The [m, p) shard contains no rows and is omitted.
+  ASSERT_EQ(3U, shards.size());
+  auto p0 = shards[0].as_proto();
+  ASSERT_EQ(1, p0.row_ranges_size());
+  EXPECT_EQ("a", p0.row_ranges(0).start_key_closed());
+  EXPECT_EQ("c", p0.row_ranges(0).end_key_open());
+  auto p1 = shards[1].as_proto();
+  ASSERT_EQ(1, p1.row_ranges_size());
+  EXPECT_EQ("c", p1.row_ranges(0).start_key_closed());
+  EXPECT_EQ("d", p1.row_ranges(0).end_key_open());
+  auto p2 = shards[2].as_proto();
+  EXPECT_EQ(0, p2.row_ranges_size());
+  ASSERT_EQ(1, p2.row_keys_size());
+  EXPECT_EQ("x", p2.row_keys(0));
+}
+
+TEST(ShardRowSetTest, NarrowRangeInLargeTable) {
+  std::vector<RowKeySample> samples;
+  for (char c = 'a'; c <= 'z'; ++c) {
+    samples.push_back(MakeSample(std::string(1, c), 10 * (c - 'a' + 1)));
+  }
+  samples.push_back(MakeSample("", 270));
+  // Only the samples inside [m, q) are used, and they are split evenly.
+  auto shards = ShardRowSet(RowSet(RowRange::RightOpen("m", "q")), samples, 4);
+  ASSERT_EQ(4U, shards.size());
+  std::vector<std::pair<std::string, std::string>> actual;
+  for (auto const& shard : shards) {
+    auto proto = shard.as_proto();
+    ASSERT_EQ(1, proto.row_ranges_size());
+    actual.emplace_back(proto.row_ranges(0).start_key_closed(),
+                        proto.row_ranges(0).end_key_open());
+  }
+  EXPECT_THAT(actual, ElementsAre(Pair("m", "n"), Pair("n", "o"),
+                                  Pair("o", "p"), Pair("p", "q")));
+}
+
+TEST(ShardRowSetTest, NoSamples) {
+  auto shards = ShardRowSet(RowSet(), {}, 10);
+  ASSERT_EQ(1U, shards.size());
+  EXPECT_FALSE(shards[0].IsEmpty());
+}
+
+TEST(ShardRowSetTest, EmptyRowSet) {
+  auto shards = ShardRowSet(RowSet(RowRange::Empty()),
+                            {MakeSample("c", 10), MakeSample("", 20)}, 10);
+  EXPECT_TRUE(shards.empty());
+}
+
+/// Records the shards started by `ParallelScanState`.
+struct FakeShard {
+  ParallelScanState::RowCallback on_row;
+  ParallelScanState::FinishCallback on_finish;
+};
+
+class ParallelScanStateTest : public ::testing::Test {
+ protected:
+  std::shared_ptr<ParallelScanState> MakeState(
+      std::size_t shard_count, std::size_t max_concurrent,
+      std::size_t max_buffered, bool ordered,
+      ParallelScanState::RowCallback on_row) {
+    auto reader = [this](RowSet, ParallelScanState::RowCallback r,
+                         ParallelScanState::FinishCallback f) {
+      started_.push_back(FakeShard{std::move(r), std::move(f)});
+    };
+    return ParallelScanState::Create(std::vector<RowSet>(shard_count),
+                                     std::move(reader), std::move(on_row),
+                                     max_concurrent, max_buffered, ordered);
+  }
+
+  /// An `on_row` callback that records the keys and accepts all rows.
+  ParallelScanState::RowCallback RecordKeys() {
+    return [this](Row row) {
+      keys_.push_back(row.row_key());
+      return make_ready_future(true);
+    };
+  }
+
+  static Row MakeRow(std::string key) {
+    return Row(std::move(key), std::vector<Cell>{});
+  }
+
+  std::deque<FakeShard> started_;
+  std::vector<std::string> keys_;
+};
+
+TEST_F(ParallelScanStateTest, NoShards) {
+  auto done = MakeState(0, 4, 4, false, RecordKeys())->Start();
+  ASSERT_TRUE(done.is_ready());
+  EXPECT_STATUS_OK(done.get());
+  EXPECT_TRUE(started_.empty());
+}
+
+TEST_F(ParallelScanStateTest, Unordered) {
+  auto done = MakeState(2, 4, 4, false, RecordKeys())->Start();
+  ASSERT_EQ(2U, started_.size());
+  EXPECT_TRUE(started_[1].on_row(MakeRow("b1")).get());
+  EXPECT_TRUE(started_[0].on_row(MakeRow("a1")).get());
+  EXPECT_TRUE(started_[1].on_row(MakeRow("b2")).get());
+  started_[0].on_finish(Status());
+  EXPECT_FALSE(done.is_ready());
+  started_[1].on_finish(Status());
+  ASSERT_TRUE(done.is_ready());
+  EXPECT_STATUS_OK(done.get());
+  EXPECT_THAT(keys_, ElementsAre("b1", "a1", "b2"));
+}
+
+TEST_F(ParallelScanStateTest, Ordered) {
+  auto done = MakeState(2, 4, 4, true, RecordKeys())->Start();
+  ASSERT_EQ(2U, started_.size());
+  EXPECT_TRUE(started_[1].on_row(MakeRow("b1")).get());
+  EXPECT_TRUE(keys_.empty());
+  EXPECT_TRUE(started_[0].on_row(MakeRow("a1")).get());
+  EXPECT_THAT(keys_, ElementsAre("a1"));
+  started_[0].on_finish(Status());
+  EXPECT_THAT(keys_, ElementsAre("a1", "b1"));
+  started_[1].on_finish(Status());
+  ASSERT_TRUE(done.is_ready());
+  EXPECT_STATUS_OK(done.get());
+}
+
+TEST_F(ParallelScanStateTest, ConcurrencyLimit) {
+  auto done = MakeState(3, 2, 4, false, RecordKeys())->Start();
+  ASSERT_EQ(2U, started_.size());
+  started_[0].on_finish(Status());
+  ASSERT_EQ(3U, started_.size());
+  started_[1].on_finish(Status());
+  EXPECT_FALSE(done.is_ready());
+  started_[2].on_finish(Status());
+  ASSERT_TRUE(done.is_ready());
+  EXPECT_STATUS_OK(done.get());
+}
+
+TEST_F(ParallelScanStateTest, FlowControl) {
+  std::deque<promise<bool>> pending;
+  auto on_row = [this, &pending](Row row) {
+    keys_.push_back(row.row_key());
+    pending.emplace_back();
+    return pending.back().get_future();
+  };
+  auto done = MakeState(1, 1, 1, false, on_row)->Start();
+  ASSERT_EQ(1U, started_.size());
+
+  // The first row is delivered right away, so there is room in the buffer.
+  auto f1 = started_[0].on_row(MakeRow("r1"));
+  EXPECT_TRUE(f1.is_ready());
+  // The application has not finished with "r1", so "r2" fills the buffer.
+  auto f2 = started_[0].on_row(MakeRow("r2"));
+  EXPECT_FALSE(f2.is_ready());
+  EXPECT_THAT(keys_, ElementsAre("r1"));
+
+  pending.front().set_value(true);
+  EXPECT_TRUE(f2.is_ready());
+  EXPECT_TRUE(f2.get());
+  EXPECT_THAT(keys_, ElementsAre("r1", "r2"));
+
+  started_[0].on_finish(Status());
+  EXPECT_FALSE(done.is_ready());
+  pending.back().set_value(true);
+  ASSERT_TRUE(done.is_ready());
+  EXPECT_STATUS_OK(done.get());
+}
+
+TEST_F(ParallelScanStateTest, ApplicationStops) {
+  auto on_row = [this](Row row) {
+    keys_.push_back(row.row_key());
+    return make_ready_future(false);
+  };
+  auto done = MakeState(3, 2, 4, false, on_row)->Start();
+  ASSERT_EQ(2U, started_.size());
+  EXPECT_FALSE(started_[0].on_row(MakeRow("a1")).get());
+  EXPECT_FALSE(started_[1].on_row(MakeRow("b1")).get());
+  started_[0].on_finish(Status(StatusCode::kCancelled, "cancelled"));
+  started_[1].on_finish(Status(StatusCode::kCancelled, "cancelled"));
+  // No more shards are started once the scan stops.
+  EXPECT_EQ(2U, started_.size());
+  ASSERT_TRUE(done.is_ready());
+  EXPECT_STATUS_OK(done.get());
+  EXPECT_THAT(keys_, ElementsAre("a1"));
+}
+
+TEST_F(ParallelScanStateTest, ShardErrorStopsScan) {
+  auto done = MakeState(3, 2, 1, true, RecordKeys())->Start();
+  ASSERT_EQ(2U, started_.size());
+  // The second shard waits for the first one.
+  auto waiting = started_[1].on_row(MakeRow("b1"));
+  EXPECT_FALSE(waiting.is_ready());
+
+  started_[0].on_finish(Status(StatusCode::kUnavailable, "try-again"));
+  ASSERT_TRUE(waiting.is_ready());
+  EXPECT_FALSE(waiting.get());
+  EXPECT_FALSE(done.is_ready());
+  started_[1].on_finish(Status(StatusCode::kCancelled, "cancelled"));
+  EXPECT_EQ(2U, started_.size());
+  ASSERT_TRUE(done.is_ready());
+  EXPECT_EQ(StatusCode::kUnavailable, done.get().code());
+  EXPECT_TRUE(keys_.empty());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace BIGTABLE_CLIENT_NS
+}  // namespace bigtable
+}  // namespace cloud
+}  // namespace google
@@ -91,6 +91,7 @@ RowReader::RowReader(
       parser_factory_(std::move(parser_factory)),
       stream_is_open_(false),
       operation_cancelled_(false),
+      compact_rows_(false),
       processed_chunks_count_(0),
       rows_count_(0) {}
 
@@ -128,7 +129,8 @@ void RowReader::MakeRequest() {
   stream_ = client_->ReadRows(context_.get(), request);
   stream_is_open_ = true;
 
-  parser_ = parser_factory_->Create();
+  parser_ = compact_rows_ ? parser_factory_->CreateCompact()
+                         : parser_factory_->Create();
 }
 
 bool RowReader::NextChunk() {
@@ -145,11 +147,25 @@ bool RowReader::NextChunk() {
 }
 
 StatusOr<internal::OptionalRow> RowReader::Advance() {
+  return AdvanceImpl<Row>();
+}
+
+StatusOr<optional<CompactRow>> RowReader::NextCompact() {
+  if (stream_ && !compact_rows_) {
+    return Status(StatusCode::kFailedPrecondition,
+                  "NextCompact() cannot be used after the iterators");
+  }
+  compact_rows_ = true;
+  return AdvanceImpl<CompactRow>();
+}
+
+template <typename RowType>
+StatusOr<optional<RowType>> RowReader::AdvanceImpl() {
   if (operation_cancelled_) {
     return Status(StatusCode::kCancelled, "Operation cancelled.");
   }
   while (true) {
-    internal::OptionalRow row;
+    optional<RowType> row;
     grpc::Status status = AdvanceOrFail(row);
     if (status.ok()) {
       return row;
@@ -187,7 +203,8 @@ StatusOr<internal::OptionalRow> RowReader::Advance() {
   }
 }
 
-grpc::Status RowReader::AdvanceOrFail(internal::OptionalRow& row) {
+template <typename RowType>
+grpc::Status RowReader::AdvanceOrFail(optional<RowType>& row) {
   row.reset();
   grpc::Status status;
   if (!stream_) {
@@ -217,17 +234,25 @@ grpc::Status RowReader::AdvanceOrFail(internal::OptionalRow& row) {
   }
 
   // We have a complete row in the parser.
-  Row parsed_row = parser_->Next(status);
+  TakeRow(row, status);
   if (!status.ok()) {
+    row.reset();
     return status;
   }
-  row.emplace(std::move(parsed_row));
   ++rows_count_;
   last_read_row_key_ = std::string(row.value().row_key());
 
   return status;
 }
 
+void RowReader::TakeRow(optional<Row>& row, grpc::Status& status) {
+  row.emplace(parser_->Next(status));
+}
+
+void RowReader::TakeRow(optional<CompactRow>& row, grpc::Status& status) {
+  row.emplace(parser_->NextCompact(status));
+}
+
 void RowReader::Cancel() {
   operation_cancelled_ = true;
   if (!stream_is_open_) {
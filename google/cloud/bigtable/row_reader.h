@@ -15,6 +15,7 @@
 #ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_ROW_READER_H
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_BIGTABLE_ROW_READER_H
 
+#include "google/cloud/bigtable/compact_row.h"
 #include "google/cloud/bigtable/data_client.h"
 #include "google/cloud/bigtable/filters.h"
 #include "google/cloud/bigtable/internal/readrowsparser.h"
@@ -25,6 +26,7 @@
 #include "google/cloud/bigtable/rpc_backoff_policy.h"
 #include "google/cloud/bigtable/rpc_retry_policy.h"
 #include "google/cloud/bigtable/version.h"
+#include "google/cloud/optional.h"
 #include <google/bigtable/v2/bigtable.grpc.pb.h>
 #include <grpcpp/grpcpp.h>
 #include <cinttypes>
@@ -91,6 +93,23 @@ class RowReader {
   /// End iterator over the rows in the response.
   iterator end();
 
+  /**
+   * Read the next row in the response, using the `CompactRow` representation.
+   *
+   * `CompactRow` stores the row key and column family names once per row, and
+   * packs the qualifiers and values in a single buffer. Full table scans over
+   * wide rows allocate far less memory with this function than with the
+   * iterators.
+   *
+   * Returns an unset `optional<>` when there are no more rows. Retry and
+   * backoff policies are honored.
+   *
+   * Use either this function or the iterators to consume the rows, calling
+   * this function after the iterators have started reading returns a
+   * `kFailedPrecondition` error.
+   */
+  StatusOr<optional<CompactRow>> NextCompact();
+
   /**
    * Gracefully terminate a streaming read.
    *
@@ -109,8 +128,19 @@ class RowReader {
    */
   StatusOr<internal::OptionalRow> Advance();
 
-  /// Called by Advance(), does not handle retries.
-  grpc::Status AdvanceOrFail(internal::OptionalRow& row);
+  /// Implements Advance() and NextCompact().
+  template <typename RowType>
+  StatusOr<optional<RowType>> AdvanceImpl();
+
+  /// Called by AdvanceImpl(), does not handle retries.
+  template <typename RowType>
+  grpc::Status AdvanceOrFail(optional<RowType>& row);
+
+  //@{
+  /// Take the next row from the parser, in the requested representation.
+  void TakeRow(optional<Row>& row, grpc::Status& status);
+  void TakeRow(optional<CompactRow>& row, grpc::Status& status);
+  //@}
 
   /**
    * Move the `processed_chunks_count_` index to the next chunk,
@@ -147,6 +177,8 @@ class RowReader {
       stream_;
   bool stream_is_open_;
   bool operation_cancelled_;
+  /// Set by NextCompact(), the parser accumulates `CompactRow`s.
+  bool compact_rows_;
 
   /// The last received response, chunks are being parsed one by one from it.
   google::bigtable::v2::ReadRowsResponse response_;
@@ -809,3 +809,83 @@ TEST_F(RowReaderTest, FailedStreamRetryNewContext) {
   EXPECT_EQ((*it)->row_key(), "r1");
   EXPECT_EQ(++it, reader.end());
 }
+
+TEST_F(RowReaderTest, ReadCompactRows) {
+  google::bigtable::v2::ReadRowsResponse response;
+  auto add_cell = [&response](std::string const& row_key,
+                              std::string const& qualifier, bool commit) {
+    auto& chunk = *response.add_chunks();
+    chunk.set_row_key(row_key);
+    chunk.mutable_family_name()->set_value("fam");
+    chunk.mutable_qualifier()->set_value(qualifier);
+    chunk.set_value("value-" + qualifier);
+    chunk.set_commit_row(commit);
+  };
+  add_cell("r1", "c1", false);
+  add_cell("r1", "c2", true);
+  add_cell("r2", "c1", true);
+
+  // wrapped in unique_ptr by ReadRows
+  auto* stream = new MockReadRowsReader("google.bigtable.v2.Bigtable.ReadRows");
+  {
+    testing::InSequence s;
+    EXPECT_CALL(*client_, ReadRows(_, _))
+        .WillOnce(Invoke(stream->MakeMockReturner()));
+    EXPECT_CALL(*stream, Read(_))
+        .WillOnce(DoAll(SetArgPointee<0>(response), Return(true)));
+    EXPECT_CALL(*stream, Read(_)).WillOnce(Return(false));
+    EXPECT_CALL(*stream, Finish()).WillOnce(Return(grpc::Status::OK));
+  }
+
+  bigtable::RowReader reader(
+      client_, "", bigtable::RowSet(), bigtable::RowReader::NO_ROWS_LIMIT,
+      bigtable::Filter::PassAllFilter(), std::move(retry_policy_),
+      std::move(backoff_policy_), metadata_update_policy_,
+      std::move(parser_factory_));
+
+  auto row = reader.NextCompact();
+  ASSERT_STATUS_OK(row);
+  ASSERT_TRUE(row->has_value());
+  EXPECT_EQ("r1", (*row)->row_key());
+  ASSERT_EQ(2U, (*row)->size());
+  EXPECT_EQ("c2", (*row)->cell(1).column_qualifier());
+  EXPECT_EQ("value-c2", (*row)->cell(1).value());
+
+  row = reader.NextCompact();
+  ASSERT_STATUS_OK(row);
+  ASSERT_TRUE(row->has_value());
+  EXPECT_EQ("r2", (*row)->row_key());
+  ASSERT_EQ(1U, (*row)->size());
+
+  row = reader.NextCompact();
+  ASSERT_STATUS_OK(row);
+  EXPECT_FALSE(row->has_value());
+}
+
+TEST_F(RowReaderTest, NextCompactAfterIteratorsFails) {
+  // wrapped in unique_ptr by ReadRows
+  auto* stream = new MockReadRowsReader("google.bigtable.v2.Bigtable.ReadRows");
+  auto parser = absl::make_unique<ReadRowsParserMock>();
+  parser->SetRows({"r1", "r2"});
+  {
+    testing::InSequence s;
+    EXPECT_CALL(*client_, ReadRows(_, _))
+        .WillOnce(Invoke(stream->MakeMockReturner()));
+    EXPECT_CALL(*stream, Read(_)).WillOnce(Return(false));
+    EXPECT_CALL(*stream, Finish()).WillOnce(Return(grpc::Status::OK));
+  }
+
+  parser_factory_->AddParser(std::move(parser));
+  bigtable::RowReader reader(
+      client_, "", bigtable::RowSet(), bigtable::RowReader::NO_ROWS_LIMIT,
+      bigtable::Filter::PassAllFilter(), std::move(retry_policy_),
+      std::move(backoff_policy_), metadata_update_policy_,
+      std::move(parser_factory_));
+
+  auto it = reader.begin();
+  ASSERT_NE(it, reader.end());
+  ASSERT_STATUS_OK(*it);
+  auto row = reader.NextCompact();
+  EXPECT_EQ(google::cloud::StatusCode::kFailedPrecondition,
+            row.status().code());
+}
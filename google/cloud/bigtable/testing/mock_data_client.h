@@ -29,6 +29,7 @@ class MockDataClient : public bigtable::DataClient {
   MOCK_CONST_METHOD0(instance_id, std::string const&());
   MOCK_METHOD0(Channel, std::shared_ptr<grpc::Channel>());
   MOCK_METHOD0(reset, void());
+  MOCK_METHOD0(mutate_rows_limiter, std::shared_ptr<MutateRowsLimiter>());
 
   MOCK_METHOD3(
       MutateRow,
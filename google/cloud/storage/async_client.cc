@@ -0,0 +1,45 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/async_client.h"
+#include "google/cloud/storage/internal/curl_client.h"
+
+namespace google {
+namespace cloud {
+namespace storage_experimental {
+inline namespace STORAGE_CLIENT_NS {
+
+AsyncClient::AsyncClient(storage::ClientOptions options)
+    : client_(storage::internal::CurlClient::Create(std::move(options))) {}
+
+future<StatusOr<storage::ObjectMetadata>>
+AsyncClient::AsyncGetObjectMetadataImpl(
+    storage::internal::GetObjectMetadataRequest const& request) {
+  return client_->AsyncGetObjectMetadata(request);
+}
+
+future<StatusOr<std::string>> AsyncClient::AsyncReadObjectImpl(
+    storage::internal::ReadObjectRangeRequest const& request) {
+  return client_->AsyncReadObject(request);
+}
+
+future<StatusOr<storage::ObjectMetadata>> AsyncClient::AsyncInsertObjectImpl(
+    storage::internal::InsertObjectMediaRequest const& request) {
+  return client_->AsyncInsertObjectMedia(request);
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage_experimental
+}  // namespace cloud
+}  // namespace google
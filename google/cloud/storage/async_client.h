@@ -0,0 +1,149 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_ASYNC_CLIENT_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_ASYNC_CLIENT_H
+
+#include "google/cloud/storage/client_options.h"
+#include "google/cloud/storage/internal/object_requests.h"
+#include "google/cloud/storage/object_metadata.h"
+#include "google/cloud/storage/version.h"
+#include "google/cloud/future.h"
+#include "google/cloud/status_or.h"
+#include <memory>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+class CurlClient;
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+
+namespace storage_experimental {
+inline namespace STORAGE_CLIENT_NS {
+/**
+ * Asynchronous access to Google Cloud Storage objects.
+ *
+ * This class runs many concurrent operations using a small pool of background
+ * threads. Each thread drives all its transfers using a single `CURLM*`
+ * handle, applications can keep thousands of operations in flight without
+ * dedicating a thread to each one. The size of the pool is controlled by
+ * `storage::ClientOptions::set_background_thread_pool_size()`.
+ *
+ * The futures returned by this class are satisfied in the background threads.
+ * Any continuations attached to them should not block, as they would stall
+ * all the other operations running in the same thread.
+ *
+ * @note Unlike `storage::Client`, these operations do not retry on transient
+ *     failures. Applications should examine the returned `Status` and retry
+ *     if appropriate.
+ *
+ * @warning this is an experimental feature, and subject to change without
+ *     notice.
+ */
+class AsyncClient {
+ public:
+  explicit AsyncClient(storage::ClientOptions options);
+
+  /**
+   * Fetches the object metadata.
+   *
+   * @param bucket_name the name of the bucket that contains the object.
+   * @param object_name the name of the object.
+   * @param options a list of optional query parameters and/or request headers.
+   *     Valid types for this operation include `Generation`,
+   *     `IfGenerationMatch`, `IfGenerationNotMatch`, `IfMetagenerationMatch`,
+   *     `IfMetagenerationNotMatch`, `Projection`, and `UserProject`.
+   */
+  template <typename... Options>
+  future<StatusOr<storage::ObjectMetadata>> AsyncGetObjectMetadata(
+      std::string const& bucket_name, std::string const& object_name,
+      Options&&... options) {
+    storage::internal::GetObjectMetadataRequest request(bucket_name,
+                                                        object_name);
+    request.set_multiple_options(std::forward<Options>(options)...);
+    return AsyncGetObjectMetadataImpl(request);
+  }
+
+  /**
+   * Reads the contents of an object into memory.
+   *
+   * The full contents (or the range selected via `ReadRange`, `ReadFromOffset`
+   * or `ReadLast`) are returned as a single string. Applications downloading
+   * very large objects should use `storage::Client::ReadObject()` instead.
+   *
+   * @param bucket_name the name of the bucket that contains the object.
+   * @param object_name the name of the object to be read.
+   * @param options a list of optional query parameters and/or request headers.
+   *     Valid types for this operation include `DisableCrc32cChecksum`,
+   *     `DisableMD5Hash`, `EncryptionKey`, `Generation`, `IfGenerationMatch`,
+   *     `IfGenerationNotMatch`, `IfMetagenerationMatch`,
+   *     `IfMetagenerationNotMatch`, `ReadFromOffset`, `ReadRange`, `ReadLast`
+   *     and `UserProject`.
+   */
+  template <typename... Options>
+  future<StatusOr<std::string>> AsyncReadObject(std::string const& bucket_name,
+                                                std::string const& object_name,
+                                                Options&&... options) {
+    storage::internal::ReadObjectRangeRequest request(bucket_name,
+                                                      object_name);
+    request.set_multiple_options(std::forward<Options>(options)...);
+    return AsyncReadObjectImpl(request);
+  }
+
+  /**
+   * Creates an object given its name and contents.
+   *
+   * @param bucket_name the name of the bucket that will contain the object.
+   * @param object_name the name of the object to be created.
+   * @param contents the contents (media) for the new object.
+   * @param options a list of optional query parameters and/or request headers.
+   *     Valid types for this operation include `ContentEncoding`,
+   *     `ContentType`, `Crc32cChecksumValue`, `DisableCrc32cChecksum`,
+   *     `DisableMD5Hash`, `EncryptionKey`, `IfGenerationMatch`,
+   *     `IfGenerationNotMatch`, `IfMetagenerationMatch`,
+   *     `IfMetagenerationNotMatch`, `KmsKeyName`, `MD5HashValue`,
+   *     `PredefinedAcl`, `Projection`, `UserProject`, and `WithObjectMetadata`.
+   */
+  template <typename... Options>
+  future<StatusOr<storage::ObjectMetadata>> AsyncInsertObject(
+      std::string const& bucket_name, std::string const& object_name,
+      std::string contents, Options&&... options) {
+    storage::internal::InsertObjectMediaRequest request(
+        bucket_name, object_name, std::move(contents));
+    request.set_multiple_options(std::forward<Options>(options)...);
+    return AsyncInsertObjectImpl(request);
+  }
+
+ private:
+  future<StatusOr<storage::ObjectMetadata>> AsyncGetObjectMetadataImpl(
+      storage::internal::GetObjectMetadataRequest const& request);
+  future<StatusOr<std::string>> AsyncReadObjectImpl(
+      storage::internal::ReadObjectRangeRequest const& request);
+  future<StatusOr<storage::ObjectMetadata>> AsyncInsertObjectImpl(
+      storage::internal::InsertObjectMediaRequest const& request);
+
+  std::shared_ptr<storage::internal::CurlClient> client_;
+};
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage_experimental
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_ASYNC_CLIENT_H
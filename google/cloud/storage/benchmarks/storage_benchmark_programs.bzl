@@ -17,6 +17,7 @@
 """Automatically generated unit tests list - DO NOT EDIT."""
 
 storage_benchmark_programs = [
+    "storage_directory_upload_benchmark.cc",
     "storage_file_transfer_benchmark.cc",
     "storage_latency_benchmark.cc",
     "storage_parallel_uploads_benchmark.cc",
@@ -0,0 +1,322 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/benchmarks/benchmark_utils.h"
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/upload_directory.h"
+#include "google/cloud/internal/build_info.h"
+#include "google/cloud/internal/format_time_point.h"
+#include "google/cloud/internal/getenv.h"
+#include "google/cloud/internal/random.h"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <sys/stat.h>
+#if _WIN32
+#include <direct.h>
+#endif  // _WIN32
+
+namespace {
+namespace gcs = google::cloud::storage;
+namespace gcs_bm = google::cloud::storage_benchmarks;
+
+char const kDescription[] = R"""(
+A throughput benchmark for uploading directories with the Google Cloud Storage
+C++ client library.
+
+This program creates a local directory tree with a prescribed number of files,
+all of the same size, spread over a number of subdirectories. It then
+repeatedly uploads the directory to a new prefix in a GCS bucket using
+`gcs::UploadDirectory()`, and immediately uploads it again to the same prefix.
+The second upload finds all the objects up to date and skips them, so it
+measures the cost of listing and checksumming. The program reports the time
+taken by each operation, the number of files, and the effective bandwidth. The
+program deletes the objects after each iteration.
+
+To perform this benchmark the program creates a new standard bucket, in a region
+configured via the command line. The output of this program is an annotated CSV
+file, that can be analyzed by an external script. The annotation lines start
+with a '#', analysis scripts should skip these lines.
+)""";
+
+struct Options {
+  std::string project_id;
+  std::string region;
+  std::chrono::seconds duration = std::chrono::seconds(60);
+  int file_count = 1000;
+  int directory_count = 10;
+  std::int64_t file_size = 16 * gcs_bm::kKiB;
+  int max_streams = 32;
+};
+
+google::cloud::StatusOr<Options> ParseArgs(int argc, char* argv[]);
+
+void MakeDirectory(std::string const& path) {
+#if _WIN32
+  ::_mkdir(path.c_str());
+#else
+  ::mkdir(path.c_str(), 0700);
+#endif  // _WIN32
+}
+
+void Report(char const* operation, gcs::UploadDirectoryStats const& stats) {
+  auto const ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(stats.elapsed);
+  std::cout << operation << ',' << stats.files_total << ','
+            << stats.files_uploaded << ',' << stats.files_skipped << ','
+            << stats.files_failed << ',' << stats.bytes_uploaded << ','
+            << ms.count() << ',' << stats.BytesPerSecond() / gcs_bm::kMiB
+            << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  google::cloud::StatusOr<Options> options = ParseArgs(argc, argv);
+  if (!options) {
+    std::cerr << options.status() << "\n";
+    return 1;
+  }
+
+  google::cloud::StatusOr<gcs::ClientOptions> client_options =
+      gcs::ClientOptions::CreateDefaultClientOptions();
+  if (!client_options) {
+    std::cerr << "Could not create ClientOptions, status="
+              << client_options.status() << "\n";
+    return 1;
+  }
+  client_options->set_project_id(options->project_id);
+  // Keep a connection for each concurrent upload.
+  client_options->set_connection_pool_size(options->max_streams);
+
+  gcs::Client client(*std::move(client_options));
+
+  google::cloud::internal::DefaultPRNG generator =
+      google::cloud::internal::MakeDefaultPRNG();
+
+  auto bucket_name =
+      gcs_bm::MakeRandomBucketName(generator, "gcs-directory-upload-");
+  auto meta =
+      client
+          .CreateBucket(bucket_name,
+                        gcs::BucketMetadata()
+                            .set_storage_class(gcs::storage_class::Standard())
+                            .set_location(options->region),
+                        gcs::PredefinedAcl("private"),
+                        gcs::PredefinedDefaultObjectAcl("projectPrivate"),
+                        gcs::Projection("full"))
+          .value();
+  std::cout << "# Running test on bucket: " << meta.name() << "\n";
+  std::string notes = google::cloud::storage::version_string() + ";" +
+                      google::cloud::internal::compiler() + ";" +
+                      google::cloud::internal::compiler_flags();
+  std::transform(notes.begin(), notes.end(), notes.begin(),
+                 [](char c) { return c == '\n' ? ';' : c; });
+  std::cout << "# Start time: "
+            << google::cloud::internal::FormatRfc3339(
+                   std::chrono::system_clock::now())
+            << "\n# Region: " << options->region
+            << "\n# Duration: " << options->duration.count() << "s"
+            << "\n# File Count: " << options->file_count
+            << "\n# Directory Count: " << options->directory_count
+            << "\n# File Size: " << options->file_size
+            << "\n# Max Streams: " << options->max_streams
+            << "\n# Build info: " << notes << "\n";
+
+  std::cout << "# Creating directory to upload ..." << std::flush;
+  auto const root = gcs_bm::MakeRandomFileName(generator);
+  MakeDirectory(root);
+  std::vector<std::string> directories;
+  for (int i = 0; i != options->directory_count; ++i) {
+    directories.push_back(root + "/d" + std::to_string(i));
+    MakeDirectory(directories.back());
+  }
+  std::vector<std::string> files;
+  auto const data = gcs_bm::MakeRandomData(generator, options->file_size);
+  for (int i = 0; i != options->file_count; ++i) {
+    auto const& directory = directories.empty()
+                                ? root
+                                : directories[i % directories.size()];
+    files.push_back(directory + "/f" + std::to_string(i) + ".bin");
+    std::ofstream(files.back(), std::ios::binary) << data;
+  }
+  std::cout << " DONE\n"
+            << "# Directory: " << root << "\n"
+            << "Operation,Files,Uploaded,Skipped,Failed,Bytes,ElapsedMs,MiBs\n";
+
+  auto deadline = std::chrono::system_clock::now() + options->duration;
+  for (auto now = std::chrono::system_clock::now(); now < deadline;
+       now = std::chrono::system_clock::now()) {
+    auto const prefix = gcs_bm::MakeRandomObjectName(generator) + "/";
+    for (auto const* operation : {"Upload", "UploadUpToDate"}) {
+      auto result =
+          gcs::UploadDirectory(client, root, bucket_name, prefix,
+                               gcs::MaxStreams(options->max_streams));
+      if (!result) {
+        std::cout << "# Error in " << operation << ": " << result.status()
+                  << "\n";
+        break;
+      }
+      Report(operation, result->stats);
+    }
+    auto status = gcs::DeleteByPrefix(client, bucket_name, prefix);
+    if (!status.ok()) {
+      std::cout << "# Error in DeleteByPrefix: " << status << "\n";
+    }
+  }
+
+  for (auto const& f : files) std::remove(f.c_str());
+  for (auto const& d : directories) std::remove(d.c_str());
+  std::remove(root.c_str());
+
+  std::cout << "# Deleting " << bucket_name << "\n";
+  auto status = client.DeleteBucket(bucket_name);
+  if (!status.ok()) {
+    std::cerr << "# Error deleting bucket, status=" << status << "\n";
+    return 1;
+  }
+
+  return 0;
+}
+
+namespace {
+
+google::cloud::StatusOr<Options> ParseArgsDefault(
+    std::vector<std::string> const& argv) {
+  Options options;
+
+  bool wants_help = false;
+  bool wants_description = false;
+  std::vector<gcs_bm::OptionDescriptor> descriptors{
+      {"--help", "print the usage message",
+       [&wants_help](std::string const&) { wants_help = true; }},
+      {"--description", "print a description of the benchmark",
+       [&wants_description](std::string const&) { wants_description = true; }},
+      {"--project-id", "the GCP project to create the bucket",
+       [&options](std::string const& val) { options.project_id = val; }},
+      {"--duration", "how long should the benchmark run (in seconds).",
+       [&options](std::string const& val) {
+         options.duration = gcs_bm::ParseDuration(val);
+       }},
+      {"--file-count", "the number of files in the directory",
+       [&options](std::string const& val) {
+         options.file_count = std::stoi(val);
+       }},
+      {"--directory-count", "the number of subdirectories",
+       [&options](std::string const& val) {
+         options.directory_count = std::stoi(val);
+       }},
+      {"--file-size", "the size of each file",
+       [&options](std::string const& val) {
+         options.file_size = gcs_bm::ParseSize(val);
+       }},
+      {"--max-streams", "the number of concurrent uploads",
+       [&options](std::string const& val) {
+         options.max_streams = std::stoi(val);
+       }},
+      {"--region", "The GCS region used for the benchmark",
+       [&options](std::string const& val) { options.region = val; }},
+  };
+  auto usage = gcs_bm::BuildUsage(descriptors, argv[0]);
+
+  auto unparsed = gcs_bm::OptionsParse(descriptors, argv);
+  if (wants_help) {
+    std::cout << usage << "\n";
+  }
+
+  if (wants_description) {
+    std::cout << kDescription << "\n";
+  }
+
+  if (unparsed.size() > 2) {
+    std::ostringstream os;
+    os << "Unknown arguments or options\n" << usage << "\n";
+    return google::cloud::Status{google::cloud::StatusCode::kInvalidArgument,
+                                 std::move(os).str()};
+  }
+  if (unparsed.size() == 2) {
+    options.region = unparsed[1];
+  }
+  if (options.region.empty()) {
+    std::ostringstream os;
+    os << "Missing value for --region option" << usage << "\n";
+    return google::cloud::Status{google::cloud::StatusCode::kInvalidArgument,
+                                 std::move(os).str()};
+  }
+  if (options.file_count <= 0 || options.directory_count < 0 ||
+      options.max_streams <= 0) {
+    std::ostringstream os;
+    os << "Invalid --file-count, --directory-count, or --max-streams\n"
+       << usage << "\n";
+    return google::cloud::Status{google::cloud::StatusCode::kInvalidArgument,
+                                 std::move(os).str()};
+  }
+
+  return options;
+}
+
+google::cloud::StatusOr<Options> SelfTest() {
+  using google::cloud::internal::GetEnv;
+
+  google::cloud::Status const self_test_error(
+      google::cloud::StatusCode::kUnknown, "self-test failure");
+
+  {
+    auto options = ParseArgsDefault(
+        {"self-test", "--help", "--description", "fake-region"});
+    if (!options) return options;
+  }
+  {
+    // Missing the region should be an error
+    auto options = ParseArgsDefault({"self-test"});
+    if (options) return self_test_error;
+  }
+  {
+    // Too many positional arguments should be an error
+    auto options = ParseArgsDefault({"self-test", "unused-1", "unused-2"});
+    if (options) return self_test_error;
+  }
+
+  for (auto const& var :
+       {"GOOGLE_CLOUD_PROJECT", "GOOGLE_CLOUD_CPP_STORAGE_TEST_REGION_ID"}) {
+    auto const value = GetEnv(var).value_or("");
+    if (!value.empty()) continue;
+    std::ostringstream os;
+    os << "The environment variable " << var << " is not set or empty";
+    return google::cloud::Status(google::cloud::StatusCode::kUnknown,
+                                 std::move(os).str());
+  }
+  return ParseArgsDefault({
+      "self-test",
+      "--project-id=" + GetEnv("GOOGLE_CLOUD_PROJECT").value(),
+      "--duration=1s",
+      "--file-count=8",
+      "--directory-count=2",
+      "--file-size=1KiB",
+      "--max-streams=2",
+      "--region=" + GetEnv("GOOGLE_CLOUD_CPP_STORAGE_TEST_REGION_ID").value(),
+  });
+}
+
+google::cloud::StatusOr<Options> ParseArgs(int argc, char* argv[]) {
+  bool auto_run =
+      google::cloud::internal::GetEnv("GOOGLE_CLOUD_CPP_AUTO_RUN_EXAMPLES")
+          .value_or("") == "yes";
+  if (auto_run) return SelfTest();
+
+  return ParseArgsDefault({argv, argv + argc});
+}
+
+}  // namespace
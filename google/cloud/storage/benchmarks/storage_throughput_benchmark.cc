@@ -79,6 +79,7 @@ struct Options {
   std::int64_t maximum_read_size = 0;
   bool enable_connection_pool = true;
   bool enable_xml_api = true;
+  bool enable_adaptive_tuning = false;
   bool create_bucket = true;
   bool delete_bucket = true;
   bool create_objects = true;
@@ -139,6 +140,8 @@ int main(int argc, char* argv[]) {
   if (!options->project_id.empty()) {
     client_options->set_project_id(options->project_id);
   }
+  client_options->set_enable_adaptive_transfer_tuning(
+      options->enable_adaptive_tuning);
   gcs::Client client(*std::move(client_options));
 
   google::cloud::internal::DefaultPRNG generator =
@@ -190,6 +193,7 @@ int main(int argc, char* argv[]) {
             << gcs_bm::FormatSize(options->maximum_read_size) << std::boolalpha
             << "\n# Enable connection pool: " << options->enable_connection_pool
             << "\n# Enable XML API: " << options->enable_xml_api
+            << "\n# Enable adaptive tuning: " << options->enable_adaptive_tuning
             << "\n# Create Bucket: " << options->create_bucket
             << "\n# Delete Bucket: " << options->delete_bucket
             << "\n# Create Objects: " << options->create_objects
@@ -521,6 +525,13 @@ google::cloud::StatusOr<Options> ParseArgsDefault(
        [&options](std::string const& val) {
          options.enable_xml_api = gcs_bm::ParseBoolean(val).value_or(true);
        }},
+      {"--enable-adaptive-tuning",
+       "tune the buffer and upload chunk sizes based on the measured "
+       "throughput and RTT",
+       [&options](std::string const& val) {
+         options.enable_adaptive_tuning =
+             gcs_bm::ParseBoolean(val).value_or(false);
+       }},
       {"--project-id", "use the given project id for the benchmark",
        [&options](std::string const& val) { options.project_id = val; }},
       {"--region", "use this region if the benchmark creates a bucket",
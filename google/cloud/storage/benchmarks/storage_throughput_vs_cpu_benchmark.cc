@@ -20,6 +20,8 @@
 #include "google/cloud/internal/random.h"
 #include <future>
 #include <iomanip>
+#include <map>
+#include <mutex>
 #include <sstream>
 
 namespace {
@@ -74,7 +76,10 @@ The loop stops when any of the following conditions are met:
   the test has been running for more than a prescribed "duration".
 
 Once the threads finish running their loops the program prints the captured
-performance data. The bucket is deleted after the program terminates.
+performance data. The program also prints (as comments) a summary with the
+total CPU time used per GiB uploaded and downloaded, this is useful to quickly
+compare the CPU overhead of different versions of the library. The bucket is
+deleted after the program terminates.
 
 A helper script in this directory can generate pretty graphs from the output of
 this program.
@@ -112,6 +117,7 @@ using TestResults = std::vector<IterationResult>;
 
 TestResults RunThread(Options const& options, std::string const& bucket_name);
 void PrintResults(TestResults const& results);
+void PrintCpuSummary();
 
 google::cloud::StatusOr<Options> ParseArgs(int argc, char* argv[]);
 
@@ -188,6 +194,7 @@ int main(int argc, char* argv[]) {
   for (auto& f : tasks) {
     PrintResults(f.get());
   }
+  PrintCpuSummary();
 
   gcs_bm::DeleteAllObjects(client, bucket_name, options->thread_count);
   auto status = client.DeleteBucket(bucket_name);
@@ -236,9 +243,36 @@ std::ostream& operator<<(std::ostream& os, IterationResult const& rhs) {
             << google::cloud::storage::version_string();
 }
 
+// Accumulate the CPU usage for all the successful operations, the results may
+// be printed from the worker thread, so we need to protect this data.
+struct CpuSummary {
+  std::uint64_t bytes = 0;
+  std::chrono::microseconds cpu_time{0};
+};
+std::mutex cpu_summary_mu;
+std::map<OpType, CpuSummary> cpu_summary;
+
 void PrintResults(TestResults const& results) {
+  std::lock_guard<std::mutex> lk(cpu_summary_mu);
   for (auto& r : results) {
     std::cout << r << '\n';
+    if (r.status != google::cloud::StatusCode::kOk) continue;
+    auto& summary = cpu_summary[r.op];
+    summary.bytes += r.object_size;
+    summary.cpu_time += r.cpu_time;
+  }
+  std::cout << std::flush;
+}
+
+void PrintCpuSummary() {
+  std::lock_guard<std::mutex> lk(cpu_summary_mu);
+  for (auto const& kv : cpu_summary) {
+    if (kv.second.bytes == 0) continue;
+    auto const gib = static_cast<double>(kv.second.bytes) / gcs_bm::kGiB;
+    auto const cpu_seconds =
+        std::chrono::duration<double>(kv.second.cpu_time).count();
+    std::cout << "# " << ToString(kv.first)
+              << " CPU seconds per GiB: " << cpu_seconds / gib << "\n";
   }
   std::cout << std::flush;
 }
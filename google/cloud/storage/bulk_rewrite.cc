@@ -0,0 +1,131 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/bulk_rewrite.h"
+#include "google/cloud/storage/internal/moving_average.h"
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+using BulkRewriteMonitor = ProgressMonitor<BulkRewriteStats>;
+
+StatusOr<ObjectMetadata> RewriteOne(RawClient& client, std::size_t index,
+                                    BulkRewriteTask const& task,
+                                    RewriteObjectRequest request,
+                                    RewriteChunkTuner& tuner,
+                                    BulkRewriteConfig const& config,
+                                    BulkRewriteMonitor& monitor) {
+  auto state = task.state;
+  // The value cannot change after the rewrite starts.
+  if (state.rewrite_token.empty()) {
+    state.max_bytes_rewritten_per_call =
+        config.max_bytes_rewritten_per_call != 0
+            ? config.max_bytes_rewritten_per_call
+            : tuner.NextObjectLimit();
+  }
+  if (state.max_bytes_rewritten_per_call != 0) {
+    request.set_option(
+        MaxBytesRewrittenPerCall(state.max_bytes_rewritten_per_call));
+  } else {
+    request.set_option(MaxBytesRewrittenPerCall());
+  }
+
+  for (;;) {
+    auto const start = std::chrono::steady_clock::now();
+    auto response = client.RewriteObject(request);
+    if (!response) {
+      monitor.Update([](BulkRewriteStats& s) { ++s.objects_failed; },
+                     config.progress);
+      return std::move(response).status();
+    }
+    auto const bytes =
+        response->total_bytes_rewritten > state.total_bytes_rewritten
+            ? response->total_bytes_rewritten - state.total_bytes_rewritten
+            : 0;
+    tuner.OnCall(bytes, std::chrono::steady_clock::now() - start);
+
+    state.rewrite_token = std::move(response->rewrite_token);
+    state.total_bytes_rewritten = response->total_bytes_rewritten;
+    state.done = response->done;
+    monitor.Update(
+        [&](BulkRewriteStats& s) {
+          s.bytes_rewritten += bytes;
+          if (state.done) ++s.objects_completed;
+        },
+        [&](BulkRewriteStats const& s) {
+          config.checkpoint(index, state);
+          config.progress(s);
+        });
+    if (state.done) return std::move(response->resource);
+    request.set_rewrite_token(state.rewrite_token);
+  }
+}
+}  // namespace
+
+std::int64_t constexpr RewriteChunkTuner::kQuantum;
+std::int64_t constexpr RewriteChunkTuner::kMaxBytesPerCall;
+
+std::int64_t RewriteChunkTuner::NextObjectLimit() const {
+  std::unique_lock<std::mutex> lk(mu_);
+  auto const rate = bytes_per_second_;
+  lk.unlock();
+  if (rate <= 0) return 0;
+  using seconds = std::chrono::duration<double>;
+  auto const target =
+      std::chrono::duration_cast<seconds>(target_call_duration_).count();
+  auto const bytes = (std::min)(rate * target,
+                                static_cast<double>(kMaxBytesPerCall));
+  // The service requires a multiple of 1 MiB.
+  auto const quanta = static_cast<std::int64_t>(bytes) / kQuantum;
+  return (std::max)(quanta, std::int64_t{1}) * kQuantum;
+}
+
+void RewriteChunkTuner::OnCall(std::uint64_t bytes,
+                               std::chrono::steady_clock::duration elapsed) {
+  using seconds = std::chrono::duration<double>;
+  auto const s = std::chrono::duration_cast<seconds>(elapsed).count();
+  if (bytes == 0 || s <= 0) return;
+  auto const sample = static_cast<double>(bytes) / s;
+  std::lock_guard<std::mutex> lk(mu_);
+  bytes_per_second_ = Smooth(bytes_per_second_, sample);
+}
+
+BulkRewriteResult BulkRewriteObjectsImpl(
+    RawClient& client, std::vector<BulkRewriteTask> const& tasks,
+    BulkRewriteRequestFactory const& make_request, BulkRewriteConfig config) {
+  RewriteChunkTuner tuner(config.target_call_duration);
+  BulkRewriteStats initial;
+  initial.objects_total = tasks.size();
+  BulkRewriteMonitor monitor(initial);
+  BulkRewriteResult result;
+  result.objects.resize(tasks.size());
+  RunConcurrently(tasks.size(), config.max_streams, [&](std::size_t i) {
+    result.objects[i] = RewriteOne(client, i, tasks[i], make_request(tasks[i]),
+                                   tuner, config, monitor);
+    // A failed rewrite does not stop the others.
+    return true;
+  });
+  result.stats = monitor.Current();
+  return result;
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
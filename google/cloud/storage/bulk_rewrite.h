@@ -0,0 +1,299 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_BULK_REWRITE_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_BULK_REWRITE_H
+
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/internal/bulk_progress.h"
+#include "google/cloud/storage/internal/tuple_filter.h"
+#include "google/cloud/storage/parallel_upload.h"
+#include "google/cloud/storage/version.h"
+#include "google/cloud/status_or.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+/**
+ * The state of a rewrite in `BulkRewriteObjects()`.
+ *
+ * Applications save this state in their checkpoints, and use it to resume the
+ * rewrite, even if the application was terminated.
+ */
+struct BulkRewriteState {
+  /// The token to resume the rewrite, empty if the rewrite has not started.
+  std::string rewrite_token;
+  /**
+   * The `MaxBytesRewrittenPerCall` value used by the rewrite.
+   *
+   * The service rejects a rewrite token if this value changes between calls,
+   * a value of 0 means the option was not set.
+   */
+  std::int64_t max_bytes_rewritten_per_call = 0;
+  std::uint64_t total_bytes_rewritten = 0;
+  bool done = false;
+};
+
+/// One of the objects copied by `BulkRewriteObjects()`.
+struct BulkRewriteTask {
+  std::string source_bucket_name;
+  std::string source_object_name;
+  std::string destination_bucket_name;
+  std::string destination_object_name;
+  /// The state from a previous checkpoint, the default starts a new rewrite.
+  BulkRewriteState state;
+};
+
+/// The aggregate progress of `BulkRewriteObjects()`.
+struct BulkRewriteStats {
+  std::size_t objects_total = 0;
+  std::size_t objects_completed = 0;
+  std::size_t objects_failed = 0;
+  /// The bytes rewritten by this call, excluding any resumed progress.
+  std::uint64_t bytes_rewritten = 0;
+  std::chrono::steady_clock::duration elapsed{};
+
+  double BytesPerSecond() const {
+    return internal::BytesPerSecond(bytes_rewritten, elapsed);
+  }
+};
+
+/// The results of `BulkRewriteObjects()`, in the same order as the tasks.
+struct BulkRewriteResult {
+  std::vector<StatusOr<ObjectMetadata>> objects;
+  BulkRewriteStats stats;
+};
+
+/**
+ * A parameter type to receive the checkpoints in `BulkRewriteObjects()`.
+ *
+ * The callback receives the index of the task and its new state after each
+ * request to the service. It may be called from several threads, but the calls
+ * are serialized.
+ */
+class RewriteCheckpointCallback
+    : public internal::CallbackOption<
+          RewriteCheckpointCallback,
+          void(std::size_t, BulkRewriteState const&)> {
+ public:
+  using CallbackOption::CallbackOption;
+};
+
+/**
+ * A parameter type to receive the progress of `BulkRewriteObjects()`.
+ *
+ * The callback receives the aggregate progress after each request to the
+ * service. It may be called from several threads, but the calls are
+ * serialized.
+ */
+class RewriteProgressCallback
+    : public internal::CallbackOption<RewriteProgressCallback,
+                                      void(BulkRewriteStats const&)> {
+ public:
+  using CallbackOption::CallbackOption;
+};
+
+namespace internal {
+
+/**
+ * Chooses the `MaxBytesRewrittenPerCall` value for new rewrites.
+ *
+ * The value cannot change once a rewrite starts, so it is chosen per object:
+ * the tuner keeps an estimate of the throughput of each request, and picks the
+ * value that completes a request in about @p target_call_duration. Shorter
+ * requests make checkpoints and progress reports more frequent, longer
+ * requests reduce the number of requests. Before any request completes the
+ * option is not set, and the service uses its default.
+ *
+ * This class is thread-safe.
+ */
+class RewriteChunkTuner {
+ public:
+  static std::int64_t constexpr kQuantum = 1024 * 1024;
+  static std::int64_t constexpr kMaxBytesPerCall = 1024 * kQuantum;
+
+  explicit RewriteChunkTuner(std::chrono::milliseconds target_call_duration)
+      : target_call_duration_(target_call_duration) {}
+
+  /// The value for a new rewrite, 0 if there is no estimate yet.
+  std::int64_t NextObjectLimit() const;
+
+  /// Updates the throughput estimate after a request completes.
+  void OnCall(std::uint64_t bytes, std::chrono::steady_clock::duration elapsed);
+
+ private:
+  std::chrono::milliseconds target_call_duration_;
+  mutable std::mutex mu_;
+  double bytes_per_second_ = 0;
+};
+
+struct BulkRewriteConfig {
+  std::size_t max_streams;
+  /// If not 0 use this value for all new rewrites, otherwise tune it.
+  std::int64_t max_bytes_rewritten_per_call;
+  std::chrono::milliseconds target_call_duration;
+  RewriteCheckpointCallback::Callback checkpoint;
+  RewriteProgressCallback::Callback progress;
+};
+
+/// Creates the first request for a task, including any common options.
+using BulkRewriteRequestFactory =
+    std::function<RewriteObjectRequest(BulkRewriteTask const&)>;
+
+BulkRewriteResult BulkRewriteObjectsImpl(
+    RawClient& client, std::vector<BulkRewriteTask> const& tasks,
+    BulkRewriteRequestFactory const& make_request, BulkRewriteConfig config);
+
+struct RewriteSetOptionsApplyHelper {
+  template <typename... Options>
+  void operator()(Options&&... options) const {
+    request.set_multiple_options(std::forward<Options>(options)...);
+  }
+
+  RewriteObjectRequest& request;
+};
+
+}  // namespace internal
+
+/**
+ * Rewrites (copies) many objects, keeping several rewrites in flight.
+ *
+ * Each rewrite may require multiple requests to the service, for example, when
+ * copying objects across locations or storage classes. This function runs up
+ * to `MaxStreams` rewrites concurrently (the default is 16), each one until it
+ * completes or fails.
+ *
+ * Applications copying many objects should provide a
+ * `RewriteCheckpointCallback` and save the state of each task. If the
+ * application is terminated it can resume the rewrites by calling this
+ * function with the saved state in each `BulkRewriteTask`. Tasks with
+ * `state.done == true` should be removed, calling this function with them
+ * copies the object again. Use `RewriteProgressCallback` to report the
+ * aggregate progress and throughput.
+ *
+ * Unless the application provides a `MaxBytesRewrittenPerCall` option, the
+ * function chooses its value for each object, based on the throughput
+ * observed so far, so each request takes about 10 seconds.
+ *
+ * @param client the client on which to perform the operations.
+ * @param tasks the objects to copy.
+ * @param options a list of optional query parameters and/or request headers.
+ *     The options apply to all the rewrites. Valid types for this operation
+ *     include `DestinationKmsKeyName`, `DestinationPredefinedAcl`,
+ *     `EncryptionKey`, `IfGenerationMatch`, `IfGenerationNotMatch`,
+ *     `IfMetagenerationMatch`, `IfMetagenerationNotMatch`,
+ *     `IfSourceGenerationMatch`, `IfSourceGenerationNotMatch`,
+ *     `IfSourceMetagenerationMatch`, `IfSourceMetagenerationNotMatch`,
+ *     `MaxBytesRewrittenPerCall`, `MaxStreams`, `Projection`, `QuotaUser`,
+ *     `RewriteCheckpointCallback`, `RewriteProgressCallback`,
+ *     `SourceEncryptionKey`, `UserIp`, and `UserProject`.
+ *
+ * @return the metadata of each new object, or the error that stopped its
+ *     rewrite, in the same order as @p tasks. A failure does not stop the
+ *     other rewrites.
+ *
+ * @par Idempotency
+ * Each request is retried based on the client policies. Rewrites are only
+ * idempotent if restricted by pre-conditions, for example
+ * `IfGenerationMatch(0)`.
+ */
+template <typename... Options>
+BulkRewriteResult BulkRewriteObjects(Client client,
+                                     std::vector<BulkRewriteTask> const& tasks,
+                                     Options&&... options) {
+  using internal::Among;
+  using internal::NotAmong;
+  using internal::StaticTupleFilter;
+
+  static_assert(
+      std::tuple_size<decltype(
+              StaticTupleFilter<NotAmong<
+                  DestinationKmsKeyName, DestinationPredefinedAcl,
+                  EncryptionKey, IfGenerationMatch, IfGenerationNotMatch,
+                  IfMetagenerationMatch, IfMetagenerationNotMatch,
+                  IfSourceGenerationMatch, IfSourceGenerationNotMatch,
+                  IfSourceMetagenerationMatch, IfSourceMetagenerationNotMatch,
+                  MaxBytesRewrittenPerCall, MaxStreams, Projection, QuotaUser,
+                  RewriteCheckpointCallback, RewriteProgressCallback,
+                  SourceEncryptionKey, UserIp, UserProject>::TPred>(
+                  std::tie(options...)))>::value == 0,
+      "This functions accepts only options of type DestinationKmsKeyName, "
+      "DestinationPredefinedAcl, EncryptionKey, IfGenerationMatch, "
+      "IfGenerationNotMatch, IfMetagenerationMatch, IfMetagenerationNotMatch, "
+      "IfSourceGenerationMatch, IfSourceGenerationNotMatch, "
+      "IfSourceMetagenerationMatch, IfSourceMetagenerationNotMatch, "
+      "MaxBytesRewrittenPerCall, MaxStreams, Projection, QuotaUser, "
+      "RewriteCheckpointCallback, RewriteProgressCallback, "
+      "SourceEncryptionKey, UserIp or UserProject.");
+
+  auto request_options = StaticTupleFilter<
+      Among<DestinationKmsKeyName, DestinationPredefinedAcl, EncryptionKey,
+            IfGenerationMatch, IfGenerationNotMatch, IfMetagenerationMatch,
+            IfMetagenerationNotMatch, IfSourceGenerationMatch,
+            IfSourceGenerationNotMatch, IfSourceMetagenerationMatch,
+            IfSourceMetagenerationNotMatch, MaxBytesRewrittenPerCall,
+            Projection, QuotaUser, SourceEncryptionKey, UserIp,
+            UserProject>::TPred>(std::make_tuple(options...));
+  auto make_request = [request_options](BulkRewriteTask const& task) {
+    internal::RewriteObjectRequest request(
+        task.source_bucket_name, task.source_object_name,
+        task.destination_bucket_name, task.destination_object_name,
+        task.state.rewrite_token);
+    google::cloud::internal::apply(
+        internal::RewriteSetOptionsApplyHelper{request}, request_options);
+    return request;
+  };
+
+  using internal::ExtractFirstOccurenceOfType;
+  auto all_options = std::tie(options...);
+  // Rewrites are bounded by the service, not by the client, the default is
+  // arbitrary.
+  MaxStreams const default_max_streams(16);
+  // The option may be present but empty, in that case tune the value.
+  auto const max_bytes =
+      ExtractFirstOccurenceOfType<MaxBytesRewrittenPerCall>(all_options);
+  internal::BulkRewriteConfig config{
+      ExtractFirstOccurenceOfType<MaxStreams>(all_options)
+          .value_or(default_max_streams)
+          .value(),
+      max_bytes && max_bytes->has_value() ? max_bytes->value() : 0,
+      std::chrono::seconds(10),
+      ExtractFirstOccurenceOfType<RewriteCheckpointCallback>(all_options)
+          .value_or(RewriteCheckpointCallback(
+              [](std::size_t, BulkRewriteState const&) {}))
+          .value(),
+      ExtractFirstOccurenceOfType<RewriteProgressCallback>(all_options)
+          .value_or(RewriteProgressCallback([](BulkRewriteStats const&) {}))
+          .value(),
+  };
+
+  return internal::BulkRewriteObjectsImpl(*client.raw_client(), tasks,
+                                          make_request, std::move(config));
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_BULK_REWRITE_H
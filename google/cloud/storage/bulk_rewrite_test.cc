@@ -0,0 +1,251 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/bulk_rewrite.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include "absl/memory/memory.h"
+#include <gmock/gmock.h>
+#include <map>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::testing::_;
+using ::testing::Invoke;
+
+class BulkRewriteTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    raw_client_mock_ = std::make_shared<testing::MockClient>();
+    client_ = absl::make_unique<Client>(
+        std::shared_ptr<internal::RawClient>(raw_client_mock_),
+        Client::NoDecorations{});
+  }
+
+  std::shared_ptr<testing::MockClient> raw_client_mock_;
+  std::unique_ptr<Client> client_;
+};
+
+BulkRewriteTask MakeTask(std::string const& name) {
+  return BulkRewriteTask{"src-bucket", name, "dst-bucket", name + ".copy", {}};
+}
+
+/**
+ * A fake rewrite: each object takes two requests, the first one copies half
+ * the object. The token encodes the object name.
+ */
+StatusOr<RewriteObjectResponse> FakeRewrite(RewriteObjectRequest const& r) {
+  EXPECT_EQ("src-bucket", r.source_bucket());
+  EXPECT_EQ("dst-bucket", r.destination_bucket());
+  EXPECT_EQ(r.source_object() + ".copy", r.destination_object());
+  RewriteObjectResponse response;
+  response.object_size = 2 * 1024 * 1024;
+  if (r.rewrite_token().empty()) {
+    response.total_bytes_rewritten = 1024 * 1024;
+    response.done = false;
+    response.rewrite_token = "token-" + r.source_object();
+    return response;
+  }
+  EXPECT_EQ("token-" + r.source_object(), r.rewrite_token());
+  response.total_bytes_rewritten = response.object_size;
+  response.done = true;
+  response.resource = ObjectMetadataParser::FromJson(
+                          nl::json{{"bucket", r.destination_bucket()},
+                                   {"name", r.destination_object()}})
+                          .value();
+  return response;
+}
+
+TEST_F(BulkRewriteTest, Basic) {
+  EXPECT_CALL(*raw_client_mock_, RewriteObject(_))
+      .Times(6)
+      .WillRepeatedly(Invoke(FakeRewrite));
+
+  std::mutex mu;
+  std::map<std::size_t, std::vector<BulkRewriteState>> checkpoints;
+  std::size_t progress_calls = 0;
+  auto result = BulkRewriteObjects(
+      *client_, {MakeTask("a"), MakeTask("b"), MakeTask("c")}, MaxStreams(2),
+      RewriteCheckpointCallback(
+          [&](std::size_t index, BulkRewriteState const& state) {
+            std::lock_guard<std::mutex> lk(mu);
+            checkpoints[index].push_back(state);
+          }),
+      RewriteProgressCallback([&](BulkRewriteStats const& stats) {
+        EXPECT_EQ(3, stats.objects_total);
+        ++progress_calls;
+      }));
+
+  ASSERT_EQ(3, result.objects.size());
+  std::vector<std::string> const names{"a", "b", "c"};
+  for (std::size_t i = 0; i != names.size(); ++i) {
+    ASSERT_STATUS_OK(result.objects[i]);
+    EXPECT_EQ(names[i] + ".copy", result.objects[i]->name());
+
+    auto const& c = checkpoints[i];
+    ASSERT_EQ(2, c.size());
+    EXPECT_EQ("token-" + names[i], c[0].rewrite_token);
+    EXPECT_EQ(1024 * 1024, c[0].total_bytes_rewritten);
+    EXPECT_FALSE(c[0].done);
+    EXPECT_EQ(2 * 1024 * 1024, c[1].total_bytes_rewritten);
+    EXPECT_TRUE(c[1].done);
+  }
+  EXPECT_EQ(6, progress_calls);
+  EXPECT_EQ(3, result.stats.objects_completed);
+  EXPECT_EQ(0, result.stats.objects_failed);
+  EXPECT_EQ(3 * 2 * 1024 * 1024, result.stats.bytes_rewritten);
+}
+
+TEST_F(BulkRewriteTest, Resume) {
+  EXPECT_CALL(*raw_client_mock_, RewriteObject(_))
+      .WillOnce(Invoke([](RewriteObjectRequest const& r) {
+        EXPECT_EQ("token-a", r.rewrite_token());
+        // The value saved in the checkpoint, not the value in the options.
+        EXPECT_EQ(3 * 1024 * 1024,
+                  r.GetOption<MaxBytesRewrittenPerCall>().value());
+        EXPECT_EQ("test-project", r.GetOption<UserProject>().value());
+        return FakeRewrite(r);
+      }));
+
+  auto task = MakeTask("a");
+  task.state.rewrite_token = "token-a";
+  task.state.max_bytes_rewritten_per_call = 3 * 1024 * 1024;
+  task.state.total_bytes_rewritten = 1024 * 1024;
+  auto result =
+      BulkRewriteObjects(*client_, {task}, UserProject("test-project"),
+                         MaxBytesRewrittenPerCall(8 * 1024 * 1024));
+  ASSERT_EQ(1, result.objects.size());
+  ASSERT_STATUS_OK(result.objects[0]);
+  // Only the bytes rewritten after the checkpoint are counted.
+  EXPECT_EQ(1024 * 1024, result.stats.bytes_rewritten);
+  EXPECT_EQ(1, result.stats.objects_completed);
+}
+
+TEST_F(BulkRewriteTest, FixedMaxBytesRewrittenPerCall) {
+  EXPECT_CALL(*raw_client_mock_, RewriteObject(_))
+      .Times(4)
+      .WillRepeatedly(Invoke([](RewriteObjectRequest const& r) {
+        EXPECT_EQ(8 * 1024 * 1024,
+                  r.GetOption<MaxBytesRewrittenPerCall>().value());
+        return FakeRewrite(r);
+      }));
+
+  auto result = BulkRewriteObjects(*client_, {MakeTask("a"), MakeTask("b")},
+                                   MaxBytesRewrittenPerCall(8 * 1024 * 1024));
+  ASSERT_EQ(2, result.objects.size());
+  EXPECT_STATUS_OK(result.objects[0]);
+  EXPECT_STATUS_OK(result.objects[1]);
+}
+
+TEST_F(BulkRewriteTest, EmptyMaxBytesRewrittenPerCall) {
+  EXPECT_CALL(*raw_client_mock_, RewriteObject(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([](RewriteObjectRequest const& r) {
+        // Without an estimate the option is not set.
+        EXPECT_FALSE(r.GetOption<MaxBytesRewrittenPerCall>().has_value());
+        return FakeRewrite(r);
+      }));
+
+  auto result = BulkRewriteObjects(*client_, {MakeTask("a")},
+                                   MaxBytesRewrittenPerCall());
+  ASSERT_EQ(1, result.objects.size());
+  EXPECT_STATUS_OK(result.objects[0]);
+}
+
+TEST_F(BulkRewriteTest, ForwardsRequestOptions) {
+  EXPECT_CALL(*raw_client_mock_, RewriteObject(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([](RewriteObjectRequest const& r) {
+        EXPECT_EQ(7, r.GetOption<IfSourceGenerationMatch>().value());
+        EXPECT_EQ(3, r.GetOption<IfMetagenerationMatch>().value());
+        EXPECT_EQ(5, r.GetOption<IfGenerationNotMatch>().value());
+        EXPECT_EQ("test-quota-user", r.GetOption<QuotaUser>().value());
+        EXPECT_EQ("127.0.0.1", r.GetOption<UserIp>().value());
+        return FakeRewrite(r);
+      }));
+
+  auto result = BulkRewriteObjects(
+      *client_, {MakeTask("a")}, IfSourceGenerationMatch(7),
+      IfMetagenerationMatch(3), IfGenerationNotMatch(5),
+      QuotaUser("test-quota-user"), UserIp("127.0.0.1"));
+  ASSERT_EQ(1, result.objects.size());
+  EXPECT_STATUS_OK(result.objects[0]);
+}
+
+TEST_F(BulkRewriteTest, FailureDoesNotStopOthers) {
+  EXPECT_CALL(*raw_client_mock_, RewriteObject(_))
+      .Times(6)
+      .WillRepeatedly(Invoke([](RewriteObjectRequest const& r) {
+        if (r.source_object() == "b" && !r.rewrite_token().empty()) {
+          return StatusOr<RewriteObjectResponse>(PermanentError());
+        }
+        return FakeRewrite(r);
+      }));
+
+  auto result = BulkRewriteObjects(
+      *client_, {MakeTask("a"), MakeTask("b"), MakeTask("c")}, MaxStreams(1));
+  ASSERT_EQ(3, result.objects.size());
+  EXPECT_STATUS_OK(result.objects[0]);
+  EXPECT_EQ(PermanentError().code(), result.objects[1].status().code());
+  EXPECT_STATUS_OK(result.objects[2]);
+  EXPECT_EQ(2, result.stats.objects_completed);
+  EXPECT_EQ(1, result.stats.objects_failed);
+}
+
+TEST(RewriteChunkTunerTest, Tuning) {
+  RewriteChunkTuner tuner(std::chrono::seconds(10));
+  // No estimate, the service chooses.
+  EXPECT_EQ(0, tuner.NextObjectLimit());
+
+  auto constexpr kMiB = RewriteChunkTuner::kQuantum;
+  tuner.OnCall(10 * kMiB, std::chrono::seconds(1));
+  EXPECT_EQ(100 * kMiB, tuner.NextObjectLimit());
+
+  // The estimate moves towards slower samples.
+  tuner.OnCall(2 * kMiB, std::chrono::seconds(1));
+  auto const limit = tuner.NextObjectLimit();
+  EXPECT_LT(limit, 100 * kMiB);
+  EXPECT_GT(limit, 20 * kMiB);
+  EXPECT_EQ(0, limit % kMiB);
+
+  // Empty responses carry no information.
+  tuner.OnCall(0, std::chrono::seconds(1));
+  EXPECT_EQ(limit, tuner.NextObjectLimit());
+}
+
+TEST(RewriteChunkTunerTest, Bounds) {
+  auto constexpr kMiB = RewriteChunkTuner::kQuantum;
+  RewriteChunkTuner slow(std::chrono::seconds(1));
+  slow.OnCall(1024, std::chrono::seconds(1));
+  EXPECT_EQ(kMiB, slow.NextObjectLimit());
+
+  RewriteChunkTuner fast(std::chrono::seconds(10));
+  fast.OnCall(1024 * kMiB, std::chrono::milliseconds(100));
+  EXPECT_EQ(RewriteChunkTuner::kMaxBytesPerCall, fast.NextObjectLimit());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
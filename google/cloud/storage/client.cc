@@ -16,13 +16,18 @@
 #include "google/cloud/storage/internal/curl_client.h"
 #include "google/cloud/storage/internal/curl_handle.h"
 #include "google/cloud/storage/internal/openssl_util.h"
+#include "google/cloud/storage/internal/pipelined_object_write_streambuf.h"
 #include "google/cloud/storage/oauth2/service_account_credentials.h"
 #include "google/cloud/internal/filesystem.h"
 #include "google/cloud/log.h"
 #include "absl/memory/memory.h"
 #include <openssl/md5.h>
+#include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <iterator>
 #include <thread>
+#include <vector>
 
 namespace google {
 namespace cloud {
@@ -85,8 +90,17 @@ ObjectWriteStream Client::WriteObjectImpl(
     error_stream.Close();
     return error_stream;
   }
+  auto const& options = raw_client_->client_options();
+  auto const buffer_size = raw_client_->upload_buffer_size();
+  if (options.upload_pipeline_depth() != 0) {
+    return ObjectWriteStream(
+        absl::make_unique<internal::PipelinedObjectWriteStreambuf>(
+            *std::move(session), buffer_size,
+            internal::CreateHashValidator(request),
+            options.upload_pipeline_depth()));
+  }
   return ObjectWriteStream(absl::make_unique<internal::ObjectWriteStreambuf>(
-      *std::move(session), raw_client_->client_options().upload_buffer_size(),
+      *std::move(session), buffer_size,
       internal::CreateHashValidator(request)));
 }
 
@@ -156,27 +170,29 @@ StatusOr<ObjectMetadata> Client::UploadStreamResumable(
 
   // GCS requires chunks to be a multiple of 256KiB.
   auto chunk_size = internal::UploadChunkRequest::RoundUpToQuantum(
-      raw_client()->client_options().upload_buffer_size());
+      raw_client()->upload_buffer_size());
 
   StatusOr<internal::ResumableUploadResponse> upload_response(
       internal::ResumableUploadResponse{});
+  // The same buffer is reused for all the chunks, the sessions do not copy it.
+  std::vector<char> buffer(chunk_size);
   // We iterate while `source` is good and the retry policy has not been
   // exhausted.
   while (!source.eof() && upload_response &&
          !upload_response->payload.has_value()) {
     // Read a chunk of data from the source file.
-    std::string buffer(chunk_size, '\0');
-    source.read(&buffer[0], buffer.size());
+    source.read(buffer.data(), buffer.size());
     auto gcount = static_cast<std::size_t>(source.gcount());
     bool final_chunk = (gcount < buffer.size());
     auto source_size = session->next_expected_byte() + gcount;
-    buffer.resize(gcount);
+    internal::ConstBufferSequence const chunk{
+        internal::ConstBuffer(buffer.data(), gcount)};
 
     auto expected = session->next_expected_byte() + gcount - 1;
     if (final_chunk) {
-      upload_response = session->UploadFinalChunk(buffer, source_size);
+      upload_response = session->UploadFinalChunk(chunk, source_size);
     } else {
-      upload_response = session->UploadChunk(buffer);
+      upload_response = session->UploadChunk(chunk);
     }
     if (!upload_response) {
       return std::move(upload_response).status();
@@ -308,17 +324,7 @@ StatusOr<std::string> Client::SignUrlV4(internal::V4SignUrlRequest request) {
     return signed_blob.status();
   }
 
-  std::string signature = internal::HexEncode(signed_blob->signed_blob);
-  internal::CurlHandle curl;
-  std::ostringstream os;
-  os << request.HostnameWithBucket();
-  for (auto& part : request.ObjectNameParts()) {
-    os << '/' << curl.MakeEscapedString(part).get();
-  }
-  os << "?" << request.CanonicalQueryString(signing_email)
-     << "&X-Goog-Signature=" << signature;
-
-  return std::move(os).str();
+  return request.SignedUrl(signing_email, signed_blob->signed_blob);
 }
 
 StatusOr<PolicyDocumentResult> Client::SignPolicyDocument(
@@ -374,10 +380,68 @@ std::string CreateRandomPrefixName(std::string const& prefix) {
 
 namespace internal {
 
+std::vector<Status> DeleteObjectsImpl(
+    RawClient& client, std::vector<DeleteObjectRequest> const& requests) {
+  auto delete_one = [&client](DeleteObjectRequest const& r) {
+    return client.DeleteObject(r).status();
+  };
+  std::vector<Status> result;
+  result.reserve(requests.size());
+  auto begin = requests.begin();
+  while (begin != requests.end()) {
+    auto const count = (std::min)(
+        BatchRequest::kMaxBatchSize,
+        static_cast<std::size_t>(std::distance(begin, requests.end())));
+    auto const end = std::next(begin, static_cast<std::ptrdiff_t>(count));
+    // A batch with a single request is just overhead.
+    if (count == 1) {
+      result.push_back(delete_one(*begin));
+      begin = end;
+      continue;
+    }
+    BatchRequest batch;
+    for (auto i = begin; i != end; ++i) batch.AddDeleteObject(*i);
+    auto response = client.ExecuteBatch(batch);
+    if (!response && response.status().code() == StatusCode::kUnimplemented) {
+      // Not all the transports support batches, use individual requests.
+      std::transform(begin, end, std::back_inserter(result), delete_one);
+    } else if (!response) {
+      result.insert(result.end(), count, response.status());
+    } else {
+      for (auto const& r : response->responses) result.push_back(AsStatus(r));
+    }
+    begin = end;
+  }
+  return result;
+}
+
+void RunConcurrently(std::size_t count, std::size_t max_concurrency,
+                     std::function<bool(std::size_t)> const& task) {
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> stopped{false};
+  auto worker = [&] {
+    while (!stopped.load()) {
+      auto const i = next.fetch_add(1);
+      if (i >= count) return;
+      if (!task(i)) stopped.store(true);
+    }
+  };
+  auto const thread_count =
+      (std::min)(count, (std::max)(max_concurrency, std::size_t{1}));
+  std::vector<std::thread> threads;
+  // The calling thread is also a worker.
+  for (std::size_t i = 1; i < thread_count; ++i) threads.emplace_back(worker);
+  worker();
+  for (auto& t : threads) t.join();
+}
+
 ScopedDeleter::ScopedDeleter(
     std::function<Status(std::string, std::int64_t)> delete_fun)
     : enabled_(true), delete_fun_(std::move(delete_fun)) {}
 
+ScopedDeleter::ScopedDeleter(BatchDeleteFunction batch_delete_fun)
+    : enabled_(true), batch_delete_fun_(std::move(batch_delete_fun)) {}
+
 ScopedDeleter::~ScopedDeleter() {
   if (enabled_) {
     ExecuteDelete();
@@ -398,6 +462,20 @@ Status ScopedDeleter::ExecuteDelete() {
   // make sure the dtor will not do this again
   object_list.swap(object_list_);
 
+  if (batch_delete_fun_) {
+    if (object_list.empty()) return Status();
+    // The order within a batch is unspecified, but the first object (often a
+    // "lock") must still be removed last.
+    auto first = std::move(object_list.front());
+    object_list.erase(object_list.begin());
+    for (auto& status : batch_delete_fun_(std::move(object_list))) {
+      if (!status.ok()) return std::move(status);
+    }
+    auto status = batch_delete_fun_({std::move(first)});
+    if (!status.empty() && !status.front().ok()) return status.front();
+    return Status();
+  }
+
   // Perform deletion in reverse order. We rely on it in functions which create
   // a "lock" object - it is created as the first file and should be removed as
   // last.
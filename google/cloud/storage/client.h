@@ -15,10 +15,14 @@
 #ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_CLIENT_H
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_CLIENT_H
 
+#include "google/cloud/storage/connection_pool_stats.h"
 #include "google/cloud/storage/hmac_key_metadata.h"
+#include "google/cloud/storage/internal/caching_client.h"
+#include "google/cloud/storage/internal/hedging_client.h"
 #include "google/cloud/storage/internal/logging_client.h"
 #include "google/cloud/storage/internal/parameter_pack_validation.h"
 #include "google/cloud/storage/internal/policy_document_request.h"
+#include "google/cloud/storage/internal/prefetching_page_loader.h"
 #include "google/cloud/storage/internal/retry_client.h"
 #include "google/cloud/storage/internal/signed_url_requests.h"
 #include "google/cloud/storage/internal/tuple_filter.h"
@@ -247,6 +251,18 @@ class Client {
     return raw_client_;
   }
 
+  /**
+   * Returns the counters for the connections used by this client.
+   *
+   * Use these counters to tune `ClientOptions::set_connection_pool_size()`,
+   * `set_connection_pool_warmup_size()` and
+   * `set_connection_pool_idle_timeout()`. All the counters are zero if the
+   * client does not use the REST transport.
+   */
+  ConnectionPoolStats connection_pool_stats() const {
+    return raw_client_->connection_pool_stats();
+  }
+
   //@{
   /**
    * @name Bucket operations.
@@ -984,7 +1000,7 @@ class Client {
    * @param options a list of optional query parameters and/or request headers.
    *     Valid types for this operation include
    *     `IfMetagenerationMatch`, `IfMetagenerationNotMatch`, `UserProject`,
-   *     `Projection`, `Prefix`, `Delimiter`, and `Versions`.
+   *     `Projection`, `Prefix`, `Delimiter`, `Versions`, and `PrefetchPages`.
    *
    * @par Idempotency
    * This is a read-only operation and is always idempotent.
@@ -998,10 +1014,18 @@ class Client {
     internal::ListObjectsRequest request(bucket_name);
     request.set_multiple_options(std::forward<Options>(options)...);
     auto client = raw_client_;
-    return ListObjectsReader(request,
-                             [client](internal::ListObjectsRequest const& r) {
-                               return client->ListObjects(r);
-                             });
+    std::function<StatusOr<internal::ListObjectsResponse>(
+        internal::ListObjectsRequest const&)>
+        loader = [client](internal::ListObjectsRequest const& r) {
+          return client->ListObjects(r);
+        };
+    if (request.HasOption<PrefetchPages>() &&
+        request.GetOption<PrefetchPages>().value() != 0) {
+      loader = internal::PrefetchingPageLoader<internal::ListObjectsRequest,
+                                               internal::ListObjectsResponse>(
+          std::move(loader), request.GetOption<PrefetchPages>().value());
+    }
+    return ListObjectsReader(std::move(request), std::move(loader));
   }
 
   /**
@@ -3011,8 +3035,20 @@ class Client {
     if (client->client_options().enable_raw_client_tracing()) {
       client = std::make_shared<internal::LoggingClient>(std::move(client));
     }
+    if (auto hedging = client->client_options().hedging_policy()) {
+      client = std::make_shared<internal::HedgingClient>(
+          std::move(client), std::move(hedging), policies...);
+    }
     auto retry = std::make_shared<internal::RetryClient>(
         std::move(client), std::forward<Policies>(policies)...);
+    auto const& options = retry->client_options();
+    if (!options.object_cache_directory().empty()) {
+      auto cache = std::make_shared<internal::ObjectCache>(
+          options.object_cache_directory(), options.object_cache_size());
+      return std::make_shared<internal::CachingClient>(
+          std::move(retry), std::move(cache),
+          options.maximum_cached_object_size());
+    }
     return retry;
   }
 
@@ -3172,6 +3208,66 @@ StatusOr<ObjectMetadata> LockPrefix(Client& client,
               std::forward_as_tuple(std::forward<Options>(options)...))));
 }
 
+/// Deletes the objects using batch requests, see `DeleteObjects()`.
+std::vector<Status> DeleteObjectsImpl(
+    RawClient& client, std::vector<DeleteObjectRequest> const& requests);
+
+}  // namespace internal
+
+/**
+ * Delete many objects using batch requests.
+ *
+ * This function packs up to 100 deletions into a single HTTP request, which
+ * is much faster than calling `Client::DeleteObject()` for each object. Each
+ * object is deleted only if its generation matches the value in @p objects.
+ *
+ * @param client the client on which to perform the operation.
+ * @param bucket_name the name of the bucket that contains the objects.
+ * @param objects the name and generation of the objects to delete.
+ * @param options a list of optional query parameters and/or request headers.
+ *     Valid types for this operation include `QuotaUser`, `UserIp` and
+ *     `UserProject`.
+ * @return the result of each deletion, in the same order as @p objects.
+ *
+ * @par Idempotency
+ * Each deletion is idempotent because it is restricted to one generation of
+ * the object. Only the deletions that fail with transient errors are retried.
+ */
+template <typename... Options>
+std::vector<Status> DeleteObjects(
+    Client& client, std::string const& bucket_name,
+    std::vector<std::pair<std::string, std::int64_t>> const& objects,
+    Options&&... options) {
+  using Unsupported = internal::NotAmong<QuotaUser, UserIp, UserProject>;
+  static_assert(
+      std::tuple_size<decltype(internal::StaticTupleFilter<Unsupported::TPred>(
+          std::tie(options...)))>::value == 0,
+      "This functions accepts only options of type QuotaUser, UserIp or "
+      "UserProject.");
+  std::vector<internal::DeleteObjectRequest> requests;
+  requests.reserve(objects.size());
+  for (auto const& object : objects) {
+    internal::DeleteObjectRequest request(bucket_name, object.first);
+    request.set_multiple_options(IfGenerationMatch(object.second), options...);
+    requests.push_back(std::move(request));
+  }
+  return internal::DeleteObjectsImpl(*client.raw_client(), requests);
+}
+
+namespace internal {
+
+// Just a wrapper to allow for use in `google::cloud::internal::apply`.
+struct DeleteObjectsApplyHelper {
+  template <typename... Options>
+  std::vector<Status> operator()(Options... options) const {
+    return DeleteObjects(client, bucket_name, objects, std::move(options)...);
+  }
+
+  Client& client;
+  std::string bucket_name;
+  std::vector<std::pair<std::string, std::int64_t>> objects;
+};
+
 }  // namespace internal
 
 /**
@@ -3199,24 +3295,32 @@ Status DeleteByPrefix(Client& client, std::string const& bucket_name,
                   all_options))>::value == 0,
       "This functions accepts only options of type QuotaUser, UserIp, "
       "UserProject or Versions.");
-  for (auto const& object :
-       client.ListObjects(bucket_name, Projection::NoAcl(), Prefix(prefix),
-                          std::forward<Options>(options)...)) {
+  std::vector<std::pair<std::string, std::int64_t>> objects;
+  auto delete_objects = [&]() -> Status {
+    auto results = google::cloud::internal::apply(
+        internal::DeleteObjectsApplyHelper{client, bucket_name,
+                                           std::move(objects)},
+        StaticTupleFilter<NotAmong<Versions>::TPred>(all_options));
+    objects.clear();
+    for (auto& status : results) {
+      if (!status.ok()) return std::move(status);
+    }
+    return Status();
+  };
+  // The options are also used in the deletions, they cannot be moved.
+  for (auto const& object : client.ListObjects(
+           bucket_name, Projection::NoAcl(), Prefix(prefix), options...)) {
     if (!object) {
       return object.status();
     }
-
-    auto deletion_status = google::cloud::internal::apply(
-        internal::DeleteApplyHelper{client, bucket_name, object->name()},
-        std::tuple_cat(
-            std::make_tuple(IfGenerationMatch(object->generation())),
-            StaticTupleFilter<NotAmong<Versions>::TPred>(all_options)));
-
-    if (!deletion_status.ok()) {
-      return deletion_status;
+    objects.emplace_back(object->name(), object->generation());
+    if (objects.size() < internal::BatchRequest::kMaxBatchSize) continue;
+    auto status = delete_objects();
+    if (!status.ok()) {
+      return status;
     }
   }
-  return Status();
+  return delete_objects();
 }
 
 namespace internal {
@@ -3243,6 +3347,11 @@ class ScopedDeleter {
   // so we abstract this away by providing the function to delete one object.
   // NOLINTNEXTLINE(google-explicit-constructor)
   ScopedDeleter(std::function<Status(std::string, std::int64_t)> delete_fun);
+  // Delete the objects in batches, the function returns the result of each
+  // deletion.
+  using BatchDeleteFunction = std::function<std::vector<Status>(
+      std::vector<std::pair<std::string, std::int64_t>>)>;
+  explicit ScopedDeleter(BatchDeleteFunction batch_delete_fun);
   ScopedDeleter(ScopedDeleter const&) = delete;
   ScopedDeleter& operator=(ScopedDeleter const&) = delete;
   ~ScopedDeleter();
@@ -3261,9 +3370,48 @@ class ScopedDeleter {
  private:
   bool enabled_;
   std::function<Status(std::string, std::int64_t)> delete_fun_;
+  BatchDeleteFunction batch_delete_fun_;
   std::vector<std::pair<std::string, std::int64_t>> object_list_;
 };
 
+/**
+ * Calls `task(i)` for each `i` in `[0, count)`, using up to `max_concurrency`
+ * threads, including the calling thread.
+ *
+ * No new tasks are started once any task returns `false`, the function returns
+ * after all the tasks already started complete.
+ */
+void RunConcurrently(std::size_t count, std::size_t max_concurrency,
+                     std::function<bool(std::size_t)> const& task);
+
+}  // namespace internal
+
+/**
+ * A parameter type indicating the maximum number of concurrent compose
+ * requests in `ComposeMany`.
+ */
+class MaxConcurrentComposes {
+ public:
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  MaxConcurrentComposes(std::size_t value) : value_(value) {}
+  std::size_t value() const { return value_; }
+
+ private:
+  std::size_t value_;
+};
+
+namespace internal {
+inline MaxConcurrentComposes FirstMaxConcurrentComposes(
+    MaxConcurrentComposes default_value, std::tuple<> const&) {
+  return default_value;
+}
+
+template <typename... Tail>
+MaxConcurrentComposes FirstMaxConcurrentComposes(
+    MaxConcurrentComposes const&,
+    std::tuple<MaxConcurrentComposes, Tail...> const& options) {
+  return std::get<0>(options);
+}
 }  // namespace internal
 
 /**
@@ -3274,6 +3422,10 @@ class ScopedDeleter {
  *
  * The implementation may need to perform multiple Client::ComposeObject calls
  * to create intermediate, temporary objects which are then further composed.
+ * The source objects are split in balanced groups of at most 32 objects, and
+ * the temporary objects for each level of this composition tree are created
+ * concurrently. Use the `MaxConcurrentComposes` option to limit the number of
+ * concurrent requests, it defaults to 16.
  * Due to the lack of atomicity of this series of operations, stray temporary
  * objects might be left over if there are transient failuers. In order to allow
  * the user to easily control for such situations, the user is expected to
@@ -3298,13 +3450,14 @@ class ScopedDeleter {
  * @param options a list of optional query parameters and/or request headers.
  *     Valid types for this operation include `DestinationPredefinedAcl`,
  *     `EncryptionKey`, `IfGenerationMatch`, `IfMetagenerationMatch`
- *     `KmsKeyName`, `QuotaUser`, `UserIp`, `UserProject` and
- *     `WithObjectMetadata`.
+ *     `KmsKeyName`, `MaxConcurrentComposes`, `QuotaUser`, `UserIp`,
+ *     `UserProject` and `WithObjectMetadata`.
  *
  * @par Idempotency
  * This operation is not idempotent. While each request performed by this
  * function is retried based on the client policies, the operation itself stops
- * on the first request that fails.
+ * on the first request that fails. Requests already in progress when a request
+ * fails are allowed to complete, and their temporary objects are deleted.
  *
  * @par Example
  * @snippet storage_object_samples.cc compose object from many
@@ -3325,29 +3478,38 @@ StatusOr<ObjectMetadata> ComposeMany(
                   "ComposeMany requires at least one source object.");
   }
 
-  auto all_options = std::make_tuple(options...);
-
   // TODO(#3247): this list of type should somehow be generated
   static_assert(
       std::tuple_size<decltype(
               StaticTupleFilter<NotAmong<
                   DestinationPredefinedAcl, EncryptionKey, IfGenerationMatch,
-                  IfMetagenerationMatch, KmsKeyName, QuotaUser, UserIp,
-                  UserProject, WithObjectMetadata>::TPred>(
-                  all_options))>::value == 0,
+                  IfMetagenerationMatch, KmsKeyName, MaxConcurrentComposes,
+                  QuotaUser, UserIp, UserProject, WithObjectMetadata>::TPred>(
+                  std::make_tuple(options...)))>::value == 0,
       "This functions accepts only options of type DestinationPredefinedAcl, "
       "EncryptionKey, IfGenerationMatch, IfMetagenerationMatch, KmsKeyName, "
-      "QuotaUser, UserIp, UserProject or WithObjectMetadata.");
-
-  internal::ScopedDeleter deleter(
-      [&](std::string const& object_name, std::int64_t generation) {
+      "MaxConcurrentComposes, QuotaUser, UserIp, UserProject or "
+      "WithObjectMetadata.");
+
+  MaxConcurrentComposes const default_max_concurrent_composes(16);
+  auto const max_concurrent_composes =
+      internal::FirstMaxConcurrentComposes(
+          default_max_concurrent_composes,
+          StaticTupleFilter<Among<MaxConcurrentComposes>::TPred>(
+              std::make_tuple(options...)))
+          .value();
+  auto all_options =
+      StaticTupleFilter<NotAmong<MaxConcurrentComposes>::TPred>(
+          std::make_tuple(options...));
+
+  internal::ScopedDeleter deleter(internal::ScopedDeleter::BatchDeleteFunction(
+      [&](std::vector<std::pair<std::string, std::int64_t>> objects) {
         return google::cloud::internal::apply(
-            internal::DeleteApplyHelper{client, bucket_name, object_name},
-            std::tuple_cat(
-                std::make_tuple(IfGenerationMatch(generation)),
-                StaticTupleFilter<Among<QuotaUser, UserProject, UserIp>::TPred>(
-                    all_options)));
-      });
+            internal::DeleteObjectsApplyHelper{client, bucket_name,
+                                               std::move(objects)},
+            StaticTupleFilter<Among<QuotaUser, UserProject, UserIp>::TPred>(
+                all_options));
+      }));
 
   auto lock = internal::LockPrefix(client, bucket_name, prefix, "",
                                    std::make_tuple(options...));
@@ -3372,19 +3534,21 @@ StatusOr<ObjectMetadata> ComposeMany(
     return sources;
   };
 
-  auto composer = [&](std::vector<ComposeSourceObject> compose_range,
-                      bool is_final) -> StatusOr<ObjectMetadata> {
-    if (is_final) {
-      return google::cloud::internal::apply(
-          internal::ComposeApplyHelper{client, bucket_name,
-                                       std::move(compose_range),
-                                       std::move(destination_object_name)},
-          std::tuple_cat(std::make_tuple(IfGenerationMatch(0)), all_options));
-    }
+  auto compose_final = [&](std::vector<ComposeSourceObject> compose_range) {
+    return google::cloud::internal::apply(
+        internal::ComposeApplyHelper{client, bucket_name,
+                                     std::move(compose_range),
+                                     std::move(destination_object_name)},
+        std::tuple_cat(std::make_tuple(IfGenerationMatch(0)), all_options));
+  };
+
+  // Called concurrently, it must not modify any of the captured variables.
+  auto compose_tmp = [&](std::vector<ComposeSourceObject> compose_range,
+                         std::string object_name) {
     return google::cloud::internal::apply(
         internal::ComposeApplyHelper{client, bucket_name,
                                      std::move(compose_range),
-                                     tmpobject_name_gen()},
+                                     std::move(object_name)},
         StaticTupleFilter<
             NotAmong<IfGenerationMatch, IfMetagenerationMatch>::TPred>(
             all_options));
@@ -3392,27 +3556,53 @@ StatusOr<ObjectMetadata> ComposeMany(
 
   auto reduce = [&](std::vector<ComposeSourceObject> source_objects)
       -> StatusOr<std::vector<ObjectMetadata>> {
+    if (source_objects.size() <= max_num_objects) {
+      auto object = compose_final(std::move(source_objects));
+      if (!object) return std::move(object).status();
+      return std::vector<ObjectMetadata>{*std::move(object)};
+    }
+
+    // Use the fewest groups possible, with sizes as even as possible, this
+    // keeps the composition tree balanced. The temporary object names are
+    // assigned before any request starts, so they do not depend on the order
+    // in which the requests complete.
+    auto const source_count = source_objects.size();
+    auto const group_count = (source_count + max_num_objects - 1) /
+                             max_num_objects;
+    std::vector<std::vector<ComposeSourceObject>> groups(group_count);
+    std::vector<std::string> names(group_count);
+    auto range_begin = source_objects.begin();
+    for (std::size_t i = 0; i != group_count; ++i) {
+      auto const range_size = source_count / group_count +
+                              (i < source_count % group_count ? 1 : 0);
+      auto range_end =
+          std::next(range_begin, static_cast<std::ptrdiff_t>(range_size));
+      groups[i].assign(std::make_move_iterator(range_begin),
+                       std::make_move_iterator(range_end));
+      names[i] = tmpobject_name_gen();
+      range_begin = range_end;
+    }
+
+    std::vector<StatusOr<ObjectMetadata>> results(group_count);
+    internal::RunConcurrently(
+        group_count, max_concurrent_composes, [&](std::size_t i) {
+          results[i] = compose_tmp(std::move(groups[i]), std::move(names[i]));
+          return results[i].ok();
+        });
+
+    // Groups are started in order, any group that did not start comes after
+    // the group that failed.
+    Status status;
     std::vector<ObjectMetadata> objects;
-    for (auto range_begin = source_objects.begin();
-         range_begin != source_objects.end();) {
-      std::size_t range_size = std::min<std::size_t>(
-          std::distance(range_begin, source_objects.end()), max_num_objects);
-      auto range_end = std::next(range_begin, range_size);
-      std::vector<ComposeSourceObject> compose_range(range_size);
-      std::move(range_begin, range_end, compose_range.begin());
-
-      bool const is_final_composition =
-          source_objects.size() <= max_num_objects;
-      auto object = composer(std::move(compose_range), is_final_composition);
-      if (!object) {
-        return std::move(object).status();
+    for (auto& r : results) {
+      if (!r) {
+        if (status.ok()) status = std::move(r).status();
+        continue;
       }
-      objects.push_back(*std::move(object));
-      if (!is_final_composition) {
-        deleter.Add(objects.back());
-      }
-      range_begin = range_end;
+      deleter.Add(*r);
+      objects.push_back(*std::move(r));
     }
+    if (!status.ok()) return status;
     return objects;
   };
 
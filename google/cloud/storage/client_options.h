@@ -15,8 +15,11 @@
 #ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_CLIENT_OPTIONS_H
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_CLIENT_OPTIONS_H
 
+#include "google/cloud/storage/hedging_policy.h"
 #include "google/cloud/storage/oauth2/credentials.h"
+#include "google/cloud/storage/transport_routing_policy.h"
 #include "google/cloud/storage/version.h"
+#include <cstdint>
 #include <memory>
 
 namespace google {
@@ -133,6 +136,50 @@ class ClientOptions {
     return *this;
   }
 
+  //@{
+  /**
+   * Control how many connections are established when the client is created.
+   *
+   * Without warm-up the first requests after creating a client pay for the
+   * TCP and TLS handshakes. With a non-zero value the client establishes this
+   * many connections (capped by `connection_pool_size()`) to the endpoint in
+   * a background thread, the constructor does not wait for them. Requests
+   * issued before the warm-up completes create their own connections.
+   * Destroying the client cancels the warm-up, which takes at most about a
+   * second. Failures to connect are not errors, the connections are simply
+   * created on demand, `Client::connection_pool_stats()` reports them.
+   *
+   * The default value is 0, which disables the warm-up.
+   */
+  std::size_t connection_pool_warmup_size() const {
+    return connection_pool_warmup_size_;
+  }
+  ClientOptions& set_connection_pool_warmup_size(std::size_t v) {
+    connection_pool_warmup_size_ = v;
+    return *this;
+  }
+  //@}
+
+  //@{
+  /**
+   * Control how long unused connections are kept in the connection pool.
+   *
+   * Servers and load balancers close idle connections, reusing one of them
+   * fails or requires a new handshake anyway. Connections that are unused for
+   * longer than this value are closed the next time a connection is needed.
+   *
+   * The default value is 0, which keeps idle connections until the pool is
+   * full.
+   */
+  std::chrono::seconds connection_pool_idle_timeout() const {
+    return connection_pool_idle_timeout_;
+  }
+  ClientOptions& set_connection_pool_idle_timeout(std::chrono::seconds v) {
+    connection_pool_idle_timeout_ = v;
+    return *this;
+  }
+  //@}
+
   std::size_t download_buffer_size() const { return download_buffer_size_; }
   ClientOptions& SetDownloadBufferSize(std::size_t size);
 
@@ -195,6 +242,48 @@ class ClientOptions {
     return *this;
   }
 
+  //@{
+  /**
+   * Control the number of background threads used for asynchronous operations.
+   *
+   * Each background thread runs an event loop that can drive many concurrent
+   * transfers. The threads are only created if the application uses the
+   * asynchronous APIs, see `storage_experimental::AsyncClient`.
+   *
+   * The default value is 1.
+   */
+  std::size_t background_thread_pool_size() const {
+    return background_thread_pool_size_;
+  }
+  ClientOptions& set_background_thread_pool_size(std::size_t v) {
+    background_thread_pool_size_ = v;
+    return *this;
+  }
+  //@}
+
+  //@{
+  /**
+   * Control how many upload buffers can be queued behind `WriteObject()`.
+   *
+   * By default `ObjectWriteStream` uploads each full buffer before it accepts
+   * more data, so the throughput is bounded by the buffer size divided by the
+   * round-trip time. With a non-zero value the stream uploads full buffers in a
+   * background thread, while the application fills the next buffer. At most
+   * this many full buffers are queued, each `upload_buffer_size()` bytes.
+   *
+   * The chunks of a resumable upload are still sent one at a time and in
+   * order, the service rejects chunks that do not start at the next expected
+   * byte.
+   *
+   * The default value is 0, which disables the background uploads.
+   */
+  std::size_t upload_pipeline_depth() const { return upload_pipeline_depth_; }
+  ClientOptions& set_upload_pipeline_depth(std::size_t v) {
+    upload_pipeline_depth_ = v;
+    return *this;
+  }
+  //@}
+
   ChannelOptions& channel_options() { return channel_options_; }
   ChannelOptions const& channel_options() const { return channel_options_; }
 
@@ -217,6 +306,130 @@ class ClientOptions {
   }
   //@}
 
+  //@{
+  /**
+   * Enable adaptive tuning of the transfer buffers and upload chunk sizes.
+   *
+   * The best buffer sizes depend on the bandwidth and round-trip time of the
+   * network path. When enabled, the client measures the throughput and RTT of
+   * each transfer, and uses these measurements to size the libcurl receive
+   * buffer (`CURLOPT_BUFFERSIZE`), the socket buffers in new connections, and
+   * the chunks of new resumable uploads.
+   *
+   * The chunk sizes stay between `upload_buffer_size()` and
+   * `maximum_adaptive_upload_buffer_size()`. The socket buffers are only tuned
+   * if `maximum_socket_recv_size()` or `maximum_socket_send_size()` are 0.
+   *
+   * The default value is `false`.
+   */
+  bool enable_adaptive_transfer_tuning() const {
+    return enable_adaptive_transfer_tuning_;
+  }
+  ClientOptions& set_enable_adaptive_transfer_tuning(bool v) {
+    enable_adaptive_transfer_tuning_ = v;
+    return *this;
+  }
+
+  std::size_t maximum_adaptive_upload_buffer_size() const {
+    return maximum_adaptive_upload_buffer_size_;
+  }
+  ClientOptions& set_maximum_adaptive_upload_buffer_size(std::size_t v) {
+    maximum_adaptive_upload_buffer_size_ = v;
+    return *this;
+  }
+  //@}
+
+  //@{
+  /**
+   * Control how a client using both REST and gRPC picks the transport.
+   *
+   * Only the clients created by `storage_experimental::DefaultGrpcClient()`
+   * use this policy, and only for the operations implemented by both
+   * transports. Use `LatencyRoutingPolicy` to send each call to the transport
+   * with the best observed latency and throughput, the policy also counts its
+   * decisions. Applications can also implement their own
+   * `TransportRoutingPolicy`.
+   *
+   * The default value is `nullptr`, which sends media operations to gRPC and
+   * all other operations to REST.
+   */
+  std::shared_ptr<TransportRoutingPolicy> transport_routing_policy() const {
+    return transport_routing_policy_;
+  }
+  ClientOptions& set_transport_routing_policy(
+      std::shared_ptr<TransportRoutingPolicy> v) {
+    transport_routing_policy_ = std::move(v);
+    return *this;
+  }
+  //@}
+
+  //@{
+  /**
+   * Cache the contents of small objects in a local directory.
+   *
+   * When `object_cache_directory()` is not empty, `Client::ReadObject()` keeps
+   * a copy of each object up to `maximum_cached_object_size()` bytes in this
+   * directory, and serves later reads of the same object generation (including
+   * ranged reads) from the local copy. Each read still fetches the object
+   * metadata, so the latest generation is always returned, and any
+   * preconditions in the request are validated by the service. Reads of
+   * objects using customer-supplied encryption keys are never cached.
+   *
+   * The least recently used objects are removed when the cache is larger than
+   * `object_cache_size()`. Several processes may share the same directory.
+   *
+   * The default value is an empty string, which disables the cache.
+   */
+  std::string const& object_cache_directory() const {
+    return object_cache_directory_;
+  }
+  ClientOptions& set_object_cache_directory(std::string v) {
+    object_cache_directory_ = std::move(v);
+    return *this;
+  }
+
+  std::uint64_t object_cache_size() const { return object_cache_size_; }
+  ClientOptions& set_object_cache_size(std::uint64_t v) {
+    object_cache_size_ = v;
+    return *this;
+  }
+
+  std::uint64_t maximum_cached_object_size() const {
+    return maximum_cached_object_size_;
+  }
+  ClientOptions& set_maximum_cached_object_size(std::uint64_t v) {
+    maximum_cached_object_size_ = v;
+    return *this;
+  }
+  //@}
+
+  //@{
+  /**
+   * Hedge the `ReadObject()` and `GetObjectMetadata()` requests.
+   *
+   * A few requests may be served by slow backends, and take much longer than
+   * the median. When a policy is set, the client sends a duplicate request if
+   * the original takes longer than a percentile of the recent latencies, and
+   * uses whichever request completes first. Only idempotent requests, as
+   * defined by the `IdempotencyPolicy`, are hedged, and the policy limits the
+   * fraction of calls that send a duplicate request. Use
+   * `HedgingPolicy::Counters()` to monitor the policy.
+   *
+   * Hedging is most effective for small objects, where most of the time is
+   * spent waiting for the first byte. The duplicate requests run in background
+   * threads.
+   *
+   * The default value is `nullptr`, which disables hedging.
+   */
+  std::shared_ptr<HedgingPolicy> hedging_policy() const {
+    return hedging_policy_;
+  }
+  ClientOptions& set_hedging_policy(std::shared_ptr<HedgingPolicy> v) {
+    hedging_policy_ = std::move(v);
+    return *this;
+  }
+  //@}
+
  private:
   void SetupFromEnvironment();
 
@@ -228,6 +441,8 @@ class ClientOptions {
   bool enable_raw_client_tracing_;
   std::string project_id_;
   std::size_t connection_pool_size_;
+  std::size_t connection_pool_warmup_size_ = 0;
+  std::chrono::seconds connection_pool_idle_timeout_{0};
   std::size_t download_buffer_size_;
   std::size_t upload_buffer_size_;
   std::string user_agent_prefix_;
@@ -237,6 +452,15 @@ class ClientOptions {
   std::size_t maximum_socket_recv_size_ = 0;
   std::size_t maximum_socket_send_size_ = 0;
   std::chrono::seconds download_stall_timeout_;
+  std::size_t background_thread_pool_size_ = 1;
+  std::size_t upload_pipeline_depth_ = 0;
+  bool enable_adaptive_transfer_tuning_ = false;
+  std::size_t maximum_adaptive_upload_buffer_size_ = 64 * 1024 * 1024L;
+  std::shared_ptr<TransportRoutingPolicy> transport_routing_policy_;
+  std::string object_cache_directory_;
+  std::uint64_t object_cache_size_ = 1024 * 1024 * 1024L;
+  std::uint64_t maximum_cached_object_size_ = 64 * 1024 * 1024L;
+  std::shared_ptr<HedgingPolicy> hedging_policy_;
   ChannelOptions channel_options_;
 };
 }  // namespace STORAGE_CLIENT_NS
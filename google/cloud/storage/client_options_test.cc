@@ -188,6 +188,71 @@ TEST_F(ClientOptionsTest, SetMaximumDownloadStall) {
   EXPECT_EQ(60, client_options.download_stall_timeout().count());
 }
 
+TEST_F(ClientOptionsTest, SetBackgroundThreadPoolSize) {
+  ClientOptions client_options(oauth2::CreateAnonymousCredentials());
+  EXPECT_EQ(1, client_options.background_thread_pool_size());
+  client_options.set_background_thread_pool_size(4);
+  EXPECT_EQ(4, client_options.background_thread_pool_size());
+}
+
+TEST_F(ClientOptionsTest, SetConnectionPoolWarmup) {
+  ClientOptions client_options(oauth2::CreateAnonymousCredentials());
+  EXPECT_EQ(0, client_options.connection_pool_warmup_size());
+  EXPECT_EQ(0, client_options.connection_pool_idle_timeout().count());
+  client_options.set_connection_pool_warmup_size(8)
+      .set_connection_pool_idle_timeout(std::chrono::seconds(30));
+  EXPECT_EQ(8, client_options.connection_pool_warmup_size());
+  EXPECT_EQ(30, client_options.connection_pool_idle_timeout().count());
+}
+
+TEST_F(ClientOptionsTest, SetUploadPipelineDepth) {
+  ClientOptions client_options(oauth2::CreateAnonymousCredentials());
+  EXPECT_EQ(0, client_options.upload_pipeline_depth());
+  client_options.set_upload_pipeline_depth(3);
+  EXPECT_EQ(3, client_options.upload_pipeline_depth());
+}
+
+TEST_F(ClientOptionsTest, SetAdaptiveTransferTuning) {
+  ClientOptions client_options(oauth2::CreateAnonymousCredentials());
+  EXPECT_FALSE(client_options.enable_adaptive_transfer_tuning());
+  EXPECT_EQ(64 * 1024 * 1024L,
+            client_options.maximum_adaptive_upload_buffer_size());
+  client_options.set_enable_adaptive_transfer_tuning(true)
+      .set_maximum_adaptive_upload_buffer_size(16 * 1024 * 1024L);
+  EXPECT_TRUE(client_options.enable_adaptive_transfer_tuning());
+  EXPECT_EQ(16 * 1024 * 1024L,
+            client_options.maximum_adaptive_upload_buffer_size());
+}
+
+TEST_F(ClientOptionsTest, SetTransportRoutingPolicy) {
+  ClientOptions client_options(oauth2::CreateAnonymousCredentials());
+  EXPECT_FALSE(client_options.transport_routing_policy());
+  auto policy = std::make_shared<LatencyRoutingPolicy>();
+  client_options.set_transport_routing_policy(policy);
+  EXPECT_EQ(policy, client_options.transport_routing_policy());
+}
+
+TEST_F(ClientOptionsTest, SetObjectCache) {
+  ClientOptions client_options(oauth2::CreateAnonymousCredentials());
+  EXPECT_TRUE(client_options.object_cache_directory().empty());
+  EXPECT_EQ(1024 * 1024 * 1024L, client_options.object_cache_size());
+  EXPECT_EQ(64 * 1024 * 1024L, client_options.maximum_cached_object_size());
+  client_options.set_object_cache_directory("/tmp/cache")
+      .set_object_cache_size(1024)
+      .set_maximum_cached_object_size(128);
+  EXPECT_EQ("/tmp/cache", client_options.object_cache_directory());
+  EXPECT_EQ(1024, client_options.object_cache_size());
+  EXPECT_EQ(128, client_options.maximum_cached_object_size());
+}
+
+TEST_F(ClientOptionsTest, SetHedgingPolicy) {
+  ClientOptions client_options(oauth2::CreateAnonymousCredentials());
+  EXPECT_FALSE(client_options.hedging_policy());
+  auto policy = std::make_shared<HedgingPolicy>();
+  client_options.set_hedging_policy(policy);
+  EXPECT_EQ(policy, client_options.hedging_policy());
+}
+
 }  // namespace
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
@@ -168,6 +168,67 @@ TEST_F(ClientTest, LoggingDecorators) {
   ASSERT_TRUE(curl != nullptr);
 }
 
+/// @test Verify the constructor creates the right set of RawClient decorations.
+TEST_F(ClientTest, CachingDecorators) {
+  // Create a client, use the anonymous credentials because on the CI
+  // environment there may not be other credentials configured.
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  options.set_object_cache_directory(::testing::TempDir());
+  Client tested(options);
+
+  EXPECT_TRUE(tested.raw_client() != nullptr);
+  auto caching =
+      dynamic_cast<internal::CachingClient*>(tested.raw_client().get());
+  ASSERT_TRUE(caching != nullptr);
+
+  auto retry = dynamic_cast<internal::RetryClient*>(caching->client().get());
+  ASSERT_TRUE(retry != nullptr);
+
+  auto curl = dynamic_cast<internal::CurlClient*>(retry->client().get());
+  ASSERT_TRUE(curl != nullptr);
+}
+
+/// @test Verify the constructor creates the right set of RawClient decorations.
+TEST_F(ClientTest, HedgingDecorators) {
+  // Create a client, use the anonymous credentials because on the CI
+  // environment there may not be other credentials configured.
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  options.set_hedging_policy(std::make_shared<HedgingPolicy>());
+  Client tested(options);
+
+  EXPECT_TRUE(tested.raw_client() != nullptr);
+  auto retry = dynamic_cast<internal::RetryClient*>(tested.raw_client().get());
+  ASSERT_TRUE(retry != nullptr);
+
+  auto hedging =
+      dynamic_cast<internal::HedgingClient*>(retry->client().get());
+  ASSERT_TRUE(hedging != nullptr);
+
+  auto curl = dynamic_cast<internal::CurlClient*>(hedging->client().get());
+  ASSERT_TRUE(curl != nullptr);
+}
+
+/// @test Verify the connection pool counters are forwarded by all decorators.
+TEST_F(ClientTest, ConnectionPoolStats) {
+  auto const mock_options =
+      ClientOptions(oauth2::CreateAnonymousCredentials())
+          .set_enable_raw_client_tracing(true)
+          .set_hedging_policy(std::make_shared<HedgingPolicy>())
+          .set_object_cache_directory(::testing::TempDir());
+  EXPECT_CALL(*mock_, client_options()).WillRepeatedly(ReturnRef(mock_options));
+  ConnectionPoolStats stats;
+  stats.handles_created = 3;
+  stats.handles_reused = 7;
+  stats.idle_handles.resize(2);
+  EXPECT_CALL(*mock_, connection_pool_stats()).WillOnce(Return(stats));
+  Client client{std::shared_ptr<internal::RawClient>(mock_)};
+
+  auto actual = client.connection_pool_stats();
+  EXPECT_EQ(3, actual.handles_created);
+  EXPECT_EQ(7, actual.handles_reused);
+  EXPECT_EQ(2, actual.idle_handles.size());
+}
+
 }  // namespace
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
@@ -101,6 +101,49 @@ TEST_F(WriteObjectTest, WriteObject) {
   EXPECT_EQ(expected, actual);
 }
 
+TEST_F(WriteObjectTest, WriteObjectPipelined) {
+  auto const quantum = internal::UploadChunkRequest::kChunkSizeQuantum;
+  client_options_.SetUploadBufferSize(quantum).set_upload_pipeline_depth(2);
+  std::string const payload = std::string(3 * quantum, 'A') + "trailer";
+
+  auto received = std::make_shared<std::string>();
+  EXPECT_CALL(*mock_, CreateResumableSession(_))
+      .WillOnce(Invoke([received](internal::ResumableUploadRequest const&) {
+        auto mock = absl::make_unique<testing::MockResumableUploadSession>();
+        using internal::ResumableUploadResponse;
+        EXPECT_CALL(*mock, done()).WillRepeatedly(Return(false));
+        EXPECT_CALL(*mock, next_expected_byte())
+            .WillRepeatedly(Invoke([received] { return received->size(); }));
+        EXPECT_CALL(*mock, UploadChunk(_))
+            .Times(3)
+            .WillRepeatedly(
+                Invoke([received](internal::ConstBufferSequence const& p) {
+                  *received += internal::ToString(p);
+                  return make_status_or(ResumableUploadResponse{
+                      "fake-url", received->size() - 1, {},
+                      ResumableUploadResponse::kInProgress, {}});
+                }));
+        EXPECT_CALL(*mock, UploadFinalChunk(_, _))
+            .WillOnce(Invoke([received](internal::ConstBufferSequence const& p,
+                                        std::uint64_t) {
+              *received += internal::ToString(p);
+              return make_status_or(ResumableUploadResponse{
+                  "fake-url", received->size() - 1, ObjectMetadata{},
+                  ResumableUploadResponse::kDone, {}});
+            }));
+
+        return make_status_or(
+            std::unique_ptr<internal::ResumableUploadSession>(
+                std::move(mock)));
+      }));
+
+  auto stream = client_->WriteObject("test-bucket-name", "test-object-name");
+  stream << payload;
+  stream.Close();
+  ASSERT_STATUS_OK(stream.metadata());
+  EXPECT_EQ(payload, *received);
+}
+
 TEST_F(WriteObjectTest, WriteObjectTooManyFailures) {
   Client client{std::shared_ptr<internal::RawClient>(mock_),
                 LimitedErrorCountRetryPolicy(2),
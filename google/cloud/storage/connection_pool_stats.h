@@ -0,0 +1,69 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_CONNECTION_POOL_STATS_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_CONNECTION_POOL_STATS_H
+
+#include "google/cloud/storage/version.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+
+/// Counters for a single pooled connection.
+struct PooledConnectionStats {
+  /// The number of times the connection was taken from the pool.
+  std::uint64_t reuse_count = 0;
+  /// The number of new connections created by the transfers using the handle.
+  std::uint64_t connection_count = 0;
+  /// The total time spent in TCP and TLS handshakes for those connections.
+  std::chrono::microseconds handshake_time{0};
+};
+
+/**
+ * Counters for the connections used by a `Client`.
+ *
+ * Use `Client::connection_pool_stats()` to get these counters. They are
+ * aggregated over all the connection pools used by the client, and they are
+ * always zero for clients that do not use the REST transport.
+ */
+struct ConnectionPoolStats {
+  std::uint64_t handles_created = 0;
+  std::uint64_t handles_reused = 0;
+  /// Handles released because they were idle for too long.
+  std::uint64_t handles_expired = 0;
+  /// Handles released because the pool was full.
+  std::uint64_t handles_overflowed = 0;
+  /// Handles released because their last transfer did not get a response.
+  std::uint64_t transfer_failures = 0;
+  /// Connections that could not be established by the warm-up.
+  std::uint64_t warmup_failures = 0;
+  /// The number of new connections created by all the transfers.
+  std::uint64_t connection_count = 0;
+  /// The total time spent in TCP and TLS handshakes for those connections.
+  std::chrono::microseconds handshake_time{0};
+  /// The counters for each connection in the pool, i.e., not in use.
+  std::vector<PooledConnectionStats> idle_handles;
+};
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_CONNECTION_POOL_STATS_H
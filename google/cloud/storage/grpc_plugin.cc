@@ -23,11 +23,17 @@ namespace storage_experimental {
 inline namespace STORAGE_CLIENT_NS {
 
 namespace {
+std::string GrpcConfig() {
+  return google::cloud::internal::GetEnv("GOOGLE_CLOUD_CPP_STORAGE_GRPC_CONFIG")
+      .value_or("");
+}
+
 bool UseGrpcForMetadata() {
-  auto v =
-      google::cloud::internal::GetEnv("GOOGLE_CLOUD_CPP_STORAGE_GRPC_CONFIG")
-          .value_or("");
-  return v.find("metadata") != std::string::npos;
+  return GrpcConfig().find("metadata") != std::string::npos;
+}
+
+bool UseLatencyRouting() {
+  return GrpcConfig().find("latency") != std::string::npos;
 }
 }  // namespace
 
@@ -44,6 +50,10 @@ StatusOr<google::cloud::storage::Client> DefaultGrpcClient(
     return storage::Client(
         std::make_shared<storage::internal::GrpcClient>(std::move(options)));
   }
+  if (UseLatencyRouting() && !options.transport_routing_policy()) {
+    options.set_transport_routing_policy(
+        std::make_shared<storage::LatencyRoutingPolicy>());
+  }
   return storage::Client(
       std::make_shared<storage::internal::HybridClient>(std::move(options)));
 }
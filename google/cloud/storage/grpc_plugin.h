@@ -48,6 +48,10 @@ StatusOr<google::cloud::storage::Client> DefaultGrpcClient();
  *
  * @param options the configuration parameters for the Client.
  *
+ * Set `GOOGLE_CLOUD_CPP_STORAGE_GRPC_CONFIG` to `latency` to route each
+ * operation supported by both transports to the one with the lowest observed
+ * latency, see `ClientOptions::transport_routing_policy()`.
+ *
  * @warning this is an experimental feature, and subject to change without
  *     notice.
  */
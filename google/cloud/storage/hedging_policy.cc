@@ -0,0 +1,102 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/hedging_policy.h"
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+
+std::size_t constexpr HedgingPolicy::kMaximumSamples;
+std::size_t constexpr HedgingPolicy::kMinimumSamples;
+std::size_t constexpr HedgingPolicy::kRecomputeInterval;
+double constexpr HedgingPolicy::kMaximumBudget;
+
+HedgingPolicy::HedgingPolicy(double delay_percentile, double budget_ratio,
+                             std::chrono::microseconds initial_delay,
+                             std::chrono::microseconds minimum_delay)
+    : delay_percentile_((std::min)(1.0, (std::max)(0.0, delay_percentile))),
+      budget_ratio_(budget_ratio),
+      initial_delay_(initial_delay),
+      minimum_delay_(minimum_delay) {}
+
+std::chrono::microseconds HedgingPolicy::OnCall(std::string const& operation) {
+  std::lock_guard<std::mutex> lk(mu_);
+  ++counters_.calls;
+  budget_ = (std::min)(kMaximumBudget, budget_ + budget_ratio_);
+  return DelayLocked(operations_[operation]);
+}
+
+bool HedgingPolicy::AcquireHedge() {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (budget_ < 1.0) {
+    ++counters_.budget_exhausted;
+    return false;
+  }
+  budget_ -= 1.0;
+  ++counters_.hedges;
+  return true;
+}
+
+bool HedgingPolicy::CanHedge() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return budget_ >= 1.0;
+}
+
+void HedgingPolicy::OnCompletion(std::string const& operation,
+                                 std::chrono::microseconds latency) {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto& state = operations_[operation];
+  if (state.samples.size() < kMaximumSamples) {
+    state.samples.push_back(latency);
+  } else {
+    state.samples[state.next] = latency;
+    state.next = (state.next + 1) % kMaximumSamples;
+  }
+  ++state.new_samples;
+}
+
+void HedgingPolicy::OnHedgeResult(bool hedge_won) {
+  if (!hedge_won) return;
+  std::lock_guard<std::mutex> lk(mu_);
+  ++counters_.hedge_wins;
+}
+
+HedgingCounters HedgingPolicy::Counters() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return counters_;
+}
+
+std::chrono::microseconds HedgingPolicy::DelayLocked(OperationState& state) {
+  if (state.samples.size() < kMinimumSamples) return initial_delay_;
+  if (state.delay.count() != 0 && state.new_samples < kRecomputeInterval) {
+    return state.delay;
+  }
+  auto samples = state.samples;
+  auto const index = (std::min)(
+      samples.size() - 1,
+      static_cast<std::size_t>(delay_percentile_ *
+                               static_cast<double>(samples.size())));
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  state.delay = (std::max)(minimum_delay_, samples[index]);
+  state.new_samples = 0;
+  return state.delay;
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,141 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_HEDGING_POLICY_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_HEDGING_POLICY_H
+
+#include "google/cloud/storage/version.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+
+/// The decisions made by a `HedgingPolicy`.
+struct HedgingCounters {
+  /// The number of calls that could be hedged.
+  std::uint64_t calls = 0;
+  /// The number of duplicate requests issued.
+  std::uint64_t hedges = 0;
+  /// The number of calls where the duplicate request finished first.
+  std::uint64_t hedge_wins = 0;
+  /// The number of duplicate requests skipped because the budget was spent.
+  std::uint64_t budget_exhausted = 0;
+};
+
+/**
+ * Controls when a `Client` issues duplicate requests.
+ *
+ * Configure the policy with `ClientOptions::set_hedging_policy()`.
+ *
+ * The policy records the latency of the original requests for each operation
+ * (e.g. "GetObjectMetadata"). If a call takes longer than the
+ * `delay_percentile` of the recent latencies, the client issues a duplicate
+ * request and uses whichever finishes first. Until there are enough samples
+ * the policy uses `initial_delay`.
+ *
+ * The duplicate requests are limited by a budget: each call earns
+ * `budget_ratio` tokens, up to `kMaximumBudget`, and each duplicate request
+ * spends one token. The budget starts full, after that, with the default
+ * values, at most about 5% of the calls are hedged.
+ *
+ * @par Limitations
+ * A call that may be hedged runs its original request in a background thread,
+ * while the calling thread waits for the first result: the client cannot
+ * abandon a request running in the calling thread. Calls made while the budget
+ * cannot pay for a duplicate request run in the calling thread, without
+ * hedging.
+ *
+ * The request that loses the race is not cancelled. It runs to completion in
+ * the background, holding a connection and a background thread, and its
+ * result is discarded. For `ReadObject()` the losing download is closed after
+ * its first read, but a losing `GetObjectMetadata()` request is not
+ * interrupted at all. Destroying the `Client` waits for any such requests.
+ *
+ * The policy is thread-safe, it is shared by all the calls in a client.
+ */
+class HedgingPolicy {
+ public:
+  /// The number of latency samples kept for each operation.
+  static std::size_t constexpr kMaximumSamples = 1000;
+  /// The number of samples needed before the percentile is used.
+  static std::size_t constexpr kMinimumSamples = 20;
+  /// The percentile is recomputed after this many new samples.
+  static std::size_t constexpr kRecomputeInterval = 16;
+  /// The maximum number of tokens saved in the budget.
+  static double constexpr kMaximumBudget = 10.0;
+
+  explicit HedgingPolicy(
+      double delay_percentile = 0.95, double budget_ratio = 0.05,
+      std::chrono::microseconds initial_delay = std::chrono::milliseconds(50),
+      std::chrono::microseconds minimum_delay = std::chrono::milliseconds(1));
+
+  /**
+   * Starts a call to @p operation, returns the time to wait before hedging.
+   *
+   * Each call to this function adds to the budget, use `AcquireHedge()` to
+   * spend it.
+   */
+  std::chrono::microseconds OnCall(std::string const& operation);
+
+  /// Returns true if there is enough budget to issue a duplicate request.
+  bool AcquireHedge();
+
+  /// Returns true if `AcquireHedge()` would succeed, without spending the
+  /// budget.
+  bool CanHedge() const;
+
+  /// Records the latency of a successful original request to @p operation.
+  void OnCompletion(std::string const& operation,
+                    std::chrono::microseconds latency);
+
+  /// Records the result of a hedged call.
+  void OnHedgeResult(bool hedge_won);
+
+  HedgingCounters Counters() const;
+
+ private:
+  struct OperationState {
+    std::vector<std::chrono::microseconds> samples;
+    // The position of the next sample once `samples` is full.
+    std::size_t next = 0;
+    // The cached percentile, and the samples received since it was computed.
+    std::chrono::microseconds delay{0};
+    std::size_t new_samples = 0;
+  };
+
+  std::chrono::microseconds DelayLocked(OperationState& state);
+
+  double const delay_percentile_;
+  double const budget_ratio_;
+  std::chrono::microseconds const initial_delay_;
+  std::chrono::microseconds const minimum_delay_;
+  mutable std::mutex mu_;
+  std::map<std::string, OperationState> operations_;
+  double budget_ = kMaximumBudget;
+  HedgingCounters counters_;
+};
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_HEDGING_POLICY_H
@@ -0,0 +1,125 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/hedging_policy.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+
+using ::std::chrono::microseconds;
+using ::std::chrono::milliseconds;
+
+TEST(HedgingPolicyTest, InitialDelay) {
+  HedgingPolicy policy(0.9, 0.05, milliseconds(50), milliseconds(1));
+  EXPECT_EQ(milliseconds(50), policy.OnCall("GetObjectMetadata"));
+  for (int i = 0; i != 10; ++i) {
+    policy.OnCompletion("GetObjectMetadata", milliseconds(5));
+  }
+  // There are not enough samples yet.
+  EXPECT_EQ(milliseconds(50), policy.OnCall("GetObjectMetadata"));
+  EXPECT_EQ(2, policy.Counters().calls);
+}
+
+TEST(HedgingPolicyTest, PercentileDelay) {
+  HedgingPolicy policy(0.9, 0.05, milliseconds(50), milliseconds(1));
+  for (int i = 1; i <= 100; ++i) {
+    policy.OnCompletion("ReadObject", milliseconds(i));
+  }
+  EXPECT_EQ(milliseconds(91), policy.OnCall("ReadObject"));
+  // Each operation has its own samples.
+  EXPECT_EQ(milliseconds(50), policy.OnCall("GetObjectMetadata"));
+}
+
+TEST(HedgingPolicyTest, MinimumDelay) {
+  HedgingPolicy policy(0.9, 0.05, milliseconds(50), milliseconds(2));
+  for (int i = 0; i != 50; ++i) {
+    policy.OnCompletion("ReadObject", microseconds(10));
+  }
+  EXPECT_EQ(milliseconds(2), policy.OnCall("ReadObject"));
+}
+
+TEST(HedgingPolicyTest, DelayFollowsNewSamples) {
+  HedgingPolicy policy(0.9, 0.05, milliseconds(50), milliseconds(1));
+  for (int i = 0; i != 20; ++i) {
+    policy.OnCompletion("ReadObject", milliseconds(10));
+  }
+  EXPECT_EQ(milliseconds(10), policy.OnCall("ReadObject"));
+
+  // The delay is not recomputed for every sample.
+  for (int i = 0; i != 10; ++i) {
+    policy.OnCompletion("ReadObject", milliseconds(100));
+  }
+  EXPECT_EQ(milliseconds(10), policy.OnCall("ReadObject"));
+  for (int i = 0; i != 6; ++i) {
+    policy.OnCompletion("ReadObject", milliseconds(100));
+  }
+  EXPECT_EQ(milliseconds(100), policy.OnCall("ReadObject"));
+}
+
+TEST(HedgingPolicyTest, OldSamplesAreDiscarded) {
+  HedgingPolicy policy(0.5, 0.05, milliseconds(50), milliseconds(1));
+  for (std::size_t i = 0; i != HedgingPolicy::kMaximumSamples; ++i) {
+    policy.OnCompletion("ReadObject", milliseconds(100));
+  }
+  EXPECT_EQ(milliseconds(100), policy.OnCall("ReadObject"));
+  for (std::size_t i = 0; i != HedgingPolicy::kMaximumSamples; ++i) {
+    policy.OnCompletion("ReadObject", milliseconds(10));
+  }
+  EXPECT_EQ(milliseconds(10), policy.OnCall("ReadObject"));
+}
+
+TEST(HedgingPolicyTest, Budget) {
+  HedgingPolicy policy(0.9, 0.5, milliseconds(50), milliseconds(1));
+  // The budget starts full.
+  for (int i = 0; i != 10; ++i) EXPECT_TRUE(policy.AcquireHedge());
+  EXPECT_FALSE(policy.AcquireHedge());
+
+  // Each call adds half a token.
+  policy.OnCall("ReadObject");
+  EXPECT_FALSE(policy.CanHedge());
+  EXPECT_FALSE(policy.AcquireHedge());
+  policy.OnCall("ReadObject");
+  EXPECT_TRUE(policy.CanHedge());
+  EXPECT_TRUE(policy.AcquireHedge());
+
+  auto const counters = policy.Counters();
+  EXPECT_EQ(2, counters.calls);
+  EXPECT_EQ(11, counters.hedges);
+  EXPECT_EQ(2, counters.budget_exhausted);
+}
+
+TEST(HedgingPolicyTest, BudgetIsCapped) {
+  HedgingPolicy policy(0.9, 0.5, milliseconds(50), milliseconds(1));
+  for (int i = 0; i != 100; ++i) policy.OnCall("ReadObject");
+  for (int i = 0; i != 10; ++i) EXPECT_TRUE(policy.AcquireHedge());
+  EXPECT_FALSE(policy.AcquireHedge());
+}
+
+TEST(HedgingPolicyTest, HedgeWins) {
+  HedgingPolicy policy;
+  policy.OnHedgeResult(true);
+  policy.OnHedgeResult(false);
+  policy.OnHedgeResult(true);
+  EXPECT_EQ(2, policy.Counters().hedge_wins);
+}
+
+}  // namespace
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -632,8 +632,9 @@ TEST(StrictIdempotencyPolicyTest, ResumableUploadIfGenerationMatch) {
 
 TEST(StrictIdempotencyPolicyTest, UploadChunk) {
   StrictIdempotencyPolicy policy;
+  std::string const payload = "test-payload";
   internal::UploadChunkRequest request("https://test-url.example.com", 0,
-                                       "test-payload", 0);
+                                       {payload}, 0);
   EXPECT_TRUE(policy.IsIdempotent(request));
 }
 
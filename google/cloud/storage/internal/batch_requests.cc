@@ -0,0 +1,400 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/batch_requests.h"
+#include "google/cloud/storage/idempotency_policy.h"
+#include "google/cloud/storage/internal/complex_option.h"
+#include "google/cloud/storage/well_known_headers.h"
+#include "google/cloud/storage/well_known_parameters.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+/// Percent-encode @p value, with the same rules as `curl_easy_escape()`.
+std::string UrlEscape(std::string const& value) {
+  static char const kHexDigits[] = "0123456789ABCDEF";
+  std::string result;
+  result.reserve(value.size());
+  for (auto const c : value) {
+    auto const u = static_cast<unsigned char>(c);
+    if ((u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') ||
+        (u >= '0' && u <= '9') || u == '-' || u == '.' || u == '_' ||
+        u == '~') {
+      result.push_back(c);
+      continue;
+    }
+    result.push_back('%');
+    result.push_back(kHexDigits[u >> 4U]);
+    result.push_back(kHexDigits[u & 0xFU]);
+  }
+  return result;
+}
+
+/**
+ * Formats one sub-request of a batch.
+ *
+ * The requests add their options using the same `AddOption()` overloads as
+ * `CurlRequestBuilder`, but the options are captured in the sub-request
+ * instead of a libcurl handle.
+ */
+class BatchPartBuilder {
+ public:
+  BatchPartBuilder(std::string method, std::string path) {
+    part_.method = std::move(method);
+    part_.path = std::move(path);
+  }
+
+  template <typename P>
+  BatchPartBuilder& AddOption(WellKnownParameter<P, std::string> const& p) {
+    if (p.has_value()) {
+      AddQueryParameter(p.parameter_name(), p.value());
+    }
+    return *this;
+  }
+
+  template <typename P>
+  BatchPartBuilder& AddOption(WellKnownParameter<P, std::int64_t> const& p) {
+    if (p.has_value()) {
+      AddQueryParameter(p.parameter_name(), std::to_string(p.value()));
+    }
+    return *this;
+  }
+
+  template <typename P>
+  BatchPartBuilder& AddOption(WellKnownParameter<P, bool> const& p) {
+    if (p.has_value()) {
+      AddQueryParameter(p.parameter_name(), p.value() ? "true" : "false");
+    }
+    return *this;
+  }
+
+  /// An empty `UserIp` means "use the client address", the service does that
+  /// anyway for the sub-requests.
+  BatchPartBuilder& AddOption(UserIp const& p) {
+    if (p.has_value() && !p.value().empty()) {
+      AddQueryParameter(UserIp::name(), p.value());
+    }
+    return *this;
+  }
+
+  template <typename P>
+  BatchPartBuilder& AddOption(WellKnownHeader<P, std::string> const& p) {
+    if (p.has_value()) {
+      AddHeader(std::string(p.header_name()) + ": " + p.value());
+    }
+    return *this;
+  }
+
+  BatchPartBuilder& AddOption(CustomHeader const& p) {
+    if (p.has_value()) {
+      AddHeader(p.custom_header_name() + ": " + p.value());
+    }
+    return *this;
+  }
+
+  BatchPartBuilder& AddOption(EncryptionKey const& p) {
+    if (p.has_value()) {
+      AddHeader(std::string(EncryptionKey::prefix()) +
+                "algorithm: " + p.value().algorithm);
+      AddHeader(std::string(EncryptionKey::prefix()) + "key: " + p.value().key);
+      AddHeader(std::string(EncryptionKey::prefix()) +
+                "key-sha256: " + p.value().sha256);
+    }
+    return *this;
+  }
+
+  BatchPartBuilder& AddOption(SourceEncryptionKey const& p) {
+    if (p.has_value()) {
+      AddHeader(std::string(SourceEncryptionKey::prefix()) +
+                "Algorithm: " + p.value().algorithm);
+      AddHeader(std::string(SourceEncryptionKey::prefix()) +
+                "Key: " + p.value().key);
+      AddHeader(std::string(SourceEncryptionKey::prefix()) +
+                "Key-Sha256: " + p.value().sha256);
+    }
+    return *this;
+  }
+
+  template <typename Option, typename T>
+  BatchPartBuilder& AddOption(ComplexOption<Option, T> const&) {
+    return *this;
+  }
+
+  BatchPartBuilder& AddHeader(std::string header) {
+    part_.headers.push_back(std::move(header));
+    return *this;
+  }
+
+  BatchPartBuilder& AddQueryParameter(std::string const& key,
+                                      std::string const& value) {
+    part_.path += query_separator_;
+    part_.path += UrlEscape(key);
+    part_.path += '=';
+    part_.path += UrlEscape(value);
+    query_separator_ = "&";
+    return *this;
+  }
+
+  template <typename Request>
+  BatchRequestPart Build(Request const& request, std::string payload) && {
+    request.AddOptionsToHttpRequest(*this);
+    if (!payload.empty()) {
+      AddHeader("Content-Type: application/json");
+    }
+    part_.payload = std::move(payload);
+    part_.is_idempotent = [request](IdempotencyPolicy const& policy) {
+      return policy.IsIdempotent(request);
+    };
+    return std::move(part_);
+  }
+
+ private:
+  BatchRequestPart part_;
+  char const* query_separator_ = "?";
+};
+
+std::string ObjectPath(std::string const& bucket_name,
+                       std::string const& object_name) {
+  return "/b/" + bucket_name + "/o/" + UrlEscape(object_name);
+}
+
+/// Reads one line from @p text, starting at @p pos, without the line break.
+std::string ReadLine(std::string const& text, std::size_t& pos) {
+  auto end = text.find('\n', pos);
+  if (end == std::string::npos) end = text.size();
+  auto line = text.substr(pos, end - pos);
+  if (!line.empty() && line.back() == '\r') line.pop_back();
+  pos = (std::min)(end + 1, text.size());
+  return line;
+}
+
+/// Reads a block of headers, up to and including the empty line.
+std::multimap<std::string, std::string> ReadHeaders(std::string const& text,
+                                                    std::size_t& pos) {
+  std::multimap<std::string, std::string> headers;
+  while (pos < text.size()) {
+    auto line = ReadLine(text, pos);
+    if (line.empty()) break;
+    auto separator = line.find(':');
+    auto name = line.substr(0, separator);
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](char x) { return static_cast<char>(std::tolower(x)); });
+    std::string value;
+    if (separator != std::string::npos) {
+      value = line.substr(separator + 1);
+      auto const start = value.find_first_not_of(' ');
+      value = start == std::string::npos ? std::string{} : value.substr(start);
+    }
+    headers.emplace(std::move(name), std::move(value));
+  }
+  return headers;
+}
+
+/// Extracts the boundary parameter from a `multipart/mixed` content type.
+std::string ExtractBoundary(std::string const& content_type) {
+  auto const key = std::string("boundary=");
+  auto pos = content_type.find(key);
+  if (pos == std::string::npos) return {};
+  auto value = content_type.substr(pos + key.size());
+  value = value.substr(0, value.find(';'));
+  if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+    value = value.substr(1, value.size() - 2);
+  }
+  return value;
+}
+
+/**
+ * Returns the sub-request index from a `Content-ID` header.
+ *
+ * The service returns `<response-item-N>` for a sub-request sent with
+ * `<item-N>`. Returns -1 if the header does not have that format.
+ */
+std::int64_t ParseContentId(std::string const& content_id) {
+  auto end = content_id.find_last_of("0123456789");
+  if (end == std::string::npos) return -1;
+  auto start = content_id.find_last_not_of("0123456789", end);
+  start = start == std::string::npos ? 0 : start + 1;
+  return std::strtoll(content_id.substr(start, end - start + 1).c_str(),
+                      nullptr, 10);
+}
+
+}  // namespace
+
+std::size_t constexpr BatchRequest::kMaxBatchSize;
+
+BatchRequest& BatchRequest::AddDeleteObject(
+    DeleteObjectRequest const& request) {
+  return AddPart(
+      BatchPartBuilder("DELETE",
+                       ObjectPath(request.bucket_name(), request.object_name()))
+          .Build(request, {}));
+}
+
+BatchRequest& BatchRequest::AddPatchObject(PatchObjectRequest const& request) {
+  return AddPart(
+      BatchPartBuilder("PATCH",
+                       ObjectPath(request.bucket_name(), request.object_name()))
+          .Build(request, request.payload()));
+}
+
+BatchRequest& BatchRequest::AddDeleteObjectAcl(
+    DeleteObjectAclRequest const& request) {
+  auto path = ObjectPath(request.bucket_name(), request.object_name()) +
+              "/acl/" + UrlEscape(request.entity());
+  return AddPart(
+      BatchPartBuilder("DELETE", std::move(path)).Build(request, {}));
+}
+
+BatchRequest& BatchRequest::AddPatchObjectAcl(
+    PatchObjectAclRequest const& request) {
+  auto path = ObjectPath(request.bucket_name(), request.object_name()) +
+              "/acl/" + UrlEscape(request.entity());
+  return AddPart(BatchPartBuilder("PATCH", std::move(path))
+                     .Build(request, request.payload()));
+}
+
+BatchRequest& BatchRequest::AddPart(BatchRequestPart part) {
+  parts_.push_back(std::move(part));
+  return *this;
+}
+
+std::string BatchRequest::Payload(std::string const& boundary,
+                                  std::string const& path_prefix) const {
+  std::string const crlf = "\r\n";
+  std::string const marker = "--" + boundary;
+  std::ostringstream os;
+  int index = 0;
+  for (auto const& part : parts_) {
+    os << marker << crlf << "Content-Type: application/http" << crlf
+       << "Content-ID: <item-" << index++ << ">" << crlf << crlf;
+    os << part.method << " " << path_prefix << part.path << " HTTP/1.1"
+       << crlf;
+    for (auto const& h : part.headers) os << h << crlf;
+    if (!part.payload.empty()) {
+      os << "Content-Length: " << part.payload.size() << crlf;
+    }
+    os << crlf << part.payload << crlf;
+  }
+  os << marker << "--" << crlf;
+  return std::move(os).str();
+}
+
+std::ostream& operator<<(std::ostream& os, BatchRequest const& r) {
+  os << "BatchRequest={parts=[";
+  char const* sep = "";
+  for (auto const& part : r.parts()) {
+    os << sep << part.method << " " << part.path;
+    sep = ", ";
+  }
+  return os << "]}";
+}
+
+StatusOr<BatchResponse> BatchResponse::FromHttpResponse(
+    HttpResponse const& response, std::size_t expected_size) {
+  auto content_type = response.headers.find("content-type");
+  auto const boundary = content_type == response.headers.end()
+                            ? std::string{}
+                            : ExtractBoundary(content_type->second);
+  if (boundary.empty()) {
+    return Status(StatusCode::kInvalidArgument,
+                  "Missing multipart boundary in batch response");
+  }
+
+  auto const& payload = response.payload;
+  auto const marker = "--" + boundary;
+  BatchResponse result;
+  result.responses.resize(expected_size);
+  std::vector<bool> received(expected_size, false);
+  std::size_t next_index = 0;
+
+  auto pos = payload.find(marker);
+  while (pos != std::string::npos) {
+    pos += marker.size();
+    if (payload.compare(pos, 2, "--") == 0) break;
+    auto const end = payload.find(marker, pos);
+    if (end == std::string::npos) {
+      return Status(StatusCode::kInvalidArgument,
+                    "Unterminated part in batch response");
+    }
+    auto part = payload.substr(pos, end - pos);
+    std::size_t offset = 0;
+    ReadLine(part, offset);  // The remainder of the boundary line.
+    auto part_headers = ReadHeaders(part, offset);
+
+    // The body of each part is a complete HTTP response, starting with a
+    // status line such as `HTTP/1.1 204 No Content`.
+    std::istringstream status_line(ReadLine(part, offset));
+    std::string version;
+    long status_code = 0;  // NOLINT(google-runtime-int)
+    status_line >> version >> status_code;
+    if (version.compare(0, 5, "HTTP/") != 0 || status_code == 0) {
+      return Status(StatusCode::kInvalidArgument,
+                    "Invalid status line in batch response part");
+    }
+    HttpResponse item{status_code, {}, ReadHeaders(part, offset)};
+    item.payload = part.substr(offset);
+    if (item.payload.size() >= 2 &&
+        item.payload.compare(item.payload.size() - 2, 2, "\r\n") == 0) {
+      item.payload.resize(item.payload.size() - 2);
+    } else if (!item.payload.empty() && item.payload.back() == '\n') {
+      item.payload.pop_back();
+    }
+
+    auto index = static_cast<std::int64_t>(next_index);
+    auto content_id = part_headers.find("content-id");
+    if (content_id != part_headers.end()) {
+      index = ParseContentId(content_id->second);
+    }
+    if (index < 0 || static_cast<std::size_t>(index) >= expected_size ||
+        received[index]) {
+      return Status(StatusCode::kInvalidArgument,
+                    "Unexpected part in batch response");
+    }
+    received[index] = true;
+    result.responses[index] = std::move(item);
+    next_index = static_cast<std::size_t>(index) + 1;
+    pos = end;
+  }
+
+  if (std::find(received.begin(), received.end(), false) != received.end()) {
+    return Status(StatusCode::kInvalidArgument,
+                  "Missing parts in batch response");
+  }
+  return result;
+}
+
+std::ostream& operator<<(std::ostream& os, BatchResponse const& r) {
+  os << "BatchResponse={responses=[";
+  char const* sep = "";
+  for (auto const& response : r.responses) {
+    os << sep << response;
+    sep = ", ";
+  }
+  return os << "]}";
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,107 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_BATCH_REQUESTS_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_BATCH_REQUESTS_H
+
+#include "google/cloud/storage/internal/http_response.h"
+#include "google/cloud/storage/internal/object_acl_requests.h"
+#include "google/cloud/storage/internal/object_requests.h"
+#include "google/cloud/storage/version.h"
+#include "google/cloud/status_or.h"
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+class IdempotencyPolicy;
+namespace internal {
+
+/// One of the sub-requests in a `BatchRequest`.
+struct BatchRequestPart {
+  std::string method;
+  /// The path relative to the JSON API root, including any query parameters.
+  std::string path;
+  std::vector<std::string> headers;
+  std::string payload;
+  /// Returns true if the sub-request is idempotent under the given policy.
+  std::function<bool(IdempotencyPolicy const&)> is_idempotent;
+};
+
+/**
+ * Represents a batch of metadata requests sent in a single HTTP request.
+ *
+ * The JSON API accepts up to `kMaxBatchSize` requests packed in a single
+ * `multipart/mixed` HTTP request, each part contains a complete HTTP request.
+ * The service executes each sub-request independently, and returns their
+ * responses, also packed in a `multipart/mixed` response. Only requests that
+ * do not upload or download media can be batched.
+ *
+ * @see https://cloud.google.com/storage/docs/json_api/v1/how-tos/batch
+ */
+class BatchRequest {
+ public:
+  static std::size_t constexpr kMaxBatchSize = 100;
+
+  BatchRequest() = default;
+
+  std::vector<BatchRequestPart> const& parts() const { return parts_; }
+  std::size_t size() const { return parts_.size(); }
+  bool empty() const { return parts_.empty(); }
+
+  BatchRequest& AddDeleteObject(DeleteObjectRequest const& request);
+  BatchRequest& AddPatchObject(PatchObjectRequest const& request);
+  BatchRequest& AddDeleteObjectAcl(DeleteObjectAclRequest const& request);
+  BatchRequest& AddPatchObjectAcl(PatchObjectAclRequest const& request);
+  BatchRequest& AddPart(BatchRequestPart part);
+
+  /**
+   * Formats the `multipart/mixed` payload for this batch.
+   *
+   * @param boundary the separator between parts, it must not appear in any of
+   *     the sub-requests.
+   * @param path_prefix the path of the JSON API root in the service, e.g.
+   *     `/storage/v1`.
+   */
+  std::string Payload(std::string const& boundary,
+                      std::string const& path_prefix) const;
+
+ private:
+  std::vector<BatchRequestPart> parts_;
+};
+
+std::ostream& operator<<(std::ostream& os, BatchRequest const& r);
+
+/// The responses for a `BatchRequest`, in the same order as its parts.
+struct BatchResponse {
+  static StatusOr<BatchResponse> FromHttpResponse(HttpResponse const& response,
+                                                  std::size_t expected_size);
+
+  std::vector<HttpResponse> responses;
+};
+
+std::ostream& operator<<(std::ostream& os, BatchResponse const& r);
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_BATCH_REQUESTS_H
@@ -0,0 +1,232 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/batch_requests.h"
+#include "google/cloud/storage/idempotency_policy.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+TEST(BatchRequestsTest, DeleteObject) {
+  BatchRequest batch;
+  batch.AddDeleteObject(DeleteObjectRequest("test-bucket", "folder/a b.txt")
+                            .set_multiple_options(IfGenerationMatch(42),
+                                                  UserProject("test-project")));
+  ASSERT_EQ(1, batch.size());
+  auto const& part = batch.parts().front();
+  EXPECT_EQ("DELETE", part.method);
+  EXPECT_EQ(
+      "/b/test-bucket/o/folder%2Fa%20b.txt?ifGenerationMatch=42"
+      "&userProject=test-project",
+      part.path);
+  EXPECT_TRUE(part.headers.empty());
+  EXPECT_TRUE(part.payload.empty());
+  EXPECT_TRUE(part.is_idempotent(StrictIdempotencyPolicy()));
+}
+
+TEST(BatchRequestsTest, DeleteObjectNotIdempotent) {
+  BatchRequest batch;
+  batch.AddDeleteObject(DeleteObjectRequest("test-bucket", "test-object"));
+  ASSERT_EQ(1, batch.size());
+  auto const& part = batch.parts().front();
+  EXPECT_EQ("/b/test-bucket/o/test-object", part.path);
+  EXPECT_FALSE(part.is_idempotent(StrictIdempotencyPolicy()));
+  EXPECT_TRUE(part.is_idempotent(AlwaysRetryIdempotencyPolicy()));
+}
+
+TEST(BatchRequestsTest, PatchObject) {
+  ObjectMetadata original;
+  ObjectMetadata updated = original;
+  updated.set_content_type("text/plain");
+  PatchObjectRequest request("test-bucket", "test-object", original, updated);
+  request.set_option(IfMetagenerationMatch(7));
+
+  BatchRequest batch;
+  batch.AddPatchObject(request);
+  ASSERT_EQ(1, batch.size());
+  auto const& part = batch.parts().front();
+  EXPECT_EQ("PATCH", part.method);
+  EXPECT_EQ("/b/test-bucket/o/test-object?ifMetagenerationMatch=7", part.path);
+  EXPECT_THAT(part.headers, ElementsAre("Content-Type: application/json"));
+  EXPECT_EQ(request.payload(), part.payload);
+}
+
+TEST(BatchRequestsTest, ObjectAcl) {
+  BatchRequest batch;
+  batch.AddDeleteObjectAcl(
+      DeleteObjectAclRequest("test-bucket", "test-object", "user-a@b.com"));
+  batch.AddPatchObjectAcl(PatchObjectAclRequest(
+      "test-bucket", "test-object", "allUsers",
+      ObjectAccessControlPatchBuilder().set_role("READER")));
+  ASSERT_EQ(2, batch.size());
+  EXPECT_EQ("DELETE", batch.parts()[0].method);
+  EXPECT_EQ("/b/test-bucket/o/test-object/acl/user-a%40b.com",
+            batch.parts()[0].path);
+  EXPECT_EQ("PATCH", batch.parts()[1].method);
+  EXPECT_EQ("/b/test-bucket/o/test-object/acl/allUsers",
+            batch.parts()[1].path);
+  EXPECT_THAT(batch.parts()[1].payload, HasSubstr("READER"));
+}
+
+TEST(BatchRequestsTest, Payload) {
+  BatchRequest batch;
+  batch.AddDeleteObject(DeleteObjectRequest("test-bucket", "a"));
+  batch.AddPart(BatchRequestPart{
+      "PATCH", "/b/test-bucket/o/b", {"x-test: 1"}, "{}", nullptr});
+
+  auto const payload = batch.Payload("abc123", "/storage/v1");
+  auto const expected =
+      "--abc123\r\n"
+      "Content-Type: application/http\r\n"
+      "Content-ID: <item-0>\r\n"
+      "\r\n"
+      "DELETE /storage/v1/b/test-bucket/o/a HTTP/1.1\r\n"
+      "\r\n"
+      "\r\n"
+      "--abc123\r\n"
+      "Content-Type: application/http\r\n"
+      "Content-ID: <item-1>\r\n"
+      "\r\n"
+      "PATCH /storage/v1/b/test-bucket/o/b HTTP/1.1\r\n"
+      "x-test: 1\r\n"
+      "Content-Length: 2\r\n"
+      "\r\n"
+      "{}\r\n"
+      "--abc123--\r\n";
+  EXPECT_EQ(expected, payload);
+}
+
+TEST(BatchRequestsTest, IOStream) {
+  BatchRequest batch;
+  batch.AddDeleteObject(DeleteObjectRequest("test-bucket", "test-object"));
+  std::ostringstream os;
+  os << batch;
+  auto actual = std::move(os).str();
+  EXPECT_THAT(actual, HasSubstr("BatchRequest"));
+  EXPECT_THAT(actual, HasSubstr("DELETE /b/test-bucket/o/test-object"));
+}
+
+TEST(BatchResponseTest, Parse) {
+  // The service may return the parts in any order, this test also uses LF
+  // line breaks in the second part to verify the parser tolerates them.
+  std::string const payload =
+      "--batch_xyz\r\n"
+      "Content-Type: application/http\r\n"
+      "Content-ID: <response-item-1>\r\n"
+      "\r\n"
+      "HTTP/1.1 404 Not Found\r\n"
+      "Content-Type: application/json; charset=UTF-8\r\n"
+      "\r\n"
+      "{\"error\": \"not found\"}\r\n"
+      "--batch_xyz\n"
+      "Content-Type: application/http\n"
+      "Content-ID: <response-item-0>\n"
+      "\n"
+      "HTTP/1.1 204 No Content\n"
+      "Content-Length: 0\n"
+      "\n"
+      "\n"
+      "--batch_xyz--\r\n";
+  HttpResponse response{
+      200, payload, {{"content-type", "multipart/mixed; boundary=batch_xyz"}}};
+  auto actual = BatchResponse::FromHttpResponse(response, 2);
+  ASSERT_STATUS_OK(actual);
+  ASSERT_EQ(2, actual->responses.size());
+  EXPECT_EQ(204, actual->responses[0].status_code);
+  EXPECT_EQ("", actual->responses[0].payload);
+  EXPECT_EQ(404, actual->responses[1].status_code);
+  EXPECT_EQ("{\"error\": \"not found\"}", actual->responses[1].payload);
+  EXPECT_EQ(StatusCode::kNotFound, AsStatus(actual->responses[1]).code());
+  auto const& headers = actual->responses[1].headers;
+  ASSERT_EQ(1, headers.count("content-type"));
+  EXPECT_EQ("application/json; charset=UTF-8",
+            headers.find("content-type")->second);
+}
+
+TEST(BatchResponseTest, ParseWithoutContentId) {
+  std::string const payload =
+      "--b\r\n"
+      "Content-Type: application/http\r\n"
+      "\r\n"
+      "HTTP/1.1 200 OK\r\n"
+      "\r\n"
+      "{}\r\n"
+      "--b\r\n"
+      "Content-Type: application/http\r\n"
+      "\r\n"
+      "HTTP/1.1 412 Precondition Failed\r\n"
+      "\r\n"
+      "\r\n"
+      "--b--\r\n";
+  HttpResponse response{
+      200, payload, {{"content-type", "multipart/mixed; boundary=\"b\""}}};
+  auto actual = BatchResponse::FromHttpResponse(response, 2);
+  ASSERT_STATUS_OK(actual);
+  ASSERT_EQ(2, actual->responses.size());
+  EXPECT_EQ(200, actual->responses[0].status_code);
+  EXPECT_EQ("{}", actual->responses[0].payload);
+  EXPECT_EQ(412, actual->responses[1].status_code);
+}
+
+TEST(BatchResponseTest, ParseErrors) {
+  auto parse = [](std::string payload, std::string content_type,
+                  std::size_t expected_size) {
+    HttpResponse response{
+        200, std::move(payload), {{"content-type", std::move(content_type)}}};
+    return BatchResponse::FromHttpResponse(response, expected_size).status();
+  };
+  auto const part =
+      "--b\r\n"
+      "Content-ID: <response-item-0>\r\n"
+      "\r\n"
+      "HTTP/1.1 204 No Content\r\n"
+      "\r\n"
+      "\r\n";
+  // Missing boundary.
+  EXPECT_EQ(StatusCode::kInvalidArgument,
+            parse(std::string(part) + "--b--", "multipart/mixed", 1).code());
+  // Unterminated part.
+  EXPECT_EQ(StatusCode::kInvalidArgument,
+            parse(part, "multipart/mixed; boundary=b", 1).code());
+  // Missing parts.
+  EXPECT_EQ(StatusCode::kInvalidArgument,
+            parse(std::string(part) + "--b--", "multipart/mixed; boundary=b", 2)
+                .code());
+  // Duplicate parts.
+  EXPECT_EQ(StatusCode::kInvalidArgument,
+            parse(std::string(part) + part + "--b--",
+                  "multipart/mixed; boundary=b", 2)
+                .code());
+  // Invalid status line.
+  EXPECT_EQ(StatusCode::kInvalidArgument,
+            parse("--b\r\n\r\nnot-http\r\n\r\n--b--",
+                  "multipart/mixed; boundary=b", 1)
+                .code());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
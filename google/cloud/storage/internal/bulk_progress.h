@@ -0,0 +1,103 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_BULK_PROGRESS_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_BULK_PROGRESS_H
+
+#include "google/cloud/storage/version.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/// Returns the throughput for @p bytes transferred in @p elapsed.
+inline double BytesPerSecond(std::uint64_t bytes,
+                             std::chrono::steady_clock::duration elapsed) {
+  using seconds = std::chrono::duration<double>;
+  auto const s = std::chrono::duration_cast<seconds>(elapsed).count();
+  return s > 0 ? static_cast<double>(bytes) / s : 0.0;
+}
+
+/**
+ * A parameter type holding a callback for a bulk operation.
+ *
+ * @tparam Derived the type we will use to represent the option, each option
+ *     needs its own type to be found in the list of options.
+ * @tparam Signature the signature of the callback.
+ */
+template <typename Derived, typename Signature>
+class CallbackOption {
+ public:
+  using Callback = std::function<Signature>;
+
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  CallbackOption(Callback value) : value_(std::move(value)) {}
+  Callback const& value() const { return value_; }
+
+ private:
+  Callback value_;
+};
+
+/**
+ * Tracks the aggregate progress of a bulk operation.
+ *
+ * The updates to the statistics, and the callbacks reporting them, are
+ * serialized, so the callbacks observe the updates in order.
+ *
+ * @tparam Stats the statistics for the operation, `elapsed` is updated in
+ *     each snapshot.
+ */
+template <typename Stats>
+class ProgressMonitor {
+ public:
+  explicit ProgressMonitor(Stats initial)
+      : start_(std::chrono::steady_clock::now()), stats_(std::move(initial)) {}
+
+  /// Applies @p update to the statistics, then calls @p report with them.
+  template <typename UpdateFunction, typename ReportFunction>
+  void Update(UpdateFunction const& update, ReportFunction const& report) {
+    std::lock_guard<std::mutex> lk(mu_);
+    update(stats_);
+    report(Snapshot());
+  }
+
+  Stats Current() {
+    std::lock_guard<std::mutex> lk(mu_);
+    return Snapshot();
+  }
+
+ private:
+  Stats Snapshot() {
+    stats_.elapsed = std::chrono::steady_clock::now() - start_;
+    return stats_;
+  }
+
+  std::chrono::steady_clock::time_point const start_;
+  std::mutex mu_;
+  Stats stats_;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_BULK_PROGRESS_H
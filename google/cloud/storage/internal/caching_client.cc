@@ -0,0 +1,511 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/caching_client.h"
+#include "google/cloud/storage/hashing_options.h"
+#include "google/cloud/log.h"
+#include "absl/memory/memory.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+/// Serves a range of a cached object.
+class CachedObjectReadSource : public ObjectReadSource {
+ public:
+  CachedObjectReadSource(std::shared_ptr<CachedObject> object,
+                         std::size_t begin, std::size_t end,
+                         std::multimap<std::string, std::string> headers)
+      : object_(std::move(object)),
+        offset_(begin),
+        end_(end),
+        headers_(std::move(headers)) {}
+
+  bool IsOpen() const override { return is_open_; }
+  StatusOr<HttpResponse> Close() override {
+    is_open_ = false;
+    return HttpResponse{HttpStatusCode::kOk, {}, {}};
+  }
+  StatusOr<ReadSourceResult> Read(char* buf, std::size_t n) override {
+    auto const count = (std::min)(n, end_ - offset_);
+    if (count != 0) std::memcpy(buf, object_->data() + offset_, count);
+    offset_ += count;
+    return ReadSourceResult{count, NextResponse()};
+  }
+  // The memory mapped contents are lent to the caller, there are no copies.
+  bool CanReadBorrowed() const override { return true; }
+  StatusOr<BorrowedReadSourceResult> ReadBorrowed() override {
+    ConstBuffer data(object_->data() + offset_, end_ - offset_);
+    offset_ = end_;
+    return BorrowedReadSourceResult{data, NextResponse()};
+  }
+
+ private:
+  HttpResponse NextResponse() {
+    if (offset_ != end_) {
+      return HttpResponse{HttpStatusCode::kContinue, {}, std::move(headers_)};
+    }
+    is_open_ = false;
+    return HttpResponse{HttpStatusCode::kOk, {}, std::move(headers_)};
+  }
+
+  std::shared_ptr<CachedObject> object_;
+  std::size_t offset_;
+  std::size_t end_;
+  // Sent with the first response only.
+  std::multimap<std::string, std::string> headers_;
+  bool is_open_ = true;
+};
+}  // namespace
+
+CachingClient::CachingClient(std::shared_ptr<RawClient> client,
+                             std::shared_ptr<ObjectCache> cache,
+                             std::uint64_t maximum_cached_object_size)
+    : client_(std::move(client)),
+      cache_(std::move(cache)),
+      maximum_cached_object_size_(maximum_cached_object_size) {}
+
+ClientOptions const& CachingClient::client_options() const {
+  return client_->client_options();
+}
+
+std::size_t CachingClient::upload_buffer_size() const {
+  return client_->upload_buffer_size();
+}
+
+ConnectionPoolStats CachingClient::connection_pool_stats() const {
+  return client_->connection_pool_stats();
+}
+
+StatusOr<ListBucketsResponse> CachingClient::ListBuckets(
+    ListBucketsRequest const& request) {
+  return client_->ListBuckets(request);
+}
+
+StatusOr<BucketMetadata> CachingClient::CreateBucket(
+    CreateBucketRequest const& request) {
+  return client_->CreateBucket(request);
+}
+
+StatusOr<BucketMetadata> CachingClient::GetBucketMetadata(
+    GetBucketMetadataRequest const& request) {
+  return client_->GetBucketMetadata(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteBucket(
+    DeleteBucketRequest const& request) {
+  return client_->DeleteBucket(request);
+}
+
+StatusOr<BucketMetadata> CachingClient::UpdateBucket(
+    UpdateBucketRequest const& request) {
+  return client_->UpdateBucket(request);
+}
+
+StatusOr<BucketMetadata> CachingClient::PatchBucket(
+    PatchBucketRequest const& request) {
+  return client_->PatchBucket(request);
+}
+
+StatusOr<IamPolicy> CachingClient::GetBucketIamPolicy(
+    GetBucketIamPolicyRequest const& request) {
+  return client_->GetBucketIamPolicy(request);
+}
+
+StatusOr<NativeIamPolicy> CachingClient::GetNativeBucketIamPolicy(
+    GetBucketIamPolicyRequest const& request) {
+  return client_->GetNativeBucketIamPolicy(request);
+}
+
+StatusOr<IamPolicy> CachingClient::SetBucketIamPolicy(
+    SetBucketIamPolicyRequest const& request) {
+  return client_->SetBucketIamPolicy(request);
+}
+
+StatusOr<NativeIamPolicy> CachingClient::SetNativeBucketIamPolicy(
+    SetNativeBucketIamPolicyRequest const& request) {
+  return client_->SetNativeBucketIamPolicy(request);
+}
+
+StatusOr<TestBucketIamPermissionsResponse>
+CachingClient::TestBucketIamPermissions(
+    TestBucketIamPermissionsRequest const& request) {
+  return client_->TestBucketIamPermissions(request);
+}
+
+StatusOr<BucketMetadata> CachingClient::LockBucketRetentionPolicy(
+    LockBucketRetentionPolicyRequest const& request) {
+  return client_->LockBucketRetentionPolicy(request);
+}
+
+StatusOr<ObjectMetadata> CachingClient::InsertObjectMedia(
+    InsertObjectMediaRequest const& request) {
+  return client_->InsertObjectMedia(request);
+}
+
+StatusOr<ObjectMetadata> CachingClient::CopyObject(
+    CopyObjectRequest const& request) {
+  return client_->CopyObject(request);
+}
+
+StatusOr<ObjectMetadata> CachingClient::GetObjectMetadata(
+    GetObjectMetadataRequest const& request) {
+  return client_->GetObjectMetadata(request);
+}
+
+StatusOr<std::unique_ptr<ObjectReadSource>> CachingClient::ReadObject(
+    ReadObjectRangeRequest const& request) {
+  // Never store the plaintext of objects encrypted with customer-supplied keys.
+  if (request.HasOption<EncryptionKey>()) return client_->ReadObject(request);
+  if (IsKnownLargeObject(request)) return client_->ReadObject(request);
+
+  // A specific generation never changes, if its contents were verified there
+  // is nothing to validate with the service.
+  auto const has_preconditions = request.HasOption<IfGenerationMatch>() ||
+                                 request.HasOption<IfGenerationNotMatch>() ||
+                                 request.HasOption<IfMetagenerationMatch>() ||
+                                 request.HasOption<IfMetagenerationNotMatch>();
+  if (request.HasOption<Generation>() && !has_preconditions) {
+    auto const generation = request.GetOption<Generation>().value();
+    auto object = cache_->LookupVerified(
+        {request.bucket_name(), request.object_name(), generation});
+    if (object) return Serve(request, std::move(object), generation, {}, {});
+  }
+
+  // Validate the preconditions and find the current generation.
+  GetObjectMetadataRequest metadata_request(request.bucket_name(),
+                                            request.object_name());
+  metadata_request.set_multiple_options(
+      request.GetOption<Generation>(), request.GetOption<IfGenerationMatch>(),
+      request.GetOption<IfGenerationNotMatch>(),
+      request.GetOption<IfMetagenerationMatch>(),
+      request.GetOption<IfMetagenerationNotMatch>(),
+      request.GetOption<QuotaUser>(), request.GetOption<UserIp>(),
+      request.GetOption<UserProject>());
+  auto metadata = client_->GetObjectMetadata(metadata_request);
+  if (!metadata) return std::move(metadata).status();
+  if (metadata->size() > maximum_cached_object_size_) {
+    AddKnownLargeObject(request);
+    return client_->ReadObject(request);
+  }
+
+  ObjectCacheKey key{request.bucket_name(), request.object_name(),
+                     metadata->generation()};
+  // Ranged reads are not validated by the caller, verify the cached contents.
+  auto object = cache_->Lookup(key, metadata->crc32c());
+  if (!object) {
+    auto contents = Download(request, *metadata);
+    if (!contents) {
+      GCP_LOG(INFO) << __func__ << "() cannot cache object " << request
+                    << ": " << contents.status();
+      return client_->ReadObject(request);
+    }
+    auto inserted = cache_->Insert(key, *contents);
+    // Serve the contents from memory if they cannot be stored.
+    object = inserted ? *std::move(inserted)
+                      : CachedObject::FromString(*std::move(contents));
+  }
+  return Serve(request, std::move(object), metadata->generation(),
+               metadata->crc32c(), metadata->md5_hash());
+}
+
+StatusOr<std::unique_ptr<ObjectReadSource>> CachingClient::Serve(
+    ReadObjectRangeRequest const& request,
+    std::shared_ptr<CachedObject> object, std::int64_t generation,
+    std::string const& crc32c, std::string const& md5_hash) {
+  auto const size = static_cast<std::int64_t>(object->size());
+  std::int64_t begin = 0;
+  std::int64_t end = size;
+  if (request.HasOption<ReadRange>()) {
+    auto const range = request.GetOption<ReadRange>().value();
+    begin = (std::max)(begin, range.begin);
+    end = (std::min)(end, range.end);
+  }
+  if (request.HasOption<ReadFromOffset>()) {
+    begin = (std::max)(begin, request.GetOption<ReadFromOffset>().value());
+  }
+  if (request.HasOption<ReadLast>()) {
+    begin = (std::max)(begin, size - request.GetOption<ReadLast>().value());
+  }
+  // Let the service report invalid ranges.
+  if (begin > end || (begin == end && size != 0)) {
+    return client_->ReadObject(request);
+  }
+
+  std::multimap<std::string, std::string> headers;
+  headers.emplace("x-goog-generation", std::to_string(generation));
+  if (begin == 0 && end == size) {
+    // The hashes of full downloads are validated as usual, this detects any
+    // corruption in the local copy.
+    if (!crc32c.empty()) headers.emplace("x-goog-hash", "crc32c=" + crc32c);
+    if (!md5_hash.empty()) headers.emplace("x-goog-hash", "md5=" + md5_hash);
+  }
+  return std::unique_ptr<ObjectReadSource>(
+      absl::make_unique<CachedObjectReadSource>(
+          std::move(object), static_cast<std::size_t>(begin),
+          static_cast<std::size_t>(end), std::move(headers)));
+}
+
+bool CachingClient::IsKnownLargeObject(ReadObjectRangeRequest const& request) {
+  std::lock_guard<std::mutex> lk(mu_);
+  return large_objects_.count(request.bucket_name() + "/" +
+                              request.object_name()) != 0;
+}
+
+void CachingClient::AddKnownLargeObject(ReadObjectRangeRequest const& request) {
+  auto name = request.bucket_name() + "/" + request.object_name();
+  std::lock_guard<std::mutex> lk(mu_);
+  if (!large_objects_.insert(name).second) return;
+  large_objects_order_.push_back(std::move(name));
+  // Forget the oldest names, a smaller object may have replaced them.
+  while (large_objects_order_.size() > kMaximumKnownLargeObjects) {
+    large_objects_.erase(large_objects_order_.front());
+    large_objects_order_.pop_front();
+  }
+}
+
+StatusOr<ListObjectsResponse> CachingClient::ListObjects(
+    ListObjectsRequest const& request) {
+  return client_->ListObjects(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteObject(
+    DeleteObjectRequest const& request) {
+  return client_->DeleteObject(request);
+}
+
+StatusOr<ObjectMetadata> CachingClient::UpdateObject(
+    UpdateObjectRequest const& request) {
+  return client_->UpdateObject(request);
+}
+
+StatusOr<ObjectMetadata> CachingClient::PatchObject(
+    PatchObjectRequest const& request) {
+  return client_->PatchObject(request);
+}
+
+StatusOr<ObjectMetadata> CachingClient::ComposeObject(
+    ComposeObjectRequest const& request) {
+  return client_->ComposeObject(request);
+}
+
+StatusOr<RewriteObjectResponse> CachingClient::RewriteObject(
+    RewriteObjectRequest const& request) {
+  return client_->RewriteObject(request);
+}
+
+StatusOr<std::unique_ptr<ResumableUploadSession>>
+CachingClient::CreateResumableSession(ResumableUploadRequest const& request) {
+  return client_->CreateResumableSession(request);
+}
+
+StatusOr<std::unique_ptr<ResumableUploadSession>>
+CachingClient::RestoreResumableSession(std::string const& upload_id) {
+  return client_->RestoreResumableSession(upload_id);
+}
+
+StatusOr<ListBucketAclResponse> CachingClient::ListBucketAcl(
+    ListBucketAclRequest const& request) {
+  return client_->ListBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> CachingClient::CreateBucketAcl(
+    CreateBucketAclRequest const& request) {
+  return client_->CreateBucketAcl(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteBucketAcl(
+    DeleteBucketAclRequest const& request) {
+  return client_->DeleteBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> CachingClient::GetBucketAcl(
+    GetBucketAclRequest const& request) {
+  return client_->GetBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> CachingClient::UpdateBucketAcl(
+    UpdateBucketAclRequest const& request) {
+  return client_->UpdateBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> CachingClient::PatchBucketAcl(
+    PatchBucketAclRequest const& request) {
+  return client_->PatchBucketAcl(request);
+}
+
+StatusOr<ListObjectAclResponse> CachingClient::ListObjectAcl(
+    ListObjectAclRequest const& request) {
+  return client_->ListObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::CreateObjectAcl(
+    CreateObjectAclRequest const& request) {
+  return client_->CreateObjectAcl(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteObjectAcl(
+    DeleteObjectAclRequest const& request) {
+  return client_->DeleteObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::GetObjectAcl(
+    GetObjectAclRequest const& request) {
+  return client_->GetObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::UpdateObjectAcl(
+    UpdateObjectAclRequest const& request) {
+  return client_->UpdateObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::PatchObjectAcl(
+    PatchObjectAclRequest const& request) {
+  return client_->PatchObjectAcl(request);
+}
+
+StatusOr<ListDefaultObjectAclResponse> CachingClient::ListDefaultObjectAcl(
+    ListDefaultObjectAclRequest const& request) {
+  return client_->ListDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::CreateDefaultObjectAcl(
+    CreateDefaultObjectAclRequest const& request) {
+  return client_->CreateDefaultObjectAcl(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteDefaultObjectAcl(
+    DeleteDefaultObjectAclRequest const& request) {
+  return client_->DeleteDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::GetDefaultObjectAcl(
+    GetDefaultObjectAclRequest const& request) {
+  return client_->GetDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::UpdateDefaultObjectAcl(
+    UpdateDefaultObjectAclRequest const& request) {
+  return client_->UpdateDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::PatchDefaultObjectAcl(
+    PatchDefaultObjectAclRequest const& request) {
+  return client_->PatchDefaultObjectAcl(request);
+}
+
+StatusOr<ServiceAccount> CachingClient::GetServiceAccount(
+    GetProjectServiceAccountRequest const& request) {
+  return client_->GetServiceAccount(request);
+}
+
+StatusOr<ListHmacKeysResponse> CachingClient::ListHmacKeys(
+    ListHmacKeysRequest const& request) {
+  return client_->ListHmacKeys(request);
+}
+
+StatusOr<CreateHmacKeyResponse> CachingClient::CreateHmacKey(
+    CreateHmacKeyRequest const& request) {
+  return client_->CreateHmacKey(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteHmacKey(
+    DeleteHmacKeyRequest const& request) {
+  return client_->DeleteHmacKey(request);
+}
+
+StatusOr<HmacKeyMetadata> CachingClient::GetHmacKey(
+    GetHmacKeyRequest const& request) {
+  return client_->GetHmacKey(request);
+}
+
+StatusOr<HmacKeyMetadata> CachingClient::UpdateHmacKey(
+    UpdateHmacKeyRequest const& request) {
+  return client_->UpdateHmacKey(request);
+}
+
+StatusOr<SignBlobResponse> CachingClient::SignBlob(
+    SignBlobRequest const& request) {
+  return client_->SignBlob(request);
+}
+
+StatusOr<ListNotificationsResponse> CachingClient::ListNotifications(
+    ListNotificationsRequest const& request) {
+  return client_->ListNotifications(request);
+}
+
+StatusOr<NotificationMetadata> CachingClient::CreateNotification(
+    CreateNotificationRequest const& request) {
+  return client_->CreateNotification(request);
+}
+
+StatusOr<NotificationMetadata> CachingClient::GetNotification(
+    GetNotificationRequest const& request) {
+  return client_->GetNotification(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteNotification(
+    DeleteNotificationRequest const& request) {
+  return client_->DeleteNotification(request);
+}
+
+StatusOr<BatchResponse> CachingClient::ExecuteBatch(
+    BatchRequest const& request) {
+  return client_->ExecuteBatch(request);
+}
+
+StatusOr<std::string> CachingClient::Download(
+    ReadObjectRangeRequest const& request, ObjectMetadata const& metadata) {
+  // Pin the generation, the contents must match the validated metadata.
+  ReadObjectRangeRequest download(request.bucket_name(), request.object_name());
+  download.set_multiple_options(Generation(metadata.generation()),
+                                request.GetOption<UserProject>());
+  auto source = client_->ReadObject(download);
+  if (!source) return std::move(source).status();
+
+  std::string contents(static_cast<std::size_t>(metadata.size()), '\0');
+  std::size_t offset = 0;
+  while (offset != contents.size()) {
+    auto result = (*source)->Read(&contents[offset], contents.size() - offset);
+    if (!result) return std::move(result).status();
+    if (result->response.status_code >= HttpStatusCode::kMinNotSuccess) {
+      return AsStatus(result->response);
+    }
+    offset += result->bytes_received;
+    if (result->response.status_code != HttpStatusCode::kContinue) break;
+  }
+  (void)(*source)->Close();
+  if (offset != contents.size()) {
+    return Status(StatusCode::kDataLoss,
+                  "short download, expected " +
+                      std::to_string(contents.size()) + " bytes, got " +
+                      std::to_string(offset));
+  }
+  if (!metadata.crc32c().empty() &&
+      ComputeCrc32cChecksum(contents) != metadata.crc32c()) {
+    return Status(StatusCode::kDataLoss, "mismatched CRC32C checksum");
+  }
+  return contents;
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,364 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/caching_client.h"
+#include "google/cloud/storage/hashing_options.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/storage/testing/random_names.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include "absl/memory/memory.h"
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <vector>
+#include <sys/stat.h>
+#if _WIN32
+#include <direct.h>
+#endif  // _WIN32
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::google::cloud::storage::testing::canonical_errors::TransientError;
+using ::testing::ByMove;
+using ::testing::Invoke;
+using ::testing::Return;
+
+ObjectMetadata MakeMetadata(std::string const& contents,
+                            std::int64_t generation) {
+  auto text = R"""({"bucket": "test-bucket", "name": "test-object")""" +
+              std::string(R"""(, "generation": ")""") +
+              std::to_string(generation) + R"""(", "size": ")""" +
+              std::to_string(contents.size()) + R"""(", "crc32c": ")""" +
+              ComputeCrc32cChecksum(contents) + R"""("})""";
+  return ObjectMetadataParser::FromString(text).value();
+}
+
+/// Returns a source that serves @p contents, in as many reads as needed.
+std::unique_ptr<ObjectReadSource> MakeSource(std::string const& contents) {
+  auto source = absl::make_unique<testing::MockObjectReadSource>();
+  auto offset = std::make_shared<std::size_t>(0);
+  EXPECT_CALL(*source, Read)
+      .WillRepeatedly(Invoke([contents, offset](char* buf, std::size_t n) {
+        n = (std::min)(n, contents.size() - *offset);
+        std::copy(contents.begin() + *offset, contents.begin() + *offset + n,
+                  buf);
+        *offset += n;
+        auto const code = *offset == contents.size()
+                              ? HttpStatusCode::kOk
+                              : HttpStatusCode::kContinue;
+        return make_status_or(ReadSourceResult{n, HttpResponse{code, {}, {}}});
+      }));
+  EXPECT_CALL(*source, Close)
+      .WillRepeatedly(Return(HttpResponse{HttpStatusCode::kOk, {}, {}}));
+  return std::unique_ptr<ObjectReadSource>(std::move(source));
+}
+
+/// Reads all the data in @p source.
+StatusOr<std::string> ReadAll(ObjectReadSource& source) {
+  std::string result;
+  std::vector<char> buffer(7);
+  for (;;) {
+    auto r = source.Read(buffer.data(), buffer.size());
+    if (!r) return std::move(r).status();
+    result.append(buffer.data(), r->bytes_received);
+    if (r->response.status_code != HttpStatusCode::kContinue) break;
+  }
+  return result;
+}
+
+class CachingClientTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto generator =
+        google::cloud::internal::DefaultPRNG(std::random_device{}());
+    directory_ = ::testing::TempDir() + testing::MakeRandomFileName(generator);
+#if _WIN32
+    ASSERT_EQ(0, ::_mkdir(directory_.c_str()));
+#else
+    ASSERT_EQ(0, ::mkdir(directory_.c_str(), 0700));
+#endif  // _WIN32
+    mock_ = std::make_shared<testing::MockClient>();
+    cache_ = std::make_shared<ObjectCache>(directory_, 1024 * 1024);
+    client_ = std::make_shared<CachingClient>(mock_, cache_, 1024);
+  }
+
+  void TearDown() override {
+    for (std::int64_t generation : {1, 2}) {
+      auto name = cache_->FileName(
+          ObjectCacheKey{"test-bucket", "test-object", generation});
+      std::remove(name.c_str());
+    }
+    std::remove(directory_.c_str());
+  }
+
+  std::string directory_;
+  std::shared_ptr<testing::MockClient> mock_;
+  std::shared_ptr<ObjectCache> cache_;
+  std::shared_ptr<CachingClient> client_;
+};
+
+TEST_F(CachingClientTest, MissThenHit) {
+  std::string const contents = "0123456789abcdefghijklmnopqrstuvwxyz";
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .Times(4)
+      .WillRepeatedly(Return(MakeMetadata(contents, 1)));
+  EXPECT_CALL(*mock_, ReadObject)
+      .WillOnce(Invoke([&](ReadObjectRangeRequest const& r) {
+        EXPECT_EQ(1, r.GetOption<Generation>().value());
+        EXPECT_FALSE(r.HasOption<ReadRange>());
+        return make_status_or(MakeSource(contents));
+      }));
+
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  for (int i = 0; i != 2; ++i) {
+    auto source = client_->ReadObject(request);
+    ASSERT_STATUS_OK(source);
+    auto actual = ReadAll(**source);
+    ASSERT_STATUS_OK(actual);
+    EXPECT_EQ(contents, *actual);
+  }
+
+  // Ranged reads are served from the cached contents too.
+  auto source = client_->ReadObject(
+      ReadObjectRangeRequest("test-bucket", "test-object")
+          .set_multiple_options(ReadRange(4, 9)));
+  ASSERT_STATUS_OK(source);
+  auto actual = ReadAll(**source);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ("45678", *actual);
+
+  source = client_->ReadObject(
+      ReadObjectRangeRequest("test-bucket", "test-object")
+          .set_multiple_options(ReadLast(3)));
+  ASSERT_STATUS_OK(source);
+  ASSERT_TRUE((*source)->CanReadBorrowed());
+  auto borrowed = (*source)->ReadBorrowed();
+  ASSERT_STATUS_OK(borrowed);
+  EXPECT_EQ("xyz", std::string(borrowed->data.data(), borrowed->data.size()));
+  EXPECT_EQ(HttpStatusCode::kOk, borrowed->response.status_code);
+
+  auto const stats = cache_->stats();
+  EXPECT_EQ(3, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+}
+
+TEST_F(CachingClientTest, FullReadsIncludeHashes) {
+  std::string const contents = "some contents";
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .WillOnce(Return(MakeMetadata(contents, 1)));
+  EXPECT_CALL(*mock_, ReadObject)
+      .WillOnce(Return(ByMove(make_status_or(MakeSource(contents)))));
+
+  auto source =
+      client_->ReadObject(ReadObjectRangeRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(source);
+  auto r = (*source)->Read(nullptr, 0);
+  ASSERT_STATUS_OK(r);
+  auto const& headers = r->response.headers;
+  EXPECT_EQ(1, headers.count("x-goog-generation"));
+  auto const hash = headers.find("x-goog-hash");
+  ASSERT_NE(headers.end(), hash);
+  EXPECT_EQ("crc32c=" + ComputeCrc32cChecksum(contents), hash->second);
+}
+
+TEST_F(CachingClientTest, NewGenerationIsDownloaded) {
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .WillOnce(Return(MakeMetadata("generation 1", 1)))
+      .WillOnce(Return(MakeMetadata("generation 2", 2)));
+  EXPECT_CALL(*mock_, ReadObject)
+      .WillOnce(Return(ByMove(make_status_or(MakeSource("generation 1")))))
+      .WillOnce(Return(ByMove(make_status_or(MakeSource("generation 2")))));
+
+  for (auto const* expected : {"generation 1", "generation 2"}) {
+    auto source = client_->ReadObject(
+        ReadObjectRangeRequest("test-bucket", "test-object"));
+    ASSERT_STATUS_OK(source);
+    auto actual = ReadAll(**source);
+    ASSERT_STATUS_OK(actual);
+    EXPECT_EQ(expected, *actual);
+  }
+}
+
+TEST_F(CachingClientTest, PreconditionsAreValidated) {
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .WillOnce(Invoke([](GetObjectMetadataRequest const& r) {
+        EXPECT_EQ(42, r.GetOption<IfGenerationMatch>().value());
+        EXPECT_EQ(7, r.GetOption<IfMetagenerationMatch>().value());
+        EXPECT_EQ("test-quota-user", r.GetOption<QuotaUser>().value());
+        EXPECT_EQ("127.0.0.1", r.GetOption<UserIp>().value());
+        return StatusOr<ObjectMetadata>(PermanentError());
+      }));
+  EXPECT_CALL(*mock_, ReadObject).Times(0);
+
+  auto source = client_->ReadObject(
+      ReadObjectRangeRequest("test-bucket", "test-object")
+          .set_multiple_options(
+              IfGenerationMatch(42), IfMetagenerationMatch(7),
+              QuotaUser("test-quota-user"), UserIp("127.0.0.1")));
+  EXPECT_EQ(PermanentError().code(), source.status().code());
+}
+
+TEST_F(CachingClientTest, EncryptedObjectsAreNotCached) {
+  EXPECT_CALL(*mock_, GetObjectMetadata).Times(0);
+  EXPECT_CALL(*mock_, ReadObject)
+      .WillOnce(Return(ByMove(make_status_or(MakeSource("secret")))));
+
+  auto source = client_->ReadObject(
+      ReadObjectRangeRequest("test-bucket", "test-object")
+          .set_multiple_options(
+              EncryptionKey::FromBinaryKey(std::string(32, 'k'))));
+  ASSERT_STATUS_OK(source);
+  EXPECT_EQ(0, cache_->stats().misses);
+}
+
+TEST_F(CachingClientTest, LargeObjectsAreNotCached) {
+  std::string const contents(2048, 'x');
+  // The metadata is fetched once, later reads go directly to the service.
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .WillOnce(Return(MakeMetadata(contents, 1)));
+  EXPECT_CALL(*mock_, ReadObject)
+      .Times(2)
+      .WillRepeatedly(Invoke([&](ReadObjectRangeRequest const& r) {
+        EXPECT_TRUE(r.HasOption<ReadRange>());
+        return make_status_or(MakeSource(contents.substr(0, 100)));
+      }));
+
+  for (int i = 0; i != 2; ++i) {
+    auto source = client_->ReadObject(
+        ReadObjectRangeRequest("test-bucket", "test-object")
+            .set_multiple_options(ReadRange(0, 100)));
+    ASSERT_STATUS_OK(source);
+  }
+  EXPECT_EQ(0, cache_->stats().insertions);
+}
+
+TEST_F(CachingClientTest, GenerationReadsSkipMetadata) {
+  std::string const contents = "0123456789";
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .Times(2)
+      .WillRepeatedly(Return(MakeMetadata(contents, 1)));
+  EXPECT_CALL(*mock_, ReadObject)
+      .WillOnce(Return(ByMove(make_status_or(MakeSource(contents)))));
+
+  // The first read fetches the metadata to verify the contents, the second
+  // read is served from the cache directly.
+  for (int i = 0; i != 2; ++i) {
+    auto source = client_->ReadObject(
+        ReadObjectRangeRequest("test-bucket", "test-object")
+            .set_multiple_options(Generation(1), ReadRange(2, 5)));
+    ASSERT_STATUS_OK(source);
+    auto actual = ReadAll(**source);
+    ASSERT_STATUS_OK(actual);
+    EXPECT_EQ("234", *actual);
+  }
+
+  // Preconditions are always validated by the service.
+  auto source = client_->ReadObject(
+      ReadObjectRangeRequest("test-bucket", "test-object")
+          .set_multiple_options(Generation(1), IfMetagenerationMatch(1)));
+  ASSERT_STATUS_OK(source);
+  auto actual = ReadAll(**source);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(contents, *actual);
+
+  auto const stats = cache_->stats();
+  EXPECT_EQ(2, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+}
+
+TEST_F(CachingClientTest, DownloadErrorFallsBack) {
+  std::string const contents = "some contents";
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .WillOnce(Return(MakeMetadata(contents, 1)));
+  EXPECT_CALL(*mock_, ReadObject)
+      .WillOnce(Return(ByMove(
+          StatusOr<std::unique_ptr<ObjectReadSource>>(TransientError()))))
+      .WillOnce(Return(ByMove(make_status_or(MakeSource(contents)))));
+
+  auto source =
+      client_->ReadObject(ReadObjectRangeRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(source);
+  auto actual = ReadAll(**source);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(contents, *actual);
+  EXPECT_EQ(0, cache_->stats().insertions);
+}
+
+TEST_F(CachingClientTest, CorruptDownloadIsNotCached) {
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .WillOnce(Return(MakeMetadata("expected", 1)));
+  EXPECT_CALL(*mock_, ReadObject)
+      .WillOnce(Return(ByMove(make_status_or(MakeSource("corrupt!")))))
+      .WillOnce(Return(ByMove(make_status_or(MakeSource("expected")))));
+
+  auto source =
+      client_->ReadObject(ReadObjectRangeRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(source);
+  EXPECT_EQ(0, cache_->stats().insertions);
+}
+
+TEST_F(CachingClientTest, CorruptedCacheIsDownloadedAgain) {
+  std::string const contents = "0123456789";
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .Times(2)
+      .WillRepeatedly(Return(MakeMetadata(contents, 1)));
+  EXPECT_CALL(*mock_, ReadObject)
+      .Times(2)
+      .WillRepeatedly(Invoke([&](ReadObjectRangeRequest const&) {
+        return make_status_or(MakeSource(contents));
+      }));
+
+  auto const request = ReadObjectRangeRequest("test-bucket", "test-object")
+                           .set_multiple_options(ReadRange(2, 5));
+  auto source = client_->ReadObject(request);
+  ASSERT_STATUS_OK(source);
+
+  // Damage the cached file, ranged reads carry no hash to detect this. A new
+  // cache, e.g. in the next run of the application, verifies the file.
+  auto const name =
+      cache_->FileName(ObjectCacheKey{"test-bucket", "test-object", 1});
+  std::ofstream(name, std::ios::binary | std::ios::trunc) << "0123XXX789";
+  cache_ = std::make_shared<ObjectCache>(directory_, 1024 * 1024);
+  client_ = std::make_shared<CachingClient>(mock_, cache_, 1024);
+
+  source = client_->ReadObject(request);
+  ASSERT_STATUS_OK(source);
+  auto actual = ReadAll(**source);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ("234", *actual);
+  EXPECT_EQ(1, cache_->stats().insertions);
+}
+
+TEST_F(CachingClientTest, OtherOperationsAreForwarded) {
+  EXPECT_CALL(*mock_, DeleteObject)
+      .WillOnce(Return(make_status_or(EmptyResponse{})));
+  EXPECT_STATUS_OK(
+      client_->DeleteObject(DeleteObjectRequest("test-bucket", "test-object")));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -63,6 +63,7 @@ inline bool operator>=(Owner const& lhs, Owner const& rhs) {
 
 namespace internal {
 class GrpcClient;
+class ObjectMetadataStreamParser;
 
 /**
  * Defines common attributes to both `BucketMetadata` and `ObjectMetadata`.
@@ -131,6 +132,7 @@ class CommonMetadata {
 
  private:
   friend class GrpcClient;
+  friend class ObjectMetadataStreamParser;
 
   // Keep the fields in alphabetical order.
   std::string etag_;
@@ -0,0 +1,50 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/const_buffer.h"
+#include <numeric>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+std::size_t TotalBytes(ConstBufferSequence const& s) {
+  return std::accumulate(
+      s.begin(), s.end(), std::size_t{0},
+      [](std::size_t a, ConstBuffer const& b) { return a + b.size(); });
+}
+
+void PopFrontBytes(ConstBufferSequence& s, std::size_t count) {
+  auto i = s.begin();
+  for (; i != s.end() && i->size() <= count; ++i) {
+    count -= i->size();
+  }
+  if (i != s.end() && count > 0) *i = i->subspan(count);
+  s.erase(s.begin(), i);
+}
+
+std::string ToString(ConstBufferSequence const& s) {
+  std::string result;
+  result.reserve(TotalBytes(s));
+  for (auto const& b : s) result.append(b.data(), b.size());
+  return result;
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,62 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CONST_BUFFER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CONST_BUFFER_H
+
+#include "google/cloud/storage/version.h"
+#include "absl/types/span.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+/**
+ * A non-owning view of a contiguous block of bytes to upload.
+ *
+ * Implicitly constructible from `std::string`, `std::vector<char>`, and any
+ * other contiguous container of `char`. The caller must keep the underlying
+ * storage alive (and unchanged) while the view is in use.
+ */
+using ConstBuffer = absl::Span<char const>;
+
+/**
+ * A sequence of non-owning buffers, sent as a single logical payload.
+ *
+ * This allows the upload functions to send data from multiple (and reused)
+ * buffers without concatenating them into a single `std::string` first.
+ */
+using ConstBufferSequence = std::vector<ConstBuffer>;
+
+/// Returns the total number of bytes in @p s.
+std::size_t TotalBytes(ConstBufferSequence const& s);
+
+/// Removes the first @p count bytes from @p s, the bytes are not modified.
+void PopFrontBytes(ConstBufferSequence& s, std::size_t count);
+
+/// Copies the contents of @p s into a single string, mostly for tests.
+std::string ToString(ConstBufferSequence const& s);
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CONST_BUFFER_H
@@ -0,0 +1,68 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/const_buffer.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+TEST(ConstBufferTest, TotalBytes) {
+  EXPECT_EQ(0, TotalBytes({}));
+  std::string const b0(16, 'a');
+  std::string const b1(32, 'b');
+  EXPECT_EQ(48, TotalBytes({b0, ConstBuffer{}, b1}));
+}
+
+TEST(ConstBufferTest, PopFrontBytes) {
+  std::string const b0 = "abc";
+  std::string const b1 = "defgh";
+  std::string const b2 = "ij";
+  ConstBufferSequence s{b0, b1, b2};
+
+  PopFrontBytes(s, 0);
+  EXPECT_EQ("abcdefghij", ToString(s));
+  PopFrontBytes(s, 2);
+  EXPECT_EQ("cdefghij", ToString(s));
+  EXPECT_EQ(3, s.size());
+  PopFrontBytes(s, 1);
+  EXPECT_EQ("defghij", ToString(s));
+  EXPECT_EQ(2, s.size());
+  PopFrontBytes(s, 6);
+  EXPECT_EQ("j", ToString(s));
+  EXPECT_EQ(1, s.size());
+  PopFrontBytes(s, 1);
+  EXPECT_TRUE(s.empty());
+  PopFrontBytes(s, 1);
+  EXPECT_TRUE(s.empty());
+}
+
+TEST(ConstBufferTest, PopFrontBytesDoesNotCopy) {
+  std::string const b0 = "abcdef";
+  ConstBufferSequence s{b0};
+  PopFrontBytes(s, 2);
+  ASSERT_EQ(1, s.size());
+  EXPECT_EQ(b0.data() + 2, s.front().data());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,81 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/crc32c_combine.h"
+#include <array>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+// The CRC32C (Castagnoli) polynomial, in reversed bit order.
+std::uint32_t constexpr kCrc32cPolynomial = 0x82F63B78U;
+
+// A 32x32 matrix over GF(2), each element is a column.
+using Gf2Matrix = std::array<std::uint32_t, 32>;
+
+std::uint32_t Gf2MatrixTimes(Gf2Matrix const& mat, std::uint32_t vec) {
+  std::uint32_t sum = 0;
+  for (auto i = mat.begin(); vec != 0; vec >>= 1, ++i) {
+    if ((vec & 1U) != 0) sum ^= *i;
+  }
+  return sum;
+}
+
+void Gf2MatrixSquare(Gf2Matrix& square, Gf2Matrix const& mat) {
+  for (std::size_t n = 0; n != mat.size(); ++n) {
+    square[n] = Gf2MatrixTimes(mat, mat[n]);
+  }
+}
+}  // namespace
+
+std::uint32_t Crc32cCombine(std::uint32_t crc1, std::uint32_t crc2,
+                            std::uint64_t len2) {
+  if (len2 == 0) return crc1;
+
+  // `odd` is the operator that feeds a single zero bit into the CRC register.
+  Gf2Matrix odd;
+  odd[0] = kCrc32cPolynomial;
+  std::uint32_t row = 1;
+  for (std::size_t n = 1; n != odd.size(); ++n) {
+    odd[n] = row;
+    row <<= 1;
+  }
+  Gf2Matrix even;
+  Gf2MatrixSquare(even, odd);  // two zero bits
+  Gf2MatrixSquare(odd, even);  // four zero bits
+
+  // Apply `len2` zero bytes to `crc1`, each iteration squares the operator,
+  // and applies it if the corresponding bit in `len2` is set.
+  for (;;) {
+    Gf2MatrixSquare(even, odd);
+    if ((len2 & 1U) != 0) crc1 = Gf2MatrixTimes(even, crc1);
+    len2 >>= 1;
+    if (len2 == 0) break;
+
+    Gf2MatrixSquare(odd, even);
+    if ((len2 & 1U) != 0) crc1 = Gf2MatrixTimes(odd, crc1);
+    len2 >>= 1;
+    if (len2 == 0) break;
+  }
+  return crc1 ^ crc2;
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,51 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CRC32C_COMBINE_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CRC32C_COMBINE_H
+
+#include "google/cloud/storage/version.h"
+#include <cstdint>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * Computes the CRC32C checksum of the concatenation of two blocks of data.
+ *
+ * Given `crc1 == crc32c::Extend(0, A, len(A))` and
+ * `crc2 == crc32c::Extend(0, B, len(B))` this returns
+ * `crc32c::Extend(0, A + B, len(A) + len(B))`, without access to `A` or `B`.
+ * This allows applications to compute the checksum of separate ranges in
+ * parallel, and then combine the results into the checksum of the full object.
+ *
+ * The algorithm runs in O(log(len2)) time, it is the same algorithm used by
+ * `crc32_combine()` in zlib, with the CRC32C polynomial.
+ *
+ * @param crc1 the checksum of the first block.
+ * @param crc2 the checksum of the second block.
+ * @param len2 the length of the second block.
+ */
+std::uint32_t Crc32cCombine(std::uint32_t crc1, std::uint32_t crc2,
+                            std::uint64_t len2);
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CRC32C_COMBINE_H
@@ -0,0 +1,72 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/crc32c_combine.h"
+#include <crc32c/crc32c.h>
+#include <gmock/gmock.h>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+std::uint32_t Crc32c(std::string const& s) {
+  return crc32c::Extend(0, reinterpret_cast<std::uint8_t const*>(s.data()),
+                        s.size());
+}
+
+TEST(Crc32cCombine, Empty) {
+  auto const crc = Crc32c("The quick brown fox jumps over the lazy dog");
+  EXPECT_EQ(crc, Crc32cCombine(crc, Crc32c(""), 0));
+  EXPECT_EQ(crc, Crc32cCombine(Crc32c(""), crc, 43));
+}
+
+TEST(Crc32cCombine, Simple) {
+  std::string const a = "The quick brown fox ";
+  std::string const b = "jumps over the lazy dog";
+  EXPECT_EQ(Crc32c(a + b), Crc32cCombine(Crc32c(a), Crc32c(b), b.size()));
+}
+
+TEST(Crc32cCombine, ManySplits) {
+  std::string data;
+  for (int i = 0; i != 4096; ++i) data.push_back(static_cast<char>(i * 7));
+  auto const expected = Crc32c(data);
+  for (std::size_t split : {1, 7, 128, 1000, 2048, 4095}) {
+    auto const a = data.substr(0, split);
+    auto const b = data.substr(split);
+    EXPECT_EQ(expected, Crc32cCombine(Crc32c(a), Crc32c(b), b.size()))
+        << "split=" << split;
+  }
+}
+
+TEST(Crc32cCombine, SeveralBlocks) {
+  std::string const blocks[] = {"abc", "defghij", "", "klmnopqrstu", "vwxyz"};
+  std::string full;
+  std::uint32_t combined = 0;
+  for (auto const& b : blocks) {
+    full += b;
+    combined = Crc32cCombine(combined, Crc32c(b), b.size());
+  }
+  EXPECT_EQ(Crc32c(full), combined);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "google/cloud/storage/internal/curl_client.h"
+#include "google/cloud/storage/internal/curl_event_loop.h"
 #include "google/cloud/storage/internal/curl_request_builder.h"
 #include "google/cloud/storage/internal/curl_resumable_upload_session.h"
 #include "google/cloud/storage/internal/generate_message_boundary.h"
@@ -22,6 +23,7 @@
 #include "google/cloud/internal/getenv.h"
 #include "google/cloud/terminate_handler.h"
 #include "absl/memory/memory.h"
+#include <algorithm>
 #include <sstream>
 
 namespace google {
@@ -38,7 +40,9 @@ std::shared_ptr<CurlHandleFactory> CreateHandleFactory(
         options.channel_options());
   }
   return std::make_shared<PooledCurlHandleFactory>(
-      options.connection_pool_size(), options.channel_options());
+      options.connection_pool_size(), options.channel_options(),
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          options.connection_pool_idle_timeout()));
 }
 
 std::string UrlEscapeString(std::string const& value) {
@@ -100,6 +104,7 @@ Status CurlClient::SetupBuilderCommon(CurlRequestBuilder& builder,
   }
   builder.SetMethod(method)
       .ApplyClientOptions(options_)
+      .SetTransferTuner(tuner_)
       .AddHeader(auth_header.value())
       .AddHeader("x-goog-api-client: " + x_goog_api_client());
   return Status();
@@ -234,6 +239,8 @@ CurlClient::CurlClient(ClientOptions options)
       xml_upload_factory_(CreateHandleFactory(options_)),
       xml_download_factory_(CreateHandleFactory(options_)) {
   storage_endpoint_ = options_.endpoint() + "/storage/" + options_.version();
+  batch_endpoint_ =
+      options_.endpoint() + "/batch/storage/" + options_.version();
   upload_endpoint_ =
       options_.endpoint() + "/upload/storage/" + options_.version();
   iam_endpoint_ = options_.iam_endpoint();
@@ -250,6 +257,167 @@ CurlClient::CurlClient(ClientOptions options)
   }
 
   CurlInitializeOnce(options);
+
+  if (options_.enable_adaptive_transfer_tuning()) {
+    tuner_ = std::make_shared<TransferTuner>(
+        options_.upload_buffer_size(),
+        options_.maximum_adaptive_upload_buffer_size());
+  }
+
+  auto const warmup = options_.connection_pool_warmup_size();
+  if (warmup != 0) {
+    // Most requests use these endpoints, establish the connections before the
+    // application needs them. This can take as long as the connection
+    // timeout, do not block the constructor: requests issued in the meantime
+    // create their own connections.
+    auto storage_factory = storage_factory_;
+    auto storage_endpoint = storage_endpoint_;
+    auto upload_factory = upload_factory_;
+    auto upload_endpoint = upload_endpoint_;
+    warmup_thread_ = std::thread([=] {
+      storage_factory->Warmup(storage_endpoint, warmup);
+      upload_factory->Warmup(upload_endpoint, warmup);
+    });
+  }
+}
+
+std::size_t CurlClient::upload_buffer_size() const {
+  if (!tuner_) return options_.upload_buffer_size();
+  return tuner_->UploadChunkSize();
+}
+
+ConnectionPoolStats CurlClient::connection_pool_stats() const {
+  // Without a connection pool all the factories are the same (process-wide)
+  // `DefaultCurlHandleFactory`, count each factory only once.
+  std::vector<CurlHandleFactory const*> factories;
+  for (auto const& factory : {storage_factory_, upload_factory_,
+                              xml_upload_factory_, xml_download_factory_}) {
+    if (std::find(factories.begin(), factories.end(), factory.get()) ==
+        factories.end()) {
+      factories.push_back(factory.get());
+    }
+  }
+  ConnectionPoolStats result;
+  for (auto const* factory : factories) {
+    auto stats = factory->Stats();
+    result.handles_created += stats.handles_created;
+    result.handles_reused += stats.handles_reused;
+    result.handles_expired += stats.handles_expired;
+    result.handles_overflowed += stats.handles_overflowed;
+    result.transfer_failures += stats.transfer_failures;
+    result.warmup_failures += stats.warmup_failures;
+    result.connection_count += stats.connection_count;
+    result.handshake_time += stats.handshake_time;
+    result.idle_handles.insert(result.idle_handles.end(),
+                               stats.idle_handles.begin(),
+                               stats.idle_handles.end());
+  }
+  return result;
+}
+
+CurlClient::~CurlClient() {
+  // The event loops may outlive this object, as pending operations hold a
+  // reference to them. This stops their background threads, cancelling any
+  // pending operations.
+  for (auto& loop : event_loops_) loop->Shutdown();
+  if (warmup_thread_.joinable()) {
+    // Do not wait for the connections, the warm-up is only an optimization.
+    storage_factory_->CancelWarmup();
+    upload_factory_->CancelWarmup();
+    warmup_thread_.join();
+  }
+}
+
+std::shared_ptr<CurlEventLoop> CurlClient::PickEventLoop() {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (event_loops_.empty()) {
+    auto const size =
+        (std::max)(std::size_t{1}, options_.background_thread_pool_size());
+    event_loops_.reserve(size);
+    for (std::size_t i = 0; i != size; ++i) {
+      event_loops_.push_back(CurlEventLoop::Create());
+    }
+  }
+  auto loop = event_loops_[next_event_loop_];
+  next_event_loop_ = (next_event_loop_ + 1) % event_loops_.size();
+  return loop;
+}
+
+future<StatusOr<ObjectMetadata>> CurlClient::AsyncGetObjectMetadata(
+    GetObjectMetadataRequest const& request) {
+  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket_name() +
+                                 "/o/" + UrlEscapeString(request.object_name()),
+                             storage_factory_);
+  auto status = SetupBuilder(builder, request, "GET");
+  if (!status.ok()) {
+    return make_ready_future(StatusOr<ObjectMetadata>(std::move(status)));
+  }
+  return PickEventLoop()
+      ->MakeRequest(builder.BuildRequest(), std::string{})
+      .then([](future<StatusOr<HttpResponse>> f) {
+        return CheckedFromString<ObjectMetadataParser>(f.get());
+      });
+}
+
+future<StatusOr<std::string>> CurlClient::AsyncReadObject(
+    ReadObjectRangeRequest const& request) {
+  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket_name() +
+                                 "/o/" + UrlEscapeString(request.object_name()),
+                             storage_factory_);
+  auto status = SetupBuilder(builder, request, "GET");
+  if (!status.ok()) {
+    return make_ready_future(StatusOr<std::string>(std::move(status)));
+  }
+  builder.AddQueryParameter("alt", "media");
+  if (request.RequiresRangeHeader()) {
+    builder.AddHeader(request.RangeHeader());
+  }
+  if (request.RequiresNoCache()) {
+    builder.AddHeader("Cache-Control: no-transform");
+  }
+  // We need a copyable type to capture the validator in a C++11 lambda.
+  std::shared_ptr<HashValidator> validator = CreateHashValidator(request);
+  return PickEventLoop()
+      ->MakeRequest(builder.BuildRequest(), std::string{})
+      .then([validator](future<StatusOr<HttpResponse>> f)
+                -> StatusOr<std::string> {
+        auto response = f.get();
+        if (!response.ok()) {
+          return std::move(response).status();
+        }
+        if (response->status_code >= HttpStatusCode::kMinNotSuccess) {
+          return AsStatus(*response);
+        }
+        for (auto const& kv : response->headers) {
+          validator->ProcessHeader(kv.first, kv.second);
+        }
+        validator->Update(response->payload.data(), response->payload.size());
+        auto result = std::move(*validator).Finish();
+        if (result.is_mismatch) {
+          return Status(StatusCode::kDataLoss,
+                        "AsyncReadObject(): mismatched hashes in download," +
+                            std::string(" computed=") + result.computed +
+                            ", received=" + result.received);
+        }
+        return std::move(response->payload);
+      });
+}
+
+future<StatusOr<ObjectMetadata>> CurlClient::AsyncInsertObjectMedia(
+    InsertObjectMediaRequest const& request) {
+  // Always use multipart uploads, they support all the options and send the
+  // object hashes (when enabled) for validation.
+  CurlRequestBuilder builder(
+      upload_endpoint_ + "/b/" + request.bucket_name() + "/o", upload_factory_);
+  auto payload = SetupInsertObjectMediaMultipart(builder, request);
+  if (!payload) {
+    return make_ready_future(StatusOr<ObjectMetadata>(payload.status()));
+  }
+  return PickEventLoop()
+      ->MakeRequest(builder.BuildRequest(), *std::move(payload))
+      .then([](future<StatusOr<HttpResponse>> f) {
+        return CheckedFromString<ObjectMetadataParser>(f.get());
+      });
 }
 
 StatusOr<ResumableUploadResponse> CurlClient::UploadChunk(
@@ -262,8 +430,8 @@ StatusOr<ResumableUploadResponse> CurlClient::UploadChunk(
   builder.AddHeader(request.RangeHeader());
   builder.AddHeader("Content-Type: application/octet-stream");
   builder.AddHeader("Content-Length: " +
-                    std::to_string(request.payload().size()));
-  auto response = builder.BuildRequest().MakeRequest(request.payload());
+                    std::to_string(request.payload_size()));
+  auto response = builder.BuildRequest().MakeUploadRequest(request.payload());
   if (!response.ok()) {
     return std::move(response).status();
   }
@@ -1145,6 +1313,39 @@ StatusOr<EmptyResponse> CurlClient::DeleteNotification(
   return ReturnEmptyResponse(builder.BuildRequest().MakeRequest(std::string{}));
 }
 
+StatusOr<BatchResponse> CurlClient::ExecuteBatch(BatchRequest const& request) {
+  if (request.empty() || request.size() > BatchRequest::kMaxBatchSize) {
+    std::ostringstream os;
+    os << "Batch requests must contain between 1 and "
+       << BatchRequest::kMaxBatchSize << " sub-requests, got "
+       << request.size();
+    return Status(StatusCode::kInvalidArgument, std::move(os).str());
+  }
+  CurlRequestBuilder builder(batch_endpoint_, storage_factory_);
+  auto status = SetupBuilderCommon(builder, "POST");
+  if (!status.ok()) {
+    return status;
+  }
+  // The boundary must not appear in any of the sub-requests.
+  std::string contents;
+  for (auto const& part : request.parts()) {
+    contents += part.path;
+    for (auto const& h : part.headers) contents += h;
+    contents += part.payload;
+  }
+  auto boundary = PickBoundary(contents);
+  builder.AddHeader("Content-Type: multipart/mixed; boundary=" + boundary);
+  auto response = builder.BuildRequest().MakeRequest(
+      request.Payload(boundary, "/storage/" + options_.version()));
+  if (!response.ok()) {
+    return std::move(response).status();
+  }
+  if (response->status_code >= HttpStatusCode::kMinNotSuccess) {
+    return AsStatus(*response);
+  }
+  return BatchResponse::FromHttpResponse(*response, request.size());
+}
+
 StatusOr<ObjectMetadata> CurlClient::InsertObjectMediaXml(
     InsertObjectMediaRequest const& request) {
   CurlRequestBuilder builder(xml_upload_endpoint_ + "/" +
@@ -1286,12 +1487,22 @@ StatusOr<std::unique_ptr<ObjectReadSource>> CurlClient::ReadObjectXml(
 
 StatusOr<ObjectMetadata> CurlClient::InsertObjectMediaMultipart(
     InsertObjectMediaRequest const& request) {
+  CurlRequestBuilder builder(
+      upload_endpoint_ + "/b/" + request.bucket_name() + "/o", upload_factory_);
+  auto contents = SetupInsertObjectMediaMultipart(builder, request);
+  if (!contents) {
+    return std::move(contents).status();
+  }
+  return CheckedFromString<ObjectMetadataParser>(
+      builder.BuildRequest().MakeRequest(*contents));
+}
+
+StatusOr<std::string> CurlClient::SetupInsertObjectMediaMultipart(
+    CurlRequestBuilder& builder, InsertObjectMediaRequest const& request) {
   // To perform a multipart upload we need to separate the parts using:
   //   https://cloud.google.com/storage/docs/json_api/v1/how-tos/multipart-upload
   // This function is structured as follows:
-  // 1. Create a request object, as we often do.
-  CurlRequestBuilder builder(
-      upload_endpoint_ + "/b/" + request.bucket_name() + "/o", upload_factory_);
+  // 1. Setup the request object, as we often do.
   auto status = SetupBuilder(builder, request, "POST");
   if (!status.ok()) {
     return status;
@@ -1344,11 +1555,10 @@ StatusOr<ObjectMetadata> CurlClient::InsertObjectMediaMultipart(
   }
   writer << crlf << request.contents() << crlf << marker << "--" << crlf;
 
-  // 6. Return the results as usual.
+  // 6. Return the payload, the caller makes the request.
   auto contents = std::move(writer).str();
   builder.AddHeader("Content-Length: " + std::to_string(contents.size()));
-  return CheckedFromString<ObjectMetadataParser>(
-      builder.BuildRequest().MakeRequest(contents));
+  return contents;
 }
 
 std::string CurlClient::PickBoundary(std::string const& text_to_avoid) {
@@ -18,16 +18,21 @@
 #include "google/cloud/storage/internal/curl_handle_factory.h"
 #include "google/cloud/storage/internal/raw_client.h"
 #include "google/cloud/storage/internal/resumable_upload_session.h"
+#include "google/cloud/storage/internal/transfer_tuner.h"
 #include "google/cloud/storage/oauth2/credentials.h"
 #include "google/cloud/storage/version.h"
+#include "google/cloud/future.h"
 #include "google/cloud/internal/random.h"
 #include <mutex>
+#include <thread>
+#include <vector>
 
 namespace google {
 namespace cloud {
 namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace internal {
+class CurlEventLoop;
 class CurlRequestBuilder;
 
 /**
@@ -45,6 +50,8 @@ class CurlClient : public RawClient,
     return Create(ClientOptions(std::move(credentials)));
   }
 
+  ~CurlClient() override;
+
   CurlClient(CurlClient const& rhs) = delete;
   CurlClient(CurlClient&& rhs) = delete;
   CurlClient& operator=(CurlClient const& rhs) = delete;
@@ -67,7 +74,36 @@ class CurlClient : public RawClient,
       QueryResumableUploadRequest const&);
   //@}
 
+  //@{
+  /**
+   * @name Asynchronous operations.
+   *
+   * These member functions are not inherited from RawClient, they are used by
+   * `storage_experimental::AsyncClient`. All the transfers share a small pool
+   * of `CurlEventLoop` objects, each one with its own background thread and
+   * `CURLM*` handle. The size of the pool is controlled by
+   * `ClientOptions::background_thread_pool_size()`.
+   *
+   * These operations do not retry, and their futures are satisfied in one of
+   * the background threads.
+   */
+  future<StatusOr<ObjectMetadata>> AsyncGetObjectMetadata(
+      GetObjectMetadataRequest const& request);
+  future<StatusOr<std::string>> AsyncReadObject(
+      ReadObjectRangeRequest const& request);
+  future<StatusOr<ObjectMetadata>> AsyncInsertObjectMedia(
+      InsertObjectMediaRequest const& request);
+  //@}
+
   ClientOptions const& client_options() const override { return options_; }
+  std::size_t upload_buffer_size() const override;
+  /**
+   * Returns the counters for the connection pools used by this client.
+   *
+   * The counters are aggregated over all the pools, the `idle_handles` field
+   * includes the handles in all the pools.
+   */
+  ConnectionPoolStats connection_pool_stats() const override;
 
   StatusOr<ListBucketsResponse> ListBuckets(
       ListBucketsRequest const& request) override;
@@ -177,6 +213,8 @@ class CurlClient : public RawClient,
   StatusOr<EmptyResponse> DeleteNotification(
       DeleteNotificationRequest const&) override;
 
+  StatusOr<BatchResponse> ExecuteBatch(BatchRequest const& request) override;
+
   void LockShared(curl_lock_data data);
   void UnlockShared(curl_lock_data data);
 
@@ -202,6 +240,9 @@ class CurlClient : public RawClient,
   /// Insert an object using uploadType=multipart.
   StatusOr<ObjectMetadata> InsertObjectMediaMultipart(
       InsertObjectMediaRequest const& request);
+  /// Setup @p builder for a uploadType=multipart request, returns the payload.
+  StatusOr<std::string> SetupInsertObjectMediaMultipart(
+      CurlRequestBuilder& builder, InsertObjectMediaRequest const& request);
   std::string PickBoundary(std::string const& text_to_avoid);
 
   /// Insert an object using uploadType=media.
@@ -212,8 +253,12 @@ class CurlClient : public RawClient,
   StatusOr<std::unique_ptr<ResumableUploadSession>>
   CreateResumableSessionGeneric(RequestType const& request);
 
+  /// Pick one of the event loops for an asynchronous operation.
+  std::shared_ptr<CurlEventLoop> PickEventLoop();
+
   ClientOptions options_;
   std::string storage_endpoint_;
+  std::string batch_endpoint_;
   std::string upload_endpoint_;
   std::string xml_upload_endpoint_;
   std::string xml_download_endpoint_;
@@ -226,6 +271,18 @@ class CurlClient : public RawClient,
   std::shared_ptr<CurlHandleFactory> upload_factory_;
   std::shared_ptr<CurlHandleFactory> xml_upload_factory_;
   std::shared_ptr<CurlHandleFactory> xml_download_factory_;
+
+  // Only created if the adaptive transfer tuning is enabled.
+  std::shared_ptr<TransferTuner> tuner_;
+
+  // The event loops are created on demand, most applications do not use
+  // asynchronous operations.
+  std::vector<std::shared_ptr<CurlEventLoop>> event_loops_;  // GUARDED_BY(mu_)
+  std::size_t next_event_loop_ = 0;                          // GUARDED_BY(mu_)
+
+  // Establishes the warm-up connections. The destructor cancels the warm-up
+  // and joins this thread.
+  std::thread warmup_thread_;
 };
 
 }  // namespace internal
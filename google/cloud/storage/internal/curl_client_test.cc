@@ -97,7 +97,7 @@ TEST_P(CurlClientTest, UploadChunk) {
   auto actual =
       client_
           ->UploadChunk(UploadChunkRequest(
-              "http://localhost:1/invalid-session-id", 0, std::string{}, 0))
+              "http://localhost:1/invalid-session-id", 0, {}, 0))
           .status();
   CheckStatus(actual);
 }
@@ -499,12 +499,60 @@ TEST_P(CurlClientTest, DeleteNotification) {
   CheckStatus(actual);
 }
 
+TEST_P(CurlClientTest, ExecuteBatch) {
+  BatchRequest batch;
+  batch.AddDeleteObject(DeleteObjectRequest("bkt", "obj-1"));
+  batch.AddDeleteObject(DeleteObjectRequest("bkt", "obj-2"));
+  auto actual = client_->ExecuteBatch(batch).status();
+  CheckStatus(actual);
+}
+
+TEST_P(CurlClientTest, ExecuteBatchInvalidSize) {
+  auto actual = client_->ExecuteBatch(BatchRequest{}).status();
+  EXPECT_EQ(StatusCode::kInvalidArgument, actual.code());
+}
+
 INSTANTIATE_TEST_SUITE_P(CredentialsFailure, CurlClientTest,
                          ::testing::Values("credentials-failure"));
 
 INSTANTIATE_TEST_SUITE_P(LibCurlFailure, CurlClientTest,
                          ::testing::Values("libcurl-failure"));
 
+TEST(CurlClientUploadBufferSizeTest, Default) {
+  auto client = CurlClient::Create(
+      ClientOptions(oauth2::CreateAnonymousCredentials())
+          .SetUploadBufferSize(4 * 1024 * 1024L));
+  EXPECT_EQ(4 * 1024 * 1024L, client->upload_buffer_size());
+}
+
+TEST(CurlClientUploadBufferSizeTest, AdaptiveTuning) {
+  // Before any transfer completes the tuned size is the configured minimum,
+  // rounded up to a valid chunk size.
+  auto client = CurlClient::Create(
+      ClientOptions(oauth2::CreateAnonymousCredentials())
+          .SetUploadBufferSize(1000 * 1000L)
+          .set_enable_adaptive_transfer_tuning(true));
+  EXPECT_EQ(4 * 256 * 1024L, client->upload_buffer_size());
+}
+
+TEST(CurlClientConnectionPoolStatsTest, NoPool) {
+  // Without a connection pool each request creates a new handle, and that
+  // handle must be counted only once.
+  auto client = CurlClient::Create(
+      ClientOptions(oauth2::CreateAnonymousCredentials())
+          .set_endpoint("http://localhost:1")
+          .set_connection_pool_size(0));
+  auto actual =
+      client->GetObjectMetadata(GetObjectMetadataRequest("bkt", "obj"));
+  EXPECT_FALSE(actual.ok());
+
+  auto stats = client->connection_pool_stats();
+  EXPECT_EQ(1, stats.handles_created);
+  EXPECT_EQ(0, stats.handles_reused);
+  EXPECT_EQ(1, stats.transfer_failures);
+  EXPECT_TRUE(stats.idle_handles.empty());
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
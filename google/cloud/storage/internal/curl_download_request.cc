@@ -50,7 +50,8 @@ extern "C" std::size_t CurlDownloadRequestHeader(char* contents,
   GCP_LOG(TRACE) << __func__ << "(), buffer_size_=" << buffer_size_         \
                  << ", buffer_offset_=" << buffer_offset_                   \
                  << ", spill_.size()=" << spill_.size()                     \
-                 << ", spill_offset_=" << spill_offset_                     \
+                 << ", spill_begin_=" << spill_begin_                       \
+                 << ", spill_end_=" << spill_end_                           \
                  << ", closing=" << closing_ << ", closed=" << curl_closed_ \
                  << ", paused=" << paused_ << ", in_multi=" << in_multi_
 
@@ -205,15 +206,19 @@ StatusOr<ReadSourceResult> CurlDownloadRequest::Read(char* buf, std::size_t n) {
 
 void CurlDownloadRequest::SetOptions() {
   // We get better performance using a slightly larger buffer (128KiB) than the
-  // default buffer size set by libcurl (16KiB)
-  auto constexpr kDefaultBufferSize = 128 * 1024L;
+  // default buffer size set by libcurl (16KiB), unless the tuner has a better
+  // estimate.
+  // NOLINTNEXTLINE(google-runtime-int) - libcurl *requires* `long`
+  auto const buffer_size = static_cast<long>(
+      tuner_ ? tuner_->CurlBufferSize()
+             : TransferTuner::kDefaultCurlBufferSize);
 
   handle_.SetOption(CURLOPT_URL, url_.c_str());
   handle_.SetOption(CURLOPT_HTTPHEADER, headers_.get());
   handle_.SetOption(CURLOPT_USERAGENT, user_agent_.c_str());
   handle_.SetOption(CURLOPT_NOSIGNAL, 1L);
   handle_.SetOption(CURLOPT_NOPROGRESS, 1L);
-  handle_.SetOption(CURLOPT_BUFFERSIZE, kDefaultBufferSize);
+  handle_.SetOption(CURLOPT_BUFFERSIZE, buffer_size);
   if (!payload_.empty()) {
     handle_.SetOption(CURLOPT_POSTFIELDSIZE, payload_.length());
     handle_.SetOption(CURLOPT_POSTFIELDS, payload_.c_str());
@@ -244,12 +249,18 @@ void CurlDownloadRequest::SetOptions() {
 
 void CurlDownloadRequest::DrainSpillBuffer() {
   std::size_t free = buffer_size_ - buffer_offset_;
-  auto copy_count = (std::min)(free, spill_offset_);
-  std::memcpy(buffer_ + buffer_offset_, spill_.data(), copy_count);
+  auto copy_count = (std::min)(free, spill_end_ - spill_begin_);
+  if (copy_count == 0) return;
+  std::memcpy(buffer_ + buffer_offset_, spill_.data() + spill_begin_,
+              copy_count);
   buffer_offset_ += copy_count;
-  std::memmove(spill_.data(), spill_.data() + copy_count,
-               spill_.size() - copy_count);
-  spill_offset_ -= copy_count;
+  spill_begin_ += copy_count;
+  if (spill_begin_ == spill_end_) {
+    // The spill buffer is empty, the next WriteCallback() can reuse it from
+    // the beginning.
+    spill_begin_ = 0;
+    spill_end_ = 0;
+  }
 }
 
 std::size_t CurlDownloadRequest::WriteCallback(void* ptr, std::size_t size,
@@ -290,9 +301,12 @@ std::size_t CurlDownloadRequest::WriteCallback(void* ptr, std::size_t size,
   // Copy as much as possible from `ptr` into the application buffer.
   std::memcpy(buffer_ + buffer_offset_, ptr, free);
   buffer_offset_ += free;
-  spill_offset_ = size * nmemb - free;
-  // The rest goes into the spill buffer.
-  std::memcpy(spill_.data(), static_cast<char*>(ptr) + free, spill_offset_);
+  // The rest goes into the spill buffer, which must be empty at this point
+  // because `DrainSpillBuffer()` left some free space in the application
+  // buffer.
+  spill_begin_ = 0;
+  spill_end_ = size * nmemb - free;
+  std::memcpy(spill_.data(), static_cast<char*>(ptr) + free, spill_end_);
   TRACE_STATE() << ", n=" << size * nmemb << ", free=" << free;
   return size * nmemb;
 }
@@ -347,6 +361,12 @@ StatusOr<int> CurlDownloadRequest::PerformWork() {
       // Whatever the status is, the transfer is done, we need to remove it
       // from the CURLM* interface.
       curl_closed_ = true;
+      // Downloads closed by the application are excluded, their throughput
+      // measures the application and not the network.
+      if (tuner_ && status.ok() && !closing_) {
+        auto sample = handle_.GetTransferSample();
+        if (sample) tuner_->OnTransfer(*sample);
+      }
       Status multi_remove_status;
       if (in_multi_) {
         // In the extremely unlikely case that removing the handle from CURLM*
@@ -57,7 +57,9 @@ class CurlDownloadRequest : public ObjectReadSource {
   CurlDownloadRequest(CurlDownloadRequest&&) = default;
   CurlDownloadRequest& operator=(CurlDownloadRequest&& rhs) = default;
 
-  bool IsOpen() const override { return !(curl_closed_ && spill_offset_ == 0); }
+  bool IsOpen() const override {
+    return !(curl_closed_ && spill_begin_ == spill_end_);
+  }
   StatusOr<HttpResponse> Close() override;
 
   /**
@@ -116,6 +118,7 @@ class CurlDownloadRequest : public ObjectReadSource {
   CurlHandle handle_;
   CurlMulti multi_;
   std::shared_ptr<CurlHandleFactory> factory_;
+  std::shared_ptr<TransferTuner> tuner_;
 
   // Explicitly closing the handle happens in two steps.
   // 1. First the application (or higher-level class), calls Close(). This class
@@ -150,8 +153,14 @@ class CurlDownloadRequest : public ObjectReadSource {
   // less bytes read aborts the download (we do that on a Close(), but in
   // general we do not). The application may have requested less bytes in the
   // call to `Read()`, so we need a place to store the additional bytes.
+  //
+  // The valid data in the spill buffer is the range
+  // `[spill_begin_, spill_end_)`. Draining the buffer only advances
+  // `spill_begin_`, this avoids moving the remaining bytes to the front of the
+  // buffer on each (possibly small) `Read()`.
   std::vector<char> spill_;
-  std::size_t spill_offset_ = 0;
+  std::size_t spill_begin_ = 0;
+  std::size_t spill_end_ = 0;
 };
 
 }  // namespace internal
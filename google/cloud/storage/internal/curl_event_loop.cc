@@ -0,0 +1,210 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/curl_event_loop.h"
+#include "google/cloud/log.h"
+#include <curl/multi.h>
+#include <sstream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+Status AsStatus(CURLMcode result, char const* where) {
+  if (result == CURLM_OK) {
+    return Status();
+  }
+  std::ostringstream os;
+  os << where << "(): unexpected error code in curl_multi_*, [" << result
+     << "]=" << curl_multi_strerror(result);
+  return Status(StatusCode::kUnknown, std::move(os).str());
+}
+
+Status CancelledStatus() {
+  return Status(StatusCode::kCancelled, "CurlEventLoop is shutting down");
+}
+}  // namespace
+
+struct CurlEventLoop::Operation {
+  CurlRequest request;
+  std::string payload;
+  promise<StatusOr<HttpResponse>> done;
+};
+
+std::shared_ptr<CurlEventLoop> CurlEventLoop::Create() {
+  // Cannot use std::make_shared because the constructor is private.
+  auto loop = std::shared_ptr<CurlEventLoop>(new CurlEventLoop);
+  // The thread holds a reference to the loop, this prevents deleting the loop
+  // while the thread is running.
+  loop->thread_ = std::thread(
+      [](std::shared_ptr<CurlEventLoop> self) { self->Run(); }, loop);
+  return loop;
+}
+
+CurlEventLoop::CurlEventLoop()
+    : multi_(curl_multi_init(), &curl_multi_cleanup) {}
+
+CurlEventLoop::~CurlEventLoop() {
+  // The last reference may be released by the background thread itself, we
+  // cannot join the thread in that case.
+  if (thread_.get_id() == std::this_thread::get_id()) {
+    thread_.detach();
+  } else if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+future<StatusOr<HttpResponse>> CurlEventLoop::MakeRequest(CurlRequest request,
+                                                          std::string payload) {
+  // Configure the transfer in the calling thread, any errors (which are
+  // reported as exceptions) are raised to the caller, and not in the
+  // background thread. The operation is allocated in the heap, the transfer
+  // refers to both `request` and `payload` and they cannot move.
+  std::unique_ptr<Operation> op(
+      new Operation{std::move(request), std::move(payload), {}});
+  op->request.SetupTransfer(op->payload);
+  auto f = op->done.get_future();
+  {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (shutdown_) {
+      lk.unlock();
+      op->done.set_value(CancelledStatus());
+      return f;
+    }
+    pending_.push_back(std::move(op));
+  }
+  cv_.notify_one();
+#if CURL_AT_LEAST_VERSION(7, 68, 0)
+  (void)curl_multi_wakeup(multi_.get());
+#endif  // libcurl >= 7.68.0
+  return f;
+}
+
+void CurlEventLoop::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    shutdown_ = true;
+  }
+  cv_.notify_one();
+#if CURL_AT_LEAST_VERSION(7, 68, 0)
+  (void)curl_multi_wakeup(multi_.get());
+#endif  // libcurl >= 7.68.0
+}
+
+void CurlEventLoop::Run() {
+  for (;;) {
+    std::vector<std::unique_ptr<Operation>> pending;
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      // Block until there is something to do when the loop is idle.
+      cv_.wait(lk, [this] {
+        return shutdown_ || !pending_.empty() || !running_.empty();
+      });
+      if (shutdown_) break;
+      pending.swap(pending_);
+    }
+    for (auto& op : pending) StartOperation(std::move(op));
+
+    int running_handles = 0;
+    CURLMcode result;
+    do {
+      result = curl_multi_perform(multi_.get(), &running_handles);
+    } while (result == CURLM_CALL_MULTI_PERFORM);
+    auto status = AsStatus(result, __func__);
+    if (!status.ok()) {
+      // This indicates a bug (or memory corruption), we cannot know which
+      // transfer caused the problem, so they all fail.
+      GCP_LOG(ERROR) << __func__ << "(): " << status;
+      FailRunningTransfers(status);
+      continue;
+    }
+    ProcessCompletedTransfers();
+    if (!running_.empty()) WaitForActivity();
+  }
+
+  std::vector<std::unique_ptr<Operation>> pending;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    pending.swap(pending_);
+  }
+  for (auto& op : pending) op->done.set_value(CancelledStatus());
+  FailRunningTransfers(CancelledStatus());
+}
+
+void CurlEventLoop::StartOperation(std::unique_ptr<Operation> op) {
+  auto* handle = op->request.handle_.handle_.get();
+  auto status = AsStatus(curl_multi_add_handle(multi_.get(), handle), __func__);
+  if (!status.ok()) {
+    op->done.set_value(std::move(status));
+    return;
+  }
+  running_.emplace(handle, std::move(op));
+}
+
+void CurlEventLoop::ProcessCompletedTransfers() {
+  int remaining;
+  while (auto* msg = curl_multi_info_read(multi_.get(), &remaining)) {
+    if (msg->msg != CURLMSG_DONE) continue;
+    auto i = running_.find(msg->easy_handle);
+    if (i == running_.end()) {
+      GCP_LOG(ERROR) << __func__
+                     << "(): unknown handle returned by curl_multi_info_read()";
+      continue;
+    }
+    auto op = std::move(i->second);
+    running_.erase(i);
+    auto status = CurlHandle::AsStatus(msg->data.result, __func__);
+    (void)curl_multi_remove_handle(multi_.get(), msg->easy_handle);
+    // Satisfying the promise may run continuations, and those may start new
+    // transfers, all the bookkeeping must be complete at this point.
+    op->done.set_value(op->request.CompleteTransfer(std::move(status)));
+  }
+}
+
+void CurlEventLoop::FailRunningTransfers(Status const& status) {
+  auto running = std::move(running_);
+  running_.clear();
+  for (auto& kv : running) {
+    (void)curl_multi_remove_handle(multi_.get(), kv.first);
+    kv.second->done.set_value(status);
+  }
+}
+
+void CurlEventLoop::WaitForActivity() {
+#if CURL_AT_LEAST_VERSION(7, 68, 0)
+  // curl_multi_poll() can be interrupted by curl_multi_wakeup(), which is
+  // called when new transfers are started, so we can use a long timeout.
+  int const timeout_ms = 100;
+  (void)curl_multi_poll(multi_.get(), nullptr, 0, timeout_ms, nullptr);
+#else
+  // With older versions of libcurl we cannot interrupt curl_multi_wait(), use
+  // a short timeout so new transfers start promptly.
+  int const timeout_ms = 1;
+  int numfds = 0;
+  auto result = curl_multi_wait(multi_.get(), nullptr, 0, timeout_ms, &numfds);
+  // The documentation for curl_multi_wait() recommends sleeping if it returns
+  // numfds == 0, this happens, for example, while resolving DNS names.
+  if (result == CURLM_OK && numfds == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+  }
+#endif  // libcurl >= 7.68.0
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,103 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_EVENT_LOOP_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_EVENT_LOOP_H
+
+#include "google/cloud/storage/internal/curl_request.h"
+#include "google/cloud/storage/internal/curl_wrappers.h"
+#include "google/cloud/storage/internal/http_response.h"
+#include "google/cloud/storage/version.h"
+#include "google/cloud/future.h"
+#include "google/cloud/status_or.h"
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * Runs many `CurlRequest` transfers over a single `CURLM*` handle.
+ *
+ * Each `CurlEventLoop` owns one `CURLM*` handle and one background thread.
+ * That thread drives all the transfers started via `MakeRequest()`, so a small
+ * number of threads can keep thousands of transfers in flight.
+ *
+ * The futures returned by `MakeRequest()` are satisfied by the background
+ * thread. Any continuations attached to them (via `.then()`) run in that
+ * thread, unless the future was already satisfied when the continuation is
+ * attached. Continuations should not block, as they stall all the other
+ * transfers in the same event loop.
+ *
+ * The background thread holds a reference to the event loop, the loop is only
+ * deleted once `Shutdown()` is called and the thread has stopped. Any transfer
+ * pending at that time completes with `StatusCode::kCancelled`.
+ */
+class CurlEventLoop : public std::enable_shared_from_this<CurlEventLoop> {
+ public:
+  static std::shared_ptr<CurlEventLoop> Create();
+
+  ~CurlEventLoop();
+
+  CurlEventLoop(CurlEventLoop const&) = delete;
+  CurlEventLoop(CurlEventLoop&&) = delete;
+  CurlEventLoop& operator=(CurlEventLoop const&) = delete;
+  CurlEventLoop& operator=(CurlEventLoop&&) = delete;
+
+  /**
+   * Starts @p request in the background thread, sending @p payload.
+   *
+   * @return a future satisfied when the transfer completes. The response
+   *     includes the full payload received from the server.
+   */
+  future<StatusOr<HttpResponse>> MakeRequest(CurlRequest request,
+                                             std::string payload);
+
+  /// Stops the background thread, cancelling any pending transfers.
+  void Shutdown();
+
+ private:
+  struct Operation;
+
+  CurlEventLoop();
+
+  void Run();
+  void StartOperation(std::unique_ptr<Operation> op);
+  void ProcessCompletedTransfers();
+  void FailRunningTransfers(Status const& status);
+  void WaitForActivity();
+
+  CurlMulti multi_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool shutdown_ = false;                             // GUARDED_BY(mu_)
+  std::vector<std::unique_ptr<Operation>> pending_;  // GUARDED_BY(mu_)
+  // Only used by the background thread.
+  std::map<CURL*, std::unique_ptr<Operation>> running_;
+  std::thread thread_;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_EVENT_LOOP_H
@@ -16,6 +16,7 @@
 #include "google/cloud/storage/internal/binary_data_as_debug_string.h"
 #include "google/cloud/internal/strerror.h"
 #include "google/cloud/log.h"
+#include <algorithm>
 #ifdef _WIN32
 #include <winsock.h>
 #else
@@ -134,6 +135,59 @@ void CurlHandle::ResetSocketCallback() {
   SetOption(CURLOPT_SOCKOPTFUNCTION, nullptr);
 }
 
+StatusOr<TransferSample> CurlHandle::GetTransferSample() {
+#if CURL_AT_LEAST_VERSION(7, 55, 0)
+  // CURLINFO_SIZE_{DOWNLOAD,UPLOAD} are deprecated since 7.55.0.
+  using size_type = curl_off_t;
+  CURLINFO const size_info[] = {CURLINFO_SIZE_DOWNLOAD_T,
+                                CURLINFO_SIZE_UPLOAD_T};
+#else
+  using size_type = double;
+  CURLINFO const size_info[] = {CURLINFO_SIZE_DOWNLOAD, CURLINFO_SIZE_UPLOAD};
+#endif  // CURL_AT_LEAST_VERSION(7, 55, 0)
+  size_type sizes[] = {0, 0};
+  for (std::size_t i = 0; i != 2; ++i) {
+    auto e = curl_easy_getinfo(handle_.get(), size_info[i], &sizes[i]);
+    if (e != CURLE_OK) return AsStatus(e, __func__);
+  }
+
+  struct {
+    CURLINFO info;
+    double value;
+  } values[] = {
+      {CURLINFO_NAMELOOKUP_TIME, 0},  {CURLINFO_CONNECT_TIME, 0},
+      {CURLINFO_PRETRANSFER_TIME, 0}, {CURLINFO_STARTTRANSFER_TIME, 0},
+      {CURLINFO_TOTAL_TIME, 0},
+  };
+  for (auto& v : values) {
+    auto e = curl_easy_getinfo(handle_.get(), v.info, &v.value);
+    if (e != CURLE_OK) return AsStatus(e, __func__);
+  }
+  auto as_bytes = [](size_type v) {
+    return v > 0 ? static_cast<std::uint64_t>(v) : std::uint64_t{0};
+  };
+  auto const downloaded = as_bytes(sizes[0]);
+  auto const uploaded = as_bytes(sizes[1]);
+  auto const handshake = values[1].value - values[0].value;
+  auto const first_byte = values[3].value - values[2].value;
+  auto const transfer = values[4].value - values[2].value;
+
+  using seconds = std::chrono::duration<double>;
+  auto as_microseconds = [](double s) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        seconds((std::max)(s, 0.0)));
+  };
+  // The time to the first byte includes the time to send the payload, only
+  // use it for requests with small payloads.
+  auto const rtt =
+      handshake > 0 ? handshake
+                    : (uploaded < TransferTuner::kMinThroughputSampleSize
+                           ? first_byte
+                           : 0.0);
+  return TransferSample{downloaded + uploaded, as_microseconds(transfer),
+                        as_microseconds(rtt)};
+}
+
 void CurlHandle::EnableLogging(bool enabled) {
   if (enabled) {
     SetOption(CURLOPT_DEBUGDATA, &debug_buffer_);
@@ -17,6 +17,7 @@
 
 #include "google/cloud/storage/client_options.h"
 #include "google/cloud/storage/internal/curl_wrappers.h"
+#include "google/cloud/storage/internal/transfer_tuner.h"
 #include "google/cloud/storage/version.h"
 #include "google/cloud/status_or.h"
 #include <curl/curl.h>
@@ -87,6 +88,15 @@ class CurlHandle {
     return AsStatus(e, __func__);
   }
 
+  /**
+   * Returns the size and timing of the last transfer.
+   *
+   * The RTT is estimated from the TCP handshake for new connections, and from
+   * the time to the first response byte for small requests. Otherwise it is
+   * not available and set to zero.
+   */
+  StatusOr<TransferSample> GetTransferSample();
+
   Status EasyPause(int bitmask) {
     auto e = curl_easy_pause(handle_.get(), bitmask);
     return AsStatus(e, __func__);
@@ -104,6 +114,7 @@ class CurlHandle {
   explicit CurlHandle(CurlPtr ptr) : handle_(std::move(ptr)) {}
 
   friend class CurlDownloadRequest;
+  friend class CurlEventLoop;
   friend class CurlRequestBuilder;
   friend class CurlHandleFactory;
 
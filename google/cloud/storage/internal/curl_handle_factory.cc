@@ -13,12 +13,28 @@
 // limitations under the License.
 
 #include "google/cloud/storage/internal/curl_handle_factory.h"
+#include <algorithm>
+#include <thread>
 
 namespace google {
 namespace cloud {
 namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace internal {
+namespace {
+// The maximum time to establish each connection in `Warmup()`. The warm-up is
+// an optimization, it should not hold resources (or a destructor) for long.
+auto constexpr kWarmupTimeout = std::chrono::seconds(5);
+}  // namespace
+
+extern "C" int CurlHandleFactoryWarmupProgress(void* userdata, curl_off_t,
+                                               curl_off_t, curl_off_t,
+                                               curl_off_t) {
+  auto* cancelled = reinterpret_cast<std::atomic<bool>*>(userdata);
+  // Returning a non-zero value aborts the transfer.
+  return cancelled->load() ? 1 : 0;
+}
+
 std::once_flag default_curl_handle_factory_initialized;
 std::shared_ptr<CurlHandleFactory> default_curl_handle_factory;
 
@@ -35,6 +51,43 @@ void CurlHandleFactory::SetCurlOptions(CURL* handle,
   }
 }
 
+CurlHandleStats CurlHandleFactory::LastTransferStats(CURL* handle) {
+  CurlHandleStats stats;
+  long connects = 0;  // NOLINT(google-runtime-int)
+  auto e = curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &connects);
+  if (e != CURLE_OK || connects <= 0) return stats;
+  stats.connection_count = static_cast<std::uint64_t>(connects);
+#if CURL_AT_LEAST_VERSION(7, 61, 0)
+  curl_off_t connect = 0;
+  curl_off_t app_connect = 0;
+  (void)curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME_T, &connect);
+  (void)curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME_T, &app_connect);
+  stats.handshake_time =
+      std::chrono::microseconds((std::max)(connect, app_connect));
+#else
+  double connect = 0;
+  double app_connect = 0;
+  (void)curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME, &connect);
+  (void)curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME, &app_connect);
+  stats.handshake_time = std::chrono::microseconds(
+      static_cast<std::int64_t>((std::max)(connect, app_connect) * 1.0E6));
+#endif  // CURL_AT_LEAST_VERSION(7, 61, 0)
+  return stats;
+}
+
+bool CurlHandleFactory::LastTransferFailed(CURL* handle) {
+  long code = 0;  // NOLINT(google-runtime-int)
+  auto e = curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &code);
+  if (e != CURLE_OK || code != 0) return false;
+  // Handles that were never used also have no response code, but they have
+  // spent no time in a transfer and have no error.
+  long os_errno = 0;  // NOLINT(google-runtime-int)
+  double total_time = 0;
+  (void)curl_easy_getinfo(handle, CURLINFO_OS_ERRNO, &os_errno);
+  (void)curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME, &total_time);
+  return os_errno != 0 || total_time > 0;
+}
+
 std::shared_ptr<CurlHandleFactory> GetDefaultCurlHandleFactory() {
   std::call_once(default_curl_handle_factory_initialized, [] {
     default_curl_handle_factory = std::make_shared<DefaultCurlHandleFactory>();
@@ -51,17 +104,26 @@ std::shared_ptr<CurlHandleFactory> GetDefaultCurlHandleFactory(
 }
 
 CurlPtr DefaultCurlHandleFactory::CreateHandle() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    ++stats_.handles_created;
+  }
   CurlPtr curl(curl_easy_init(), &curl_easy_cleanup);
   SetCurlOptions(curl.get(), options_);
   return curl;
 }
 
 void DefaultCurlHandleFactory::CleanupHandle(CurlHandle&& h) {
+  auto const last = LastTransferStats(GetHandle(h));
+  auto const failed = LastTransferFailed(GetHandle(h));
   char* ip;
   auto res = curl_easy_getinfo(GetHandle(h), CURLINFO_LOCAL_IP, &ip);
-  if (res == CURLE_OK && ip != nullptr) {
+  {
     std::lock_guard<std::mutex> lk(mu_);
-    last_client_ip_address_ = ip;
+    if (res == CURLE_OK && ip != nullptr) last_client_ip_address_ = ip;
+    stats_.connection_count += last.connection_count;
+    stats_.handshake_time += last.handshake_time;
+    if (failed) ++stats_.transfer_failures;
   }
   ResetHandle(h);
 }
@@ -72,55 +134,165 @@ CurlMulti DefaultCurlHandleFactory::CreateMultiHandle() {
 
 void DefaultCurlHandleFactory::CleanupMultiHandle(CurlMulti&& m) { m.reset(); }
 
-PooledCurlHandleFactory::PooledCurlHandleFactory(std::size_t maximum_size,
-                                                 ChannelOptions options)
-    : maximum_size_(maximum_size), options_(std::move(options)) {
+PooledCurlHandleFactory::PooledCurlHandleFactory(
+    std::size_t maximum_size, ChannelOptions options,
+    std::chrono::milliseconds maximum_idle_time)
+    : maximum_size_(maximum_size),
+      maximum_idle_time_(maximum_idle_time),
+      options_(std::move(options)) {
   handles_.reserve(maximum_size);
   multi_handles_.reserve(maximum_size);
 }
 
 PooledCurlHandleFactory::~PooledCurlHandleFactory() {
-  for (auto* h : handles_) {
-    curl_easy_cleanup(h);
+  for (auto const& h : handles_) {
+    curl_easy_cleanup(h.handle);
   }
   for (auto* m : multi_handles_) {
     curl_multi_cleanup(m);
   }
 }
 
+std::size_t PooledCurlHandleFactory::Warmup(std::string const& url,
+                                            std::size_t count) {
+  count = (std::min)(count, maximum_size_);
+  std::vector<CurlPtr> handles;
+  handles.reserve(count);
+  for (std::size_t i = 0; i != count; ++i) {
+    if (warmup_cancelled_.load()) return 0;
+    CurlPtr curl(curl_easy_init(), &curl_easy_cleanup);
+    SetCurlOptions(curl.get(), options_);
+    (void)curl_easy_setopt(curl.get(), CURLOPT_URL, url.c_str());
+    (void)curl_easy_setopt(curl.get(), CURLOPT_NOBODY, 1L);
+    (void)curl_easy_setopt(curl.get(), CURLOPT_NOSIGNAL, 1L);
+    (void)curl_easy_setopt(curl.get(), CURLOPT_TCP_KEEPALIVE, 1L);
+    (void)curl_easy_setopt(
+        curl.get(), CURLOPT_TIMEOUT_MS,
+        static_cast<long>(  // NOLINT(google-runtime-int)
+            std::chrono::milliseconds(kWarmupTimeout).count()));
+    // libcurl calls this function about once per second, even if the
+    // connection makes no progress, `CancelWarmup()` takes effect then.
+    (void)curl_easy_setopt(curl.get(), CURLOPT_NOPROGRESS, 0L);
+    (void)curl_easy_setopt(curl.get(), CURLOPT_XFERINFOFUNCTION,
+                           &CurlHandleFactoryWarmupProgress);
+    (void)curl_easy_setopt(curl.get(), CURLOPT_XFERINFODATA,
+                           &warmup_cancelled_);
+    handles.push_back(std::move(curl));
+  }
+
+  // Each handle keeps its connection open after the transfer, establish all
+  // the connections in parallel.
+  std::vector<CURLcode> results(count, CURLE_OK);
+  std::vector<std::thread> threads;
+  threads.reserve(count);
+  for (std::size_t i = 0; i != count; ++i) {
+    threads.emplace_back([&handles, &results, i] {
+      results[i] = curl_easy_perform(handles[i].get());
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  std::lock_guard<std::mutex> lk(mu_);
+  std::size_t added = 0;
+  for (std::size_t i = 0; i != count; ++i) {
+    // Cancelled connections are not failures, they are simply discarded.
+    if (results[i] == CURLE_ABORTED_BY_CALLBACK) continue;
+    if (results[i] != CURLE_OK) {
+      ++stats_.warmup_failures;
+      continue;
+    }
+    auto const last = LastTransferStats(handles[i].get());
+    ++stats_.handles_created;
+    stats_.connection_count += last.connection_count;
+    stats_.handshake_time += last.handshake_time;
+    AddToPool(handles[i].release(), last);
+    ++added;
+  }
+  return added;
+}
+
 CurlPtr PooledCurlHandleFactory::CreateHandle() {
   std::unique_lock<std::mutex> lk(mu_);
+  ExpireIdleHandles(Clock::now());
   if (!handles_.empty()) {
-    CURL* handle = handles_.back();
-    // Clear all the options in the handle so we do not leak its previous state.
-    (void)curl_easy_reset(handle);
+    auto entry = handles_.back();
     handles_.pop_back();
-    CurlPtr curl(handle, &curl_easy_cleanup);
+    // Clear all the options in the handle so we do not leak its previous state.
+    // The connections (and the TLS session) are preserved.
+    (void)curl_easy_reset(entry.handle);
+    ++entry.stats.reuse_count;
+    ++stats_.handles_reused;
+    active_handles_[entry.handle] = entry.stats;
+    CurlPtr curl(entry.handle, &curl_easy_cleanup);
     SetCurlOptions(curl.get(), options_);
     return curl;
   }
+  ++stats_.handles_created;
   CurlPtr curl(curl_easy_init(), &curl_easy_cleanup);
+  active_handles_[curl.get()] = CurlHandleStats{};
   SetCurlOptions(curl.get(), options_);
   return curl;
 }
 
 void PooledCurlHandleFactory::CleanupHandle(CurlHandle&& h) {
   std::unique_lock<std::mutex> lk(mu_);
+  CURL* handle = GetHandle(h);
   char* ip;
-  auto res = curl_easy_getinfo(GetHandle(h), CURLINFO_LOCAL_IP, &ip);
+  auto res = curl_easy_getinfo(handle, CURLINFO_LOCAL_IP, &ip);
   if (res == CURLE_OK && ip != nullptr) {
     last_client_ip_address_ = ip;
   }
-  if (handles_.size() >= maximum_size_) {
-    CURL* tmp = handles_.front();
-    handles_.erase(handles_.begin());
-    curl_easy_cleanup(tmp);
+  CurlHandleStats stats;
+  auto a = active_handles_.find(handle);
+  if (a != active_handles_.end()) {
+    stats = a->second;
+    active_handles_.erase(a);
   }
-  handles_.push_back(GetHandle(h));
+  auto const last = LastTransferStats(handle);
+  stats.connection_count += last.connection_count;
+  stats.handshake_time += last.handshake_time;
+  stats_.connection_count += last.connection_count;
+  stats_.handshake_time += last.handshake_time;
+  if (LastTransferFailed(handle)) {
+    // The connection is likely broken, do not return the handle to the pool.
+    ++stats_.transfer_failures;
+    ResetHandle(h);
+    return;
+  }
+  AddToPool(handle, stats);
   // The handles_ vector now has ownership, so release it.
   ReleaseHandle(h);
 }
 
+CurlHandlePoolStats PooledCurlHandleFactory::Stats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto stats = stats_;
+  stats.idle_handles.reserve(handles_.size());
+  for (auto const& h : handles_) stats.idle_handles.push_back(h.stats);
+  return stats;
+}
+
+void PooledCurlHandleFactory::ExpireIdleHandles(Clock::time_point now) {
+  if (maximum_idle_time_.count() == 0) return;
+  // The handles are sorted by the time they were returned to the pool.
+  auto const cutoff = now - maximum_idle_time_;
+  auto end = std::find_if(
+      handles_.begin(), handles_.end(),
+      [cutoff](PooledHandle const& h) { return h.last_used >= cutoff; });
+  for (auto i = handles_.begin(); i != end; ++i) curl_easy_cleanup(i->handle);
+  stats_.handles_expired += std::distance(handles_.begin(), end);
+  handles_.erase(handles_.begin(), end);
+}
+
+void PooledCurlHandleFactory::AddToPool(CURL* handle, CurlHandleStats stats) {
+  if (handles_.size() >= maximum_size_) {
+    curl_easy_cleanup(handles_.front().handle);
+    handles_.erase(handles_.begin());
+    ++stats_.handles_overflowed;
+  }
+  handles_.push_back(PooledHandle{handle, Clock::now(), stats});
+}
+
 CurlMulti PooledCurlHandleFactory::CreateMultiHandle() {
   std::unique_lock<std::mutex> lk(mu_);
   if (!multi_handles_.empty()) {
@@ -15,10 +15,16 @@
 #ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_HANDLE_FACTORY_H
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_HANDLE_FACTORY_H
 
+#include "google/cloud/storage/connection_pool_stats.h"
 #include "google/cloud/storage/internal/curl_handle.h"
 #include "google/cloud/storage/internal/curl_wrappers.h"
 #include "google/cloud/storage/version.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace google {
@@ -26,6 +32,12 @@ namespace cloud {
 namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace internal {
+/// Counters for a single handle created by a `CurlHandleFactory`.
+using CurlHandleStats = PooledConnectionStats;
+
+/// Counters for all the handles created by a `CurlHandleFactory`.
+using CurlHandlePoolStats = ConnectionPoolStats;
+
 /**
  * Implements the Factory Pattern for CURL handles (and multi-handles).
  */
@@ -41,6 +53,26 @@ class CurlHandleFactory {
 
   virtual std::string LastClientIpAddress() const = 0;
 
+  /**
+   * Creates up to @p count handles connected to @p url, if the factory keeps
+   * handles for reuse.
+   *
+   * @return the number of connected handles kept by the factory.
+   */
+  virtual std::size_t Warmup(std::string const& url, std::size_t count) = 0;
+
+  /**
+   * Stops any `Warmup()` in progress, and any future `Warmup()` calls return
+   * immediately.
+   *
+   * Connections that are not established yet are abandoned, this function does
+   * not wait for `Warmup()` to return.
+   */
+  virtual void CancelWarmup() = 0;
+
+  /// Returns the counters for the handles created by this factory.
+  virtual CurlHandlePoolStats Stats() const = 0;
+
  protected:
   // Only virtual for testing purposes.
   virtual void SetCurlStringOption(CURL* handle, CURLoption option_tag,
@@ -50,6 +82,11 @@ class CurlHandleFactory {
   static CURL* GetHandle(CurlHandle& h) { return h.handle_.get(); }
   static void ResetHandle(CurlHandle& h) { h.handle_.reset(); }
   static void ReleaseHandle(CurlHandle& h) { (void)h.handle_.release(); }
+
+  /// Get the counters for the last transfer using @p handle.
+  static CurlHandleStats LastTransferStats(CURL* handle);
+  /// Returns true if the last transfer using @p handle got no response.
+  static bool LastTransferFailed(CURL* handle);
 };
 
 std::shared_ptr<CurlHandleFactory> GetDefaultCurlHandleFactory(
@@ -80,25 +117,57 @@ class DefaultCurlHandleFactory : public CurlHandleFactory {
     return last_client_ip_address_;
   }
 
+  /// This factory does not keep handles, there is nothing to warm up.
+  std::size_t Warmup(std::string const&, std::size_t) override { return 0; }
+  void CancelWarmup() override {}
+
+  CurlHandlePoolStats Stats() const override {
+    std::lock_guard<std::mutex> lk(mu_);
+    return stats_;
+  }
+
  private:
   mutable std::mutex mu_;
   std::string last_client_ip_address_;
   ChannelOptions options_;
+  CurlHandlePoolStats stats_;
 };
 
 /**
  * Implements a CurlHandleFactory that pools handles.
  *
- * This implementation keeps up to N handles in memory, they are only released
- * when the factory is destructed.
+ * This implementation keeps up to N handles in memory. The handles keep their
+ * connections open, so reusing a handle avoids the TCP and TLS handshakes.
+ * Handles are released when the pool is full, when they have been idle for
+ * longer than @p maximum_idle_time (if not zero), when their last transfer
+ * did not receive a response (the connection is likely broken), or when the
+ * factory is destructed.
  */
 class PooledCurlHandleFactory : public CurlHandleFactory {
  public:
-  PooledCurlHandleFactory(std::size_t maximum_size, ChannelOptions options);
+  PooledCurlHandleFactory(std::size_t maximum_size, ChannelOptions options,
+                          std::chrono::milliseconds maximum_idle_time);
+  PooledCurlHandleFactory(std::size_t maximum_size, ChannelOptions options)
+      : PooledCurlHandleFactory(maximum_size, std::move(options),
+                                std::chrono::milliseconds(0)) {}
   explicit PooledCurlHandleFactory(std::size_t maximum_size)
       : PooledCurlHandleFactory(maximum_size, {}) {}
   ~PooledCurlHandleFactory() override;
 
+  /**
+   * Creates up to @p count handles connected to @p url and adds them to the
+   * pool.
+   *
+   * The connections are established in parallel, using a `HEAD` request to
+   * @p url, and this function blocks until all of them complete, time out, or
+   * `CancelWarmup()` is called. Failures are not fatal, they are reported via
+   * `Stats()`.
+   *
+   * @return the number of handles added to the pool.
+   */
+  std::size_t Warmup(std::string const& url, std::size_t count) override;
+  void CancelWarmup() override { warmup_cancelled_.store(true); }
+
   CurlPtr CreateHandle() override;
   void CleanupHandle(CurlHandle&&) override;
 
@@ -110,13 +179,35 @@ class PooledCurlHandleFactory : public CurlHandleFactory {
     return last_client_ip_address_;
   }
 
+  CurlHandlePoolStats Stats() const override;
+
  private:
+  using Clock = std::chrono::steady_clock;
+
+  struct PooledHandle {
+    CURL* handle;
+    Clock::time_point last_used;
+    CurlHandleStats stats;
+  };
+
+  /// Release the handles that have been idle for too long.
+  void ExpireIdleHandles(Clock::time_point now);
+
+  /// Add a handle to the pool, releasing the oldest handle if it is full.
+  void AddToPool(CURL* handle, CurlHandleStats stats);
+
   std::size_t maximum_size_;
+  std::chrono::milliseconds maximum_idle_time_;
   mutable std::mutex mu_;
-  std::vector<CURL*> handles_;
+  // The idle handles, the most recently used handle is last.
+  std::vector<PooledHandle> handles_;
+  // The counters for handles in use, keyed by handle.
+  std::unordered_map<CURL*, CurlHandleStats> active_handles_;
   std::vector<CURLM*> multi_handles_;
   std::string last_client_ip_address_;
   ChannelOptions options_;
+  CurlHandlePoolStats stats_;
+  std::atomic<bool> warmup_cancelled_{false};
 };
 
 }  // namespace internal
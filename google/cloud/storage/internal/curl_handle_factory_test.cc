@@ -13,8 +13,10 @@
 // limitations under the License.
 
 #include "google/cloud/storage/internal/curl_handle_factory.h"
+#include "google/cloud/storage/internal/curl_request_builder.h"
 #include <gmock/gmock.h>
 #include <map>
+#include <thread>
 
 namespace google {
 namespace cloud {
@@ -110,6 +112,73 @@ TEST(CurlHandleFactoryTest, PooledFactoryChannelOptionsCallsSetOptions) {
   EXPECT_THAT(object_under_test.set_options_, testing::ElementsAre(expected));
 }
 
+TEST(CurlHandleFactoryTest, PooledFactoryReusesHandles) {
+  auto factory = std::make_shared<PooledCurlHandleFactory>(2);
+  // Creating a builder takes a handle from the factory, destroying the builder
+  // (without building a request) returns the handle.
+  { CurlRequestBuilder builder("http://localhost:1/", factory); }
+  { CurlRequestBuilder builder("http://localhost:1/", factory); }
+
+  auto stats = factory->Stats();
+  EXPECT_EQ(1, stats.handles_created);
+  EXPECT_EQ(1, stats.handles_reused);
+  EXPECT_EQ(0, stats.transfer_failures);
+  ASSERT_EQ(1, stats.idle_handles.size());
+  EXPECT_EQ(1, stats.idle_handles[0].reuse_count);
+  EXPECT_EQ(0, stats.idle_handles[0].connection_count);
+}
+
+TEST(CurlHandleFactoryTest, PooledFactoryOverflow) {
+  auto factory = std::make_shared<PooledCurlHandleFactory>(1);
+  {
+    CurlRequestBuilder b1("http://localhost:1/", factory);
+    CurlRequestBuilder b2("http://localhost:1/", factory);
+  }
+
+  auto stats = factory->Stats();
+  EXPECT_EQ(2, stats.handles_created);
+  EXPECT_EQ(0, stats.handles_reused);
+  EXPECT_EQ(1, stats.handles_overflowed);
+  EXPECT_EQ(1, stats.idle_handles.size());
+}
+
+TEST(CurlHandleFactoryTest, PooledFactoryExpiresIdleHandles) {
+  auto factory = std::make_shared<PooledCurlHandleFactory>(
+      2, ChannelOptions{}, std::chrono::milliseconds(1));
+  { CurlRequestBuilder builder("http://localhost:1/", factory); }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  { CurlRequestBuilder builder("http://localhost:1/", factory); }
+
+  auto stats = factory->Stats();
+  EXPECT_EQ(2, stats.handles_created);
+  EXPECT_EQ(0, stats.handles_reused);
+  EXPECT_EQ(1, stats.handles_expired);
+  EXPECT_EQ(1, stats.idle_handles.size());
+}
+
+TEST(CurlHandleFactoryTest, PooledFactoryCancelWarmup) {
+  auto factory = std::make_shared<PooledCurlHandleFactory>(4);
+  factory->CancelWarmup();
+  EXPECT_EQ(0, factory->Warmup("http://localhost:1/", 4));
+
+  auto stats = factory->Stats();
+  EXPECT_EQ(0, stats.handles_created);
+  EXPECT_EQ(0, stats.warmup_failures);
+  EXPECT_TRUE(stats.idle_handles.empty());
+}
+
+TEST(CurlHandleFactoryTest, DefaultFactoryStats) {
+  auto factory = std::make_shared<DefaultCurlHandleFactory>();
+  EXPECT_EQ(0, factory->Warmup("http://localhost:1/", 4));
+  { CurlRequestBuilder builder("http://localhost:1/", factory); }
+
+  auto stats = factory->Stats();
+  EXPECT_EQ(1, stats.handles_created);
+  EXPECT_EQ(0, stats.handles_reused);
+  EXPECT_EQ(0, stats.transfer_failures);
+  EXPECT_TRUE(stats.idle_handles.empty());
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
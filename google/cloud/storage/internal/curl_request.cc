@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "google/cloud/storage/internal/curl_request.h"
+#include <algorithm>
 #include <iostream>
 
 namespace google {
@@ -33,13 +34,54 @@ extern "C" size_t CurlRequestOnHeaderData(char* contents, size_t size,
   return request->OnHeaderData(contents, size, nitems);
 }
 
+extern "C" size_t CurlRequestOnReadData(char* ptr, size_t size, size_t nitems,
+                                        void* userdata) {
+  auto* request = reinterpret_cast<CurlRequest*>(userdata);
+  return request->OnReadData(ptr, size, nitems);
+}
+
 StatusOr<HttpResponse> CurlRequest::MakeRequest(std::string const& payload) {
+  SetupTransfer(payload);
+  return CompleteTransfer(handle_.EasyPerform());
+}
+
+StatusOr<HttpResponse> CurlRequest::MakeUploadRequest(
+    ConstBufferSequence payload) {
+  payload.erase(std::remove_if(payload.begin(), payload.end(),
+                               [](ConstBuffer const& b) { return b.empty(); }),
+                payload.end());
+  if (payload.size() <= 1) {
+    // libcurl does not copy the CURLOPT_POSTFIELDS data, a single buffer can
+    // be sent as-is.
+    SetupTransfer(payload.empty() ? ConstBuffer{} : payload.front());
+    return CompleteTransfer(handle_.EasyPerform());
+  }
+  SetupTransfer(ConstBuffer{});
+  // Have libcurl pull the data from each buffer, as opposed to concatenating
+  // them into a temporary buffer.
+  auto const size = static_cast<curl_off_t>(TotalBytes(payload));
+  upload_payload_ = std::move(payload);
+  handle_.SetOption(CURLOPT_POSTFIELDS, static_cast<char const*>(nullptr));
+  handle_.SetOption(CURLOPT_POST, 1L);
+  handle_.SetOption(CURLOPT_POSTFIELDSIZE_LARGE, size);
+  handle_.SetOption(CURLOPT_READFUNCTION, &CurlRequestOnReadData);
+  handle_.SetOption(CURLOPT_READDATA, this);
+  auto response = CompleteTransfer(handle_.EasyPerform());
+  upload_payload_.clear();
+  return response;
+}
+
+void CurlRequest::SetupTransfer(ConstBuffer payload) {
   // We get better performance using a slightly larger buffer (128KiB) than the
-  // default buffer size set by libcurl (16KiB)
-  auto constexpr kDefaultBufferSize = 128 * 1024L;
+  // default buffer size set by libcurl (16KiB), unless the tuner has a better
+  // estimate.
+  // NOLINTNEXTLINE(google-runtime-int) - libcurl *requires* `long`
+  auto const buffer_size = static_cast<long>(
+      tuner_ ? tuner_->CurlBufferSize()
+             : TransferTuner::kDefaultCurlBufferSize);
 
   response_payload_.clear();
-  handle_.SetOption(CURLOPT_BUFFERSIZE, kDefaultBufferSize);
+  handle_.SetOption(CURLOPT_BUFFERSIZE, buffer_size);
   handle_.SetOption(CURLOPT_URL, url_.c_str());
   handle_.SetOption(CURLOPT_HTTPHEADER, headers_.get());
   handle_.SetOption(CURLOPT_USERAGENT, user_agent_.c_str());
@@ -53,10 +95,12 @@ StatusOr<HttpResponse> CurlRequest::MakeRequest(std::string const& payload) {
   handle_.SetOption(CURLOPT_HEADERFUNCTION, &CurlRequestOnHeaderData);
   handle_.SetOption(CURLOPT_HEADERDATA, this);
   if (!payload.empty()) {
-    handle_.SetOption(CURLOPT_POSTFIELDSIZE, payload.length());
-    handle_.SetOption(CURLOPT_POSTFIELDS, payload.c_str());
+    handle_.SetOption(CURLOPT_POSTFIELDSIZE, payload.size());
+    handle_.SetOption(CURLOPT_POSTFIELDS, payload.data());
   }
-  auto status = handle_.EasyPerform();
+}
+
+StatusOr<HttpResponse> CurlRequest::CompleteTransfer(Status status) {
   if (!status.ok()) {
     return status;
   }
@@ -67,6 +111,10 @@ StatusOr<HttpResponse> CurlRequest::MakeRequest(std::string const& payload) {
   if (!code.ok()) {
     return std::move(code).status();
   }
+  if (tuner_) {
+    auto sample = handle_.GetTransferSample();
+    if (sample) tuner_->OnTransfer(*sample);
+  }
   return HttpResponse{code.value(), std::move(response_payload_),
                       std::move(received_headers_)};
 }
@@ -82,6 +130,20 @@ std::size_t CurlRequest::OnHeaderData(char* contents, std::size_t size,
   return CurlAppendHeaderData(received_headers_, contents, size * nitems);
 }
 
+std::size_t CurlRequest::OnReadData(char* buffer, std::size_t size,
+                                    std::size_t nitems) {
+  auto const capacity = size * nitems;
+  std::size_t offset = 0;
+  while (offset != capacity && !upload_payload_.empty()) {
+    auto const& front = upload_payload_.front();
+    auto const n = (std::min)(capacity - offset, front.size());
+    std::copy(front.data(), front.data() + n, buffer + offset);
+    offset += n;
+    PopFrontBytes(upload_payload_, n);
+  }
+  return offset;
+}
+
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
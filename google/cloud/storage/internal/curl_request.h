@@ -15,6 +15,7 @@
 #ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_REQUEST_H
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_REQUEST_H
 
+#include "google/cloud/storage/internal/const_buffer.h"
 #include "google/cloud/storage/internal/curl_handle.h"
 #include "google/cloud/storage/internal/curl_handle_factory.h"
 #include "google/cloud/storage/internal/http_response.h"
@@ -29,6 +30,8 @@ extern "C" size_t CurlRequestOnWriteData(char* ptr, size_t size, size_t nmemb,
                                          void* userdata);
 extern "C" size_t CurlRequestOnHeaderData(char* contents, size_t size,
                                           size_t nitems, void* userdata);
+extern "C" size_t CurlRequestOnReadData(char* ptr, size_t size, size_t nitems,
+                                        void* userdata);
 
 class CurlRequest {
  public:
@@ -49,26 +52,54 @@ class CurlRequest {
    */
   StatusOr<HttpResponse> MakeRequest(std::string const& payload);
 
+  /**
+   * Makes the prepared request, sending the contents of @p payload.
+   *
+   * The buffers are not copied, libcurl reads directly from them. The caller
+   * must keep them alive until this function returns.
+   *
+   * @return The response HTTP error code, the headers and an empty payload.
+   */
+  StatusOr<HttpResponse> MakeUploadRequest(ConstBufferSequence payload);
+
  private:
   friend class CurlRequestBuilder;
+  friend class CurlEventLoop;
+
+  /**
+   * Configures the handle to send @p payload, without starting the transfer.
+   *
+   * The caller must keep @p payload (and this object) alive and at the same
+   * address until the transfer completes.
+   */
+  void SetupTransfer(ConstBuffer payload);
+
+  /// Creates the response once the transfer has completed with @p status.
+  StatusOr<HttpResponse> CompleteTransfer(Status status);
+
   friend size_t CurlRequestOnWriteData(char* ptr, size_t size, size_t nmemb,
                                        void* userdata);
   friend size_t CurlRequestOnHeaderData(char* contents, size_t size,
                                         size_t nitems, void* userdata);
+  friend size_t CurlRequestOnReadData(char* ptr, size_t size, size_t nitems,
+                                      void* userdata);
 
   std::size_t OnWriteData(char* contents, std::size_t size, std::size_t nmemb);
   std::size_t OnHeaderData(char* contents, std::size_t size,
                            std::size_t nitems);
+  std::size_t OnReadData(char* buffer, std::size_t size, std::size_t nitems);
 
   std::string url_;
   CurlHeaders headers_ = CurlHeaders(nullptr, &curl_slist_free_all);
   std::string user_agent_;
   std::string response_payload_;
+  ConstBufferSequence upload_payload_;
   CurlReceivedHeaders received_headers_;
   bool logging_enabled_ = false;
   CurlHandle::SocketOptions socket_options_;
   CurlHandle handle_;
   std::shared_ptr<CurlHandleFactory> factory_;
+  std::shared_ptr<TransferTuner> tuner_;
 };
 
 }  // namespace internal
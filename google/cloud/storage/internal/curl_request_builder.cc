@@ -36,6 +36,12 @@ CurlRequestBuilder::CurlRequestBuilder(
       logging_enabled_(false),
       download_stall_timeout_(0) {}
 
+CurlRequestBuilder::~CurlRequestBuilder() {
+  // Return the handle to the factory if no request was built, e.g. because
+  // the caller found an error while preparing the request.
+  if (factory_ && handle_.handle_) factory_->CleanupHandle(std::move(handle_));
+}
+
 CurlRequest CurlRequestBuilder::BuildRequest() {
   ValidateBuilderState(__func__);
   CurlRequest request;
@@ -45,7 +51,8 @@ CurlRequest CurlRequestBuilder::BuildRequest() {
   request.handle_ = std::move(handle_);
   request.factory_ = std::move(factory_);
   request.logging_enabled_ = logging_enabled_;
-  request.socket_options_ = socket_options_;
+  request.socket_options_ = TunedSocketOptions();
+  request.tuner_ = std::move(tuner_);
   return request;
 }
 
@@ -61,8 +68,9 @@ CurlDownloadRequest CurlRequestBuilder::BuildDownloadRequest(
   request.multi_ = factory_->CreateMultiHandle();
   request.factory_ = factory_;
   request.logging_enabled_ = logging_enabled_;
-  request.socket_options_ = socket_options_;
+  request.socket_options_ = TunedSocketOptions();
   request.download_stall_timeout_ = download_stall_timeout_;
+  request.tuner_ = std::move(tuner_);
   request.SetOptions();
   return request;
 }
@@ -78,6 +86,13 @@ CurlRequestBuilder& CurlRequestBuilder::ApplyClientOptions(
   return *this;
 }
 
+CurlRequestBuilder& CurlRequestBuilder::SetTransferTuner(
+    std::shared_ptr<TransferTuner> tuner) {
+  ValidateBuilderState(__func__);
+  tuner_ = std::move(tuner);
+  return *this;
+}
+
 CurlRequestBuilder& CurlRequestBuilder::AddHeader(std::string const& header) {
   ValidateBuilderState(__func__);
   auto new_header = curl_slist_append(headers_.get(), header.c_str());
@@ -121,6 +136,16 @@ std::string CurlRequestBuilder::UserAgentSuffix() const {
   return kUserAgentSuffix;
 }
 
+CurlHandle::SocketOptions CurlRequestBuilder::TunedSocketOptions() const {
+  auto options = socket_options_;
+  if (!tuner_) return options;
+  // Values set by the application take precedence.
+  auto const size = tuner_->SocketBufferSize();
+  if (options.recv_buffer_size_ == 0) options.recv_buffer_size_ = size;
+  if (options.send_buffer_size_ == 0) options.send_buffer_size_ = size;
+  return options;
+}
+
 void CurlRequestBuilder::ValidateBuilderState(char const* where) const {
   if (handle_.handle_.get() == nullptr) {
     std::string msg = "Attempt to use invalidated CurlRequest in ";
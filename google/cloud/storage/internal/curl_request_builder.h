@@ -36,6 +36,10 @@ class CurlRequestBuilder {
 
   explicit CurlRequestBuilder(std::string base_url,
                               std::shared_ptr<CurlHandleFactory> factory);
+  ~CurlRequestBuilder();
+
+  CurlRequestBuilder(CurlRequestBuilder&&) = default;
+  CurlRequestBuilder& operator=(CurlRequestBuilder&&) = default;
 
   /**
    * Creates a http request with the given payload.
@@ -149,6 +153,14 @@ class CurlRequestBuilder {
   /// Copy interesting configuration parameters from the client options.
   CurlRequestBuilder& ApplyClientOptions(ClientOptions const& options);
 
+  /**
+   * Uses @p tuner to size the buffers of the request, and reports the
+   * request throughput and RTT to it.
+   *
+   * A null @p tuner disables the adaptive tuning, this is the default.
+   */
+  CurlRequestBuilder& SetTransferTuner(std::shared_ptr<TransferTuner> tuner);
+
   /// Sets the CURLSH* handle to share resources.
   CurlRequestBuilder& SetCurlShare(CURLSH* share);
 
@@ -168,6 +180,9 @@ class CurlRequestBuilder {
  private:
   void ValidateBuilderState(char const* where) const;
 
+  /// The socket options, with the tuned values for any unset sizes.
+  CurlHandle::SocketOptions TunedSocketOptions() const;
+
   std::shared_ptr<CurlHandleFactory> factory_;
 
   CurlHandle handle_;
@@ -180,6 +195,7 @@ class CurlRequestBuilder {
   bool logging_enabled_;
   CurlHandle::SocketOptions socket_options_;
   std::chrono::seconds download_stall_timeout_;
+  std::shared_ptr<TransferTuner> tuner_;
 };
 
 }  // namespace internal
@@ -34,10 +34,10 @@ class CurlResumableUploadSession : public ResumableUploadSession {
       : client_(std::move(client)), session_id_(std::move(session_id)) {}
 
   StatusOr<ResumableUploadResponse> UploadChunk(
-      std::string const& buffer) override;
+      ConstBufferSequence const& buffers) override;
 
   StatusOr<ResumableUploadResponse> UploadFinalChunk(
-      std::string const& buffer, std::uint64_t upload_size) override;
+      ConstBufferSequence const& buffers, std::uint64_t upload_size) override;
 
   StatusOr<ResumableUploadResponse> ResetSession() override;
 
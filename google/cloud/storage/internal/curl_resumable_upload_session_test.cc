@@ -56,7 +56,7 @@ TEST(CurlResumableUploadSessionTest, Simple) {
   EXPECT_CALL(*mock, UploadChunk(_))
       .WillOnce(Invoke([&](UploadChunkRequest const& request) {
         EXPECT_EQ(test_url, request.upload_session_url());
-        EXPECT_EQ(payload, request.payload());
+        EXPECT_EQ(payload, ToString(request.payload()));
         EXPECT_EQ(0, request.source_size());
         EXPECT_EQ(0, request.range_begin());
         return make_status_or(ResumableUploadResponse{
@@ -64,20 +64,20 @@ TEST(CurlResumableUploadSessionTest, Simple) {
       }))
       .WillOnce(Invoke([&](UploadChunkRequest const& request) {
         EXPECT_EQ(test_url, request.upload_session_url());
-        EXPECT_EQ(payload, request.payload());
+        EXPECT_EQ(payload, ToString(request.payload()));
         EXPECT_EQ(2 * size, request.source_size());
         EXPECT_EQ(size, request.range_begin());
         return make_status_or(ResumableUploadResponse{
             "", 2 * size - 1, {}, ResumableUploadResponse::kDone, {}});
       }));
 
-  auto upload = session.UploadChunk(payload);
+  auto upload = session.UploadChunk({payload});
   EXPECT_STATUS_OK(upload);
   EXPECT_EQ(size - 1, upload->last_committed_byte);
   EXPECT_EQ(size, session.next_expected_byte());
   EXPECT_FALSE(session.done());
 
-  upload = session.UploadFinalChunk(payload, 2 * size);
+  upload = session.UploadFinalChunk({payload}, 2 * size);
   EXPECT_STATUS_OK(upload);
   EXPECT_EQ(2 * size - 1, upload->last_committed_byte);
   EXPECT_EQ(2 * size, session.next_expected_byte());
@@ -111,9 +111,9 @@ TEST(CurlResumableUploadSessionTest, Reset) {
         return make_status_or(resume_response);
       }));
 
-  auto upload = session.UploadChunk(payload);
+  auto upload = session.UploadChunk({payload});
   EXPECT_EQ(size, session.next_expected_byte());
-  upload = session.UploadChunk(payload);
+  upload = session.UploadChunk({payload});
   EXPECT_FALSE(upload.ok());
   EXPECT_EQ(size, session.next_expected_byte());
   EXPECT_EQ(url1, session.session_id());
@@ -147,9 +147,9 @@ TEST(CurlResumableUploadSessionTest, SessionUpdatedInChunkUpload) {
             url2, 2 * size - 1, {}, ResumableUploadResponse::kInProgress, {}});
       }));
 
-  auto upload = session.UploadChunk(payload);
+  auto upload = session.UploadChunk({payload});
   EXPECT_EQ(size, session.next_expected_byte());
-  upload = session.UploadChunk(payload);
+  upload = session.UploadChunk({payload});
   EXPECT_STATUS_OK(upload);
   EXPECT_EQ(2 * size, session.next_expected_byte());
   EXPECT_EQ(url2, session.session_id());
@@ -458,6 +458,10 @@ StatusOr<EmptyResponse> GrpcClient::DeleteNotification(
   return Status(StatusCode::kUnimplemented, __func__);
 }
 
+StatusOr<BatchResponse> GrpcClient::ExecuteBatch(BatchRequest const&) {
+  return Status(StatusCode::kUnimplemented, __func__);
+}
+
 template <typename GrpcRequest, typename StorageRequest>
 void SetCommonParameters(GrpcRequest& request, StorageRequest const& req) {
   if (req.template HasOption<UserProject>()) {
@@ -159,6 +159,8 @@ class GrpcClient : public RawClient,
   StatusOr<EmptyResponse> DeleteNotification(
       DeleteNotificationRequest const&) override;
 
+  StatusOr<BatchResponse> ExecuteBatch(BatchRequest const&) override;
+
   static BucketMetadata FromProto(google::storage::v1::Bucket bucket);
 
   static google::storage::v1::Object::CustomerEncryption ToProto(
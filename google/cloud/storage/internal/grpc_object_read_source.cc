@@ -15,6 +15,8 @@
 #include "google/cloud/storage/internal/grpc_object_read_source.h"
 #include "google/cloud/storage/internal/grpc_client.h"
 #include "google/cloud/grpc_error_delegate.h"
+#include <algorithm>
+#include <cstring>
 
 namespace google {
 namespace cloud {
@@ -50,63 +52,88 @@ StatusOr<HttpResponse> GrpcObjectReadSource::Close() {
   return HttpResponse{HttpStatusCode::kOk, {}, {}};
 }
 
-/// Read more data from the download, returning any HTTP headers and error
-/// codes.
 StatusOr<ReadSourceResult> GrpcObjectReadSource::Read(char* buf,
                                                       std::size_t n) {
   std::multimap<std::string, std::string> headers;
   std::size_t offset = 0;
-  auto update_buf = [&offset, buf, n](std::string source) {
-    if (source.empty()) {
-      return source;
-    }
-    auto const nbytes = std::min(n - offset, source.size());
-    std::memcpy(buf + offset, source.data(), nbytes);
+  auto drain_spill = [&] {
+    auto const nbytes = (std::min)(n - offset, spill_.size() - spill_offset_);
+    if (nbytes == 0) return;
+    std::memcpy(buf + offset, spill_.data() + spill_offset_, nbytes);
     offset += nbytes;
-    source.erase(0, nbytes);
-    return source;
+    spill_offset_ += nbytes;
   };
 
-  spill_ = update_buf(std::move(spill_));
+  drain_spill();
+  while (offset < n && ReadNextResponse(headers)) drain_spill();
 
-  while (offset < n && stream_) {
-    google::storage::v1::GetObjectMediaResponse response;
-    bool success = stream_->Read(&response);
+  if (offset != 0) {
+    return ReadSourceResult{
+        offset,
+        HttpResponse{HttpStatusCode::kContinue, {}, std::move(headers)}};
+  }
+  auto response = Response(std::move(headers));
+  if (!response) return std::move(response).status();
+  return ReadSourceResult{0, *std::move(response)};
+}
 
-    // The google.storage.v1.Storage documentation says this field can be empty.
-    if (response.has_checksummed_data()) {
-      spill_ = update_buf(
-          std::move(*response.mutable_checksummed_data()->mutable_content()));
-    }
-    if (response.has_object_checksums()) {
-      auto& checksums = response.object_checksums();
-      if (checksums.has_crc32c()) {
-        headers.emplace("x-goog-hash", "crc32c=" + GrpcClient::Crc32cFromProto(
-                                                       checksums.crc32c()));
-      }
-      if (!checksums.md5_hash().empty()) {
-        headers.emplace("x-goog-hash", "md5=" + GrpcClient::MD5FromProto(
-                                                    checksums.md5_hash()));
-      }
+StatusOr<BorrowedReadSourceResult> GrpcObjectReadSource::ReadBorrowed() {
+  std::multimap<std::string, std::string> headers;
+  while (spill_offset_ == spill_.size() && ReadNextResponse(headers)) continue;
+
+  if (spill_offset_ != spill_.size()) {
+    // The data remains valid until the next call, which is the contract for
+    // borrowed reads.
+    ConstBuffer data(spill_.data() + spill_offset_,
+                     spill_.size() - spill_offset_);
+    spill_offset_ = spill_.size();
+    return BorrowedReadSourceResult{
+        data, HttpResponse{HttpStatusCode::kContinue, {}, std::move(headers)}};
+  }
+  auto response = Response(std::move(headers));
+  if (!response) return std::move(response).status();
+  return BorrowedReadSourceResult{ConstBuffer{}, *std::move(response)};
+}
+
+bool GrpcObjectReadSource::ReadNextResponse(
+    std::multimap<std::string, std::string>& headers) {
+  if (!stream_) return false;
+  google::storage::v1::GetObjectMediaResponse response;
+  bool success = stream_->Read(&response);
+
+  // The google.storage.v1.Storage documentation says this field can be empty.
+  if (response.has_checksummed_data()) {
+    spill_ = std::move(*response.mutable_checksummed_data()->mutable_content());
+    spill_offset_ = 0;
+  }
+  if (response.has_object_checksums()) {
+    auto& checksums = response.object_checksums();
+    if (checksums.has_crc32c()) {
+      headers.emplace("x-goog-hash", "crc32c=" + GrpcClient::Crc32cFromProto(
+                                                     checksums.crc32c()));
     }
-    if (!success) {
-      status_ = google::cloud::MakeStatusFromRpcError(stream_->Finish());
-      stream_ = nullptr;
+    if (!checksums.md5_hash().empty()) {
+      headers.emplace("x-goog-hash",
+                      "md5=" + GrpcClient::MD5FromProto(checksums.md5_hash()));
     }
   }
+  if (!success) {
+    status_ = google::cloud::MakeStatusFromRpcError(stream_->Finish());
+    stream_ = nullptr;
+  }
+  return true;
+}
 
-  if (offset != 0) {
-    return ReadSourceResult{
-        offset,
-        HttpResponse{HttpStatusCode::kContinue, {}, std::move(headers)}};
+StatusOr<HttpResponse> GrpcObjectReadSource::Response(
+    std::multimap<std::string, std::string> headers) {
+  if (stream_) {
+    return HttpResponse{HttpStatusCode::kContinue, {}, std::move(headers)};
   }
   if (status_.ok()) {
     // The stream was closed successfully, but there is no more data, cannot
     // return a "OK" Status via a `StatusOr` need to provide some value.
-    return ReadSourceResult{
-        0, HttpResponse{HttpStatusCode::kOk, {}, std::move(headers)}};
+    return HttpResponse{HttpStatusCode::kOk, {}, std::move(headers)};
   }
-
   return status_;
 }
 
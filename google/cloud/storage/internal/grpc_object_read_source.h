@@ -18,6 +18,8 @@
 #include "google/cloud/storage/internal/object_read_source.h"
 #include <google/storage/v1/storage.grpc.pb.h>
 #include <functional>
+#include <map>
+#include <string>
 
 namespace google {
 namespace cloud {
@@ -37,6 +39,11 @@ using StreamMaker = std::function<std::unique_ptr<grpc::ClientReaderInterface<
  * needed. The IOStream classes (storage::ReadObjectStream,
  * storage::internal::ReadObjectStreambuf), read chunks from gRPC through this
  * class.
+ *
+ * Each response from the streaming RPC contains up to 2MiB of data. The
+ * content of the last response is kept (without copying it) until the caller
+ * consumes it. `ReadBorrowed()` lends that content to the caller, this avoids
+ * copying the data into an intermediate buffer in `ObjectReadStreambuf`.
  */
 class GrpcObjectReadSource : public ObjectReadSource {
  public:
@@ -54,7 +61,22 @@ class GrpcObjectReadSource : public ObjectReadSource {
   /// codes.
   StatusOr<ReadSourceResult> Read(char* buf, std::size_t n) override;
 
+  bool CanReadBorrowed() const override { return true; }
+  StatusOr<BorrowedReadSourceResult> ReadBorrowed() override;
+
  private:
+  /**
+   * Reads the next response, moving its content (if any) to `spill_`.
+   *
+   * Any checksums in the response are added to @p headers. Returns false if
+   * the stream was already closed.
+   */
+  bool ReadNextResponse(std::multimap<std::string, std::string>& headers);
+
+  /// Returns the final response for a closed stream, or the error status.
+  StatusOr<HttpResponse> Response(
+      std::multimap<std::string, std::string> headers);
+
   // To create a reader for a streaming RPC one needs a client context with
   // longer lifetime than the stream. This is the client context used for the
   // request.
@@ -64,8 +86,12 @@ class GrpcObjectReadSource : public ObjectReadSource {
       stream_;
 
   // In some cases the gRPC response may contain more data than the buffer
-  // provided by the application. This buffer stores any excess results.
+  // provided by the application. This buffer holds the content of the last
+  // response, moved (not copied) out of the protobuf message, and
+  // `spill_offset_` is the first byte not yet returned. Consuming data only
+  // advances `spill_offset_`, it never moves the remaining bytes.
   std::string spill_;
+  std::size_t spill_offset_ = 0;
 
   // The status of the request.
   google::cloud::Status status_;
@@ -28,7 +28,9 @@ namespace internal {
 namespace {
 
 using ::testing::_;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::Pair;
 using ::testing::Return;
 using ::testing::UnorderedElementsAre;
 
@@ -365,6 +367,78 @@ TEST(GrpcObjectReadSource, HandleExtraRead) {
   EXPECT_EQ(200, status->status_code);
 }
 
+TEST(GrpcObjectReadSource, ReadBorrowed) {
+  auto mock = absl::make_unique<MockMediaReader>();
+  std::string const expected_crc32c = "ImIEBA==";
+  EXPECT_CALL(*mock, Read(_))
+      .WillOnce([&](storage_proto::GetObjectMediaResponse* response) {
+        response->mutable_checksummed_data()->set_content("The quick brown");
+        response->mutable_object_checksums()->mutable_crc32c()->set_value(
+            GrpcClient::Crc32cToProto(expected_crc32c));
+        return true;
+      })
+      .WillOnce(Return(true))
+      .WillOnce([](storage_proto::GetObjectMediaResponse* response) {
+        response->mutable_checksummed_data()->set_content(
+            " fox jumps over the lazy dog");
+        return true;
+      })
+      .WillOnce(Return(false));
+  EXPECT_CALL(*mock, Finish()).WillOnce(Return(grpc::Status::OK));
+  GrpcObjectReadSource tested([&mock](grpc::ClientContext&) {
+    return std::unique_ptr<
+        grpc::ClientReaderInterface<storage_proto::GetObjectMediaResponse>>(
+        mock.release());
+  });
+  EXPECT_TRUE(tested.CanReadBorrowed());
+
+  // Start with a regular read, the rest of the first message is borrowed.
+  std::vector<char> buffer(4);
+  auto read = tested.Read(buffer.data(), buffer.size());
+  ASSERT_STATUS_OK(read);
+  EXPECT_EQ("The ", std::string(buffer.data(), read->bytes_received));
+  EXPECT_THAT(read->response.headers,
+              ElementsAre(Pair("x-goog-hash", "crc32c=" + expected_crc32c)));
+
+  auto response = tested.ReadBorrowed();
+  ASSERT_STATUS_OK(response);
+  EXPECT_EQ(100, response->response.status_code);
+  EXPECT_EQ("quick brown",
+            std::string(response->data.data(), response->data.size()));
+
+  // Empty messages are skipped.
+  response = tested.ReadBorrowed();
+  ASSERT_STATUS_OK(response);
+  EXPECT_EQ(100, response->response.status_code);
+  EXPECT_EQ(" fox jumps over the lazy dog",
+            std::string(response->data.data(), response->data.size()));
+
+  response = tested.ReadBorrowed();
+  ASSERT_STATUS_OK(response);
+  EXPECT_EQ(200, response->response.status_code);
+  EXPECT_TRUE(response->data.empty());
+
+  auto status = tested.Close();
+  EXPECT_STATUS_OK(status);
+  EXPECT_EQ(200, status->status_code);
+}
+
+TEST(GrpcObjectReadSource, ReadBorrowedWithError) {
+  auto mock = absl::make_unique<MockMediaReader>();
+  EXPECT_CALL(*mock, Read(_)).WillOnce(Return(false));
+  EXPECT_CALL(*mock, Finish())
+      .WillOnce(
+          Return(grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "uh-oh")));
+  GrpcObjectReadSource tested([&mock](grpc::ClientContext&) {
+    return std::unique_ptr<
+        grpc::ClientReaderInterface<storage_proto::GetObjectMediaResponse>>(
+        mock.release());
+  });
+  auto response = tested.ReadBorrowed();
+  EXPECT_EQ(StatusCode::kPermissionDenied, response.status().code());
+  EXPECT_THAT(response.status().message(), HasSubstr("uh-oh"));
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
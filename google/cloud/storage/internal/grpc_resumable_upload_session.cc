@@ -16,20 +16,49 @@
 #include "google/cloud/grpc_error_delegate.h"
 #include "absl/memory/memory.h"
 #include <crc32c/crc32c.h>
+#include <algorithm>
 
 namespace google {
 namespace cloud {
 namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace internal {
+namespace {
+/// Copies the first @p n bytes of @p buffers into @p dest, and removes them.
+void CopyAndPopFrontBytes(ConstBufferSequence& buffers, std::size_t n,
+                          std::string& dest) {
+  dest.reserve(dest.size() + n);
+  while (n != 0 && !buffers.empty()) {
+    auto const& front = buffers.front();
+    auto const count = (std::min)(n, front.size());
+    dest.append(front.data(), count);
+    PopFrontBytes(buffers, count);
+    n -= count;
+  }
+}
+
+/// Returns the views for the first @p n bytes in @p buffers.
+ConstBufferSequence FrontBytes(ConstBufferSequence const& buffers,
+                               std::size_t n) {
+  ConstBufferSequence result;
+  for (auto i = buffers.begin(); n != 0 && i != buffers.end(); ++i) {
+    auto const count = (std::min)(n, i->size());
+    result.push_back(i->subspan(0, count));
+    n -= count;
+  }
+  return result;
+}
+}  // namespace
 
 StatusOr<ResumableUploadResponse> GrpcResumableUploadSession::UploadChunk(
-    std::string const& buffer) {
+    ConstBufferSequence const& buffers) {
   CreateUploadWriter();
 
   bool success = true;
   // This loop must run at least once because we need to send at least one
   // Write() call for empty objects.
+  auto const total_bytes = TotalBytes(buffers);
+  auto remaining = buffers;
   std::size_t offset = 0;
   do {
     // This limit is for the *message*, not just the payload. It includes any
@@ -45,8 +74,8 @@ StatusOr<ResumableUploadResponse> GrpcResumableUploadSession::UploadChunk(
     request.set_finish_write(false);
 
     auto& data = *request.mutable_checksummed_data();
-    auto const n = (std::min)(buffer.size() - offset, maximum_buffer_size);
-    data.set_content(buffer.substr(offset, n));
+    auto const n = (std::min)(total_bytes - offset, maximum_buffer_size);
+    CopyAndPopFrontBytes(remaining, n, *data.mutable_content());
     data.mutable_crc32c()->set_value(crc32c::Crc32c(data.content()));
 
     success = upload_writer_->Write(request);
@@ -64,7 +93,7 @@ StatusOr<ResumableUploadResponse> GrpcResumableUploadSession::UploadChunk(
                                           ResumableUploadResponse::kInProgress,
                                           {}};
     Update(result);
-  } while (success && offset < buffer.size());
+  } while (success && offset < total_bytes);
   if (success) {
     return ResumableUploadResponse{
         {}, next_expected_ - 1, {}, ResumableUploadResponse::kInProgress, {}};
@@ -80,7 +109,7 @@ StatusOr<ResumableUploadResponse> GrpcResumableUploadSession::UploadChunk(
 }
 
 StatusOr<ResumableUploadResponse> GrpcResumableUploadSession::UploadFinalChunk(
-    std::string const& buffer, std::uint64_t) {
+    ConstBufferSequence const& buffers, std::uint64_t) {
   std::size_t const maximum_buffer_size =
       GrpcClient::kMaxInsertObjectWriteRequestSize -
       UploadChunkRequest::kChunkSizeQuantum;
@@ -94,21 +123,22 @@ StatusOr<ResumableUploadResponse> GrpcResumableUploadSession::UploadFinalChunk(
                 "Expected maximum insert request size to be greater than twice "
                 "the chunk quantum");
 
-  std::string trailer;
-  if (buffer.size() < maximum_buffer_size) {
-    trailer = buffer;
-  } else {
-    auto const last_full_chunk_pos = [&buffer] {
-      if (buffer.size() % UploadChunkRequest::kChunkSizeQuantum == 0) {
-        return buffer.size() - UploadChunkRequest::kChunkSizeQuantum;
+  auto const total_bytes = TotalBytes(buffers);
+  auto remaining = buffers;
+  if (total_bytes >= maximum_buffer_size) {
+    auto const last_full_chunk_pos = [total_bytes] {
+      if (total_bytes % UploadChunkRequest::kChunkSizeQuantum == 0) {
+        return total_bytes - UploadChunkRequest::kChunkSizeQuantum;
       }
-      return (buffer.size() / UploadChunkRequest::kChunkSizeQuantum) *
+      return (total_bytes / UploadChunkRequest::kChunkSizeQuantum) *
              UploadChunkRequest::kChunkSizeQuantum;
     }();
-    auto initial = UploadChunk(buffer.substr(0, last_full_chunk_pos));
+    auto initial = UploadChunk(FrontBytes(buffers, last_full_chunk_pos));
     if (!initial) return initial;
-    trailer = buffer.substr(last_full_chunk_pos);
+    PopFrontBytes(remaining, last_full_chunk_pos);
   }
+  std::string trailer;
+  CopyAndPopFrontBytes(remaining, total_bytes, trailer);
 
   CreateUploadWriter();
   google::storage::v1::InsertObjectRequest request;
@@ -133,7 +163,7 @@ StatusOr<ResumableUploadResponse> GrpcResumableUploadSession::UploadFinalChunk(
   if (!status.ok()) return google::cloud::MakeStatusFromRpcError(status);
 
   ResumableUploadResponse result{{},
-                                 next_expected_ + buffer.size() - 1,
+                                 next_expected_ + trailer.size() - 1,
                                  GrpcClient::FromProto(upload_object_),
                                  ResumableUploadResponse::kDone,
                                  {}};
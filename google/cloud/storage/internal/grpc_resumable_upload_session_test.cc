@@ -90,13 +90,13 @@ TEST(GrpcResumableUploadSessionTest, Simple) {
         return std::unique_ptr<GrpcClient::UploadWriter>(writer.release());
       });
 
-  auto upload = session.UploadChunk(payload);
+  auto upload = session.UploadChunk({payload});
   EXPECT_STATUS_OK(upload);
   EXPECT_EQ(size - 1, upload->last_committed_byte);
   EXPECT_EQ(size, session.next_expected_byte());
   EXPECT_FALSE(session.done());
 
-  upload = session.UploadFinalChunk(payload, 2 * size);
+  upload = session.UploadFinalChunk({payload}, 2 * size);
   EXPECT_STATUS_OK(upload);
   EXPECT_EQ(2 * size - 1, upload->last_committed_byte);
   EXPECT_EQ(2 * size, session.next_expected_byte());
@@ -147,10 +147,10 @@ TEST(GrpcResumableUploadSessionTest, Reset) {
         return make_status_or(resume_response);
       }));
 
-  auto upload = session.UploadChunk(payload);
+  auto upload = session.UploadChunk({payload});
   EXPECT_EQ(size, session.next_expected_byte());
   EXPECT_TRUE(upload.ok());
-  upload = session.UploadChunk(payload);
+  upload = session.UploadChunk({payload});
   EXPECT_FALSE(upload.ok());
   EXPECT_EQ(StatusCode::kUnavailable, upload.status().code());
 
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "google/cloud/storage/internal/hash_validator_impl.h"
+#include "google/cloud/storage/internal/crc32c_combine.h"
 #include "google/cloud/storage/internal/openssl_util.h"
 #include "google/cloud/storage/object_metadata.h"
 #include "google/cloud/internal/big_endian.h"
@@ -23,6 +24,26 @@ namespace cloud {
 namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace internal {
+namespace {
+/// Extracts the value for @p prefix (e.g. "md5=") from a `x-goog-hash` header.
+void ParseHashHeader(std::string const& key, std::string const& value,
+                     std::string const& prefix, std::string& received_hash) {
+  if (key != "x-goog-hash") {
+    return;
+  }
+  auto pos = value.find(prefix);
+  if (pos == std::string::npos) {
+    return;
+  }
+  auto end = value.find(',', pos);
+  if (end == std::string::npos) {
+    received_hash = value.substr(pos + prefix.size());
+    return;
+  }
+  received_hash = value.substr(pos + prefix.size(), end - pos - prefix.size());
+}
+}  // namespace
+
 MD5HashValidator::MD5HashValidator() : context_{} { MD5_Init(&context_); }
 
 void MD5HashValidator::Update(char const* buf, std::size_t n) {
@@ -41,21 +62,7 @@ void MD5HashValidator::ProcessMetadata(ObjectMetadata const& meta) {
 
 void MD5HashValidator::ProcessHeader(std::string const& key,
                                      std::string const& value) {
-  if (key != "x-goog-hash") {
-    return;
-  }
-  char const prefix[] = "md5=";
-  auto constexpr kPrefixLen = sizeof(prefix) - 1;
-  auto pos = value.find(prefix);
-  if (pos == std::string::npos) {
-    return;
-  }
-  auto end = value.find(',', pos);
-  if (end == std::string::npos) {
-    received_hash_ = value.substr(pos + kPrefixLen);
-    return;
-  }
-  received_hash_ = value.substr(pos + kPrefixLen, end - pos - kPrefixLen);
+  ParseHashHeader(key, value, "md5=", received_hash_);
 }
 
 HashValidator::Result MD5HashValidator::Finish() && {
@@ -83,21 +90,7 @@ void Crc32cHashValidator::ProcessMetadata(ObjectMetadata const& meta) {
 
 void Crc32cHashValidator::ProcessHeader(std::string const& key,
                                         std::string const& value) {
-  if (key != "x-goog-hash") {
-    return;
-  }
-  char const prefix[] = "crc32c=";
-  auto constexpr kPrefixLen = sizeof(prefix) - 1;
-  auto pos = value.find(prefix);
-  if (pos == std::string::npos) {
-    return;
-  }
-  auto end = value.find(',', pos);
-  if (end == std::string::npos) {
-    received_hash_ = value.substr(pos + kPrefixLen);
-    return;
-  }
-  received_hash_ = value.substr(pos + kPrefixLen, end - pos - kPrefixLen);
+  ParseHashHeader(key, value, "crc32c=", received_hash_);
 }
 
 HashValidator::Result Crc32cHashValidator::Finish() && {
@@ -107,6 +100,74 @@ HashValidator::Result Crc32cHashValidator::Finish() && {
   return Result{std::move(received_hash_), std::move(computed), is_mismatch};
 }
 
+void CombinedCrc32cHashValidator::AddRange(std::uint64_t offset,
+                                           std::uint64_t size,
+                                           std::uint32_t crc32c) {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (!ranges_.emplace(offset, Range{size, crc32c}).second) {
+    has_duplicates_ = true;
+  }
+}
+
+void CombinedCrc32cHashValidator::AddRange(std::uint64_t offset,
+                                           char const* buf, std::size_t n) {
+  AddRange(offset, n,
+           crc32c::Extend(0, reinterpret_cast<std::uint8_t const*>(buf), n));
+}
+
+void CombinedCrc32cHashValidator::Update(char const* buf, std::size_t n) {
+  if (n == 0) return;
+  std::lock_guard<std::mutex> lk(mu_);
+  if (ranges_.empty()) ranges_.emplace(0, Range{0, 0});
+  // Extend the last range, this is equivalent to (but faster than) adding a
+  // new range for each call.
+  auto& last = ranges_.rbegin()->second;
+  last.crc32c = crc32c::Extend(
+      last.crc32c, reinterpret_cast<std::uint8_t const*>(buf), n);
+  last.size += n;
+}
+
+void CombinedCrc32cHashValidator::ProcessMetadata(ObjectMetadata const& meta) {
+  // See the comments in Crc32cHashValidator::ProcessMetadata()
+  if (meta.crc32c().empty()) return;
+  received_hash_ = meta.crc32c();
+}
+
+void CombinedCrc32cHashValidator::ProcessHeader(std::string const& key,
+                                                std::string const& value) {
+  ParseHashHeader(key, value, "crc32c=", received_hash_);
+}
+
+HashValidator::Result CombinedCrc32cHashValidator::Finish() && {
+  std::lock_guard<std::mutex> lk(mu_);
+  std::uint32_t current = 0;
+  std::uint64_t expected_offset = 0;
+  bool has_gaps = false;
+  for (auto const& kv : ranges_) {
+    if (kv.first != expected_offset) {
+      has_gaps = true;
+      break;
+    }
+    current = Crc32cCombine(current, kv.second.crc32c, kv.second.size);
+    expected_offset += kv.second.size;
+  }
+  if (has_gaps || has_duplicates_) {
+    // The computed value is meaningless, report it as a mismatch even if
+    // there is no received value to compare against.
+    return Result{std::move(received_hash_), std::string{}, true};
+  }
+  std::string const hash = google::cloud::internal::EncodeBigEndian(current);
+  auto computed = Base64Encode(hash);
+  bool is_mismatch = !received_hash_.empty() && (received_hash_ != computed);
+  return Result{std::move(received_hash_), std::move(computed), is_mismatch};
+}
+
+StatusOr<std::uint32_t> DecodeCrc32cChecksum(std::string const& value) {
+  auto decoded = Base64Decode(value);
+  return google::cloud::internal::DecodeBigEndian<std::uint32_t>(
+      std::string(decoded.begin(), decoded.end()));
+}
+
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
@@ -17,7 +17,11 @@
 
 #include "google/cloud/storage/internal/hash_validator.h"
 #include "google/cloud/storage/version.h"
+#include "google/cloud/status_or.h"
 #include <openssl/md5.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
 
 namespace google {
 namespace cloud {
@@ -67,6 +71,61 @@ class Crc32cHashValidator : public HashValidator {
   std::string received_hash_;
 };
 
+/**
+ * A validator based on CRC32C checksums computed over independent ranges.
+ *
+ * `Crc32cHashValidator` must receive all the data in order, so a single thread
+ * computes the checksum of the full object. This validator receives the
+ * checksums of separate ranges, which can be computed in different threads,
+ * and in any order. The checksums are combined (see `Crc32cCombine()`) into
+ * the checksum of the full object when `Finish()` is called. Combining the
+ * checksums is very cheap compared to hashing the data.
+ *
+ * Calling `Update()` appends the data after the last range, so this class can
+ * be used as a drop-in replacement for `Crc32cHashValidator`. `AddRange()` is
+ * thread-safe, and it is the only member function that can be called
+ * concurrently.
+ *
+ * If the ranges overlap, or do not cover the object without gaps, `Finish()`
+ * reports a mismatch.
+ */
+class CombinedCrc32cHashValidator : public HashValidator {
+ public:
+  CombinedCrc32cHashValidator() = default;
+
+  CombinedCrc32cHashValidator(CombinedCrc32cHashValidator const&) = delete;
+  CombinedCrc32cHashValidator& operator=(CombinedCrc32cHashValidator const&) =
+      delete;
+
+  /// Records the CRC32C checksum of the `[offset, offset + size)` range.
+  void AddRange(std::uint64_t offset, std::uint64_t size, std::uint32_t crc32c);
+
+  /// Computes and records the checksum of @p n bytes starting at @p offset.
+  void AddRange(std::uint64_t offset, char const* buf, std::size_t n);
+
+  std::string Name() const override { return "crc32c"; }
+  void Update(char const* buf, std::size_t n) override;
+  void ProcessMetadata(ObjectMetadata const& meta) override;
+  void ProcessHeader(std::string const& key, std::string const& value) override;
+  Result Finish() && override;
+
+ private:
+  struct Range {
+    std::uint64_t size;
+    std::uint32_t crc32c;
+  };
+
+  std::mutex mu_;
+  // Indexed by the offset of each range.
+  std::map<std::uint64_t, Range> ranges_;  // GUARDED_BY(mu_)
+  bool has_duplicates_ = false;           // GUARDED_BY(mu_)
+  std::string received_hash_;
+};
+
+/// Decodes a CRC32C checksum in the format used by GCS, i.e., the base64
+/// encoding of the big-endian representation.
+StatusOr<std::uint32_t> DecodeCrc32cChecksum(std::string const& value);
+
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
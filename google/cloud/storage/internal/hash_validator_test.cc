@@ -150,6 +150,99 @@ TEST(Crc32cHashValidator, MultipleHashes) {
   EXPECT_TRUE(result.is_mismatch);
 }
 
+TEST(CombinedCrc32cHashValidator, Empty) {
+  CombinedCrc32cHashValidator validator;
+  validator.ProcessHeader("x-goog-hash",
+                          "crc32c=" + kEmptyStringCrc32cChecksum);
+  auto result = std::move(validator).Finish();
+  EXPECT_EQ(kEmptyStringCrc32cChecksum, result.computed);
+  EXPECT_FALSE(result.is_mismatch);
+}
+
+TEST(CombinedCrc32cHashValidator, Update) {
+  CombinedCrc32cHashValidator validator;
+  UpdateValidator(validator, "The quick");
+  UpdateValidator(validator, " brown");
+  UpdateValidator(validator, " fox jumps over the lazy dog");
+  validator.ProcessHeader("x-goog-hash", "crc32c=" + kQuickFoxCrc32cChecksum);
+  auto result = std::move(validator).Finish();
+  EXPECT_EQ(kQuickFoxCrc32cChecksum, result.computed);
+  EXPECT_FALSE(result.is_mismatch);
+}
+
+TEST(CombinedCrc32cHashValidator, RangesOutOfOrder) {
+  std::string const quick = "The quick";
+  std::string const brown = " brown";
+  std::string const fox = " fox jumps over the lazy dog";
+  CombinedCrc32cHashValidator validator;
+  validator.AddRange(quick.size() + brown.size(), fox.data(), fox.size());
+  validator.AddRange(0, quick.data(), quick.size());
+  validator.AddRange(quick.size(), brown.data(), brown.size());
+  validator.ProcessHeader("x-goog-hash", "crc32c=" + kQuickFoxCrc32cChecksum);
+  auto result = std::move(validator).Finish();
+  EXPECT_EQ(kQuickFoxCrc32cChecksum, result.computed);
+  EXPECT_FALSE(result.is_mismatch);
+}
+
+TEST(CombinedCrc32cHashValidator, Mismatch) {
+  std::string const quick = "The quick";
+  CombinedCrc32cHashValidator validator;
+  validator.AddRange(0, quick.data(), quick.size());
+  validator.ProcessHeader("x-goog-hash", "crc32c=" + kQuickFoxCrc32cChecksum);
+  auto result = std::move(validator).Finish();
+  EXPECT_EQ(kQuickFoxCrc32cChecksum, result.received);
+  EXPECT_TRUE(result.is_mismatch);
+}
+
+TEST(CombinedCrc32cHashValidator, Gaps) {
+  std::string const quick = "The quick";
+  std::string const fox = " fox jumps over the lazy dog";
+  CombinedCrc32cHashValidator validator;
+  validator.AddRange(0, quick.data(), quick.size());
+  validator.AddRange(quick.size() + 6, fox.data(), fox.size());
+  auto result = std::move(validator).Finish();
+  EXPECT_TRUE(result.computed.empty());
+  EXPECT_TRUE(result.is_mismatch);
+}
+
+TEST(CombinedCrc32cHashValidator, Duplicates) {
+  std::string const quick = "The quick";
+  CombinedCrc32cHashValidator validator;
+  validator.AddRange(0, quick.data(), quick.size());
+  validator.AddRange(0, quick.data(), quick.size());
+  auto result = std::move(validator).Finish();
+  EXPECT_TRUE(result.computed.empty());
+  EXPECT_TRUE(result.is_mismatch);
+}
+
+TEST(CombinedCrc32cHashValidator, ProcessMetadata) {
+  CombinedCrc32cHashValidator validator;
+  UpdateValidator(validator, "The quick brown fox jumps over the lazy dog");
+  auto object_metadata = internal::ObjectMetadataParser::FromJson(
+                             internal::nl::json{
+                                 {"crc32c", kQuickFoxCrc32cChecksum},
+                             })
+                             .value();
+  validator.ProcessMetadata(object_metadata);
+  auto result = std::move(validator).Finish();
+  EXPECT_EQ(kQuickFoxCrc32cChecksum, result.received);
+  EXPECT_EQ(kQuickFoxCrc32cChecksum, result.computed);
+  EXPECT_FALSE(result.is_mismatch);
+}
+
+TEST(DecodeCrc32cChecksum, Simple) {
+  auto actual = DecodeCrc32cChecksum(kQuickFoxCrc32cChecksum);
+  ASSERT_TRUE(actual.ok()) << actual.status();
+  EXPECT_EQ(0x22620404U, *actual);
+
+  actual = DecodeCrc32cChecksum(kEmptyStringCrc32cChecksum);
+  ASSERT_TRUE(actual.ok()) << actual.status();
+  EXPECT_EQ(0U, *actual);
+
+  EXPECT_FALSE(DecodeCrc32cChecksum("").ok());
+  EXPECT_FALSE(DecodeCrc32cChecksum(kQuickFoxMD5Hash).ok());
+}
+
 TEST(CompositeHashValidator, Empty) {
   CompositeValidator validator(absl::make_unique<Crc32cHashValidator>(),
                                absl::make_unique<MD5HashValidator>());
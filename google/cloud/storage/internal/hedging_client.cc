@@ -0,0 +1,557 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/hedging_client.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+/// The state shared by the requests in a hedged call.
+template <typename T>
+struct HedgeState {
+  std::mutex mu;
+  std::condition_variable cv;
+  int launched = 0;
+  int failures = 0;
+  bool done = false;
+  bool hedge_won = false;
+  StatusOr<T> result;
+};
+
+/**
+ * Returns a function to run @p attempt in a `HedgingThreadPool`.
+ *
+ * The first attempt to succeed sets the result of the call. If all the
+ * attempts fail the last error is the result. Successful attempts that finish
+ * after the result is set are passed to @p cancel.
+ */
+template <typename T>
+std::function<void()> MakeAttempt(std::shared_ptr<HedgeState<T>> state,
+                                  std::shared_ptr<HedgingPolicy> policy,
+                                  std::string operation,
+                                  std::function<StatusOr<T>()> attempt,
+                                  std::function<void(T)> cancel,
+                                  bool is_hedge) {
+  return [state, policy, operation, attempt, cancel, is_hedge] {
+    auto const start = std::chrono::steady_clock::now();
+    auto r = attempt();
+    auto const elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    // Only the original requests define the latency distribution, otherwise
+    // the hedged requests would lower the delay before hedging.
+    if (r && !is_hedge) policy->OnCompletion(operation, elapsed);
+    std::unique_lock<std::mutex> lk(state->mu);
+    if (state->done) {
+      lk.unlock();
+      if (r) cancel(*std::move(r));
+      return;
+    }
+    if (!r && ++state->failures != state->launched) return;
+    state->done = true;
+    state->hedge_won = r && is_hedge;
+    state->result = std::move(r);
+    lk.unlock();
+    state->cv.notify_one();
+  };
+}
+
+/**
+ * Runs @p attempt, and a duplicate if it does not complete in time.
+ *
+ * If a duplicate request cannot be issued, because the budget is spent or
+ * there are no background threads available, the call runs @p direct in the
+ * calling thread, without hedging. Otherwise @p attempt runs in a background
+ * thread, a request running in the calling thread could not be abandoned if
+ * the duplicate wins.
+ */
+template <typename T>
+StatusOr<T> Hedge(HedgingThreadPool& threads,
+                  std::shared_ptr<HedgingPolicy> const& policy,
+                  std::string const& operation,
+                  std::function<StatusOr<T>()> const& attempt,
+                  std::function<StatusOr<T>()> const& direct,
+                  std::function<void(T)> const& cancel) {
+  auto const delay = policy->OnCall(operation);
+  if (!policy->CanHedge()) return direct();
+  auto state = std::make_shared<HedgeState<T>>();
+  std::unique_lock<std::mutex> lk(state->mu);
+  state->launched = 1;
+  if (!threads.TrySchedule(
+          MakeAttempt(state, policy, operation, attempt, cancel, false))) {
+    lk.unlock();
+    return direct();
+  }
+  if (!state->cv.wait_for(lk, delay, [&state] { return state->done; })) {
+    auto const hedged = threads.TrySchedule(
+        MakeAttempt(state, policy, operation, attempt, cancel, true),
+        [&policy] { return policy->AcquireHedge(); });
+    if (hedged) ++state->launched;
+    state->cv.wait(lk, [&state] { return state->done; });
+    if (hedged) policy->OnHedgeResult(state->hedge_won);
+  }
+  return std::move(state->result);
+}
+
+/**
+ * Returns the data read by a hedged `ReadObject()`, then reads from @p child.
+ *
+ * The data is either in @p buffer, or, if @p buffer is null, lent by @p child
+ * and valid until the next call on @p child.
+ */
+class PrefetchedObjectReadSource : public ObjectReadSource {
+ public:
+  PrefetchedObjectReadSource(std::unique_ptr<ObjectReadSource> child,
+                             std::unique_ptr<char[]> buffer, ConstBuffer data,
+                             HttpResponse response)
+      : child_(std::move(child)),
+        buffer_(std::move(buffer)),
+        data_(data),
+        response_(std::move(response)) {}
+
+  bool IsOpen() const override { return pending_ || child_->IsOpen(); }
+  StatusOr<HttpResponse> Close() override {
+    pending_ = false;
+    return child_->Close();
+  }
+  StatusOr<ReadSourceResult> Read(char* buf, std::size_t n) override {
+    if (!pending_) return child_->Read(buf, n);
+    auto const count = (std::min)(n, data_.size() - offset_);
+    if (count != 0) std::memcpy(buf, data_.data() + offset_, count);
+    offset_ += count;
+    return ReadSourceResult{count, NextResponse()};
+  }
+  // The prefetched data is lent without copying it, even if the child cannot
+  // lend its buffers.
+  bool CanReadBorrowed() const override {
+    return pending_ || child_->CanReadBorrowed();
+  }
+  StatusOr<BorrowedReadSourceResult> ReadBorrowed() override {
+    if (!pending_) return child_->ReadBorrowed();
+    ConstBuffer data(data_.data() + offset_, data_.size() - offset_);
+    offset_ = data_.size();
+    return BorrowedReadSourceResult{data, NextResponse()};
+  }
+
+ private:
+  // The headers are sent with the first piece of data, the status code of the
+  // prefetched read with the last one.
+  HttpResponse NextResponse() {
+    if (offset_ != data_.size()) {
+      auto headers = std::move(response_.headers);
+      response_.headers.clear();
+      return HttpResponse{HttpStatusCode::kContinue, {}, std::move(headers)};
+    }
+    pending_ = false;
+    return std::move(response_);
+  }
+
+  std::unique_ptr<ObjectReadSource> child_;
+  std::unique_ptr<char[]> buffer_;
+  ConstBuffer data_;
+  std::size_t offset_ = 0;
+  HttpResponse response_;
+  bool pending_ = true;
+};
+}  // namespace
+
+HedgingThreadPool::~HedgingThreadPool() {
+  std::unique_lock<std::mutex> lk(mu_);
+  shutdown_ = true;
+  lk.unlock();
+  cv_.notify_all();
+  for (auto& t : threads_) t.join();
+}
+
+bool HedgingThreadPool::TrySchedule(std::function<void()> work,
+                                    std::function<bool()> const& admit) {
+  std::unique_lock<std::mutex> lk(mu_);
+  auto const has_idle_thread = idle_ > queue_.size();
+  if (!has_idle_thread && threads_.size() >= max_threads_) return false;
+  if (admit && !admit()) return false;
+  queue_.push_back(std::move(work));
+  if (!has_idle_thread) {
+    threads_.emplace_back([this] { Run(); });
+    return true;
+  }
+  lk.unlock();
+  cv_.notify_one();
+  return true;
+}
+
+void HedgingThreadPool::Run() {
+  std::unique_lock<std::mutex> lk(mu_);
+  for (;;) {
+    ++idle_;
+    cv_.wait(lk, [this] { return shutdown_ || !queue_.empty(); });
+    --idle_;
+    // Drain the queue before shutting down, the callers are waiting for the
+    // results.
+    if (queue_.empty()) return;
+    auto work = std::move(queue_.front());
+    queue_.pop_front();
+    lk.unlock();
+    work();
+    lk.lock();
+  }
+}
+
+std::size_t constexpr HedgingClient::kMaximumBackgroundThreads;
+
+ClientOptions const& HedgingClient::client_options() const {
+  return client_->client_options();
+}
+
+std::size_t HedgingClient::upload_buffer_size() const {
+  return client_->upload_buffer_size();
+}
+
+ConnectionPoolStats HedgingClient::connection_pool_stats() const {
+  return client_->connection_pool_stats();
+}
+
+StatusOr<ListBucketsResponse> HedgingClient::ListBuckets(
+    ListBucketsRequest const& request) {
+  return client_->ListBuckets(request);
+}
+
+StatusOr<BucketMetadata> HedgingClient::CreateBucket(
+    CreateBucketRequest const& request) {
+  return client_->CreateBucket(request);
+}
+
+StatusOr<BucketMetadata> HedgingClient::GetBucketMetadata(
+    GetBucketMetadataRequest const& request) {
+  return client_->GetBucketMetadata(request);
+}
+
+StatusOr<EmptyResponse> HedgingClient::DeleteBucket(
+    DeleteBucketRequest const& request) {
+  return client_->DeleteBucket(request);
+}
+
+StatusOr<BucketMetadata> HedgingClient::UpdateBucket(
+    UpdateBucketRequest const& request) {
+  return client_->UpdateBucket(request);
+}
+
+StatusOr<BucketMetadata> HedgingClient::PatchBucket(
+    PatchBucketRequest const& request) {
+  return client_->PatchBucket(request);
+}
+
+StatusOr<IamPolicy> HedgingClient::GetBucketIamPolicy(
+    GetBucketIamPolicyRequest const& request) {
+  return client_->GetBucketIamPolicy(request);
+}
+
+StatusOr<NativeIamPolicy> HedgingClient::GetNativeBucketIamPolicy(
+    GetBucketIamPolicyRequest const& request) {
+  return client_->GetNativeBucketIamPolicy(request);
+}
+
+StatusOr<IamPolicy> HedgingClient::SetBucketIamPolicy(
+    SetBucketIamPolicyRequest const& request) {
+  return client_->SetBucketIamPolicy(request);
+}
+
+StatusOr<NativeIamPolicy> HedgingClient::SetNativeBucketIamPolicy(
+    SetNativeBucketIamPolicyRequest const& request) {
+  return client_->SetNativeBucketIamPolicy(request);
+}
+
+StatusOr<TestBucketIamPermissionsResponse>
+HedgingClient::TestBucketIamPermissions(
+    TestBucketIamPermissionsRequest const& request) {
+  return client_->TestBucketIamPermissions(request);
+}
+
+StatusOr<BucketMetadata> HedgingClient::LockBucketRetentionPolicy(
+    LockBucketRetentionPolicyRequest const& request) {
+  return client_->LockBucketRetentionPolicy(request);
+}
+
+StatusOr<ObjectMetadata> HedgingClient::InsertObjectMedia(
+    InsertObjectMediaRequest const& request) {
+  return client_->InsertObjectMedia(request);
+}
+
+StatusOr<ObjectMetadata> HedgingClient::CopyObject(
+    CopyObjectRequest const& request) {
+  return client_->CopyObject(request);
+}
+
+StatusOr<ObjectMetadata> HedgingClient::GetObjectMetadata(
+    GetObjectMetadataRequest const& request) {
+  if (!idempotency_policy_->IsIdempotent(request)) {
+    return client_->GetObjectMetadata(request);
+  }
+  auto client = client_;
+  std::function<StatusOr<ObjectMetadata>()> attempt = [client, request] {
+    return client->GetObjectMetadata(request);
+  };
+  return Hedge<ObjectMetadata>(*threads_, policy_, __func__, attempt, attempt,
+                               [](ObjectMetadata) {});
+}
+
+StatusOr<std::unique_ptr<ObjectReadSource>> HedgingClient::ReadObject(
+    ReadObjectRangeRequest const& request) {
+  if (!idempotency_policy_->IsIdempotent(request)) {
+    return client_->ReadObject(request);
+  }
+  auto client = client_;
+  auto const size = client_->client_options().download_buffer_size();
+  using Source = std::unique_ptr<ObjectReadSource>;
+  // Each request includes the first read, where the transport waits for the
+  // service to start sending data. Sources that can lend their buffers avoid
+  // allocating a buffer for it.
+  auto attempt = [client, request, size]() -> StatusOr<Source> {
+    auto source = client->ReadObject(request);
+    if (!source) return source;
+    std::unique_ptr<char[]> buffer;
+    ConstBuffer data;
+    HttpResponse response;
+    if ((*source)->CanReadBorrowed()) {
+      auto r = (*source)->ReadBorrowed();
+      if (!r) {
+        (void)(*source)->Close();
+        return std::move(r).status();
+      }
+      data = r->data;
+      response = std::move(r->response);
+    } else {
+      buffer.reset(new char[size]);
+      auto r = (*source)->Read(buffer.get(), size);
+      if (!r) {
+        (void)(*source)->Close();
+        return std::move(r).status();
+      }
+      data = ConstBuffer(buffer.get(), r->bytes_received);
+      response = std::move(r->response);
+    }
+    if (response.status_code >= HttpStatusCode::kMinNotSuccess) {
+      (void)(*source)->Close();
+      return AsStatus(response);
+    }
+    return Source(new PrefetchedObjectReadSource(
+        *std::move(source), std::move(buffer), data, std::move(response)));
+  };
+  // Without hedging there is no need to read ahead.
+  auto direct = [client, request] { return client->ReadObject(request); };
+  return Hedge<Source>(*threads_, policy_, __func__, attempt, direct,
+                       [](Source s) { (void)s->Close(); });
+}
+
+StatusOr<ListObjectsResponse> HedgingClient::ListObjects(
+    ListObjectsRequest const& request) {
+  return client_->ListObjects(request);
+}
+
+StatusOr<EmptyResponse> HedgingClient::DeleteObject(
+    DeleteObjectRequest const& request) {
+  return client_->DeleteObject(request);
+}
+
+StatusOr<ObjectMetadata> HedgingClient::UpdateObject(
+    UpdateObjectRequest const& request) {
+  return client_->UpdateObject(request);
+}
+
+StatusOr<ObjectMetadata> HedgingClient::PatchObject(
+    PatchObjectRequest const& request) {
+  return client_->PatchObject(request);
+}
+
+StatusOr<ObjectMetadata> HedgingClient::ComposeObject(
+    ComposeObjectRequest const& request) {
+  return client_->ComposeObject(request);
+}
+
+StatusOr<RewriteObjectResponse> HedgingClient::RewriteObject(
+    RewriteObjectRequest const& request) {
+  return client_->RewriteObject(request);
+}
+
+StatusOr<std::unique_ptr<ResumableUploadSession>>
+HedgingClient::CreateResumableSession(ResumableUploadRequest const& request) {
+  return client_->CreateResumableSession(request);
+}
+
+StatusOr<std::unique_ptr<ResumableUploadSession>>
+HedgingClient::RestoreResumableSession(std::string const& upload_id) {
+  return client_->RestoreResumableSession(upload_id);
+}
+
+StatusOr<ListBucketAclResponse> HedgingClient::ListBucketAcl(
+    ListBucketAclRequest const& request) {
+  return client_->ListBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> HedgingClient::CreateBucketAcl(
+    CreateBucketAclRequest const& request) {
+  return client_->CreateBucketAcl(request);
+}
+
+StatusOr<EmptyResponse> HedgingClient::DeleteBucketAcl(
+    DeleteBucketAclRequest const& request) {
+  return client_->DeleteBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> HedgingClient::GetBucketAcl(
+    GetBucketAclRequest const& request) {
+  return client_->GetBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> HedgingClient::UpdateBucketAcl(
+    UpdateBucketAclRequest const& request) {
+  return client_->UpdateBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> HedgingClient::PatchBucketAcl(
+    PatchBucketAclRequest const& request) {
+  return client_->PatchBucketAcl(request);
+}
+
+StatusOr<ListObjectAclResponse> HedgingClient::ListObjectAcl(
+    ListObjectAclRequest const& request) {
+  return client_->ListObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> HedgingClient::CreateObjectAcl(
+    CreateObjectAclRequest const& request) {
+  return client_->CreateObjectAcl(request);
+}
+
+StatusOr<EmptyResponse> HedgingClient::DeleteObjectAcl(
+    DeleteObjectAclRequest const& request) {
+  return client_->DeleteObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> HedgingClient::GetObjectAcl(
+    GetObjectAclRequest const& request) {
+  return client_->GetObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> HedgingClient::UpdateObjectAcl(
+    UpdateObjectAclRequest const& request) {
+  return client_->UpdateObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> HedgingClient::PatchObjectAcl(
+    PatchObjectAclRequest const& request) {
+  return client_->PatchObjectAcl(request);
+}
+
+StatusOr<ListDefaultObjectAclResponse> HedgingClient::ListDefaultObjectAcl(
+    ListDefaultObjectAclRequest const& request) {
+  return client_->ListDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> HedgingClient::CreateDefaultObjectAcl(
+    CreateDefaultObjectAclRequest const& request) {
+  return client_->CreateDefaultObjectAcl(request);
+}
+
+StatusOr<EmptyResponse> HedgingClient::DeleteDefaultObjectAcl(
+    DeleteDefaultObjectAclRequest const& request) {
+  return client_->DeleteDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> HedgingClient::GetDefaultObjectAcl(
+    GetDefaultObjectAclRequest const& request) {
+  return client_->GetDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> HedgingClient::UpdateDefaultObjectAcl(
+    UpdateDefaultObjectAclRequest const& request) {
+  return client_->UpdateDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> HedgingClient::PatchDefaultObjectAcl(
+    PatchDefaultObjectAclRequest const& request) {
+  return client_->PatchDefaultObjectAcl(request);
+}
+
+StatusOr<ServiceAccount> HedgingClient::GetServiceAccount(
+    GetProjectServiceAccountRequest const& request) {
+  return client_->GetServiceAccount(request);
+}
+
+StatusOr<ListHmacKeysResponse> HedgingClient::ListHmacKeys(
+    ListHmacKeysRequest const& request) {
+  return client_->ListHmacKeys(request);
+}
+
+StatusOr<CreateHmacKeyResponse> HedgingClient::CreateHmacKey(
+    CreateHmacKeyRequest const& request) {
+  return client_->CreateHmacKey(request);
+}
+
+StatusOr<EmptyResponse> HedgingClient::DeleteHmacKey(
+    DeleteHmacKeyRequest const& request) {
+  return client_->DeleteHmacKey(request);
+}
+
+StatusOr<HmacKeyMetadata> HedgingClient::GetHmacKey(
+    GetHmacKeyRequest const& request) {
+  return client_->GetHmacKey(request);
+}
+
+StatusOr<HmacKeyMetadata> HedgingClient::UpdateHmacKey(
+    UpdateHmacKeyRequest const& request) {
+  return client_->UpdateHmacKey(request);
+}
+
+StatusOr<SignBlobResponse> HedgingClient::SignBlob(
+    SignBlobRequest const& request) {
+  return client_->SignBlob(request);
+}
+
+StatusOr<ListNotificationsResponse> HedgingClient::ListNotifications(
+    ListNotificationsRequest const& request) {
+  return client_->ListNotifications(request);
+}
+
+StatusOr<NotificationMetadata> HedgingClient::CreateNotification(
+    CreateNotificationRequest const& request) {
+  return client_->CreateNotification(request);
+}
+
+StatusOr<NotificationMetadata> HedgingClient::GetNotification(
+    GetNotificationRequest const& request) {
+  return client_->GetNotification(request);
+}
+
+StatusOr<EmptyResponse> HedgingClient::DeleteNotification(
+    DeleteNotificationRequest const& request) {
+  return client_->DeleteNotification(request);
+}
+
+StatusOr<BatchResponse> HedgingClient::ExecuteBatch(
+    BatchRequest const& request) {
+  return client_->ExecuteBatch(request);
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,260 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_HEDGING_CLIENT_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_HEDGING_CLIENT_H
+
+#include "google/cloud/storage/hedging_policy.h"
+#include "google/cloud/storage/idempotency_policy.h"
+#include "google/cloud/storage/internal/raw_client.h"
+#include "google/cloud/storage/retry_policy.h"
+#include "google/cloud/storage/version.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * Runs the requests of a `HedgingClient` in background threads.
+ *
+ * The threads are created on demand, up to `max_threads`, and reused for
+ * later requests. The destructor waits for all the scheduled work, including
+ * requests that lost the race, before returning.
+ */
+class HedgingThreadPool {
+ public:
+  explicit HedgingThreadPool(std::size_t max_threads)
+      : max_threads_(max_threads) {}
+  ~HedgingThreadPool();
+
+  HedgingThreadPool(HedgingThreadPool const&) = delete;
+  HedgingThreadPool& operator=(HedgingThreadPool const&) = delete;
+
+  /**
+   * Runs @p work in a background thread if one is available.
+   *
+   * Returns false, without calling @p work, if all the threads are busy or
+   * if @p admit returns false. @p admit is called with the pool lock held,
+   * only once a thread is available.
+   */
+  bool TrySchedule(std::function<void()> work,
+                   std::function<bool()> const& admit = {});
+
+ private:
+  void Run();
+
+  std::size_t const max_threads_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> queue_;
+  std::size_t idle_ = 0;
+  bool shutdown_ = false;
+  std::vector<std::thread> threads_;
+};
+
+/**
+ * A decorator for `RawClient` that hedges small reads to reduce tail latency.
+ *
+ * `GetObjectMetadata()` and `ReadObject()` calls that take longer than the
+ * delay chosen by the `HedgingPolicy` are duplicated, and the result of the
+ * first request to succeed is used. Only idempotent requests, as defined by
+ * the `IdempotencyPolicy`, are hedged.
+ *
+ * For `ReadObject()` the hedged part of the call includes the first read from
+ * the object, up to `download_buffer_size()` bytes, as that is where the
+ * REST transport waits for the service. Small objects are read completely by
+ * the hedged requests, larger objects continue reading from the winner.
+ *
+ * The requests run in a `HedgingThreadPool` owned by this class, with at most
+ * `kMaximumBackgroundThreads` threads. If all the threads are busy, or the
+ * hedging budget is spent, the call runs in the calling thread, without
+ * hedging. The losing request of a
+ * `ReadObject()` call is closed as soon as its first read completes, which
+ * stops the download. A losing `GetObjectMetadata()` request cannot be
+ * interrupted, its result is discarded. The destructor waits for any losing
+ * requests still running.
+ *
+ * All other operations are forwarded to the decorated client.
+ */
+class HedgingClient : public RawClient {
+ public:
+  /// The maximum number of requests running in background threads.
+  static std::size_t constexpr kMaximumBackgroundThreads = 64;
+
+  template <typename... Policies>
+  explicit HedgingClient(std::shared_ptr<RawClient> client,
+                         std::shared_ptr<HedgingPolicy> policy,
+                         Policies&&... policies)
+      : client_(std::move(client)),
+        policy_(std::move(policy)),
+        idempotency_policy_(AlwaysRetryIdempotencyPolicy().clone()),
+        threads_(new HedgingThreadPool(kMaximumBackgroundThreads)) {
+    ApplyPolicies(std::forward<Policies>(policies)...);
+  }
+  ~HedgingClient() override = default;
+
+  ClientOptions const& client_options() const override;
+  std::size_t upload_buffer_size() const override;
+  ConnectionPoolStats connection_pool_stats() const override;
+
+  StatusOr<ListBucketsResponse> ListBuckets(
+      ListBucketsRequest const& request) override;
+  StatusOr<BucketMetadata> CreateBucket(
+      CreateBucketRequest const& request) override;
+  StatusOr<BucketMetadata> GetBucketMetadata(
+      GetBucketMetadataRequest const& request) override;
+  StatusOr<EmptyResponse> DeleteBucket(DeleteBucketRequest const&) override;
+  StatusOr<BucketMetadata> UpdateBucket(
+      UpdateBucketRequest const& request) override;
+  StatusOr<BucketMetadata> PatchBucket(
+      PatchBucketRequest const& request) override;
+  StatusOr<IamPolicy> GetBucketIamPolicy(
+      GetBucketIamPolicyRequest const& request) override;
+  StatusOr<NativeIamPolicy> GetNativeBucketIamPolicy(
+      GetBucketIamPolicyRequest const& request) override;
+  StatusOr<IamPolicy> SetBucketIamPolicy(
+      SetBucketIamPolicyRequest const& request) override;
+  StatusOr<NativeIamPolicy> SetNativeBucketIamPolicy(
+      SetNativeBucketIamPolicyRequest const& request) override;
+  StatusOr<TestBucketIamPermissionsResponse> TestBucketIamPermissions(
+      TestBucketIamPermissionsRequest const& request) override;
+  StatusOr<BucketMetadata> LockBucketRetentionPolicy(
+      LockBucketRetentionPolicyRequest const& request) override;
+
+  StatusOr<ObjectMetadata> InsertObjectMedia(
+      InsertObjectMediaRequest const& request) override;
+  StatusOr<ObjectMetadata> CopyObject(
+      CopyObjectRequest const& request) override;
+  StatusOr<ObjectMetadata> GetObjectMetadata(
+      GetObjectMetadataRequest const& request) override;
+  StatusOr<std::unique_ptr<ObjectReadSource>> ReadObject(
+      ReadObjectRangeRequest const&) override;
+  StatusOr<ListObjectsResponse> ListObjects(ListObjectsRequest const&) override;
+  StatusOr<EmptyResponse> DeleteObject(DeleteObjectRequest const&) override;
+  StatusOr<ObjectMetadata> UpdateObject(
+      UpdateObjectRequest const& request) override;
+  StatusOr<ObjectMetadata> PatchObject(
+      PatchObjectRequest const& request) override;
+  StatusOr<ObjectMetadata> ComposeObject(
+      ComposeObjectRequest const& request) override;
+  StatusOr<RewriteObjectResponse> RewriteObject(
+      RewriteObjectRequest const&) override;
+  StatusOr<std::unique_ptr<ResumableUploadSession>> CreateResumableSession(
+      ResumableUploadRequest const& request) override;
+  StatusOr<std::unique_ptr<ResumableUploadSession>> RestoreResumableSession(
+      std::string const& request) override;
+
+  StatusOr<ListBucketAclResponse> ListBucketAcl(
+      ListBucketAclRequest const& request) override;
+  StatusOr<BucketAccessControl> CreateBucketAcl(
+      CreateBucketAclRequest const&) override;
+  StatusOr<EmptyResponse> DeleteBucketAcl(
+      DeleteBucketAclRequest const&) override;
+  StatusOr<BucketAccessControl> GetBucketAcl(
+      GetBucketAclRequest const&) override;
+  StatusOr<BucketAccessControl> UpdateBucketAcl(
+      UpdateBucketAclRequest const&) override;
+  StatusOr<BucketAccessControl> PatchBucketAcl(
+      PatchBucketAclRequest const&) override;
+
+  StatusOr<ListObjectAclResponse> ListObjectAcl(
+      ListObjectAclRequest const& request) override;
+  StatusOr<ObjectAccessControl> CreateObjectAcl(
+      CreateObjectAclRequest const&) override;
+  StatusOr<EmptyResponse> DeleteObjectAcl(
+      DeleteObjectAclRequest const&) override;
+  StatusOr<ObjectAccessControl> GetObjectAcl(
+      GetObjectAclRequest const&) override;
+  StatusOr<ObjectAccessControl> UpdateObjectAcl(
+      UpdateObjectAclRequest const&) override;
+  StatusOr<ObjectAccessControl> PatchObjectAcl(
+      PatchObjectAclRequest const&) override;
+
+  StatusOr<ListDefaultObjectAclResponse> ListDefaultObjectAcl(
+      ListDefaultObjectAclRequest const& request) override;
+  StatusOr<ObjectAccessControl> CreateDefaultObjectAcl(
+      CreateDefaultObjectAclRequest const&) override;
+  StatusOr<EmptyResponse> DeleteDefaultObjectAcl(
+      DeleteDefaultObjectAclRequest const&) override;
+  StatusOr<ObjectAccessControl> GetDefaultObjectAcl(
+      GetDefaultObjectAclRequest const&) override;
+  StatusOr<ObjectAccessControl> UpdateDefaultObjectAcl(
+      UpdateDefaultObjectAclRequest const&) override;
+  StatusOr<ObjectAccessControl> PatchDefaultObjectAcl(
+      PatchDefaultObjectAclRequest const&) override;
+
+  StatusOr<ServiceAccount> GetServiceAccount(
+      GetProjectServiceAccountRequest const&) override;
+  StatusOr<ListHmacKeysResponse> ListHmacKeys(
+      ListHmacKeysRequest const&) override;
+  StatusOr<CreateHmacKeyResponse> CreateHmacKey(
+      CreateHmacKeyRequest const&) override;
+  StatusOr<EmptyResponse> DeleteHmacKey(DeleteHmacKeyRequest const&) override;
+  StatusOr<HmacKeyMetadata> GetHmacKey(GetHmacKeyRequest const&) override;
+  StatusOr<HmacKeyMetadata> UpdateHmacKey(UpdateHmacKeyRequest const&) override;
+  StatusOr<SignBlobResponse> SignBlob(SignBlobRequest const&) override;
+
+  StatusOr<ListNotificationsResponse> ListNotifications(
+      ListNotificationsRequest const&) override;
+  StatusOr<NotificationMetadata> CreateNotification(
+      CreateNotificationRequest const&) override;
+  StatusOr<NotificationMetadata> GetNotification(
+      GetNotificationRequest const&) override;
+  StatusOr<EmptyResponse> DeleteNotification(
+      DeleteNotificationRequest const&) override;
+
+  StatusOr<BatchResponse> ExecuteBatch(BatchRequest const& request) override;
+
+  std::shared_ptr<RawClient> client() const { return client_; }
+  std::shared_ptr<HedgingPolicy> policy() const { return policy_; }
+
+ private:
+  // Only the idempotency policy is used, the other policies are accepted so
+  // this class can be created with the same arguments as `RetryClient`.
+  void Apply(RetryPolicy const&) {}
+  void Apply(BackoffPolicy const&) {}
+  void Apply(IdempotencyPolicy const& policy) {
+    idempotency_policy_ = policy.clone();
+  }
+
+  void ApplyPolicies() {}
+
+  template <typename P, typename... Policies>
+  void ApplyPolicies(P&& head, Policies&&... policies) {
+    Apply(std::forward<P>(head));
+    ApplyPolicies(std::forward<Policies>(policies)...);
+  }
+
+  std::shared_ptr<RawClient> client_;
+  std::shared_ptr<HedgingPolicy> policy_;
+  std::shared_ptr<IdempotencyPolicy const> idempotency_policy_;
+  std::unique_ptr<HedgingThreadPool> threads_;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_HEDGING_CLIENT_H
@@ -0,0 +1,372 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/hedging_client.h"
+#include "google/cloud/storage/oauth2/google_credentials.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include "absl/memory/memory.h"
+#include <gmock/gmock.h>
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::TransientError;
+using ::std::chrono::milliseconds;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+ObjectMetadata MakeMetadata(std::string const& name) {
+  return ObjectMetadataParser::FromString(
+             R"""({"bucket": "test-bucket", "name": ")""" + name + R"""("})""")
+      .value();
+}
+
+class HedgingClientTest : public ::testing::Test {
+ protected:
+  HedgingClientTest()
+      : options_(oauth2::CreateAnonymousCredentials()),
+        mock_(std::make_shared<testing::MockClient>()) {
+    options_.SetDownloadBufferSize(1024);
+    EXPECT_CALL(*mock_, client_options()).WillRepeatedly(ReturnRef(options_));
+  }
+
+  std::shared_ptr<HedgingClient> MakeClient(milliseconds initial_delay) {
+    policy_ = std::make_shared<HedgingPolicy>(0.95, 0.05, initial_delay);
+    return std::make_shared<HedgingClient>(mock_, policy_,
+                                           LimitedErrorCountRetryPolicy(3),
+                                           StrictIdempotencyPolicy());
+  }
+
+  /// Verify the client waits for its background threads when destroyed.
+  void WaitForBackgroundThreads(std::shared_ptr<HedgingClient> client) {
+    client.reset();
+    EXPECT_EQ(1, mock_.use_count());
+  }
+
+  /**
+   * Returns an action where the first call blocks until `release_` is
+   * satisfied and returns @p slow, and the following calls return @p fast.
+   */
+  template <typename T>
+  std::function<T()> SlowThenFast(std::function<T()> slow,
+                                  std::function<T()> fast) {
+    auto count = std::make_shared<std::atomic<int>>(0);
+    auto released = release_.get_future().share();
+    return [count, released, slow, fast] {
+      if (count->fetch_add(1) != 0) return fast();
+      released.wait();
+      return slow();
+    };
+  }
+
+  ClientOptions options_;
+  std::shared_ptr<testing::MockClient> mock_;
+  std::shared_ptr<HedgingPolicy> policy_;
+  std::promise<void> release_;
+};
+
+TEST_F(HedgingClientTest, FastCallIsNotHedged) {
+  auto client = MakeClient(milliseconds(1000));
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .WillOnce(Return(make_status_or(MakeMetadata("test-object"))));
+
+  auto actual = client->GetObjectMetadata(
+      GetObjectMetadataRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ("test-object", actual->name());
+  auto const counters = policy_->Counters();
+  EXPECT_EQ(1, counters.calls);
+  EXPECT_EQ(0, counters.hedges);
+  WaitForBackgroundThreads(std::move(client));
+}
+
+TEST_F(HedgingClientTest, SlowCallIsHedged) {
+  auto client = MakeClient(milliseconds(10));
+  auto action = SlowThenFast<StatusOr<ObjectMetadata>>(
+      [] { return make_status_or(MakeMetadata("slow")); },
+      [] { return make_status_or(MakeMetadata("fast")); });
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .Times(2)
+      .WillRepeatedly(Invoke(
+          [action](GetObjectMetadataRequest const&) { return action(); }));
+
+  auto actual = client->GetObjectMetadata(
+      GetObjectMetadataRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ("fast", actual->name());
+  EXPECT_EQ(1, policy_->Counters().hedges);
+
+  release_.set_value();
+  WaitForBackgroundThreads(std::move(client));
+}
+
+TEST_F(HedgingClientTest, FastErrorIsNotHedged) {
+  auto client = MakeClient(milliseconds(1000));
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .WillOnce(Return(StatusOr<ObjectMetadata>(TransientError())));
+
+  auto actual = client->GetObjectMetadata(
+      GetObjectMetadataRequest("test-bucket", "test-object"));
+  EXPECT_EQ(TransientError().code(), actual.status().code());
+  EXPECT_EQ(0, policy_->Counters().hedges);
+  WaitForBackgroundThreads(std::move(client));
+}
+
+TEST_F(HedgingClientTest, SlowErrorUsesHedge) {
+  auto client = MakeClient(milliseconds(10));
+  // The hedge releases the original request, which fails before the hedge
+  // completes. The error must not be used.
+  auto* release = &release_;
+  auto action = SlowThenFast<StatusOr<ObjectMetadata>>(
+      [] { return StatusOr<ObjectMetadata>(TransientError()); },
+      [release] {
+        release->set_value();
+        std::this_thread::sleep_for(milliseconds(20));
+        return make_status_or(MakeMetadata("fast"));
+      });
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .Times(2)
+      .WillRepeatedly(Invoke(
+          [action](GetObjectMetadataRequest const&) { return action(); }));
+
+  auto actual = client->GetObjectMetadata(
+      GetObjectMetadataRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ("fast", actual->name());
+  WaitForBackgroundThreads(std::move(client));
+}
+
+TEST_F(HedgingClientTest, BudgetLimitsHedges) {
+  auto client = MakeClient(milliseconds(1));
+  while (policy_->AcquireHedge()) continue;
+  // Without budget the call runs in the calling thread.
+  auto const caller = std::this_thread::get_id();
+  EXPECT_CALL(*mock_, GetObjectMetadata)
+      .WillOnce(Invoke([caller](GetObjectMetadataRequest const&) {
+        EXPECT_EQ(caller, std::this_thread::get_id());
+        std::this_thread::sleep_for(milliseconds(20));
+        return make_status_or(MakeMetadata("slow"));
+      }));
+
+  auto actual = client->GetObjectMetadata(
+      GetObjectMetadataRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ("slow", actual->name());
+  auto const counters = policy_->Counters();
+  EXPECT_EQ(10, counters.hedges);
+  EXPECT_EQ(1, counters.budget_exhausted);
+  WaitForBackgroundThreads(std::move(client));
+}
+
+/// Returns a source that returns @p contents in its first read.
+std::unique_ptr<ObjectReadSource> MakeSource(
+    std::string const& contents, std::function<void()> on_close = [] {}) {
+  auto source = absl::make_unique<testing::MockObjectReadSource>();
+  EXPECT_CALL(*source, CanReadBorrowed).WillRepeatedly(Return(false));
+  EXPECT_CALL(*source, Read)
+      .WillOnce(Invoke([contents](char* buf, std::size_t n) {
+        EXPECT_LE(contents.size(), n);
+        std::copy(contents.begin(), contents.end(), buf);
+        return make_status_or(ReadSourceResult{
+            contents.size(),
+            HttpResponse{HttpStatusCode::kOk,
+                         {},
+                         {{"x-goog-generation", "1"}}}});
+      }));
+  EXPECT_CALL(*source, IsOpen).WillRepeatedly(Return(false));
+  EXPECT_CALL(*source, Close).WillRepeatedly(Invoke([on_close] {
+    on_close();
+    return make_status_or(HttpResponse{HttpStatusCode::kOk, {}, {}});
+  }));
+  return std::unique_ptr<ObjectReadSource>(std::move(source));
+}
+
+TEST_F(HedgingClientTest, ReadObjectPieces) {
+  auto client = MakeClient(milliseconds(1000));
+  EXPECT_CALL(*mock_, ReadObject)
+      .WillOnce(Invoke([](ReadObjectRangeRequest const&) {
+        return make_status_or(MakeSource("0123456789"));
+      }));
+
+  auto source =
+      client->ReadObject(ReadObjectRangeRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(source);
+  char buffer[4];
+  auto r = (*source)->Read(buffer, sizeof(buffer));
+  ASSERT_STATUS_OK(r);
+  EXPECT_EQ("0123", std::string(buffer, r->bytes_received));
+  EXPECT_EQ(HttpStatusCode::kContinue, r->response.status_code);
+  EXPECT_EQ(1, r->response.headers.count("x-goog-generation"));
+
+  r = (*source)->Read(buffer, sizeof(buffer));
+  ASSERT_STATUS_OK(r);
+  EXPECT_EQ("4567", std::string(buffer, r->bytes_received));
+  EXPECT_EQ(HttpStatusCode::kContinue, r->response.status_code);
+  EXPECT_TRUE(r->response.headers.empty());
+
+  r = (*source)->Read(buffer, sizeof(buffer));
+  ASSERT_STATUS_OK(r);
+  EXPECT_EQ("89", std::string(buffer, r->bytes_received));
+  EXPECT_EQ(HttpStatusCode::kOk, r->response.status_code);
+  EXPECT_FALSE((*source)->IsOpen());
+  source->reset();
+  WaitForBackgroundThreads(std::move(client));
+}
+
+TEST_F(HedgingClientTest, ReadObjectHedged) {
+  auto client = MakeClient(milliseconds(10));
+  std::promise<void> closed;
+  auto action = SlowThenFast<StatusOr<std::unique_ptr<ObjectReadSource>>>(
+      [&closed] {
+        return make_status_or(
+            MakeSource("slow", [&closed] { closed.set_value(); }));
+      },
+      [] { return make_status_or(MakeSource("fast")); });
+  EXPECT_CALL(*mock_, ReadObject)
+      .Times(2)
+      .WillRepeatedly(Invoke(
+          [action](ReadObjectRangeRequest const&) { return action(); }));
+
+  auto source =
+      client->ReadObject(ReadObjectRangeRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(source);
+  char buffer[16];
+  auto r = (*source)->Read(buffer, sizeof(buffer));
+  ASSERT_STATUS_OK(r);
+  EXPECT_EQ("fast", std::string(buffer, r->bytes_received));
+  EXPECT_EQ(HttpStatusCode::kOk, r->response.status_code);
+  source->reset();
+
+  // The losing request is closed once it completes.
+  release_.set_value();
+  EXPECT_EQ(std::future_status::ready,
+            closed.get_future().wait_for(std::chrono::seconds(10)));
+  WaitForBackgroundThreads(std::move(client));
+}
+
+TEST_F(HedgingClientTest, ReadObjectBorrowed) {
+  auto client = MakeClient(milliseconds(1000));
+  std::string const contents = "0123456789";
+  EXPECT_CALL(*mock_, ReadObject)
+      .WillOnce(Invoke([&contents](ReadObjectRangeRequest const&) {
+        auto source = absl::make_unique<testing::MockObjectReadSource>();
+        EXPECT_CALL(*source, CanReadBorrowed).WillRepeatedly(Return(true));
+        EXPECT_CALL(*source, Read).Times(0);
+        EXPECT_CALL(*source, ReadBorrowed)
+            .WillOnce(Return(BorrowedReadSourceResult{
+                ConstBuffer(contents.data(), contents.size()),
+                HttpResponse{HttpStatusCode::kOk, {}, {}}}));
+        EXPECT_CALL(*source, IsOpen).WillRepeatedly(Return(false));
+        return make_status_or(
+            std::unique_ptr<ObjectReadSource>(std::move(source)));
+      }));
+
+  auto source =
+      client->ReadObject(ReadObjectRangeRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(source);
+  // The prefetched data is lent by the child source, without a copy.
+  ASSERT_TRUE((*source)->CanReadBorrowed());
+  auto r = (*source)->ReadBorrowed();
+  ASSERT_STATUS_OK(r);
+  EXPECT_EQ(contents.data(), r->data.data());
+  EXPECT_EQ(contents.size(), r->data.size());
+  EXPECT_EQ(HttpStatusCode::kOk, r->response.status_code);
+  EXPECT_FALSE((*source)->IsOpen());
+  source->reset();
+  WaitForBackgroundThreads(std::move(client));
+}
+
+TEST_F(HedgingClientTest, ReadObjectErrorInFirstRead) {
+  auto client = MakeClient(milliseconds(1000));
+  bool closed = false;
+  EXPECT_CALL(*mock_, ReadObject)
+      .WillOnce(Invoke([&closed](ReadObjectRangeRequest const&) {
+        auto source = absl::make_unique<testing::MockObjectReadSource>();
+        EXPECT_CALL(*source, CanReadBorrowed).WillRepeatedly(Return(false));
+        EXPECT_CALL(*source, Read).WillOnce(Return(ReadSourceResult{
+            0, HttpResponse{HttpStatusCode::kNotFound, "not found", {}}}));
+        EXPECT_CALL(*source, Close).WillOnce(Invoke([&closed] {
+          closed = true;
+          return make_status_or(HttpResponse{HttpStatusCode::kOk, {}, {}});
+        }));
+        return make_status_or(
+            std::unique_ptr<ObjectReadSource>(std::move(source)));
+      }));
+
+  auto source =
+      client->ReadObject(ReadObjectRangeRequest("test-bucket", "test-object"));
+  EXPECT_EQ(StatusCode::kNotFound, source.status().code());
+  EXPECT_TRUE(closed);
+  WaitForBackgroundThreads(std::move(client));
+}
+
+TEST(HedgingThreadPoolTest, Saturated) {
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  std::atomic<int> count(0);
+  {
+    HedgingThreadPool threads(1);
+    EXPECT_TRUE(threads.TrySchedule([released, &count] {
+      released.wait();
+      ++count;
+    }));
+    bool admitted = false;
+    EXPECT_FALSE(threads.TrySchedule([&count] { ++count; },
+                                     [&admitted] { return admitted = true; }));
+    EXPECT_FALSE(admitted);
+    release.set_value();
+  }
+  EXPECT_EQ(1, count.load());
+}
+
+TEST(HedgingThreadPoolTest, ReusesThreads) {
+  std::atomic<int> count(0);
+  {
+    HedgingThreadPool threads(1);
+    for (int i = 0; i != 10; ++i) {
+      // Wait until the thread is idle again.
+      while (!threads.TrySchedule([&count] { ++count; })) {
+        std::this_thread::sleep_for(milliseconds(1));
+      }
+    }
+  }
+  EXPECT_EQ(10, count.load());
+}
+
+TEST(HedgingThreadPoolTest, AdmitRejects) {
+  int count = 0;
+  {
+    HedgingThreadPool threads(1);
+    EXPECT_FALSE(
+        threads.TrySchedule([&count] { ++count; }, [] { return false; }));
+  }
+  EXPECT_EQ(0, count);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
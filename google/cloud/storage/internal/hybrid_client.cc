@@ -13,39 +13,156 @@
 // limitations under the License.
 
 #include "google/cloud/storage/internal/hybrid_client.h"
+#include "absl/memory/memory.h"
+#include <chrono>
 
 namespace google {
 namespace cloud {
 namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace internal {
+namespace {
+using Clock = std::chrono::steady_clock;
+
+std::chrono::microseconds ElapsedSince(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                               start);
+}
+
+/**
+ * Reports the throughput of a download to the routing policy.
+ *
+ * The download is reported once, when the source returns its final response,
+ * an error, or when the application closes or discards the stream. Only the
+ * time spent in the source is reported, the time the application takes to
+ * consume the data says nothing about the transport.
+ */
+class RoutedObjectReadSource : public ObjectReadSource {
+ public:
+  RoutedObjectReadSource(std::unique_ptr<ObjectReadSource> child,
+                         std::shared_ptr<TransportRoutingPolicy> policy,
+                         Transport transport, std::chrono::microseconds elapsed)
+      : child_(std::move(child)),
+        policy_(std::move(policy)),
+        transport_(transport),
+        elapsed_(elapsed) {}
+  ~RoutedObjectReadSource() override { Report(StatusCode::kOk); }
+
+  bool IsOpen() const override { return child_->IsOpen(); }
+  StatusOr<HttpResponse> Close() override {
+    auto const start = Clock::now();
+    auto response = child_->Close();
+    elapsed_ += ElapsedSince(start);
+    Report(response ? StatusCode::kOk : response.status().code());
+    return response;
+  }
+  StatusOr<ReadSourceResult> Read(char* buf, std::size_t n) override {
+    auto const start = Clock::now();
+    auto result = child_->Read(buf, n);
+    elapsed_ += ElapsedSince(start);
+    if (!result) {
+      Report(result.status().code());
+      return result;
+    }
+    bytes_ += result->bytes_received;
+    OnResponse(result->response);
+    return result;
+  }
+  bool CanReadBorrowed() const override { return child_->CanReadBorrowed(); }
+  StatusOr<BorrowedReadSourceResult> ReadBorrowed() override {
+    auto const start = Clock::now();
+    auto result = child_->ReadBorrowed();
+    elapsed_ += ElapsedSince(start);
+    if (!result) {
+      Report(result.status().code());
+      return result;
+    }
+    bytes_ += result->data.size();
+    OnResponse(result->response);
+    return result;
+  }
+
+ private:
+  void OnResponse(HttpResponse const& response) {
+    if (response.status_code == HttpStatusCode::kContinue) return;
+    Report(AsStatus(response).code());
+  }
+
+  void Report(StatusCode code) {
+    if (reported_) return;
+    reported_ = true;
+    policy_->OnCompletion("ReadObject",
+                          TransportSample{transport_, elapsed_, bytes_, code});
+  }
+
+  std::unique_ptr<ObjectReadSource> child_;
+  std::shared_ptr<TransportRoutingPolicy> policy_;
+  Transport transport_;
+  std::chrono::microseconds elapsed_;
+  std::uint64_t bytes_ = 0;
+  bool reported_ = false;
+};
+}  // namespace
 
 HybridClient::HybridClient(ClientOptions options)
     : grpc_(std::make_shared<GrpcClient>(options)),
-      curl_(CurlClient::Create(std::move(options))) {}
+      curl_(CurlClient::Create(options)),
+      policy_(options.transport_routing_policy()) {
+  if (!policy_) policy_ = std::make_shared<StaticTransportRoutingPolicy>();
+}
+
+template <typename Function>
+auto HybridClient::Route(char const* operation, std::uint64_t bytes,
+                         Function const& function)
+    -> decltype(function(std::declval<RawClient&>())) {
+  auto const transport = policy_->Pick(operation);
+  auto const start = Clock::now();
+  auto result = function(ClientFor(transport));
+  policy_->OnCompletion(
+      operation, TransportSample{transport, ElapsedSince(start), bytes,
+                                 result.status().code()});
+  return result;
+}
+
+RawClient& HybridClient::ClientFor(Transport transport) {
+  if (transport == Transport::kGrpc) return *grpc_;
+  return *curl_;
+}
 
 ClientOptions const& HybridClient::client_options() const {
   return curl_->client_options();
 }
 
+ConnectionPoolStats HybridClient::connection_pool_stats() const {
+  return curl_->connection_pool_stats();
+}
+
 StatusOr<ListBucketsResponse> HybridClient::ListBuckets(
     ListBucketsRequest const& request) {
-  return curl_->ListBuckets(request);
+  return Route(__func__, 0, [&request](RawClient& client) {
+    return client.ListBuckets(request);
+  });
 }
 
 StatusOr<BucketMetadata> HybridClient::CreateBucket(
     CreateBucketRequest const& request) {
-  return curl_->CreateBucket(request);
+  return Route(__func__, 0, [&request](RawClient& client) {
+    return client.CreateBucket(request);
+  });
 }
 
 StatusOr<BucketMetadata> HybridClient::GetBucketMetadata(
     GetBucketMetadataRequest const& request) {
-  return curl_->GetBucketMetadata(request);
+  return Route(__func__, 0, [&request](RawClient& client) {
+    return client.GetBucketMetadata(request);
+  });
 }
 
 StatusOr<EmptyResponse> HybridClient::DeleteBucket(
     DeleteBucketRequest const& request) {
-  return curl_->DeleteBucket(request);
+  return Route(__func__, 0, [&request](RawClient& client) {
+    return client.DeleteBucket(request);
+  });
 }
 
 StatusOr<BucketMetadata> HybridClient::UpdateBucket(
@@ -91,7 +208,10 @@ StatusOr<BucketMetadata> HybridClient::LockBucketRetentionPolicy(
 
 StatusOr<ObjectMetadata> HybridClient::InsertObjectMedia(
     InsertObjectMediaRequest const& request) {
-  return grpc_->InsertObjectMedia(request);
+  return Route(__func__, request.contents().size(),
+               [&request](RawClient& client) {
+                 return client.InsertObjectMedia(request);
+               });
 }
 
 StatusOr<ObjectMetadata> HybridClient::CopyObject(
@@ -106,7 +226,18 @@ StatusOr<ObjectMetadata> HybridClient::GetObjectMetadata(
 
 StatusOr<std::unique_ptr<ObjectReadSource>> HybridClient::ReadObject(
     ReadObjectRangeRequest const& request) {
-  return grpc_->ReadObject(request);
+  auto const transport = policy_->Pick(__func__);
+  auto const start = Clock::now();
+  auto source = ClientFor(transport).ReadObject(request);
+  auto const elapsed = ElapsedSince(start);
+  if (!source) {
+    policy_->OnCompletion(__func__, TransportSample{transport, elapsed, 0,
+                                                    source.status().code()});
+    return source;
+  }
+  return std::unique_ptr<ObjectReadSource>(
+      absl::make_unique<RoutedObjectReadSource>(*std::move(source), policy_,
+                                                transport, elapsed));
 }
 
 StatusOr<ListObjectsResponse> HybridClient::ListObjects(
@@ -116,7 +247,9 @@ StatusOr<ListObjectsResponse> HybridClient::ListObjects(
 
 StatusOr<EmptyResponse> HybridClient::DeleteObject(
     DeleteObjectRequest const& request) {
-  return curl_->DeleteObject(request);
+  return Route(__func__, 0, [&request](RawClient& client) {
+    return client.DeleteObject(request);
+  });
 }
 
 StatusOr<ObjectMetadata> HybridClient::UpdateObject(
@@ -141,11 +274,18 @@ StatusOr<RewriteObjectResponse> HybridClient::RewriteObject(
 
 StatusOr<std::unique_ptr<ResumableUploadSession>>
 HybridClient::CreateResumableSession(ResumableUploadRequest const& request) {
-  return grpc_->CreateResumableSession(request);
+  return Route(__func__, 0, [&request](RawClient& client) {
+    return client.CreateResumableSession(request);
+  });
 }
 
 StatusOr<std::unique_ptr<ResumableUploadSession>>
 HybridClient::RestoreResumableSession(std::string const& upload_id) {
+  // The sessions must be restored using the transport that created them. The
+  // REST upload ids are URLs, the gRPC upload ids are opaque strings.
+  if (upload_id.rfind("http", 0) == 0) {
+    return curl_->RestoreResumableSession(upload_id);
+  }
   return grpc_->RestoreResumableSession(upload_id);
 }
 
@@ -294,6 +434,11 @@ StatusOr<EmptyResponse> HybridClient::DeleteNotification(
   return curl_->DeleteNotification(request);
 }
 
+StatusOr<BatchResponse> HybridClient::ExecuteBatch(
+    BatchRequest const& request) {
+  return curl_->ExecuteBatch(request);
+}
+
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
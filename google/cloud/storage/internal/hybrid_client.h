@@ -18,6 +18,11 @@
 #include "google/cloud/storage/internal/curl_client.h"
 #include "google/cloud/storage/internal/grpc_client.h"
 #include "google/cloud/storage/internal/raw_client.h"
+#include "google/cloud/storage/transport_routing_policy.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
 
 namespace google {
 namespace cloud {
@@ -25,12 +30,21 @@ namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace internal {
 
+/**
+ * A `RawClient` that uses both the REST and gRPC transports.
+ *
+ * The operations implemented by both transports are routed by the
+ * `TransportRoutingPolicy` in `ClientOptions::transport_routing_policy()`, or
+ * by a `StaticTransportRoutingPolicy` if none is configured. All other
+ * operations use REST.
+ */
 class HybridClient : public RawClient {
  public:
   explicit HybridClient(ClientOptions options);
   ~HybridClient() override = default;
 
   ClientOptions const& client_options() const override;
+  ConnectionPoolStats connection_pool_stats() const override;
 
   StatusOr<ListBucketsResponse> ListBuckets(
       ListBucketsRequest const& request) override;
@@ -140,9 +154,20 @@ class HybridClient : public RawClient {
   StatusOr<EmptyResponse> DeleteNotification(
       DeleteNotificationRequest const&) override;
 
+  StatusOr<BatchResponse> ExecuteBatch(BatchRequest const& request) override;
+
  private:
+  /// Calls @p function with the client for the transport picked by the policy.
+  template <typename Function>
+  auto Route(char const* operation, std::uint64_t bytes,
+             Function const& function)
+      -> decltype(function(std::declval<RawClient&>()));
+
+  RawClient& ClientFor(Transport transport);
+
   std::shared_ptr<GrpcClient> grpc_;
   std::shared_ptr<CurlClient> curl_;
+  std::shared_ptr<TransportRoutingPolicy> policy_;
 };
 
 }  // namespace internal
@@ -84,6 +84,14 @@ ClientOptions const& LoggingClient::client_options() const {
   return client_->client_options();
 }
 
+std::size_t LoggingClient::upload_buffer_size() const {
+  return client_->upload_buffer_size();
+}
+
+ConnectionPoolStats LoggingClient::connection_pool_stats() const {
+  return client_->connection_pool_stats();
+}
+
 StatusOr<ListBucketsResponse> LoggingClient::ListBuckets(
     ListBucketsRequest const& request) {
   return MakeCall(*client_, &RawClient::ListBuckets, request, __func__);
@@ -369,6 +377,11 @@ StatusOr<EmptyResponse> LoggingClient::DeleteNotification(
   return MakeCall(*client_, &RawClient::DeleteNotification, request, __func__);
 }
 
+StatusOr<BatchResponse> LoggingClient::ExecuteBatch(
+    BatchRequest const& request) {
+  return MakeCall(*client_, &RawClient::ExecuteBatch, request, __func__);
+}
+
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
@@ -32,6 +32,8 @@ class LoggingClient : public RawClient {
   ~LoggingClient() override = default;
 
   ClientOptions const& client_options() const override;
+  std::size_t upload_buffer_size() const override;
+  ConnectionPoolStats connection_pool_stats() const override;
 
   StatusOr<ListBucketsResponse> ListBuckets(
       ListBucketsRequest const& request) override;
@@ -139,6 +141,8 @@ class LoggingClient : public RawClient {
   StatusOr<EmptyResponse> DeleteNotification(
       DeleteNotificationRequest const&) override;
 
+  StatusOr<BatchResponse> ExecuteBatch(BatchRequest const& request) override;
+
   std::shared_ptr<RawClient> client() const { return client_; }
 
  private:
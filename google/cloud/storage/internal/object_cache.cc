@@ -0,0 +1,375 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/object_cache.h"
+#include "google/cloud/storage/internal/hash_validator_impl.h"
+#include "google/cloud/storage/internal/sha256_hash.h"
+#include "google/cloud/log.h"
+#include <crc32c/crc32c.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <fcntl.h>
+#include <sys/types.h>
+// The order of these two includes cannot be changed.
+#include <sys/stat.h>
+#if _WIN32
+#include <direct.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+Status ErrnoStatus(char const* what, std::string const& path) {
+  auto const error = errno;
+  auto const code =
+      error == ENOENT ? StatusCode::kNotFound : StatusCode::kUnknown;
+  return Status(code, std::string(what) + "(" + path +
+                          ") failed: " + std::strerror(error));
+}
+
+/// Returns true if @p object does not match the CRC32C checksum @p crc32c.
+bool IsCorrupted(CachedObject const& object, std::string const& crc32c) {
+  auto expected = DecodeCrc32cChecksum(crc32c);
+  // An invalid checksum says nothing about the contents.
+  if (!expected) return false;
+  auto const actual = crc32c::Crc32c(
+      reinterpret_cast<std::uint8_t const*>(object.data()), object.size());
+  return actual != *expected;
+}
+
+// Temporary files older than this are left over by a process that crashed
+// while inserting an entry, newer files may still be in use.
+auto constexpr kStaleTemporaryAgeSeconds = 3600;
+
+// The entry names are the hex-encoded SHA256 hash of the key.
+auto constexpr kEntryNameLength = 64;
+
+bool IsEntryName(std::string const& name) {
+  return name.size() == kEntryNameLength &&
+         std::all_of(name.begin(), name.end(), [](char c) {
+           return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+         });
+}
+
+bool IsTemporaryName(std::string const& name) {
+  return name.size() > kEntryNameLength &&
+         name.compare(kEntryNameLength, 5, ".tmp-") == 0 &&
+         IsEntryName(name.substr(0, kEntryNameLength));
+}
+
+struct DirectoryEntry {
+  std::string name;
+  std::uint64_t size;
+  // The modification time, in seconds since the Unix epoch.
+  std::int64_t mtime;
+};
+
+/// Returns the regular files in @p directory, errors are logged and ignored.
+std::vector<DirectoryEntry> ListDirectory(std::string const& directory) {
+  std::vector<DirectoryEntry> entries;
+#if _WIN32
+  WIN32_FIND_DATAA data;
+  auto handle = ::FindFirstFileA((directory + "\\*").c_str(), &data);
+  if (handle == INVALID_HANDLE_VALUE) {
+    GCP_LOG(WARNING) << "cannot list the object cache directory " << directory
+                     << ": error code " << ::GetLastError();
+    return entries;
+  }
+  do {
+    if (data.dwFileAttributes &
+        (FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_REPARSE_POINT)) {
+      continue;
+    }
+    auto const size = (static_cast<std::uint64_t>(data.nFileSizeHigh) << 32U) |
+                      data.nFileSizeLow;
+    // FILETIME counts 100ns intervals since 1601-01-01.
+    auto const ticks =
+        (static_cast<std::uint64_t>(data.ftLastWriteTime.dwHighDateTime)
+         << 32U) |
+        data.ftLastWriteTime.dwLowDateTime;
+    auto const mtime =
+        static_cast<std::int64_t>(ticks / 10000000) - 11644473600LL;
+    entries.push_back(DirectoryEntry{data.cFileName, size, mtime});
+  } while (::FindNextFileA(handle, &data));
+  ::FindClose(handle);
+#else
+  auto* dir = ::opendir(directory.c_str());
+  if (dir == nullptr) {
+    GCP_LOG(WARNING) << "cannot list the object cache directory " << directory
+                     << ": " << std::strerror(errno);
+    return entries;
+  }
+  for (auto* entry = ::readdir(dir); entry != nullptr; entry = ::readdir(dir)) {
+    std::string name = entry->d_name;
+    struct stat s {};
+    // Use lstat() to not follow symbolic links, ignore files removed by other
+    // processes while listing the directory.
+    if (::lstat((directory + "/" + name).c_str(), &s) != 0) continue;
+    if (!S_ISREG(s.st_mode)) continue;
+    entries.push_back(DirectoryEntry{std::move(name),
+                                     static_cast<std::uint64_t>(s.st_size),
+                                     static_cast<std::int64_t>(s.st_mtime)});
+  }
+  ::closedir(dir);
+#endif  // _WIN32
+  return entries;
+}
+}  // namespace
+
+StatusOr<std::shared_ptr<CachedObject>> CachedObject::Open(
+    std::string const& path) {
+  std::shared_ptr<CachedObject> object(new CachedObject);
+#if _WIN32
+  std::ifstream is(path, std::ios::binary);
+  if (!is.is_open()) return ErrnoStatus("open", path);
+  object->contents_.assign(std::istreambuf_iterator<char>(is), {});
+  if (is.bad()) return ErrnoStatus("read", path);
+  object->data_ = object->contents_.data();
+  object->size_ = object->contents_.size();
+#else
+  auto fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) return ErrnoStatus("open", path);
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    auto status = ErrnoStatus("fstat", path);
+    ::close(fd);
+    return status;
+  }
+  object->size_ = static_cast<std::size_t>(st.st_size);
+  if (object->size_ == 0) {
+    ::close(fd);
+    object->data_ = object->contents_.data();
+    return object;
+  }
+  // The mapping remains valid after the file is closed, or even removed.
+  auto* p = ::mmap(nullptr, object->size_, PROT_READ, MAP_SHARED, fd, 0);
+  auto status = p == MAP_FAILED ? ErrnoStatus("mmap", path) : Status();
+  ::close(fd);
+  if (!status.ok()) return status;
+  object->data_ = static_cast<char const*>(p);
+  object->mapped_ = true;
+#endif  // _WIN32
+  return object;
+}
+
+std::shared_ptr<CachedObject> CachedObject::FromString(std::string contents) {
+  std::shared_ptr<CachedObject> object(new CachedObject);
+  object->contents_ = std::move(contents);
+  object->data_ = object->contents_.data();
+  object->size_ = object->contents_.size();
+  return object;
+}
+
+CachedObject::~CachedObject() {
+#if !_WIN32
+  if (mapped_) ::munmap(const_cast<char*>(data_), size_);
+#endif  // !_WIN32
+}
+
+ObjectCache::ObjectCache(std::string directory, std::uint64_t capacity)
+    : directory_(std::move(directory)),
+      capacity_(capacity),
+      generator_(google::cloud::internal::MakeDefaultPRNG()) {
+  // Only the last component is created, the application owns the rest of the
+  // path. Without the directory no object can be stored, the contents are
+  // served from memory.
+#if _WIN32
+  auto const result = ::_mkdir(directory_.c_str());
+#else
+  auto const result = ::mkdir(directory_.c_str(), 0700);
+#endif  // _WIN32
+  auto const error = errno;
+  if (result != 0 && error != EEXIST) {
+    GCP_LOG(WARNING) << "cannot create the object cache directory "
+                     << directory_ << ": " << std::strerror(error)
+                     << ", objects will not be cached";
+    return;
+  }
+  AdoptExistingFiles();
+}
+
+void ObjectCache::AdoptExistingFiles() {
+  auto files = ListDirectory(directory_);
+  // Add the oldest files first, so the newest are the most recently used.
+  std::sort(files.begin(), files.end(),
+            [](DirectoryEntry const& a, DirectoryEntry const& b) {
+              return a.mtime < b.mtime;
+            });
+  auto const now = static_cast<std::int64_t>(std::time(nullptr));
+  std::lock_guard<std::mutex> lk(mu_);
+  for (auto const& f : files) {
+    auto const path = directory_ + "/" + f.name;
+    if (IsEntryName(f.name)) {
+      // The contents are verified on the first lookup with a checksum.
+      AddEntryLocked(path, f.size, /*verified=*/false);
+    } else if (IsTemporaryName(f.name) &&
+               now - f.mtime > kStaleTemporaryAgeSeconds) {
+      std::remove(path.c_str());
+    }
+  }
+  EvictIfNeededLocked(std::string{});
+}
+
+std::shared_ptr<CachedObject> ObjectCache::Lookup(ObjectCacheKey const& key,
+                                                  std::string const& crc32c) {
+  return LookupImpl(key, &crc32c);
+}
+
+std::shared_ptr<CachedObject> ObjectCache::LookupVerified(
+    ObjectCacheKey const& key) {
+  return LookupImpl(key, nullptr);
+}
+
+std::shared_ptr<CachedObject> ObjectCache::LookupImpl(
+    ObjectCacheKey const& key, std::string const* crc32c) {
+  auto const path = FileName(key);
+  bool verified = false;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto l = entries_.find(path);
+    verified = l != entries_.end() && l->second.verified;
+    // The caller falls back to `Lookup()`, which counts the miss.
+    if (crc32c == nullptr && !verified) return nullptr;
+  }
+  auto object = CachedObject::Open(path);
+  // Computing the checksum reads the whole file, do it only once per entry.
+  auto const verify =
+      object && !verified && crc32c != nullptr && !crc32c->empty();
+  if (verify && IsCorrupted(**object, *crc32c)) {
+    GCP_LOG(WARNING) << "removing corrupted object cache entry " << path;
+    std::remove(path.c_str());
+    object = Status(StatusCode::kDataLoss, "corrupted cache entry " + path);
+  }
+  std::lock_guard<std::mutex> lk(mu_);
+  auto l = entries_.find(path);
+  if (!object) {
+    // The file may have been removed by another process sharing the cache, or
+    // because it was corrupted.
+    if (l != entries_.end()) {
+      stats_.bytes -= l->second.size;
+      lru_.erase(l->second.lru);
+      entries_.erase(l);
+    }
+    ++stats_.misses;
+    return nullptr;
+  }
+  ++stats_.hits;
+  if (l == entries_.end()) {
+    // Created by another process, or by a previous run.
+    AddEntryLocked(path, (*object)->size(), verify);
+    EvictIfNeededLocked(path);
+  } else {
+    lru_.splice(lru_.begin(), lru_, l->second.lru);
+    l->second.verified = l->second.verified || verify;
+  }
+  return *std::move(object);
+}
+
+StatusOr<std::shared_ptr<CachedObject>> ObjectCache::Insert(
+    ObjectCacheKey const& key, std::string const& contents) {
+  if (contents.size() > capacity_) {
+    return Status(StatusCode::kOutOfRange,
+                  "object is larger than the cache capacity");
+  }
+  auto const path = FileName(key);
+  std::string temporary;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    temporary = path + ".tmp-" +
+                google::cloud::internal::Sample(generator_, 16,
+                                                "abcdefghijklmnopqrstuvwxyz");
+  }
+  {
+    std::ofstream os(temporary, std::ios::binary | std::ios::trunc);
+    os.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    os.close();
+    if (!os) {
+      std::remove(temporary.c_str());
+      return Status(StatusCode::kUnknown,
+                    "cannot write cache entry " + temporary);
+    }
+  }
+  // Readers in other processes see either no file or the complete file. On
+  // Windows the rename fails if the file already exists, in that case another
+  // process has already stored the same contents, and they are not verified
+  // yet.
+  auto const renamed = std::rename(temporary.c_str(), path.c_str()) == 0;
+  if (!renamed) std::remove(temporary.c_str());
+  auto object = CachedObject::Open(path);
+  if (!object) return std::move(object).status();
+
+  std::lock_guard<std::mutex> lk(mu_);
+  ++stats_.insertions;
+  auto l = entries_.find(path);
+  if (l == entries_.end()) {
+    AddEntryLocked(path, contents.size(), renamed);
+  } else {
+    lru_.splice(lru_.begin(), lru_, l->second.lru);
+    l->second.verified = l->second.verified || renamed;
+  }
+  EvictIfNeededLocked(path);
+  return object;
+}
+
+ObjectCacheStats ObjectCache::stats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return stats_;
+}
+
+std::string ObjectCache::FileName(ObjectCacheKey const& key) const {
+  auto const hash = Sha256Hash(key.bucket_name + "\n" + key.object_name +
+                               "\n" + std::to_string(key.generation));
+  return directory_ + "/" + HexEncode(hash);
+}
+
+void ObjectCache::AddEntryLocked(std::string const& path, std::uint64_t size,
+                                 bool verified) {
+  lru_.push_front(path);
+  entries_.emplace(path, Entry{size, lru_.begin(), verified});
+  stats_.bytes += size;
+}
+
+void ObjectCache::EvictIfNeededLocked(std::string const& keep) {
+  while (stats_.bytes > capacity_ && !lru_.empty() && lru_.back() != keep) {
+    auto const& victim = lru_.back();
+    auto l = entries_.find(victim);
+    stats_.bytes -= l->second.size;
+    // Ignore errors, the file may have been removed by another process. Any
+    // `CachedObject` for this file remains valid.
+    std::remove(victim.c_str());
+    entries_.erase(l);
+    lru_.pop_back();
+    ++stats_.evictions;
+  }
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,171 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_CACHE_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_CACHE_H
+
+#include "google/cloud/storage/version.h"
+#include "google/cloud/internal/random.h"
+#include "google/cloud/status_or.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+/// Identifies an object in the `ObjectCache`.
+struct ObjectCacheKey {
+  std::string bucket_name;
+  std::string object_name;
+  std::int64_t generation;
+};
+
+/**
+ * The contents of a cached object.
+ *
+ * On POSIX systems the contents of cached files are memory mapped. On Windows,
+ * and for objects that could not be stored, the contents are held in memory.
+ */
+class CachedObject {
+ public:
+  /// Maps the contents of @p path.
+  static StatusOr<std::shared_ptr<CachedObject>> Open(std::string const& path);
+  /// Holds @p contents in memory.
+  static std::shared_ptr<CachedObject> FromString(std::string contents);
+
+  ~CachedObject();
+  CachedObject(CachedObject const&) = delete;
+  CachedObject& operator=(CachedObject const&) = delete;
+
+  char const* data() const { return data_; }
+  std::size_t size() const { return size_; }
+
+ private:
+  CachedObject() = default;
+
+  char const* data_ = nullptr;
+  std::size_t size_ = 0;
+  bool mapped_ = false;
+  std::string contents_;
+};
+
+/// Statistics about an `ObjectCache`.
+struct ObjectCacheStats {
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t insertions = 0;
+  std::uint64_t evictions = 0;
+  std::uint64_t bytes = 0;
+};
+
+/**
+ * A least-recently-used cache of object contents in a local directory.
+ *
+ * Objects are immutable once a generation is created, so the entries never
+ * become stale. The caller is responsible for validating the generation (e.g.
+ * with a metadata request) before using the cache.
+ *
+ * The entries are stored as files named after a hash of the key. New entries
+ * are written to a temporary file and then renamed, so several processes can
+ * safely share a directory: each process adopts the files created by other
+ * processes on its first lookup. The constructor adopts the files already in
+ * the directory, evicting the oldest ones if they exceed `capacity`, and
+ * removes the temporary files left over by processes that crashed. Each
+ * process evicts only the entries it knows about, so the directory may still
+ * grow past `capacity` while it is shared.
+ */
+class ObjectCache {
+ public:
+  /// Creates @p directory if needed, its parent must exist.
+  ObjectCache(std::string directory, std::uint64_t capacity);
+
+  /**
+   * Returns the cached contents for @p key, or `nullptr` on a miss.
+   *
+   * Each entry is verified once: the entries stored by `Insert()` are
+   * trusted, and the first lookup of a file created by another process (or a
+   * previous run) compares its contents against @p crc32c, in the format used
+   * by the service. Corrupted files are removed and reported as a miss. If
+   * @p crc32c is empty the file is used without verification.
+   */
+  std::shared_ptr<CachedObject> Lookup(ObjectCacheKey const& key,
+                                       std::string const& crc32c = {});
+
+  /**
+   * Returns the cached contents for @p key if they have been verified, or
+   * `nullptr` otherwise.
+   *
+   * Use this function when the checksum is not known, the files that have not
+   * been verified yet are reported as a miss. These misses are not counted in
+   * `stats()`, the caller is expected to fall back to `Lookup()`.
+   */
+  std::shared_ptr<CachedObject> LookupVerified(ObjectCacheKey const& key);
+
+  /**
+   * Stores @p contents for @p key, evicting the least recently used entries
+   * if needed.
+   *
+   * Returns an error if the contents cannot be stored. Objects larger than
+   * the capacity are never stored. The caller must verify @p contents, later
+   * lookups do not verify this entry again.
+   */
+  StatusOr<std::shared_ptr<CachedObject>> Insert(ObjectCacheKey const& key,
+                                                 std::string const& contents);
+
+  ObjectCacheStats stats() const;
+
+  /// The name of the file used for @p key, exposed for testing.
+  std::string FileName(ObjectCacheKey const& key) const;
+
+ private:
+  struct Entry {
+    std::uint64_t size;
+    std::list<std::string>::iterator lru;
+    // The contents were verified against the object checksum.
+    bool verified;
+  };
+
+  /// Adds the entries found in `directory_`, called by the constructor.
+  void AdoptExistingFiles();
+  /// Implements `Lookup()` and, with a null @p crc32c, `LookupVerified()`.
+  std::shared_ptr<CachedObject> LookupImpl(ObjectCacheKey const& key,
+                                           std::string const* crc32c);
+  void AddEntryLocked(std::string const& path, std::uint64_t size,
+                      bool verified);
+  void EvictIfNeededLocked(std::string const& keep);
+
+  std::string const directory_;
+  std::uint64_t const capacity_;
+  mutable std::mutex mu_;
+  // The most recently used entries are at the front.
+  std::list<std::string> lru_;
+  std::unordered_map<std::string, Entry> entries_;
+  ObjectCacheStats stats_;
+  google::cloud::internal::DefaultPRNG generator_;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_CACHE_H
@@ -0,0 +1,271 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/object_cache.h"
+#include "google/cloud/storage/hashing_options.h"
+#include "google/cloud/storage/testing/random_names.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <random>
+#include <vector>
+#include <sys/stat.h>
+#if _WIN32
+#include <direct.h>
+#else
+#include <utime.h>
+#endif  // _WIN32
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+/// Creates a cache directory, and removes it (and its files) after each test.
+class ObjectCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto generator =
+        google::cloud::internal::DefaultPRNG(std::random_device{}());
+    directory_ = ::testing::TempDir() + testing::MakeRandomFileName(generator);
+#if _WIN32
+    ASSERT_EQ(0, ::_mkdir(directory_.c_str()));
+#else
+    ASSERT_EQ(0, ::mkdir(directory_.c_str(), 0700));
+#endif  // _WIN32
+  }
+
+  void TearDown() override {
+    for (auto const& f : files_) std::remove(f.c_str());
+    std::remove(directory_.c_str());
+  }
+
+  /// Remember @p key so its file is removed in `TearDown()`.
+  ObjectCacheKey Key(ObjectCache const& cache, std::string object,
+                     std::int64_t generation) {
+    ObjectCacheKey key{"test-bucket", std::move(object), generation};
+    files_.push_back(cache.FileName(key));
+    return key;
+  }
+
+  static std::string Contents(CachedObject const& object) {
+    return std::string(object.data(), object.size());
+  }
+
+  std::string directory_;
+  std::vector<std::string> files_;
+};
+
+TEST_F(ObjectCacheTest, InsertAndLookup) {
+  ObjectCache cache(directory_, 1024);
+  auto const key = Key(cache, "test-object", 1);
+  EXPECT_EQ(nullptr, cache.Lookup(key));
+
+  auto inserted = cache.Insert(key, "the quick brown fox");
+  ASSERT_STATUS_OK(inserted);
+  EXPECT_EQ("the quick brown fox", Contents(**inserted));
+
+  auto found = cache.Lookup(key);
+  ASSERT_NE(nullptr, found);
+  EXPECT_EQ("the quick brown fox", Contents(*found));
+
+  // Other generations are different entries.
+  EXPECT_EQ(nullptr, cache.Lookup(Key(cache, "test-object", 2)));
+
+  auto const stats = cache.stats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(2, stats.misses);
+  EXPECT_EQ(1, stats.insertions);
+  EXPECT_EQ(19, stats.bytes);
+}
+
+TEST_F(ObjectCacheTest, EmptyObject) {
+  ObjectCache cache(directory_, 1024);
+  auto const key = Key(cache, "empty", 1);
+  ASSERT_STATUS_OK(cache.Insert(key, std::string{}));
+  auto found = cache.Lookup(key);
+  ASSERT_NE(nullptr, found);
+  EXPECT_EQ(0, found->size());
+}
+
+TEST_F(ObjectCacheTest, EvictsLeastRecentlyUsed) {
+  ObjectCache cache(directory_, 30);
+  auto const a = Key(cache, "a", 1);
+  auto const b = Key(cache, "b", 1);
+  auto const c = Key(cache, "c", 1);
+  ASSERT_STATUS_OK(cache.Insert(a, std::string(10, 'a')));
+  ASSERT_STATUS_OK(cache.Insert(b, std::string(10, 'b')));
+  // Using `a` makes `b` the least recently used entry.
+  ASSERT_NE(nullptr, cache.Lookup(a));
+  // The entries returned before the eviction remain usable.
+  auto held = cache.Lookup(b);
+  ASSERT_NE(nullptr, held);
+  ASSERT_NE(nullptr, cache.Lookup(a));
+  ASSERT_STATUS_OK(cache.Insert(c, std::string(15, 'c')));
+
+  EXPECT_EQ(nullptr, cache.Lookup(b));
+  EXPECT_EQ(std::string(10, 'b'), Contents(*held));
+  EXPECT_NE(nullptr, cache.Lookup(a));
+  EXPECT_NE(nullptr, cache.Lookup(c));
+  auto const stats = cache.stats();
+  EXPECT_EQ(1, stats.evictions);
+  EXPECT_EQ(25, stats.bytes);
+}
+
+TEST_F(ObjectCacheTest, TooLarge) {
+  ObjectCache cache(directory_, 8);
+  auto const key = Key(cache, "large", 1);
+  auto inserted = cache.Insert(key, std::string(16, 'x'));
+  EXPECT_EQ(StatusCode::kOutOfRange, inserted.status().code());
+  EXPECT_EQ(nullptr, cache.Lookup(key));
+}
+
+TEST_F(ObjectCacheTest, SharedDirectory) {
+  // Simulate two processes sharing the same directory.
+  ObjectCache writer(directory_, 1024);
+  ObjectCache reader(directory_, 1024);
+  auto const key = Key(writer, "shared", 3);
+  ASSERT_STATUS_OK(writer.Insert(key, "shared contents"));
+
+  auto found = reader.Lookup(key);
+  ASSERT_NE(nullptr, found);
+  EXPECT_EQ("shared contents", Contents(*found));
+  EXPECT_EQ(15, reader.stats().bytes);
+}
+
+TEST_F(ObjectCacheTest, CorruptedEntryIsRemoved) {
+  // Simulate a file corrupted by another process sharing the directory.
+  ObjectCache writer(directory_, 1024);
+  auto const key = Key(writer, "corrupted", 1);
+  std::string const contents = "the quick brown fox";
+  ASSERT_STATUS_OK(writer.Insert(key, contents));
+  std::ofstream(writer.FileName(key), std::ios::binary | std::ios::trunc)
+      << "the quick brown cat";
+
+  ObjectCache reader(directory_, 1024);
+  auto const crc32c = ComputeCrc32cChecksum(contents);
+  EXPECT_EQ(nullptr, reader.Lookup(key, crc32c));
+  // The file is removed, even lookups without a checksum miss.
+  EXPECT_EQ(nullptr, reader.Lookup(key));
+  auto const stats = reader.stats();
+  EXPECT_EQ(0, stats.hits);
+  EXPECT_EQ(2, stats.misses);
+  EXPECT_EQ(0, stats.bytes);
+}
+
+TEST_F(ObjectCacheTest, EntriesAreVerifiedOnce) {
+  ObjectCache writer(directory_, 1024);
+  auto const key = Key(writer, "verified", 1);
+  std::string const contents = "the quick brown fox";
+  ASSERT_STATUS_OK(writer.Insert(key, contents));
+  // The inserted contents are trusted.
+  EXPECT_NE(nullptr, writer.LookupVerified(key));
+
+  // Files created by other processes are verified on their first lookup with
+  // a checksum, and trusted afterwards.
+  ObjectCache reader(directory_, 1024);
+  EXPECT_EQ(nullptr, reader.LookupVerified(key));
+  auto const crc32c = ComputeCrc32cChecksum(contents);
+  EXPECT_NE(nullptr, reader.Lookup(key, crc32c));
+  EXPECT_NE(nullptr, reader.LookupVerified(key));
+
+  auto const stats = reader.stats();
+  EXPECT_EQ(2, stats.hits);
+  EXPECT_EQ(0, stats.misses);
+}
+
+TEST_F(ObjectCacheTest, AdoptsExistingFiles) {
+  // Simulate a previous run that left more files than the capacity allows.
+  {
+    ObjectCache previous(directory_, 1024);
+    for (auto const* name : {"a", "b", "c"}) {
+      ASSERT_STATUS_OK(previous.Insert(Key(previous, name, 1), "0123456789"));
+    }
+  }
+
+  ObjectCache cache(directory_, 25);
+  auto stats = cache.stats();
+  EXPECT_EQ(1, stats.evictions);
+  EXPECT_EQ(20, stats.bytes);
+  int found = 0;
+  for (auto const* name : {"a", "b", "c"}) {
+    if (cache.Lookup(Key(cache, name, 1)) != nullptr) ++found;
+  }
+  EXPECT_EQ(2, found);
+}
+
+#if !_WIN32
+TEST_F(ObjectCacheTest, EvictsOldestExistingFiles) {
+  ObjectCache cache(directory_, 1024);
+  auto const old_key = Key(cache, "old", 1);
+  auto const new_key = Key(cache, "new", 1);
+  auto write = [](std::string const& path, std::time_t mtime) {
+    std::ofstream(path, std::ios::binary) << "0123456789";
+    struct utimbuf times {};
+    times.actime = mtime;
+    times.modtime = mtime;
+    ASSERT_EQ(0, ::utime(path.c_str(), &times));
+  };
+  auto const now = std::time(nullptr);
+  write(cache.FileName(new_key), now - 10);
+  write(cache.FileName(old_key), now - 20);
+
+  ObjectCache reader(directory_, 15);
+  EXPECT_EQ(1, reader.stats().evictions);
+  EXPECT_EQ(nullptr, reader.Lookup(old_key));
+  EXPECT_NE(nullptr, reader.Lookup(new_key));
+}
+
+TEST_F(ObjectCacheTest, RemovesStaleTemporaryFiles) {
+  ObjectCache cache(directory_, 1024);
+  auto const key = Key(cache, "temporary", 1);
+  auto const stale = cache.FileName(key) + ".tmp-stale";
+  auto const fresh = cache.FileName(key) + ".tmp-fresh";
+  files_.push_back(stale);
+  files_.push_back(fresh);
+  std::ofstream(stale, std::ios::binary) << "stale";
+  std::ofstream(fresh, std::ios::binary) << "fresh";
+  struct utimbuf times {};
+  times.actime = std::time(nullptr) - 2 * 3600;
+  times.modtime = times.actime;
+  ASSERT_EQ(0, ::utime(stale.c_str(), &times));
+
+  ObjectCache reader(directory_, 1024);
+  struct stat s {};
+  EXPECT_NE(0, ::stat(stale.c_str(), &s));
+  EXPECT_EQ(0, ::stat(fresh.c_str(), &s));
+  // Temporary files are not entries.
+  EXPECT_EQ(0, reader.stats().bytes);
+}
+#endif  // !_WIN32
+
+TEST_F(ObjectCacheTest, CreatesDirectory) {
+  auto const directory = directory_ + "/created";
+  ObjectCache cache(directory, 1024);
+  auto const key = Key(cache, "test-object", 1);
+  ASSERT_STATUS_OK(cache.Insert(key, "contents"));
+  std::remove(cache.FileName(key).c_str());
+  std::remove(directory.c_str());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
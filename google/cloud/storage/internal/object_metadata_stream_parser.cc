@@ -0,0 +1,601 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/object_metadata_stream_parser.h"
+#include "google/cloud/storage/internal/nljson.h"
+#include "google/cloud/storage/internal/object_acl_requests.h"
+#include "google/cloud/internal/parse_rfc3339.h"
+#include <cerrno>
+#include <cstdlib>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+enum class Field {
+  kUnknown,
+  kAcl,
+  kBucket,
+  kCacheControl,
+  kComponentCount,
+  kContentDisposition,
+  kContentEncoding,
+  kContentLanguage,
+  kContentType,
+  kCrc32c,
+  kCustomerEncryption,
+  kEtag,
+  kEventBasedHold,
+  kGeneration,
+  kId,
+  kKind,
+  kKmsKeyName,
+  kMd5Hash,
+  kMediaLink,
+  kMetadata,
+  kMetageneration,
+  kName,
+  kOwner,
+  kRetentionExpirationTime,
+  kSelfLink,
+  kSize,
+  kStorageClass,
+  kTemporaryHold,
+  kTimeCreated,
+  kTimeDeleted,
+  kTimeStorageClassUpdated,
+  kUpdated,
+};
+
+Field LookupField(std::string const& name) {
+  static auto const* const kFields = new std::unordered_map<std::string, Field>{
+      {"acl", Field::kAcl},
+      {"bucket", Field::kBucket},
+      {"cacheControl", Field::kCacheControl},
+      {"componentCount", Field::kComponentCount},
+      {"contentDisposition", Field::kContentDisposition},
+      {"contentEncoding", Field::kContentEncoding},
+      {"contentLanguage", Field::kContentLanguage},
+      {"contentType", Field::kContentType},
+      {"crc32c", Field::kCrc32c},
+      {"customerEncryption", Field::kCustomerEncryption},
+      {"etag", Field::kEtag},
+      {"eventBasedHold", Field::kEventBasedHold},
+      {"generation", Field::kGeneration},
+      {"id", Field::kId},
+      {"kind", Field::kKind},
+      {"kmsKeyName", Field::kKmsKeyName},
+      {"md5Hash", Field::kMd5Hash},
+      {"mediaLink", Field::kMediaLink},
+      {"metadata", Field::kMetadata},
+      {"metageneration", Field::kMetageneration},
+      {"name", Field::kName},
+      {"owner", Field::kOwner},
+      {"retentionExpirationTime", Field::kRetentionExpirationTime},
+      {"selfLink", Field::kSelfLink},
+      {"size", Field::kSize},
+      {"storageClass", Field::kStorageClass},
+      {"temporaryHold", Field::kTemporaryHold},
+      {"timeCreated", Field::kTimeCreated},
+      {"timeDeleted", Field::kTimeDeleted},
+      {"timeStorageClassUpdated", Field::kTimeStorageClassUpdated},
+      {"updated", Field::kUpdated},
+  };
+  auto f = kFields->find(name);
+  return f == kFields->end() ? Field::kUnknown : f->second;
+}
+
+bool ParseInteger(std::string const& s, std::int64_t& value) {
+  if (s.empty()) return false;
+  char* end;
+  errno = 0;
+  auto v = std::strtoll(s.c_str(), &end, 10);
+  if (errno != 0 || *end != '\0') return false;
+  value = static_cast<std::int64_t>(v);
+  return true;
+}
+
+bool ParseInteger(std::string const& s, std::uint64_t& value) {
+  if (s.empty()) return false;
+  char* end;
+  errno = 0;
+  auto v = std::strtoull(s.c_str(), &end, 10);
+  if (errno != 0 || *end != '\0') return false;
+  value = static_cast<std::uint64_t>(v);
+  return true;
+}
+}  // namespace
+
+/**
+ * Receives the events from the nlohmann/json SAX parser.
+ *
+ * The handler keeps a stack with the type of each open JSON object or array.
+ * Scalar values are stored directly in the `ObjectMetadata` fields. The ACL
+ * entries are rare and have many fields, they are collected into a small
+ * `nl::json` object and parsed using `ObjectAccessControlParser`.
+ */
+class ObjectMetadataStreamParser::Handler {
+ public:
+  Handler(ObjectMetadata* object, ListObjectsResponse* list)
+      : object_(object), list_(list) {}
+
+  Status Parse(std::string const& payload) {
+    auto const success = nl::json::sax_parse(payload, this);
+    if (!status_.ok()) return status_;
+    if (!success || !root_seen_ || !stack_.empty()) {
+      return Status(StatusCode::kInvalidArgument,
+                    "Error parsing object metadata: incomplete JSON object");
+    }
+    return Status();
+  }
+
+  //@{
+  /// @name The nlohmann/json SAX interface.
+  bool null() { return OnValue(Value::Null()); }
+  bool boolean(bool v) { return OnValue(Value::Boolean(v)); }
+  bool number_integer(nl::json::number_integer_t v) {
+    return OnValue(Value::Integer(v));
+  }
+  bool number_unsigned(nl::json::number_unsigned_t v) {
+    return OnValue(Value::Unsigned(v));
+  }
+  bool number_float(nl::json::number_float_t v, nl::json::string_t const&) {
+    return OnValue(Value::Float(v));
+  }
+  bool string(nl::json::string_t& v) { return OnValue(Value::String(v)); }
+  // Only generated by the binary formats, which this class does not use.
+  template <typename Binary>
+  bool binary(Binary&) {
+    return Error("unexpected binary value");
+  }
+
+  bool start_object(std::size_t);
+  bool key(nl::json::string_t& v);
+  bool end_object() { return EndContainer(); }
+  bool start_array(std::size_t);
+  bool end_array() { return EndContainer(); }
+
+  template <typename Exception>
+  bool parse_error(std::size_t, std::string const&, Exception const& ex) {
+    status_ = Status(StatusCode::kInvalidArgument,
+                     std::string("Error parsing object metadata: ") +
+                         ex.what());
+    return false;
+  }
+  //@}
+
+ private:
+  /// The type of each open JSON object or array.
+  enum class Frame {
+    kListResponse,
+    kItems,
+    kPrefixes,
+    kObject,
+    kOwner,
+    kCustomerEncryption,
+    kMetadata,
+    kAcl,
+    kDom,
+    kSkip,
+  };
+
+  /// A scalar value received from the parser.
+  struct Value {
+    enum Type { kNull, kBoolean, kInteger, kUnsigned, kFloat, kString };
+    Type type;
+    bool b;
+    std::int64_t i;
+    std::uint64_t u;
+    double f;
+    std::string* s;
+
+    static Value Null() { return {kNull, false, 0, 0, 0, nullptr}; }
+    static Value Boolean(bool v) { return {kBoolean, v, 0, 0, 0, nullptr}; }
+    static Value Integer(std::int64_t v) {
+      return {kInteger, false, v, 0, 0, nullptr};
+    }
+    static Value Unsigned(std::uint64_t v) {
+      return {kUnsigned, false, 0, v, 0, nullptr};
+    }
+    static Value Float(double v) { return {kFloat, false, 0, 0, v, nullptr}; }
+    static Value String(std::string& v) {
+      return {kString, false, 0, 0, 0, &v};
+    }
+  };
+
+  bool Push(Frame frame) {
+    stack_.push_back(frame);
+    return true;
+  }
+
+  bool Error(std::string const& what) {
+    status_ = Status(StatusCode::kInvalidArgument,
+                     "Error parsing field <" + key_ + ">: " + what);
+    return false;
+  }
+
+  bool OnValue(Value const& v);
+  bool SetObjectField(Value const& v);
+  bool SetString(std::string& dest, Value const& v);
+  bool SetBoolean(bool& dest, Value const& v);
+  bool SetTimestamp(std::chrono::system_clock::time_point& dest,
+                    Value const& v);
+  template <typename T>
+  bool SetInteger(T& dest, Value const& v);
+  std::string* StringField(Field field);
+
+  bool EndContainer();
+  bool StartDom(nl::json v);
+  bool EndDom();
+  void AddToDom(std::string const& key, nl::json v);
+  static nl::json ToJson(Value const& v);
+
+  ObjectMetadata* object_;
+  ListObjectsResponse* list_;
+  Status status_;
+  bool root_seen_ = false;
+  std::vector<Frame> stack_;
+  std::string key_;
+  Field field_ = Field::kUnknown;
+  bool skip_ = false;
+  std::vector<nl::json> dom_;
+  std::vector<std::string> dom_keys_;
+};
+
+bool ObjectMetadataStreamParser::Handler::start_object(std::size_t) {
+  if (stack_.empty()) {
+    if (root_seen_) return Error("unexpected JSON object");
+    root_seen_ = true;
+    return Push(list_ != nullptr ? Frame::kListResponse : Frame::kObject);
+  }
+  switch (stack_.back()) {
+    case Frame::kItems:
+      list_->items.emplace_back();
+      object_ = &list_->items.back();
+      return Push(Frame::kObject);
+    case Frame::kObject:
+      if (skip_) return Push(Frame::kSkip);
+      switch (field_) {
+        case Field::kOwner:
+          object_->owner_ = Owner{};
+          return Push(Frame::kOwner);
+        case Field::kCustomerEncryption:
+          object_->customer_encryption_ = CustomerEncryption{};
+          return Push(Frame::kCustomerEncryption);
+        case Field::kMetadata:
+          return Push(Frame::kMetadata);
+        default:
+          break;
+      }
+      return Error("unexpected JSON object");
+    case Frame::kAcl:
+    case Frame::kDom:
+      return StartDom(nl::json::object());
+    case Frame::kPrefixes:
+    case Frame::kMetadata:
+      return Error("unexpected JSON object");
+    case Frame::kListResponse:
+    case Frame::kOwner:
+    case Frame::kCustomerEncryption:
+    case Frame::kSkip:
+      break;
+  }
+  return Push(Frame::kSkip);
+}
+
+bool ObjectMetadataStreamParser::Handler::key(nl::json::string_t& v) {
+  if (!stack_.empty() && stack_.back() == Frame::kObject) {
+    field_ = LookupField(v);
+    skip_ = field_ == Field::kUnknown;
+  }
+  key_ = std::move(v);
+  return true;
+}
+
+bool ObjectMetadataStreamParser::Handler::start_array(std::size_t) {
+  if (stack_.empty()) return Error("expected a JSON object");
+  switch (stack_.back()) {
+    case Frame::kListResponse:
+      if (key_ == "items") return Push(Frame::kItems);
+      if (key_ == "prefixes") return Push(Frame::kPrefixes);
+      break;
+    case Frame::kObject:
+      if (skip_) break;
+      if (field_ == Field::kAcl) return Push(Frame::kAcl);
+      return Error("unexpected JSON array");
+    case Frame::kDom:
+      return StartDom(nl::json::array());
+    case Frame::kItems:
+    case Frame::kPrefixes:
+    case Frame::kAcl:
+    case Frame::kMetadata:
+      return Error("unexpected JSON array");
+    case Frame::kOwner:
+    case Frame::kCustomerEncryption:
+    case Frame::kSkip:
+      break;
+  }
+  return Push(Frame::kSkip);
+}
+
+bool ObjectMetadataStreamParser::Handler::EndContainer() {
+  auto const frame = stack_.back();
+  stack_.pop_back();
+  if (frame == Frame::kDom) return EndDom();
+  return true;
+}
+
+bool ObjectMetadataStreamParser::Handler::OnValue(Value const& v) {
+  if (stack_.empty()) return Error("expected a JSON object");
+  switch (stack_.back()) {
+    case Frame::kListResponse:
+      if (key_ == "nextPageToken") return SetString(list_->next_page_token, v);
+      return true;
+    case Frame::kItems:
+      return Error("expected a JSON object");
+    case Frame::kPrefixes:
+      if (v.type != Value::kString) return Error("expected a string");
+      list_->prefixes.push_back(std::move(*v.s));
+      return true;
+    case Frame::kObject:
+      if (skip_) return true;
+      return SetObjectField(v);
+    case Frame::kOwner:
+      if (key_ == "entity") return SetString(object_->owner_->entity, v);
+      if (key_ == "entityId") return SetString(object_->owner_->entity_id, v);
+      return true;
+    case Frame::kCustomerEncryption:
+      if (key_ == "encryptionAlgorithm") {
+        return SetString(object_->customer_encryption_->encryption_algorithm,
+                         v);
+      }
+      if (key_ == "keySha256") {
+        return SetString(object_->customer_encryption_->key_sha256, v);
+      }
+      return true;
+    case Frame::kMetadata:
+      if (v.type != Value::kString) return Error("expected a string");
+      object_->metadata_[key_] = std::move(*v.s);
+      return true;
+    case Frame::kAcl:
+      return Error("expected a JSON object");
+    case Frame::kDom:
+      AddToDom(key_, ToJson(v));
+      return true;
+    case Frame::kSkip:
+      break;
+  }
+  return true;
+}
+
+bool ObjectMetadataStreamParser::Handler::SetObjectField(Value const& v) {
+  auto* s = StringField(field_);
+  if (s != nullptr) return SetString(*s, v);
+  switch (field_) {
+    case Field::kComponentCount:
+      return SetInteger(object_->component_count_, v);
+    case Field::kGeneration:
+      return SetInteger(object_->generation_, v);
+    case Field::kMetageneration:
+      return SetInteger(object_->metageneration_, v);
+    case Field::kSize:
+      return SetInteger(object_->size_, v);
+    case Field::kEventBasedHold:
+      return SetBoolean(object_->event_based_hold_, v);
+    case Field::kTemporaryHold:
+      return SetBoolean(object_->temporary_hold_, v);
+    case Field::kRetentionExpirationTime:
+      return SetTimestamp(object_->retention_expiration_time_, v);
+    case Field::kTimeCreated:
+      return SetTimestamp(object_->time_created_, v);
+    case Field::kTimeDeleted:
+      return SetTimestamp(object_->time_deleted_, v);
+    case Field::kTimeStorageClassUpdated:
+      return SetTimestamp(object_->time_storage_class_updated_, v);
+    case Field::kUpdated:
+      return SetTimestamp(object_->updated_, v);
+    default:
+      break;
+  }
+  // The remaining fields are objects or arrays.
+  if (v.type == Value::kNull) return true;
+  return Error("unexpected scalar value");
+}
+
+std::string* ObjectMetadataStreamParser::Handler::StringField(Field field) {
+  switch (field) {
+    case Field::kBucket:
+      return &object_->bucket_;
+    case Field::kCacheControl:
+      return &object_->cache_control_;
+    case Field::kContentDisposition:
+      return &object_->content_disposition_;
+    case Field::kContentEncoding:
+      return &object_->content_encoding_;
+    case Field::kContentLanguage:
+      return &object_->content_language_;
+    case Field::kContentType:
+      return &object_->content_type_;
+    case Field::kCrc32c:
+      return &object_->crc32c_;
+    case Field::kEtag:
+      return &object_->etag_;
+    case Field::kId:
+      return &object_->id_;
+    case Field::kKind:
+      return &object_->kind_;
+    case Field::kKmsKeyName:
+      return &object_->kms_key_name_;
+    case Field::kMd5Hash:
+      return &object_->md5_hash_;
+    case Field::kMediaLink:
+      return &object_->media_link_;
+    case Field::kName:
+      return &object_->name_;
+    case Field::kSelfLink:
+      return &object_->self_link_;
+    case Field::kStorageClass:
+      return &object_->storage_class_;
+    default:
+      break;
+  }
+  return nullptr;
+}
+
+bool ObjectMetadataStreamParser::Handler::SetString(std::string& dest,
+                                                    Value const& v) {
+  if (v.type == Value::kNull) return true;
+  if (v.type != Value::kString) return Error("expected a string");
+  dest = std::move(*v.s);
+  return true;
+}
+
+bool ObjectMetadataStreamParser::Handler::SetBoolean(bool& dest,
+                                                     Value const& v) {
+  switch (v.type) {
+    case Value::kNull:
+      return true;
+    case Value::kBoolean:
+      dest = v.b;
+      return true;
+    case Value::kString:
+      if (*v.s == "true" || *v.s == "false") {
+        dest = *v.s == "true";
+        return true;
+      }
+      break;
+    default:
+      break;
+  }
+  return Error("expected a boolean");
+}
+
+bool ObjectMetadataStreamParser::Handler::SetTimestamp(
+    std::chrono::system_clock::time_point& dest, Value const& v) {
+  if (v.type == Value::kNull) return true;
+  if (v.type != Value::kString) return Error("expected a timestamp");
+  dest = google::cloud::internal::ParseRfc3339(*v.s);
+  return true;
+}
+
+template <typename T>
+bool ObjectMetadataStreamParser::Handler::SetInteger(T& dest, Value const& v) {
+  using Parsed = typename std::conditional<std::is_signed<T>::value,
+                                           std::int64_t, std::uint64_t>::type;
+  switch (v.type) {
+    case Value::kNull:
+      return true;
+    case Value::kInteger:
+      dest = static_cast<T>(v.i);
+      return true;
+    case Value::kUnsigned:
+      dest = static_cast<T>(v.u);
+      return true;
+    case Value::kFloat:
+      dest = static_cast<T>(v.f);
+      return true;
+    case Value::kString: {
+      Parsed parsed;
+      if (!ParseInteger(*v.s, parsed)) break;
+      dest = static_cast<T>(parsed);
+      return true;
+    }
+    default:
+      break;
+  }
+  return Error("expected an integer");
+}
+
+bool ObjectMetadataStreamParser::Handler::StartDom(nl::json v) {
+  dom_keys_.push_back(key_);
+  dom_.push_back(std::move(v));
+  return Push(Frame::kDom);
+}
+
+bool ObjectMetadataStreamParser::Handler::EndDom() {
+  auto v = std::move(dom_.back());
+  dom_.pop_back();
+  auto k = std::move(dom_keys_.back());
+  dom_keys_.pop_back();
+  if (!dom_.empty()) {
+    AddToDom(k, std::move(v));
+    return true;
+  }
+  // This was a complete ACL entry.
+  auto acl = ObjectAccessControlParser::FromJson(v);
+  if (!acl) {
+    status_ = std::move(acl).status();
+    return false;
+  }
+  object_->acl_.push_back(*std::move(acl));
+  return true;
+}
+
+void ObjectMetadataStreamParser::Handler::AddToDom(std::string const& key,
+                                                   nl::json v) {
+  auto& parent = dom_.back();
+  if (parent.is_object()) {
+    parent[key] = std::move(v);
+  } else {
+    parent.push_back(std::move(v));
+  }
+}
+
+nl::json ObjectMetadataStreamParser::Handler::ToJson(Value const& v) {
+  switch (v.type) {
+    case Value::kBoolean:
+      return nl::json(v.b);
+    case Value::kInteger:
+      return nl::json(v.i);
+    case Value::kUnsigned:
+      return nl::json(v.u);
+    case Value::kFloat:
+      return nl::json(v.f);
+    case Value::kString:
+      return nl::json(std::move(*v.s));
+    case Value::kNull:
+      break;
+  }
+  return nl::json(nullptr);
+}
+
+StatusOr<ObjectMetadata> ObjectMetadataStreamParser::ParseObjectMetadata(
+    std::string const& payload) {
+  ObjectMetadata result;
+  Handler handler(&result, nullptr);
+  auto status = handler.Parse(payload);
+  if (!status.ok()) return status;
+  return result;
+}
+
+StatusOr<ListObjectsResponse>
+ObjectMetadataStreamParser::ParseListObjectsResponse(
+    std::string const& payload) {
+  ListObjectsResponse result;
+  Handler handler(nullptr, &result);
+  auto status = handler.Parse(payload);
+  if (!status.ok()) return status;
+  return result;
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
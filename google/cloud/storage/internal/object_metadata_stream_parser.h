@@ -0,0 +1,59 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_METADATA_STREAM_PARSER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_METADATA_STREAM_PARSER_H
+
+#include "google/cloud/storage/internal/object_requests.h"
+#include "google/cloud/storage/object_metadata.h"
+#include "google/cloud/storage/version.h"
+#include "google/cloud/status_or.h"
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+/**
+ * Parses object resources without creating a `nl::json` object.
+ *
+ * `ObjectMetadataParser::FromJson()` requires a fully parsed JSON object,
+ * which allocates a node for each field. When parsing large listings building
+ * this tree dominates the cost. This class fills `ObjectMetadata` objects
+ * directly from the parser events. The results are identical to
+ * `ObjectMetadataParser::FromJson()`.
+ */
+class ObjectMetadataStreamParser {
+ public:
+  /// Parses a single object resource.
+  static StatusOr<ObjectMetadata> ParseObjectMetadata(
+      std::string const& payload);
+
+  /// Parses the response of an `Objects: list` request.
+  static StatusOr<ListObjectsResponse> ParseListObjectsResponse(
+      std::string const& payload);
+
+ private:
+  class Handler;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_METADATA_STREAM_PARSER_H
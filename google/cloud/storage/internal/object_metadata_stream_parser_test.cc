@@ -0,0 +1,222 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/object_metadata_stream_parser.h"
+#include "google/cloud/storage/internal/nljson.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::testing::ElementsAre;
+
+std::string const kFullObject = R"""({
+      "acl": [{
+        "kind": "storage#objectAccessControl",
+        "id": "acl-id-0",
+        "selfLink": "https://storage.googleapis.com/storage/v1/b/foo-bar/o/baz/acl/user-qux",
+        "bucket": "foo-bar",
+        "object": "foo",
+        "generation": 12345,
+        "entity": "user-qux",
+        "role": "OWNER",
+        "email": "qux@example.com",
+        "entityId": "user-qux-id-123",
+        "domain": "example.com",
+        "projectTeam": {
+          "projectNumber": "4567",
+          "team": "owners"
+        },
+        "etag": "AYX="
+      }, {
+        "kind": "storage#objectAccessControl",
+        "id": "acl-id-1",
+        "selfLink": "https://storage.googleapis.com/storage/v1/b/foo-bar/o/baz/acl/user-quux",
+        "bucket": "foo-bar",
+        "object": "foo",
+        "generation": 12345,
+        "entity": "user-quux",
+        "role": "READER",
+        "email": "qux@example.com",
+        "entityId": "user-quux-id-123",
+        "domain": "example.com",
+        "projectTeam": {
+          "projectNumber": "4567",
+          "team": "viewers"
+        },
+        "etag": "AYX="
+      }
+      ],
+      "bucket": "foo-bar",
+      "cacheControl": "no-cache",
+      "componentCount": 7,
+      "contentDisposition": "a-disposition",
+      "contentEncoding": "an-encoding",
+      "contentLanguage": "a-language",
+      "contentType": "application/octet-stream",
+      "crc32c": "deadbeef",
+      "customerEncryption": {
+        "encryptionAlgorithm": "some-algo",
+        "keySha256": "abc123"
+      },
+      "etag": "XYZ=",
+      "eventBasedHold": true,
+      "generation": "12345",
+      "id": "foo-bar/baz/12345",
+      "kind": "storage#object",
+      "kmsKeyName": "/foo/bar/baz/key",
+      "md5Hash": "deaderBeef=",
+      "mediaLink": "https://storage.googleapis.com/storage/v1/b/foo-bar/o/baz?generation=12345&alt=media",
+      "metadata": {
+        "foo": "bar",
+        "baz": "qux"
+      },
+      "metageneration": "4",
+      "name": "baz",
+      "owner": {
+        "entity": "user-qux",
+        "entityId": "user-qux-id-123"
+      },
+      "retentionExpirationTime": "2019-01-01T00:00:00Z",
+      "selfLink": "https://storage.googleapis.com/storage/v1/b/foo-bar/o/baz",
+      "size": 102400,
+      "storageClass": "STANDARD",
+      "temporaryHold": true,
+      "timeCreated": "2018-05-19T19:31:14Z",
+      "timeDeleted": "2018-05-19T19:32:24Z",
+      "timeStorageClassUpdated": "2018-05-19T19:31:34Z",
+      "updated": "2018-05-19T19:31:24Z"
+})""";
+
+ObjectMetadata ParseWithDom(std::string const& payload) {
+  return ObjectMetadataParser::FromJson(nl::json::parse(payload)).value();
+}
+
+/// @test Verify that all the fields are parsed as in the DOM-based parser.
+TEST(ObjectMetadataStreamParserTest, MatchesDomParser) {
+  auto actual = ObjectMetadataStreamParser::ParseObjectMetadata(kFullObject);
+  ASSERT_STATUS_OK(actual);
+  auto const expected = ParseWithDom(kFullObject);
+  EXPECT_EQ(expected, *actual);
+  EXPECT_EQ(2, actual->acl().size());
+  EXPECT_EQ("viewers", actual->acl().at(1).project_team().team);
+  EXPECT_EQ("some-algo", actual->customer_encryption().encryption_algorithm);
+  EXPECT_EQ("bar", actual->metadata("foo"));
+  EXPECT_EQ("user-qux-id-123", actual->owner().entity_id);
+  EXPECT_EQ(12345, actual->generation());
+  EXPECT_EQ(4, actual->metageneration());
+  EXPECT_EQ(102400, actual->size());
+  EXPECT_TRUE(actual->temporary_hold());
+}
+
+/// @test Verify that list responses are parsed as in the DOM-based parser.
+TEST(ObjectMetadataStreamParserTest, ListObjectsResponse) {
+  std::string const payload = R"""({
+      "kind": "storage#objects",
+      "nextPageToken": "some-token-42",
+      "prefixes": ["a/", "b/"],
+      "items": [)""" + kFullObject + R"""(,
+        {"name": "foo", "generation": 7, "size": "1024",
+         "unknownArray": [1, [2, {"x": 3}]], "unknownObject": {"y": [4]}}
+      ]
+})""";
+  auto actual = ObjectMetadataStreamParser::ParseListObjectsResponse(payload);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ("some-token-42", actual->next_page_token);
+  EXPECT_THAT(actual->prefixes, ElementsAre("a/", "b/"));
+  ASSERT_EQ(2, actual->items.size());
+
+  auto const json = nl::json::parse(payload);
+  EXPECT_EQ(ObjectMetadataParser::FromJson(json["items"][0]).value(),
+            actual->items[0]);
+  EXPECT_EQ(ObjectMetadataParser::FromJson(json["items"][1]).value(),
+            actual->items[1]);
+  EXPECT_EQ(1024, actual->items[1].size());
+}
+
+TEST(ObjectMetadataStreamParserTest, EmptyListObjectsResponse) {
+  auto actual = ObjectMetadataStreamParser::ParseListObjectsResponse(
+      R"""({"kind": "storage#objects"})""");
+  ASSERT_STATUS_OK(actual);
+  EXPECT_TRUE(actual->next_page_token.empty());
+  EXPECT_TRUE(actual->items.empty());
+  EXPECT_TRUE(actual->prefixes.empty());
+}
+
+TEST(ObjectMetadataStreamParserTest, ValuesAsStrings) {
+  auto actual = ObjectMetadataStreamParser::ParseObjectMetadata(R"""({
+      "componentCount": "3",
+      "eventBasedHold": "true",
+      "generation": "-2",
+      "size": "18446744073709551615",
+      "temporaryHold": false
+})""");
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(3, actual->component_count());
+  EXPECT_TRUE(actual->event_based_hold());
+  EXPECT_EQ(-2, actual->generation());
+  EXPECT_EQ(18446744073709551615ULL, actual->size());
+  EXPECT_FALSE(actual->temporary_hold());
+}
+
+TEST(ObjectMetadataStreamParserTest, InvalidPayloads) {
+  for (std::string const payload : {
+           "",
+           "{",
+           "[]",
+           "7",
+           R"""({"name": "foo"} {})""",
+           R"""({"name": 7})""",
+           R"""({"generation": "not-a-number"})""",
+           R"""({"generation": true})""",
+           R"""({"eventBasedHold": "maybe"})""",
+           R"""({"timeCreated": 1234})""",
+           R"""({"metadata": {"key": 1}})""",
+           R"""({"acl": {}})""",
+           R"""({"acl": [1]})""",
+           R"""({"owner": [1]})""",
+       }) {
+    auto actual = ObjectMetadataStreamParser::ParseObjectMetadata(payload);
+    EXPECT_EQ(StatusCode::kInvalidArgument, actual.status().code())
+        << "payload=" << payload;
+  }
+}
+
+TEST(ObjectMetadataStreamParserTest, InvalidListPayloads) {
+  for (std::string const payload : {
+           "[]",
+           R"""({"nextPageToken": 7})""",
+           R"""({"prefixes": [7]})""",
+           R"""({"prefixes": [{}]})""",
+           R"""({"items": [7]})""",
+           R"""({"items": [[]]})""",
+           R"""({"items": [{"size": "x"}]})""",
+       }) {
+    auto actual = ObjectMetadataStreamParser::ParseListObjectsResponse(payload);
+    EXPECT_EQ(StatusCode::kInvalidArgument, actual.status().code())
+        << "payload=" << payload;
+  }
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -15,6 +15,7 @@
 #ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_READ_SOURCE_H
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_READ_SOURCE_H
 
+#include "google/cloud/storage/internal/const_buffer.h"
 #include "google/cloud/storage/internal/http_response.h"
 #include "google/cloud/storage/version.h"
 #include "google/cloud/status_or.h"
@@ -49,6 +50,18 @@ struct ReadSourceResult {
   HttpResponse response;
 };
 
+/**
+ * The result of reading data without copying it, see
+ * `ObjectReadSource::ReadBorrowed()`.
+ *
+ * The `response` field has the same semantics as in `ReadSourceResult`.
+ */
+struct BorrowedReadSourceResult {
+  /// The data, owned by the source and only valid until its next call.
+  ConstBuffer data;
+  HttpResponse response;
+};
+
 /**
  * A data source for ObjectReadStreambuf.
  *
@@ -69,6 +82,25 @@ class ObjectReadSource {
   /// Read more data from the download, returning any HTTP headers and error
   /// codes.
   virtual StatusOr<ReadSourceResult> Read(char* buf, std::size_t n) = 0;
+
+  /**
+   * Returns true if the source implements `ReadBorrowed()`.
+   *
+   * Sources that receive the data in their own buffers, such as the messages
+   * of a streaming RPC, can lend these buffers to the caller.
+   */
+  virtual bool CanReadBorrowed() const { return false; }
+
+  /**
+   * Read more data from the download, without copying it.
+   *
+   * The data is owned by the source, it remains valid until the next call to
+   * any member function of the source. Callers must check `CanReadBorrowed()`
+   * first.
+   */
+  virtual StatusOr<BorrowedReadSourceResult> ReadBorrowed() {
+    return Status(StatusCode::kUnimplemented, "ReadBorrowed() not supported");
+  }
 };
 
 /**
@@ -0,0 +1,146 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/hashing_options.h"
+#include "google/cloud/storage/internal/object_read_source.h"
+#include "google/cloud/storage/internal/object_requests.h"
+#include "google/cloud/storage/internal/object_streambuf.h"
+#include "absl/memory/memory.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+// Run on (1 X 2100 MHz CPU ), using a debug build
+// CPU Caches:
+//   L1 Data 48 KiB (x1)
+//   L1 Instruction 32 KiB (x1)
+//   L2 Unified 2048 KiB (x1)
+//   L3 Unified 307200 KiB (x1)
+// -----------------------------------------------------------------------
+// Benchmark                         Time        CPU  Iterations UserCounters
+// -----------------------------------------------------------------------
+// BM_ReadStreambufCopy        2517518 ns  2475173 ns        282 25.25G/s
+// BM_ReadStreambufBorrowed       8682 ns     8595 ns      79045 7.10T/s
+
+auto constexpr kMessageSize = 2 * 1024 * 1024;
+auto constexpr kMessageCount = 32;
+
+/**
+ * Simulates a source that receives the data in large messages, like the
+ * gRPC transport does.
+ */
+class FakeMessageSource : public ObjectReadSource {
+ public:
+  FakeMessageSource(std::string const& message, bool can_read_borrowed)
+      : message_(message), can_read_borrowed_(can_read_borrowed) {}
+
+  bool IsOpen() const override { return remaining_ != 0 || offset_ != 0; }
+  StatusOr<HttpResponse> Close() override {
+    return HttpResponse{HttpStatusCode::kOk, {}, {}};
+  }
+
+  StatusOr<ReadSourceResult> Read(char* buf, std::size_t n) override {
+    std::size_t bytes = 0;
+    while (bytes != n && NextMessage()) {
+      auto const count = (std::min)(n - bytes, message_.size() - offset_);
+      std::memcpy(buf + bytes, message_.data() + offset_, count);
+      bytes += count;
+      Consume(count);
+    }
+    return ReadSourceResult{bytes, Response()};
+  }
+
+  bool CanReadBorrowed() const override { return can_read_borrowed_; }
+  StatusOr<BorrowedReadSourceResult> ReadBorrowed() override {
+    if (!NextMessage()) return BorrowedReadSourceResult{{}, Response()};
+    auto const count = message_.size() - offset_;
+    ConstBuffer data(message_.data() + offset_, count);
+    Consume(count);
+    return BorrowedReadSourceResult{data, Response()};
+  }
+
+ private:
+  bool NextMessage() {
+    if (offset_ != 0) return true;
+    return remaining_ != 0;
+  }
+  void Consume(std::size_t count) {
+    offset_ += count;
+    if (offset_ != message_.size()) return;
+    offset_ = 0;
+    --remaining_;
+  }
+  HttpResponse Response() const {
+    return HttpResponse{IsOpen() ? HttpStatusCode::kContinue
+                                 : HttpStatusCode::kOk,
+                        {},
+                        {}};
+  }
+
+  std::string const& message_;
+  bool can_read_borrowed_;
+  int remaining_ = kMessageCount;
+  std::size_t offset_ = 0;
+};
+
+/// Discards all the data, so the benchmark measures only the reads.
+class NullStreambuf : public std::streambuf {
+ protected:
+  std::streamsize xsputn(char const*, std::streamsize count) override {
+    return count;
+  }
+  int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+};
+
+void ReadAll(benchmark::State& state, bool can_read_borrowed) {
+  std::string const message(kMessageSize, 'A');
+  ReadObjectRangeRequest const request =
+      ReadObjectRangeRequest("test-bucket", "test-object")
+          .set_multiple_options(DisableCrc32cChecksum(true),
+                                DisableMD5Hash(true));
+  NullStreambuf null;
+  std::ostream sink(&null);
+  for (auto _ : state) {
+    ObjectReadStreambuf buf(request, absl::make_unique<FakeMessageSource>(
+                                         message, can_read_borrowed));
+    // Copying the stream buffer uses `underflow()`, like `operator>>`,
+    // `std::getline()`, and other formatted input functions.
+    sink << &buf;
+  }
+  state.SetBytesProcessed(state.iterations() * kMessageSize * kMessageCount);
+}
+
+void BM_ReadStreambufCopy(benchmark::State& state) { ReadAll(state, false); }
+BENCHMARK(BM_ReadStreambufCopy);
+
+void BM_ReadStreambufBorrowed(benchmark::State& state) {
+  ReadAll(state, true);
+}
+BENCHMARK(BM_ReadStreambufBorrowed);
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -17,6 +17,7 @@
 #include "google/cloud/storage/internal/metadata_parser.h"
 #include "google/cloud/storage/internal/nljson.h"
 #include "google/cloud/storage/internal/object_acl_requests.h"
+#include "google/cloud/storage/internal/object_metadata_stream_parser.h"
 #include "google/cloud/storage/object_metadata.h"
 #include <cinttypes>
 #include <sstream>
@@ -100,8 +101,7 @@ StatusOr<ObjectMetadata> ObjectMetadataParser::FromJson(
 
 StatusOr<ObjectMetadata> ObjectMetadataParser::FromString(
     std::string const& payload) {
-  auto json = internal::nl::json::parse(payload, nullptr, false);
-  return FromJson(json);
+  return ObjectMetadataStreamParser::ParseObjectMetadata(payload);
 }
 
 internal::nl::json ObjectMetadataJsonForCompose(ObjectMetadata const& meta) {
@@ -196,23 +196,7 @@ std::ostream& operator<<(std::ostream& os, ListObjectsRequest const& r) {
 
 StatusOr<ListObjectsResponse> ListObjectsResponse::FromHttpResponse(
     std::string const& payload) {
-  auto json = storage::internal::nl::json::parse(payload, nullptr, false);
-  if (!json.is_object()) {
-    return Status(StatusCode::kInvalidArgument, __func__);
-  }
-
-  ListObjectsResponse result;
-  result.next_page_token = json.value("nextPageToken", "");
-
-  for (auto const& kv : json["items"].items()) {
-    auto parsed = internal::ObjectMetadataParser::FromJson(kv.value());
-    if (!parsed.ok()) {
-      return std::move(parsed).status();
-    }
-    result.items.emplace_back(std::move(*parsed));
-  }
-
-  return result;
+  return ObjectMetadataStreamParser::ParseListObjectsResponse(payload);
 }
 
 std::ostream& operator<<(std::ostream& os, ListObjectsResponse const& r) {
@@ -220,6 +204,9 @@ std::ostream& operator<<(std::ostream& os, ListObjectsResponse const& r) {
      << ", items={";
   std::copy(r.items.begin(), r.items.end(),
             std::ostream_iterator<ObjectMetadata>(os, "\n  "));
+  os << "}, prefixes={";
+  std::copy(r.prefixes.begin(), r.prefixes.end(),
+            std::ostream_iterator<std::string>(os, ", "));
   return os << "}}";
 }
 
@@ -571,7 +558,7 @@ std::ostream& operator<<(std::ostream& os, ResumableUploadRequest const& r) {
 std::string UploadChunkRequest::RangeHeader() const {
   std::ostringstream os;
   os << "Content-Range: bytes ";
-  if (payload().empty()) {
+  if (payload_size() == 0) {
     // This typically happens when the sender realizes too late that the
     // previous chunk was really the last chunk (e.g. the file is exactly a
     // multiple of the quantum, reading the last chunk from a file, or sending
@@ -579,7 +566,7 @@ std::string UploadChunkRequest::RangeHeader() const {
     // the range is special in this case.
     os << "*";
   } else {
-    os << range_begin() << "-" << range_begin() + payload().size() - 1;
+    os << range_begin() << "-" << range_begin() + payload_size() - 1;
   }
   if (!last_chunk_) {
     os << "/*";
@@ -594,10 +581,13 @@ std::ostream& operator<<(std::ostream& os, UploadChunkRequest const& r) {
      << ", range=<" << r.RangeHeader() << ">";
   r.DumpOptions(os, ", ");
   auto constexpr kMaxOutputBytes = 128;
-  return os << ", payload="
-            << BinaryDataAsDebugString(r.payload().data(), r.payload().size(),
-                                       kMaxOutputBytes)
-            << "}";
+  os << ", payload={";
+  char const* sep = "";
+  for (auto const& b : r.payload()) {
+    os << sep << BinaryDataAsDebugString(b.data(), b.size(), kMaxOutputBytes);
+    sep = ", ";
+  }
+  return os << "}}";
 }
 
 std::ostream& operator<<(std::ostream& os,
@@ -17,8 +17,10 @@
 
 #include "google/cloud/storage/download_options.h"
 #include "google/cloud/storage/hashing_options.h"
+#include "google/cloud/storage/internal/const_buffer.h"
 #include "google/cloud/storage/internal/generic_object_request.h"
 #include "google/cloud/storage/internal/http_response.h"
+#include "google/cloud/storage/list_objects_options.h"
 #include "google/cloud/storage/object_metadata.h"
 #include "google/cloud/storage/upload_options.h"
 #include "google/cloud/storage/version.h"
@@ -55,7 +57,7 @@ internal::nl::json ObjectMetadataJsonForUpdate(ObjectMetadata const& meta);
  */
 class ListObjectsRequest
     : public GenericRequest<ListObjectsRequest, MaxResults, Prefix, Delimiter,
-                            Projection, UserProject, Versions> {
+                            Projection, UserProject, Versions, PrefetchPages> {
  public:
   ListObjectsRequest() = default;
   explicit ListObjectsRequest(std::string bucket_name)
@@ -81,6 +83,8 @@ struct ListObjectsResponse {
 
   std::string next_page_token;
   std::vector<ObjectMetadata> items;
+  /// The prefixes found when the request uses a `Delimiter`.
+  std::vector<std::string> prefixes;
 };
 
 std::ostream& operator<<(std::ostream& os, ListObjectsResponse const& r);
@@ -378,12 +382,12 @@ class UploadChunkRequest : public GenericRequest<UploadChunkRequest> {
  public:
   UploadChunkRequest() = default;
   UploadChunkRequest(std::string upload_session_url, std::uint64_t range_begin,
-                     std::string payload)
+                     ConstBufferSequence payload)
       : upload_session_url_(std::move(upload_session_url)),
         range_begin_(range_begin),
         payload_(std::move(payload)) {}
   UploadChunkRequest(std::string upload_session_url, std::uint64_t range_begin,
-                     std::string payload, std::uint64_t source_size)
+                     ConstBufferSequence payload, std::uint64_t source_size)
       : upload_session_url_(std::move(upload_session_url)),
         range_begin_(range_begin),
         payload_(std::move(payload)),
@@ -392,9 +396,11 @@ class UploadChunkRequest : public GenericRequest<UploadChunkRequest> {
 
   std::string const& upload_session_url() const { return upload_session_url_; }
   std::uint64_t range_begin() const { return range_begin_; }
-  std::uint64_t range_end() const { return range_begin_ + payload_.size() - 1; }
+  std::uint64_t range_end() const { return range_begin_ + payload_size() - 1; }
   std::uint64_t source_size() const { return source_size_; }
-  std::string const& payload() const { return payload_; }
+  std::size_t payload_size() const { return TotalBytes(payload_); }
+  /// The payload buffers, they are not owned by the request.
+  ConstBufferSequence const& payload() const { return payload_; }
 
   std::string RangeHeader() const;
 
@@ -416,7 +422,7 @@ class UploadChunkRequest : public GenericRequest<UploadChunkRequest> {
  private:
   std::string upload_session_url_;
   std::uint64_t range_begin_ = 0;
-  std::string payload_;
+  ConstBufferSequence payload_;
   std::uint64_t source_size_ = 0;
   bool last_chunk_ = false;
 };
@@ -114,6 +114,19 @@ TEST(ObjectRequestsTest, ParseListResponse) {
   auto actual = ListObjectsResponse::FromHttpResponse(text).value();
   EXPECT_EQ("some-token-42", actual.next_page_token);
   EXPECT_THAT(actual.items, ::testing::ElementsAre(o1, o2));
+  EXPECT_TRUE(actual.prefixes.empty());
+}
+
+TEST(ObjectRequestsTest, ParseListResponseWithPrefixes) {
+  std::string text = R"""({
+      "kind": "storage#objects",
+      "prefixes": ["foo/", "qux/"]
+})""";
+
+  auto actual = ListObjectsResponse::FromHttpResponse(text).value();
+  EXPECT_EQ("", actual.next_page_token);
+  EXPECT_TRUE(actual.items.empty());
+  EXPECT_THAT(actual.prefixes, ::testing::ElementsAre("foo/", "qux/"));
 }
 
 TEST(ObjectRequestsTest, ParseListResponseFailure) {
@@ -505,7 +518,8 @@ TEST(ObjectRequestsTest, UploadChunk) {
       "https://storage.googleapis.com/upload/storage/v1/b/"
       "myBucket/o?uploadType=resumable"
       "&upload_id=xa298sd_sdlkj2";
-  UploadChunkRequest request(url, 0, "abc123", 2048);
+  std::string const payload = "abc123";
+  UploadChunkRequest request(url, 0, {payload}, 2048);
   EXPECT_EQ(url, request.upload_session_url());
   EXPECT_EQ(0, request.range_begin());
   EXPECT_EQ(5, request.range_end());
@@ -517,35 +531,54 @@ TEST(ObjectRequestsTest, UploadChunk) {
   std::string actual = os.str();
   EXPECT_THAT(actual, HasSubstr(url));
   EXPECT_THAT(actual, HasSubstr("<Content-Range: bytes 0-5/2048>"));
+  EXPECT_THAT(actual, HasSubstr("abc123"));
+}
+
+TEST(ObjectRequestsTest, UploadChunkMultipleBuffers) {
+  std::string const url = "https://unused.googleapis.com/test-only";
+  std::string const p0 = "abc";
+  std::string const p1 = "123";
+  UploadChunkRequest request(url, 0, {p0, ConstBuffer{}, p1}, 2048);
+  EXPECT_EQ(6, request.payload_size());
+  EXPECT_EQ(5, request.range_end());
+  EXPECT_EQ("Content-Range: bytes 0-5/2048", request.RangeHeader());
+
+  std::ostringstream os;
+  os << request;
+  auto const actual = os.str();
+  EXPECT_THAT(actual, HasSubstr("abc"));
+  EXPECT_THAT(actual, HasSubstr("123"));
 }
 
 TEST(ObjectRequestsTest, UploadChunkContentRangeNotLast) {
   std::string const url = "https://unused.googleapis.com/test-only";
-  UploadChunkRequest request(url, 1024, "1234");
+  std::string const payload = "1234";
+  UploadChunkRequest request(url, 1024, {payload});
   EXPECT_EQ("Content-Range: bytes 1024-1027/*", request.RangeHeader());
 }
 
 TEST(ObjectRequestsTest, UploadChunkContentRangeLast) {
   std::string const url = "https://unused.googleapis.com/test-only";
-  UploadChunkRequest request(url, 2045, "1234", 2048U);
+  std::string const payload = "1234";
+  UploadChunkRequest request(url, 2045, {payload}, 2048U);
   EXPECT_EQ("Content-Range: bytes 2045-2048/2048", request.RangeHeader());
 }
 
 TEST(ObjectRequestsTest, UploadChunkContentRangeEmptyPayloadNotLast) {
   std::string const url = "https://unused.googleapis.com/test-only";
-  UploadChunkRequest request(url, 1024, std::string{});
+  UploadChunkRequest request(url, 1024, {});
   EXPECT_EQ("Content-Range: bytes */*", request.RangeHeader());
 }
 
 TEST(ObjectRequestsTest, UploadChunkContentRangeEmptyPayloadLast) {
   std::string const url = "https://unused.googleapis.com/test-only";
-  UploadChunkRequest request(url, 2047, std::string{}, 2048U);
+  UploadChunkRequest request(url, 2047, {}, 2048U);
   EXPECT_EQ("Content-Range: bytes */2048", request.RangeHeader());
 }
 
 TEST(ObjectRequestsTest, UploadChunkContentRangeEmptyPayloadEmpty) {
   std::string const url = "https://unused.googleapis.com/test-only";
-  UploadChunkRequest request(url, 1024, std::string{}, 0U);
+  UploadChunkRequest request(url, 1024, {}, 0U);
   EXPECT_EQ("Content-Range: bytes */0", request.RangeHeader());
 }
 
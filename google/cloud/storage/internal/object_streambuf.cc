@@ -41,6 +41,7 @@ ObjectReadStreambuf::ObjectReadStreambuf(ReadObjectRangeRequest const& request,
 bool ObjectReadStreambuf::IsOpen() const { return source_->IsOpen(); }
 
 void ObjectReadStreambuf::Close() {
+  ReleaseBorrowedRegion();
   auto response = source_->Close();
   if (!response.ok()) {
     ReportError(std::move(response).status());
@@ -56,29 +57,32 @@ StatusOr<ObjectReadStreambuf::int_type> ObjectReadStreambuf::Peek() {
     return traits_type::eof();
   }
 
+  if (source_->CanReadBorrowed()) return PeekBorrowed();
+
+  // Only grow the buffer, never shrink it. Resizing the vector down to the
+  // number of bytes received, and then back up on the next call, would
+  // value-initialize (i.e. zero-fill) the buffer before each read, which is
+  // about as expensive as copying the data a second time.
   auto constexpr kInitialPeekRead = 128 * 1024;
-  current_ios_buffer_.resize(kInitialPeekRead);
+  if (current_ios_buffer_.size() < kInitialPeekRead) {
+    current_ios_buffer_.resize(kInitialPeekRead);
+  }
   std::size_t n = current_ios_buffer_.size();
   StatusOr<ReadSourceResult> read_result =
       source_->Read(current_ios_buffer_.data(), n);
   if (!read_result.ok()) {
     return std::move(read_result).status();
   }
-  // assert(n <= current_ios_buffer_.size())
-  current_ios_buffer_.resize(read_result->bytes_received);
+  // assert(read_result->bytes_received <= n)
+  auto const bytes_received = read_result->bytes_received;
 
-  for (auto const& kv : read_result->response.headers) {
-    hash_validator_->ProcessHeader(kv.first, kv.second);
-    headers_.emplace(kv.first, kv.second);
-  }
-  if (read_result->response.status_code >= HttpStatusCode::kMinNotSuccess) {
-    return AsStatus(read_result->response);
-  }
+  auto status = ProcessResponse(read_result->response);
+  if (!status.ok()) return status;
 
-  if (!current_ios_buffer_.empty()) {
+  if (bytes_received != 0) {
     char* data = current_ios_buffer_.data();
-    hash_validator_->Update(data, current_ios_buffer_.size());
-    setg(data, data, data + current_ios_buffer_.size());
+    hash_validator_->Update(data, bytes_received);
+    setg(data, data, data + bytes_received);
     return traits_type::to_int_type(*data);
   }
 
@@ -88,6 +92,42 @@ StatusOr<ObjectReadStreambuf::int_type> ObjectReadStreambuf::Peek() {
   return traits_type::eof();
 }
 
+StatusOr<ObjectReadStreambuf::int_type> ObjectReadStreambuf::PeekBorrowed() {
+  ReleaseBorrowedRegion();
+  auto read_result = source_->ReadBorrowed();
+  if (!read_result.ok()) {
+    return std::move(read_result).status();
+  }
+  auto status = ProcessResponse(read_result->response);
+  if (!status.ok()) return status;
+
+  auto const& data = read_result->data;
+  if (!data.empty()) {
+    hash_validator_->Update(data.data(), data.size());
+    // The get area points directly to the data in the source, there is no
+    // copy. `std::basic_streambuf<>` never writes to the get area, but it
+    // requires non-const pointers.
+    char* begin = const_cast<char*>(data.data());
+    setg(begin, begin, begin + data.size());
+    borrowed_region_ = true;
+    return traits_type::to_int_type(*begin);
+  }
+
+  SetEmptyRegion();
+  return traits_type::eof();
+}
+
+Status ObjectReadStreambuf::ProcessResponse(HttpResponse const& response) {
+  for (auto const& kv : response.headers) {
+    hash_validator_->ProcessHeader(kv.first, kv.second);
+    headers_.emplace(kv.first, kv.second);
+  }
+  if (response.status_code >= HttpStatusCode::kMinNotSuccess) {
+    return AsStatus(response);
+  }
+  return Status();
+}
+
 ObjectReadStreambuf::int_type ObjectReadStreambuf::underflow() {
   auto next_char = Peek();
   if (!next_char) {
@@ -185,6 +225,7 @@ std::streamsize ObjectReadStreambuf::xsgetn(char* s, std::streamsize count) {
     return run_validator_if_closed(Status());
   }
 
+  ReleaseBorrowedRegion();
   StatusOr<ReadSourceResult> read_result =
       source_->Read(s + offset, static_cast<std::size_t>(count - offset));
   // If there was an error set the internal state, but we still return the
@@ -202,6 +243,8 @@ std::streamsize ObjectReadStreambuf::xsgetn(char* s, std::streamsize count) {
 
   hash_validator_->Update(s + offset, read_result->bytes_received);
   offset += read_result->bytes_received;
+  // The data bypassed the get area, keep the last character for `sungetc()`.
+  if (read_result->bytes_received != 0) SetPutbackRegion(s[offset - 1]);
 
   for (auto const& kv : read_result->response.headers) {
     hash_validator_->ProcessHeader(kv.first, kv.second);
@@ -238,6 +281,28 @@ void ObjectReadStreambuf::SetEmptyRegion() {
   current_ios_buffer_.push_back('\0');
   char* data = &current_ios_buffer_[0];
   setg(data, data + 1, data + 1);
+  borrowed_region_ = false;
+}
+
+void ObjectReadStreambuf::ReleaseBorrowedRegion() {
+  if (!borrowed_region_) return;
+  borrowed_region_ = false;
+  if (gptr() == eback()) {
+    setg(nullptr, nullptr, nullptr);
+    return;
+  }
+  // Any unread data is lost, `Peek()` and `xsgetn()` only call this function
+  // once the region is drained, and `Close()` discards the data anyway.
+  SetPutbackRegion(gptr()[-1]);
+}
+
+void ObjectReadStreambuf::SetPutbackRegion(char c) {
+  // Do not shrink the buffer, see the comments in `Peek()`.
+  if (current_ios_buffer_.empty()) current_ios_buffer_.resize(1);
+  char* data = current_ios_buffer_.data();
+  data[0] = c;
+  setg(data, data + 1, data + 1);
+  borrowed_region_ = false;
 }
 
 ObjectWriteStreambuf::ObjectWriteStreambuf(
@@ -346,8 +411,8 @@ StatusOr<ResumableUploadResponse> ObjectWriteStreambuf::FlushFinal() {
   std::size_t upload_size = upload_session_->next_expected_byte() + actual_size;
   hash_validator_->Update(pbase(), actual_size);
 
-  std::string to_upload(pbase(), actual_size);
-  last_response_ = upload_session_->UploadFinalChunk(to_upload, upload_size);
+  last_response_ = upload_session_->UploadFinalChunk(
+      {ConstBuffer(pbase(), actual_size)}, upload_size);
   if (!last_response_) {
     // This was an unrecoverable error, time to store status and signal an
     // error.
@@ -381,9 +446,8 @@ StatusOr<ResumableUploadResponse> ObjectWriteStreambuf::Flush() {
   auto expected_next_byte = upload_session_->next_expected_byte() + chunk_size;
 
   hash_validator_->Update(pbase(), chunk_size);
-  StatusOr<ResumableUploadResponse> result;
-  std::string to_send(pbase(), chunk_size);
-  last_response_ = upload_session_->UploadChunk(to_send);
+  last_response_ =
+      upload_session_->UploadChunk({ConstBuffer(pbase(), chunk_size)});
   if (!last_response_) {
     return last_response_;
   }
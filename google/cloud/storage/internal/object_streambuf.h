@@ -70,7 +70,20 @@ class ObjectReadStreambuf : public std::basic_streambuf<char> {
  private:
   int_type ReportError(Status status);
   void SetEmptyRegion();
+  /**
+   * Moves the putback character out of a get area lent by the source.
+   *
+   * Borrowed buffers are only valid until the next call on `source_`, this
+   * must be called before any such call that may replace them.
+   */
+  void ReleaseBorrowedRegion();
+  /// Sets an empty get area with @p c as its putback character.
+  void SetPutbackRegion(char c);
   StatusOr<int_type> Peek();
+  /// Implements `Peek()` for sources that can lend their buffers.
+  StatusOr<int_type> PeekBorrowed();
+  /// Processes the headers in @p response, and returns its error (if any).
+  Status ProcessResponse(HttpResponse const& response);
 
   int_type underflow() override;
   std::streamsize xsgetn(char* s, std::streamsize count) override;
@@ -81,6 +94,7 @@ class ObjectReadStreambuf : public std::basic_streambuf<char> {
   HashValidator::Result hash_validator_result_;
   Status status_;
   std::multimap<std::string, std::string> headers_;
+  bool borrowed_region_ = false;
 };
 
 /**
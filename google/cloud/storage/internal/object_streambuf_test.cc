@@ -19,6 +19,9 @@
 #include "google/cloud/testing_util/assert_ok.h"
 #include "absl/memory/memory.h"
 #include <gmock/gmock.h>
+#include <algorithm>
+#include <istream>
+#include <vector>
 
 namespace google {
 namespace cloud {
@@ -31,9 +34,9 @@ using ::testing::_;
 using ::testing::InSequence;
 using ::testing::Invoke;
 using ::testing::InvokeWithoutArgs;
+using ::testing::ResultOf;
 using ::testing::Return;
 using ::testing::ReturnRef;
-using ::testing::SizeIs;
 
 /// @test Verify that uploading an empty stream creates a single chunk.
 TEST(ObjectWriteStreambufTest, EmptyStream) {
@@ -44,10 +47,10 @@ TEST(ObjectWriteStreambufTest, EmptyStream) {
 
   int count = 0;
   EXPECT_CALL(*mock, UploadFinalChunk(_, _))
-      .WillOnce(Invoke([&](std::string const& p, std::uint64_t s) {
+      .WillOnce(Invoke([&](ConstBufferSequence const& p, std::uint64_t s) {
         ++count;
         EXPECT_EQ(1, count);
-        EXPECT_TRUE(p.empty());
+        EXPECT_EQ(0, TotalBytes(p));
         EXPECT_EQ(0, s);
         return make_status_or(ResumableUploadResponse{
             "{}", 0, {}, ResumableUploadResponse::kInProgress, {}});
@@ -70,10 +73,10 @@ TEST(ObjectWriteStreambufTest, SmallStream) {
 
   int count = 0;
   EXPECT_CALL(*mock, UploadFinalChunk(_, _))
-      .WillOnce(Invoke([&](std::string const& p, std::uint64_t s) {
+      .WillOnce(Invoke([&](ConstBufferSequence const& p, std::uint64_t s) {
         ++count;
         EXPECT_EQ(1, count);
-        EXPECT_EQ(payload, p);
+        EXPECT_EQ(payload, ToString(p));
         EXPECT_EQ(payload.size(), s);
         auto last_committed_byte = payload.size() - 1;
         return make_status_or(
@@ -104,20 +107,25 @@ TEST(ObjectWriteStreambufTest, EmptyTrailer) {
 
   int count = 0;
   size_t next_byte = 0;
-  EXPECT_CALL(*mock, UploadChunk(_)).WillOnce(Invoke([&](std::string const& p) {
-    ++count;
-    EXPECT_EQ(1, count);
-    EXPECT_EQ(payload, p);
-    auto last_committed_byte = payload.size() - 1;
-    next_byte = last_committed_byte + 1;
-    return make_status_or(ResumableUploadResponse{
-        "", last_committed_byte, {}, ResumableUploadResponse::kInProgress, {}});
-  }));
+  EXPECT_CALL(*mock, UploadChunk(_))
+      .WillOnce(Invoke([&](ConstBufferSequence const& p) {
+        ++count;
+        EXPECT_EQ(1, count);
+        EXPECT_EQ(payload, ToString(p));
+        auto last_committed_byte = payload.size() - 1;
+        next_byte = last_committed_byte + 1;
+        return make_status_or(
+            ResumableUploadResponse{"",
+                                    last_committed_byte,
+                                    {},
+                                    ResumableUploadResponse::kInProgress,
+                                    {}});
+      }));
   EXPECT_CALL(*mock, UploadFinalChunk(_, _))
-      .WillOnce(Invoke([&](std::string const& p, std::uint64_t s) {
+      .WillOnce(Invoke([&](ConstBufferSequence const& p, std::uint64_t s) {
         ++count;
         EXPECT_EQ(2, count);
-        EXPECT_TRUE(p.empty());
+        EXPECT_EQ(0, TotalBytes(p));
         EXPECT_EQ(quantum, s);
         auto last_committed_byte = quantum - 1;
         return make_status_or(
@@ -160,7 +168,8 @@ TEST(ObjectWriteStreambufTest, FlushAfterLargePayload) {
                                   {}});
     }));
     EXPECT_CALL(
-        *mock, UploadFinalChunk(payload_2, payload_1.size() + payload_2.size()))
+        *mock, UploadFinalChunk(ResultOf(ToString, payload_2),
+                                payload_1.size() + payload_2.size()))
         .WillOnce(Return(make_status_or(
             ResumableUploadResponse{"{}",
                                     payload_1.size() + payload_2.size() - 1,
@@ -192,21 +201,23 @@ TEST(ObjectWriteStreambufTest, FlushAfterFullQuantum) {
 
   int count = 0;
   size_t next_byte = 0;
-  EXPECT_CALL(*mock, UploadChunk(_)).WillOnce(Invoke([&](std::string const& p) {
-    ++count;
-    EXPECT_EQ(1, count);
-    auto expected = payload_1 + payload_2.substr(0, quantum - payload_1.size());
-    EXPECT_EQ(expected, p);
-    next_byte += p.size();
-    return make_status_or(ResumableUploadResponse{
-        "", quantum - 1, {}, ResumableUploadResponse::kInProgress, {}});
-  }));
+  EXPECT_CALL(*mock, UploadChunk(_))
+      .WillOnce(Invoke([&](ConstBufferSequence const& p) {
+        ++count;
+        EXPECT_EQ(1, count);
+        auto expected =
+            payload_1 + payload_2.substr(0, quantum - payload_1.size());
+        EXPECT_EQ(expected, ToString(p));
+        next_byte += TotalBytes(p);
+        return make_status_or(ResumableUploadResponse{
+            "", quantum - 1, {}, ResumableUploadResponse::kInProgress, {}});
+      }));
   EXPECT_CALL(*mock, UploadFinalChunk(_, _))
-      .WillOnce(Invoke([&](std::string const& p, std::uint64_t s) {
+      .WillOnce(Invoke([&](ConstBufferSequence const& p, std::uint64_t s) {
         ++count;
         EXPECT_EQ(2, count);
         auto expected = payload_2.substr(payload_2.size() - payload_1.size());
-        EXPECT_EQ(expected, p);
+        EXPECT_EQ(expected, ToString(p));
         EXPECT_EQ(payload_1.size() + payload_2.size(), s);
         auto last_committed_byte = payload_1.size() + payload_2.size() - 1;
         return make_status_or(
@@ -238,20 +249,21 @@ TEST(ObjectWriteStreambufTest, OverflowFlushAtFullQuantum) {
 
   int count = 0;
   size_t next_byte = 0;
-  EXPECT_CALL(*mock, UploadChunk(_)).WillOnce(Invoke([&](std::string const& p) {
-    ++count;
-    EXPECT_EQ(1, count);
-    auto const& expected = payload;
-    EXPECT_EQ(expected, p);
-    next_byte += p.size();
-    return make_status_or(ResumableUploadResponse{
-        "", quantum - 1, {}, ResumableUploadResponse::kInProgress, {}});
-  }));
+  EXPECT_CALL(*mock, UploadChunk(_))
+      .WillOnce(Invoke([&](ConstBufferSequence const& p) {
+        ++count;
+        EXPECT_EQ(1, count);
+        auto const& expected = payload;
+        EXPECT_EQ(expected, ToString(p));
+        next_byte += TotalBytes(p);
+        return make_status_or(ResumableUploadResponse{
+            "", quantum - 1, {}, ResumableUploadResponse::kInProgress, {}});
+      }));
   EXPECT_CALL(*mock, UploadFinalChunk(_, _))
-      .WillOnce(Invoke([&](std::string const& p, std::uint64_t s) {
+      .WillOnce(Invoke([&](ConstBufferSequence const& p, std::uint64_t s) {
         ++count;
         EXPECT_EQ(2, count);
-        EXPECT_TRUE(p.empty());
+        EXPECT_EQ(0, TotalBytes(p));
         EXPECT_EQ(payload.size(), s);
         auto last_committed_byte = payload.size() - 1;
         return make_status_or(
@@ -285,20 +297,21 @@ TEST(ObjectWriteStreambufTest, SomeBytesNotAccepted) {
 
   size_t next_byte = 0;
   uint64_t const bytes_uploaded_first_try = quantum - 1;
-  EXPECT_CALL(*mock, UploadChunk(_)).WillOnce(Invoke([&](std::string const& p) {
-    auto expected = payload.substr(0, quantum);
-    EXPECT_EQ(expected, p);
-    next_byte += bytes_uploaded_first_try;
-    return make_status_or(
-        ResumableUploadResponse{"",
-                                bytes_uploaded_first_try - 1,
-                                {},
-                                ResumableUploadResponse::kInProgress,
-                                {}});
-  }));
+  EXPECT_CALL(*mock, UploadChunk(_))
+      .WillOnce(Invoke([&](ConstBufferSequence const& p) {
+        auto expected = payload.substr(0, quantum);
+        EXPECT_EQ(expected, ToString(p));
+        next_byte += bytes_uploaded_first_try;
+        return make_status_or(
+            ResumableUploadResponse{"",
+                                    bytes_uploaded_first_try - 1,
+                                    {},
+                                    ResumableUploadResponse::kInProgress,
+                                    {}});
+      }));
   EXPECT_CALL(*mock, UploadFinalChunk(_, _))
-      .WillOnce(Invoke([&](std::string const& p, std::uint64_t s) {
-        EXPECT_EQ(p, payload.substr(bytes_uploaded_first_try));
+      .WillOnce(Invoke([&](ConstBufferSequence const& p, std::uint64_t s) {
+        EXPECT_EQ(ToString(p), payload.substr(bytes_uploaded_first_try));
         EXPECT_EQ(payload.size(), s);
         auto last_committed_byte = payload.size() - 1;
         return make_status_or(
@@ -331,13 +344,14 @@ TEST(ObjectWriteStreambufTest, NextExpectedByteJumpsAhead) {
   std::string const payload = std::string(quantum * 2, '*');
 
   size_t next_byte = 0;
-  EXPECT_CALL(*mock, UploadChunk(_)).WillOnce(Invoke([&](std::string const& p) {
-    next_byte += quantum * 2;
-    auto expected = payload.substr(0, quantum);
-    EXPECT_EQ(expected, p);
-    return make_status_or(ResumableUploadResponse{
-        "", next_byte - 1, {}, ResumableUploadResponse::kInProgress, {}});
-  }));
+  EXPECT_CALL(*mock, UploadChunk(_))
+      .WillOnce(Invoke([&](ConstBufferSequence const& p) {
+        next_byte += quantum * 2;
+        auto expected = payload.substr(0, quantum);
+        EXPECT_EQ(expected, ToString(p));
+        return make_status_or(ResumableUploadResponse{
+            "", next_byte - 1, {}, ResumableUploadResponse::kInProgress, {}});
+      }));
   EXPECT_CALL(*mock, next_expected_byte()).WillRepeatedly(Invoke([&]() {
     return next_byte;
   }));
@@ -394,21 +408,23 @@ TEST(ObjectWriteStreambufTest, MixPutcPutn) {
 
   int count = 0;
   size_t next_byte = 0;
-  EXPECT_CALL(*mock, UploadChunk(_)).WillOnce(Invoke([&](std::string const& p) {
-    ++count;
-    EXPECT_EQ(1, count);
-    auto expected = payload_1 + payload_2.substr(0, quantum - payload_1.size());
-    EXPECT_EQ(expected, p);
-    next_byte += p.size();
-    return make_status_or(ResumableUploadResponse{
-        "", quantum - 1, {}, ResumableUploadResponse::kInProgress, {}});
-  }));
+  EXPECT_CALL(*mock, UploadChunk(_))
+      .WillOnce(Invoke([&](ConstBufferSequence const& p) {
+        ++count;
+        EXPECT_EQ(1, count);
+        auto expected =
+            payload_1 + payload_2.substr(0, quantum - payload_1.size());
+        EXPECT_EQ(expected, ToString(p));
+        next_byte += TotalBytes(p);
+        return make_status_or(ResumableUploadResponse{
+            "", quantum - 1, {}, ResumableUploadResponse::kInProgress, {}});
+      }));
   EXPECT_CALL(*mock, UploadFinalChunk(_, _))
-      .WillOnce(Invoke([&](std::string const& p, std::uint64_t s) {
+      .WillOnce(Invoke([&](ConstBufferSequence const& p, std::uint64_t s) {
         ++count;
         EXPECT_EQ(2, count);
         auto expected = payload_2.substr(payload_2.size() - payload_1.size());
-        EXPECT_EQ(expected, p);
+        EXPECT_EQ(expected, ToString(p));
         EXPECT_EQ(payload_1.size() + payload_2.size(), s);
         auto last_committed_byte = payload_1.size() + payload_2.size() - 1;
         return make_status_or(
@@ -461,10 +477,10 @@ TEST(ObjectWriteStreambufTest, ErroneousStream) {
 
   int count = 0;
   EXPECT_CALL(*mock, UploadFinalChunk(_, _))
-      .WillOnce(Invoke([&](std::string const& p, std::uint64_t n) {
+      .WillOnce(Invoke([&](ConstBufferSequence const& p, std::uint64_t n) {
         ++count;
         EXPECT_EQ(1, count);
-        EXPECT_EQ(payload, p);
+        EXPECT_EQ(payload, ToString(p));
         EXPECT_EQ(payload.size(), n);
         return Status(StatusCode::kInvalidArgument, "Invalid Argument");
       }));
@@ -492,7 +508,7 @@ TEST(ObjectWriteStreambufTest, ErrorInLargePayload) {
   std::string const payload_2("trailer");
   std::string const session_id = "upload_id";
 
-  EXPECT_CALL(*mock, UploadChunk(SizeIs(quantum)))
+  EXPECT_CALL(*mock, UploadChunk(ResultOf(TotalBytes, quantum)))
       .WillOnce(
           Return(Status(StatusCode::kInvalidArgument, "Invalid Argument")));
   EXPECT_CALL(*mock, session_id).WillOnce(ReturnRef(session_id));
@@ -512,6 +528,149 @@ TEST(ObjectWriteStreambufTest, ErrorInLargePayload) {
   EXPECT_EQ(StatusCode::kInvalidArgument, response.status().code())
       << ", status=" << response.status();
 }
+
+/// @test Verify that reads of different sizes through underflow() work.
+TEST(ObjectReadStreambufTest, UnderflowVariableSizes) {
+  auto mock = absl::make_unique<testing::MockObjectReadSource>();
+  EXPECT_CALL(*mock, IsOpen).WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock, CanReadBorrowed).WillRepeatedly(Return(false));
+
+  std::string const chunk_1(1024, 'A');
+  std::string const chunk_2 = "short";
+  std::string const chunk_3(2048, 'B');
+  auto make_read = [](std::string const& chunk, HttpStatusCode code) {
+    return [chunk, code](char* buf, std::size_t n) {
+      EXPECT_LE(chunk.size(), n);
+      std::copy(chunk.begin(), chunk.end(), buf);
+      return make_status_or(ReadSourceResult{chunk.size(), {code, {}, {}}});
+    };
+  };
+  EXPECT_CALL(*mock, Read)
+      .WillOnce(Invoke(make_read(chunk_1, HttpStatusCode::kContinue)))
+      .WillOnce(Invoke(make_read(chunk_2, HttpStatusCode::kContinue)))
+      .WillOnce(Invoke(make_read(chunk_3, HttpStatusCode::kContinue)))
+      .WillOnce(Invoke(make_read(std::string{}, HttpStatusCode::kOk)));
+
+  ObjectReadStreambuf streambuf(ReadObjectRangeRequest{}, std::move(mock));
+  std::string actual;
+  for (auto c = streambuf.sgetc(); c != std::char_traits<char>::eof();
+       c = streambuf.snextc()) {
+    actual.push_back(std::char_traits<char>::to_char_type(c));
+  }
+  EXPECT_EQ(chunk_1 + chunk_2 + chunk_3, actual);
+  EXPECT_STATUS_OK(streambuf.status());
+}
+
+/// @test Verify that underflow() uses the buffers lent by the source.
+TEST(ObjectReadStreambufTest, UnderflowBorrowed) {
+  auto mock = absl::make_unique<testing::MockObjectReadSource>();
+  EXPECT_CALL(*mock, IsOpen).WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock, CanReadBorrowed).WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock, Read).Times(0);
+
+  std::string const chunk_1(1024, 'A');
+  std::string const chunk_2 = "short";
+  auto make_read = [](std::string const& chunk, HttpStatusCode code) {
+    return [&chunk, code]() {
+      return make_status_or(BorrowedReadSourceResult{
+          ConstBuffer(chunk.data(), chunk.size()), {code, {}, {}}});
+    };
+  };
+  EXPECT_CALL(*mock, ReadBorrowed)
+      .WillOnce(Invoke(make_read(chunk_1, HttpStatusCode::kContinue)))
+      .WillOnce(Invoke(make_read(chunk_2, HttpStatusCode::kContinue)))
+      .WillOnce(Invoke(make_read(std::string{}, HttpStatusCode::kOk)));
+
+  ObjectReadStreambuf streambuf(ReadObjectRangeRequest{}, std::move(mock));
+  std::string actual;
+  for (auto c = streambuf.sgetc(); c != std::char_traits<char>::eof();
+       c = streambuf.snextc()) {
+    actual.push_back(std::char_traits<char>::to_char_type(c));
+  }
+  EXPECT_EQ(chunk_1 + chunk_2, actual);
+  EXPECT_STATUS_OK(streambuf.status());
+}
+
+/// @test Verify that errors in borrowed reads are reported.
+TEST(ObjectReadStreambufTest, UnderflowBorrowedError) {
+  auto mock = absl::make_unique<testing::MockObjectReadSource>();
+  EXPECT_CALL(*mock, IsOpen).WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock, CanReadBorrowed).WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock, ReadBorrowed)
+      .WillOnce(Return(StatusOr<BorrowedReadSourceResult>(
+          Status(StatusCode::kUnavailable, "try-again"))));
+
+  ObjectReadStreambuf streambuf(ReadObjectRangeRequest{}, std::move(mock));
+  // The streambuf may throw to report errors, `std::istream` catches them.
+  std::istream stream(&streambuf);
+  EXPECT_EQ(std::char_traits<char>::eof(), stream.get());
+  EXPECT_TRUE(stream.bad());
+  EXPECT_EQ(StatusCode::kUnavailable, streambuf.status().code());
+}
+
+/// @test Verify that sungetc() works after xsgetn() replaces a borrowed buffer.
+TEST(ObjectReadStreambufTest, UngetAfterBorrowedAndDirectRead) {
+  auto mock = absl::make_unique<testing::MockObjectReadSource>();
+  EXPECT_CALL(*mock, IsOpen).WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock, CanReadBorrowed).WillRepeatedly(Return(true));
+
+  // The source reuses this buffer, the streambuf must not read from it after
+  // the next call.
+  std::string lent = "abc";
+  EXPECT_CALL(*mock, ReadBorrowed).WillOnce(Invoke([&lent] {
+    return make_status_or(BorrowedReadSourceResult{
+        ConstBuffer(lent.data(), lent.size()),
+        {HttpStatusCode::kContinue, {}, {}}});
+  }));
+  EXPECT_CALL(*mock, Read).WillOnce(Invoke([&lent](char* buf, std::size_t n) {
+    lent.assign(lent.size(), 'X');
+    std::string const payload = "de";
+    EXPECT_LE(payload.size(), n);
+    std::copy(payload.begin(), payload.end(), buf);
+    return make_status_or(
+        ReadSourceResult{payload.size(), {HttpStatusCode::kContinue, {}, {}}});
+  }));
+
+  ObjectReadStreambuf streambuf(ReadObjectRangeRequest{}, std::move(mock));
+  EXPECT_EQ('a', streambuf.sgetc());
+  std::vector<char> buffer(5);
+  EXPECT_EQ(5, streambuf.sgetn(buffer.data(), buffer.size()));
+  EXPECT_EQ("abcde", std::string(buffer.begin(), buffer.end()));
+  EXPECT_EQ('e', streambuf.sungetc());
+  EXPECT_EQ('e', streambuf.sbumpc());
+  EXPECT_STATUS_OK(streambuf.status());
+}
+
+/// @test Verify that sungetc() works after a borrowed buffer is drained.
+TEST(ObjectReadStreambufTest, UngetAfterBorrowedError) {
+  auto mock = absl::make_unique<testing::MockObjectReadSource>();
+  EXPECT_CALL(*mock, IsOpen).WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock, CanReadBorrowed).WillRepeatedly(Return(true));
+
+  std::string lent = "abc";
+  EXPECT_CALL(*mock, ReadBorrowed)
+      .WillOnce(Invoke([&lent] {
+        return make_status_or(BorrowedReadSourceResult{
+            ConstBuffer(lent.data(), lent.size()),
+            {HttpStatusCode::kContinue, {}, {}}});
+      }))
+      .WillOnce(Invoke([&lent] {
+        lent.assign(lent.size(), 'X');
+        return StatusOr<BorrowedReadSourceResult>(
+            Status(StatusCode::kUnavailable, "try-again"));
+      }));
+
+  ObjectReadStreambuf streambuf(ReadObjectRangeRequest{}, std::move(mock));
+  std::istream stream(&streambuf);
+  std::string actual;
+  for (auto c = stream.get(); c != std::char_traits<char>::eof();
+       c = stream.get()) {
+    actual.push_back(std::char_traits<char>::to_char_type(c));
+  }
+  EXPECT_EQ("abc", actual);
+  EXPECT_EQ(StatusCode::kUnavailable, streambuf.status().code());
+  EXPECT_EQ('c', streambuf.sungetc());
+}
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
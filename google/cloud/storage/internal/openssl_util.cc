@@ -173,46 +173,17 @@ std::string Base64Encode(std::vector<std::uint8_t> const& bytes) {
   return Base64Encode(bytes.data(), bytes.size());
 }
 
-std::vector<std::uint8_t> SignStringWithPem(
-    std::string const& str, std::string const& pem_contents,
-    storage::oauth2::JwtSigningAlgorithms alg) {
-  using ::google::cloud::storage::oauth2::JwtSigningAlgorithms;
-
-  // We check for failures several times, so we shorten this into a lambda
-  // to avoid bloating the code with alloc/init checks.
-  const char* func_name = __func__;  // Avoid using the lambda name instead.
-  auto handle_openssl_failure = [&func_name](const char* error_msg) -> void {
-    std::ostringstream err_builder;
-    err_builder << "Permanent error in " << func_name
-                << " (failed to sign string with PEM key):\n"
-                << error_msg;
-    google::cloud::internal::ThrowRuntimeError(err_builder.str());
-  };
-
-  auto digest_ctx = GetDigestCtx();
-  if (!digest_ctx) {
-    handle_openssl_failure("Could not create context for OpenSSL digest.");
-  }
-
-  EVP_MD const* digest_type = nullptr;
-  switch (alg) {
-    case JwtSigningAlgorithms::RS256:
-      digest_type = EVP_sha256();
-      break;
-  }
-  if (digest_type == nullptr) {
-    handle_openssl_failure("Could not find specified digest in OpenSSL.");
-  }
-
+StatusOr<PemPrivateKey> PemPrivateKey::Parse(
+    std::string const& pem_contents) {
   auto pem_buffer = std::unique_ptr<BIO, decltype(&BIO_free)>(
       BIO_new_mem_buf(pem_contents.data(),
                       static_cast<int>(pem_contents.length())),
       &BIO_free);
   if (!pem_buffer) {
-    handle_openssl_failure("Could not create PEM buffer.");
+    return Status(StatusCode::kInternal, "Could not create PEM buffer.");
   }
 
-  auto private_key = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>(
+  auto private_key = std::shared_ptr<EVP_PKEY>(
       PEM_read_bio_PrivateKey(
           pem_buffer.get(),
           nullptr,  // EVP_PKEY **x
@@ -223,7 +194,31 @@ std::vector<std::uint8_t> SignStringWithPem(
           nullptr),
       &EVP_PKEY_free);
   if (!private_key) {
-    handle_openssl_failure("Could not parse PEM to get private key.");
+    return Status(StatusCode::kInvalidArgument,
+                  "Could not parse PEM to get private key.");
+  }
+  return PemPrivateKey(std::move(private_key));
+}
+
+StatusOr<std::vector<std::uint8_t>> PemPrivateKey::Sign(
+    std::string const& str, storage::oauth2::JwtSigningAlgorithms alg) const {
+  using ::google::cloud::storage::oauth2::JwtSigningAlgorithms;
+
+  auto digest_ctx = GetDigestCtx();
+  if (!digest_ctx) {
+    return Status(StatusCode::kInternal,
+                  "Could not create context for OpenSSL digest.");
+  }
+
+  EVP_MD const* digest_type = nullptr;
+  switch (alg) {
+    case JwtSigningAlgorithms::RS256:
+      digest_type = EVP_sha256();
+      break;
+  }
+  if (digest_type == nullptr) {
+    return Status(StatusCode::kInvalidArgument,
+                  "Could not find specified digest in OpenSSL.");
   }
 
   int const digest_sign_success_code = 1;
@@ -232,13 +227,13 @@ std::vector<std::uint8_t> SignStringWithPem(
                          nullptr,  // EVP_PKEY_CTX **pctx
                          digest_type,
                          nullptr,  // ENGINE *e
-                         private_key.get())) {
-    handle_openssl_failure("Could not initialize PEM digest.");
+                         key_.get())) {
+    return Status(StatusCode::kInternal, "Could not initialize PEM digest.");
   }
 
   if (digest_sign_success_code !=
       EVP_DigestSignUpdate(digest_ctx.get(), str.data(), str.length())) {
-    handle_openssl_failure("Could not update PEM digest.");
+    return Status(StatusCode::kInternal, "Could not update PEM digest.");
   }
 
   std::size_t signed_str_size = 0;
@@ -249,17 +244,38 @@ std::vector<std::uint8_t> SignStringWithPem(
       EVP_DigestSignFinal(digest_ctx.get(),
                           nullptr,  // unsigned char *sig
                           &signed_str_size)) {
-    handle_openssl_failure("Could not finalize PEM digest (1/2).");
+    return Status(StatusCode::kInternal,
+                  "Could not finalize PEM digest (1/2).");
   }
 
-  std::vector<unsigned char> signed_str(signed_str_size);
+  std::vector<std::uint8_t> signed_str(signed_str_size);
   if (digest_sign_success_code != EVP_DigestSignFinal(digest_ctx.get(),
                                                       signed_str.data(),
                                                       &signed_str_size)) {
-    handle_openssl_failure("Could not finalize PEM digest (2/2).");
+    return Status(StatusCode::kInternal,
+                  "Could not finalize PEM digest (2/2).");
   }
+  signed_str.resize(signed_str_size);
+  return signed_str;
+}
+
+std::vector<std::uint8_t> SignStringWithPem(
+    std::string const& str, std::string const& pem_contents,
+    storage::oauth2::JwtSigningAlgorithms alg) {
+  char const* func_name = __func__;  // Avoid using the lambda name instead.
+  auto handle_openssl_failure = [&func_name](Status const& status) {
+    std::ostringstream err_builder;
+    err_builder << "Permanent error in " << func_name
+                << " (failed to sign string with PEM key):\n"
+                << status.message();
+    google::cloud::internal::ThrowRuntimeError(err_builder.str());
+  };
 
-  return {signed_str.begin(), signed_str.end()};
+  auto private_key = PemPrivateKey::Parse(pem_contents);
+  if (!private_key) handle_openssl_failure(private_key.status());
+  auto signature = private_key->Sign(str, alg);
+  if (!signature) handle_openssl_failure(signature.status());
+  return *std::move(signature);
 }
 
 std::vector<std::uint8_t> UrlsafeBase64Decode(std::string const& str) {
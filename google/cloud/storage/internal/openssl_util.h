@@ -17,9 +17,15 @@
 
 #include "google/cloud/storage/oauth2/credential_constants.h"
 #include "google/cloud/storage/version.h"
+#include "google/cloud/status_or.h"
 #include <algorithm>
+#include <memory>
+#include <string>
 #include <vector>
 
+// Avoid including the OpenSSL headers, `EVP_PKEY` is an alias for this type.
+struct evp_pkey_st;
+
 namespace google {
 namespace cloud {
 namespace storage {
@@ -41,6 +47,34 @@ std::string Base64Encode(std::string const& str);
  */
 std::string Base64Encode(std::vector<std::uint8_t> const& bytes);
 
+/**
+ * A private key parsed from a PEM container.
+ *
+ * Parsing the PEM container is more expensive than signing a short string,
+ * applications that sign many strings with the same key should parse it only
+ * once. Objects of this class are immutable and cheap to copy, and can be used
+ * to sign strings from multiple threads at the same time.
+ */
+class PemPrivateKey {
+ public:
+  /// Parses @p pem_contents, returns an error if it has no private key.
+  static StatusOr<PemPrivateKey> Parse(std::string const& pem_contents);
+
+  /**
+   * Signs a string with this private key.
+   *
+   * @return Returns the signature as an *unencoded* byte array.
+   */
+  StatusOr<std::vector<std::uint8_t>> Sign(
+      std::string const& str, storage::oauth2::JwtSigningAlgorithms alg) const;
+
+ private:
+  explicit PemPrivateKey(std::shared_ptr<evp_pkey_st> key)
+      : key_(std::move(key)) {}
+
+  std::shared_ptr<evp_pkey_st> key_;
+};
+
 /**
  * Signs a string with the private key from a PEM container.
  *
@@ -0,0 +1,270 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/pipelined_object_write_streambuf.h"
+#include "google/cloud/storage/internal/object_requests.h"
+#include "google/cloud/log.h"
+#include <algorithm>
+#include <sstream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+PipelinedObjectWriteStreambuf::PipelinedObjectWriteStreambuf(
+    std::unique_ptr<ResumableUploadSession> upload_session,
+    std::size_t max_buffer_size, std::unique_ptr<HashValidator> hash_validator,
+    std::size_t pipeline_depth)
+    : upload_session_(std::move(upload_session)),
+      max_buffer_size_(UploadChunkRequest::RoundUpToQuantum(max_buffer_size)),
+      pipeline_depth_((std::max)(pipeline_depth, std::size_t{1})),
+      hash_validator_(std::move(hash_validator)),
+      current_offset_(upload_session_->next_expected_byte()),
+      last_response_(ResumableUploadResponse{
+          {}, 0, {}, ResumableUploadResponse::kInProgress, {}}) {
+  current_ios_buffer_.resize(max_buffer_size_);
+  auto pbeg = current_ios_buffer_.data();
+  setp(pbeg, pbeg + current_ios_buffer_.size());
+  // Sessions start in a closed state for uploads that have already been
+  // finalized.
+  if (upload_session_->done()) {
+    done_ = true;
+    last_response_ = upload_session_->last_response();
+    return;
+  }
+  sender_ = std::thread([this] { SenderLoop(); });
+}
+
+PipelinedObjectWriteStreambuf::~PipelinedObjectWriteStreambuf() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    shutdown_ = true;
+  }
+  cv_.notify_all();
+  // Any chunk in progress is completed, the queued chunks are discarded. The
+  // application can resume the upload from `next_expected_byte()`.
+  if (sender_.joinable()) sender_.join();
+}
+
+StatusOr<ResumableUploadResponse> PipelinedObjectWriteStreambuf::Close() {
+  GCP_LOG(INFO) << __func__ << "()";
+  std::unique_lock<std::mutex> lk(mu_);
+  if (closed_ || done_) return last_response_;
+  Drain(lk);
+  closed_ = true;
+  if (!status_.ok()) return status_;
+  if (done_) return last_response_;
+  // The background thread is idle, and no more chunks will be queued, it is
+  // safe to use the session from this thread.
+  lk.unlock();
+
+  auto const actual_size = static_cast<std::size_t>(pptr() - pbase());
+  hash_validator_->Update(pbase(), actual_size);
+  auto response = upload_session_->UploadFinalChunk(
+      {ConstBuffer(pbase(), actual_size)}, current_offset_ + actual_size);
+
+  // Reset the iostream put area with valid pointers, but empty.
+  current_ios_buffer_.resize(1);
+  auto pbeg = current_ios_buffer_.data();
+  setp(pbeg, pbeg);
+
+  lk.lock();
+  last_response_ = std::move(response);
+  if (!last_response_) status_ = last_response_.status();
+  return last_response_;
+}
+
+bool PipelinedObjectWriteStreambuf::IsOpen() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return !closed_ && !done_ && status_.ok();
+}
+
+bool PipelinedObjectWriteStreambuf::ValidateHash(ObjectMetadata const& meta) {
+  hash_validator_->ProcessMetadata(meta);
+  hash_validator_result_ = std::move(*hash_validator_).Finish();
+  return !hash_validator_result_.is_mismatch;
+}
+
+std::string const& PipelinedObjectWriteStreambuf::resumable_session_id()
+    const {
+  std::unique_lock<std::mutex> lk(mu_);
+  Drain(lk);
+  return upload_session_->session_id();
+}
+
+std::uint64_t PipelinedObjectWriteStreambuf::next_expected_byte() const {
+  std::unique_lock<std::mutex> lk(mu_);
+  Drain(lk);
+  return upload_session_->next_expected_byte();
+}
+
+Status PipelinedObjectWriteStreambuf::last_status() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (!status_.ok()) return status_;
+  return last_response_.status();
+}
+
+int PipelinedObjectWriteStreambuf::sync() {
+  // Partial buffers cannot be uploaded until the stream is closed, report any
+  // errors from the background thread.
+  std::lock_guard<std::mutex> lk(mu_);
+  return status_.ok() ? 0 : traits_type::eof();
+}
+
+std::streamsize PipelinedObjectWriteStreambuf::xsputn(char const* s,
+                                                      std::streamsize count) {
+  if (!IsOpen()) return traits_type::eof();
+
+  std::streamsize bytes_copied = 0;
+  while (bytes_copied != count) {
+    std::streamsize remaining_buffer_size = epptr() - pptr();
+    std::streamsize bytes_to_copy =
+        (std::min)(count - bytes_copied, remaining_buffer_size);
+    std::copy(s, s + bytes_to_copy, pptr());
+    pbump(static_cast<int>(bytes_to_copy));
+    bytes_copied += bytes_to_copy;
+    s += bytes_to_copy;
+    if (pptr() == epptr() && !SubmitBuffer().ok()) return traits_type::eof();
+  }
+  return count;
+}
+
+PipelinedObjectWriteStreambuf::int_type
+PipelinedObjectWriteStreambuf::overflow(int_type ch) {
+  if (!IsOpen()) return traits_type::eof();
+  if (traits_type::eq_int_type(ch, traits_type::eof())) {
+    // For ch == EOF this function must do nothing and return any value != EOF.
+    return 0;
+  }
+  if (pptr() == epptr() && !SubmitBuffer().ok()) return traits_type::eof();
+  *pptr() = traits_type::to_char_type(ch);
+  pbump(1);
+  return ch;
+}
+
+Status PipelinedObjectWriteStreambuf::SubmitBuffer() {
+  auto const size = static_cast<std::size_t>(pptr() - pbase());
+  // The hash is computed in the application thread, while the previous chunks
+  // are uploaded.
+  hash_validator_->Update(pbase(), size);
+  current_ios_buffer_.resize(size);
+
+  std::unique_lock<std::mutex> lk(mu_);
+  cv_.wait(lk, [this] {
+    return !status_.ok() || done_ ||
+           pending_.size() + (sending_ ? 1 : 0) < pipeline_depth_;
+  });
+  if (!status_.ok()) return status_;
+  if (done_) {
+    return Status(StatusCode::kFailedPrecondition,
+                  "Could not continue upload stream. The upload was finalized"
+                  " before all the data was sent.");
+  }
+  pending_.push_back(Chunk{std::move(current_ios_buffer_), current_offset_});
+  current_offset_ += size;
+  if (free_buffers_.empty()) {
+    current_ios_buffer_ = std::vector<char>(max_buffer_size_);
+  } else {
+    current_ios_buffer_ = std::move(free_buffers_.back());
+    free_buffers_.pop_back();
+    current_ios_buffer_.resize(max_buffer_size_);
+  }
+  lk.unlock();
+  cv_.notify_all();
+
+  auto pbeg = current_ios_buffer_.data();
+  setp(pbeg, pbeg + current_ios_buffer_.size());
+  return Status();
+}
+
+void PipelinedObjectWriteStreambuf::Drain(
+    std::unique_lock<std::mutex>& lk) const {
+  cv_.wait(lk, [this] { return pending_.empty() && !sending_; });
+}
+
+void PipelinedObjectWriteStreambuf::SenderLoop() {
+  std::unique_lock<std::mutex> lk(mu_);
+  for (;;) {
+    cv_.wait(lk, [this] { return shutdown_ || !pending_.empty(); });
+    if (shutdown_) break;
+    auto chunk = std::move(pending_.front());
+    pending_.pop_front();
+    // After an error, or if the upload was finalized, the remaining chunks are
+    // discarded.
+    if (status_.ok() && !done_) {
+      sending_ = true;
+      lk.unlock();
+      auto status = UploadChunk(chunk);
+      lk.lock();
+      sending_ = false;
+      if (!status.ok()) status_ = std::move(status);
+    }
+    free_buffers_.push_back(std::move(chunk.buffer));
+    cv_.notify_all();
+  }
+  // Wake up any threads waiting for the queue to drain.
+  pending_.clear();
+  cv_.notify_all();
+}
+
+Status PipelinedObjectWriteStreambuf::UploadChunk(Chunk const& chunk) {
+  auto const chunk_end = chunk.offset + chunk.buffer.size();
+  auto committed = upload_session_->next_expected_byte();
+  while (committed < chunk_end) {
+    if (committed < chunk.offset) {
+      std::ostringstream error_message;
+      error_message << "Could not continue upload stream. GCS requested byte "
+                    << committed << " which has already been uploaded.";
+      return Status(StatusCode::kAborted, error_message.str());
+    }
+    auto const skip = static_cast<std::size_t>(committed - chunk.offset);
+    auto response = upload_session_->UploadChunk({ConstBuffer(
+        chunk.buffer.data() + skip, chunk.buffer.size() - skip)});
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      last_response_ = response;
+      if (response && upload_session_->done()) done_ = true;
+    }
+    if (!response) return std::move(response).status();
+    if (upload_session_->done()) return Status();
+
+    auto const next = upload_session_->next_expected_byte();
+    if (next > chunk_end) {
+      std::ostringstream error_message;
+      error_message << "Could not continue upload stream. "
+                    << "GCS requested unexpected byte. (expected: "
+                    << chunk_end << ", actual: " << next << ")";
+      return Status(StatusCode::kAborted, error_message.str());
+    }
+    if (next <= committed) {
+      std::ostringstream error_message;
+      error_message << "Could not continue upload stream. GCS did not commit"
+                    << " any data. (expected: " << chunk_end
+                    << ", actual: " << next << ")";
+      return Status(StatusCode::kAborted, error_message.str());
+    }
+    // The service may commit only part of the chunk, upload the rest of it
+    // before moving to the next chunk.
+    committed = next;
+  }
+  return Status();
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
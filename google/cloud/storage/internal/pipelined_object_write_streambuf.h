@@ -0,0 +1,132 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_PIPELINED_OBJECT_WRITE_STREAMBUF_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_PIPELINED_OBJECT_WRITE_STREAMBUF_H
+
+#include "google/cloud/storage/internal/object_streambuf.h"
+#include "google/cloud/storage/version.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+/**
+ * An `ObjectWriteStreambuf` that uploads full buffers in a background thread.
+ *
+ * `ObjectWriteStreambuf` blocks the application while each chunk is uploaded,
+ * so the throughput is bounded by the chunk size divided by the round-trip
+ * time. This class hands full buffers to a background thread, and the
+ * application fills the next buffer while the previous chunk is uploaded. At
+ * most @p pipeline_depth full buffers are queued, writing to the stream blocks
+ * when the queue is full.
+ *
+ * The service requires each chunk to start at the next expected byte, so the
+ * background thread uploads the queued chunks one at a time and in order. If
+ * the service commits only part of a chunk the remaining bytes are uploaded
+ * before the next chunk.
+ */
+class PipelinedObjectWriteStreambuf : public ObjectWriteStreambuf {
+ public:
+  PipelinedObjectWriteStreambuf(
+      std::unique_ptr<ResumableUploadSession> upload_session,
+      std::size_t max_buffer_size,
+      std::unique_ptr<HashValidator> hash_validator,
+      std::size_t pipeline_depth);
+
+  ~PipelinedObjectWriteStreambuf() override;
+
+  StatusOr<ResumableUploadResponse> Close() override;
+  bool IsOpen() const override;
+  bool ValidateHash(ObjectMetadata const& meta) override;
+
+  std::string const& received_hash() const override {
+    return hash_validator_result_.received;
+  }
+  std::string const& computed_hash() const override {
+    return hash_validator_result_.computed;
+  }
+
+  /// Waits until all the queued chunks are uploaded.
+  std::string const& resumable_session_id() const override;
+
+  /// Waits until all the queued chunks are uploaded.
+  std::uint64_t next_expected_byte() const override;
+
+  Status last_status() const override;
+
+ protected:
+  int sync() override;
+  std::streamsize xsputn(char const* s, std::streamsize count) override;
+  int_type overflow(int_type ch) override;
+
+ private:
+  /// A full buffer waiting in the upload queue.
+  struct Chunk {
+    std::vector<char> buffer;
+    std::uint64_t offset;
+  };
+
+  /// Queue the put area for upload and start filling a different buffer.
+  Status SubmitBuffer();
+
+  /// Block until the background thread has uploaded all the queued chunks.
+  void Drain(std::unique_lock<std::mutex>& lk) const;
+
+  /// The body of the background thread.
+  void SenderLoop();
+
+  /// Upload one chunk, resending any bytes not committed by the service.
+  Status UploadChunk(Chunk const& chunk);
+
+  std::unique_ptr<ResumableUploadSession> upload_session_;
+  std::size_t max_buffer_size_;
+  std::size_t pipeline_depth_;
+  std::unique_ptr<HashValidator> hash_validator_;
+  HashValidator::Result hash_validator_result_;
+
+  // The buffer used as the put area, only used by the application thread.
+  std::vector<char> current_ios_buffer_;
+  // The offset of the put area within the object.
+  std::uint64_t current_offset_;
+
+  mutable std::mutex mu_;
+  mutable std::condition_variable cv_;
+  std::deque<Chunk> pending_;
+  std::vector<std::vector<char>> free_buffers_;
+  bool sending_ = false;
+  bool shutdown_ = false;
+  bool closed_ = false;
+  bool done_ = false;
+  Status status_;
+  StatusOr<ResumableUploadResponse> last_response_;
+  std::thread sender_;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_PIPELINED_OBJECT_WRITE_STREAMBUF_H
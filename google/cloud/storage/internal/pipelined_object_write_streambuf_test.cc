@@ -0,0 +1,293 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/pipelined_object_write_streambuf.h"
+#include "google/cloud/storage/internal/object_requests.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include "absl/memory/memory.h"
+#include <gmock/gmock.h>
+#include <future>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::testing::_;
+using ::testing::HasSubstr;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+auto const kQuantum = UploadChunkRequest::kChunkSizeQuantum;
+
+std::string MakePayload(std::size_t size) {
+  std::string payload;
+  for (std::size_t i = 0; i != size; ++i) {
+    payload.push_back(static_cast<char>('a' + i % 26));
+  }
+  return payload;
+}
+
+/// Simulates a session that commits all the data it receives.
+struct FakeSession {
+  std::mutex mu;
+  std::uint64_t next_byte = 0;
+  std::string received;
+
+  void Setup(testing::MockResumableUploadSession& mock) {
+    EXPECT_CALL(mock, done).WillRepeatedly(Return(false));
+    EXPECT_CALL(mock, next_expected_byte).WillRepeatedly(Invoke([this] {
+      std::lock_guard<std::mutex> lk(mu);
+      return next_byte;
+    }));
+  }
+
+  StatusOr<ResumableUploadResponse> Commit(ConstBufferSequence const& p,
+                                           std::size_t n) {
+    std::lock_guard<std::mutex> lk(mu);
+    received += ToString(p).substr(0, n);
+    next_byte += n;
+    return make_status_or(ResumableUploadResponse{
+        "", next_byte - 1, {}, ResumableUploadResponse::kInProgress, {}});
+  }
+};
+
+/// @test Verify that the chunks are uploaded in order.
+TEST(PipelinedObjectWriteStreambufTest, UploadsInOrder) {
+  auto mock = absl::make_unique<testing::MockResumableUploadSession>();
+  FakeSession session;
+  session.Setup(*mock);
+  std::string const payload = MakePayload(5 * kQuantum + 10);
+
+  EXPECT_CALL(*mock, UploadChunk)
+      .Times(5)
+      .WillRepeatedly(Invoke([&](ConstBufferSequence const& p) {
+        EXPECT_EQ(kQuantum, TotalBytes(p));
+        return session.Commit(p, TotalBytes(p));
+      }));
+  EXPECT_CALL(*mock, UploadFinalChunk)
+      .WillOnce(Invoke([&](ConstBufferSequence const& p, std::uint64_t s) {
+        EXPECT_EQ(payload.size(), s);
+        EXPECT_EQ(10, TotalBytes(p));
+        session.Commit(p, TotalBytes(p));
+        return make_status_or(ResumableUploadResponse{
+            "{}", s - 1, {}, ResumableUploadResponse::kDone, {}});
+      }));
+
+  PipelinedObjectWriteStreambuf streambuf(
+      std::move(mock), kQuantum, absl::make_unique<NullHashValidator>(), 2);
+  EXPECT_TRUE(streambuf.IsOpen());
+  EXPECT_EQ(payload.size(), streambuf.sputn(payload.data(), payload.size()));
+  auto response = streambuf.Close();
+  ASSERT_STATUS_OK(response);
+  EXPECT_FALSE(streambuf.IsOpen());
+  EXPECT_EQ(payload, session.received);
+}
+
+/// @test Verify that the application fills buffers while a chunk is uploaded.
+TEST(PipelinedObjectWriteStreambufTest, WritesWhileUploading) {
+  auto mock = absl::make_unique<testing::MockResumableUploadSession>();
+  FakeSession session;
+  session.Setup(*mock);
+  std::string const payload = MakePayload(2 * kQuantum + 10);
+
+  std::promise<void> first_upload;
+  auto wait = first_upload.get_future().share();
+  EXPECT_CALL(*mock, UploadChunk)
+      .Times(2)
+      .WillRepeatedly(Invoke([&](ConstBufferSequence const& p) {
+        // Block until the application has written all the data.
+        wait.get();
+        return session.Commit(p, TotalBytes(p));
+      }));
+  EXPECT_CALL(*mock, UploadFinalChunk)
+      .WillOnce(Invoke([&](ConstBufferSequence const& p, std::uint64_t s) {
+        EXPECT_EQ(payload.size(), s);
+        EXPECT_EQ(10, TotalBytes(p));
+        session.Commit(p, TotalBytes(p));
+        return make_status_or(ResumableUploadResponse{
+            "{}", s - 1, {}, ResumableUploadResponse::kDone, {}});
+      }));
+
+  PipelinedObjectWriteStreambuf streambuf(
+      std::move(mock), kQuantum, absl::make_unique<NullHashValidator>(), 2);
+  // With a pipeline depth of 2 the first chunk is uploading, the second chunk
+  // is queued, and the application fills the third buffer without blocking.
+  EXPECT_EQ(payload.size(), streambuf.sputn(payload.data(), payload.size()));
+  first_upload.set_value();
+  ASSERT_STATUS_OK(streambuf.Close());
+  EXPECT_EQ(payload, session.received);
+}
+
+/// @test Verify that bytes not committed by the service are uploaded again.
+TEST(PipelinedObjectWriteStreambufTest, SomeBytesNotAccepted) {
+  auto mock = absl::make_unique<testing::MockResumableUploadSession>();
+  FakeSession session;
+  session.Setup(*mock);
+  std::string const payload = MakePayload(4 * kQuantum);
+
+  ::testing::InSequence sequence;
+  EXPECT_CALL(*mock, UploadChunk)
+      .WillOnce(Invoke([&](ConstBufferSequence const& p) {
+        EXPECT_EQ(2 * kQuantum, TotalBytes(p));
+        return session.Commit(p, kQuantum);
+      }))
+      .WillOnce(Invoke([&](ConstBufferSequence const& p) {
+        EXPECT_EQ(payload.substr(kQuantum, kQuantum), ToString(p));
+        return session.Commit(p, TotalBytes(p));
+      }))
+      .WillOnce(Invoke([&](ConstBufferSequence const& p) {
+        EXPECT_EQ(payload.substr(2 * kQuantum), ToString(p));
+        return session.Commit(p, TotalBytes(p));
+      }));
+  EXPECT_CALL(*mock, UploadFinalChunk)
+      .WillOnce(Invoke([&](ConstBufferSequence const&, std::uint64_t s) {
+        EXPECT_EQ(payload.size(), s);
+        return make_status_or(ResumableUploadResponse{
+            "{}", s - 1, {}, ResumableUploadResponse::kDone, {}});
+      }));
+
+  PipelinedObjectWriteStreambuf streambuf(
+      std::move(mock), 2 * kQuantum, absl::make_unique<NullHashValidator>(),
+      1);
+  EXPECT_EQ(payload.size(), streambuf.sputn(payload.data(), payload.size()));
+  ASSERT_STATUS_OK(streambuf.Close());
+  EXPECT_EQ(payload, session.received);
+}
+
+/// @test Verify that next_expected_byte() waits for the queued chunks.
+TEST(PipelinedObjectWriteStreambufTest, NextExpectedByteWaitsForUploads) {
+  auto mock = absl::make_unique<testing::MockResumableUploadSession>();
+  FakeSession session;
+  session.Setup(*mock);
+  std::string const payload = MakePayload(3 * kQuantum + 10);
+  std::string const session_id = "test-upload-id";
+
+  EXPECT_CALL(*mock, UploadChunk)
+      .Times(3)
+      .WillRepeatedly(Invoke([&](ConstBufferSequence const& p) {
+        return session.Commit(p, TotalBytes(p));
+      }));
+  EXPECT_CALL(*mock, session_id).WillRepeatedly(ReturnRef(session_id));
+
+  PipelinedObjectWriteStreambuf streambuf(
+      std::move(mock), kQuantum, absl::make_unique<NullHashValidator>(), 4);
+  EXPECT_EQ(payload.size(), streambuf.sputn(payload.data(), payload.size()));
+  EXPECT_EQ(3 * kQuantum, streambuf.next_expected_byte());
+  EXPECT_EQ(session_id, streambuf.resumable_session_id());
+  EXPECT_EQ(payload.substr(0, 3 * kQuantum), session.received);
+}
+
+/// @test Verify that a stream resumes at the session's next expected byte.
+TEST(PipelinedObjectWriteStreambufTest, ResumedUpload) {
+  auto mock = absl::make_unique<testing::MockResumableUploadSession>();
+  FakeSession session;
+  session.next_byte = 4 * kQuantum;
+  session.Setup(*mock);
+  std::string const payload = MakePayload(kQuantum + 10);
+
+  EXPECT_CALL(*mock, UploadChunk)
+      .WillOnce(Invoke([&](ConstBufferSequence const& p) {
+        return session.Commit(p, TotalBytes(p));
+      }));
+  EXPECT_CALL(*mock, UploadFinalChunk)
+      .WillOnce(Invoke([&](ConstBufferSequence const& p, std::uint64_t s) {
+        EXPECT_EQ(5 * kQuantum + 10, s);
+        EXPECT_EQ(10, TotalBytes(p));
+        return make_status_or(ResumableUploadResponse{
+            "{}", s - 1, {}, ResumableUploadResponse::kDone, {}});
+      }));
+
+  PipelinedObjectWriteStreambuf streambuf(
+      std::move(mock), kQuantum, absl::make_unique<NullHashValidator>(), 2);
+  EXPECT_EQ(payload.size(), streambuf.sputn(payload.data(), payload.size()));
+  ASSERT_STATUS_OK(streambuf.Close());
+}
+
+/// @test Verify that upload errors are reported to the application.
+TEST(PipelinedObjectWriteStreambufTest, ErrorInUpload) {
+  auto mock = absl::make_unique<testing::MockResumableUploadSession>();
+  FakeSession session;
+  session.Setup(*mock);
+  std::string const payload = MakePayload(4 * kQuantum);
+
+  EXPECT_CALL(*mock, UploadChunk).WillOnce(Return(PermanentError()));
+  EXPECT_CALL(*mock, UploadFinalChunk).Times(0);
+
+  PipelinedObjectWriteStreambuf streambuf(
+      std::move(mock), kQuantum, absl::make_unique<NullHashValidator>(), 2);
+  streambuf.sputn(payload.data(), payload.size());
+  auto response = streambuf.Close();
+  EXPECT_EQ(PermanentError().code(), response.status().code());
+  EXPECT_EQ(PermanentError().code(), streambuf.last_status().code());
+  EXPECT_FALSE(streambuf.IsOpen());
+
+  // Once the stream has an error all writes fail.
+  EXPECT_EQ(-1, streambuf.sputn(payload.data(), payload.size()));
+  EXPECT_EQ(0, streambuf.next_expected_byte());
+}
+
+/// @test Verify that unexpected jumps in the next expected byte are errors.
+TEST(PipelinedObjectWriteStreambufTest, NextExpectedByteJumpsAhead) {
+  auto mock = absl::make_unique<testing::MockResumableUploadSession>();
+  FakeSession session;
+  session.Setup(*mock);
+  std::string const payload = MakePayload(kQuantum);
+
+  EXPECT_CALL(*mock, UploadChunk)
+      .WillOnce(Invoke([&](ConstBufferSequence const& p) {
+        return session.Commit(p, 2 * kQuantum);
+      }));
+  EXPECT_CALL(*mock, UploadFinalChunk).Times(0);
+
+  PipelinedObjectWriteStreambuf streambuf(
+      std::move(mock), kQuantum, absl::make_unique<NullHashValidator>(), 2);
+  streambuf.sputn(payload.data(), payload.size());
+  auto response = streambuf.Close();
+  EXPECT_EQ(StatusCode::kAborted, response.status().code());
+  EXPECT_THAT(response.status().message(), HasSubstr("unexpected byte"));
+}
+
+/// @test Verify that a stream created for a finished upload starts out as
+/// closed.
+TEST(PipelinedObjectWriteStreambufTest, CreatedForFinalizedUpload) {
+  auto mock = absl::make_unique<testing::MockResumableUploadSession>();
+  EXPECT_CALL(*mock, done).WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock, next_expected_byte).WillRepeatedly(Return(0));
+  auto last_upload_response = make_status_or(ResumableUploadResponse{
+      "url-for-test", 0, {}, ResumableUploadResponse::kDone, {}});
+  EXPECT_CALL(*mock, last_response).WillOnce(ReturnRef(last_upload_response));
+  EXPECT_CALL(*mock, UploadFinalChunk(_, _)).Times(0);
+
+  PipelinedObjectWriteStreambuf streambuf(
+      std::move(mock), kQuantum, absl::make_unique<NullHashValidator>(), 2);
+  EXPECT_FALSE(streambuf.IsOpen());
+  auto response = streambuf.Close();
+  ASSERT_STATUS_OK(response);
+  EXPECT_EQ("url-for-test", response->upload_session_url);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,161 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_PREFETCHING_PAGE_LOADER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_PREFETCHING_PAGE_LOADER_H
+
+#include "google/cloud/storage/version.h"
+#include "google/cloud/status_or.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+/**
+ * Wraps the page loader of a `PaginationRange` to fetch pages in advance.
+ *
+ * `PaginationRange` calls its loader only when the application has consumed
+ * all the items in the current page, so listing a large collection pays one
+ * round-trip per page. This class uses a background thread to request up to
+ * @p depth pages ahead of the application.
+ *
+ * Each page request requires the token returned with the previous page, so the
+ * background thread still fetches the pages one at a time. The prefetched
+ * pages are returned if the caller requests them in order, any other request
+ * discards them and restarts the prefetching from the new request.
+ *
+ * The background thread stops after the last page, or after an error. The
+ * class is copyable so it can be stored in a `std::function`, all the copies
+ * share the same background thread.
+ *
+ * @tparam Request the request type, must have `page_token()` and
+ *     `set_page_token()` members.
+ * @tparam Response the response type, must have a `next_page_token` member.
+ */
+template <typename Request, typename Response>
+class PrefetchingPageLoader {
+ public:
+  using Loader = std::function<StatusOr<Response>(Request const&)>;
+
+  PrefetchingPageLoader(Loader loader, std::size_t depth)
+      : state_(std::make_shared<State>(std::move(loader), depth)) {}
+
+  StatusOr<Response> operator()(Request const& request) {
+    return state_->Next(request);
+  }
+
+ private:
+  class State {
+   public:
+    State(Loader loader, std::size_t depth)
+        : loader_(std::move(loader)), depth_(depth == 0 ? 1 : depth) {}
+
+    ~State() {
+      {
+        std::lock_guard<std::mutex> lk(mu_);
+        shutdown_ = true;
+      }
+      cv_.notify_all();
+      // A request in progress is completed before the thread exits.
+      if (worker_.joinable()) worker_.join();
+    }
+
+    StatusOr<Response> Next(Request const& request) {
+      std::unique_lock<std::mutex> lk(mu_);
+      if (!started_ || request.page_token() != expected_token_ ||
+          (ready_.empty() && !active_)) {
+        Restart(request);
+      }
+      cv_.wait(lk, [this] { return !ready_.empty(); });
+      auto response = std::move(ready_.front());
+      ready_.pop_front();
+      expected_token_ = response ? response->next_page_token : std::string{};
+      lk.unlock();
+      cv_.notify_all();
+      return response;
+    }
+
+   private:
+    void Restart(Request const& request) {
+      ++generation_;
+      ready_.clear();
+      next_request_ = request;
+      active_ = true;
+      started_ = true;
+      if (!worker_.joinable()) {
+        worker_ = std::thread([this] { WorkerLoop(); });
+      }
+      cv_.notify_all();
+    }
+
+    void WorkerLoop() {
+      std::unique_lock<std::mutex> lk(mu_);
+      for (;;) {
+        cv_.wait(lk, [this] {
+          return shutdown_ || (active_ && ready_.size() < depth_);
+        });
+        if (shutdown_) return;
+        auto request = next_request_;
+        auto const generation = generation_;
+        lk.unlock();
+        auto response = loader_(request);
+        lk.lock();
+        // The caller restarted the listing while this page was in flight.
+        if (generation != generation_) continue;
+        if (!response || response->next_page_token.empty()) {
+          active_ = false;
+        } else {
+          next_request_.set_page_token(response->next_page_token);
+        }
+        ready_.push_back(std::move(response));
+        cv_.notify_all();
+      }
+    }
+
+    Loader loader_;
+    std::size_t depth_;
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<StatusOr<Response>> ready_;
+    Request next_request_;
+    std::string expected_token_;
+    std::uint64_t generation_ = 0;
+    bool started_ = false;
+    bool active_ = false;
+    bool shutdown_ = false;
+    std::thread worker_;
+  };
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_PREFETCHING_PAGE_LOADER_H
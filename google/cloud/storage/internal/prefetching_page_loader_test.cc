@@ -0,0 +1,172 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/prefetching_page_loader.h"
+#include "google/cloud/storage/list_objects_reader.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+using Loader =
+    PrefetchingPageLoader<ListObjectsRequest, ListObjectsResponse>;
+
+ObjectMetadata CreateElement(int index) {
+  nl::json metadata{
+      {"bucket", "test-bucket"},
+      {"name", "object-" + std::to_string(index)},
+      {"kind", "storage#object"},
+  };
+  return ObjectMetadataParser::FromJson(metadata).value();
+}
+
+/// A fake service returning @p page_count pages, with two objects each.
+class FakeService {
+ public:
+  explicit FakeService(int page_count, int error_page = -1)
+      : page_count_(page_count), error_page_(error_page) {}
+
+  StatusOr<ListObjectsResponse> operator()(ListObjectsRequest const& r) {
+    int page = r.page_token().empty() ? 0 : std::stoi(r.page_token());
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      tokens_.push_back(r.page_token());
+    }
+    cv_.notify_all();
+    if (page == error_page_) return PermanentError();
+    ListObjectsResponse response;
+    if (page + 1 < page_count_) {
+      response.next_page_token = std::to_string(page + 1);
+    }
+    response.items.push_back(CreateElement(2 * page));
+    response.items.push_back(CreateElement(2 * page + 1));
+    return response;
+  }
+
+  bool WaitForCalls(std::size_t count) {
+    std::unique_lock<std::mutex> lk(mu_);
+    return cv_.wait_for(lk, std::chrono::seconds(5),
+                        [&] { return tokens_.size() >= count; });
+  }
+
+  std::vector<std::string> tokens() {
+    std::lock_guard<std::mutex> lk(mu_);
+    return tokens_;
+  }
+
+ private:
+  int page_count_;
+  int error_page_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::vector<std::string> tokens_;
+};
+
+std::vector<std::string> Names(std::vector<ObjectMetadata> const& items) {
+  std::vector<std::string> names;
+  for (auto const& o : items) names.push_back(o.name());
+  return names;
+}
+
+TEST(PrefetchingPageLoaderTest, ReturnsAllPagesInOrder) {
+  auto service = std::make_shared<FakeService>(5);
+  ListObjectsReader reader(
+      ListObjectsRequest("test-bucket"),
+      Loader([service](ListObjectsRequest const& r) { return (*service)(r); },
+             2));
+  std::vector<std::string> actual;
+  std::vector<std::string> expected;
+  for (int i = 0; i != 10; ++i) expected.push_back(CreateElement(i).name());
+  for (auto& o : reader) {
+    ASSERT_STATUS_OK(o);
+    actual.push_back(o->name());
+  }
+  EXPECT_THAT(actual, ElementsAreArray(expected));
+  EXPECT_THAT(service->tokens(), ElementsAre("", "1", "2", "3", "4"));
+}
+
+TEST(PrefetchingPageLoaderTest, FetchesAhead) {
+  auto service = std::make_shared<FakeService>(10);
+  Loader loader(
+      [service](ListObjectsRequest const& r) { return (*service)(r); }, 2);
+  auto page = loader(ListObjectsRequest("test-bucket"));
+  ASSERT_STATUS_OK(page);
+  EXPECT_THAT(Names(page->items), ElementsAre("object-0", "object-1"));
+
+  // Without any further calls the loader fetches the next two pages.
+  ASSERT_TRUE(service->WaitForCalls(3));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_THAT(service->tokens(), ElementsAre("", "1", "2"));
+
+  page = loader(ListObjectsRequest("test-bucket").set_page_token("1"));
+  ASSERT_STATUS_OK(page);
+  EXPECT_THAT(Names(page->items), ElementsAre("object-2", "object-3"));
+  ASSERT_TRUE(service->WaitForCalls(4));
+}
+
+TEST(PrefetchingPageLoaderTest, RestartOnUnexpectedToken) {
+  auto service = std::make_shared<FakeService>(10);
+  Loader loader(
+      [service](ListObjectsRequest const& r) { return (*service)(r); }, 1);
+  auto page = loader(ListObjectsRequest("test-bucket"));
+  ASSERT_STATUS_OK(page);
+  EXPECT_EQ("1", page->next_page_token);
+
+  page = loader(ListObjectsRequest("test-bucket").set_page_token("7"));
+  ASSERT_STATUS_OK(page);
+  EXPECT_THAT(Names(page->items), ElementsAre("object-14", "object-15"));
+  EXPECT_EQ("8", page->next_page_token);
+}
+
+TEST(PrefetchingPageLoaderTest, StopsAfterError) {
+  auto service = std::make_shared<FakeService>(5, 1);
+  ListObjectsReader reader(
+      ListObjectsRequest("test-bucket"),
+      Loader([service](ListObjectsRequest const& r) { return (*service)(r); },
+             3));
+  std::vector<std::string> names;
+  Status status;
+  for (auto& o : reader) {
+    if (!o) {
+      status = std::move(o).status();
+      break;
+    }
+    names.push_back(o->name());
+  }
+  EXPECT_THAT(names, ElementsAre("object-0", "object-1"));
+  EXPECT_EQ(PermanentError().code(), status.code());
+  EXPECT_THAT(service->tokens(), ElementsAre("", "1"));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
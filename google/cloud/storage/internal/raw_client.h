@@ -17,6 +17,8 @@
 
 #include "google/cloud/storage/bucket_metadata.h"
 #include "google/cloud/storage/client_options.h"
+#include "google/cloud/storage/connection_pool_stats.h"
+#include "google/cloud/storage/internal/batch_requests.h"
 #include "google/cloud/storage/internal/bucket_acl_requests.h"
 #include "google/cloud/storage/internal/bucket_requests.h"
 #include "google/cloud/storage/internal/default_object_acl_requests.h"
@@ -52,6 +54,24 @@ class RawClient {
 
   virtual ClientOptions const& client_options() const = 0;
 
+  /**
+   * The size of the buffers for new uploads.
+   *
+   * Clients that tune the transfers override this function, by default it
+   * returns `client_options().upload_buffer_size()`.
+   */
+  virtual std::size_t upload_buffer_size() const {
+    return client_options().upload_buffer_size();
+  }
+
+  /**
+   * The counters for the connections used by this client.
+   *
+   * Clients that pool connections override this function, by default all the
+   * counters are zero.
+   */
+  virtual ConnectionPoolStats connection_pool_stats() const { return {}; }
+
   //@{
   /// @name Bucket resource operations
   virtual StatusOr<ListBucketsResponse> ListBuckets(
@@ -175,6 +195,11 @@ class RawClient {
   virtual StatusOr<EmptyResponse> DeleteNotification(
       DeleteNotificationRequest const&) = 0;
   //@}
+
+  //@{
+  /// @name Batch operations
+  virtual StatusOr<BatchResponse> ExecuteBatch(BatchRequest const&) = 0;
+  //@}
 };
 
 }  // namespace internal
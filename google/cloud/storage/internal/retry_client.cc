@@ -17,6 +17,8 @@
 #include "google/cloud/storage/internal/retry_object_read_source.h"
 #include "google/cloud/storage/internal/retry_resumable_upload_session.h"
 #include "absl/memory/memory.h"
+#include <algorithm>
+#include <numeric>
 #include <sstream>
 #include <thread>
 
@@ -125,6 +127,14 @@ ClientOptions const& RetryClient::client_options() const {
   return client_->client_options();
 }
 
+std::size_t RetryClient::upload_buffer_size() const {
+  return client_->upload_buffer_size();
+}
+
+ConnectionPoolStats RetryClient::connection_pool_stats() const {
+  return client_->connection_pool_stats();
+}
+
 StatusOr<ListBucketsResponse> RetryClient::ListBuckets(
     ListBucketsRequest const& request) {
   auto retry_policy = retry_policy_prototype_->clone();
@@ -625,6 +635,78 @@ StatusOr<EmptyResponse> RetryClient::DeleteNotification(
                   &RawClient::DeleteNotification, request, __func__);
 }
 
+StatusOr<BatchResponse> RetryClient::ExecuteBatch(
+    BatchRequest const& request) {
+  auto retry_policy = retry_policy_prototype_->clone();
+  auto backoff_policy = backoff_policy_prototype_->clone();
+  auto const& parts = request.parts();
+  auto is_idempotent = [&](std::size_t i) {
+    return parts[i].is_idempotent(*idempotency_policy_);
+  };
+
+  // Each sub-request succeeds or fails independently. After each attempt only
+  // the sub-requests that failed with a transient error are sent again, in a
+  // smaller batch.
+  BatchResponse result;
+  result.responses.resize(parts.size());
+  bool has_responses = false;
+  std::vector<std::size_t> pending(parts.size());
+  std::iota(pending.begin(), pending.end(), std::size_t{0});
+  Status last_status(StatusCode::kDeadlineExceeded,
+                     "Retry policy exhausted before first attempt was made.");
+  auto error = [&last_status](std::string const& msg) {
+    return Status(last_status.code(), msg);
+  };
+
+  while (!retry_policy->IsExhausted()) {
+    BatchRequest attempt;
+    for (auto i : pending) attempt.AddPart(parts[i]);
+    auto response = client_->ExecuteBatch(attempt);
+    std::vector<std::size_t> retry;
+    if (!response) {
+      last_status = std::move(response).status();
+      if (!std::all_of(pending.begin(), pending.end(), is_idempotent)) {
+        std::ostringstream os;
+        os << "Error in non-idempotent operation " << __func__ << ": "
+           << last_status;
+        return error(std::move(os).str());
+      }
+      retry = pending;
+    } else {
+      has_responses = true;
+      for (std::size_t k = 0; k != pending.size(); ++k) {
+        auto const i = pending[k];
+        auto status = AsStatus(response->responses[k]);
+        auto const transient =
+            !status.ok() && !internal::StatusTraits::IsPermanentFailure(status);
+        if (transient && is_idempotent(i)) {
+          retry.push_back(i);
+          last_status = std::move(status);
+        }
+        result.responses[i] = std::move(response->responses[k]);
+      }
+      if (retry.empty()) return result;
+    }
+    pending = std::move(retry);
+    if (!retry_policy->OnFailure(last_status)) {
+      if (!has_responses &&
+          internal::StatusTraits::IsPermanentFailure(last_status)) {
+        std::ostringstream os;
+        os << "Permanent error in " << __func__ << ": " << last_status;
+        return error(std::move(os).str());
+      }
+      break;
+    }
+    auto delay = backoff_policy->OnCompletion();
+    std::this_thread::sleep_for(delay);
+  }
+  // The sub-requests that could not be retried keep their last response.
+  if (has_responses) return result;
+  std::ostringstream os;
+  os << "Retry policy exhausted in " << __func__ << ": " << last_status;
+  return error(std::move(os).str());
+}
+
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
@@ -48,6 +48,8 @@ class RetryClient : public RawClient,
   ~RetryClient() override = default;
 
   ClientOptions const& client_options() const override;
+  std::size_t upload_buffer_size() const override;
+  ConnectionPoolStats connection_pool_stats() const override;
 
   StatusOr<ListBucketsResponse> ListBuckets(
       ListBucketsRequest const& request) override;
@@ -160,6 +162,8 @@ class RetryClient : public RawClient,
   StatusOr<EmptyResponse> DeleteNotification(
       DeleteNotificationRequest const&) override;
 
+  StatusOr<BatchResponse> ExecuteBatch(BatchRequest const& request) override;
+
   std::shared_ptr<RawClient> client() const { return client_; }
 
  private:
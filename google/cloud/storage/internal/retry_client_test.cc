@@ -15,6 +15,7 @@
 #include "google/cloud/storage/internal/retry_client.h"
 #include "google/cloud/storage/testing/canonical_errors.h"
 #include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/testing_util/assert_ok.h"
 #include "google/cloud/testing_util/chrono_literals.h"
 #include <gmock/gmock.h>
 
@@ -30,6 +31,7 @@ using ::google::cloud::storage::testing::canonical_errors::PermanentError;
 using ::google::cloud::storage::testing::canonical_errors::TransientError;
 using ::testing::_;
 using ::testing::HasSubstr;
+using ::testing::Invoke;
 using ::testing::Return;
 
 class RetryClientTest : public ::testing::Test {
@@ -104,6 +106,94 @@ TEST_F(RetryClientTest, ExpiredRetryPolicy) {
               HasSubstr("Retry policy exhausted before first attempt"));
 }
 
+BatchResponse MockBatchResponse(std::vector<int> const& codes) {
+  BatchResponse response;
+  for (auto code : codes) response.responses.push_back({code, "", {}});
+  return response;
+}
+
+/// @test Verify that only the sub-requests with transient failures are retried.
+TEST_F(RetryClientTest, ExecuteBatchRetriesTransientParts) {
+  RetryClient client(std::shared_ptr<internal::RawClient>(mock_),
+                     LimitedErrorCountRetryPolicy(3),
+                     ExponentialBackoffPolicy(1_us, 2_us, 2));
+
+  BatchRequest batch;
+  batch.AddDeleteObject(DeleteObjectRequest("test-bucket", "o-0"));
+  batch.AddDeleteObject(DeleteObjectRequest("test-bucket", "o-1"));
+  batch.AddDeleteObject(DeleteObjectRequest("test-bucket", "o-2"));
+
+  EXPECT_CALL(*mock_, ExecuteBatch(_))
+      .WillOnce(Invoke([](BatchRequest const& r) {
+        EXPECT_EQ(3, r.size());
+        return make_status_or(MockBatchResponse({204, 503, 404}));
+      }))
+      .WillOnce(Return(StatusOr<BatchResponse>(TransientError())))
+      .WillOnce(Invoke([](BatchRequest const& r) {
+        EXPECT_EQ(1, r.size());
+        EXPECT_EQ("/b/test-bucket/o/o-1", r.parts().front().path);
+        return make_status_or(MockBatchResponse({204}));
+      }));
+
+  auto result = client.ExecuteBatch(batch);
+  ASSERT_STATUS_OK(result);
+  ASSERT_EQ(3, result->responses.size());
+  EXPECT_EQ(204, result->responses[0].status_code);
+  EXPECT_EQ(204, result->responses[1].status_code);
+  EXPECT_EQ(404, result->responses[2].status_code);
+}
+
+/// @test Verify that the last response is kept when the policy is exhausted.
+TEST_F(RetryClientTest, ExecuteBatchTooManyTransients) {
+  RetryClient client(std::shared_ptr<internal::RawClient>(mock_),
+                     LimitedErrorCountRetryPolicy(2),
+                     ExponentialBackoffPolicy(1_us, 2_us, 2));
+
+  BatchRequest batch;
+  batch.AddDeleteObject(DeleteObjectRequest("test-bucket", "o-0"));
+  batch.AddDeleteObject(DeleteObjectRequest("test-bucket", "o-1"));
+
+  EXPECT_CALL(*mock_, ExecuteBatch(_))
+      .WillOnce(Return(make_status_or(MockBatchResponse({204, 503}))))
+      .WillRepeatedly(Return(make_status_or(MockBatchResponse({503}))));
+
+  auto result = client.ExecuteBatch(batch);
+  ASSERT_STATUS_OK(result);
+  ASSERT_EQ(2, result->responses.size());
+  EXPECT_EQ(204, result->responses[0].status_code);
+  EXPECT_EQ(503, result->responses[1].status_code);
+}
+
+/// @test Verify that batches with non-idempotent parts are not retried.
+TEST_F(RetryClientTest, ExecuteBatchNonIdempotent) {
+  RetryClient client(std::shared_ptr<internal::RawClient>(mock_),
+                     LimitedErrorCountRetryPolicy(3), StrictIdempotencyPolicy(),
+                     ExponentialBackoffPolicy(1_us, 2_us, 2));
+
+  BatchRequest batch;
+  batch.AddDeleteObject(DeleteObjectRequest("test-bucket", "o-0"));
+  batch.AddDeleteObject(DeleteObjectRequest("test-bucket", "o-1")
+                            .set_multiple_options(IfGenerationMatch(7)));
+
+  EXPECT_CALL(*mock_, ExecuteBatch(_))
+      .WillOnce(Return(StatusOr<BatchResponse>(TransientError())));
+  auto failed = client.ExecuteBatch(batch);
+  EXPECT_EQ(TransientError().code(), failed.status().code());
+  EXPECT_THAT(failed.status().message(), HasSubstr("non-idempotent"));
+
+  // Only the idempotent part is retried after a transient failure.
+  EXPECT_CALL(*mock_, ExecuteBatch(_))
+      .WillOnce(Return(make_status_or(MockBatchResponse({503, 503}))))
+      .WillOnce(Invoke([](BatchRequest const& r) {
+        EXPECT_EQ(1, r.size());
+        return make_status_or(MockBatchResponse({204}));
+      }));
+  auto result = client.ExecuteBatch(batch);
+  ASSERT_STATUS_OK(result);
+  EXPECT_EQ(503, result->responses[0].status_code);
+  EXPECT_EQ(204, result->responses[1].status_code);
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
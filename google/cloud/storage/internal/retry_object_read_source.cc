@@ -22,6 +22,16 @@ namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace internal {
 
+namespace {
+std::size_t BytesReceived(ReadSourceResult const& r) {
+  return r.bytes_received;
+}
+
+std::size_t BytesReceived(BorrowedReadSourceResult const& r) {
+  return r.data.size();
+}
+}  // namespace
+
 std::size_t InitialOffset(OffsetDirection const& offset_direction,
                           ReadObjectRangeRequest const& request) {
   if (offset_direction == kFromEnd) {
@@ -44,14 +54,15 @@ RetryObjectReadSource::RetryObjectReadSource(
                                                        : kFromBeginning),
       current_offset_(InitialOffset(offset_direction_, request_)) {}
 
-StatusOr<ReadSourceResult> RetryObjectReadSource::Read(char* buf,
-                                                       std::size_t n) {
-  GCP_LOG(INFO) << __func__ << "() current_offset=" << current_offset_;
+template <typename Result, typename ReadFunction>
+StatusOr<Result> RetryObjectReadSource::ReadWithRetry(
+    char const* where, ReadFunction const& read) {
+  GCP_LOG(INFO) << where << "() current_offset=" << current_offset_;
   if (!child_) {
     return Status(StatusCode::kFailedPrecondition, "Stream is not open");
   }
   // Refactor code to handle a successful read so we can return early.
-  auto handle_result = [this](StatusOr<ReadSourceResult> const& r) {
+  auto handle_result = [this](StatusOr<Result> const& r) {
     if (!r) {
       return false;
     }
@@ -59,15 +70,16 @@ StatusOr<ReadSourceResult> RetryObjectReadSource::Read(char* buf,
     if (g != r->response.headers.end()) {
       generation_ = std::stoll(g->second);
     }
+    auto const bytes_received = static_cast<std::int64_t>(BytesReceived(*r));
     if (offset_direction_ == kFromEnd) {
-      current_offset_ -= r->bytes_received;
+      current_offset_ -= bytes_received;
     } else {
-      current_offset_ += r->bytes_received;
+      current_offset_ += bytes_received;
     }
     return true;
   };
   // Read some data, if successful return immediately, saving some allocations.
-  auto result = child_->Read(buf, n);
+  auto result = read(*child_);
   if (handle_result(result)) {
     return result;
   }
@@ -85,7 +97,7 @@ StatusOr<ReadSourceResult> RetryObjectReadSource::Read(char* buf,
   int counter = 0;
   for (; !result && retry_policy->OnFailure(result.status());
        std::this_thread::sleep_for(backoff_policy->OnCompletion()),
-       result = child_->Read(buf, n)) {
+       result = read(*child_)) {
     // A Read() request failed, most likely that means the connection failed or
     // stalled. The current child might no longer be usable, so we will try to
     // create a new one and replace it. Should that fail, the retry policy would
@@ -122,13 +134,40 @@ StatusOr<ReadSourceResult> RetryObjectReadSource::Read(char* buf,
   auto status = std::move(result).status();
   std::stringstream os;
   if (internal::StatusTraits::IsPermanentFailure(status)) {
-    os << "Permanent error in Read(): " << status;
+    os << "Permanent error in " << where << "(): " << status;
   } else {
-    os << "Retry policy exhausted in Read(): " << status;
+    os << "Retry policy exhausted in " << where << "(): " << status;
   }
   return Status(status.code(), os.str());
 }
 
+StatusOr<ReadSourceResult> RetryObjectReadSource::Read(char* buf,
+                                                       std::size_t n) {
+  return ReadWithRetry<ReadSourceResult>(
+      __func__,
+      [buf, n](ObjectReadSource& child) { return child.Read(buf, n); });
+}
+
+StatusOr<BorrowedReadSourceResult> RetryObjectReadSource::ReadBorrowed() {
+  return ReadWithRetry<BorrowedReadSourceResult>(
+      __func__, [this](ObjectReadSource& child) {
+        if (child.CanReadBorrowed()) return child.ReadBorrowed();
+        return ReadIntoBuffer(child);
+      });
+}
+
+StatusOr<BorrowedReadSourceResult> RetryObjectReadSource::ReadIntoBuffer(
+    ObjectReadSource& child) {
+  if (buffer_.empty()) {
+    buffer_.resize(client_->client_options().download_buffer_size());
+  }
+  auto result = child.Read(buffer_.data(), buffer_.size());
+  if (!result) return std::move(result).status();
+  return BorrowedReadSourceResult{
+      ConstBuffer(buffer_.data(), result->bytes_received),
+      std::move(result->response)};
+}
+
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
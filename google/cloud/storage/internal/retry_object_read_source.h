@@ -18,6 +18,7 @@
 #include "google/cloud/storage/internal/object_read_source.h"
 #include "google/cloud/storage/internal/retry_client.h"
 #include "google/cloud/storage/version.h"
+#include <vector>
 
 namespace google {
 namespace cloud {
@@ -46,8 +47,24 @@ class RetryObjectReadSource : public ObjectReadSource {
   bool IsOpen() const override { return child_ && child_->IsOpen(); }
   StatusOr<HttpResponse> Close() override { return child_->Close(); }
   StatusOr<ReadSourceResult> Read(char* buf, std::size_t n) override;
+  bool CanReadBorrowed() const override {
+    return child_ && child_->CanReadBorrowed();
+  }
+  StatusOr<BorrowedReadSourceResult> ReadBorrowed() override;
 
  private:
+  /// Calls @p read on the child, and on new children if it fails.
+  template <typename Result, typename ReadFunction>
+  StatusOr<Result> ReadWithRetry(char const* where, ReadFunction const& read);
+
+  /**
+   * Implements `ReadBorrowed()` for children that cannot lend their buffers.
+   *
+   * A retry may create a child that does not support borrowed reads, e.g.,
+   * when a `HybridClient` routes the new download to a different transport.
+   */
+  StatusOr<BorrowedReadSourceResult> ReadIntoBuffer(ObjectReadSource& child);
+
   std::shared_ptr<RetryClient> client_;
   ReadObjectRangeRequest request_;
   std::unique_ptr<ObjectReadSource> child_;
@@ -56,6 +73,7 @@ class RetryObjectReadSource : public ObjectReadSource {
   std::unique_ptr<BackoffPolicy const> backoff_policy_prototype_;
   OffsetDirection offset_direction_;
   std::int64_t current_offset_;
+  std::vector<char> buffer_;
 };
 
 }  // namespace internal
@@ -20,6 +20,7 @@
 #include "google/cloud/testing_util/assert_ok.h"
 #include "google/cloud/testing_util/chrono_literals.h"
 #include <gmock/gmock.h>
+#include <algorithm>
 
 namespace google {
 namespace cloud {
@@ -33,6 +34,7 @@ using ::testing::HasSubstr;
 using ::testing::Invoke;
 using testing::MockObjectReadSource;
 using ::testing::Return;
+using ::testing::ReturnRef;
 using ::google::cloud::testing_util::chrono_literals::operator"" _us;
 using ::google::cloud::storage::testing::canonical_errors::PermanentError;
 using ::google::cloud::storage::testing::canonical_errors::TransientError;
@@ -311,6 +313,102 @@ TEST(RetryObjectReadSourceTest, TransientFailureWithReadLastOption) {
   auto res = (*source)->Read(nullptr, 1024);
   ASSERT_TRUE(res);
 }
+
+/// @test Borrowed reads resume from the right offset after a failure.
+TEST(RetryObjectReadSourceTest, ReadBorrowedTransientFailure) {
+  auto raw_client = std::make_shared<testing::MockClient>();
+  auto raw_source1 = new MockObjectReadSource;
+  auto raw_source2 = new MockObjectReadSource;
+  auto client = std::make_shared<RetryClient>(
+      std::shared_ptr<internal::RawClient>(raw_client),
+      LimitedErrorCountRetryPolicy(3), StrictIdempotencyPolicy(),
+      ExponentialBackoffPolicy(1_us, 2_us, 2));
+
+  EXPECT_CALL(*raw_client, ReadObject(_))
+      .WillOnce(Invoke([raw_source1](ReadObjectRangeRequest const& req) {
+        EXPECT_FALSE(req.HasOption<ReadFromOffset>());
+        return std::unique_ptr<ObjectReadSource>(raw_source1);
+      }))
+      .WillOnce(Invoke([raw_source2](ReadObjectRangeRequest const& req) {
+        EXPECT_EQ(1024, req.GetOption<ReadFromOffset>().value());
+        return std::unique_ptr<ObjectReadSource>(raw_source2);
+      }));
+
+  std::string const data(1024, 'A');
+  EXPECT_CALL(*raw_source1, CanReadBorrowed).WillRepeatedly(Return(true));
+  EXPECT_CALL(*raw_source1, ReadBorrowed)
+      .WillOnce(Return(BorrowedReadSourceResult{
+          ConstBuffer(data.data(), data.size()), HttpResponse{100, "", {}}}))
+      .WillOnce(Return(TransientError()));
+  EXPECT_CALL(*raw_source2, CanReadBorrowed).WillRepeatedly(Return(true));
+  EXPECT_CALL(*raw_source2, ReadBorrowed)
+      .WillOnce(Return(
+          BorrowedReadSourceResult{ConstBuffer{}, HttpResponse{200, "", {}}}));
+
+  auto source = client->ReadObject(ReadObjectRangeRequest{});
+  ASSERT_STATUS_OK(source);
+  EXPECT_TRUE((*source)->CanReadBorrowed());
+  auto res = (*source)->ReadBorrowed();
+  ASSERT_STATUS_OK(res);
+  EXPECT_EQ(data.size(), res->data.size());
+  res = (*source)->ReadBorrowed();
+  ASSERT_STATUS_OK(res);
+  EXPECT_TRUE(res->data.empty());
+}
+
+/// @test Borrowed reads continue if the retry creates a non-borrowing child.
+TEST(RetryObjectReadSourceTest, ReadBorrowedRetryWithoutBorrowing) {
+  auto raw_client = std::make_shared<testing::MockClient>();
+  auto raw_source1 = new MockObjectReadSource;
+  auto raw_source2 = new MockObjectReadSource;
+  auto client = std::make_shared<RetryClient>(
+      std::shared_ptr<internal::RawClient>(raw_client),
+      LimitedErrorCountRetryPolicy(3), StrictIdempotencyPolicy(),
+      ExponentialBackoffPolicy(1_us, 2_us, 2));
+
+  auto const options = ClientOptions(oauth2::CreateAnonymousCredentials());
+  EXPECT_CALL(*raw_client, client_options).WillRepeatedly(ReturnRef(options));
+  // Simulate a `HybridClient` that routes the retry to a different transport,
+  // with a source that only implements `Read()`.
+  EXPECT_CALL(*raw_client, ReadObject(_))
+      .WillOnce(Invoke([raw_source1](ReadObjectRangeRequest const&) {
+        return std::unique_ptr<ObjectReadSource>(raw_source1);
+      }))
+      .WillOnce(Invoke([raw_source2](ReadObjectRangeRequest const& req) {
+        EXPECT_EQ(1024, req.GetOption<ReadFromOffset>().value());
+        return std::unique_ptr<ObjectReadSource>(raw_source2);
+      }));
+
+  std::string const data(1024, 'A');
+  EXPECT_CALL(*raw_source1, CanReadBorrowed).WillRepeatedly(Return(true));
+  EXPECT_CALL(*raw_source1, ReadBorrowed)
+      .WillOnce(Return(BorrowedReadSourceResult{
+          ConstBuffer(data.data(), data.size()), HttpResponse{100, "", {}}}))
+      .WillOnce(Return(TransientError()));
+  EXPECT_CALL(*raw_source2, CanReadBorrowed).WillRepeatedly(Return(false));
+  EXPECT_CALL(*raw_source2, ReadBorrowed).Times(0);
+  EXPECT_CALL(*raw_source2, Read)
+      .WillOnce(Invoke([](char* buf, std::size_t n) {
+        std::string const contents = "0123456789";
+        EXPECT_LE(contents.size(), n);
+        std::copy(contents.begin(), contents.end(), buf);
+        return ReadSourceResult{contents.size(), HttpResponse{100, "", {}}};
+      }))
+      .WillOnce(Return(ReadSourceResult{0, HttpResponse{200, "", {}}}));
+
+  auto source = client->ReadObject(ReadObjectRangeRequest{});
+  ASSERT_STATUS_OK(source);
+  auto res = (*source)->ReadBorrowed();
+  ASSERT_STATUS_OK(res);
+  EXPECT_EQ(data.size(), res->data.size());
+  res = (*source)->ReadBorrowed();
+  ASSERT_STATUS_OK(res);
+  EXPECT_EQ("0123456789", std::string(res->data.data(), res->data.size()));
+  res = (*source)->ReadBorrowed();
+  ASSERT_STATUS_OK(res);
+  EXPECT_TRUE(res->data.empty());
+  EXPECT_EQ(200, res->response.status_code);
+}
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
@@ -50,11 +50,12 @@ std::vector<std::uint8_t> Sha256Hash(std::vector<std::uint8_t> const& bytes) {
 }
 
 std::string HexEncode(std::vector<std::uint8_t> const& bytes) {
-  std::string result;
-  std::array<char, sizeof("ff")> buf{};
+  static char const kDigits[] = "0123456789abcdef";
+  std::string result(2 * bytes.size(), '\0');
+  auto* out = &result[0];
   for (auto c : bytes) {
-    std::snprintf(buf.data(), buf.size(), "%02x", c);
-    result += buf.data();
+    *out++ = kDigits[(c >> 4) & 0xf];
+    *out++ = kDigits[c & 0xf];
   }
   return result;
 }
@@ -206,6 +206,21 @@ std::string V4SignUrlRequest::StringToSign(std::string const& client_id) const {
          "\n" + Scope() + "\n" + CanonicalRequestHash(client_id);
 }
 
+std::string V4SignUrlRequest::SignedUrl(
+    std::string const& client_id, std::vector<std::uint8_t> const& signature) {
+  CurlHandle curl;
+  std::string result = HostnameWithBucket();
+  for (auto& part : ObjectNameParts()) {
+    result += '/';
+    result += curl.MakeEscapedString(part).get();
+  }
+  result += '?';
+  result += QueryStringFromParameters(curl, AllQueryParameters(client_id));
+  result += "&X-Goog-Signature=";
+  result += HexEncode(signature);
+  return result;
+}
+
 Status V4SignUrlRequest::Validate() {
   if (virtual_host_name_ && domain_named_bucket_) {
     return Status(StatusCode::kInvalidArgument,
@@ -281,8 +296,6 @@ V4SignUrlRequest::CanonicalQueryParameters(std::string const& client_id) const {
 
 std::multimap<std::string, std::string> V4SignUrlRequest::AllQueryParameters(
     std::string const& client_id) const {
-  CurlHandle curl;
-  // Query parameters.
   auto parameters = common_request_.query_parameters();
   auto canonical_parameters = CanonicalQueryParameters(client_id);
   // No .merge() until C++17, blegh.
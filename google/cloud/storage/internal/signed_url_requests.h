@@ -20,8 +20,11 @@
 #include "google/cloud/storage/signed_url_options.h"
 #include "google/cloud/storage/version.h"
 #include "google/cloud/storage/well_known_parameters.h"
+#include <cstdint>
 #include <iosfwd>
 #include <map>
+#include <string>
+#include <vector>
 
 namespace google {
 namespace cloud {
@@ -246,6 +249,15 @@ class V4SignUrlRequest {
   /// Creates the V4 string to be signed.
   std::string StringToSign(std::string const& client_id) const;
 
+  /**
+   * Creates the signed URL.
+   *
+   * @param client_id the signing account, as used in `StringToSign()`.
+   * @param signature the signature of `StringToSign()`, as raw bytes.
+   */
+  std::string SignedUrl(std::string const& client_id,
+                        std::vector<std::uint8_t> const& signature);
+
   template <typename H, typename... T>
   V4SignUrlRequest& set_multiple_options(H&& h, T&&... tail) {
     SetOption(std::forward<H>(h));
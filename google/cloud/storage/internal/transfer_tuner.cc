@@ -0,0 +1,104 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/transfer_tuner.h"
+#include "google/cloud/storage/internal/moving_average.h"
+#include "google/cloud/storage/internal/object_requests.h"
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+std::size_t Clamp(double value, std::size_t lo, std::size_t hi) {
+  if (value <= static_cast<double>(lo)) return lo;
+  if (value >= static_cast<double>(hi)) return hi;
+  return static_cast<std::size_t>(value);
+}
+}  // namespace
+
+std::size_t constexpr TransferTuner::kDefaultCurlBufferSize;
+std::size_t constexpr TransferTuner::kMinCurlBufferSize;
+std::size_t constexpr TransferTuner::kMaxCurlBufferSize;
+std::size_t constexpr TransferTuner::kMinSocketBufferSize;
+std::size_t constexpr TransferTuner::kMaxSocketBufferSize;
+std::uint64_t constexpr TransferTuner::kMinThroughputSampleSize;
+
+TransferTuner::TransferTuner(std::size_t min_upload_chunk_size,
+                             std::size_t max_upload_chunk_size)
+    : min_upload_chunk_size_(
+          UploadChunkRequest::RoundUpToQuantum(min_upload_chunk_size)),
+      max_upload_chunk_size_((std::max)(
+          min_upload_chunk_size_,
+          UploadChunkRequest::RoundUpToQuantum(max_upload_chunk_size))) {}
+
+void TransferTuner::OnTransfer(TransferSample const& sample) {
+  using seconds = std::chrono::duration<double>;
+  auto const elapsed =
+      std::chrono::duration_cast<seconds>(sample.elapsed).count();
+  auto const rtt = std::chrono::duration_cast<seconds>(sample.rtt).count();
+  std::lock_guard<std::mutex> lk(mu_);
+  if (rtt > 0) rtt_seconds_ = Smooth(rtt_seconds_, rtt);
+  if (sample.bytes < kMinThroughputSampleSize || elapsed <= 0) return;
+  bytes_per_second_ =
+      Smooth(bytes_per_second_, static_cast<double>(sample.bytes) / elapsed);
+}
+
+std::size_t TransferTuner::CurlBufferSize() const {
+  auto const bdp = BandwidthDelayProduct();
+  if (bdp <= 0) return kDefaultCurlBufferSize;
+  auto size = kMinCurlBufferSize;
+  while (size < kMaxCurlBufferSize && 2.0 * size <= bdp / 4) size *= 2;
+  return size;
+}
+
+std::size_t TransferTuner::SocketBufferSize() const {
+  auto const bdp = BandwidthDelayProduct();
+  if (bdp <= 0) return 0;
+  return Clamp(2 * bdp, kMinSocketBufferSize, kMaxSocketBufferSize);
+}
+
+std::size_t TransferTuner::UploadChunkSize() const {
+  auto const bdp = BandwidthDelayProduct();
+  if (bdp <= 0) return min_upload_chunk_size_;
+  auto const size =
+      Clamp(10 * bdp, min_upload_chunk_size_, max_upload_chunk_size_);
+  auto constexpr kQuantum = UploadChunkRequest::kChunkSizeQuantum;
+  return (std::max)(size / kQuantum * kQuantum, min_upload_chunk_size_);
+}
+
+double TransferTuner::bytes_per_second() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return bytes_per_second_;
+}
+
+std::chrono::microseconds TransferTuner::rtt() const {
+  using seconds = std::chrono::duration<double>;
+  std::lock_guard<std::mutex> lk(mu_);
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      seconds(rtt_seconds_));
+}
+
+double TransferTuner::BandwidthDelayProduct() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return bytes_per_second_ * rtt_seconds_;
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
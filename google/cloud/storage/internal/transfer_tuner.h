@@ -0,0 +1,124 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_TRANSFER_TUNER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_TRANSFER_TUNER_H
+
+#include "google/cloud/storage/version.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+/// The measurements for a single HTTP transfer.
+struct TransferSample {
+  /// The number of payload bytes sent or received.
+  std::uint64_t bytes;
+  /// The time spent sending or receiving the payload.
+  std::chrono::microseconds elapsed;
+  /// An estimate of the round-trip time, zero if not available.
+  std::chrono::microseconds rtt;
+};
+
+/**
+ * Chooses buffer and chunk sizes based on the measured throughput and RTT.
+ *
+ * The right sizes depend on the bandwidth-delay product (BDP) of the network
+ * path: small buffers underutilize long, fat pipes, while large buffers waste
+ * memory and increase the cost of retries on short paths. The tuner keeps an
+ * exponentially weighted moving average of the throughput and RTT of recent
+ * transfers, and derives all the sizes from the estimated BDP. Before any
+ * transfer completes it returns the same values as a client without tuning.
+ *
+ * The throughput of a transfer is limited by the application too, e.g. when it
+ * reads a download slowly, so the estimate is conservative.
+ *
+ * This class is thread-safe.
+ */
+class TransferTuner {
+ public:
+  /// The default value for `CURLOPT_BUFFERSIZE`.
+  static std::size_t constexpr kDefaultCurlBufferSize = 128 * 1024;
+  /// The libcurl default, and the smallest value we use.
+  static std::size_t constexpr kMinCurlBufferSize = 16 * 1024;
+  /// The largest value supported by libcurl (`CURL_MAX_READ_SIZE`).
+  static std::size_t constexpr kMaxCurlBufferSize = 512 * 1024;
+  static std::size_t constexpr kMinSocketBufferSize = 64 * 1024;
+  static std::size_t constexpr kMaxSocketBufferSize = 16 * 1024 * 1024;
+  /// Smaller transfers are dominated by latency, ignore their throughput.
+  static std::uint64_t constexpr kMinThroughputSampleSize = 256 * 1024;
+
+  /**
+   * Creates a tuner for upload chunks between @p min_upload_chunk_size and
+   * @p max_upload_chunk_size bytes.
+   */
+  TransferTuner(std::size_t min_upload_chunk_size,
+                std::size_t max_upload_chunk_size);
+
+  /// Updates the throughput and RTT estimates after a transfer completes.
+  void OnTransfer(TransferSample const& sample);
+
+  /**
+   * The value for `CURLOPT_BUFFERSIZE` in new transfers.
+   *
+   * About a quarter of the BDP, so each callback drains a meaningful fraction
+   * of the data in flight, rounded to a power of two.
+   */
+  std::size_t CurlBufferSize() const;
+
+  /**
+   * The size for the socket buffers in new connections, 0 to use the OS
+   * defaults.
+   *
+   * The sockets need to hold at least one BDP to keep the pipe full, we use
+   * twice that to absorb throughput variations.
+   */
+  std::size_t SocketBufferSize() const;
+
+  /**
+   * The chunk size for new uploads, a multiple of 256KiB.
+   *
+   * Each chunk is a separate request, so each chunk costs at least a RTT. The
+   * chunk size is large enough to keep that overhead under 10%.
+   */
+  std::size_t UploadChunkSize() const;
+
+  /// The current estimates, mostly for testing and troubleshooting.
+  double bytes_per_second() const;
+  std::chrono::microseconds rtt() const;
+
+ private:
+  /// The estimated BDP in bytes, 0 if there is no estimate yet.
+  double BandwidthDelayProduct() const;
+
+  std::size_t min_upload_chunk_size_;
+  std::size_t max_upload_chunk_size_;
+  mutable std::mutex mu_;
+  double bytes_per_second_ = 0;  // GUARDED_BY(mu_)
+  double rtt_seconds_ = 0;       // GUARDED_BY(mu_)
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_TRANSFER_TUNER_H
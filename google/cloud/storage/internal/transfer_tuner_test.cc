@@ -0,0 +1,108 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/transfer_tuner.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::std::chrono::microseconds;
+using ::std::chrono::milliseconds;
+using ::std::chrono::seconds;
+
+auto constexpr kKiB = 1024;
+auto constexpr kMiB = 1024 * kKiB;
+
+TransferSample MakeSample(std::uint64_t bytes, microseconds elapsed,
+                          microseconds rtt) {
+  return TransferSample{bytes, elapsed, rtt};
+}
+
+TEST(TransferTunerTest, Defaults) {
+  TransferTuner tuner(3 * kMiB, 32 * kMiB);
+  EXPECT_EQ(128 * kKiB, tuner.CurlBufferSize());
+  EXPECT_EQ(0, tuner.SocketBufferSize());
+  // The minimum is rounded up to a multiple of 256KiB.
+  EXPECT_EQ(3 * kMiB, tuner.UploadChunkSize());
+
+  TransferTuner rounded(100 * kKiB, 100 * kKiB);
+  EXPECT_EQ(256 * kKiB, rounded.UploadChunkSize());
+}
+
+TEST(TransferTunerTest, ModerateBandwidthDelayProduct) {
+  TransferTuner tuner(256 * kKiB, 32 * kMiB);
+  // 10MiB/s with a 50ms RTT, the BDP is 512KiB.
+  tuner.OnTransfer(MakeSample(10 * kMiB, seconds(1), milliseconds(50)));
+  EXPECT_DOUBLE_EQ(10.0 * kMiB, tuner.bytes_per_second());
+  EXPECT_EQ(milliseconds(50), tuner.rtt());
+  EXPECT_EQ(128 * kKiB, tuner.CurlBufferSize());
+  EXPECT_EQ(1 * kMiB, tuner.SocketBufferSize());
+  EXPECT_EQ(5 * kMiB, tuner.UploadChunkSize());
+}
+
+TEST(TransferTunerTest, LargeBandwidthDelayProduct) {
+  TransferTuner tuner(256 * kKiB, 8 * kMiB);
+  // 100MiB/s with a 100ms RTT, the BDP is 10MiB.
+  tuner.OnTransfer(MakeSample(100 * kMiB, seconds(1), milliseconds(100)));
+  EXPECT_EQ(TransferTuner::kMaxCurlBufferSize, tuner.CurlBufferSize());
+  EXPECT_EQ(TransferTuner::kMaxSocketBufferSize, tuner.SocketBufferSize());
+  EXPECT_EQ(8 * kMiB, tuner.UploadChunkSize());
+}
+
+TEST(TransferTunerTest, SmallBandwidthDelayProduct) {
+  TransferTuner tuner(2 * kMiB, 8 * kMiB);
+  // 1MiB/s with a 1ms RTT, the BDP is about 1KiB.
+  tuner.OnTransfer(MakeSample(1 * kMiB, seconds(1), milliseconds(1)));
+  EXPECT_EQ(TransferTuner::kMinCurlBufferSize, tuner.CurlBufferSize());
+  EXPECT_EQ(TransferTuner::kMinSocketBufferSize, tuner.SocketBufferSize());
+  EXPECT_EQ(2 * kMiB, tuner.UploadChunkSize());
+}
+
+TEST(TransferTunerTest, SmallTransfersOnlyUpdateRtt) {
+  TransferTuner tuner(256 * kKiB, 8 * kMiB);
+  tuner.OnTransfer(MakeSample(1 * kKiB, milliseconds(1), milliseconds(20)));
+  EXPECT_EQ(0, tuner.bytes_per_second());
+  EXPECT_EQ(milliseconds(20), tuner.rtt());
+  // Without a throughput estimate the defaults are used.
+  EXPECT_EQ(TransferTuner::kDefaultCurlBufferSize, tuner.CurlBufferSize());
+  EXPECT_EQ(0, tuner.SocketBufferSize());
+}
+
+TEST(TransferTunerTest, MissingRttOnlyUpdatesThroughput) {
+  TransferTuner tuner(256 * kKiB, 8 * kMiB);
+  tuner.OnTransfer(MakeSample(4 * kMiB, seconds(1), microseconds(0)));
+  EXPECT_DOUBLE_EQ(4.0 * kMiB, tuner.bytes_per_second());
+  EXPECT_EQ(microseconds(0), tuner.rtt());
+  EXPECT_EQ(TransferTuner::kDefaultCurlBufferSize, tuner.CurlBufferSize());
+}
+
+TEST(TransferTunerTest, MovingAverage) {
+  TransferTuner tuner(256 * kKiB, 8 * kMiB);
+  tuner.OnTransfer(MakeSample(8 * kMiB, seconds(1), milliseconds(40)));
+  tuner.OnTransfer(MakeSample(16 * kMiB, seconds(1), milliseconds(80)));
+  EXPECT_DOUBLE_EQ(10.0 * kMiB, tuner.bytes_per_second());
+  EXPECT_EQ(milliseconds(50), tuner.rtt());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
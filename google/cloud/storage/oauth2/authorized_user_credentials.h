@@ -60,8 +60,10 @@ ParseAuthorizedUserRefreshResponse(
  *
  * An HTTP Authorization header, with an access token as its value,
  * can be obtained by calling the AuthorizationHeader() method; if the current
- * access token is invalid or nearing expiration, this will class will first
- * obtain a new access token before returning the Authorization header string.
+ * access token is invalid, this class will first obtain a new access token
+ * before returning the Authorization header string. Access tokens nearing
+ * expiration are refreshed in a background thread, while this class keeps
+ * returning the current (and still valid) access token.
  *
  * @see https://developers.google.com/identity/protocols/OAuth2 for an overview
  * of using user credentials with Google's OAuth 2.0 system.
@@ -95,9 +97,10 @@ class AuthorizedUserCredentials : public Credentials {
   }
 
   StatusOr<std::string> AuthorizationHeader() override {
-    std::unique_lock<std::mutex> lock(mu_);
-    return refreshing_creds_.AuthorizationHeader(clock_.now(),
-                                                 [this] { return Refresh(); });
+    return refreshing_creds_.AuthorizationHeader(clock_.now(), [this] {
+      std::unique_lock<std::mutex> lock(mu_);
+      return Refresh();
+    });
   }
 
  private:
@@ -116,6 +119,8 @@ class AuthorizedUserCredentials : public Credentials {
   typename HttpRequestBuilderType::RequestType request_;
   std::string payload_;
   mutable std::mutex mu_;
+  // Must be the last member, it may be running `Refresh()` in the background
+  // and its destructor waits for it.
   RefreshingCredentialsWrapper refreshing_creds_;
 };
 
@@ -61,8 +61,10 @@ ParseComputeEngineRefreshResponse(
  *
  * An HTTP Authorization header, with an access token as its value, can be
  * obtained by calling the AuthorizationHeader() method; if the current access
- * token is invalid or nearing expiration, this will class will first obtain a
- * new access token before returning the Authorization header string.
+ * token is invalid, this class will first obtain a new access token before
+ * returning the Authorization header string. Access tokens nearing expiration
+ * are refreshed in a background thread, while this class keeps returning the
+ * current (and still valid) access token.
  *
  * @see https://cloud.google.com/compute/docs/authentication#using for details
  * on how to get started with Compute Engine service account credentials.
@@ -84,9 +86,10 @@ class ComputeEngineCredentials : public Credentials {
       : clock_(), service_account_email_(std::move(service_account_email)) {}
 
   StatusOr<std::string> AuthorizationHeader() override {
-    std::unique_lock<std::mutex> lock(mu_);
-    return refreshing_creds_.AuthorizationHeader(clock_.now(),
-                                                 [this] { return Refresh(); });
+    return refreshing_creds_.AuthorizationHeader(clock_.now(), [this] {
+      std::unique_lock<std::mutex> lock(mu_);
+      return Refresh();
+    });
   }
 
   std::string AccountEmail() const override {
@@ -195,9 +198,11 @@ class ComputeEngineCredentials : public Credentials {
 
   ClockType clock_;
   mutable std::mutex mu_;
-  RefreshingCredentialsWrapper refreshing_creds_;
   mutable std::set<std::string> scopes_;
   mutable std::string service_account_email_;
+  // Must be the last member, it may be running `Refresh()` in the background
+  // and its destructor waits for it.
+  RefreshingCredentialsWrapper refreshing_creds_;
 };
 
 }  // namespace oauth2
@@ -51,6 +51,19 @@ constexpr std::chrono::seconds GoogleOAuthAccessTokenExpirationSlack() {
   return std::chrono::seconds(500);
 }
 
+/**
+ * Returns how early an access token is refreshed in the background.
+ *
+ * Credentials start refreshing the access token this long before it is
+ * considered expired (see `GoogleOAuthAccessTokenExpirationSlack()`). Until
+ * the refresh completes they keep using the current access token, so
+ * applications that use the credentials at least once during this period
+ * never wait for a refresh.
+ */
+constexpr std::chrono::seconds GoogleOAuthAccessTokenRefreshAhead() {
+  return std::chrono::seconds(300);
+}
+
 /// The endpoint to fetch an OAuth 2.0 access token from.
 inline char const* GoogleOAuthRefreshEndpoint() {
   static constexpr char kEndpoint[] = "https://oauth2.googleapis.com/token";
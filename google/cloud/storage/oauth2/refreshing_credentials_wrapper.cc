@@ -21,15 +21,93 @@ namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace oauth2 {
 
+namespace {
+/// How long to wait before retrying a failed background refresh.
+constexpr std::chrono::seconds BackgroundRefreshBackoff() {
+  return std::chrono::seconds(10);
+}
+}  // namespace
+
+RefreshingCredentialsWrapper::~RefreshingCredentialsWrapper() {
+  std::unique_lock<std::mutex> lk(background_mu_);
+  auto pending = std::move(background_refresh_);
+  lk.unlock();
+  if (pending.valid()) pending.wait();
+}
+
 bool RefreshingCredentialsWrapper::IsExpired(
     std::chrono::system_clock::time_point now) const {
-  return now > (temporary_token_.expiration_time -
-                GoogleOAuthAccessTokenExpirationSlack());
+  auto token = std::atomic_load(&temporary_token_);
+  return !token || IsExpired(*token, now);
 }
 
 bool RefreshingCredentialsWrapper::IsValid(
     std::chrono::system_clock::time_point now) const {
-  return !temporary_token_.token.empty() && !IsExpired(now);
+  auto token = std::atomic_load(&temporary_token_);
+  return IsValid(token.get(), now);
+}
+
+bool RefreshingCredentialsWrapper::NeedsRefresh(
+    std::chrono::system_clock::time_point now) const {
+  auto token = std::atomic_load(&temporary_token_);
+  return IsValid(token.get(), now) && NeedsRefresh(*token, now);
+}
+
+bool RefreshingCredentialsWrapper::IsExpired(
+    TemporaryToken const& token, std::chrono::system_clock::time_point now) {
+  return now >
+         (token.expiration_time - GoogleOAuthAccessTokenExpirationSlack());
+}
+
+bool RefreshingCredentialsWrapper::IsValid(
+    TemporaryToken const* token, std::chrono::system_clock::time_point now) {
+  return token != nullptr && !token->token.empty() && !IsExpired(*token, now);
+}
+
+bool RefreshingCredentialsWrapper::NeedsRefresh(
+    TemporaryToken const& token, std::chrono::system_clock::time_point now) {
+  return now > (token.expiration_time -
+                GoogleOAuthAccessTokenExpirationSlack() -
+                GoogleOAuthAccessTokenRefreshAhead());
+}
+
+void RefreshingCredentialsWrapper::StartBackgroundRefresh(
+    std::chrono::system_clock::time_point now,
+    RefreshFunction refresh_fn) const {
+  std::lock_guard<std::mutex> lk(background_mu_);
+  if (background_refresh_running_ || now < background_refresh_after_) return;
+  background_refresh_running_ = true;
+  // The previous background refresh, if any, has already completed.
+  background_refresh_ =
+      std::async(std::launch::async, [this, now, refresh_fn] {
+        BackgroundRefresh(now, refresh_fn);
+      });
+}
+
+void RefreshingCredentialsWrapper::BackgroundRefresh(
+    std::chrono::system_clock::time_point now,
+    RefreshFunction const& refresh_fn) const {
+  bool failed = false;
+  {
+    std::lock_guard<std::mutex> lk(refresh_mu_);
+    // A synchronous refresh may have completed while this thread waited.
+    auto token = std::atomic_load(&temporary_token_);
+    if (!IsValid(token.get(), now) || NeedsRefresh(*token, now)) {
+      StatusOr<TemporaryToken> new_token = refresh_fn();
+      if (new_token) {
+        std::atomic_store(
+            &temporary_token_,
+            std::make_shared<TemporaryToken const>(*std::move(new_token)));
+      } else {
+        failed = true;
+      }
+    }
+  }
+  std::lock_guard<std::mutex> lk(background_mu_);
+  background_refresh_running_ = false;
+  // The current token is still valid, the next refresh attempt happens on
+  // demand, but avoid retrying on every call while the service is failing.
+  if (failed) background_refresh_after_ = now + BackgroundRefreshBackoff();
 }
 
 }  // namespace oauth2
@@ -19,6 +19,10 @@
 #include "google/cloud/status.h"
 #include "google/cloud/status_or.h"
 #include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 
@@ -30,6 +34,15 @@ namespace oauth2 {
 
 /**
  * Wrapper for refreshable parts of a Credentials object.
+ *
+ * The current access token is stored in an immutable object, replaced
+ * atomically on each refresh. Callers read the token without locking.
+ *
+ * Once the access token is close to expiring, but still valid, the wrapper
+ * refreshes it in a background thread and keeps returning the current token
+ * meanwhile. Callers only wait for a refresh when there is no valid token,
+ * that is, before the first refresh and if the token expired before a
+ * background refresh could complete.
  */
 class RefreshingCredentialsWrapper {
  public:
@@ -38,20 +51,38 @@ class RefreshingCredentialsWrapper {
     std::chrono::system_clock::time_point expiration_time;
   };
 
+  RefreshingCredentialsWrapper() = default;
+  /// Blocks until any background refresh completes.
+  ~RefreshingCredentialsWrapper();
+
+  /**
+   * Returns the current authorization header, refreshing it if needed.
+   *
+   * @p refresh_fn may be called from a background thread, it must remain
+   * usable until this object is destroyed. The wrapper never calls it from
+   * two threads at the same time.
+   */
   template <typename RefreshFunctor>
   StatusOr<std::string> AuthorizationHeader(
       std::chrono::system_clock::time_point now,
       RefreshFunctor refresh_fn) const {
-    if (IsValid(now)) {
-      return temporary_token_.token;
+    auto token = std::atomic_load(&temporary_token_);
+    if (IsValid(token.get(), now)) {
+      if (NeedsRefresh(*token, now)) {
+        StartBackgroundRefresh(now, RefreshFunction(std::move(refresh_fn)));
+      }
+      return token->token;
     }
 
+    std::lock_guard<std::mutex> lk(refresh_mu_);
+    // Another thread may have refreshed the token while this one waited.
+    token = std::atomic_load(&temporary_token_);
+    if (IsValid(token.get(), now)) return token->token;
     StatusOr<TemporaryToken> new_token = refresh_fn();
-    if (new_token) {
-      temporary_token_ = *std::move(new_token);
-      return temporary_token_.token;
-    }
-    return new_token.status();
+    if (!new_token) return std::move(new_token).status();
+    token = std::make_shared<TemporaryToken const>(*std::move(new_token));
+    std::atomic_store(&temporary_token_, token);
+    return token->token;
   }
 
   /**
@@ -75,8 +106,39 @@ class RefreshingCredentialsWrapper {
    */
   bool IsValid(std::chrono::system_clock::time_point now) const;
 
+  /**
+   * Returns whether the current access token should be refreshed in the
+   * background.
+   *
+   * This is true for valid tokens that expire in less than
+   * `GoogleOAuthAccessTokenRefreshAhead()`.
+   */
+  bool NeedsRefresh(std::chrono::system_clock::time_point now) const;
+
  private:
-  mutable TemporaryToken temporary_token_;
+  using RefreshFunction = std::function<StatusOr<TemporaryToken>()>;
+
+  static bool IsExpired(TemporaryToken const& token,
+                        std::chrono::system_clock::time_point now);
+  static bool IsValid(TemporaryToken const* token,
+                      std::chrono::system_clock::time_point now);
+  static bool NeedsRefresh(TemporaryToken const& token,
+                           std::chrono::system_clock::time_point now);
+
+  void StartBackgroundRefresh(std::chrono::system_clock::time_point now,
+                              RefreshFunction refresh_fn) const;
+  void BackgroundRefresh(std::chrono::system_clock::time_point now,
+                         RefreshFunction const& refresh_fn) const;
+
+  // Always accessed using `std::atomic_load()` and `std::atomic_store()`.
+  mutable std::shared_ptr<TemporaryToken const> temporary_token_;
+  // Serializes the calls to the refresh function.
+  mutable std::mutex refresh_mu_;
+
+  mutable std::mutex background_mu_;
+  mutable bool background_refresh_running_ = false;
+  mutable std::chrono::system_clock::time_point background_refresh_after_;
+  mutable std::future<void> background_refresh_;
 };
 
 }  // namespace oauth2
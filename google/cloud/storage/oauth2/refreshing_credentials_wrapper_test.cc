@@ -0,0 +1,173 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/oauth2/refreshing_credentials_wrapper.h"
+#include "google/cloud/storage/oauth2/credential_constants.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace oauth2 {
+namespace {
+
+using TemporaryToken = RefreshingCredentialsWrapper::TemporaryToken;
+
+auto const kTokenLifetime = std::chrono::seconds(3600);
+
+/// Returns a time point where the token expiring at @p expiration is stale.
+std::chrono::system_clock::time_point StaleTime(
+    std::chrono::system_clock::time_point expiration) {
+  return expiration - GoogleOAuthAccessTokenExpirationSlack() -
+         GoogleOAuthAccessTokenRefreshAhead() / 2;
+}
+
+/// @test Verify that the first call refreshes and later calls use the cache.
+TEST(RefreshingCredentialsWrapperTest, RefreshOnlyWhenMissing) {
+  auto const now = std::chrono::system_clock::now();
+  RefreshingCredentialsWrapper tested;
+  EXPECT_FALSE(tested.IsValid(now));
+  EXPECT_TRUE(tested.IsExpired(now));
+  EXPECT_FALSE(tested.NeedsRefresh(now));
+
+  int count = 0;
+  auto refresh = [&count, now]() -> StatusOr<TemporaryToken> {
+    ++count;
+    return TemporaryToken{"token-" + std::to_string(count),
+                          now + kTokenLifetime};
+  };
+  for (int i = 0; i != 3; ++i) {
+    auto header = tested.AuthorizationHeader(now, refresh);
+    ASSERT_STATUS_OK(header);
+    EXPECT_EQ("token-1", *header);
+  }
+  EXPECT_EQ(1, count);
+  EXPECT_TRUE(tested.IsValid(now));
+  EXPECT_FALSE(tested.NeedsRefresh(now));
+}
+
+/// @test Verify that refresh errors are reported when there is no token.
+TEST(RefreshingCredentialsWrapperTest, RefreshFailure) {
+  auto const now = std::chrono::system_clock::now();
+  RefreshingCredentialsWrapper tested;
+  auto header = tested.AuthorizationHeader(now, [] {
+    return StatusOr<TemporaryToken>(Status(StatusCode::kUnavailable, "try"));
+  });
+  EXPECT_EQ(StatusCode::kUnavailable, header.status().code());
+  EXPECT_FALSE(tested.IsValid(now));
+}
+
+/// @test Verify that expired tokens are refreshed before returning.
+TEST(RefreshingCredentialsWrapperTest, ExpiredTokenRefreshesInline) {
+  auto const now = std::chrono::system_clock::now();
+  RefreshingCredentialsWrapper tested;
+  auto header = tested.AuthorizationHeader(now, [now] {
+    return StatusOr<TemporaryToken>(TemporaryToken{"token-1", now});
+  });
+  ASSERT_STATUS_OK(header);
+  EXPECT_EQ("token-1", *header);
+  EXPECT_TRUE(tested.IsExpired(now));
+
+  header = tested.AuthorizationHeader(now, [now] {
+    return StatusOr<TemporaryToken>(
+        TemporaryToken{"token-2", now + kTokenLifetime});
+  });
+  ASSERT_STATUS_OK(header);
+  EXPECT_EQ("token-2", *header);
+}
+
+/// @test Verify that stale tokens are refreshed without blocking the callers.
+TEST(RefreshingCredentialsWrapperTest, StaleTokenRefreshesInBackground) {
+  auto const now = std::chrono::system_clock::now();
+  auto const expiration = now + kTokenLifetime;
+  RefreshingCredentialsWrapper tested;
+  auto header = tested.AuthorizationHeader(now, [expiration] {
+    return StatusOr<TemporaryToken>(TemporaryToken{"token-1", expiration});
+  });
+  ASSERT_STATUS_OK(header);
+
+  auto const stale = StaleTime(expiration);
+  EXPECT_TRUE(tested.IsValid(stale));
+  EXPECT_TRUE(tested.NeedsRefresh(stale));
+
+  // Block the background refresh until all the callers got a token.
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  std::promise<void> done;
+  std::atomic<int> count{0};
+  auto refresh = [&, released]() {
+    ++count;
+    released.wait();
+    done.set_value();
+    return StatusOr<TemporaryToken>(
+        TemporaryToken{"token-2", stale + kTokenLifetime});
+  };
+  for (int i = 0; i != 3; ++i) {
+    header = tested.AuthorizationHeader(stale, refresh);
+    ASSERT_STATUS_OK(header);
+    EXPECT_EQ("token-1", *header);
+  }
+  release.set_value();
+  done.get_future().get();
+  // `done` is set before the token is stored, wait until it is visible.
+  while (tested.NeedsRefresh(stale)) std::this_thread::yield();
+
+  header = tested.AuthorizationHeader(stale, refresh);
+  ASSERT_STATUS_OK(header);
+  EXPECT_EQ("token-2", *header);
+  EXPECT_EQ(1, count.load());
+}
+
+/// @test Verify that failed background refreshes keep the current token.
+TEST(RefreshingCredentialsWrapperTest, BackgroundRefreshFailure) {
+  auto const now = std::chrono::system_clock::now();
+  auto const expiration = now + kTokenLifetime;
+  RefreshingCredentialsWrapper tested;
+  auto header = tested.AuthorizationHeader(now, [expiration] {
+    return StatusOr<TemporaryToken>(TemporaryToken{"token-1", expiration});
+  });
+  ASSERT_STATUS_OK(header);
+
+  auto const stale = StaleTime(expiration);
+  std::promise<void> done;
+  auto failing = [&done] {
+    done.set_value();
+    return StatusOr<TemporaryToken>(Status(StatusCode::kUnavailable, "try"));
+  };
+  header = tested.AuthorizationHeader(stale, failing);
+  ASSERT_STATUS_OK(header);
+  EXPECT_EQ("token-1", *header);
+  done.get_future().get();
+
+  // The failed refresh is not retried immediately, and the current token is
+  // still returned.
+  header = tested.AuthorizationHeader(stale, [] {
+    ADD_FAILURE() << "unexpected refresh";
+    return StatusOr<TemporaryToken>(Status(StatusCode::kUnavailable, "try"));
+  });
+  ASSERT_STATUS_OK(header);
+  EXPECT_EQ("token-1", *header);
+}
+
+}  // namespace
+}  // namespace oauth2
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
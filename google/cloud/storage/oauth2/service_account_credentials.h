@@ -26,6 +26,7 @@
 #include <condition_variable>
 #include <ctime>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <set>
 
@@ -110,8 +111,10 @@ std::string CreateServiceAccountRefreshPayload(
  *
  * An HTTP Authorization header, with an access token as its value,
  * can be obtained by calling the AuthorizationHeader() method; if the current
- * access token is invalid or nearing expiration, this will class will first
- * obtain a new access token before returning the Authorization header string.
+ * access token is invalid, this class will first obtain a new access token
+ * before returning the Authorization header string. Access tokens nearing
+ * expiration are refreshed in a background thread, while this class keeps
+ * returning the current (and still valid) access token.
 
  * @see https://developers.google.com/identity/protocols/OAuth2ServiceAccount
  * for an overview of using service accounts with Google's OAuth 2.0 system.
@@ -153,9 +156,10 @@ class ServiceAccountCredentials : public Credentials {
   }
 
   StatusOr<std::string> AuthorizationHeader() override {
-    std::unique_lock<std::mutex> lock(mu_);
-    return refreshing_creds_.AuthorizationHeader(clock_.now(),
-                                                 [this] { return Refresh(); });
+    return refreshing_creds_.AuthorizationHeader(clock_.now(), [this] {
+      std::unique_lock<std::mutex> lock(mu_);
+      return Refresh();
+    });
   }
 
   /**
@@ -178,8 +182,9 @@ class ServiceAccountCredentials : public Credentials {
                     "The current_credentials cannot sign blobs for " +
                         signing_account.value());
     }
-    return internal::SignStringWithPem(blob, info_.private_key,
-                                       JwtSigningAlgorithms::RS256);
+    auto key = PrivateKey();
+    if (!key) return std::move(key).status();
+    return (*key)->Sign(blob, JwtSigningAlgorithms::RS256);
   }
 
   std::string AccountEmail() const override { return info_.client_email; }
@@ -201,12 +206,27 @@ class ServiceAccountCredentials : public Credentials {
     return ParseServiceAccountRefreshResponse(*response, clock_.now());
   }
 
+  /// Returns the private key, parsing it only on the first call.
+  StatusOr<std::shared_ptr<internal::PemPrivateKey const>> PrivateKey() const {
+    auto key = std::atomic_load(&private_key_);
+    if (key) return key;
+    auto parsed = internal::PemPrivateKey::Parse(info_.private_key);
+    if (!parsed) return std::move(parsed).status();
+    key = std::make_shared<internal::PemPrivateKey const>(*std::move(parsed));
+    std::atomic_store(&private_key_, key);
+    return key;
+  }
+
   typename HttpRequestBuilderType::RequestType request_;
   std::string grant_type_;
   ServiceAccountCredentialsInfo info_;
+  // Always accessed using `std::atomic_load()` and `std::atomic_store()`.
+  mutable std::shared_ptr<internal::PemPrivateKey const> private_key_;
   mutable std::mutex mu_;
-  RefreshingCredentialsWrapper refreshing_creds_;
   ClockType clock_;
+  // Must be the last member, it may be running `Refresh()` in the background
+  // and its destructor waits for it.
+  RefreshingCredentialsWrapper refreshing_creds_;
 };
 
 }  // namespace oauth2
@@ -20,6 +20,10 @@
 #include "google/cloud/storage/testing/retry_tests.h"
 #include "google/cloud/testing_util/assert_ok.h"
 #include <gmock/gmock.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
 
 namespace google {
 namespace cloud {
@@ -30,6 +34,7 @@ namespace {
 using ::google::cloud::storage::testing::canonical_errors::PermanentError;
 using ::google::cloud::storage::testing::canonical_errors::TransientError;
 using ::testing::_;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 using ::testing::Invoke;
 using ::testing::Return;
@@ -439,6 +444,44 @@ ObjectMetadata CreateObject(int index) {
   return internal::ObjectMetadataParser::FromJson(metadata).value();
 };
 
+TEST_F(ObjectTest, ListObjectsPrefetchPages) {
+  auto mock = std::make_shared<testing::MockClient>();
+  auto const mock_options = ClientOptions(oauth2::CreateAnonymousCredentials());
+  EXPECT_CALL(*mock, client_options()).WillRepeatedly(ReturnRef(mock_options));
+  EXPECT_CALL(*mock, ListObjects(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([](internal::ListObjectsRequest const& req)
+                                 -> StatusOr<internal::ListObjectsResponse> {
+        EXPECT_EQ("test-bucket", req.bucket_name());
+        auto const page =
+            req.page_token().empty() ? 0 : std::stoi(req.page_token());
+        internal::ListObjectsResponse response;
+        if (page != 2) response.next_page_token = std::to_string(page + 1);
+        response.items.emplace_back(CreateObject(page));
+        return response;
+      }));
+  Client client(mock);
+
+  std::vector<std::string> names;
+  for (auto& o : client.ListObjects("test-bucket", PrefetchPages(2))) {
+    ASSERT_STATUS_OK(o);
+    names.push_back(o->name());
+  }
+  EXPECT_THAT(names, ElementsAre("object-0", "object-1", "object-2"));
+}
+
+std::vector<std::string> BatchPaths(internal::BatchRequest const& request) {
+  std::vector<std::string> paths;
+  for (auto const& part : request.parts()) paths.push_back(part.path);
+  return paths;
+}
+
+internal::BatchResponse MockBatchResponse(std::vector<int> const& codes) {
+  internal::BatchResponse response;
+  for (auto code : codes) response.responses.push_back({code, "", {}});
+  return response;
+}
+
 TEST_F(ObjectTest, DeleteByPrefix) {
   // Pretend ListObjects returns object-1, object-2, object-3.
 
@@ -460,21 +503,15 @@ TEST_F(ObjectTest, DeleteByPrefix) {
         response.items.emplace_back(CreateObject(3));
         return response;
       }));
-  EXPECT_CALL(*mock, DeleteObject(_))
-      .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
-        EXPECT_EQ("test-bucket", r.bucket_name());
-        EXPECT_EQ("object-1", r.object_name());
-        return make_status_or(internal::EmptyResponse{});
-      }))
-      .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
-        EXPECT_EQ("test-bucket", r.bucket_name());
-        EXPECT_EQ("object-2", r.object_name());
-        return make_status_or(internal::EmptyResponse{});
-      }))
-      .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
-        EXPECT_EQ("test-bucket", r.bucket_name());
-        EXPECT_EQ("object-3", r.object_name());
-        return make_status_or(internal::EmptyResponse{});
+  EXPECT_CALL(*mock, ExecuteBatch(_))
+      .WillOnce(Invoke([](internal::BatchRequest const& r) {
+        std::string const prefix = "/b/test-bucket/o/object-";
+        std::string const suffix = "&userProject=project-to-bill";
+        EXPECT_THAT(BatchPaths(r),
+                    ElementsAre(prefix + "1?ifGenerationMatch=0" + suffix,
+                                prefix + "2?ifGenerationMatch=0" + suffix,
+                                prefix + "3?ifGenerationMatch=0" + suffix));
+        return make_status_or(MockBatchResponse({204, 204, 204}));
       }));
   Client client(mock);
 
@@ -500,21 +537,14 @@ TEST_F(ObjectTest, DeleteByPrefixNoOptions) {
         response.items.emplace_back(CreateObject(3));
         return response;
       }));
-  EXPECT_CALL(*mock, DeleteObject(_))
-      .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
-        EXPECT_EQ("test-bucket", r.bucket_name());
-        EXPECT_EQ("object-1", r.object_name());
-        return make_status_or(internal::EmptyResponse{});
-      }))
-      .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
-        EXPECT_EQ("test-bucket", r.bucket_name());
-        EXPECT_EQ("object-2", r.object_name());
-        return make_status_or(internal::EmptyResponse{});
-      }))
-      .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
-        EXPECT_EQ("test-bucket", r.bucket_name());
-        EXPECT_EQ("object-3", r.object_name());
-        return make_status_or(internal::EmptyResponse{});
+  EXPECT_CALL(*mock, ExecuteBatch(_))
+      .WillOnce(Invoke([](internal::BatchRequest const& r) {
+        EXPECT_THAT(
+            BatchPaths(r),
+            ElementsAre("/b/test-bucket/o/object-1?ifGenerationMatch=0",
+                        "/b/test-bucket/o/object-2?ifGenerationMatch=0",
+                        "/b/test-bucket/o/object-3?ifGenerationMatch=0"));
+        return make_status_or(MockBatchResponse({204, 204, 204}));
       }));
   Client client(mock);
 
@@ -557,14 +587,8 @@ TEST_F(ObjectTest, DeleteByPrefixDeleteFailure) {
         response.items.emplace_back(CreateObject(3));
         return response;
       }));
-  EXPECT_CALL(*mock, DeleteObject(_))
-      .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
-        EXPECT_EQ("test-bucket", r.bucket_name());
-        EXPECT_EQ("object-1", r.object_name());
-        return make_status_or(internal::EmptyResponse{});
-      }))
-      .WillOnce(Return(StatusOr<internal::EmptyResponse>(
-          Status(StatusCode::kPermissionDenied, ""))));
+  EXPECT_CALL(*mock, ExecuteBatch(_))
+      .WillOnce(Return(make_status_or(MockBatchResponse({204, 403, 204}))));
   Client client(mock);
 
   auto status = DeleteByPrefix(client, "test-bucket", "object-", Versions(),
@@ -573,6 +597,68 @@ TEST_F(ObjectTest, DeleteByPrefixDeleteFailure) {
   EXPECT_EQ(StatusCode::kPermissionDenied, status.code());
 }
 
+TEST_F(ObjectTest, DeleteObjectsSplitsBatches) {
+  auto mock = std::make_shared<testing::MockClient>();
+  auto const mock_options = ClientOptions(oauth2::CreateAnonymousCredentials());
+  EXPECT_CALL(*mock, client_options()).WillRepeatedly(ReturnRef(mock_options));
+  EXPECT_CALL(*mock, ExecuteBatch(_))
+      .WillOnce(Invoke([](internal::BatchRequest const& r) {
+        EXPECT_EQ(100, r.size());
+        EXPECT_EQ("/b/test-bucket/o/o-0?quotaUser=q&ifGenerationMatch=7",
+                  r.parts().front().path);
+        return make_status_or(MockBatchResponse(std::vector<int>(100, 204)));
+      }))
+      .WillOnce(Invoke([](internal::BatchRequest const& r) {
+        EXPECT_EQ(50, r.size());
+        EXPECT_EQ("/b/test-bucket/o/o-100?quotaUser=q&ifGenerationMatch=7",
+                  r.parts().front().path);
+        std::vector<int> codes(50, 204);
+        codes[10] = 404;
+        return make_status_or(MockBatchResponse(codes));
+      }));
+  Client client(mock);
+
+  std::vector<std::pair<std::string, std::int64_t>> objects;
+  for (int i = 0; i != 150; ++i) {
+    objects.emplace_back("o-" + std::to_string(i), 7);
+  }
+  auto results = DeleteObjects(client, "test-bucket", objects, QuotaUser("q"));
+  ASSERT_EQ(150, results.size());
+  for (std::size_t i = 0; i != results.size(); ++i) {
+    if (i == 110) {
+      EXPECT_EQ(StatusCode::kNotFound, results[i].code());
+    } else {
+      EXPECT_STATUS_OK(results[i]);
+    }
+  }
+}
+
+TEST_F(ObjectTest, DeleteObjectsUnimplementedBatch) {
+  auto mock = std::make_shared<testing::MockClient>();
+  auto const mock_options = ClientOptions(oauth2::CreateAnonymousCredentials());
+  EXPECT_CALL(*mock, client_options()).WillRepeatedly(ReturnRef(mock_options));
+  EXPECT_CALL(*mock, ExecuteBatch(_))
+      .WillOnce(Return(StatusOr<internal::BatchResponse>(
+          Status(StatusCode::kUnimplemented, "no batches"))));
+  EXPECT_CALL(*mock, DeleteObject(_))
+      .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
+        EXPECT_EQ("o-1", r.object_name());
+        EXPECT_EQ(1, r.GetOption<IfGenerationMatch>().value());
+        return make_status_or(internal::EmptyResponse{});
+      }))
+      .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
+        EXPECT_EQ("o-2", r.object_name());
+        return StatusOr<internal::EmptyResponse>(
+            Status(StatusCode::kPermissionDenied, ""));
+      }));
+  Client client(mock);
+
+  auto results = DeleteObjects(client, "test-bucket", {{"o-1", 1}, {"o-2", 2}});
+  ASSERT_EQ(2, results.size());
+  EXPECT_STATUS_OK(results[0]);
+  EXPECT_EQ(StatusCode::kPermissionDenied, results[1].code());
+}
+
 TEST_F(ObjectTest, ComposeManyNone) {
   auto mock = std::make_shared<testing::MockClient>();
   auto const mock_options = ClientOptions(oauth2::CreateAnonymousCredentials());
@@ -760,19 +846,144 @@ TEST_F(ObjectTest, ComposeManyThreeLayers) {
         EXPECT_EQ("", request.contents());
         return make_status_or(MockObject("test-bucket", "prefix", 42));
       }));
+  // The temporary objects are deleted in a batch, the lock is deleted last.
+  ::testing::InSequence sequence;
+  EXPECT_CALL(*mock, ExecuteBatch(_))
+      .WillOnce(Invoke([](internal::BatchRequest const& r) {
+        EXPECT_THAT(
+            BatchPaths(r),
+            ElementsAre(
+                "/b/test-bucket/o/prefix.compose-tmp-0?ifGenerationMatch=42",
+                "/b/test-bucket/o/prefix.compose-tmp-1?ifGenerationMatch=42"));
+        return make_status_or(MockBatchResponse({204, 204}));
+      }));
   EXPECT_CALL(*mock, DeleteObject(_))
       .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
         EXPECT_EQ("test-bucket", r.bucket_name());
-        EXPECT_EQ("prefix.compose-tmp-1", r.object_name());
+        EXPECT_EQ("prefix", r.object_name());
         return make_status_or(internal::EmptyResponse{});
-      }))
+      }));
+
+  Client client(mock);
+
+  std::vector<ComposeSourceObject> sources;
+
+  std::size_t i = 0;
+  std::generate_n(std::back_inserter(sources), 63, [&i] {
+    return ComposeSourceObject{std::to_string(i++), 42, {}};
+  });
+
+  // The expectations above depend on the order of the requests.
+  auto res = ComposeMany(client, "test-bucket", sources, "prefix", "dest",
+                         false, MaxConcurrentComposes(1));
+  EXPECT_STATUS_OK(res);
+  EXPECT_EQ("dest", res->name());
+}
+
+TEST_F(ObjectTest, ComposeManyBalancedConcurrent) {
+  auto mock = std::make_shared<testing::MockClient>();
+  auto const mock_options = ClientOptions(oauth2::CreateAnonymousCredentials());
+  EXPECT_CALL(*mock, client_options()).WillRepeatedly(ReturnRef(mock_options));
+
+  // Test 65 sources, which should be split in groups of 22, 22, and 21 objects,
+  // composed with at most 2 concurrent requests.
+  std::map<std::string, std::vector<std::string>> expected;
+  int next_source = 0;
+  for (int i = 0; i != 3; ++i) {
+    auto& names = expected["prefix.compose-tmp-" + std::to_string(i)];
+    for (int j = 0; j != (i == 2 ? 21 : 22); ++j) {
+      names.push_back(std::to_string(next_source++));
+    }
+    expected["dest"].push_back("prefix.compose-tmp-" + std::to_string(i));
+  }
+
+  std::mutex mu;
+  std::vector<std::string> composed;
+  std::atomic<int> running{0};
+  std::atomic<int> max_running{0};
+  EXPECT_CALL(*mock, ComposeObject(_))
+      .Times(4)
+      .WillRepeatedly(Invoke([&](internal::ComposeObjectRequest const& req)
+                                 -> StatusOr<ObjectMetadata> {
+        auto const r = ++running;
+        auto m = max_running.load();
+        while (r > m && !max_running.compare_exchange_weak(m, r)) {
+        }
+        std::this_thread::sleep_for(ms(10));
+
+        EXPECT_EQ("test-bucket", req.bucket_name());
+        internal::nl::json parsed =
+            internal::nl::json::parse(req.JsonPayload());
+        std::vector<std::string> names;
+        for (auto const& s : parsed["sourceObjects"]) {
+          names.push_back(s["name"].get<std::string>());
+        }
+        EXPECT_EQ(expected.at(req.object_name()), names);
+        {
+          std::lock_guard<std::mutex> lk(mu);
+          composed.push_back(req.object_name());
+        }
+        --running;
+        return MockObject(req.bucket_name(), req.object_name(), 42);
+      }));
+  EXPECT_CALL(*mock, InsertObjectMedia(_))
+      .WillOnce(
+          Return(make_status_or(MockObject("test-bucket", "prefix", 42))));
+  ::testing::InSequence sequence;
+  EXPECT_CALL(*mock, ExecuteBatch(_))
+      .WillOnce(Invoke([](internal::BatchRequest const& r) {
+        EXPECT_THAT(
+            BatchPaths(r),
+            ElementsAre(
+                "/b/test-bucket/o/prefix.compose-tmp-0?ifGenerationMatch=42",
+                "/b/test-bucket/o/prefix.compose-tmp-1?ifGenerationMatch=42",
+                "/b/test-bucket/o/prefix.compose-tmp-2?ifGenerationMatch=42"));
+        return make_status_or(MockBatchResponse({204, 204, 204}));
+      }));
+  EXPECT_CALL(*mock, DeleteObject(_))
+      .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
+        EXPECT_EQ("prefix", r.object_name());
+        return make_status_or(internal::EmptyResponse{});
+      }));
+
+  Client client(mock);
+
+  std::vector<ComposeSourceObject> sources;
+  std::size_t i = 0;
+  std::generate_n(std::back_inserter(sources), 65, [&i] {
+    return ComposeSourceObject{std::to_string(i++), 42, {}};
+  });
+
+  auto res = ComposeMany(client, "test-bucket", sources, "prefix", "dest",
+                         false, MaxConcurrentComposes(2));
+  ASSERT_STATUS_OK(res);
+  EXPECT_EQ("dest", res->name());
+  EXPECT_LE(max_running.load(), 2);
+  ASSERT_EQ(4, composed.size());
+  EXPECT_EQ("dest", composed.back());
+}
+
+TEST_F(ObjectTest, ComposeManyStopsAfterFailure) {
+  auto mock = std::make_shared<testing::MockClient>();
+  auto const mock_options = ClientOptions(oauth2::CreateAnonymousCredentials());
+  EXPECT_CALL(*mock, client_options()).WillRepeatedly(ReturnRef(mock_options));
+
+  // Test 65 sources, the second group fails and the third group never starts.
+  EXPECT_CALL(*mock, ComposeObject(_))
+      .WillOnce(Return(make_status_or(
+          MockObject("test-bucket", "prefix.compose-tmp-0", 42))))
+      .WillOnce(Return(
+          StatusOr<ObjectMetadata>(Status(StatusCode::kPermissionDenied, ""))));
+  EXPECT_CALL(*mock, InsertObjectMedia(_))
+      .WillOnce(
+          Return(make_status_or(MockObject("test-bucket", "prefix", 42))));
+  ::testing::InSequence sequence;
+  EXPECT_CALL(*mock, DeleteObject(_))
       .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
-        EXPECT_EQ("test-bucket", r.bucket_name());
         EXPECT_EQ("prefix.compose-tmp-0", r.object_name());
         return make_status_or(internal::EmptyResponse{});
       }))
       .WillOnce(Invoke([](internal::DeleteObjectRequest const& r) {
-        EXPECT_EQ("test-bucket", r.bucket_name());
         EXPECT_EQ("prefix", r.object_name());
         return make_status_or(internal::EmptyResponse{});
       }));
@@ -780,16 +991,15 @@ TEST_F(ObjectTest, ComposeManyThreeLayers) {
   Client client(mock);
 
   std::vector<ComposeSourceObject> sources;
-
   std::size_t i = 0;
-  std::generate_n(std::back_inserter(sources), 63, [&i] {
+  std::generate_n(std::back_inserter(sources), 65, [&i] {
     return ComposeSourceObject{std::to_string(i++), 42, {}};
   });
 
-  auto res =
-      ComposeMany(client, "test-bucket", sources, "prefix", "dest", false);
-  EXPECT_STATUS_OK(res);
-  EXPECT_EQ("dest", res->name());
+  auto res = ComposeMany(client, "test-bucket", sources, "prefix", "dest",
+                         false, MaxConcurrentComposes(1));
+  EXPECT_FALSE(res);
+  EXPECT_EQ(StatusCode::kPermissionDenied, res.status().code());
 }
 
 TEST_F(ObjectTest, ComposeManyComposeFails) {
@@ -855,8 +1065,8 @@ TEST_F(ObjectTest, ComposeManyCleanupFailsLoudly) {
       .WillOnce(Return(make_status_or(MockObject("test-bucket", "dest", 42))));
 
   // Cleanup is still expected
-  EXPECT_CALL(*mock, DeleteObject(_))
-      .WillOnce(Return(StatusOr<internal::EmptyResponse>(
+  EXPECT_CALL(*mock, ExecuteBatch(_))
+      .WillOnce(Return(StatusOr<internal::BatchResponse>(
           Status(StatusCode::kPermissionDenied, ""))));
   EXPECT_CALL(*mock, InsertObjectMedia(_))
       .WillOnce(Invoke([](internal::InsertObjectMediaRequest const& request) {
@@ -895,8 +1105,8 @@ TEST_F(ObjectTest, ComposeManyCleanupFailsSilently) {
       .WillOnce(Return(make_status_or(MockObject("test-bucket", "dest", 42))));
 
   // Cleanup is still expected
-  EXPECT_CALL(*mock, DeleteObject(_))
-      .WillOnce(Return(StatusOr<internal::EmptyResponse>(
+  EXPECT_CALL(*mock, ExecuteBatch(_))
+      .WillOnce(Return(StatusOr<internal::BatchResponse>(
           Status(StatusCode::kPermissionDenied, ""))));
 
   EXPECT_CALL(*mock, InsertObjectMedia(_))
@@ -0,0 +1,227 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/parallel_download.h"
+#include "google/cloud/storage/internal/hash_validator_impl.h"
+#include <crc32c/crc32c.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#if _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif  // _WIN32
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+Status ErrnoStatus(char const* what) {
+  auto const error = errno;
+  return Status(StatusCode::kUnknown,
+                std::string(what) + "() failed: " + std::strerror(error));
+}
+
+/**
+ * A destination file where multiple threads write at independent offsets.
+ *
+ * On POSIX systems this uses `pwrite()`, so the threads do not need to
+ * synchronize. Windows does not have an equivalent function in its C runtime,
+ * so the writes are serialized with a mutex.
+ */
+class DestinationFile {
+ public:
+  DestinationFile() = default;
+  ~DestinationFile() { (void)Close(); }
+
+  DestinationFile(DestinationFile const&) = delete;
+  DestinationFile& operator=(DestinationFile const&) = delete;
+
+  Status Open(std::string const& file_name, std::uintmax_t size) {
+#if _WIN32
+    fd_ = _open(file_name.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                _S_IREAD | _S_IWRITE);
+    if (fd_ == -1) return ErrnoStatus("_open");
+    if (_chsize_s(fd_, static_cast<__int64>(size)) != 0) {
+      return ErrnoStatus("_chsize_s");
+    }
+#else
+    fd_ = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ == -1) return ErrnoStatus("open");
+    // Preallocate the file, the shards write to disjoint ranges and the file
+    // does not grow (and get its metadata updated) on every write.
+    if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+      return ErrnoStatus("ftruncate");
+    }
+#endif  // _WIN32
+    return Status();
+  }
+
+  Status WriteAt(char const* data, std::size_t size, std::uintmax_t offset) {
+#if _WIN32
+    std::lock_guard<std::mutex> lk(mu_);
+    if (_lseeki64(fd_, static_cast<__int64>(offset), SEEK_SET) == -1) {
+      return ErrnoStatus("_lseeki64");
+    }
+    while (size != 0) {
+      auto n = _write(fd_, data, static_cast<unsigned int>(size));
+      if (n == -1) return ErrnoStatus("_write");
+      data += n;
+      size -= static_cast<std::size_t>(n);
+    }
+#else
+    while (size != 0) {
+      auto n = ::pwrite(fd_, data, size, static_cast<off_t>(offset));
+      if (n == -1) {
+        if (errno == EINTR) continue;
+        return ErrnoStatus("pwrite");
+      }
+      data += n;
+      size -= static_cast<std::size_t>(n);
+      offset += static_cast<std::uintmax_t>(n);
+    }
+#endif  // _WIN32
+    return Status();
+  }
+
+  Status Close() {
+    if (fd_ == -1) return Status();
+    auto fd = fd_;
+    fd_ = -1;
+#if _WIN32
+    if (_close(fd) != 0) return ErrnoStatus("_close");
+#else
+    if (::close(fd) != 0) return ErrnoStatus("close");
+#endif  // _WIN32
+    return Status();
+  }
+
+ private:
+  int fd_ = -1;
+#if _WIN32
+  std::mutex mu_;
+#endif  // _WIN32
+};
+
+Status DownloadShard(DestinationFile& destination,
+                     ParallelDownloadRangeReader const& reader,
+                     CombinedCrc32cHashValidator* validator,
+                     std::uintmax_t begin, std::uintmax_t end,
+                     std::size_t buffer_size) {
+  if (begin == end) return Status();
+
+  auto stream = reader(static_cast<std::int64_t>(begin),
+                       static_cast<std::int64_t>(end));
+  if (!stream.status().ok()) return stream.status();
+
+  std::vector<char> buffer(buffer_size);
+  std::uint32_t crc32c = 0;
+  auto offset = begin;
+  while (stream.good() && offset < end) {
+    stream.read(buffer.data(), buffer.size());
+    auto const n = static_cast<std::size_t>(stream.gcount());
+    if (n == 0) break;
+    if (validator != nullptr) {
+      crc32c = crc32c::Extend(
+          crc32c, reinterpret_cast<std::uint8_t const*>(buffer.data()), n);
+    }
+    auto status = destination.WriteAt(buffer.data(), n, offset);
+    if (!status.ok()) return status;
+    offset += n;
+  }
+  if (!stream.status().ok()) return stream.status();
+  if (offset != end) {
+    std::ostringstream os;
+    os << "short read for range [" << begin << "," << end
+       << "), received bytes up to " << offset;
+    return Status(StatusCode::kDataLoss, std::move(os).str());
+  }
+  if (validator != nullptr) validator->AddRange(begin, end - begin, crc32c);
+  return Status();
+}
+}  // namespace
+
+Status ParallelDownloadFileImpl(ObjectMetadata const& metadata,
+                                std::string const& file_name,
+                                std::vector<std::uintmax_t> split_points,
+                                std::size_t buffer_size, bool disable_crc32c,
+                                ParallelDownloadRangeReader const& reader) {
+  auto report_error = [&metadata, &file_name](char const* what,
+                                              Status const& status) {
+    std::ostringstream msg;
+    msg << "ParallelDownloadFile(" << metadata.bucket() << ", "
+        << metadata.name() << ", " << file_name << "): " << what
+        << " - status.message=" << status.message();
+    return Status(status.code(), std::move(msg).str());
+  };
+
+  DestinationFile destination;
+  auto status = destination.Open(file_name, metadata.size());
+  if (!status.ok()) {
+    return report_error("cannot open download destination file", status);
+  }
+
+  // Each shard computes the checksum of its range, the validator combines
+  // them into the checksum of the full object.
+  CombinedCrc32cHashValidator validator;
+  auto* shard_validator = disable_crc32c ? nullptr : &validator;
+
+  split_points.push_back(metadata.size());
+  std::vector<Status> results(split_points.size());
+  std::vector<std::thread> threads;
+  threads.reserve(split_points.size());
+  std::uintmax_t begin = 0;
+  for (std::size_t i = 0; i != split_points.size(); ++i) {
+    auto const end = split_points[i];
+    threads.emplace_back([&, i, begin, end] {
+      results[i] = DownloadShard(destination, reader, shard_validator, begin,
+                                 end, buffer_size);
+    });
+    begin = end;
+  }
+  for (auto& t : threads) t.join();
+
+  status = destination.Close();
+  if (!status.ok()) {
+    return report_error("cannot close download destination file", status);
+  }
+  for (auto const& r : results) {
+    if (!r.ok()) return report_error("error reading download source object", r);
+  }
+  if (disable_crc32c) return Status();
+
+  validator.ProcessMetadata(metadata);
+  auto result = std::move(validator).Finish();
+  if (result.is_mismatch) {
+    return report_error(
+        "mismatched CRC32C checksum",
+        Status(StatusCode::kDataLoss, "computed=" + result.computed +
+                                          ", expected=" + result.received));
+  }
+  return Status();
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,144 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_PARALLEL_DOWNLOAD_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_PARALLEL_DOWNLOAD_H
+
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/internal/tuple_filter.h"
+#include "google/cloud/storage/object_stream.h"
+#include "google/cloud/storage/parallel_upload.h"
+#include "google/cloud/storage/version.h"
+#include "google/cloud/internal/tuple.h"
+#include "google/cloud/status.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+/// Returns a stream to read the `[begin, end)` range of the downloaded object.
+using ParallelDownloadRangeReader =
+    std::function<ObjectReadStream(std::int64_t begin, std::int64_t end)>;
+
+/**
+ * Downloads the object described by @p metadata into @p file_name.
+ *
+ * The object is split into shards at @p split_points, each shard is read using
+ * @p reader in a separate thread and written to its position in the
+ * destination file. Unless @p disable_crc32c is set, the CRC32C checksum of
+ * each shard is computed as it is downloaded, the checksums are combined and
+ * compared against the checksum in @p metadata.
+ */
+Status ParallelDownloadFileImpl(ObjectMetadata const& metadata,
+                                std::string const& file_name,
+                                std::vector<std::uintmax_t> split_points,
+                                std::size_t buffer_size, bool disable_crc32c,
+                                ParallelDownloadRangeReader const& reader);
+
+}  // namespace internal
+
+/**
+ * Downloads a Cloud Storage object to a file using multiple streams.
+ *
+ * The object is split into ranges, and each range is downloaded concurrently
+ * by a separate thread, writing directly to its final position in the
+ * destination file. This can be significantly faster than
+ * `Client::DownloadToFile()` for large objects, as a single stream is rarely
+ * able to saturate the network.
+ *
+ * All the ranges are read from the same object generation, even if the object
+ * is replaced while the download is in progress. Each range is retried (and
+ * resumed from the last received byte) using the policies in @p client. The
+ * CRC32C checksum of each range is computed as the range is received, and the
+ * results are combined to validate the full object.
+ *
+ * You can affect how many ranges will be created by using the `MaxStreams` and
+ * `MinStreamSize` options. Use `ClientOptions::set_connection_pool_size()` to
+ * keep at least `MaxStreams` connections in the pool, otherwise some
+ * connections are closed after each download.
+ *
+ * @param client the client on which to perform the operation.
+ * @param bucket_name the name of the bucket that contains the object.
+ * @param object_name the name of the object to be downloaded.
+ * @param file_name the name of the destination file, the file is truncated if
+ *     it exists.
+ * @param options a list of optional query parameters and/or request headers.
+ *     Valid types for this operation include `DisableCrc32cChecksum`,
+ *     `EncryptionKey`, `Generation`, `IfGenerationMatch`,
+ *     `IfGenerationNotMatch`, `IfMetagenerationMatch`,
+ *     `IfMetagenerationNotMatch`, `MaxStreams`, `MinStreamSize`, and
+ *     `UserProject`.
+ *
+ * @par Idempotency
+ * This is a read-only operation and is always idempotent.
+ */
+template <typename... Options>
+Status ParallelDownloadFile(Client client, std::string const& bucket_name,
+                           std::string const& object_name,
+                           std::string const& file_name,
+                           Options&&... options) {
+  using internal::Among;
+  using internal::StaticTupleFilter;
+
+  auto metadata = google::cloud::internal::apply(
+      internal::GetObjectMetadataApplyHelper{client, bucket_name, object_name},
+      StaticTupleFilter<
+          Among<Generation, IfGenerationMatch, IfGenerationNotMatch,
+                IfMetagenerationMatch, IfMetagenerationNotMatch,
+                UserProject>::TPred>(std::tie(options...)));
+  if (!metadata) return std::move(metadata).status();
+
+  auto const disable_crc32c_option =
+      internal::ExtractFirstOccurenceOfType<DisableCrc32cChecksum>(
+          std::tie(options...));
+  bool const disable_crc32c = disable_crc32c_option.has_value() &&
+                              disable_crc32c_option->has_value() &&
+                              disable_crc32c_option->value();
+  auto const split_points = internal::ComputeParallelFileUploadSplitPoints(
+      metadata->size(), std::tie(options...));
+
+  // Pin the generation, so all the ranges are read from the same object even
+  // if it is replaced during the download. The ranges cannot be validated
+  // individually, the full object checksum is validated at the end.
+  auto read_options = std::tuple_cat(
+      std::make_tuple(Generation(metadata->generation()),
+                      DisableCrc32cChecksum(true), DisableMD5Hash(true)),
+      StaticTupleFilter<Among<EncryptionKey, UserProject>::TPred>(
+          std::tie(options...)));
+  auto reader = [&client, &bucket_name, &object_name, &read_options](
+                    std::int64_t begin, std::int64_t end) {
+    return google::cloud::internal::apply(
+        internal::ReadObjectApplyHelper{client, bucket_name, object_name},
+        std::tuple_cat(std::make_tuple(ReadRange(begin, end)), read_options));
+  };
+
+  return internal::ParallelDownloadFileImpl(
+      *metadata, file_name, split_points,
+      client.raw_client()->client_options().download_buffer_size(),
+      disable_crc32c, reader);
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_PARALLEL_DOWNLOAD_H
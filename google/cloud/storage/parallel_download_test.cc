@@ -0,0 +1,249 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/parallel_download.h"
+#include "google/cloud/storage/oauth2/google_credentials.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/storage/testing/random_names.h"
+#include "google/cloud/internal/random.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include "absl/memory/memory.h"
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <set>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::testing::_;
+using ::testing::HasSubstr;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+std::string const kBucketName = "test-bucket";
+std::string const kObjectName = "test-object";
+std::int64_t const kGeneration = 1234;
+
+std::string MakeContents(std::size_t size) {
+  std::string contents;
+  for (std::size_t i = 0; i != size; ++i) {
+    contents.push_back(static_cast<char>('a' + i % 26));
+  }
+  return contents;
+}
+
+ObjectMetadata MockObject(std::size_t size, std::string const& crc32c) {
+  auto metadata = internal::ObjectMetadataParser::FromJson(internal::nl::json{
+      {"bucket", kBucketName},
+      {"name", kObjectName},
+      {"generation", kGeneration},
+      {"size", size},
+      {"crc32c", crc32c},
+  });
+  EXPECT_STATUS_OK(metadata);
+  return *metadata;
+}
+
+std::unique_ptr<ObjectReadSource> MakeSource(std::string contents) {
+  auto source = absl::make_unique<testing::MockObjectReadSource>();
+  auto offset = std::make_shared<std::size_t>(0);
+  EXPECT_CALL(*source, IsOpen()).WillRepeatedly(Return(true));
+  EXPECT_CALL(*source, Read(_, _))
+      .WillRepeatedly(Invoke([contents, offset](char* buf, std::size_t n) {
+        auto const count = (std::min)(n, contents.size() - *offset);
+        std::memcpy(buf, contents.data() + *offset, count);
+        *offset += count;
+        return ReadSourceResult{count, HttpResponse{200, "", {}}};
+      }));
+  EXPECT_CALL(*source, Close())
+      .WillRepeatedly(Return(HttpResponse{200, "", {}}));
+  return std::unique_ptr<ObjectReadSource>(std::move(source));
+}
+
+class ParallelDownloadTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    client_options_.SetDownloadBufferSize(64);
+    raw_client_mock_ = std::make_shared<testing::MockClient>();
+    EXPECT_CALL(*raw_client_mock_, client_options())
+        .WillRepeatedly(ReturnRef(client_options_));
+    client_ = absl::make_unique<Client>(
+        std::shared_ptr<internal::RawClient>(raw_client_mock_),
+        ExponentialBackoffPolicy(std::chrono::milliseconds(1),
+                                 std::chrono::milliseconds(1), 2.0));
+    auto generator =
+        google::cloud::internal::DefaultPRNG(std::random_device{}());
+    file_name_ = ::testing::TempDir() + testing::MakeRandomFileName(generator);
+  }
+
+  void TearDown() override {
+    std::remove(file_name_.c_str());
+    client_.reset();
+    raw_client_mock_.reset();
+  }
+
+  std::string ReadFile() const {
+    std::ifstream is(file_name_, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>{is}, {});
+  }
+
+  /// Setup the mock to return ranges of @p contents, return the ranges read.
+  std::shared_ptr<std::set<std::pair<std::int64_t, std::int64_t>>> ExpectReads(
+      std::string const& contents) {
+    auto ranges =
+        std::make_shared<std::set<std::pair<std::int64_t, std::int64_t>>>();
+    auto mu = std::make_shared<std::mutex>();
+    EXPECT_CALL(*raw_client_mock_, ReadObject(_))
+        .WillRepeatedly(
+            Invoke([contents, ranges, mu](ReadObjectRangeRequest const& r) {
+              EXPECT_EQ(kBucketName, r.bucket_name());
+              EXPECT_EQ(kObjectName, r.object_name());
+              EXPECT_TRUE(r.HasOption<Generation>());
+              EXPECT_EQ(kGeneration, r.GetOption<Generation>().value());
+              auto const range = r.GetOption<ReadRange>().value();
+              {
+                std::lock_guard<std::mutex> lk(*mu);
+                ranges->emplace(range.begin, range.end);
+              }
+              return StatusOr<std::unique_ptr<ObjectReadSource>>(
+                  MakeSource(contents.substr(range.begin,
+                                             range.end - range.begin)));
+            }));
+    return ranges;
+  }
+
+  ClientOptions client_options_ =
+      ClientOptions(oauth2::CreateAnonymousCredentials());
+  std::shared_ptr<testing::MockClient> raw_client_mock_;
+  std::unique_ptr<Client> client_;
+  std::string file_name_;
+};
+
+TEST_F(ParallelDownloadTest, Success) {
+  auto const contents = MakeContents(1000);
+  EXPECT_CALL(*raw_client_mock_, GetObjectMetadata(_))
+      .WillOnce(Return(
+          make_status_or(MockObject(1000, ComputeCrc32cChecksum(contents)))));
+  auto ranges = ExpectReads(contents);
+
+  auto status = ParallelDownloadFile(*client_, kBucketName, kObjectName,
+                                     file_name_, MaxStreams(4),
+                                     MinStreamSize(100));
+  ASSERT_STATUS_OK(status);
+  EXPECT_EQ(contents, ReadFile());
+  std::set<std::pair<std::int64_t, std::int64_t>> const expected{
+      {0, 250}, {250, 500}, {500, 750}, {750, 1000}};
+  EXPECT_EQ(expected, *ranges);
+}
+
+TEST_F(ParallelDownloadTest, ExistingFileIsTruncated) {
+  {
+    std::ofstream os(file_name_, std::ios::binary);
+    os << MakeContents(2000);
+  }
+  auto const contents = MakeContents(300);
+  EXPECT_CALL(*raw_client_mock_, GetObjectMetadata(_))
+      .WillOnce(Return(
+          make_status_or(MockObject(300, ComputeCrc32cChecksum(contents)))));
+  ExpectReads(contents);
+
+  auto status = ParallelDownloadFile(*client_, kBucketName, kObjectName,
+                                     file_name_, MinStreamSize(100));
+  ASSERT_STATUS_OK(status);
+  EXPECT_EQ(contents, ReadFile());
+}
+
+TEST_F(ParallelDownloadTest, EmptyObject) {
+  EXPECT_CALL(*raw_client_mock_, GetObjectMetadata(_))
+      .WillOnce(
+          Return(make_status_or(MockObject(0, ComputeCrc32cChecksum("")))));
+  EXPECT_CALL(*raw_client_mock_, ReadObject(_)).Times(0);
+
+  auto status =
+      ParallelDownloadFile(*client_, kBucketName, kObjectName, file_name_);
+  ASSERT_STATUS_OK(status);
+  EXPECT_EQ("", ReadFile());
+}
+
+TEST_F(ParallelDownloadTest, Crc32cMismatch) {
+  auto const contents = MakeContents(1000);
+  EXPECT_CALL(*raw_client_mock_, GetObjectMetadata(_))
+      .WillOnce(Return(make_status_or(
+          MockObject(1000, ComputeCrc32cChecksum("not the contents")))));
+  ExpectReads(contents);
+
+  auto status = ParallelDownloadFile(*client_, kBucketName, kObjectName,
+                                     file_name_, MinStreamSize(100));
+  EXPECT_EQ(StatusCode::kDataLoss, status.code());
+  EXPECT_THAT(status.message(), HasSubstr("mismatched CRC32C"));
+}
+
+TEST_F(ParallelDownloadTest, Crc32cDisabled) {
+  auto const contents = MakeContents(1000);
+  EXPECT_CALL(*raw_client_mock_, GetObjectMetadata(_))
+      .WillOnce(Return(make_status_or(
+          MockObject(1000, ComputeCrc32cChecksum("not the contents")))));
+  ExpectReads(contents);
+
+  auto status = ParallelDownloadFile(*client_, kBucketName, kObjectName,
+                                     file_name_, MinStreamSize(100),
+                                     DisableCrc32cChecksum(true));
+  ASSERT_STATUS_OK(status);
+  EXPECT_EQ(contents, ReadFile());
+}
+
+TEST_F(ParallelDownloadTest, MetadataFailure) {
+  EXPECT_CALL(*raw_client_mock_, GetObjectMetadata(_))
+      .WillOnce(Return(StatusOr<ObjectMetadata>(PermanentError())));
+  EXPECT_CALL(*raw_client_mock_, ReadObject(_)).Times(0);
+
+  auto status =
+      ParallelDownloadFile(*client_, kBucketName, kObjectName, file_name_);
+  EXPECT_EQ(PermanentError().code(), status.code());
+}
+
+TEST_F(ParallelDownloadTest, ReadFailure) {
+  auto const contents = MakeContents(1000);
+  EXPECT_CALL(*raw_client_mock_, GetObjectMetadata(_))
+      .WillOnce(Return(
+          make_status_or(MockObject(1000, ComputeCrc32cChecksum(contents)))));
+  EXPECT_CALL(*raw_client_mock_, ReadObject(_))
+      .WillRepeatedly(Invoke([](ReadObjectRangeRequest const&) {
+        return StatusOr<std::unique_ptr<ObjectReadSource>>(PermanentError());
+      }));
+
+  auto status = ParallelDownloadFile(*client_, kBucketName, kObjectName,
+                                     file_name_, MinStreamSize(100));
+  EXPECT_EQ(PermanentError().code(), status.code());
+  EXPECT_THAT(status.message(), HasSubstr("error reading download source"));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
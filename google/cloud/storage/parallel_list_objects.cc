@@ -0,0 +1,237 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/parallel_list_objects.h"
+#include "google/cloud/optional.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+// Each listing stops requesting pages once it has this many objects waiting
+// for the application. That is a few pages with the default page size.
+std::size_t constexpr kMaxBufferedObjects = 4096;
+// The discovery of the top-level objects and prefixes stops at this many
+// segments waiting for the application.
+std::size_t constexpr kMaxBufferedSegments = 4096;
+}  // namespace
+
+/**
+ * The shared state for the threads of a `ParallelListObjectsReader`.
+ *
+ * The objects are returned as a sequence of segments, in order. A segment is
+ * either an object found at the top level, or the listing of a prefix. The
+ * discovery thread appends segments as it reads the top-level pages, and the
+ * prefixes wait in `pending_` until a worker thread lists them. The
+ * application consumes the segment at the front of `segments_`.
+ */
+class ParallelListObjectsState {
+ public:
+  ParallelListObjectsState(std::shared_ptr<RawClient> client,
+                           ListObjectsRequest request, std::size_t max_streams)
+      : client_(std::move(client)),
+        request_(std::move(request)),
+        max_streams_((std::max)(max_streams, std::size_t{1})) {}
+
+  void Start() {
+    threads_.emplace_back([this] { Discover(); });
+    for (std::size_t i = 0; i != max_streams_; ++i) {
+      threads_.emplace_back([this] { Work(); });
+    }
+  }
+
+  /// Stops all the listings and waits for the threads.
+  void Shutdown() {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      cancelled_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : threads_) t.join();
+    threads_.clear();
+  }
+
+  /// Returns the next object, an error, or nothing at the end of the listing.
+  optional<StatusOr<ObjectMetadata>> Next() {
+    std::unique_lock<std::mutex> lk(mu_);
+    while (true) {
+      if (!status_.ok()) {
+        if (status_reported_) return {};
+        status_reported_ = true;
+        return StatusOr<ObjectMetadata>(status_);
+      }
+      if (segments_.empty()) {
+        if (discovery_done_) return {};
+        cv_.wait(lk);
+        continue;
+      }
+      auto& segment = *segments_.front();
+      if (!segment.items.empty()) {
+        auto object = std::move(segment.items.front());
+        segment.items.pop_front();
+        if (segment.items.size() + 1 == kMaxBufferedObjects) cv_.notify_all();
+        return StatusOr<ObjectMetadata>(std::move(object));
+      }
+      if (segment.done) {
+        segments_.pop_front();
+        if (segments_.size() + 1 == kMaxBufferedSegments) cv_.notify_all();
+        continue;
+      }
+      cv_.wait(lk);
+    }
+  }
+
+ private:
+  struct Segment {
+    std::string prefix;
+    std::deque<ObjectMetadata> items;
+    bool done = false;
+  };
+
+  /// Records the first error and stops all the listings, `lk` must be held.
+  void Fail(std::unique_lock<std::mutex> const&, Status status) {
+    if (status_.ok()) status_ = std::move(status);
+    cancelled_ = true;
+    cv_.notify_all();
+  }
+
+  /// Lists the top-level pages, creating the segments in order.
+  void Discover() {
+    auto request = request_;
+    do {
+      std::unique_lock<std::mutex> lk(mu_);
+      cv_.wait(lk, [this] {
+        return cancelled_ || segments_.size() < kMaxBufferedSegments;
+      });
+      if (cancelled_) return;
+      lk.unlock();
+      auto response = client_->ListObjects(request);
+      lk.lock();
+      if (!response) return Fail(lk, std::move(response).status());
+      // The objects and the prefixes in each page are sorted, and together
+      // they are sorted with the rest of the pages. A prefix sorts before all
+      // the names that start with it.
+      auto item = response->items.begin();
+      auto prefix = response->prefixes.begin();
+      while (item != response->items.end() ||
+             prefix != response->prefixes.end()) {
+        auto segment = std::make_shared<Segment>();
+        if (prefix == response->prefixes.end() ||
+            (item != response->items.end() && item->name() < *prefix)) {
+          segment->items.push_back(std::move(*item++));
+          segment->done = true;
+        } else {
+          segment->prefix = std::move(*prefix++);
+          pending_.push_back(segment);
+        }
+        segments_.push_back(std::move(segment));
+      }
+      cv_.notify_all();
+      request.set_page_token(std::move(response->next_page_token));
+    } while (!request.page_token().empty());
+    std::lock_guard<std::mutex> lk(mu_);
+    discovery_done_ = true;
+    cv_.notify_all();
+  }
+
+  /// Lists the pending prefixes until there are none left.
+  void Work() {
+    std::unique_lock<std::mutex> lk(mu_);
+    while (true) {
+      cv_.wait(lk, [this] {
+        return cancelled_ || !pending_.empty() || discovery_done_;
+      });
+      if (cancelled_ || pending_.empty()) return;
+      auto segment = std::move(pending_.front());
+      pending_.pop_front();
+      auto request = request_;
+      request.set_option(Prefix(segment->prefix));
+      request.set_option(Delimiter());
+      do {
+        // The application consumes the segments in order, and the prefixes
+        // are assigned in order, so the segment it waits for always has a
+        // worker, and this wait cannot block it.
+        cv_.wait(lk, [this, &segment] {
+          return cancelled_ || segment->items.size() < kMaxBufferedObjects;
+        });
+        if (cancelled_) return;
+        lk.unlock();
+        auto response = client_->ListObjects(request);
+        lk.lock();
+        if (!response) return Fail(lk, std::move(response).status());
+        std::move(response->items.begin(), response->items.end(),
+                  std::back_inserter(segment->items));
+        cv_.notify_all();
+        request.set_page_token(std::move(response->next_page_token));
+      } while (!request.page_token().empty());
+      segment->done = true;
+      cv_.notify_all();
+    }
+  }
+
+  std::shared_ptr<RawClient> const client_;
+  ListObjectsRequest const request_;
+  std::size_t const max_streams_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<std::shared_ptr<Segment>> segments_;
+  std::deque<std::shared_ptr<Segment>> pending_;
+  bool discovery_done_ = false;
+  bool cancelled_ = false;
+  Status status_;
+  bool status_reported_ = false;
+};
+
+ParallelListObjectsReader ParallelListObjectsImpl(
+    std::shared_ptr<RawClient> client, ListObjectsRequest request,
+    std::size_t max_streams) {
+  auto state = std::make_shared<ParallelListObjectsState>(
+      std::move(client), std::move(request), max_streams);
+  state->Start();
+  return ParallelListObjectsReader(std::move(state));
+}
+
+}  // namespace internal
+
+ParallelListObjectsReader::ParallelListObjectsReader(
+    std::shared_ptr<internal::ParallelListObjectsState> state)
+    : state_(std::move(state)) {}
+
+ParallelListObjectsReader::~ParallelListObjectsReader() {
+  // A moved-from reader has no state.
+  if (state_) state_->Shutdown();
+}
+
+ParallelListObjectsReader::iterator ParallelListObjectsReader::GetNext() {
+  auto next = state_->Next();
+  if (!next) return iterator{};
+  return iterator(this, *std::move(next));
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
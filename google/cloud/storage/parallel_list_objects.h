@@ -0,0 +1,170 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_PARALLEL_LIST_OBJECTS_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_PARALLEL_LIST_OBJECTS_H
+
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/internal/range_from_pagination.h"
+#include "google/cloud/storage/internal/tuple_filter.h"
+#include "google/cloud/storage/parallel_upload.h"
+#include "google/cloud/storage/version.h"
+#include "google/cloud/status_or.h"
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+class ParallelListObjectsState;
+
+struct ListObjectsSetOptionsApplyHelper {
+  template <typename... Options>
+  void operator()(Options&&... options) const {
+    request.set_multiple_options(std::forward<Options>(options)...);
+  }
+
+  ListObjectsRequest& request;
+};
+}  // namespace internal
+
+/**
+ * The objects returned by `ParallelListObjects()`, as an input range.
+ *
+ * The listings run in background threads, owned by this object. Each listing
+ * buffers a bounded number of objects ahead of the application, so the memory
+ * usage does not grow with the size of the bucket. The destructor stops the
+ * listings and waits for the threads.
+ */
+class ParallelListObjectsReader {
+ public:
+  explicit ParallelListObjectsReader(
+      std::shared_ptr<internal::ParallelListObjectsState> state);
+  ParallelListObjectsReader(ParallelListObjectsReader&&) = default;
+  ParallelListObjectsReader& operator=(ParallelListObjectsReader&&) = delete;
+  ~ParallelListObjectsReader();
+
+  /// The iterator type for this range.
+  using iterator =
+      internal::PaginationIterator<ObjectMetadata, ParallelListObjectsReader>;
+
+  /**
+   * Return an iterator over the objects, in the order returned by
+   * `Client::ListObjects()`.
+   *
+   * The returned iterator is a single-pass input iterator. If any listing
+   * fails the iterator points to the error, and the range ends after it.
+   */
+  iterator begin() { return GetNext(); }
+
+  /// Return an iterator pointing to the end of the range.
+  iterator end() { return iterator{}; }
+
+ private:
+  friend class internal::PaginationIterator<ObjectMetadata,
+                                            ParallelListObjectsReader>;
+
+  iterator GetNext();
+
+  std::shared_ptr<internal::ParallelListObjectsState> state_;
+};
+
+namespace internal {
+/**
+ * Lists all the objects matching @p request using up to @p max_streams threads.
+ *
+ * The @p request must have a `Delimiter`. A first listing with that delimiter
+ * discovers the objects and the prefixes at the top level, then each prefix is
+ * listed (without a delimiter) by one of the threads. The listing of each
+ * prefix is already sorted, and all the names in it sort between the
+ * top-level entries around the prefix, so the listings are merged by
+ * returning them one after the other.
+ */
+ParallelListObjectsReader ParallelListObjectsImpl(
+    std::shared_ptr<RawClient> client, ListObjectsRequest request,
+    std::size_t max_streams);
+
+}  // namespace internal
+
+/**
+ * Lists all the objects in a bucket using multiple streams.
+ *
+ * `Client::ListObjects()` returns the objects one page at a time, and each
+ * page request requires the token returned with the previous page, so listing
+ * a bucket with millions of objects is bounded by the round-trip time. This
+ * function partitions the listing: it first lists the bucket using a
+ * delimiter to discover the top-level prefixes (think "directories"), and then
+ * lists the objects under each prefix concurrently.
+ *
+ * The partitioning is only as good as the object naming scheme. Buckets with
+ * few prefixes, or where most objects share a prefix, do not benefit from this
+ * function.
+ *
+ * The delimiter used to discover the prefixes is `/` unless the application
+ * provides a `Delimiter` option. Use `MaxStreams` to limit the number of
+ * concurrent listings of prefixes.
+ *
+ * @param client the client on which to perform the operation.
+ * @param bucket_name the name of the bucket to list.
+ * @param options a list of optional query parameters and/or request headers.
+ *     Valid types for this operation include `Delimiter`, `MaxResults`,
+ *     `MaxStreams`, `Prefix`, `Projection`, `UserProject`, and `Versions`, as
+ *     well as the parameters valid for all requests, such as `QuotaUser`.
+ *     Other types are rejected at compile time, as in `Client::ListObjects()`.
+ *
+ * @return a range with all the objects, sorted by name. The objects are
+ *     returned as the listings progress. If any of the listings fails the
+ *     range contains the error, and no objects after it.
+ *
+ * @par Idempotency
+ * This is a read-only operation and is always idempotent.
+ */
+template <typename... Options>
+ParallelListObjectsReader ParallelListObjects(Client client,
+                                              std::string const& bucket_name,
+                                              Options&&... options) {
+  using internal::NotAmong;
+  using internal::StaticTupleFilter;
+
+  internal::ListObjectsRequest request(bucket_name);
+  request.set_option(Delimiter("/"));
+  // `MaxStreams` is the only option that is not a request parameter, all the
+  // others are applied to the requests, which fail to compile if an option
+  // is not supported.
+  google::cloud::internal::apply(
+      internal::ListObjectsSetOptionsApplyHelper{request},
+      StaticTupleFilter<NotAmong<MaxStreams>::TPred>(std::tie(options...)));
+
+  // This default is arbitrary, the listings are small requests and are
+  // bounded by latency, not bandwidth.
+  MaxStreams const default_max_streams(16);
+  auto const max_streams =
+      internal::ExtractFirstOccurenceOfType<MaxStreams>(std::tie(options...))
+          .value_or(default_max_streams)
+          .value();
+
+  return internal::ParallelListObjectsImpl(client.raw_client(),
+                                           std::move(request), max_streams);
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_PARALLEL_LIST_OBJECTS_H
@@ -0,0 +1,224 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/parallel_list_objects.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include "absl/memory/memory.h"
+#include <gmock/gmock.h>
+#include <map>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Invoke;
+using ::testing::Return;
+
+ObjectMetadata CreateObject(std::string const& name) {
+  return ObjectMetadataParser::FromJson(
+             nl::json{{"bucket", "test-bucket"}, {"name", name}})
+      .value();
+}
+
+/// Reads all the objects, stops at the first error.
+StatusOr<std::vector<std::string>> Names(ParallelListObjectsReader reader) {
+  std::vector<std::string> names;
+  for (auto& o : reader) {
+    if (!o) return std::move(o).status();
+    names.push_back(o->name());
+  }
+  return names;
+}
+
+class ParallelListObjectsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    raw_client_mock_ = std::make_shared<testing::MockClient>();
+    client_ = absl::make_unique<Client>(
+        std::shared_ptr<internal::RawClient>(raw_client_mock_),
+        Client::NoDecorations{});
+  }
+
+  std::shared_ptr<testing::MockClient> raw_client_mock_;
+  std::unique_ptr<Client> client_;
+};
+
+std::string PrefixOf(ListObjectsRequest const& r) {
+  return r.HasOption<Prefix>() ? r.GetOption<Prefix>().value() : "";
+}
+
+/// A fake bucket with a few "directories", each listing returns one object.
+StatusOr<ListObjectsResponse> FakeListing(ListObjectsRequest const& r) {
+  EXPECT_EQ("test-bucket", r.bucket_name());
+  auto const prefix = PrefixOf(r);
+  std::map<std::string, std::vector<std::string>> const pages{
+      {"", {"a/", "b/", "c/"}},
+      {"a/", {"a/1", "a/2", "a/3"}},
+      {"b/", {"b/1"}},
+      {"c/", {"c/1/x", "c/2"}},
+  };
+  ListObjectsResponse response;
+  if (r.HasOption<Delimiter>()) {
+    EXPECT_EQ("", prefix);
+    EXPECT_EQ("/", r.GetOption<Delimiter>().value());
+    response.items.push_back(CreateObject("top"));
+    response.prefixes = pages.at("");
+    return response;
+  }
+  auto const& names = pages.at(prefix);
+  auto const index = r.page_token().empty() ? 0 : std::stoul(r.page_token());
+  response.items.push_back(CreateObject(names.at(index)));
+  if (index + 1 < names.size()) {
+    response.next_page_token = std::to_string(index + 1);
+  }
+  return response;
+}
+
+TEST_F(ParallelListObjectsTest, Success) {
+  EXPECT_CALL(*raw_client_mock_, ListObjects(_))
+      .WillRepeatedly(Invoke(FakeListing));
+
+  auto actual =
+      Names(ParallelListObjects(*client_, "test-bucket", MaxStreams(2)));
+  ASSERT_STATUS_OK(actual);
+  EXPECT_THAT(*actual, ElementsAre("a/1", "a/2", "a/3", "b/1", "c/1/x", "c/2",
+                                   "top"));
+}
+
+TEST_F(ParallelListObjectsTest, MergesTopLevelObjects) {
+  EXPECT_CALL(*raw_client_mock_, ListObjects(_))
+      .WillRepeatedly(Invoke([](ListObjectsRequest const& r) {
+        ListObjectsResponse response;
+        if (PrefixOf(r) == "a/") {
+          response.items.push_back(CreateObject("a/1"));
+          return make_status_or(response);
+        }
+        if (PrefixOf(r) == "c/") {
+          response.items.push_back(CreateObject("c/1"));
+          return make_status_or(response);
+        }
+        // The top level has two pages, with objects before, between, and
+        // after the prefixes.
+        if (r.page_token().empty()) {
+          response.items.push_back(CreateObject("a.txt"));
+          response.items.push_back(CreateObject("b"));
+          response.prefixes.emplace_back("a/");
+          response.next_page_token = "1";
+          return make_status_or(response);
+        }
+        response.items.push_back(CreateObject("bb"));
+        response.items.push_back(CreateObject("d"));
+        response.prefixes.emplace_back("c/");
+        return make_status_or(response);
+      }));
+
+  auto actual =
+      Names(ParallelListObjects(*client_, "test-bucket", MaxStreams(2)));
+  ASSERT_STATUS_OK(actual);
+  EXPECT_THAT(*actual, ElementsAre("a.txt", "a/1", "b", "bb", "c/1", "d"));
+}
+
+TEST_F(ParallelListObjectsTest, UsesOptions) {
+  EXPECT_CALL(*raw_client_mock_, ListObjects(_))
+      .WillRepeatedly(Invoke([](ListObjectsRequest const& r) {
+        EXPECT_EQ("-", r.GetOption<Delimiter>().value());
+        EXPECT_EQ("p/", PrefixOf(r));
+        EXPECT_TRUE(r.GetOption<Versions>().value());
+        EXPECT_EQ("test-quota-user", r.GetOption<QuotaUser>().value());
+        ListObjectsResponse response;
+        response.items.push_back(CreateObject("p/1"));
+        return make_status_or(response);
+      }));
+
+  auto actual = Names(ParallelListObjects(*client_, "test-bucket",
+                                          Prefix("p/"), Delimiter("-"),
+                                          Versions(true),
+                                          QuotaUser("test-quota-user")));
+  ASSERT_STATUS_OK(actual);
+  EXPECT_THAT(*actual, ElementsAre("p/1"));
+}
+
+TEST_F(ParallelListObjectsTest, DiscoveryFailure) {
+  EXPECT_CALL(*raw_client_mock_, ListObjects(_))
+      .WillOnce(Return(StatusOr<ListObjectsResponse>(PermanentError())));
+
+  auto actual = Names(ParallelListObjects(*client_, "test-bucket"));
+  EXPECT_EQ(PermanentError().code(), actual.status().code());
+}
+
+TEST_F(ParallelListObjectsTest, PartitionFailure) {
+  EXPECT_CALL(*raw_client_mock_, ListObjects(_))
+      .WillRepeatedly(Invoke([](ListObjectsRequest const& r) {
+        if (PrefixOf(r) == "b/") {
+          return StatusOr<ListObjectsResponse>(PermanentError());
+        }
+        return FakeListing(r);
+      }));
+
+  auto reader = ParallelListObjects(*client_, "test-bucket", MaxStreams(1));
+  std::vector<std::string> names;
+  Status status;
+  for (auto& o : reader) {
+    if (!o) {
+      status = std::move(o).status();
+      continue;
+    }
+    EXPECT_TRUE(status.ok()) << "object " << o->name() << " after the error";
+    names.push_back(o->name());
+  }
+  EXPECT_EQ(PermanentError().code(), status.code());
+  // The objects before the failed prefix may or may not be returned, but
+  // none of the objects after it.
+  for (auto const& n : names) EXPECT_EQ('a', n[0]);
+}
+
+TEST_F(ParallelListObjectsTest, DestructorStopsListing) {
+  // Each prefix has an endless listing, the application stops reading.
+  EXPECT_CALL(*raw_client_mock_, ListObjects(_))
+      .WillRepeatedly(Invoke([](ListObjectsRequest const& r) {
+        ListObjectsResponse response;
+        if (r.HasOption<Delimiter>()) {
+          response.prefixes = {"a/", "b/"};
+          return make_status_or(response);
+        }
+        auto const index =
+            r.page_token().empty() ? 0 : std::stoul(r.page_token());
+        response.items.push_back(
+            CreateObject(PrefixOf(r) + std::to_string(index)));
+        response.next_page_token = std::to_string(index + 1);
+        return make_status_or(response);
+      }));
+
+  auto reader = ParallelListObjects(*client_, "test-bucket", MaxStreams(2));
+  auto it = reader.begin();
+  ASSERT_NE(it, reader.end());
+  ASSERT_STATUS_OK(*it);
+  EXPECT_EQ("a/0", (*it)->name());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "google/cloud/storage/parallel_upload.h"
+#include "google/cloud/storage/internal/hash_validator_impl.h"
 #include "absl/memory/memory.h"
 
 namespace google {
@@ -20,6 +21,22 @@ namespace cloud {
 namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace internal {
+namespace {
+// Composed objects do not have MD5 hashes, and their CRC32C checksum is
+// validated by combining the checksums of each stream (see
+// `ValidateComposedChecksum()`). Computing the MD5 hash of each stream wastes
+// CPU, unless the application explicitly requests it, or disables the CRC32C
+// checksums.
+std::unique_ptr<HashValidator> CreateStreamHashValidator(
+    ResumableUploadRequest const& request) {
+  auto disable_crc32c = request.HasOption<DisableCrc32cChecksum>() &&
+                        request.GetOption<DisableCrc32cChecksum>().value();
+  if (!disable_crc32c && !request.HasOption<DisableMD5Hash>()) {
+    return absl::make_unique<Crc32cHashValidator>();
+  }
+  return CreateHashValidator(request);
+}
+}  // namespace
 
 class ParallelObjectWriteStreambuf : public ObjectWriteStreambuf {
  public:
@@ -79,14 +96,13 @@ StatusOr<ObjectWriteStream> ParallelUploadStateImpl::CreateStream(
 
   auto idx = streams_.size();
   ++num_unfinished_streams_;
-  streams_.emplace_back(
-      StreamInfo{request.object_name(), (*session)->session_id(), {}, false});
+  streams_.emplace_back(StreamInfo{request.object_name(),
+                                   (*session)->session_id(), {}, false, 0, {}});
   assert(idx < streams_.size());
   lk.unlock();
   return ObjectWriteStream(absl::make_unique<ParallelObjectWriteStreambuf>(
       shared_from_this(), idx, *std::move(session),
-      raw_client.client_options().upload_buffer_size(),
-      CreateHashValidator(request)));
+      raw_client.upload_buffer_size(), CreateStreamHashValidator(request)));
 }
 
 std::string ParallelUploadPersistentState::ToString() const {
@@ -252,6 +268,8 @@ void ParallelUploadStateImpl::AllStreamsFinished(
     lk.lock();
     if (res) {
       deleter_->Enable(true);
+      auto status = ValidateComposedChecksum(*res);
+      if (!status.ok()) res = std::move(status);
     }
     res_ = std::move(res);
   }
@@ -285,6 +303,8 @@ void ParallelUploadStateImpl::StreamFinished(
     deleter_->Add(metadata);
     streams_[stream_idx].composition_arg =
         ComposeSourceObject{metadata.name(), metadata.generation(), {}};
+    streams_[stream_idx].size = metadata.size();
+    streams_[stream_idx].crc32c = metadata.crc32c();
   }
   if (num_unfinished_streams_ > 0) {
     return;
@@ -309,6 +329,31 @@ void ParallelUploadStateImpl::StreamDestroyed(std::size_t stream_idx) {
   }
 }
 
+Status ParallelUploadStateImpl::ValidateComposedChecksum(
+    ObjectMetadata const& composed) const {
+  // Each stream has validated its data against the checksum reported by the
+  // service. Combining those checksums validates the composed object
+  // end-to-end, without hashing the data a second time.
+  CombinedCrc32cHashValidator validator;
+  std::uint64_t offset = 0;
+  for (auto const& stream : streams_) {
+    auto crc32c = DecodeCrc32cChecksum(stream.crc32c);
+    // The checksums may be missing, e.g., if the application filtered the
+    // returned fields. Nothing to validate in that case.
+    if (!crc32c) return Status();
+    validator.AddRange(offset, stream.size, *crc32c);
+    offset += stream.size;
+  }
+  validator.ProcessMetadata(composed);
+  auto result = std::move(validator).Finish();
+  if (!result.is_mismatch) return Status();
+  return Status(StatusCode::kDataLoss,
+                "mismatched CRC32C checksum in composed object " +
+                    composed.bucket() + "/" + composed.name() +
+                    ", computed=" + result.computed +
+                    ", received=" + result.received);
+}
+
 future<StatusOr<ObjectMetadata>> ParallelUploadStateImpl::WaitForCompletion()
     const {
   std::unique_lock<std::mutex> lk(mu_);
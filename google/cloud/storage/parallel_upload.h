@@ -216,8 +216,14 @@ class ParallelUploadStateImpl
     std::string resumable_session_id;
     optional<ComposeSourceObject> composition_arg;
     bool finished;
+    // The size and CRC32C checksum of the uploaded stream, as reported by the
+    // service.
+    std::uint64_t size;
+    std::string crc32c;
   };
 
+  Status ValidateComposedChecksum(ObjectMetadata const& composed) const;
+
   mutable std::mutex mu_;
   // Promises made via `WaitForCompletion()`
   mutable std::vector<promise<StatusOr<ObjectMetadata>>> res_promises_;
@@ -1113,8 +1119,7 @@ StatusOr<std::vector<ParallelUploadFileShard>> CreateUploadShards(
 
   // Everything ready - we've got the shared state and the files open, let's
   // prepare the returned objects.
-  auto upload_buffer_size =
-      client.raw_client()->client_options().upload_buffer_size();
+  auto upload_buffer_size = client.raw_client()->upload_buffer_size();
 
   file_split_points.emplace_back(file_size);
   assert(file_split_points.size() == state->shards().size());
@@ -1150,6 +1155,11 @@ StatusOr<std::vector<ParallelUploadFileShard>> CreateUploadShards(
  * You can affect how many shards will be created by using the `MaxStreams` and
  * `MinStreamSize` options.
  *
+ * The CRC32C checksums of the shards are combined and compared against the
+ * checksum of the composed object. Composed objects do not have MD5 hashes, so
+ * the shards are only validated using CRC32C checksums, unless the
+ * `DisableMD5Hash` option is explicitly provided.
+ *
  * @param client the client on which to perform the operation.
  * @param file_name the path to the file to be uploaded
  * @param bucket_name the name of the bucket that will contain the object.
@@ -63,12 +63,16 @@ std::string ObjectId(std::string const& bucket, std::string const& object,
   return bucket + "/" + object + "/" + std::to_string(generation);
 }
 
-ObjectMetadata MockObject(std::string const& object_name, int generation) {
+// The CRC32C checksum of composed objects is validated against the combined
+// checksums of its sources. Combining any number of `AAAAAA==` checksums
+// produces `AAAAAA==`, so by default all the mock objects are consistent.
+ObjectMetadata MockObject(std::string const& object_name, int generation,
+                          std::string const& crc32c = "AAAAAA==") {
   auto metadata = internal::ObjectMetadataParser::FromJson(internal::nl::json{
       {"contentDisposition", "a-disposition"},
       {"contentLanguage", "a-language"},
       {"contentType", "application/octet-stream"},
-      {"crc32c", "d1e2f3"},
+      {"crc32c", crc32c},
       {"etag", "XYZ="},
       {"kind", "storage#object"},
       {"md5Hash", "xa1b2c3=="},
@@ -208,9 +212,9 @@ class ParallelUploadTest : public ::testing::Test {
       EXPECT_CALL(res, UploadFinalChunk(_, _))
           .WillOnce(
               Invoke([expected_content, object_name, generation](
-                         std::string const& content, std::uint64_t /*size*/) {
-                EXPECT_EQ(*expected_content, content);
-                EXPECT_EQ(expected_content->size(), content.size());
+                         internal::ConstBufferSequence const& content,
+                         std::uint64_t /*size*/) {
+                EXPECT_EQ(*expected_content, internal::ToString(content));
                 return make_status_or(
                     ResumableUploadResponse{"fake-url",
                                             0,
@@ -430,6 +434,48 @@ TEST_F(ParallelUploadTest, Success) {
   EXPECT_STATUS_OK(state->EagerCleanup());
 }
 
+TEST_F(ParallelUploadTest, ComposedChecksumMismatch) {
+  int const num_shards = 2;
+  // The expectations need to be reversed.
+  ExpectCreateSession(kPrefix + ".upload_shard_1", 222);
+  ExpectCreateSession(kPrefix + ".upload_shard_0", 111);
+
+  EXPECT_CALL(*raw_client_mock_, InsertObjectMedia(_))
+      .WillOnce(Invoke(expect_new_object(kPrefix, kUploadMarkerGeneration)))
+      .WillOnce(Invoke(expect_new_object(kPrefix + ".compose_many",
+                                         kComposeMarkerGeneration)));
+  EXPECT_CALL(*raw_client_mock_, ComposeObject(_))
+      .WillOnce(Invoke(create_composition_check(
+          {{kPrefix + ".upload_shard_0", 111},
+           {kPrefix + ".upload_shard_1", 222}},
+          kDestObjectName,
+          MockObject(kDestObjectName, kDestGeneration, "ImIEBA=="))));
+
+  ExpectedDeletions deletions({{{kPrefix + ".upload_shard_0", 111}, Status()},
+                               {{kPrefix + ".upload_shard_1", 222}, Status()}});
+  EXPECT_CALL(*raw_client_mock_, DeleteObject(_))
+      .WillOnce(Invoke(
+          expect_deletion(kPrefix + ".compose_many", kComposeMarkerGeneration)))
+      .WillOnce(Invoke([&deletions](internal::DeleteObjectRequest const& r) {
+        return deletions(r);
+      }))
+      .WillOnce(Invoke([&deletions](internal::DeleteObjectRequest const& r) {
+        return deletions(r);
+      }))
+      .WillOnce(Invoke(expect_deletion(kPrefix, kUploadMarkerGeneration)));
+
+  auto state = PrepareParallelUpload(*client_, kBucketName, kDestObjectName,
+                                     num_shards, kPrefix);
+  EXPECT_STATUS_OK(state);
+  auto res_future = state->WaitForCompletion();
+
+  state->shards().clear();
+  auto res = res_future.get();
+  ASSERT_FALSE(res);
+  EXPECT_EQ(StatusCode::kDataLoss, res.status().code());
+  EXPECT_THAT(res.status().message(), HasSubstr("mismatched CRC32C"));
+}
+
 TEST_F(ParallelUploadTest, OneStreamFailsUponCration) {
   int const num_shards = 3;
   // The expectations need to be reversed.
@@ -17,24 +17,34 @@
 """Automatically generated source lists for storage_client - DO NOT EDIT."""
 
 storage_client_hdrs = [
+    "async_client.h",
     "bucket_access_control.h",
     "bucket_metadata.h",
+    "bulk_rewrite.h",
     "client.h",
     "client_options.h",
+    "connection_pool_stats.h",
     "download_options.h",
     "hashing_options.h",
+    "hedging_policy.h",
     "hmac_key_metadata.h",
     "iam_policy.h",
     "idempotency_policy.h",
     "internal/access_control_common.h",
+    "internal/batch_requests.h",
     "internal/binary_data_as_debug_string.h",
     "internal/bucket_acl_requests.h",
     "internal/bucket_requests.h",
+    "internal/bulk_progress.h",
+    "internal/caching_client.h",
     "internal/common_metadata.h",
     "internal/complex_option.h",
     "internal/compute_engine_util.h",
+    "internal/const_buffer.h",
+    "internal/crc32c_combine.h",
     "internal/curl_client.h",
     "internal/curl_download_request.h",
+    "internal/curl_event_loop.h",
     "internal/curl_handle.h",
     "internal/curl_handle_factory.h",
     "internal/curl_request.h",
@@ -48,21 +58,27 @@ storage_client_hdrs = [
     "internal/generic_request.h",
     "internal/hash_validator.h",
     "internal/hash_validator_impl.h",
+    "internal/hedging_client.h",
     "internal/hmac_key_requests.h",
     "internal/http_response.h",
     "internal/logging_client.h",
     "internal/logging_resumable_upload_session.h",
     "internal/metadata_parser.h",
+    "internal/moving_average.h",
     "internal/nljson.h",
     "internal/notification_requests.h",
     "internal/object_acl_requests.h",
+    "internal/object_cache.h",
+    "internal/object_metadata_stream_parser.h",
     "internal/object_read_source.h",
     "internal/object_requests.h",
     "internal/object_streambuf.h",
     "internal/openssl_util.h",
     "internal/parameter_pack_validation.h",
     "internal/patch_builder.h",
+    "internal/pipelined_object_write_streambuf.h",
     "internal/policy_document_request.h",
+    "internal/prefetching_page_loader.h",
     "internal/range_from_pagination.h",
     "internal/raw_client.h",
     "internal/raw_client_wrapper_utils.h",
@@ -74,10 +90,12 @@ storage_client_hdrs = [
     "internal/sha256_hash.h",
     "internal/sign_blob_requests.h",
     "internal/signed_url_requests.h",
+    "internal/transfer_tuner.h",
     "internal/tuple_filter.h",
     "lifecycle_rule.h",
     "list_buckets_reader.h",
     "list_hmac_keys_reader.h",
+    "list_objects_options.h",
     "list_objects_reader.h",
     "notification_event_type.h",
     "notification_metadata.h",
@@ -96,13 +114,18 @@ storage_client_hdrs = [
     "object_rewriter.h",
     "object_stream.h",
     "override_default_project.h",
+    "parallel_download.h",
+    "parallel_list_objects.h",
     "parallel_upload.h",
     "policy_document.h",
     "retry_policy.h",
     "service_account.h",
     "signed_url_options.h",
     "storage_class.h",
+    "transport_routing_policy.h",
+    "upload_directory.h",
     "upload_options.h",
+    "v4_url_signer.h",
     "version.h",
     "version_info.h",
     "well_known_headers.h",
@@ -110,21 +133,29 @@ storage_client_hdrs = [
 ]
 
 storage_client_srcs = [
+    "async_client.cc",
     "bucket_access_control.cc",
     "bucket_metadata.cc",
+    "bulk_rewrite.cc",
     "client.cc",
     "client_options.cc",
     "hashing_options.cc",
+    "hedging_policy.cc",
     "hmac_key_metadata.cc",
     "iam_policy.cc",
     "idempotency_policy.cc",
     "internal/access_control_common.cc",
+    "internal/batch_requests.cc",
     "internal/binary_data_as_debug_string.cc",
     "internal/bucket_acl_requests.cc",
     "internal/bucket_requests.cc",
+    "internal/caching_client.cc",
     "internal/compute_engine_util.cc",
+    "internal/const_buffer.cc",
+    "internal/crc32c_combine.cc",
     "internal/curl_client.cc",
     "internal/curl_download_request.cc",
+    "internal/curl_event_loop.cc",
     "internal/curl_handle.cc",
     "internal/curl_handle_factory.cc",
     "internal/curl_request.cc",
@@ -135,6 +166,7 @@ storage_client_srcs = [
     "internal/empty_response.cc",
     "internal/hash_validator.cc",
     "internal/hash_validator_impl.cc",
+    "internal/hedging_client.cc",
     "internal/hmac_key_requests.cc",
     "internal/http_response.cc",
     "internal/logging_client.cc",
@@ -142,9 +174,12 @@ storage_client_srcs = [
     "internal/metadata_parser.cc",
     "internal/notification_requests.cc",
     "internal/object_acl_requests.cc",
+    "internal/object_cache.cc",
+    "internal/object_metadata_stream_parser.cc",
     "internal/object_requests.cc",
     "internal/object_streambuf.cc",
     "internal/openssl_util.cc",
+    "internal/pipelined_object_write_streambuf.cc",
     "internal/policy_document_request.cc",
     "internal/resumable_upload_session.cc",
     "internal/retry_client.cc",
@@ -154,6 +189,7 @@ storage_client_srcs = [
     "internal/sha256_hash.cc",
     "internal/sign_blob_requests.cc",
     "internal/signed_url_requests.cc",
+    "internal/transfer_tuner.cc",
     "lifecycle_rule.cc",
     "list_buckets_reader.cc",
     "list_hmac_keys_reader.cc",
@@ -171,9 +207,14 @@ storage_client_srcs = [
     "object_metadata.cc",
     "object_rewriter.cc",
     "object_stream.cc",
+    "parallel_download.cc",
+    "parallel_list_objects.cc",
     "parallel_upload.cc",
     "policy_document.cc",
     "service_account.cc",
+    "transport_routing_policy.cc",
+    "upload_directory.cc",
+    "v4_url_signer.cc",
     "version.cc",
     "well_known_headers.cc",
     "well_known_parameters.cc",
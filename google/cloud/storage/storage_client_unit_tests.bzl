@@ -20,6 +20,7 @@ storage_client_unit_tests = [
     "bucket_access_control_test.cc",
     "bucket_metadata_test.cc",
     "bucket_test.cc",
+    "bulk_rewrite_test.cc",
     "client_bucket_acl_test.cc",
     "client_default_object_acl_test.cc",
     "client_notifications_test.cc",
@@ -32,13 +33,18 @@ storage_client_unit_tests = [
     "client_test.cc",
     "client_write_object_test.cc",
     "hashing_options_test.cc",
+    "hedging_policy_test.cc",
     "hmac_key_metadata_test.cc",
     "idempotency_policy_test.cc",
     "internal/access_control_common_test.cc",
+    "internal/batch_requests_test.cc",
     "internal/binary_data_as_debug_string_test.cc",
     "internal/bucket_acl_requests_test.cc",
     "internal/bucket_requests_test.cc",
+    "internal/caching_client_test.cc",
     "internal/compute_engine_util_test.cc",
+    "internal/const_buffer_test.cc",
+    "internal/crc32c_combine_test.cc",
     "internal/curl_client_test.cc",
     "internal/curl_handle_factory_test.cc",
     "internal/curl_handle_test.cc",
@@ -52,6 +58,7 @@ storage_client_unit_tests = [
     "internal/generate_message_boundary_test.cc",
     "internal/generic_request_test.cc",
     "internal/hash_validator_test.cc",
+    "internal/hedging_client_test.cc",
     "internal/hmac_key_requests_test.cc",
     "internal/http_response_test.cc",
     "internal/logging_client_test.cc",
@@ -61,12 +68,16 @@ storage_client_unit_tests = [
     "internal/nljson_use_third_party_test.cc",
     "internal/notification_requests_test.cc",
     "internal/object_acl_requests_test.cc",
+    "internal/object_cache_test.cc",
+    "internal/object_metadata_stream_parser_test.cc",
     "internal/object_requests_test.cc",
     "internal/object_streambuf_test.cc",
     "internal/openssl_util_test.cc",
     "internal/parameter_pack_validation_test.cc",
     "internal/patch_builder_test.cc",
+    "internal/pipelined_object_write_streambuf_test.cc",
     "internal/policy_document_request_test.cc",
+    "internal/prefetching_page_loader_test.cc",
     "internal/resumable_upload_session_test.cc",
     "internal/retry_client_test.cc",
     "internal/retry_object_read_source_test.cc",
@@ -75,6 +86,7 @@ storage_client_unit_tests = [
     "internal/sha256_hash_test.cc",
     "internal/sign_blob_requests_test.cc",
     "internal/signed_url_requests_test.cc",
+    "internal/transfer_tuner_test.cc",
     "internal/tuple_filter_test.cc",
     "lifecycle_rule_test.cc",
     "list_buckets_reader_test.cc",
@@ -86,11 +98,14 @@ storage_client_unit_tests = [
     "oauth2/compute_engine_credentials_test.cc",
     "oauth2/google_application_default_credentials_file_test.cc",
     "oauth2/google_credentials_test.cc",
+    "oauth2/refreshing_credentials_wrapper_test.cc",
     "oauth2/service_account_credentials_test.cc",
     "object_access_control_test.cc",
     "object_metadata_test.cc",
     "object_stream_test.cc",
     "object_test.cc",
+    "parallel_download_test.cc",
+    "parallel_list_objects_test.cc",
     "parallel_uploads_test.cc",
     "policy_document_test.cc",
     "retry_policy_test.cc",
@@ -99,6 +114,9 @@ storage_client_unit_tests = [
     "storage_class_test.cc",
     "storage_iam_policy_test.cc",
     "storage_version_test.cc",
+    "transport_routing_policy_test.cc",
+    "upload_directory_test.cc",
+    "v4_url_signer_test.cc",
     "well_known_headers_test.cc",
     "well_known_parameters_test.cc",
 ]
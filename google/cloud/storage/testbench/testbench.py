@@ -24,12 +24,15 @@ import gcs_project
 import httpbin
 import json
 import os
+import random
 import re
 import testbench_utils
 import time
 import sys
 import socket
 import struct
+import werkzeug.test
+import werkzeug.wrappers
 from werkzeug import serving
 from werkzeug.middleware.dispatcher import DispatcherMiddleware
 from werkzeug.serving import WSGIRequestHandler
@@ -895,6 +898,89 @@ def xmlapi_put_object(bucket_name, object_name):
     return response
 
 
+# Define the WSGI application to handle batch requests. The batch endpoint
+# is "/batch/storage/v1", the application is mounted at "/batch" because the
+# dispatcher does not forward requests for the mount point itself.
+BATCH_HANDLER_PATH = "/batch"
+batch = flask.Flask(__name__)
+batch.debug = True
+
+
+@batch.errorhandler(error_response.ErrorResponse)
+def batch_error(error):
+    return error.as_response()
+
+
+def split_mime_entity(entity):
+    """Split a MIME entity (or HTTP message) into its header lines and body."""
+    separator = b"\r\n\r\n" if b"\r\n\r\n" in entity else b"\n\n"
+    head, _, body = entity.partition(separator)
+    return head.decode("utf-8").splitlines(), body
+
+
+def parse_headers(lines):
+    """Convert a list of `name: value` lines into a dictionary."""
+    headers = {}
+    for line in lines:
+        name, _, value = line.partition(":")
+        headers[name.strip()] = value.strip()
+    return headers
+
+
+@batch.route("/storage/v1", methods=["POST"])
+def batch_execute():
+    """Execute the sub-requests in a multipart/mixed batch request."""
+    boundary = flask.request.mimetype_params.get("boundary")
+    if flask.request.mimetype != "multipart/mixed" or boundary is None:
+        raise error_response.ErrorResponse(
+            "Missing multipart/mixed boundary in batch request", status_code=400
+        )
+    delimiter = b"--" + boundary.encode("utf-8")
+    client = werkzeug.test.Client(application, werkzeug.wrappers.Response)
+    response_boundary = "batch_testbench_%d" % random.randint(0, 2 ** 63)
+    result = b""
+    # The first element is the (empty) preamble, the last one starts with "--"
+    # and marks the end of the batch.
+    for index, part in enumerate(flask.request.get_data().split(delimiter)[1:]):
+        if part.startswith(b"--"):
+            break
+        lines, http_request = split_mime_entity(part.lstrip(b"\r\n"))
+        part_headers = parse_headers(lines)
+        lines, body = split_mime_entity(http_request)
+        if not lines:
+            raise error_response.ErrorResponse(
+                "Missing request line in batch part %d" % index, status_code=400
+            )
+        method, path, _ = lines[0].split(" ", 2)
+        headers = parse_headers(lines[1:])
+        headers.pop("Content-Length", None)
+        if body.endswith(b"\r\n"):
+            body = body[:-2]
+        sub_response = client.open(
+            path,
+            method=method,
+            headers=headers,
+            data=body,
+            base_url=flask.request.host_url,
+        )
+        content_id = part_headers.get("Content-ID", "<item-%d>" % index)
+        result += (
+            "--%s\r\n"
+            "Content-Type: application/http\r\n"
+            "Content-ID: <response-%s>\r\n"
+            "\r\n"
+            "HTTP/1.1 %s\r\n"
+            % (response_boundary, content_id.strip("<>"), sub_response.status)
+        ).encode("utf-8")
+        for name, value in sub_response.headers.items():
+            result += ("%s: %s\r\n" % (name, value)).encode("utf-8")
+        result += b"\r\n" + sub_response.get_data() + b"\r\n"
+    result += ("--%s--\r\n" % response_boundary).encode("utf-8")
+    return flask.Response(
+        result, content_type="multipart/mixed; boundary=" + response_boundary
+    )
+
+
 # Define the WSGI application to handle HMAC key requests
 (PROJECTS_HANDLER_PATH, projects_app) = gcs_project.get_projects_app()
 
@@ -909,6 +995,7 @@ application = DispatcherMiddleware(
         UPLOAD_HANDLER_PATH: upload,
         DOWNLOAD_HANDLER_PATH: download,
         XMLAPI_HANDLER_PATH: xmlapi,
+        BATCH_HANDLER_PATH: batch,
         PROJECTS_HANDLER_PATH: projects_app,
         IAM_HANDLER_PATH: iam_app,
     },
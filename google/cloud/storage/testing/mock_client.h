@@ -27,6 +27,7 @@ namespace testing {
 class MockClient : public google::cloud::storage::internal::RawClient {
  public:
   MOCK_CONST_METHOD0(client_options, ClientOptions const&());
+  MOCK_CONST_METHOD0(connection_pool_stats, ConnectionPoolStats());
   MOCK_METHOD1(ListBuckets, StatusOr<internal::ListBucketsResponse>(
                                 internal::ListBucketsRequest const&));
   MOCK_METHOD1(CreateBucket, StatusOr<storage::BucketMetadata>(
@@ -159,6 +160,8 @@ class MockClient : public google::cloud::storage::internal::RawClient {
   MOCK_METHOD1(DeleteNotification,
                StatusOr<internal::EmptyResponse>(
                    internal::DeleteNotificationRequest const&));
+  MOCK_METHOD1(ExecuteBatch, StatusOr<internal::BatchResponse>(
+                                 internal::BatchRequest const&));
   MOCK_METHOD1(
       AuthorizationHeader,
       StatusOr<std::string>(
@@ -169,10 +172,11 @@ class MockResumableUploadSession
     : public google::cloud::storage::internal::ResumableUploadSession {
  public:
   MOCK_METHOD1(UploadChunk, StatusOr<internal::ResumableUploadResponse>(
-                                std::string const& buffer));
+                                internal::ConstBufferSequence const& buffers));
   MOCK_METHOD2(UploadFinalChunk,
                StatusOr<internal::ResumableUploadResponse>(
-                   std::string const& buffer, std::uint64_t upload_size));
+                   internal::ConstBufferSequence const& buffers,
+                   std::uint64_t upload_size));
   MOCK_METHOD0(ResetSession, StatusOr<internal::ResumableUploadResponse>());
   MOCK_CONST_METHOD0(next_expected_byte, std::uint64_t());
   MOCK_CONST_METHOD0(session_id, std::string const&());
@@ -187,6 +191,8 @@ class MockObjectReadSource : public internal::ObjectReadSource {
   MOCK_METHOD0(Close, StatusOr<internal::HttpResponse>());
   MOCK_METHOD2(Read,
                StatusOr<internal::ReadSourceResult>(char* buf, std::size_t n));
+  MOCK_CONST_METHOD0(CanReadBorrowed, bool());
+  MOCK_METHOD0(ReadBorrowed, StatusOr<internal::BorrowedReadSourceResult>());
 };
 
 class MockStreambuf : public internal::ObjectWriteStreambuf {
@@ -0,0 +1,102 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/async_client.h"
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/testing/object_integration_test.h"
+#include "google/cloud/storage/testing/storage_integration_test.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+
+using AsyncClientIntegrationTest =
+    ::google::cloud::storage::testing::ObjectIntegrationTest;
+
+TEST_F(AsyncClientIntegrationTest, ManyConcurrentOperations) {
+  auto options = ClientOptions::CreateDefaultClientOptions();
+  ASSERT_STATUS_OK(options);
+  options->set_background_thread_pool_size(2);
+  storage_experimental::AsyncClient async(*options);
+
+  StatusOr<Client> client = MakeIntegrationTestClient();
+  ASSERT_STATUS_OK(client);
+
+  auto const prefix = CreateRandomPrefixName();
+  int const object_count = 32;
+  std::vector<std::string> names;
+  std::vector<future<StatusOr<ObjectMetadata>>> inserts;
+  for (int i = 0; i != object_count; ++i) {
+    names.push_back(prefix + ".object-" + std::to_string(i));
+    inserts.push_back(async.AsyncInsertObject(
+        bucket_name_, names.back(), LoremIpsum() + std::to_string(i),
+        IfGenerationMatch(0)));
+  }
+  for (int i = 0; i != object_count; ++i) {
+    auto meta = inserts[i].get();
+    ASSERT_STATUS_OK(meta);
+    EXPECT_EQ(names[i], meta->name());
+    EXPECT_EQ(bucket_name_, meta->bucket());
+  }
+
+  std::vector<future<StatusOr<ObjectMetadata>>> metadata;
+  std::vector<future<StatusOr<std::string>>> reads;
+  for (auto const& name : names) {
+    metadata.push_back(async.AsyncGetObjectMetadata(bucket_name_, name));
+    reads.push_back(async.AsyncReadObject(bucket_name_, name));
+  }
+  for (int i = 0; i != object_count; ++i) {
+    auto meta = metadata[i].get();
+    ASSERT_STATUS_OK(meta);
+    EXPECT_EQ(names[i], meta->name());
+    auto contents = reads[i].get();
+    ASSERT_STATUS_OK(contents);
+    EXPECT_EQ(LoremIpsum() + std::to_string(i), *contents);
+  }
+
+  // Reading a range returns only the requested bytes.
+  auto range =
+      async.AsyncReadObject(bucket_name_, names.front(), ReadRange(0, 16))
+          .get();
+  ASSERT_STATUS_OK(range);
+  EXPECT_EQ(LoremIpsum().substr(0, 16), *range);
+
+  for (auto const& name : names) {
+    auto status = client->DeleteObject(bucket_name_, name);
+    EXPECT_STATUS_OK(status);
+  }
+}
+
+TEST_F(AsyncClientIntegrationTest, GetMetadataNotFound) {
+  auto options = ClientOptions::CreateDefaultClientOptions();
+  ASSERT_STATUS_OK(options);
+  storage_experimental::AsyncClient async(*options);
+
+  auto meta =
+      async.AsyncGetObjectMetadata(bucket_name_, MakeRandomObjectName()).get();
+  EXPECT_FALSE(meta.ok());
+  EXPECT_EQ(StatusCode::kNotFound, meta.status().code());
+}
+
+}  // namespace
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -123,6 +123,25 @@ TEST(CurlRequestTest, SimplePOST) {
   EXPECT_EQ("baz=baz2", form["baz"].get<std::string>());
 }
 
+TEST(CurlRequestTest, UploadMultipleBuffers) {
+  storage::internal::CurlRequestBuilder request(
+      HttpBinEndpoint() + "/put",
+      storage::internal::GetDefaultCurlHandleFactory());
+  request.SetMethod("PUT");
+  request.AddHeader("Accept: application/json");
+  request.AddHeader("Content-Type: application/octet-stream");
+
+  std::string const b0(128 * 1024, 'A');
+  std::string const b1 = "0123456789";
+  std::string const b2(200 * 1024, 'B');
+  auto response = request.BuildRequest().MakeUploadRequest(
+      {b0, ConstBuffer{}, b1, b2});
+  ASSERT_STATUS_OK(response);
+  EXPECT_EQ(200, response->status_code);
+  nl::json parsed = nl::json::parse(response->payload);
+  EXPECT_EQ(b0 + b1 + b2, parsed["data"].get<std::string>());
+}
+
 TEST(CurlRequestTest, Handle404) {
   storage::internal::CurlRequestBuilder request(
       HttpBinEndpoint() + "/status/404",
@@ -419,6 +438,50 @@ TEST(CurlRequestTest, Logging) {
   EXPECT_THAT(log_messages, HasSubstr("curl(Recv Header)"));
   EXPECT_THAT(log_messages, HasSubstr("curl(Recv Data)"));
 }
+
+TEST(CurlRequestTest, PooledFactoryWarmup) {
+  auto factory = std::make_shared<PooledCurlHandleFactory>(4);
+  EXPECT_EQ(2, factory->Warmup(HttpBinEndpoint() + "/get", 2));
+  auto stats = factory->Stats();
+  EXPECT_EQ(2, stats.handles_created);
+  EXPECT_EQ(2, stats.connection_count);
+  EXPECT_EQ(2, stats.idle_handles.size());
+
+  // The request reuses one of the connections created by the warm-up.
+  storage::internal::CurlRequestBuilder builder(HttpBinEndpoint() + "/get",
+                                                factory);
+  auto response = builder.BuildRequest().MakeRequest(std::string{});
+  ASSERT_STATUS_OK(response);
+  EXPECT_EQ(200, response->status_code);
+
+  stats = factory->Stats();
+  EXPECT_EQ(2, stats.handles_created);
+  EXPECT_EQ(1, stats.handles_reused);
+  EXPECT_EQ(2, stats.connection_count);
+}
+
+TEST(CurlRequestTest, PooledFactoryWarmupFailure) {
+  auto factory = std::make_shared<PooledCurlHandleFactory>(2);
+  EXPECT_EQ(0, factory->Warmup("https://localhost:1/", 4));
+  auto stats = factory->Stats();
+  EXPECT_EQ(0, stats.handles_created);
+  EXPECT_EQ(2, stats.warmup_failures);
+  EXPECT_TRUE(stats.idle_handles.empty());
+}
+
+TEST(CurlRequestTest, PooledFactoryDiscardsFailedHandles) {
+  auto factory = std::make_shared<PooledCurlHandleFactory>(2);
+  {
+    storage::internal::CurlRequestBuilder builder("https://localhost:1/",
+                                                  factory);
+    auto response = builder.BuildRequest().MakeRequest(std::string{});
+    EXPECT_FALSE(response.ok());
+  }
+  auto stats = factory->Stats();
+  EXPECT_EQ(1, stats.handles_created);
+  EXPECT_EQ(1, stats.transfer_failures);
+  EXPECT_TRUE(stats.idle_handles.empty());
+}
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
@@ -0,0 +1,95 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/testing/object_integration_test.h"
+#include "google/cloud/storage/testing/storage_integration_test.h"
+#include "google/cloud/status_or.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+
+using ObjectBatchIntegrationTest =
+    ::google::cloud::storage::testing::ObjectIntegrationTest;
+
+TEST_F(ObjectBatchIntegrationTest, DeleteObjects) {
+  StatusOr<Client> client = MakeIntegrationTestClient();
+  ASSERT_STATUS_OK(client);
+
+  auto prefix = CreateRandomPrefixName();
+  std::vector<std::pair<std::string, std::int64_t>> objects;
+  for (int i = 0; i != 3; ++i) {
+    auto const object_name = prefix + ".obj-" + std::to_string(i);
+    StatusOr<ObjectMetadata> meta = client->InsertObject(
+        bucket_name_, object_name, LoremIpsum(), IfGenerationMatch(0));
+    ASSERT_STATUS_OK(meta);
+    objects.emplace_back(object_name, meta->generation());
+  }
+  // Use a stale generation for the last object, its deletion must fail
+  // without affecting the other deletions in the batch.
+  auto const generation = objects.back().second;
+  objects.back().second = generation + 1;
+
+  auto result = DeleteObjects(*client, bucket_name_, objects);
+  ASSERT_EQ(3, result.size());
+  EXPECT_STATUS_OK(result[0]);
+  EXPECT_STATUS_OK(result[1]);
+  EXPECT_EQ(StatusCode::kFailedPrecondition, result[2].code());
+
+  std::vector<std::string> names;
+  for (auto const& o : client->ListObjects(bucket_name_, Prefix(prefix))) {
+    ASSERT_STATUS_OK(o);
+    names.push_back(o->name());
+  }
+  EXPECT_THAT(names, ::testing::ElementsAre(objects.back().first));
+
+  auto status = client->DeleteObject(bucket_name_, objects.back().first,
+                                     IfGenerationMatch(generation));
+  EXPECT_STATUS_OK(status);
+}
+
+TEST_F(ObjectBatchIntegrationTest, DeleteByPrefix) {
+  StatusOr<Client> client = MakeIntegrationTestClient();
+  ASSERT_STATUS_OK(client);
+
+  auto prefix = CreateRandomPrefixName();
+  for (int i = 0; i != 5; ++i) {
+    StatusOr<ObjectMetadata> meta =
+        client->InsertObject(bucket_name_, prefix + ".obj-" + std::to_string(i),
+                             LoremIpsum(), IfGenerationMatch(0));
+    ASSERT_STATUS_OK(meta);
+  }
+
+  auto status = DeleteByPrefix(*client, bucket_name_, prefix);
+  ASSERT_STATUS_OK(status);
+
+  for (auto const& o : client->ListObjects(bucket_name_, Prefix(prefix))) {
+    ASSERT_STATUS_OK(o);
+    ADD_FAILURE() << "unexpected object " << o->name();
+  }
+}
+
+}  // anonymous namespace
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
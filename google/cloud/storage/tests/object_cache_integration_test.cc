@@ -0,0 +1,113 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/testing/object_integration_test.h"
+#include "google/cloud/storage/testing/random_names.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <sys/stat.h>
+#if _WIN32
+#include <direct.h>
+#endif  // _WIN32
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+
+class ObjectCacheIntegrationTest
+    : public ::google::cloud::storage::testing::ObjectIntegrationTest {
+ protected:
+  void SetUp() override {
+    ObjectIntegrationTest::SetUp();
+    directory_ = ::testing::TempDir() + MakeRandomFilename();
+#if _WIN32
+    ASSERT_EQ(0, ::_mkdir(directory_.c_str()));
+#else
+    ASSERT_EQ(0, ::mkdir(directory_.c_str(), 0700));
+#endif  // _WIN32
+  }
+
+  StatusOr<Client> MakeCachingClient() {
+    auto options = ClientOptions::CreateDefaultClientOptions();
+    if (!options) return std::move(options).status();
+    options->set_object_cache_directory(directory_);
+    return Client(*std::move(options));
+  }
+
+  static std::string ReadAll(ObjectReadStream stream) {
+    return std::string(std::istreambuf_iterator<char>{stream}, {});
+  }
+
+  std::string directory_;
+};
+
+TEST_F(ObjectCacheIntegrationTest, ReadTwice) {
+  StatusOr<Client> client = MakeCachingClient();
+  ASSERT_STATUS_OK(client);
+
+  auto object_name = MakeRandomObjectName();
+  std::string const expected = LoremIpsum();
+  auto meta = client->InsertObject(bucket_name_, object_name, expected,
+                                   IfGenerationMatch(0));
+  ASSERT_STATUS_OK(meta);
+
+  // The first read populates the cache, the second read uses it.
+  for (int i = 0; i != 2; ++i) {
+    auto stream = client->ReadObject(bucket_name_, object_name);
+    EXPECT_EQ(expected, ReadAll(std::move(stream)));
+  }
+
+  auto stream =
+      client->ReadObject(bucket_name_, object_name, ReadRange(10, 20));
+  EXPECT_EQ(expected.substr(10, 10), ReadAll(std::move(stream)));
+
+  // Preconditions are still validated by the service.
+  stream = client->ReadObject(bucket_name_, object_name,
+                              IfGenerationMatch(meta->generation() + 1));
+  stream.Close();
+  EXPECT_FALSE(stream.status().ok());
+
+  auto status = client->DeleteObject(bucket_name_, object_name);
+  EXPECT_STATUS_OK(status);
+}
+
+TEST_F(ObjectCacheIntegrationTest, NewGeneration) {
+  StatusOr<Client> client = MakeCachingClient();
+  ASSERT_STATUS_OK(client);
+
+  auto object_name = MakeRandomObjectName();
+  auto meta = client->InsertObject(bucket_name_, object_name, "first version",
+                                   IfGenerationMatch(0));
+  ASSERT_STATUS_OK(meta);
+  EXPECT_EQ("first version",
+            ReadAll(client->ReadObject(bucket_name_, object_name)));
+
+  meta = client->InsertObject(bucket_name_, object_name, "second version",
+                              IfGenerationMatch(meta->generation()));
+  ASSERT_STATUS_OK(meta);
+  EXPECT_EQ("second version",
+            ReadAll(client->ReadObject(bucket_name_, object_name)));
+
+  auto status = client->DeleteObject(bucket_name_, object_name);
+  EXPECT_STATUS_OK(status);
+}
+
+}  // namespace
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
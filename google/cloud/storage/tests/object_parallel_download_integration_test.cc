@@ -0,0 +1,68 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/parallel_download.h"
+#include "google/cloud/storage/testing/object_integration_test.h"
+#include "google/cloud/storage/testing/storage_integration_test.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+
+using ObjectParallelDownloadIntegrationTest =
+    ::google::cloud::storage::testing::ObjectIntegrationTest;
+
+TEST_F(ObjectParallelDownloadIntegrationTest, ParallelDownload) {
+  StatusOr<Client> client = MakeIntegrationTestClient();
+  ASSERT_STATUS_OK(client);
+
+  auto object_name = MakeRandomObjectName();
+  auto file_name = MakeRandomFilename();
+
+  std::string expected;
+  for (int i = 0; i != 100; ++i) expected += LoremIpsum();
+  auto meta = client->InsertObject(bucket_name_, object_name, expected,
+                                   IfGenerationMatch(0));
+  ASSERT_STATUS_OK(meta);
+
+  auto status =
+      ParallelDownloadFile(*client, bucket_name_, object_name, file_name,
+                           MaxStreams(8), MinStreamSize(1024));
+  ASSERT_STATUS_OK(status);
+
+  std::ifstream is(file_name, std::ios::binary);
+  std::string actual(std::istreambuf_iterator<char>{is}, {});
+  EXPECT_EQ(expected, actual);
+  is.close();
+  EXPECT_EQ(0, std::remove(file_name.c_str()));
+
+  auto deletion_status = client->DeleteObject(
+      bucket_name_, object_name, IfGenerationMatch(meta->generation()));
+  ASSERT_STATUS_OK(deletion_status);
+}
+
+}  // anonymous namespace
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
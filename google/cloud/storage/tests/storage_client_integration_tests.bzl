@@ -17,6 +17,7 @@
 """Automatically generated unit tests list - DO NOT EDIT."""
 
 storage_client_integration_tests = [
+    "async_client_integration_test.cc",
     "bucket_integration_test.cc",
     "curl_download_request_integration_test.cc",
     "curl_request_integration_test.cc",
@@ -26,6 +27,8 @@ storage_client_integration_tests = [
     "grpc_integration_test.cc",
     "key_file_integration_test.cc",
     "object_basic_crud_integration_test.cc",
+    "object_batch_integration_test.cc",
+    "object_cache_integration_test.cc",
     "object_checksum_integration_test.cc",
     "object_compose_many_integration_test.cc",
     "object_file_integration_test.cc",
@@ -35,6 +38,7 @@ storage_client_integration_tests = [
     "object_integration_test.cc",
     "object_list_objects_versions_integration_test.cc",
     "object_media_integration_test.cc",
+    "object_parallel_download_integration_test.cc",
     "object_parallel_upload_integration_test.cc",
     "object_plenty_clients_serially_integration_test.cc",
     "object_plenty_clients_simultaneously_integration_test.cc",
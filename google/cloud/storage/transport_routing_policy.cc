@@ -0,0 +1,151 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/transport_routing_policy.h"
+#include "google/cloud/storage/internal/moving_average.h"
+#include <algorithm>
+#include <ostream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+std::size_t Index(Transport t) { return t == Transport::kRest ? 0 : 1; }
+
+Transport Other(Transport t) {
+  return t == Transport::kRest ? Transport::kGrpc : Transport::kRest;
+}
+
+/// Returns true for errors that indicate a problem with the transport, as
+/// opposed to a problem with the request (e.g. `kNotFound`).
+bool IsTransportFailure(StatusCode code) {
+  switch (code) {
+    case StatusCode::kUnknown:
+    case StatusCode::kDeadlineExceeded:
+    case StatusCode::kUnimplemented:
+    case StatusCode::kInternal:
+    case StatusCode::kUnavailable:
+      return true;
+    default:
+      return false;
+  }
+}
+}  // namespace
+
+std::ostream& operator<<(std::ostream& os, Transport t) {
+  return os << (t == Transport::kRest ? "REST" : "gRPC");
+}
+
+StaticTransportRoutingPolicy::StaticTransportRoutingPolicy()
+    : StaticTransportRoutingPolicy({
+          {"InsertObjectMedia", Transport::kGrpc},
+          {"ReadObject", Transport::kGrpc},
+          {"CreateResumableSession", Transport::kGrpc},
+      }) {}
+
+Transport StaticTransportRoutingPolicy::Pick(std::string const& operation) {
+  auto const l = routes_.find(operation);
+  if (l == routes_.end()) return default_transport_;
+  return l->second;
+}
+
+std::uint64_t constexpr LatencyRoutingPolicy::kMinThroughputSampleSize;
+std::chrono::microseconds constexpr LatencyRoutingPolicy::kFailureLatency;
+
+Transport LatencyRoutingPolicy::Pick(std::string const& operation) {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto& state = operations_[operation];
+  auto const transport = PickLocked(state);
+  if (transport == Transport::kRest) {
+    ++state.counters.rest_calls;
+  } else {
+    ++state.counters.grpc_calls;
+  }
+  return transport;
+}
+
+void LatencyRoutingPolicy::OnCompletion(std::string const& operation,
+                                        TransportSample const& sample) {
+  using seconds = std::chrono::duration<double>;
+  auto const elapsed =
+      std::chrono::duration_cast<seconds>(sample.elapsed).count();
+  std::lock_guard<std::mutex> lk(mu_);
+  auto& state = operations_[operation];
+  auto& estimate = state.estimates[Index(sample.transport)];
+  if (IsTransportFailure(sample.code)) {
+    ++state.counters.failures;
+    auto const latency = (std::max)(sample.elapsed, kFailureLatency);
+    estimate.latency_us = internal::Smooth(
+        estimate.latency_us, static_cast<double>(latency.count()));
+    estimate.bytes_per_second /= 2;
+    return;
+  }
+  if (sample.bytes >= kMinThroughputSampleSize && elapsed > 0) {
+    estimate.bytes_per_second =
+        internal::Smooth(estimate.bytes_per_second,
+                         static_cast<double>(sample.bytes) / elapsed);
+    return;
+  }
+  // Use at least 1us, a 0 estimate means "no estimate".
+  auto const latency_us =
+      (std::max)(static_cast<double>(sample.elapsed.count()), 1.0);
+  estimate.latency_us = internal::Smooth(estimate.latency_us, latency_us);
+}
+
+std::map<std::string, TransportRoutingCounters> LatencyRoutingPolicy::Counters()
+    const {
+  std::map<std::string, TransportRoutingCounters> result;
+  std::lock_guard<std::mutex> lk(mu_);
+  for (auto const& kv : operations_) {
+    result.emplace(kv.first, kv.second.counters);
+  }
+  return result;
+}
+
+Transport LatencyRoutingPolicy::PickLocked(OperationState& state) const {
+  auto const& counters = state.counters;
+  ++state.calls;
+  if (counters.rest_calls < warmup_calls_ ||
+      counters.grpc_calls < warmup_calls_) {
+    if (counters.rest_calls == counters.grpc_calls) return default_transport_;
+    return counters.rest_calls < counters.grpc_calls ? Transport::kRest
+                                                     : Transport::kGrpc;
+  }
+  auto const faster = Faster(state);
+  if (exploration_interval_ != 0 && state.calls % exploration_interval_ == 0) {
+    ++state.counters.explorations;
+    return Other(faster);
+  }
+  return faster;
+}
+
+Transport LatencyRoutingPolicy::Faster(OperationState const& state) const {
+  auto const& rest = state.estimates[Index(Transport::kRest)];
+  auto const& grpc = state.estimates[Index(Transport::kGrpc)];
+  if (rest.bytes_per_second > 0 && grpc.bytes_per_second > 0) {
+    return rest.bytes_per_second >= grpc.bytes_per_second ? Transport::kRest
+                                                          : Transport::kGrpc;
+  }
+  if (rest.latency_us > 0 && grpc.latency_us > 0) {
+    return rest.latency_us <= grpc.latency_us ? Transport::kRest
+                                              : Transport::kGrpc;
+  }
+  return default_transport_;
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
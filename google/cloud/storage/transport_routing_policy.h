@@ -0,0 +1,179 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TRANSPORT_ROUTING_POLICY_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TRANSPORT_ROUTING_POLICY_H
+
+#include "google/cloud/storage/version.h"
+#include "google/cloud/status.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+
+/// The transports available to the clients created by
+/// `storage_experimental::DefaultGrpcClient()`.
+enum class Transport { kRest, kGrpc };
+
+std::ostream& operator<<(std::ostream& os, Transport t);
+
+/// The result of a single call routed by a `TransportRoutingPolicy`.
+struct TransportSample {
+  Transport transport;
+  /**
+   * The time spent in the transport.
+   *
+   * For downloads this is the time spent in the calls to receive the data, it
+   * excludes the time the application takes to consume the data.
+   */
+  std::chrono::microseconds elapsed;
+  /// The number of media bytes transferred, 0 for metadata operations.
+  std::uint64_t bytes;
+  StatusCode code;
+};
+
+/**
+ * Decides which transport handles each call in a client using both REST and
+ * gRPC.
+ *
+ * Configure the policy with `ClientOptions::set_transport_routing_policy()`,
+ * it is only used by the clients created with
+ * `storage_experimental::DefaultGrpcClient()`.
+ *
+ * The operations are identified by name, e.g. "ReadObject", "DeleteObject",
+ * or "InsertObjectMedia". The client only routes the operations implemented by
+ * both transports, all other operations always use REST.
+ *
+ * Implementations must be thread-safe, a single policy is shared by all the
+ * calls in a client.
+ */
+class TransportRoutingPolicy {
+ public:
+  virtual ~TransportRoutingPolicy() = default;
+
+  /// Returns the transport for the next call to @p operation.
+  virtual Transport Pick(std::string const& operation) = 0;
+
+  /// Reports the result of a call started by `Pick()`.
+  virtual void OnCompletion(std::string const& operation,
+                            TransportSample const& sample) = 0;
+};
+
+/**
+ * Routes each operation to a fixed transport.
+ *
+ * This is the default policy: the media operations (`InsertObjectMedia`,
+ * `ReadObject` and `CreateResumableSession`) use gRPC, all other operations use
+ * REST.
+ */
+class StaticTransportRoutingPolicy : public TransportRoutingPolicy {
+ public:
+  StaticTransportRoutingPolicy();
+  explicit StaticTransportRoutingPolicy(
+      std::map<std::string, Transport> routes,
+      Transport default_transport = Transport::kRest)
+      : routes_(std::move(routes)), default_transport_(default_transport) {}
+
+  Transport Pick(std::string const& operation) override;
+  void OnCompletion(std::string const&, TransportSample const&) override {}
+
+ private:
+  std::map<std::string, Transport> routes_;
+  Transport default_transport_;
+};
+
+/// The decisions made by `LatencyRoutingPolicy` for a single operation.
+struct TransportRoutingCounters {
+  /// The number of calls routed to each transport.
+  std::uint64_t rest_calls = 0;
+  std::uint64_t grpc_calls = 0;
+  /// The calls routed to the slower transport to refresh its estimates.
+  std::uint64_t explorations = 0;
+  /// The calls that failed with a transport error, e.g. `kUnavailable`.
+  std::uint64_t failures = 0;
+};
+
+/**
+ * Routes each operation to the transport with the best observed performance.
+ *
+ * The policy keeps, for each operation and transport, an exponentially
+ * weighted moving average of the latency of small calls and the throughput of
+ * large transfers. Each call is routed to the transport with the higher
+ * throughput, or the lower latency if there are no throughput estimates for
+ * both transports.
+ *
+ * The first `warmup_calls` calls of each operation alternate between the
+ * transports. After that, one call in each `exploration_interval` goes to the
+ * slower transport, so the estimates follow changes in the load. Calls that
+ * fail with a transport error (e.g. `kUnavailable` or `kUnimplemented`) are
+ * recorded as very slow calls.
+ */
+class LatencyRoutingPolicy : public TransportRoutingPolicy {
+ public:
+  /// Transfers smaller than this only update the latency estimate.
+  static std::uint64_t constexpr kMinThroughputSampleSize = 256 * 1024;
+  /// The latency recorded for calls that fail with a transport error.
+  static std::chrono::microseconds constexpr kFailureLatency =
+      std::chrono::seconds(1);
+
+  explicit LatencyRoutingPolicy(Transport default_transport = Transport::kRest,
+                                std::uint64_t warmup_calls = 4,
+                                std::uint64_t exploration_interval = 64)
+      : default_transport_(default_transport),
+        warmup_calls_(warmup_calls),
+        exploration_interval_(exploration_interval) {}
+
+  Transport Pick(std::string const& operation) override;
+  void OnCompletion(std::string const& operation,
+                    TransportSample const& sample) override;
+
+  /// Returns the decisions made so far, indexed by operation.
+  std::map<std::string, TransportRoutingCounters> Counters() const;
+
+ private:
+  struct Estimate {
+    double latency_us = 0;
+    double bytes_per_second = 0;
+  };
+  struct OperationState {
+    std::array<Estimate, 2> estimates;
+    std::uint64_t calls = 0;
+    TransportRoutingCounters counters;
+  };
+
+  Transport PickLocked(OperationState& state) const;
+  Transport Faster(OperationState const& state) const;
+
+  Transport const default_transport_;
+  std::uint64_t const warmup_calls_;
+  std::uint64_t const exploration_interval_;
+  mutable std::mutex mu_;
+  std::map<std::string, OperationState> operations_;
+};
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TRANSPORT_ROUTING_POLICY_H
@@ -0,0 +1,189 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/transport_routing_policy.h"
+#include <gmock/gmock.h>
+#include <sstream>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+
+using ::std::chrono::microseconds;
+using ::std::chrono::milliseconds;
+
+auto constexpr kMiB = 1024 * 1024;
+
+/// Run @p count calls of @p operation, each one completing with the latency
+/// and bytes returned by @p sample.
+template <typename Functor>
+void RunCalls(LatencyRoutingPolicy& policy, std::string const& operation,
+              int count, Functor sample) {
+  for (int i = 0; i != count; ++i) {
+    auto const transport = policy.Pick(operation);
+    policy.OnCompletion(operation, sample(transport));
+  }
+}
+
+TEST(TransportRoutingPolicyTest, StreamTransport) {
+  std::ostringstream os;
+  os << Transport::kRest << " " << Transport::kGrpc;
+  EXPECT_EQ("REST gRPC", os.str());
+}
+
+TEST(TransportRoutingPolicyTest, StaticDefaults) {
+  StaticTransportRoutingPolicy policy;
+  EXPECT_EQ(Transport::kGrpc, policy.Pick("InsertObjectMedia"));
+  EXPECT_EQ(Transport::kGrpc, policy.Pick("ReadObject"));
+  EXPECT_EQ(Transport::kGrpc, policy.Pick("CreateResumableSession"));
+  EXPECT_EQ(Transport::kRest, policy.Pick("GetBucketMetadata"));
+  EXPECT_EQ(Transport::kRest, policy.Pick("DeleteObject"));
+}
+
+TEST(TransportRoutingPolicyTest, StaticCustomRoutes) {
+  StaticTransportRoutingPolicy policy({{"DeleteObject", Transport::kRest}},
+                                      Transport::kGrpc);
+  EXPECT_EQ(Transport::kRest, policy.Pick("DeleteObject"));
+  EXPECT_EQ(Transport::kGrpc, policy.Pick("ReadObject"));
+}
+
+TEST(TransportRoutingPolicyTest, LatencyWarmupAlternates) {
+  LatencyRoutingPolicy policy(Transport::kGrpc, 2, 0);
+  EXPECT_EQ(Transport::kGrpc, policy.Pick("GetBucketMetadata"));
+  EXPECT_EQ(Transport::kRest, policy.Pick("GetBucketMetadata"));
+  EXPECT_EQ(Transport::kGrpc, policy.Pick("GetBucketMetadata"));
+  EXPECT_EQ(Transport::kRest, policy.Pick("GetBucketMetadata"));
+  // Without any completed calls the policy uses the default.
+  EXPECT_EQ(Transport::kGrpc, policy.Pick("GetBucketMetadata"));
+
+  auto const counters = policy.Counters();
+  ASSERT_EQ(1, counters.count("GetBucketMetadata"));
+  auto const& c = counters.at("GetBucketMetadata");
+  EXPECT_EQ(2, c.rest_calls);
+  EXPECT_EQ(3, c.grpc_calls);
+  EXPECT_EQ(0, c.explorations);
+}
+
+TEST(TransportRoutingPolicyTest, LatencyPicksLowerLatency) {
+  LatencyRoutingPolicy policy(Transport::kGrpc, 4, 0);
+  RunCalls(policy, "GetBucketMetadata", 20, [](Transport t) {
+    return TransportSample{
+        t, t == Transport::kRest ? milliseconds(10) : milliseconds(30), 0,
+        StatusCode::kOk};
+  });
+  EXPECT_EQ(Transport::kRest, policy.Pick("GetBucketMetadata"));
+  auto const c = policy.Counters().at("GetBucketMetadata");
+  EXPECT_EQ(4, c.grpc_calls);
+  EXPECT_EQ(17, c.rest_calls);
+}
+
+TEST(TransportRoutingPolicyTest, LatencyPicksHigherThroughput) {
+  LatencyRoutingPolicy policy(Transport::kRest, 4, 0);
+  // gRPC is slower to start, but transfers large objects faster.
+  RunCalls(policy, "ReadObject", 20, [](Transport t) {
+    return TransportSample{
+        t, t == Transport::kRest ? milliseconds(400) : milliseconds(250),
+        64 * kMiB, StatusCode::kOk};
+  });
+  RunCalls(policy, "ReadObject", 8, [](Transport t) {
+    return TransportSample{
+        t, t == Transport::kRest ? milliseconds(10) : milliseconds(20), 1024,
+        StatusCode::kOk};
+  });
+  EXPECT_EQ(Transport::kGrpc, policy.Pick("ReadObject"));
+}
+
+TEST(TransportRoutingPolicyTest, OperationsAreIndependent) {
+  LatencyRoutingPolicy policy(Transport::kRest, 2, 0);
+  RunCalls(policy, "GetBucketMetadata", 10, [](Transport t) {
+    return TransportSample{
+        t, t == Transport::kRest ? milliseconds(5) : milliseconds(50), 0,
+        StatusCode::kOk};
+  });
+  RunCalls(policy, "DeleteObject", 10, [](Transport t) {
+    return TransportSample{
+        t, t == Transport::kRest ? milliseconds(50) : milliseconds(5), 0,
+        StatusCode::kOk};
+  });
+  EXPECT_EQ(Transport::kRest, policy.Pick("GetBucketMetadata"));
+  EXPECT_EQ(Transport::kGrpc, policy.Pick("DeleteObject"));
+}
+
+TEST(TransportRoutingPolicyTest, LatencyExploresSlowerTransport) {
+  LatencyRoutingPolicy policy(Transport::kRest, 1, 4);
+  RunCalls(policy, "DeleteObject", 2, [](Transport t) {
+    return TransportSample{
+        t, t == Transport::kRest ? milliseconds(5) : milliseconds(50), 0,
+        StatusCode::kOk};
+  });
+  // Calls 3 to 10, one in every 4 calls explores gRPC.
+  std::vector<Transport> actual;
+  for (int i = 0; i != 8; ++i) actual.push_back(policy.Pick("DeleteObject"));
+  EXPECT_THAT(actual, ::testing::ElementsAre(
+                          Transport::kRest, Transport::kGrpc, Transport::kRest,
+                          Transport::kRest, Transport::kRest, Transport::kGrpc,
+                          Transport::kRest, Transport::kRest));
+  EXPECT_EQ(2, policy.Counters().at("DeleteObject").explorations);
+}
+
+TEST(TransportRoutingPolicyTest, LatencyAdaptsToChanges) {
+  LatencyRoutingPolicy policy(Transport::kRest, 2, 4);
+  auto rest_latency = milliseconds(5);
+  auto sample = [&rest_latency](Transport t) {
+    return TransportSample{
+        t, t == Transport::kRest ? rest_latency : milliseconds(20), 0,
+        StatusCode::kOk};
+  };
+  RunCalls(policy, "GetBucketMetadata", 16, sample);
+  EXPECT_EQ(Transport::kRest, policy.Pick("GetBucketMetadata"));
+
+  // REST becomes slower, the exploration calls discover gRPC is now faster.
+  rest_latency = milliseconds(100);
+  RunCalls(policy, "GetBucketMetadata", 16, sample);
+  EXPECT_EQ(Transport::kGrpc, policy.Pick("GetBucketMetadata"));
+}
+
+TEST(TransportRoutingPolicyTest, TransportFailuresArePenalized) {
+  LatencyRoutingPolicy policy(Transport::kGrpc, 2, 0);
+  RunCalls(policy, "DeleteObject", 8, [](Transport t) {
+    if (t == Transport::kGrpc) {
+      return TransportSample{t, microseconds(100), 0,
+                             StatusCode::kUnavailable};
+    }
+    return TransportSample{t, milliseconds(20), 0, StatusCode::kOk};
+  });
+  EXPECT_EQ(Transport::kRest, policy.Pick("DeleteObject"));
+  EXPECT_EQ(2, policy.Counters().at("DeleteObject").failures);
+}
+
+TEST(TransportRoutingPolicyTest, RequestErrorsAreNotPenalized) {
+  LatencyRoutingPolicy policy(Transport::kRest, 2, 0);
+  RunCalls(policy, "GetBucketMetadata", 8, [](Transport t) {
+    if (t == Transport::kGrpc) {
+      return TransportSample{t, milliseconds(1), 0, StatusCode::kNotFound};
+    }
+    return TransportSample{t, milliseconds(20), 0, StatusCode::kNotFound};
+  });
+  EXPECT_EQ(Transport::kGrpc, policy.Pick("GetBucketMetadata"));
+  EXPECT_EQ(0, policy.Counters().at("GetBucketMetadata").failures);
+}
+
+}  // namespace
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,255 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/upload_directory.h"
+#include "google/cloud/storage/internal/openssl_util.h"
+#include "google/cloud/internal/big_endian.h"
+#include <crc32c/crc32c.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sys/types.h>
+// The order of these two includes cannot be changed.
+#include <sys/stat.h>
+#if _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif  // _WIN32
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+Status DirectoryError(StatusCode code, std::string const& path,
+                      std::string const& what) {
+  return Status(code, "cannot list directory " + path + ": " + what);
+}
+
+#if _WIN32
+StatusCode DirectoryErrorCode(DWORD error) {
+  switch (error) {
+    case ERROR_FILE_NOT_FOUND:
+    case ERROR_PATH_NOT_FOUND:
+      return StatusCode::kNotFound;
+    case ERROR_ACCESS_DENIED:
+      return StatusCode::kPermissionDenied;
+    default:
+      return StatusCode::kUnknown;
+  }
+}
+#else
+StatusCode DirectoryErrorCode(int error) {
+  switch (error) {
+    case ENOENT:
+    case ENOTDIR:
+      return StatusCode::kNotFound;
+    case EACCES:
+      return StatusCode::kPermissionDenied;
+    default:
+      return StatusCode::kUnknown;
+  }
+}
+#endif  // _WIN32
+
+/**
+ * Appends the entries in @p directory to @p files and @p subdirectories.
+ *
+ * The entries are relative to the root directory, @p relative is the path of
+ * @p directory relative to that root, it is empty for the root itself.
+ */
+Status ListOneDirectory(std::string const& directory,
+                        std::string const& relative,
+                        std::vector<LocalFile>& files,
+                        std::vector<std::string>& subdirectories) {
+  auto relative_name = [&relative](std::string const& name) {
+    return relative.empty() ? name : relative + "/" + name;
+  };
+#if _WIN32
+  WIN32_FIND_DATAA data;
+  auto handle = ::FindFirstFileA((directory + "\\*").c_str(), &data);
+  if (handle == INVALID_HANDLE_VALUE) {
+    auto const error = ::GetLastError();
+    return DirectoryError(DirectoryErrorCode(error), directory,
+                          "error code " + std::to_string(error));
+  }
+  do {
+    std::string name = data.cFileName;
+    if (name == "." || name == "..") continue;
+    // Do not follow symbolic links, or other reparse points.
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) continue;
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+      subdirectories.push_back(relative_name(name));
+      continue;
+    }
+    auto const size = (static_cast<std::uintmax_t>(data.nFileSizeHigh) << 32U) |
+                      data.nFileSizeLow;
+    files.push_back(LocalFile{directory + "\\" + name, relative_name(name),
+                              size, Status()});
+  } while (::FindNextFileA(handle, &data));
+  ::FindClose(handle);
+#else
+  auto* dir = ::opendir(directory.c_str());
+  if (dir == nullptr) {
+    auto const error = errno;
+    return DirectoryError(DirectoryErrorCode(error), directory,
+                          std::strerror(error));
+  }
+  for (auto* entry = ::readdir(dir); entry != nullptr; entry = ::readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name == "." || name == "..") continue;
+    auto path = directory + "/" + name;
+    struct stat s {};
+    // Use lstat() to not follow symbolic links.
+    if (::lstat(path.c_str(), &s) != 0) {
+      // Report the entry as a failed file, it may or may not be a directory.
+      auto const error = errno;
+      Status status(DirectoryErrorCode(error),
+                    "cannot stat " + path + ": " + std::strerror(error));
+      files.push_back(LocalFile{std::move(path), relative_name(name), 0,
+                                std::move(status)});
+      continue;
+    }
+    if (S_ISDIR(s.st_mode)) {
+      subdirectories.push_back(relative_name(name));
+    } else if (S_ISREG(s.st_mode)) {
+      files.push_back(LocalFile{std::move(path), relative_name(name),
+                                static_cast<std::uintmax_t>(s.st_size),
+                                Status()});
+    }
+  }
+  ::closedir(dir);
+#endif  // _WIN32
+  return Status();
+}
+
+/// Returns true if the object already has the contents of @p file.
+bool IsUpToDate(UploadDirectoryFile const& file,
+                std::map<std::string, RemoteObjectSummary> const& existing) {
+  auto const loc = existing.find(file.object_name);
+  if (loc == existing.end()) return false;
+  // Only read the file if there is a chance it matches.
+  if (loc->second.size != file.size || loc->second.crc32c.empty()) return false;
+  auto crc32c = ComputeFileCrc32cChecksum(file.file_name);
+  return crc32c && *crc32c == loc->second.crc32c;
+}
+}  // namespace
+
+StatusOr<std::vector<LocalFile>> ListLocalFiles(std::string const& root) {
+  std::vector<LocalFile> files;
+  std::vector<std::string> pending{""};
+  while (!pending.empty()) {
+    auto relative = std::move(pending.back());
+    pending.pop_back();
+    auto directory = relative.empty() ? root : root + "/" + relative;
+    auto status = ListOneDirectory(directory, relative, files, pending);
+    if (status.ok()) continue;
+    if (relative.empty()) return status;
+    // Report the subdirectory as a failed file, the rest of the tree is still
+    // uploaded.
+    files.push_back(LocalFile{std::move(directory), std::move(relative), 0,
+                              std::move(status)});
+  }
+  std::sort(files.begin(), files.end(),
+            [](LocalFile const& a, LocalFile const& b) {
+              return a.relative_name < b.relative_name;
+            });
+  return files;
+}
+
+StatusOr<std::string> ComputeFileCrc32cChecksum(std::string const& file_name) {
+  std::ifstream is(file_name, std::ios::binary);
+  if (!is.is_open()) {
+    return Status(StatusCode::kNotFound, "cannot open file " + file_name);
+  }
+  std::vector<char> buffer(1024 * 1024);
+  std::uint32_t crc = 0;
+  while (is) {
+    is.read(buffer.data(), buffer.size());
+    crc = crc32c::Extend(crc, reinterpret_cast<std::uint8_t*>(buffer.data()),
+                         static_cast<std::size_t>(is.gcount()));
+  }
+  if (is.bad()) {
+    return Status(StatusCode::kDataLoss, "error reading file " + file_name);
+  }
+  return Base64Encode(google::cloud::internal::EncodeBigEndian(crc));
+}
+
+UploadDirectoryResult UploadDirectoryImpl(
+    std::vector<LocalFile> files, std::string const& prefix,
+    std::map<std::string, RemoteObjectSummary> const& existing,
+    UploadDirectoryConfig const& config) {
+  UploadDirectoryResult result;
+  result.files.reserve(files.size());
+  for (auto& f : files) {
+    result.files.push_back(UploadDirectoryFile{std::move(f.file_name),
+                                               prefix + f.relative_name,
+                                               f.size, false,
+                                               std::move(f.status)});
+  }
+
+  UploadDirectoryStats initial;
+  initial.files_total = result.files.size();
+  ProgressMonitor<UploadDirectoryStats> monitor(initial);
+  auto upload = [&](UploadDirectoryFile& file,
+                    UploadDirectoryFunction const& function) {
+    // Files that could not be examined while listing them are failures.
+    if (file.status.ok()) {
+      file.skipped = IsUpToDate(file, existing);
+      if (!file.skipped) {
+        file.status = function(file.file_name, file.object_name);
+      }
+    }
+    monitor.Update(
+        [&file](UploadDirectoryStats& s) {
+          if (!file.status.ok()) {
+            ++s.files_failed;
+          } else if (file.skipped) {
+            ++s.files_skipped;
+          } else {
+            ++s.files_uploaded;
+            s.bytes_uploaded += file.size;
+          }
+        },
+        config.progress);
+  };
+
+  // Small files are uploaded concurrently, each with a single request. Large
+  // files use multiple streams each, uploading them concurrently would create
+  // too many streams, so they are uploaded one at a time.
+  std::vector<std::size_t> small;
+  std::vector<std::size_t> large;
+  for (std::size_t i = 0; i != result.files.size(); ++i) {
+    auto& v = result.files[i].size < config.parallel_upload_threshold ? small
+                                                                      : large;
+    v.push_back(i);
+  }
+  RunConcurrently(small.size(), config.max_streams, [&](std::size_t i) {
+    upload(result.files[small[i]], config.simple_upload);
+    return true;
+  });
+  for (auto i : large) upload(result.files[i], config.parallel_upload);
+
+  result.stats = monitor.Current();
+  return result;
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,311 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_UPLOAD_DIRECTORY_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_UPLOAD_DIRECTORY_H
+
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/internal/bulk_progress.h"
+#include "google/cloud/storage/internal/tuple_filter.h"
+#include "google/cloud/storage/parallel_upload.h"
+#include "google/cloud/storage/version.h"
+#include "google/cloud/status.h"
+#include "google/cloud/status_or.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+/**
+ * A parameter type indicating the minimum size of the files uploaded with
+ * `ParallelUploadFile` in `UploadDirectory`.
+ */
+class ParallelUploadThreshold {
+ public:
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  ParallelUploadThreshold(std::uintmax_t value) : value_(value) {}
+  std::uintmax_t value() const { return value_; }
+
+ private:
+  std::uintmax_t value_;
+};
+
+/// The aggregate progress of `UploadDirectory()`.
+struct UploadDirectoryStats {
+  std::size_t files_total = 0;
+  std::size_t files_uploaded = 0;
+  /// Files not uploaded because the object already has the same contents.
+  std::size_t files_skipped = 0;
+  std::size_t files_failed = 0;
+  std::uint64_t bytes_uploaded = 0;
+  std::chrono::steady_clock::duration elapsed{};
+
+  double BytesPerSecond() const {
+    return internal::BytesPerSecond(bytes_uploaded, elapsed);
+  }
+};
+
+/**
+ * A parameter type to receive the progress of `UploadDirectory()`.
+ *
+ * The callback receives the aggregate progress after each file. It may be
+ * called from several threads, but the calls are serialized.
+ */
+class UploadDirectoryProgressCallback
+    : public internal::CallbackOption<UploadDirectoryProgressCallback,
+                                      void(UploadDirectoryStats const&)> {
+ public:
+  using CallbackOption::CallbackOption;
+};
+
+/// The outcome for one of the files in `UploadDirectory()`.
+struct UploadDirectoryFile {
+  std::string file_name;
+  std::string object_name;
+  std::uintmax_t size;
+  bool skipped;
+  Status status;
+};
+
+/// The results of `UploadDirectory()`, sorted by object name.
+struct UploadDirectoryResult {
+  std::vector<UploadDirectoryFile> files;
+  UploadDirectoryStats stats;
+};
+
+namespace internal {
+
+/// A regular file found by `ListLocalFiles()`.
+struct LocalFile {
+  std::string file_name;
+  /// The path relative to the root, using `/` as the separator.
+  std::string relative_name;
+  std::uintmax_t size;
+  /// The error if the entry could not be examined, it is not uploaded.
+  Status status;
+};
+
+/**
+ * Lists the regular files under @p root, recursively, sorted by relative name.
+ *
+ * Symbolic links are not followed, and other special files are ignored. Entries
+ * that cannot be examined, including subdirectories that cannot be listed, are
+ * returned with an error in `LocalFile::status`. Only errors listing @p root
+ * itself are returned as an error.
+ */
+StatusOr<std::vector<LocalFile>> ListLocalFiles(std::string const& root);
+
+/// Computes the CRC32C checksum of a file, in the format used by the service.
+StatusOr<std::string> ComputeFileCrc32cChecksum(std::string const& file_name);
+
+/// The size and checksum of an existing object.
+struct RemoteObjectSummary {
+  std::uint64_t size;
+  std::string crc32c;
+};
+
+using UploadDirectoryFunction = std::function<Status(
+    std::string const& file_name, std::string const& object_name)>;
+
+struct UploadDirectoryConfig {
+  std::size_t max_streams;
+  std::uintmax_t parallel_upload_threshold;
+  UploadDirectoryProgressCallback::Callback progress;
+  UploadDirectoryFunction simple_upload;
+  UploadDirectoryFunction parallel_upload;
+};
+
+UploadDirectoryResult UploadDirectoryImpl(
+    std::vector<LocalFile> files, std::string const& prefix,
+    std::map<std::string, RemoteObjectSummary> const& existing,
+    UploadDirectoryConfig const& config);
+
+struct UploadDirectoryListApplyHelper {
+  template <typename... Options>
+  ListObjectsReader operator()(Options&&... options) const {
+    return client.ListObjects(bucket_name, Prefix(prefix),
+                              std::forward<Options>(options)...);
+  }
+
+  Client& client;
+  std::string const& bucket_name;
+  std::string const& prefix;
+};
+
+struct UploadFileApplyHelper {
+  template <typename... Options>
+  Status operator()(Options&&... options) const {
+    return client
+        .UploadFile(file_name, bucket_name, object_name,
+                    std::forward<Options>(options)...)
+        .status();
+  }
+
+  Client& client;
+  std::string const& file_name;
+  std::string const& bucket_name;
+  std::string const& object_name;
+};
+
+struct ParallelUploadFileApplyHelper {
+  template <typename... Options>
+  Status operator()(Options&&... options) const {
+    return ParallelUploadFile(client, file_name, bucket_name, object_name,
+                              CreateRandomPrefixName(object_name + ".tmp-"),
+                              /*ignore_cleanup_failures=*/true,
+                              std::forward<Options>(options)...)
+        .status();
+  }
+
+  Client& client;
+  std::string const& file_name;
+  std::string const& bucket_name;
+  std::string const& object_name;
+};
+
+}  // namespace internal
+
+/**
+ * Uploads all the files in a local directory, and its subdirectories.
+ *
+ * Each file is uploaded to an object named @p prefix followed by the path of
+ * the file relative to @p directory, using `/` as the separator. Files smaller
+ * than `ParallelUploadThreshold` (64 MiB by default) are uploaded with
+ * `Client::UploadFile()`, up to `MaxStreams` (16 by default) at a time. Once
+ * those complete, the larger files are uploaded one at a time using
+ * `ParallelUploadFile()`, each with up to `MaxStreams` streams.
+ *
+ * Files are skipped if an object with the same name, size, and CRC32C checksum
+ * already exists, so calling this function again after a partial failure only
+ * uploads the missing files.
+ *
+ * All the uploads share the connection pool in @p client, consider using
+ * `ClientOptions::set_connection_pool_size()` to keep at least `MaxStreams`
+ * connections.
+ *
+ * @param client the client on which to perform the operations.
+ * @param directory the local directory to upload.
+ * @param bucket_name the name of the destination bucket.
+ * @param prefix the prefix for the object names, usually ends with `/`.
+ * @param options a list of optional query parameters and/or request headers.
+ *     Valid types for this operation include `DestinationPredefinedAcl`,
+ *     `EncryptionKey`, `KmsKeyName`, `MaxStreams`, `MinStreamSize`,
+ *     `ParallelUploadThreshold`, `QuotaUser`,
+ *     `UploadDirectoryProgressCallback`, `UserIp`, `UserProject`, and
+ *     `WithObjectMetadata`.
+ *
+ * @return the outcome of each file, or an error if listing the local files or
+ *     the existing objects fails. A failed upload does not stop the others,
+ *     neither does a directory entry that cannot be examined, which is reported
+ *     as a failed file.
+ *
+ * @par Idempotency
+ * Uploads are not idempotent, each request is retried based on the client
+ * policies.
+ */
+template <typename... Options>
+StatusOr<UploadDirectoryResult> UploadDirectory(Client client,
+                                                std::string const& directory,
+                                                std::string const& bucket_name,
+                                                std::string const& prefix,
+                                                Options&&... options) {
+  using internal::Among;
+  using internal::ExtractFirstOccurenceOfType;
+  using internal::NotAmong;
+  using internal::StaticTupleFilter;
+
+  static_assert(
+      std::tuple_size<decltype(
+              StaticTupleFilter<NotAmong<
+                  DestinationPredefinedAcl, EncryptionKey, KmsKeyName,
+                  MaxStreams, MinStreamSize, ParallelUploadThreshold,
+                  QuotaUser, UploadDirectoryProgressCallback, UserIp,
+                  UserProject, WithObjectMetadata>::TPred>(
+                  std::tie(options...)))>::value == 0,
+      "This functions accepts only options of type DestinationPredefinedAcl, "
+      "EncryptionKey, KmsKeyName, MaxStreams, MinStreamSize, "
+      "ParallelUploadThreshold, QuotaUser, UploadDirectoryProgressCallback, "
+      "UserIp, UserProject or WithObjectMetadata.");
+
+  auto files = internal::ListLocalFiles(directory);
+  if (!files) return std::move(files).status();
+
+  std::map<std::string, internal::RemoteObjectSummary> existing;
+  auto list_options =
+      StaticTupleFilter<Among<QuotaUser, UserIp, UserProject>::TPred>(
+          std::make_tuple(options...));
+  for (auto& object : google::cloud::internal::apply(
+           internal::UploadDirectoryListApplyHelper{client, bucket_name,
+                                                    prefix},
+           std::move(list_options))) {
+    if (!object) return std::move(object).status();
+    existing.emplace(object->name(), internal::RemoteObjectSummary{
+                                         object->size(), object->crc32c()});
+  }
+
+  auto upload_options = StaticTupleFilter<
+      Among<DestinationPredefinedAcl, EncryptionKey, KmsKeyName, QuotaUser,
+            UserIp, UserProject, WithObjectMetadata>::TPred>(
+      std::make_tuple(options...));
+  auto parallel_options =
+      std::tuple_cat(upload_options,
+                     StaticTupleFilter<Among<MaxStreams, MinStreamSize>::TPred>(
+                         std::make_tuple(options...)));
+
+  auto all_options = std::tie(options...);
+  MaxStreams const default_max_streams(16);
+  ParallelUploadThreshold const default_threshold(64 * 1024 * 1024L);
+  internal::UploadDirectoryConfig config{
+      ExtractFirstOccurenceOfType<MaxStreams>(all_options)
+          .value_or(default_max_streams)
+          .value(),
+      ExtractFirstOccurenceOfType<ParallelUploadThreshold>(all_options)
+          .value_or(default_threshold)
+          .value(),
+      ExtractFirstOccurenceOfType<UploadDirectoryProgressCallback>(all_options)
+          .value_or(UploadDirectoryProgressCallback(
+              [](UploadDirectoryStats const&) {}))
+          .value(),
+      [&](std::string const& file_name, std::string const& object_name) {
+        return google::cloud::internal::apply(
+            internal::UploadFileApplyHelper{client, file_name, bucket_name,
+                                            object_name},
+            upload_options);
+      },
+      [&](std::string const& file_name, std::string const& object_name) {
+        return google::cloud::internal::apply(
+            internal::ParallelUploadFileApplyHelper{client, file_name,
+                                                    bucket_name, object_name},
+            parallel_options);
+      },
+  };
+
+  return internal::UploadDirectoryImpl(*std::move(files), prefix, existing,
+                                       config);
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_UPLOAD_DIRECTORY_H
@@ -0,0 +1,294 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/upload_directory.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/storage/testing/random_names.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sys/stat.h>
+#if _WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif  // _WIN32
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Invoke;
+
+void MakeDirectory(std::string const& path) {
+#if _WIN32
+  ASSERT_EQ(0, ::_mkdir(path.c_str()));
+#else
+  ASSERT_EQ(0, ::mkdir(path.c_str(), 0700));
+#endif  // _WIN32
+}
+
+/// Creates a small directory tree, and removes it in the destructor.
+class TempTree {
+ public:
+  TempTree() {
+    auto generator =
+        google::cloud::internal::DefaultPRNG(std::random_device{}());
+    root_ = ::testing::TempDir() + testing::MakeRandomFileName(generator);
+    MakeDirectory(root_);
+    directories_.push_back(root_);
+  }
+  ~TempTree() {
+    for (auto const& f : files_) std::remove(f.c_str());
+    for (auto d = directories_.rbegin(); d != directories_.rend(); ++d) {
+      std::remove(d->c_str());
+    }
+  }
+
+  std::string const& root() const { return root_; }
+
+  void AddDirectory(std::string const& relative) {
+    directories_.push_back(root_ + "/" + relative);
+    MakeDirectory(directories_.back());
+  }
+
+  void AddFile(std::string const& relative, std::string const& contents) {
+    files_.push_back(root_ + "/" + relative);
+    std::ofstream(files_.back(), std::ios::binary) << contents;
+  }
+
+ private:
+  std::string root_;
+  std::vector<std::string> directories_;
+  std::vector<std::string> files_;
+};
+
+std::vector<std::string> RelativeNames(std::vector<LocalFile> const& files) {
+  std::vector<std::string> names;
+  for (auto const& f : files) names.push_back(f.relative_name);
+  return names;
+}
+
+TEST(UploadDirectoryTest, ListLocalFiles) {
+  TempTree tree;
+  tree.AddDirectory("d1");
+  tree.AddDirectory("d1/d2");
+  tree.AddDirectory("empty");
+  tree.AddFile("b.txt", "bb");
+  tree.AddFile("a.txt", "a");
+  tree.AddFile("d1/c.txt", "ccc");
+  tree.AddFile("d1/d2/d.txt", "dddd");
+
+  auto files = ListLocalFiles(tree.root());
+  ASSERT_STATUS_OK(files);
+  EXPECT_THAT(RelativeNames(*files),
+              ElementsAre("a.txt", "b.txt", "d1/c.txt", "d1/d2/d.txt"));
+  EXPECT_EQ(tree.root() + "/d1/d2/d.txt", (*files)[3].file_name);
+  EXPECT_EQ(4, (*files)[3].size);
+}
+
+TEST(UploadDirectoryTest, ListLocalFilesMissing) {
+  auto files = ListLocalFiles(::testing::TempDir() + "/does-not-exist");
+  EXPECT_EQ(StatusCode::kNotFound, files.status().code());
+}
+
+TEST(UploadDirectoryTest, ListLocalFilesNotADirectory) {
+  TempTree tree;
+  tree.AddFile("a.txt", "a");
+  auto files = ListLocalFiles(tree.root() + "/a.txt");
+  EXPECT_EQ(StatusCode::kNotFound, files.status().code());
+}
+
+#if !_WIN32
+TEST(UploadDirectoryTest, ListLocalFilesPermissionDenied) {
+  // The superuser can list the directory anyway.
+  if (::geteuid() == 0) GTEST_SKIP();
+  TempTree tree;
+  tree.AddDirectory("locked");
+  tree.AddFile("a.txt", "a");
+  auto const locked = tree.root() + "/locked";
+  ASSERT_EQ(0, ::chmod(locked.c_str(), 0));
+  // The subdirectory is reported as a failed file, the other files are listed.
+  auto files = ListLocalFiles(tree.root());
+  ASSERT_STATUS_OK(files);
+  EXPECT_THAT(RelativeNames(*files), ElementsAre("a.txt", "locked"));
+  EXPECT_STATUS_OK((*files)[0].status);
+  EXPECT_EQ(StatusCode::kPermissionDenied, (*files)[1].status.code());
+
+  // Errors listing the root directory are returned as such.
+  files = ListLocalFiles(locked);
+  EXPECT_EQ(StatusCode::kPermissionDenied, files.status().code());
+  // Restore the permissions so the directory can be removed.
+  EXPECT_EQ(0, ::chmod(locked.c_str(), 0700));
+}
+#endif  // !_WIN32
+
+TEST(UploadDirectoryTest, ComputeFileCrc32cChecksum) {
+  TempTree tree;
+  std::string const contents = "The quick brown fox jumps over the lazy dog";
+  tree.AddFile("fox.txt", contents);
+  auto actual = ComputeFileCrc32cChecksum(tree.root() + "/fox.txt");
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(ComputeCrc32cChecksum(contents), *actual);
+
+  auto missing = ComputeFileCrc32cChecksum(tree.root() + "/missing");
+  EXPECT_EQ(StatusCode::kNotFound, missing.status().code());
+}
+
+TEST(UploadDirectoryTest, Impl) {
+  TempTree tree;
+  tree.AddDirectory("d");
+  tree.AddFile("same.txt", "same");
+  tree.AddFile("changed.txt", "new contents");
+  tree.AddFile("d/new.txt", "new");
+  tree.AddFile("fail.txt", "fail");
+  tree.AddFile("large.bin", std::string(1024, 'x'));
+
+  std::map<std::string, RemoteObjectSummary> existing{
+      {"p/same.txt", {4, ComputeCrc32cChecksum("same")}},
+      {"p/changed.txt", {12, ComputeCrc32cChecksum("old contents")}},
+  };
+
+  std::mutex mu;
+  std::set<std::string> simple;
+  std::vector<std::string> parallel;
+  std::size_t progress_calls = 0;
+  UploadDirectoryConfig config{
+      4,
+      1024,
+      [&](UploadDirectoryStats const& s) {
+        EXPECT_EQ(5, s.files_total);
+        ++progress_calls;
+      },
+      [&](std::string const&, std::string const& object_name) {
+        std::lock_guard<std::mutex> lk(mu);
+        simple.insert(object_name);
+        return object_name == "p/fail.txt" ? PermanentError() : Status();
+      },
+      [&](std::string const& file_name, std::string const& object_name) {
+        EXPECT_EQ(tree.root() + "/large.bin", file_name);
+        parallel.push_back(object_name);
+        return Status();
+      },
+  };
+
+  auto files = ListLocalFiles(tree.root());
+  ASSERT_STATUS_OK(files);
+  auto result = UploadDirectoryImpl(*std::move(files), "p/", existing, config);
+
+  EXPECT_THAT(simple,
+              ElementsAre("p/changed.txt", "p/d/new.txt", "p/fail.txt"));
+  EXPECT_THAT(parallel, ElementsAre("p/large.bin"));
+  ASSERT_EQ(5, result.files.size());
+  EXPECT_EQ("p/same.txt", result.files[4].object_name);
+  EXPECT_TRUE(result.files[4].skipped);
+  EXPECT_EQ("p/fail.txt", result.files[2].object_name);
+  EXPECT_EQ(PermanentError().code(), result.files[2].status.code());
+
+  EXPECT_EQ(5, progress_calls);
+  EXPECT_EQ(3, result.stats.files_uploaded);
+  EXPECT_EQ(1, result.stats.files_skipped);
+  EXPECT_EQ(1, result.stats.files_failed);
+  EXPECT_EQ(12 + 3 + 1024, result.stats.bytes_uploaded);
+}
+
+TEST(UploadDirectoryTest, ImplReportsListingErrors) {
+  std::vector<LocalFile> files{
+      {"/tmp/unreadable", "unreadable", 0, PermanentError()},
+  };
+  UploadDirectoryConfig config{
+      4,
+      1024,
+      [](UploadDirectoryStats const&) {},
+      [](std::string const&, std::string const&) {
+        ADD_FAILURE() << "unexpected upload";
+        return Status();
+      },
+      [](std::string const&, std::string const&) {
+        ADD_FAILURE() << "unexpected upload";
+        return Status();
+      },
+  };
+
+  auto result = UploadDirectoryImpl(std::move(files), "p/", {}, config);
+  ASSERT_EQ(1, result.files.size());
+  EXPECT_EQ("p/unreadable", result.files[0].object_name);
+  EXPECT_FALSE(result.files[0].skipped);
+  EXPECT_EQ(PermanentError().code(), result.files[0].status.code());
+  EXPECT_EQ(1, result.stats.files_failed);
+  EXPECT_EQ(0, result.stats.files_uploaded);
+}
+
+TEST(UploadDirectoryTest, UploadDirectory) {
+  TempTree tree;
+  tree.AddFile("same.txt", "same");
+  tree.AddFile("new.txt", "new");
+
+  auto mock = std::make_shared<testing::MockClient>();
+  auto const mock_options = ClientOptions(oauth2::CreateAnonymousCredentials());
+  EXPECT_CALL(*mock, client_options())
+      .WillRepeatedly(::testing::ReturnRef(mock_options));
+  EXPECT_CALL(*mock, ListObjects(_))
+      .WillOnce(Invoke([](ListObjectsRequest const& r) {
+        EXPECT_EQ("test-bucket", r.bucket_name());
+        EXPECT_EQ("p/", r.GetOption<Prefix>().value());
+        EXPECT_EQ("test-project", r.GetOption<UserProject>().value());
+        ListObjectsResponse response;
+        response.items.push_back(
+            ObjectMetadataParser::FromJson(
+                nl::json{{"name", "p/same.txt"},
+                         {"size", "4"},
+                         {"crc32c", ComputeCrc32cChecksum("same")}})
+                .value());
+        return make_status_or(response);
+      }));
+  EXPECT_CALL(*mock, InsertObjectMedia(_))
+      .WillOnce(Invoke([](InsertObjectMediaRequest const& r) {
+        EXPECT_EQ("test-bucket", r.bucket_name());
+        EXPECT_EQ("p/new.txt", r.object_name());
+        EXPECT_EQ("new", r.contents());
+        EXPECT_EQ("test-project", r.GetOption<UserProject>().value());
+        return make_status_or(
+            ObjectMetadataParser::FromJson(nl::json{{"name", "p/new.txt"}})
+                .value());
+      }));
+  Client client(mock, Client::NoDecorations{});
+
+  auto result = UploadDirectory(client, tree.root(), "test-bucket", "p/",
+                                UserProject("test-project"), MaxStreams(2));
+  ASSERT_STATUS_OK(result);
+  ASSERT_EQ(2, result->files.size());
+  EXPECT_STATUS_OK(result->files[0].status);
+  EXPECT_FALSE(result->files[0].skipped);
+  EXPECT_TRUE(result->files[1].skipped);
+  EXPECT_EQ(1, result->stats.files_uploaded);
+  EXPECT_EQ(1, result->stats.files_skipped);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,76 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/v4_url_signer.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage_experimental {
+inline namespace STORAGE_CLIENT_NS {
+
+StatusOr<V4UrlSigner> V4UrlSigner::Create(
+    storage::oauth2::ServiceAccountCredentialsInfo const& info) {
+  auto private_key = storage::internal::PemPrivateKey::Parse(info.private_key);
+  if (!private_key) return std::move(private_key).status();
+  return V4UrlSigner(info.client_email, *std::move(private_key));
+}
+
+StatusOr<std::string> V4UrlSigner::SignUrl(
+    storage::internal::V4SignUrlRequest request) const {
+  auto valid = request.Validate();
+  if (!valid.ok()) return valid;
+  auto const& signing_account = request.signing_account();
+  if (signing_account.has_value() &&
+      signing_account.value() != signing_email_) {
+    return Status(
+        StatusCode::kInvalidArgument,
+        "This signer cannot sign URLs for " + signing_account.value());
+  }
+  request.AddMissingRequiredHeaders();
+
+  auto signature =
+      private_key_.Sign(request.StringToSign(signing_email_),
+                        storage::oauth2::JwtSigningAlgorithms::RS256);
+  if (!signature) return std::move(signature).status();
+  return request.SignedUrl(signing_email_, *signature);
+}
+
+std::vector<StatusOr<std::string>> V4UrlSigner::SignUrls(
+    std::vector<storage::internal::V4SignUrlRequest> requests,
+    std::size_t thread_count) const {
+  std::vector<StatusOr<std::string>> result(
+      requests.size(), Status(StatusCode::kUnknown, "not signed"));
+  // Each thread picks the next unsigned URL, the signatures take about the
+  // same time, so this balances the work without any other coordination.
+  std::atomic<std::size_t> next{0};
+  auto worker = [&] {
+    for (auto i = next++; i < requests.size(); i = next++) {
+      result[i] = SignUrl(std::move(requests[i]));
+    }
+  };
+  thread_count = (std::min)(thread_count, requests.size());
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < thread_count; ++i) threads.emplace_back(worker);
+  worker();
+  for (auto& t : threads) t.join();
+  return result;
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage_experimental
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,144 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_V4_URL_SIGNER_H
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_V4_URL_SIGNER_H
+
+#include "google/cloud/storage/internal/openssl_util.h"
+#include "google/cloud/storage/internal/signed_url_requests.h"
+#include "google/cloud/storage/oauth2/service_account_credentials.h"
+#include "google/cloud/storage/signed_url_options.h"
+#include "google/cloud/storage/version.h"
+#include "google/cloud/status_or.h"
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage_experimental {
+inline namespace STORAGE_CLIENT_NS {
+
+/// The verb, bucket and object for one of the URLs created by `V4UrlSigner`.
+struct V4SignedUrlTarget {
+  std::string verb;
+  std::string bucket_name;
+  std::string object_name;
+};
+
+/**
+ * Creates many V4 signed URLs with a service account key.
+ *
+ * `storage::Client::CreateV4SignedUrl()` works with any credentials, and may
+ * use the `SignBlob` API to sign the URL. Applications that create many signed
+ * URLs with a service account key can use this class instead: it parses the
+ * key once, never makes any network requests, and can sign batches of URLs
+ * using multiple threads. Objects of this class are immutable, they can be
+ * shared by multiple threads without any synchronization.
+ *
+ * @par Example
+ * @code
+ * auto info = storage::oauth2::ParseServiceAccountCredentials(contents, path);
+ * if (!info) return info.status();
+ * auto signer = storage_experimental::V4UrlSigner::Create(*info);
+ * if (!signer) return signer.status();
+ * // Sign the URLs using 4 threads, each URL is valid for 10 minutes.
+ * auto urls = signer->CreateV4SignedUrls(
+ *     targets, 4, storage::SignedUrlDuration(std::chrono::minutes(10)));
+ * @endcode
+ *
+ * @warning this is an experimental feature, and subject to change without
+ *     notice.
+ */
+class V4UrlSigner {
+ public:
+  /// Creates a signer, returns an error if the private key is invalid.
+  static StatusOr<V4UrlSigner> Create(
+      storage::oauth2::ServiceAccountCredentialsInfo const& info);
+
+  /// The service account used to sign the URLs.
+  std::string const& signing_email() const { return signing_email_; }
+
+  /**
+   * Creates a V4 signed URL.
+   *
+   * This is equivalent to `storage::Client::CreateV4SignedUrl()`, with the
+   * same parameters and options. The `SigningAccount` option, if present,
+   * must match `signing_email()`.
+   */
+  template <typename... Options>
+  StatusOr<std::string> CreateV4SignedUrl(std::string verb,
+                                          std::string bucket_name,
+                                          std::string object_name,
+                                          Options&&... options) const {
+    storage::internal::V4SignUrlRequest request(
+        std::move(verb), std::move(bucket_name), std::move(object_name));
+    request.set_multiple_options(std::forward<Options>(options)...);
+    return SignUrl(std::move(request));
+  }
+
+  /**
+   * Creates a V4 signed URL for each element in @p targets.
+   *
+   * All the URLs use the same timestamp, by default the current time. The
+   * application can override it using the `SignedUrlTimestamp` option.
+   *
+   * @param targets the verb, bucket, and object for each URL.
+   * @param thread_count sign the URLs using up to this many threads, the
+   *     calling thread is one of them.
+   * @param options a list of options applied to each URL, see
+   *     `storage::Client::CreateV4SignedUrl()` for the valid types.
+   * @return the signed URLs (or errors), in the same order as @p targets.
+   */
+  template <typename... Options>
+  std::vector<StatusOr<std::string>> CreateV4SignedUrls(
+      std::vector<V4SignedUrlTarget> const& targets, std::size_t thread_count,
+      Options const&... options) const {
+    storage::SignedUrlTimestamp const timestamp(
+        std::chrono::system_clock::now());
+    std::vector<storage::internal::V4SignUrlRequest> requests;
+    requests.reserve(targets.size());
+    for (auto const& t : targets) {
+      storage::internal::V4SignUrlRequest request(t.verb, t.bucket_name,
+                                                  t.object_name);
+      request.set_multiple_options(timestamp, options...);
+      requests.push_back(std::move(request));
+    }
+    return SignUrls(std::move(requests), thread_count);
+  }
+
+ private:
+  V4UrlSigner(std::string signing_email,
+              storage::internal::PemPrivateKey private_key)
+      : signing_email_(std::move(signing_email)),
+        private_key_(std::move(private_key)) {}
+
+  StatusOr<std::string> SignUrl(
+      storage::internal::V4SignUrlRequest request) const;
+  std::vector<StatusOr<std::string>> SignUrls(
+      std::vector<storage::internal::V4SignUrlRequest> requests,
+      std::size_t thread_count) const;
+
+  std::string signing_email_;
+  storage::internal::PemPrivateKey private_key_;
+};
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage_experimental
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_V4_URL_SIGNER_H